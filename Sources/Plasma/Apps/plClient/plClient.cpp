@@ -93,6 +93,7 @@ You can contact Cyan Worlds, Inc. by email legal@cyan.com
 #include "plGImage/plBitmap.h"
 #include "plGImage/plFontCache.h"
 #include "plGLight/plShadowCaster.h"
+#include "plGLight/plShadowScheduler.h"
 #include "plInputCore/plInputDevice.h"
 #include "plInputCore/plInputInterfaceMgr.h"
 #include "plInputCore/plInputManager.h"
@@ -366,6 +367,7 @@ bool plClient::Shutdown()
 
     delete fPageMgr;
     fPageMgr = nullptr;
+    plShadowScheduler::DeInit();
     plGlobalVisMgr::DeInit();
 
 #ifdef TRACK_AG_ALLOCS
@@ -507,14 +509,32 @@ bool plClient::InitPipeline(hsDisplayHndl display, uint32_t devType)
     hsG3DDeviceModeRecord dmr;
     hsG3DDeviceSelector devSel;
 
-    plDisplayHelper* displayHelper = plDisplayHelper::GetInstance();
-    devSel.Enumerate(displayHelper->DefaultDisplay());
-    devSel.RemoveUnusableDevModes(true);
-
-    if (!devSel.GetRequested(&dmr, devType))
+    if (fBenchmark)
     {
-        hsMessageBox(ST_LITERAL("No suitable rendering devices found."), ST_LITERAL("Plasma"), hsMessageBoxNormal, hsMessageBoxIconError);
-        return true;
+        // Benchmarks never present anything, so don't go looking for a video card.
+        // An unknown device type gets us the null pipeline at the requested size.
+        hsG3DDeviceMode mode;
+        mode.SetWidth(plPipeline::fInitialPipeParams.Width);
+        mode.SetHeight(plPipeline::fInitialPipeParams.Height);
+        mode.SetColorDepth(plPipeline::fInitialPipeParams.ColorDepth);
+
+        hsG3DDeviceRecord nullRec;
+        nullRec.SetG3DDeviceType(hsG3DDeviceSelector::kDevTypeUnknown);
+        nullRec.SetDeviceDesc(ST_LITERAL("Benchmark"));
+        nullRec.GetModes().emplace_back(mode);
+        dmr = hsG3DDeviceModeRecord(nullRec, mode);
+    }
+    else
+    {
+        plDisplayHelper* displayHelper = plDisplayHelper::GetInstance();
+        devSel.Enumerate(displayHelper->DefaultDisplay());
+        devSel.RemoveUnusableDevModes(true);
+
+        if (!devSel.GetRequested(&dmr, devType))
+        {
+            hsMessageBox(ST_LITERAL("No suitable rendering devices found."), ST_LITERAL("Plasma"), hsMessageBoxNormal, hsMessageBoxIconError);
+            return true;
+        }
     }
 
     hsG3DDeviceRecord *rec = (hsG3DDeviceRecord *)dmr.GetDevice();
@@ -911,6 +931,12 @@ bool plClient::MsgReceive(plMessage* msg)
         return true;
     }
 
+    //============================================================================
+    // plAgeLoaded2Msg
+    //============================================================================
+    if (plAgeLoaded2Msg* ageLoaded2Msg = plAgeLoaded2Msg::ConvertNoRef(msg))
+        return IHandleAgeLoaded2Msg(ageLoaded2Msg);
+
     return hsKeyedObject::MsgReceive(msg);
 }
 
@@ -1420,7 +1446,7 @@ bool plClient::StartInit()
     hsStatusMessage("Init client");
     fFlags.SetBit( kFlagIniting );
 
-    pfLocalizationMgr::Initialize("dat");
+    pfLocalizationMgr::Initialize("dat", plFileName::Join(plFileSystem::GetUserDataPath(), "Localization.cache"));
 
     plQuality::SetQuality(fQuality);
     if( (GetClampCap() >= 0) && (GetClampCap() < plQuality::GetCapability()) )
@@ -1448,6 +1474,7 @@ bool plClient::StartInit()
     InitDLLs();
     
     plGlobalVisMgr::Init();
+    plShadowScheduler::Init();
     fPageMgr = new plPageTreeMgr;
 
     plVisLOSMgr::Init(fPipeline, fPageMgr);
@@ -1539,6 +1566,14 @@ bool plClient::StartInit()
 bool plClient::BeginGame()
 {
     plNetClientMgr::GetInstance()->Init();
+    if (fBenchmark) {
+        // Replays run from local data only: no intro, no auth, no patching.
+        // The benchmark age is loaded as soon as the global data is in.
+        plgDispatch::Dispatch()->UnRegisterForExactType(plNetCommAuthMsg::Index(), GetKey());
+        plgDispatch::Dispatch()->RegisterForExactType(plAgeLoaded2Msg::Index(), GetKey());
+        IOnAsyncInitComplete();
+        return true;
+    }
     IPlayIntroMovie("avi/CyanWorlds.webm", 0.f, 0.f, 0.f, fPipeline->fBackingScale, fPipeline->fBackingScale, 0.75);
     if (GetDone()) return false;
     if (NetCommGetStartupAge()->ageDatasetName.compare_i("StartUp") == 0) {
@@ -1595,9 +1630,18 @@ bool plClient::MainLoop()
     if (IUpdate())
         return true;
 
-    if (IDraw())
+    bool drawDone = IDraw();
+
+    // If the physics step was overlapped with rendering, collect it now.
+    plSimulationMgr::GetInstance()->FinishAdvance();
+
+    if (drawDone)
         return true;
 
+    // Sample the subsystem timers before the frame end resets them
+    if (fBenchmark && fBenchmark->EndFrame())
+        SetDone(true);
+
     plProfileManagerFull::Instance().EndFrame();
     plProfileManager::Instance().EndFrame();
 
@@ -2257,6 +2301,27 @@ void plClient::ICompleteInit () {
     plClientMsg* clientMsg = new plClientMsg(plClientMsg::kInitComplete);
     clientMsg->SetBCastFlag(plMessage::kBCastByType);
     clientMsg->Send();
+
+    if (fBenchmark) {
+        auto result = plAgeLoader::GetInstance()->LoadAge(fBenchmark->GetAgeName());
+        if (!result) {
+            hsStatusMessageF("Benchmark: {}", result.error());
+            SetDone(true);
+        }
+    }
+}
+
+//============================================================================
+bool plClient::IHandleAgeLoaded2Msg(plAgeLoaded2Msg* msg)
+{
+    plgDispatch::Dispatch()->UnRegisterForExactType(plAgeLoaded2Msg::Index(), GetKey());
+
+    // Without a server there is no age joiner to finish the load for us
+    plAgeLoader::GetInstance()->NotifyAgeLoaded(true);
+
+    if (fBenchmark && !fBenchmark->Begin())
+        SetDone(true);
+    return true;
 }
 
 //============================================================================
@@ -51,6 +51,7 @@ You can contact Cyan Worlds, Inc. by email legal@cyan.com
 #include "plFileSystem.h"
 
 #include <list>
+#include <memory>
 
 #include "pnKeyedObject/hsKeyedObject.h"
 #include "pnKeyedObject/plUoid.h"
@@ -58,6 +59,8 @@ You can contact Cyan Worlds, Inc. by email legal@cyan.com
 #include "plPipeline/hsG3DDeviceSelector.h"
 #include "plScene/plRenderRequest.h"
 
+#include "plClientBenchmark.h"
+
 class plAgeLoaded2Msg;
 struct plAnimDebugList;
 class plAudioSystem;
@@ -181,6 +184,8 @@ protected:
 
     std::vector<hsLibraryHndl> fLoadedDLLs;
 
+    std::unique_ptr<plClientBenchmark> fBenchmark;
+
     void                    ICompleteInit ();
     void                    IOnAsyncInitComplete ();
     void                    IHandlePatcherMsg (plResPatcherMsg * msg);
@@ -280,12 +285,18 @@ public:
 
     plPipeline*     GetPipeline() { return fPipeline; }
 
+    plPageTreeMgr*  GetPageTreeMgr() const { return fPageMgr; }
+
     plSceneNode*    GetCurrentScene() { return fCurrentNode; }
 
     pfConsoleEngine *GetConsoleEngine() { return fConsoleEngine; }
 
     void SetAuxInitDir(plFileName dir) { fpAuxInitDir = std::move(dir); }
 
+    // Takes ownership; must be set before InitPipeline
+    void SetBenchmark(plClientBenchmark* bench) { fBenchmark.reset(bench); }
+    bool IsBenchmarking() const { return fBenchmark != nullptr; }
+
     static void EnableClientDelay() { plClient::fDelayMS = true; }
 
     // These are a hack to let the console fake a lesser capabile board and test out quality settings.
@@ -0,0 +1,196 @@
+/*==LICENSE==*
+
+CyanWorlds.com Engine - MMOG client, server and tools
+Copyright (C) 2011  Cyan Worlds, Inc.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+Additional permissions under GNU GPL version 3 section 7
+
+If you modify this Program, or any covered work, by linking or
+combining it with any of RAD Game Tools Bink SDK, Autodesk 3ds Max SDK,
+NVIDIA PhysX SDK, Microsoft DirectX SDK, OpenSSL library, Independent
+JPEG Group JPEG library, Microsoft Windows Media SDK, or Apple QuickTime SDK
+(or a modified version of those libraries),
+containing parts covered by the terms of the Bink SDK EULA, 3ds Max EULA,
+PhysX SDK EULA, DirectX SDK EULA, OpenSSL and SSLeay licenses, IJG
+JPEG Library README, Windows Media SDK EULA, or QuickTime SDK EULA, the
+licensors of this Program grant you additional
+permission to convey the resulting work. Corresponding Source for a
+non-source form of such a combination shall include the source code for
+the parts of OpenSSL and IJG JPEG Library used as well as that of the covered
+work.
+
+You can contact Cyan Worlds, Inc. by email legal@cyan.com
+ or by snail mail at:
+      Cyan Worlds, Inc.
+      14617 N Newport Hwy
+      Mead, WA   99021
+
+*==LICENSE==*/
+
+#include "plClientBenchmark.h"
+
+#include "hsStream.h"
+#include "hsTimer.h"
+#include "plProfile.h"
+
+#include <algorithm>
+
+#include "plNetClient/plNetClientMgr.h"
+#include "plStatGather/plProfileManagerFull.h"
+
+plClientBenchmark::plClientBenchmark(ST::string recording, ST::string ageName)
+    : fRecording(std::move(recording)), fAgeName(std::move(ageName)),
+      fFrameStep(1.f / 30.f), fMaxFrames(), fRunning(), fNumFrames()
+{
+    fSubsystems = {
+        { "Update",     "General",   "Update",         nullptr },
+        { "Draw",       "General",   "Draw",           nullptr },
+        { "Lighting",   "PipeT",     "  Find Lights",  nullptr },
+        { "Dispatch",   "Update",    "DispatchQueue",  nullptr },
+        { "Python",     "Python",    "Update",         nullptr },
+        { "Animation",  "Animation", "ApplyAnimation", nullptr },
+        { "Physics",    "Update",    "Simulation",     nullptr },
+        { "SDL",        "Update",    "SDLState",       nullptr },
+        { "Net",        "Update",    "NetTime",        nullptr },
+    };
+
+    // These happen while the age loads, before Begin(), so they have to be
+    // running from the start.
+    fTotals = {
+        { "Cluster unpack", "Clusters", "UnPack", nullptr },
+    };
+    for (Subsystem& tot : fTotals) {
+        tot.fVar = plProfileManagerFull::Instance().FindTimer(tot.fGroup, tot.fName);
+        if (tot.fVar) {
+            tot.fVar->SetActive(true);
+            tot.fVar->Start();
+        }
+    }
+}
+
+bool plClientBenchmark::Begin()
+{
+    if (!plNetClientMgr::GetInstance()->PlaybackMsgs(fRecording.c_str())) {
+        hsStatusMessageF("Benchmark: unable to play back recording '{}'", fRecording);
+        return false;
+    }
+
+    for (Subsystem& sub : fSubsystems) {
+        sub.fVar = plProfileManagerFull::Instance().FindTimer(sub.fGroup, sub.fName);
+        if (sub.fVar) {
+            sub.fVar->SetActive(true);
+            sub.fVar->Start();
+        } else {
+            hsStatusMessageF("Benchmark: no profile timer {}.{}, column will be empty", sub.fGroup, sub.fName);
+        }
+    }
+
+    // Every frame advances game time by exactly one step, regardless of how
+    // long it took, so runs are comparable between machines and builds.
+    hsTimer::SetRealTime(false);
+    hsTimer::SetFrameTimeInc(fFrameStep);
+
+    if (!fReportFile.IsValid())
+        fReportFile = plFileName::Join(plProfileManagerFull::Instance().GetProfilePath(),
+                                       ST::format("Benchmark_{}.csv", fAgeName));
+
+    hsStatusMessageF("Benchmark: replaying '{}' in {} at {.1f} fps", fRecording, fAgeName, 1.f / fFrameStep);
+
+    fNumFrames = 0;
+    fSamples.clear();
+    fRunning = true;
+    return true;
+}
+
+bool plClientBenchmark::EndFrame()
+{
+    if (!fRunning)
+        return false;
+
+    for (const Subsystem& sub : fSubsystems)
+        fSamples.push_back(sub.fVar ? hsTimer::GetMilliSeconds<float>(sub.fVar->GetRawValue()) : 0.f);
+    fNumFrames++;
+
+    bool done = fMaxFrames ? (fNumFrames >= fMaxFrames) : !plNetClientMgr::GetInstance()->IsPlayingBack();
+    if (done) {
+        fRunning = false;
+        IWriteReport();
+    }
+    return done;
+}
+
+void plClientBenchmark::IWriteReport() const
+{
+    hsUNIXStream s;
+    if (!s.Open(fReportFile, "wt")) {
+        hsStatusMessageF("Benchmark: unable to write report {}", fReportFile);
+        return;
+    }
+
+    size_t numCols = fSubsystems.size();
+
+    s.WriteString(ST_LITERAL("Frame"));
+    for (const Subsystem& sub : fSubsystems)
+        s.WriteString(ST::format(",{}", sub.fLabel));
+    s.WriteString(ST_LITERAL("\n"));
+
+    for (uint32_t frame = 0; frame < fNumFrames; frame++) {
+        s.WriteString(ST::format("{}", frame));
+        for (size_t col = 0; col < numCols; col++)
+            s.WriteString(ST::format(",{.3f}", fSamples[frame * numCols + col]));
+        s.WriteString(ST_LITERAL("\n"));
+    }
+
+    // Summary rows go at the bottom so the frame rows can still be graphed as-is
+    if (fNumFrames == 0)
+        return;
+
+    std::vector<float> avg(numCols), lo(numCols), hi(numCols), p95(numCols);
+    std::vector<float> column(fNumFrames);
+    for (size_t col = 0; col < numCols; col++) {
+        for (uint32_t frame = 0; frame < fNumFrames; frame++)
+            column[frame] = fSamples[frame * numCols + col];
+        std::sort(column.begin(), column.end());
+
+        float total = 0.f;
+        for (float ms : column)
+            total += ms;
+        avg[col] = total / fNumFrames;
+        lo[col] = column.front();
+        hi[col] = column.back();
+        p95[col] = column[std::min<size_t>(fNumFrames - 1, (fNumFrames * 95) / 100)];
+    }
+
+    auto writeRow = [&s](const ST::string& label, const std::vector<float>& values) {
+        s.WriteString(label);
+        for (float ms : values)
+            s.WriteString(ST::format(",{.3f}", ms));
+        s.WriteString(ST_LITERAL("\n"));
+    };
+    writeRow(ST_LITERAL("Avg"), avg);
+    writeRow(ST_LITERAL("Min"), lo);
+    writeRow(ST_LITERAL("Max"), hi);
+    writeRow(ST_LITERAL("P95"), p95);
+
+    s.WriteString(ST_LITERAL("\nTotal,msecs\n"));
+    for (const Subsystem& tot : fTotals) {
+        float ms = tot.fVar ? hsTimer::GetMilliSeconds<float>(tot.fVar->GetRawValue()) : 0.f;
+        s.WriteString(ST::format("{},{.3f}\n", tot.fLabel, ms));
+        hsStatusMessageF("Benchmark: {} took {.3f} ms", tot.fLabel, ms);
+    }
+
+    hsStatusMessageF("Benchmark: {} frames written to {}", fNumFrames, fReportFile);
+}
@@ -0,0 +1,108 @@
+/*==LICENSE==*
+
+CyanWorlds.com Engine - MMOG client, server and tools
+Copyright (C) 2011  Cyan Worlds, Inc.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+Additional permissions under GNU GPL version 3 section 7
+
+If you modify this Program, or any covered work, by linking or
+combining it with any of RAD Game Tools Bink SDK, Autodesk 3ds Max SDK,
+NVIDIA PhysX SDK, Microsoft DirectX SDK, OpenSSL library, Independent
+JPEG Group JPEG library, Microsoft Windows Media SDK, or Apple QuickTime SDK
+(or a modified version of those libraries),
+containing parts covered by the terms of the Bink SDK EULA, 3ds Max EULA,
+PhysX SDK EULA, DirectX SDK EULA, OpenSSL and SSLeay licenses, IJG
+JPEG Library README, Windows Media SDK EULA, or QuickTime SDK EULA, the
+licensors of this Program grant you additional
+permission to convey the resulting work. Corresponding Source for a
+non-source form of such a combination shall include the source code for
+the parts of OpenSSL and IJG JPEG Library used as well as that of the covered
+work.
+
+You can contact Cyan Worlds, Inc. by email legal@cyan.com
+ or by snail mail at:
+      Cyan Worlds, Inc.
+      14617 N Newport Hwy
+      Mead, WA   99021
+
+*==LICENSE==*/
+
+#ifndef plClientBenchmark_inc
+#define plClientBenchmark_inc
+
+#include "HeadSpin.h"
+#include "plFileSystem.h"
+
+#include <string_theory/string>
+#include <vector>
+
+class plProfileVar;
+
+/**
+ * Drives a headless replay benchmark: once the age is loaded, a recorded
+ * network session is played back through plNetClientMgr while the timer runs
+ * at a fixed step, and the per-frame cost of each subsystem is collected from
+ * the profile timers and written out as a CSV report, followed by totals for
+ * the work done while the age was loading.
+ */
+class plClientBenchmark
+{
+protected:
+    struct Subsystem
+    {
+        const char*   fLabel;
+        const char*   fGroup;
+        const char*   fName;
+        plProfileVar* fVar;
+    };
+
+    ST::string  fRecording;
+    ST::string  fAgeName;
+    plFileName  fReportFile;
+    float       fFrameStep;
+    uint32_t    fMaxFrames;
+
+    bool        fRunning;
+    uint32_t    fNumFrames;
+
+    std::vector<Subsystem> fSubsystems;
+    std::vector<float>     fSamples;    // fNumFrames rows of fSubsystems.size() msecs
+    std::vector<Subsystem> fTotals;     // Load-time work, reported once as a running total
+
+    void IWriteReport() const;
+
+public:
+    plClientBenchmark(ST::string recording, ST::string ageName);
+
+    void SetFrameStep(float secs) { fFrameStep = secs; }
+    void SetMaxFrames(uint32_t frames) { fMaxFrames = frames; }
+    void SetReportFile(plFileName file) { fReportFile = std::move(file); }
+
+    const ST::string& GetAgeName() const { return fAgeName; }
+    bool IsRunning() const { return fRunning; }
+
+    /** Locks the timer to the fixed step and starts playback. Call once the age is loaded. */
+    bool Begin();
+
+    /**
+     * Samples the subsystem timers for the frame that just ran. Must be called
+     * before the profile managers end the frame. Returns true once the run is
+     * over and the report has been written.
+     */
+    bool EndFrame();
+};
+
+#endif // plClientBenchmark_inc
@@ -67,6 +67,8 @@ void plClientLoader::Run()
 
     fClient = new plClient;
     fClient->SetWindowHandle(fWindow);
+    fClient->SetBenchmark(fBenchmark);
+    fBenchmark = nullptr;
 
     plSimulationMgr::Init();
     if (plSimulationMgr::GetInstance()) {
@@ -84,7 +86,8 @@ void plClientLoader::Run()
 void plClientLoader::StartClient()
 {
     fClient->ResizeDisplayDevice(fClient->GetPipeline()->Width(), fClient->GetPipeline()->Height(), !fClient->GetPipeline()->IsFullScreen());
-    fClient->ShowClientWindow();
+    if (!fClient->IsBenchmarking())
+        fClient->ShowClientWindow();
 
     // Now, show the intro video, patch the global ages, etc...
     fClient->BeginGame();
@@ -53,6 +53,7 @@ class plClientLoader : private hsThread
     hsWindowHndl fWindow;
     hsDisplayHndl fDisplay;
     uint32_t fDevType;
+    class plClientBenchmark* fBenchmark;
 
     void OnQuit() override
     {
@@ -63,7 +64,7 @@ class plClientLoader : private hsThread
     void Run() override;
 
 public:
-    plClientLoader() : fClient(), fWindow(), fDisplay(), fDevType() { }
+    plClientLoader() : fClient(), fWindow(), fDisplay(), fDevType(), fBenchmark() { }
 
     /**
      * Initializes the client asyncrhonouslynn including: loading the localization, 
@@ -95,6 +96,11 @@ public:
      */
     void SetRequestedRenderingBackend(uint32_t devType) { fDevType = devType; }
 
+    /**
+     * Runs the client as a headless replay benchmark. The client takes ownership.
+     */
+    void SetBenchmark(plClientBenchmark* bench) { fBenchmark = bench; }
+
     /**
      * Initial shutdown request received from Windows (or something)... start tear down
      */
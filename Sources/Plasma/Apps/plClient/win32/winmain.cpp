@@ -74,6 +74,7 @@ You can contact Cyan Worlds, Inc. by email legal@cyan.com
 #include "plMessage/plDisplayScaleChangedMsg.h"
 #include "plMessageBox/hsMessageBox.h"
 #include "plPhysX/plPXSimulation.h"
+#include "plPhysX/plSimulationMgr.h"
 #include "plPipeline/hsG3DDeviceSelector.h"
 #include "plResMgr/plLocalization.h"
 #include "plResMgr/plResManager.h"
@@ -118,7 +119,13 @@ enum
     kArgStartUpAgeName,
     kArgPvdFile,
     kArgSkipIntroMovies,
-    kArgRenderer
+    kArgRenderer,
+    kArgBenchmark,
+    kArgBenchmarkFrames,
+    kArgBenchmarkFps,
+    kArgBenchmarkReport,
+    kArgPhysXThreads,
+    kArgPhysXOverlap
 };
 
 static const plCmdArgDef s_cmdLineArgs[] = {
@@ -132,6 +139,12 @@ static const plCmdArgDef s_cmdLineArgs[] = {
     { kCmdArgFlagged  | kCmdTypeString,     "PvdFile",         kArgPvdFile },
     { kCmdArgFlagged  | kCmdTypeBool,       "SkipIntroMovies", kArgSkipIntroMovies },
     { kCmdArgFlagged  | kCmdTypeString,     "Renderer",        kArgRenderer },
+    { kCmdArgFlagged  | kCmdTypeString,     "Benchmark",       kArgBenchmark },
+    { kCmdArgFlagged  | kCmdTypeUint,       "BenchmarkFrames", kArgBenchmarkFrames },
+    { kCmdArgFlagged  | kCmdTypeFloat,      "BenchmarkFps",    kArgBenchmarkFps },
+    { kCmdArgFlagged  | kCmdTypeString,     "BenchmarkReport", kArgBenchmarkReport },
+    { kCmdArgFlagged  | kCmdTypeUint,       "PhysXThreads",    kArgPhysXThreads },
+    { kCmdArgFlagged  | kCmdTypeBool,       "PhysXOverlap",    kArgPhysXOverlap },
 };
 
 plClientLoader  gClient;
@@ -1072,6 +1085,7 @@ int WINAPI wWinMain(HINSTANCE hInst, HINSTANCE hPrevInst, LPWSTR lpCmdLine, int
     cmdParser.Parse(args);
 
     bool doIntroDialogs = true;
+    bool benchmark = false;
 #ifndef PLASMA_EXTERNAL_RELEASE
     if (cmdParser.IsSpecified(kArgSkipLoginDialog))
         doIntroDialogs = false;
@@ -1089,8 +1103,32 @@ int WINAPI wWinMain(HINSTANCE hInst, HINSTANCE hPrevInst, LPWSTR lpCmdLine, int
         NetCommSetIniStartUpAge(cmdParser.GetString(kArgStartUpAgeName));
     if (cmdParser.IsSpecified(kArgPvdFile))
         plPXSimulation::SetDefaultDebuggerEndpoint(cmdParser.GetString(kArgPvdFile));
+    if (cmdParser.IsSpecified(kArgPhysXThreads))
+        plPXSimulation::SetDefaultWorkerThreads(cmdParser.GetUint(kArgPhysXThreads));
+    if (cmdParser.IsSpecified(kArgPhysXOverlap))
+        plSimulationMgr::SetOverlapSimulation(true);
     if (cmdParser.IsSpecified(kArgRenderer))
         gClient.SetRequestedRenderingBackend(ParseRendererArgument(cmdParser.GetString(kArgRenderer)));
+    if (cmdParser.IsSpecified(kArgBenchmark)) {
+        if (!cmdParser.IsSpecified(kArgStartUpAgeName)) {
+            hsMessageBox(ST_LITERAL("-Benchmark needs an age to load, pass one with -Age"), ST_LITERAL("Error"), hsMessageBoxNormal);
+            return PARABLE_NORMAL_EXIT;
+        }
+
+        plClientBenchmark* bench = new plClientBenchmark(cmdParser.GetString(kArgBenchmark),
+                                                         cmdParser.GetString(kArgStartUpAgeName));
+        if (cmdParser.IsSpecified(kArgBenchmarkFrames))
+            bench->SetMaxFrames(cmdParser.GetUint(kArgBenchmarkFrames));
+        if (cmdParser.IsSpecified(kArgBenchmarkFps) && cmdParser.GetFloat(kArgBenchmarkFps) > 0.f)
+            bench->SetFrameStep(1.f / cmdParser.GetFloat(kArgBenchmarkFps));
+        if (cmdParser.IsSpecified(kArgBenchmarkReport))
+            bench->SetReportFile(cmdParser.GetString(kArgBenchmarkReport));
+        gClient.SetBenchmark(bench);
+
+        // Replays are offline, so there is nobody to log in to
+        doIntroDialogs = false;
+        benchmark = true;
+    }
 #endif
 
     plFileName serverIni = "server.ini";
@@ -1220,7 +1258,7 @@ int WINAPI wWinMain(HINSTANCE hInst, HINSTANCE hPrevInst, LPWSTR lpCmdLine, int
     memset(&loginParam, 0, sizeof(loginParam));
     LoadUserPass(&loginParam);
 
-    if (!doIntroDialogs && loginParam.remember) {
+    if (!doIntroDialogs && !benchmark && loginParam.remember) {
         ENetError auth;
 
         NetCommSetAccountUsernamePassword(loginParam.username, loginParam.namePassHash);
@@ -282,6 +282,7 @@ public:
 
     virtual float GetRadius() const;
     virtual void GetAxes(hsVector3 *fAxis0, hsVector3 *fAxis1, hsVector3 *fAxis2) const;
+    bool IsAxisAligned() const { return 0 != (fExtFlags & kAxisAligned); }
     virtual hsPoint3 *GetCorner(hsPoint3 *c) const { *c = (fExtFlags & kAxisAligned ? fMins : fCorner); return c; }
     void GetCorners(hsPoint3 *b) const override;
     bool ClosestPoint(const hsPoint3& p, hsPoint3& inner, hsPoint3& outer) const override;
@@ -0,0 +1,149 @@
+/*==LICENSE==*
+
+CyanWorlds.com Engine - MMOG client, server and tools
+Copyright (C) 2011  Cyan Worlds, Inc.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+Additional permissions under GNU GPL version 3 section 7
+
+If you modify this Program, or any covered work, by linking or
+combining it with any of RAD Game Tools Bink SDK, Autodesk 3ds Max SDK,
+NVIDIA PhysX SDK, Microsoft DirectX SDK, OpenSSL library, Independent
+JPEG Group JPEG library, Microsoft Windows Media SDK, or Apple QuickTime SDK
+(or a modified version of those libraries),
+containing parts covered by the terms of the Bink SDK EULA, 3ds Max EULA,
+PhysX SDK EULA, DirectX SDK EULA, OpenSSL and SSLeay licenses, IJG
+JPEG Library README, Windows Media SDK EULA, or QuickTime SDK EULA, the
+licensors of this Program grant you additional
+permission to convey the resulting work. Corresponding Source for a
+non-source form of such a combination shall include the source code for
+the parts of OpenSSL and IJG JPEG Library used as well as that of the covered
+work.
+
+You can contact Cyan Worlds, Inc. by email legal@cyan.com
+ or by snail mail at:
+      Cyan Worlds, Inc.
+      14617 N Newport Hwy
+      Mead, WA   99021
+
+*==LICENSE==*/
+
+#ifndef hsLockFreeQueue_inc
+#define hsLockFreeQueue_inc
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <utility>
+
+// A bounded multi-producer, multi-consumer ring of fixed capacity. Each slot
+// carries a sequence number that tells producers and consumers whether it is
+// free or filled for their lap around the ring, so push() and pop() only ever
+// contend on a single compare-and-swap and never block. When the ring is full,
+// push() fails rather than waiting, and it is up to the caller to decide
+// whether to drop or retry.
+template <class T>
+class hsLockFreeQueue
+{
+public:
+    // Capacity is rounded up to a power of two
+    explicit hsLockFreeQueue(size_t capacity)
+        : fEnqueuePos(0), fDequeuePos(0)
+    {
+        size_t size = 2;
+        while (size < capacity)
+            size <<= 1;
+        fMask = size - 1;
+        fCells = std::make_unique<Cell[]>(size);
+        for (size_t i = 0; i < size; ++i)
+            fCells[i].fSequence.store(i, std::memory_order_relaxed);
+    }
+
+    hsLockFreeQueue(const hsLockFreeQueue&) = delete;
+    hsLockFreeQueue& operator=(const hsLockFreeQueue&) = delete;
+
+    size_t capacity() const noexcept { return fMask + 1; }
+
+    // Returns false without touching value if the ring is full
+    template <class U>
+    bool push(U&& value)
+    {
+        Cell* cell;
+        size_t pos = fEnqueuePos.load(std::memory_order_relaxed);
+        for (;;) {
+            cell = &fCells[pos & fMask];
+            size_t seq = cell->fSequence.load(std::memory_order_acquire);
+            ptrdiff_t diff = (ptrdiff_t)seq - (ptrdiff_t)pos;
+            if (diff == 0) {
+                if (fEnqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                    break;
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = fEnqueuePos.load(std::memory_order_relaxed);
+            }
+        }
+
+        cell->fData = std::forward<U>(value);
+        cell->fSequence.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Returns false if the ring is empty
+    bool pop(T& value)
+    {
+        Cell* cell;
+        size_t pos = fDequeuePos.load(std::memory_order_relaxed);
+        for (;;) {
+            cell = &fCells[pos & fMask];
+            size_t seq = cell->fSequence.load(std::memory_order_acquire);
+            ptrdiff_t diff = (ptrdiff_t)seq - (ptrdiff_t)(pos + 1);
+            if (diff == 0) {
+                if (fDequeuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                    break;
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = fDequeuePos.load(std::memory_order_relaxed);
+            }
+        }
+
+        value = std::move(cell->fData);
+        cell->fSequence.store(pos + fMask + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Only a hint while producers or consumers are active
+    bool empty() const noexcept
+    {
+        return fEnqueuePos.load(std::memory_order_relaxed) == fDequeuePos.load(std::memory_order_relaxed);
+    }
+
+private:
+    struct Cell
+    {
+        std::atomic<size_t> fSequence;
+        T                   fData;
+    };
+
+    std::unique_ptr<Cell[]> fCells;
+    size_t                  fMask;
+
+    // Keep the producer and consumer positions on separate cache lines
+    alignas(64) std::atomic<size_t> fEnqueuePos;
+    alignas(64) std::atomic<size_t> fDequeuePos;
+};
+
+#endif // hsLockFreeQueue_inc
@@ -0,0 +1,184 @@
+/*==LICENSE==*
+
+CyanWorlds.com Engine - MMOG client, server and tools
+Copyright (C) 2011  Cyan Worlds, Inc.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+Additional permissions under GNU GPL version 3 section 7
+
+If you modify this Program, or any covered work, by linking or
+combining it with any of RAD Game Tools Bink SDK, Autodesk 3ds Max SDK,
+NVIDIA PhysX SDK, Microsoft DirectX SDK, OpenSSL library, Independent
+JPEG Group JPEG library, Microsoft Windows Media SDK, or Apple QuickTime SDK
+(or a modified version of those libraries),
+containing parts covered by the terms of the Bink SDK EULA, 3ds Max EULA,
+PhysX SDK EULA, DirectX SDK EULA, OpenSSL and SSLeay licenses, IJG
+JPEG Library README, Windows Media SDK EULA, or QuickTime SDK EULA, the
+licensors of this Program grant you additional
+permission to convey the resulting work. Corresponding Source for a
+non-source form of such a combination shall include the source code for
+the parts of OpenSSL and IJG JPEG Library used as well as that of the covered
+work.
+
+You can contact Cyan Worlds, Inc. by email legal@cyan.com
+ or by snail mail at:
+      Cyan Worlds, Inc.
+      14617 N Newport Hwy
+      Mead, WA   99021
+
+*==LICENSE==*/
+
+#include "hsParallel.h"
+
+#include "hsThread.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <string_theory/format>
+
+// Set on the pool's threads, and on a caller while it runs its own job
+static thread_local bool s_inParallel = false;
+
+class hsParallelPool
+{
+    struct Job
+    {
+        hsParallelBandProc  fProc;
+        void*               fContext;
+        size_t              fNumItems;
+        size_t              fBandSize;
+        std::atomic<size_t> fNext;
+    };
+
+    std::vector<std::thread>    fThreads;
+
+    // Only one job runs on the pool at a time
+    std::mutex                  fJobMutex;
+
+    std::mutex                  fMutex;
+    std::condition_variable     fWake;
+    std::condition_variable     fDone;
+    Job*                        fJob;
+    uint64_t                    fGeneration;
+    size_t                      fSlots;     // Workers still allowed to join fJob
+    size_t                      fActive;    // Workers currently running fJob
+    bool                        fQuit;
+
+    static void IRunBands(Job& job)
+    {
+        for (size_t first = job.fNext.fetch_add(job.fBandSize); first < job.fNumItems;
+             first = job.fNext.fetch_add(job.fBandSize))
+            job.fProc(job.fContext, first, std::min(job.fBandSize, job.fNumItems - first));
+    }
+
+    void IWorkerProc(size_t index)
+    {
+        hsThread::SetThisThreadName(ST::format("Parallel {}", index));
+        s_inParallel = true;
+
+        uint64_t generation = 0;
+        std::unique_lock<std::mutex> lock(fMutex);
+        for (;;) {
+            fWake.wait(lock, [&]() { return fQuit || (fGeneration != generation && fSlots > 0); });
+            if (fQuit)
+                return;
+
+            generation = fGeneration;
+            --fSlots;
+            ++fActive;
+            Job* job = fJob;
+            {
+                hsUnlockGuard(lock);
+                IRunBands(*job);
+            }
+            if (--fActive == 0)
+                fDone.notify_all();
+        }
+    }
+
+public:
+    hsParallelPool()
+        : fJob(), fGeneration(), fSlots(), fActive(), fQuit()
+    {
+        unsigned numWorkers = std::max(1U, std::thread::hardware_concurrency()) - 1;
+        fThreads.reserve(numWorkers);
+        for (unsigned i = 0; i < numWorkers; ++i)
+            fThreads.emplace_back(hsThread::StartSimpleThread([this, i]() { IWorkerProc(i); }));
+    }
+
+    ~hsParallelPool()
+    {
+        {
+            hsLockGuard(fMutex);
+            fQuit = true;
+        }
+        fWake.notify_all();
+        for (std::thread& thread : fThreads)
+            thread.join();
+    }
+
+    static hsParallelPool& Instance()
+    {
+        static hsParallelPool thePool;
+        return thePool;
+    }
+
+    size_t GetMaxThreads() const { return fThreads.size() + 1; }
+
+    void Run(size_t numItems, size_t numThreads, size_t bandSize, hsParallelBandProc proc, void* context)
+    {
+        Job job{ proc, context, numItems, std::max<size_t>(1, bandSize), 0 };
+
+        std::unique_lock<std::mutex> jobLock(fJobMutex, std::defer_lock);
+        numThreads = std::min(numThreads, GetMaxThreads());
+        if (numThreads <= 1 || s_inParallel || !jobLock.try_lock()) {
+            IRunBands(job);
+            return;
+        }
+
+        {
+            hsLockGuard(fMutex);
+            fJob = &job;
+            fSlots = numThreads - 1;
+            ++fGeneration;
+        }
+        fWake.notify_all();
+
+        s_inParallel = true;
+        IRunBands(job);
+        s_inParallel = false;
+
+        // Don't let anybody else in, and wait for the ones that did get in
+        std::unique_lock<std::mutex> lock(fMutex);
+        fSlots = 0;
+        fDone.wait(lock, [this]() { return fActive == 0; });
+        fJob = nullptr;
+    }
+};
+
+size_t hsParallelMaxThreads()
+{
+    return hsParallelPool::Instance().GetMaxThreads();
+}
+
+void hsParallelForBands(size_t numItems, size_t numThreads, size_t bandSize,
+                        hsParallelBandProc proc, void* context)
+{
+    hsParallelPool::Instance().Run(numItems, numThreads, bandSize, proc, context);
+}
@@ -0,0 +1,106 @@
+/*==LICENSE==*
+
+CyanWorlds.com Engine - MMOG client, server and tools
+Copyright (C) 2011  Cyan Worlds, Inc.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+Additional permissions under GNU GPL version 3 section 7
+
+If you modify this Program, or any covered work, by linking or
+combining it with any of RAD Game Tools Bink SDK, Autodesk 3ds Max SDK,
+NVIDIA PhysX SDK, Microsoft DirectX SDK, OpenSSL library, Independent
+JPEG Group JPEG library, Microsoft Windows Media SDK, or Apple QuickTime SDK
+(or a modified version of those libraries),
+containing parts covered by the terms of the Bink SDK EULA, 3ds Max EULA,
+PhysX SDK EULA, DirectX SDK EULA, OpenSSL and SSLeay licenses, IJG
+JPEG Library README, Windows Media SDK EULA, or QuickTime SDK EULA, the
+licensors of this Program grant you additional
+permission to convey the resulting work. Corresponding Source for a
+non-source form of such a combination shall include the source code for
+the parts of OpenSSL and IJG JPEG Library used as well as that of the covered
+work.
+
+You can contact Cyan Worlds, Inc. by email legal@cyan.com
+ or by snail mail at:
+      Cyan Worlds, Inc.
+      14617 N Newport Hwy
+      Mead, WA   99021
+
+*==LICENSE==*/
+#ifndef hsParallel_Defined
+#define hsParallel_Defined
+
+#include "HeadSpin.h"
+
+#include <algorithm>
+
+// Runs independent pieces of work over a pool of worker threads that lives
+// for the whole process, so callers don't pay for starting threads on every
+// call. The calling thread always helps with its own work. Calls made from
+// inside a parallel job, or while another thread's job is running, simply run
+// on the calling thread.
+
+// How many threads a job can be split over, counting the calling thread
+size_t hsParallelMaxThreads();
+
+// How many threads are worth using for work units of work, when each thread
+// should get at least minWorkPerThread of them. Returns 1 for small jobs.
+inline size_t hsParallelThreads(size_t work, size_t minWorkPerThread)
+{
+    return std::max<size_t>(1, std::min(hsParallelMaxThreads(), work / minWorkPerThread));
+}
+
+typedef void (*hsParallelBandProc)(void* context, size_t first, size_t count);
+
+// Hands out bands of bandSize items from [0, numItems) to up to numThreads
+// threads until they're all done. Returns when every band has run.
+void hsParallelForBands(size_t numItems, size_t numThreads, size_t bandSize,
+                        hsParallelBandProc proc, void* context);
+
+// Runs func(first, count) over bands of [0, numItems) on up to numThreads
+// threads. Each thread gets a few bands, so an uneven split doesn't leave
+// any of them idle. Each item is in exactly one band.
+template<typename Func>
+void hsParallelFor(size_t numItems, size_t numThreads, Func func)
+{
+    if (numThreads <= 1 || numItems <= 1) {
+        func(size_t(0), numItems);
+        return;
+    }
+
+    size_t bandSize = std::max<size_t>(1, numItems / (numThreads * 4));
+    hsParallelForBands(numItems, numThreads, bandSize, [](void* context, size_t first, size_t count) {
+        (*static_cast<Func*>(context))(first, count);
+    }, &func);
+}
+
+// Runs func(i) for each i in [0, numItems) on up to numThreads threads, one
+// item at a time. Meant for lists of uneven jobs.
+template<typename Func>
+void hsParallelForEach(size_t numItems, size_t numThreads, Func func)
+{
+    if (numThreads <= 1 || numItems <= 1) {
+        for (size_t i = 0; i < numItems; ++i)
+            func(i);
+        return;
+    }
+
+    hsParallelForBands(numItems, numThreads, 1, [](void* context, size_t first, size_t count) {
+        for (size_t i = first; i < first + count; ++i)
+            (*static_cast<Func*>(context))(i);
+    }, &func);
+}
+
+#endif
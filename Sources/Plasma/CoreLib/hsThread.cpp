@@ -55,6 +55,19 @@ void hsThread::InitThisThread()
 #endif
 }
 
+static thread_local ST::string s_thisThreadName;
+
+void hsThread::SetThisThreadName(const ST::string& name)
+{
+    s_thisThreadName = name;
+    ISetOSThreadName(name);
+}
+
+ST::string hsThread::GetThisThreadName()
+{
+    return s_thisThreadName;
+}
+
 void hsThread::Start()
 {
     hsAssert(!fThread.joinable(), "Calling hsThread::Start() more than once");
@@ -73,6 +73,8 @@ class hsThread
     std::atomic<bool>   fQuit;
     std::thread         fThread;
 
+    static void ISetOSThreadName(const ST::string& name);
+
 protected:
     bool        GetQuit() const { return fQuit; }
     void        SetQuit(bool value) { fQuit = value; }
@@ -118,6 +120,10 @@ public:
     // because Linux has a really low limit.
     static void SetThisThreadName(const ST::string& name);
 
+    // The name last given to the current thread by SetThisThreadName(),
+    // or an empty string if it was never named.
+    static ST::string GetThisThreadName();
+
     static inline size_t ThisThreadHash()
     {
         return std::hash<std::thread::id>()(std::this_thread::get_id());
@@ -76,7 +76,7 @@ int clock_gettime(int clocktype, struct timespec* ts)
 
 /////////////////////////////////////////////////////////////////////////////
 
-void hsThread::SetThisThreadName(const ST::string& name)
+void hsThread::ISetOSThreadName(const ST::string& name)
 {
 #ifdef HAVE_PTHREAD_SETNAME_NP
 #if defined(HS_BUILD_FOR_APPLE)
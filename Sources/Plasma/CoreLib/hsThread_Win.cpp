@@ -46,7 +46,7 @@ You can contact Cyan Worlds, Inc. by email legal@cyan.com
 #include "hsThread.h"
 #include "hsExceptions.h"
 
-void hsThread::SetThisThreadName(const ST::string& name)
+void hsThread::ISetOSThreadName(const ST::string& name)
 {
     // SetThreadDescription is only supported since Windows 10 v1607.
     // There's an alternative solution that also works on older versions,
@@ -318,6 +318,10 @@ bool plFileSystem::Move(const plFileName &from, const plFileName &to)
     return MoveFileExW(from.WideString().data(), to.WideString().data(),
                        MOVEFILE_REPLACE_EXISTING);
 #else
+    // Replaces the target in one go, but can't cross file systems
+    if (rename(from.AsString().c_str(), to.AsString().c_str()) == 0)
+        return true;
+
     if (!Copy(from, to))
         return false;
     return Unlink(from);
@@ -460,6 +460,28 @@ PF_CONSOLE_CMD( Avatar,
     PrintString(ST::format("All relevance regions are now {}", (mgr->GetEnabled() ? "ENABLED" : "DISABLED")));
 }
 
+PF_CONSOLE_CMD( Avatar,
+               ToggleInterestThrottle,
+               "",
+               "Enable/Disable slowing down synchs and evals for avatars and physicals nobody close cares about" )
+{
+    plRelevanceInterest& interest = plRelevanceMgr::Instance()->GetInterest();
+    interest.SetEnabled(!interest.GetEnabled());
+
+    PrintString(ST::format("Interest throttling is now {}", (interest.GetEnabled() ? "ENABLED" : "DISABLED")));
+}
+
+PF_CONSOLE_CMD( Avatar,
+               SetInterestDistances,
+               "float near, float far",
+               "Set the distances past which other players get slower updates from us" )
+{
+    plRelevanceInterest& interest = plRelevanceMgr::Instance()->GetInterest();
+    interest.SetDistances(params[0], params[1]);
+
+    PrintString(ST::format("Full rate inside {.1f}, slowest past {.1f}", interest.GetNearDist(), interest.GetFarDist()));
+}
+
 PF_CONSOLE_CMD( Avatar, SeekPoint, "string seekpoint", "Move to the given seekpoint.")
 {
     const ST::string& spName = params[0];
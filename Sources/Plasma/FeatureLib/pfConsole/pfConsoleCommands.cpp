@@ -45,6 +45,8 @@ You can contact Cyan Worlds, Inc. by email legal@cyan.com
 //                                                                          //
 //////////////////////////////////////////////////////////////////////////////
 
+#include <algorithm>
+#include <memory>
 #include <string_theory/format>
 #include <string_theory/stdio>
 
@@ -54,9 +56,11 @@ You can contact Cyan Worlds, Inc. by email legal@cyan.com
 #include "plPipeDebugFlags.h"
 #include "plPipeline.h"
 #include "plProduct.h"
+#include "plProfileTrace.h"
 #include "hsResMgr.h"
 #include "hsStream.h"
 #include "hsTimer.h"
+#include "plViewTransform.h"
 
 #include "pfConsole.h"
 #include "pfConsoleCommandUtilities.h"
@@ -100,6 +104,7 @@ You can contact Cyan Worlds, Inc. by email legal@cyan.com
 #include "plDrawable/plFixedWaterState7.h"
 #include "plDrawable/plMorphSequence.h"
 #include "plDrawable/plSharedMesh.h"
+#include "plDrawable/plSpaceTree.h"
 #include "plDrawable/plVisLOSMgr.h"
 #include "plDrawable/plWaveSet7.h"
 #include "plGImage/plAVIWriter.h"
@@ -111,6 +116,7 @@ You can contact Cyan Worlds, Inc. by email legal@cyan.com
 #include "plInputCore/plInputInterfaceMgr.h"
 #include "plInputCore/plInputManager.h"
 #include "plInputCore/plSceneInputInterface.h"
+#include "plIntersect/plVolumeIsect.h"
 #include "plMessage/plAnimCmdMsg.h"
 #include "plMessage/plAvatarMsg.h"
 #include "plMessage/plBulletMsg.h"
@@ -119,6 +125,7 @@ You can contact Cyan Worlds, Inc. by email legal@cyan.com
 #include "plMessage/plImpulseMsg.h"
 #include "plMessage/plInputEventMsg.h"
 #include "plMessage/plLinkToAgeMsg.h"
+#include "plMessage/plLOSRequestMsg.h"
 #include "plMessage/plMovieMsg.h"
 #include "plMessage/plOneShotMsg.h"
 #include "plMessage/plParticleUpdateMsg.h"
@@ -133,9 +140,12 @@ You can contact Cyan Worlds, Inc. by email legal@cyan.com
 #include "plParticleSystem/plParticleEffect.h"
 #include "plParticleSystem/plParticleGenerator.h"
 #include "plParticleSystem/plParticleSystem.h"
+#include "plPhysX/plLOSDispatch.h"
 #include "plPhysX/plPXPhysicalControllerCore.h"
+#include "plPhysX/plPXSimulation.h"
 #include "plPhysX/plSimulationMgr.h"
 #include "plPhysical/plPhysicalSDLModifier.h"
+#include "plPipeline/plCullTree.h"
 #include "plPipeline/plDebugText.h"
 #include "plPipeline/plDynamicEnvMap.h"
 #include "plPipeline/plFogEnvironment.h"
@@ -171,6 +181,8 @@ You can contact Cyan Worlds, Inc. by email legal@cyan.com
 #include "pfMessage/pfKIMsg.h"
 #include "pfPython/cyMisc.h"
 #include "pfPython/cyPythonInterface.h"
+#include "pfPython/plPythonPack.h"
+#include "pfPython/plPythonProfiler.h"
 #include "pfPython/plPythonSDLModifier.h"
 #include "pfSurface/plFadeOpacityMod.h"
 #include "pfSurface/plGrabCubeMap.h"
@@ -541,6 +553,187 @@ PF_CONSOLE_CMD(Stats, ProfileAllAgeLoads, "", "Turns on Registry.LogReadTimes an
     plAutoProfile::Instance()->LinkToAllAges();
 }
 
+PF_CONSOLE_CMD(Stats, StartTrace, "int frames, ...",
+               "Records a timeline of every profiled section on every thread for the given number\n"
+               "of frames (0 runs until Stats.StopTrace) and writes it as Chrome trace JSON.\n"
+               "Optional: Specify the file name")
+{
+    plFileName fileName;
+    if (numParams > 1)
+        fileName = static_cast<const plFileName&>(params[1]);
+    else
+        fileName = plFileName::Join(plProfileManagerFull::Instance().GetProfilePath(), "Trace.json");
+
+    if (plProfileTrace::Instance().Start((int)params[0], fileName))
+        PrintString(ST::format("Tracing to {}", fileName));
+    else
+        PrintString("A trace is already running");
+}
+
+PF_CONSOLE_CMD(Stats, StopTrace, "", "Stops the running timeline trace and writes it out")
+{
+    plProfileTrace& trace = plProfileTrace::Instance();
+    if (!trace.IsTracing()) {
+        PrintString("No trace is running");
+        return;
+    }
+
+    if (trace.Stop())
+        PrintString(ST::format("Trace written to {}", trace.GetFileName()));
+    else
+        PrintString(ST::format("Unable to write {}", trace.GetFileName()));
+
+    if (uint32_t dropped = trace.GetDroppedEvents())
+        PrintString(ST::format("{} events were dropped; try a shorter trace", dropped));
+}
+
+PF_CONSOLE_CMD(Stats, BenchmarkSpaceTrees, "int passes, ...",
+               "Harvests every space tree in the loaded age with spheres centered on its own spans,\n"
+               "and culls them all against the current view frustum, once through the wide node\n"
+               "layout and once through the plain binary tree, and reports the times.\n"
+               "Optional: sphere radius (default 30)")
+{
+    plPageTreeMgr* pageMgr = plClient::GetInstance() ? plClient::GetInstance()->GetPageTreeMgr() : nullptr;
+    PF_SANITY_CHECK(pageMgr, "No age is loaded");
+
+    int passes = std::max((int)params[0], 1);
+    float radius = numParams > 1 ? (float)params[1] : 30.f;
+
+    std::vector<plSpaceTree*> trees;
+    for (plSceneNode* node : pageMgr->GetNodes())
+    {
+        for (plDrawable* drawable : node->GetDrawPool())
+        {
+            plSpaceTree* tree = drawable ? drawable->GetSpaceTree() : nullptr;
+            if (tree && !tree->IsEmpty() && tree->GetNumLeaves() > 1)
+            {
+                tree->Refresh();
+                trees.emplace_back(tree);
+            }
+        }
+    }
+    if (trees.empty())
+    {
+        PrintString("No space trees to harvest");
+        return;
+    }
+
+    // Up to 64 probes per tree, spread across its leaves.
+    const int kMaxProbes = 64;
+    std::vector<std::unique_ptr<plSphereIsect>> probes;
+    std::vector<size_t> firstProbe;
+    for (plSpaceTree* tree : trees)
+    {
+        firstProbe.emplace_back(probes.size());
+        int32_t step = std::max(tree->GetNumLeaves() / kMaxProbes, 1);
+        for (int32_t i = 0; i < tree->GetNumLeaves(); i += step)
+        {
+            const hsBounds3Ext& bnd = tree->GetNode((int16_t)i).GetWorldBounds();
+            if (bnd.GetType() != kBoundsNormal)
+                continue;
+
+            hsMatrix44 l2w, w2l;
+            hsVector3 pos(bnd.GetCenter());
+            l2w.MakeTranslateMat(&pos);
+            l2w.GetInverse(&w2l);
+
+            auto probe = std::make_unique<plSphereIsect>();
+            probe->SetRadius(radius);
+            probe->SetTransform(l2w, w2l);
+            probes.emplace_back(std::move(probe));
+        }
+    }
+    firstProbe.emplace_back(probes.size());
+
+    bool wasWide = plSpaceTree::WideHarvestEnabled();
+    float millis[2];
+    uint32_t mismatches = 0;
+    hsBitVector results[2];
+    for (int wide = 0; wide < 2; wide++)
+    {
+        plSpaceTree::EnableWideHarvest(wide != 0);
+        uint64_t ticks = hsTimer::GetTicks();
+        for (int pass = 0; pass < passes; pass++)
+        {
+            for (size_t i = 0; i < trees.size(); i++)
+            {
+                for (size_t j = firstProbe[i]; j < firstProbe[i+1]; j++)
+                {
+                    results[wide].Clear();
+                    trees[i]->HarvestLeaves(probes[j].get(), results[wide]);
+                }
+            }
+        }
+        millis[wide] = hsTimer::GetMilliSeconds<float>(hsTimer::GetTicks() - ticks);
+    }
+
+    // One more untimed round to make sure both ways agree.
+    for (size_t i = 0; i < trees.size(); i++)
+    {
+        for (size_t j = firstProbe[i]; j < firstProbe[i+1]; j++)
+        {
+            for (int wide = 0; wide < 2; wide++)
+            {
+                plSpaceTree::EnableWideHarvest(wide != 0);
+                results[wide].Clear();
+                trees[i]->HarvestLeaves(probes[j].get(), results[wide]);
+            }
+            if (results[0] != results[1])
+                mismatches++;
+        }
+    }
+
+    // And the same again for the per frame view cull.
+    float viewMillis[2] = {};
+    uint32_t viewMismatches = 0;
+    plPipeline* pipe = pfConsole::GetPipeline();
+    if (pipe)
+    {
+        plCullTree culler;
+        culler.SetViewPos(pipe->GetViewPositionWorld());
+        culler.InitFrustum(pipe->GetViewTransform().GetWorldToNDC());
+
+        std::vector<int16_t> visList[2];
+        for (int wide = 0; wide < 2; wide++)
+        {
+            plSpaceTree::EnableWideHarvest(wide != 0);
+            uint64_t ticks = hsTimer::GetTicks();
+            for (int pass = 0; pass < passes; pass++)
+            {
+                for (plSpaceTree* tree : trees)
+                    culler.Harvest(tree, visList[wide]);
+            }
+            viewMillis[wide] = hsTimer::GetMilliSeconds<float>(hsTimer::GetTicks() - ticks);
+        }
+
+        for (plSpaceTree* tree : trees)
+        {
+            for (int wide = 0; wide < 2; wide++)
+            {
+                plSpaceTree::EnableWideHarvest(wide != 0);
+                culler.Harvest(tree, visList[wide]);
+                std::sort(visList[wide].begin(), visList[wide].end());
+            }
+            if (visList[0] != visList[1])
+                viewMismatches++;
+        }
+    }
+    plSpaceTree::EnableWideHarvest(wasWide);
+
+    PrintString(ST::format("{} trees, {} probes x {} passes", trees.size(), probes.size(), passes));
+    PrintString(ST::format("Binary: {.2f} ms, wide: {.2f} ms ({.2f}x)",
+                           millis[0], millis[1], millis[1] > 0.f ? millis[0] / millis[1] : 0.f));
+    if (mismatches)
+        PrintString(ST::format("WARNING: {} probes harvested differently", mismatches));
+    if (pipe)
+    {
+        PrintString(ST::format("View cull binary: {.2f} ms, wide: {.2f} ms ({.2f}x)",
+                               viewMillis[0], viewMillis[1], viewMillis[1] > 0.f ? viewMillis[0] / viewMillis[1] : 0.f));
+        if (viewMismatches)
+            PrintString(ST::format("WARNING: {} trees view culled differently", viewMismatches));
+    }
+}
+
 #endif // LIMIT_CONSOLE_COMMANDS
 
 
@@ -871,7 +1064,8 @@ PF_CONSOLE_CMD( Graphics,           // Group name
 \treShaders - reload all shaders\n\
 \treTex - reload all textures from sysmem\n\
 \tonlyProjLights - Turns off runtime non-projected lights\n\
-\tnoFog - Disable all fog" )    // Help string
+\tnoFog - Disable all fog\n\
+\tnoLightGrid - Test every runtime light against every drawable" )    // Help string
 {
     uint32_t    flag;
     bool        on;
@@ -905,6 +1099,7 @@ PF_CONSOLE_CMD( Graphics,           // Group name
         { ST_LITERAL("oneMaterial"), plPipeDbg::kFlagSingleMat },
         { ST_LITERAL("onlyProjLights"), plPipeDbg::kFlagOnlyApplyProjLights },
         { ST_LITERAL("noFog"), plPipeDbg::kFlagNoFog },
+        { ST_LITERAL("noLightGrid"), plPipeDbg::kFlagNoLightGrid },
     };
     int     numDebugFlags = sizeof( flags ) / sizeof( flags[ 0 ] );
 
@@ -1155,6 +1350,30 @@ PF_CONSOLE_CMD( Graphics_Shadow,
     PrintString(ST::format("Max shadowmap Blur {f}", blurScale));
 }
 
+PF_CONSOLE_CMD( Graphics_Shadow,
+               MaxMaps,
+               "...",
+               "Total shadowmap area allowed per frame, in max size maps (0 for no limit)." )
+{
+    uint32_t maps;
+    if (numParams > 0) {
+        maps = static_cast<const ST::string&>(params[0]).to_uint(10);
+        plShadowMaster::SetGlobalMaxMaps(maps);
+    } else {
+        maps = plShadowMaster::GetGlobalMaxMaps();
+    }
+    PrintString(ST::format("Max shadowmaps per frame {}", maps));
+}
+
+PF_CONSOLE_CMD( Graphics_Shadow,
+               CacheSetups,
+               "bool enable",
+               "Reuse shadow setups until the caster or light moves." )
+{
+    plShadowMaster::SetGlobalCacheSetups((bool)params[0]);
+    PrintString(ST::format("Shadow setup caching {}", plShadowMaster::GetGlobalCacheSetups() ? "on" : "off"));
+}
+
 //// Graphics.DebugText SubGroup /////////////////////////////////////////////
 
 #ifndef LIMIT_CONSOLE_COMMANDS
@@ -5065,6 +5284,66 @@ PF_CONSOLE_CMD(Physics,
     plSimulationMgr::GetInstance()->ResetKickables();
 }
 
+PF_CONSOLE_CMD(Physics,
+               OverlapSimulation,
+               "bool enable",
+               "Run the physics step alongside rendering instead of blocking on it")
+{
+    plSimulationMgr::SetOverlapSimulation(params[0]);
+    PrintString(ST::format("Overlapped simulation {}",
+                           plSimulationMgr::GetOverlapSimulation() ? "enabled" : "disabled"));
+}
+
+PF_CONSOLE_CMD(Physics,
+               GetWorkerThreads,
+               "",
+               "Prints the number of PhysX worker threads")
+{
+    PrintString(ST::format("PhysX is using {} worker thread(s)",
+                           plPXSimulation::GetDefaultWorkerThreads()));
+}
+
+PF_CONSOLE_CMD(Physics,
+               BatchLOS,
+               "bool enable",
+               "Collect line of sight requests and cast them together instead of one at a time")
+{
+    plLOSDispatch::SetBatchRequests(params[0]);
+    PrintString(ST::format("Batched LOS requests {}",
+                           plLOSDispatch::GetBatchRequests() ? "enabled" : "disabled"));
+}
+
+PF_CONSOLE_CMD(Physics,
+               LOSStress,
+               "int numRays, float length",
+               "Fires a fan of line of sight requests around the local avatar, for timing the LOS dispatch")
+{
+    plArmatureMod* avMod = plAvatarMgr::GetInstance()->GetLocalAvatar();
+    const plSceneObject* avObj = avMod ? avMod->GetTarget(0) : nullptr;
+    if (!avObj) {
+        PrintString("No local avatar");
+        return;
+    }
+
+    int numRays = params[0];
+    float length = params[1];
+    hsPoint3 from = avObj->GetLocalToWorld().GetTranslate();
+    from.fZ += 5.f;
+
+    // Nobody is listening for the answers, so only the dispatch itself gets measured.
+    for (int i = 0; i < numRays; ++i) {
+        float yaw = hsConstants::two_pi<float> * i / numRays;
+        float pitch = hsConstants::half_pi<float> * ((i % 7) - 3) / 6.f;
+        hsPoint3 to = from + hsVector3(cosf(yaw) * cosf(pitch), sinf(yaw) * cosf(pitch), sinf(pitch)) * length;
+
+        plLOSRequestMsg* req = new plLOSRequestMsg(nullptr, from, to, plSimDefs::kLOSDBCameraBlockers,
+                                                   plLOSRequestMsg::kTestClosest, plLOSRequestMsg::kReportHitOrMiss);
+        req->SetRequestName(ST::format("LOSStress {}", i));
+        req->Send();
+    }
+    PrintString(ST::format("Sent {} LOS requests", numRays));
+}
+
 #endif // LIMIT_CONSOLE_COMMANDS
 
 
@@ -6073,6 +6352,60 @@ PF_CONSOLE_CMD( Python,
     PrintString(PythonInterface::getOutputAndReset());
 }
 
+PF_CONSOLE_CMD( Python,
+                ProfileScripts,
+                "bool on",
+                "Enables or disables timing of Python script handlers.\n"
+                "View the results with Stats.ShowLaps Python Scripts" )
+{
+    plPythonProfiler::Instance().SetEnabled((bool)params[0]);
+    PrintString(ST::format("Python script profiling {}", (bool)params[0] ? "enabled" : "disabled"));
+}
+
+PF_CONSOLE_CMD( Python,
+                ResetScriptProfile,
+                "",
+                "Clears the accumulated Python script handler timings" )
+{
+    plPythonProfiler::Instance().Reset();
+}
+
+PF_CONSOLE_CMD( Python,
+                DumpScriptProfile,
+                "...",
+                "Writes the Python script handler timings to a CSV file.\n"
+                "Optional: Specify the file name" )
+{
+    plFileName fileName;
+    if (numParams > 0)
+        fileName = static_cast<const plFileName&>(params[0]);
+    else
+        fileName = plFileName::Join(plProfileManagerFull::Instance().GetProfilePath(), "PythonScripts.csv");
+
+    if (plPythonProfiler::Instance().DumpCSV(fileName))
+        PrintString(ST::format("Python script profile written to {}", fileName));
+    else
+        PrintString(ST::format("Unable to write {}", fileName));
+}
+
+PF_CONSOLE_CMD( Python,
+                ListPackLoadTimes,
+                "...",
+                "Lists the time spent loading modules from the python.pak files, slowest first.\n"
+                "Optional: Specify the number of modules to list" )
+{
+    size_t count = numParams > 0 ? (int)params[0] : 20;
+    std::vector<PythonPack::LoadTime> times = PythonPack::GetLoadTimes();
+
+    double total = 0.0;
+    for (const PythonPack::LoadTime& time : times)
+        total += time.fMilliseconds;
+    PrintString(ST::format("{} modules loaded in {.2f} ms", times.size(), total));
+
+    for (size_t i = 0; i < std::min(count, times.size()); ++i)
+        PrintString(ST::format("  {.3f} ms  {} ({} bytes)", times[i].fMilliseconds, times[i].fName, times[i].fSize));
+}
+
 #endif // LIMIT_CONSOLE_COMMANDS
 
 
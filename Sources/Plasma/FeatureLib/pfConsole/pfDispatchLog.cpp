@@ -164,12 +164,8 @@ void plDispatchLog::AddFilterType(uint16_t hClass)
     if (hClass>=plFactory::GetNumClasses())
         return; 
 
-    int i;
-    for( i = 0; i < plFactory::GetNumClasses(); i++ )
-    {
-        if( plFactory::DerivesFrom(hClass, i) )
-            AddFilterExactType(i);
-    }
+    for (uint16_t derived : plFactory::GetDerivedClasses(hClass))
+        AddFilterExactType(derived);
 }
 
 void plDispatchLog::AddFilterExactType(uint16_t type)
@@ -183,12 +179,8 @@ void plDispatchLog::RemoveFilterType(uint16_t hClass)
     if (hClass>=plFactory::GetNumClasses())
         return; 
 
-    int i;
-    for( i = 0; i < plFactory::GetNumClasses(); i++ )
-    {
-        if( plFactory::DerivesFrom(hClass, i) )
-            RemoveFilterExactType(i);
-    }
+    for (uint16_t derived : plFactory::GetDerivedClasses(hClass))
+        RemoveFilterExactType(derived);
 }
 
 void plDispatchLog::RemoveFilterExactType(uint16_t type)
@@ -107,6 +107,7 @@ You can contact Cyan Worlds, Inc. by email legal@cyan.com
 #include "plDrawable/plSpanTypes.h"
 #include "plGImage/hsCodecManager.h"
 #include "plGImage/plCubicEnvironmap.h"
+#include "plGImage/plDynamicTextMap.h"
 #include "plGImage/plMipmap.h"
 #include "plGLight/plLightInfo.h"
 #include "plGLight/plShadowCaster.h"
@@ -7319,6 +7320,46 @@ void    plDXPipeline::IFillD3DTexture( plDXTextureRef *ref )
     }       
 }
 
+//// IFillD3DTextureRects /////////////////////////////////////////////////////
+// Copies just the regions a dynamic text map has drawn into since its last
+// upload into the existing D3D texture. Only the top level gets locked; if
+// the texture autogens its mips, D3D rebuilds them from that on its own.
+// Returns false if the texture can't take a partial update, in which case
+// the caller should do the full reload.
+bool    plDXPipeline::IFillD3DTextureRects( plDXTextureRef *ref, plDynamicTextMap *dtMap )
+{
+    if( ref->fFormatType != D3DFMT_A8R8G8B8 && ref->fFormatType != D3DFMT_X8R8G8B8 )
+        return false;
+
+    IDirect3DTexture9 *lpDst = (IDirect3DTexture9 *)ref->fD3DTexture;
+    const uint8_t *pTexDat = (const uint8_t *)dtMap->GetImage();
+
+    for( const plDynamicTextMap::DirtyRect &dirty : dtMap->GetDirtyRects() )
+    {
+        RECT rect = { dirty.fX, dirty.fY, dirty.fX + dirty.fWidth, dirty.fY + dirty.fHeight };
+        D3DLOCKED_RECT lockInfo;
+
+        fSettings.fDXError = lpDst->LockRect(0, &lockInfo, &rect, 0);
+        if (FAILED(fSettings.fDXError))
+        {
+            IGetD3DError();
+            return false;
+        }
+
+        const uint8_t *src = pTexDat + dirty.fY * dtMap->GetRowBytes() + dirty.fX * sizeof(uint32_t);
+        uint8_t *dst = (uint8_t *)lockInfo.pBits;
+        for( int y = 0; y < dirty.fHeight; y++ )
+        {
+            memcpy(dst, src, dirty.fWidth * sizeof(uint32_t));
+            src += dtMap->GetRowBytes();
+            dst += lockInfo.Pitch;
+        }
+        lpDst->UnlockRect( 0 );
+    }
+
+    return true;
+}
+
 //// IMakeD3DCubeTexture //////////////////////////////////////////////////////
 //  Makes a DX Cubic Texture object based on the ref given.
 
@@ -7369,6 +7410,23 @@ hsGDeviceRef    *plDXPipeline::MakeTextureRef( plLayerInterface* layer, plMipmap
 {
     plMipmap    *original = b, *colorized = nullptr;
 
+    // Dynamic text maps know what they've drawn into since their last upload,
+    // so if we still have a D3D texture of the right size, just patch that.
+    plDynamicTextMap *dtMap = plDynamicTextMap::ConvertNoRef(b);
+    if (dtMap != nullptr)
+    {
+        plDXTextureRef *oldRef = (plDXTextureRef *)b->GetDeviceRef();
+        if (oldRef != nullptr && oldRef->fD3DTexture != nullptr && dtMap->GetImage() != nullptr
+            && dtMap->HasDirtyRects() && !dtMap->IsFullyDirty() && !IsDebugFlagSet(plPipeDbg::kFlagColorizeMipmaps)
+            && oldRef->fMaxWidth == dtMap->GetWidth() && oldRef->fMaxHeight == dtMap->GetHeight()
+            && IFillD3DTextureRects( oldRef, dtMap ) )
+        {
+            dtMap->ClearDirtyRects();
+            oldRef->SetDirty( false );
+            return oldRef;
+        }
+    }
+
     // If the hardware doesn't support Luminance maps, we'll just treat as ARGB.
     if( !( fSettings.fD3DCaps & kCapsLuminanceTextures ) )
         b->SetFlags( b->GetFlags() & ~plMipmap::kIntensityMap );
@@ -7445,6 +7503,8 @@ hsGDeviceRef    *plDXPipeline::MakeTextureRef( plLayerInterface* layer, plMipmap
 
     ref->fData = nullptr;
     ref->SetDirty( false );
+    if (dtMap != nullptr)
+        dtMap->ClearDirtyRects( true );
 
     // Set any implied flags.
     if (layer)
@@ -72,6 +72,7 @@ class plDXVertexBufferRef;
 class plDXIndexBufferRef;
 class plDXTextureRef;
 class plDXCubeTextureRef;
+class plDynamicTextMap;
 class plDXVertexShader;
 class plDXPixelShader;
 
@@ -387,6 +388,7 @@ protected:
     hsGDeviceRef    *MakeTextureRef( plLayerInterface* layer, plMipmap *b );
     void            IReloadTexture( plDXTextureRef *ref );
     void            IFillD3DTexture( plDXTextureRef *ref );
+    bool            IFillD3DTextureRects( plDXTextureRef *ref, plDynamicTextMap *dtMap );
     void            IFillD3DCubeTexture( plDXCubeTextureRef *ref );
     void            IGetD3DTextureFormat( plBitmap *b, D3DFORMAT &formatType, uint32_t& texSize );
     void            IFormatTextureData( uint32_t formatType, uint32_t numPix, hsRGBAColor32* const src, void *dst );
@@ -101,6 +101,9 @@ You can contact Cyan Worlds, Inc. by email legal@cyan.com
 static bool s_ShowLinkRects = false;
 static hsColorRGBA s_LinkRectColor{ 0.f, 0.f, 1.f, 1.f };
 
+// How long an open book may spend each frame laying out pages ahead of the reader
+static constexpr double kPaginateBudget = 0.002;
+
 //////////////////////////////////////////////////////////////////////////////
 //// pfEsHTMLChunk Class /////////////////////////////////////////////////////
 //////////////////////////////////////////////////////////////////////////////
@@ -152,6 +155,11 @@ class pfEsHTMLChunk
         bool    fOnCover; // if true, the movie is on the cover
         uint8_t   fMovieIndex; // the index of the movie in the source code, used for identification
 
+        // Where this chunk came from in the compiled source, which doesn't change
+        // when pagination splits a paragraph across pages (see pfJournalPageCache)
+        uint32_t  fSourceIdx;
+        uint32_t  fSourceOffset;
+
         enum Flags
         {
             kFontBold   = 0x00000001,
@@ -185,7 +193,8 @@ class pfEsHTMLChunk
               fFontSize(), fImageKey(), fEventID(), fSFXTime(),
               fAbsoluteX(), fAbsoluteY(), fNoResizeImg(), fLineSpacing(),
               fCurrOpacity(1.f), fMinOpacity(), fMaxOpacity(1.f),
-              fTintDecal(), fLoopMovie(true), fOnCover(), fMovieIndex(-1)
+              fTintDecal(), fLoopMovie(true), fOnCover(), fMovieIndex(-1),
+              fSourceIdx(), fSourceOffset()
 
         {
             fColor.Set(0.f, 0.f, 0.f, 1.f);
@@ -200,7 +209,8 @@ class pfEsHTMLChunk
               fFontSize(), fImageKey(std::move(imageKey)), fEventID(), fSFXTime(),
               fAbsoluteX(), fAbsoluteY(), fNoResizeImg(), fLineSpacing(),
               fCurrOpacity(1.f), fMinOpacity(), fMaxOpacity(1.f),
-              fTintDecal(), fLoopMovie(true), fOnCover(), fMovieIndex(-1)
+              fTintDecal(), fLoopMovie(true), fOnCover(), fMovieIndex(-1),
+              fSourceIdx(), fSourceOffset()
         {
             fColor.Set(0.f, 0.f, 0.f, 1.f);
             fCurrColor.Set(0.f, 0.f, 0.f, 1.f);
@@ -214,7 +224,8 @@ class pfEsHTMLChunk
               fFontSize(), fImageKey(), fEventID(), fSFXTime(),
               fAbsoluteX(), fAbsoluteY(), fNoResizeImg(), fLineSpacing(),
               fCurrOpacity(1.f), fMinOpacity(), fMaxOpacity(1.f),
-              fTintDecal(), fLoopMovie(true), fOnCover(), fMovieIndex(-1)
+              fTintDecal(), fLoopMovie(true), fOnCover(), fMovieIndex(-1),
+              fSourceIdx(), fSourceOffset()
         {
             fColor.Set(0.f, 0.f, 0.f, 1.f);
             fCurrColor.Set(0.f, 0.f, 0.f, 1.f);
@@ -228,7 +239,8 @@ class pfEsHTMLChunk
               fFontSize(size), fImageKey(), fEventID(), fSFXTime(),
               fAbsoluteX(), fAbsoluteY(), fNoResizeImg(), fLineSpacing(),
               fCurrOpacity(1.f), fMinOpacity(), fMaxOpacity(1.f),
-              fTintDecal(), fLoopMovie(true), fOnCover(), fMovieIndex(-1)
+              fTintDecal(), fLoopMovie(true), fOnCover(), fMovieIndex(-1),
+              fSourceIdx(), fSourceOffset()
         {
             fColor.Set(0.f, 0.f, 0.f, 1.f);
             fCurrColor.Set(0.f, 0.f, 0.f, 1.f);
@@ -242,7 +254,8 @@ class pfEsHTMLChunk
               fFontSize(), fImageKey(), fEventID(), fSFXTime(),
               fAbsoluteX(), fAbsoluteY(), fNoResizeImg(), fLineSpacing(),
               fCurrOpacity(1.f), fMinOpacity(), fMaxOpacity(1.f),
-              fTintDecal(), fLoopMovie(true), fOnCover(), fMovieIndex(-1)
+              fTintDecal(), fLoopMovie(true), fOnCover(), fMovieIndex(-1),
+              fSourceIdx(), fSourceOffset()
         {
             fColor.Set(0.f, 0.f, 1.f, 1.f);
             fCurrColor.Set(0.f, 0.f, 0.f, 1.f);
@@ -576,10 +589,15 @@ bool pfBookData::MsgReceive(plMessage *pMsg)
     }
 
     plTimeMsg *time = plTimeMsg::ConvertNoRef( pMsg );
-    if (time != nullptr && fCurrSFXPages != kNoSides && !fCurrentlyTurning && fCurrentlyOpen)
+    if (time != nullptr && (fCurrSFXPages != kNoSides || fPaginating) && !fCurrentlyTurning)
     {
-        IHandleSFX( (float)time->DSeconds() );
-        return true;        
+        if (fCurrSFXPages != kNoSides && fCurrentlyOpen)
+            IHandleSFX( (float)time->DSeconds() );
+
+        // Lay out a few more pages while the reader is busy reading this one
+        if (fPaginating && (fCurrBook == nullptr || !fCurrBook->IPaginateAhead(kPaginateBudget)))
+            RegisterForPagination(false);
+        return true;
     }
 
     plTimerCallbackMsg* timerMsg = plTimerCallbackMsg::ConvertNoRef(pMsg);
@@ -716,14 +734,32 @@ void pfBookData::RegisterForSFX(WhichSide whichPages)
     if( whichPages == fCurrSFXPages)
         return;
 
-    if(whichPages != kNoSides)
-    {
+    bool wasRegistered = fCurrSFXPages != kNoSides || fPaginating;
+    fCurrSFXPages = whichPages;
+    IUpdateTimeRegistration(wasRegistered);
+}
+
+//// RegisterForPagination ///////////////////////////////////////////////////
+// Registers (or unregisters) for time messages so the current book can lay
+// out its remaining pages a little at a time
+
+void pfBookData::RegisterForPagination(bool paginate)
+{
+    if (paginate == fPaginating)
+        return;
+
+    bool wasRegistered = fCurrSFXPages != kNoSides || fPaginating;
+    fPaginating = paginate;
+    IUpdateTimeRegistration(wasRegistered);
+}
+
+void pfBookData::IUpdateTimeRegistration(bool wasRegistered)
+{
+    bool wantRegistered = fCurrSFXPages != kNoSides || fPaginating;
+    if (wantRegistered && !wasRegistered)
         plgDispatch::Dispatch()->RegisterForExactType(plTimeMsg::Index(), GetKey());
-    }
-    else
+    else if (!wantRegistered && wasRegistered)
         plgDispatch::Dispatch()->UnRegisterForExactType(plTimeMsg::Index(), GetKey());
-    
-    fCurrSFXPages = whichPages;
 }
 
 //// IHandleSFX //////////////////////////////////////////////////////////////
@@ -1011,6 +1047,7 @@ void pfBookData::IFinishTriggeredFlip(bool wasBackwards)
         if ( turnFront->IsValid() && right->IsValid() )
         {
             memcpy(right->GetImage(), turnFront->GetImage(), right->GetLevelSize(0));
+            right->MarkFullyDirty();
             if (right->GetDeviceRef() != nullptr)
                 right->GetDeviceRef()->SetDirty(true);
         }
@@ -1033,6 +1070,7 @@ void pfBookData::IFinishTriggeredFlip(bool wasBackwards)
         if ( turnBack->IsValid() && left->IsValid() )
         {
             memcpy(left->GetImage(), turnBack->GetImage(), left->GetLevelSize(0));
+            left->MarkFullyDirty();
             if (left->GetDeviceRef() != nullptr)
                 left->GetDeviceRef()->SetDirty(true);
         }
@@ -1246,6 +1284,8 @@ pfJournalBook::pfJournalBook(ST::string esHTMLSource, plKey coverImageKey, plKey
     fTintCover = false;
     fAreEditing = false;
     fWantEditing = false;
+    fPageCacheChecked = false;
+    fCanCachePages = false;
     fDefLoc = hintLoc;
     fUncompiledSource = std::move(esHTMLSource);
 
@@ -1352,6 +1392,7 @@ void    pfJournalBook::IFinishShow( bool startOpened )
         IRenderPage( 1, pfJournalDlgProc::kTagRightDTMap );
 
         fBookGUIs[fCurBookGUI]->UpdatePageCorners( pfBookData::kBothSides );
+        fBookGUIs[fCurBookGUI]->RegisterForPagination( true );
     }
 
     ISendNotify( kNotifyShow );
@@ -1369,6 +1410,8 @@ void    pfJournalBook::Hide()
             if (fBookGUIs[fCurBookGUI]->Dialog())
                 fBookGUIs[fCurBookGUI]->Dialog()->Hide();
             fBookGUIs[fCurBookGUI]->CurBook(nullptr);
+            fBookGUIs[fCurBookGUI]->RegisterForPagination(false);
+            IStorePageStarts();
             ISendNotify( kNotifyHide );
             ILoadAllImages( true );
             // purge the dynaTextMaps, we're done with them for now
@@ -1408,6 +1451,7 @@ void    pfJournalBook::Open( uint32_t startingPage /*= 0 */)
         IRenderPage( startingPage + 1, pfJournalDlgProc::kTagRightDTMap );
 
         fBookGUIs[fCurBookGUI]->UpdatePageCorners( pfBookData::kBothSides );
+        fBookGUIs[fCurBookGUI]->RegisterForPagination( true );
     }
 }
 
@@ -1530,6 +1574,7 @@ void    pfJournalBook::NextPage()
         if ( turnFront->IsValid() && right->IsValid() )
         {
             memcpy( turnFront->GetImage(), right->GetImage(), right->GetLevelSize( 0 ) );
+            turnFront->MarkFullyDirty();
             if (turnFront->GetDeviceRef() != nullptr)
                 turnFront->GetDeviceRef()->SetDirty( true );
         }
@@ -1598,6 +1643,7 @@ void    pfJournalBook::PreviousPage()
         if ( turnBack->IsValid() && left->IsValid() )
         {
             memcpy( turnBack->GetImage(), left->GetImage(), left->GetLevelSize( 0 ) );
+            turnBack->MarkFullyDirty();
             if (turnBack->GetDeviceRef() != nullptr)
                 turnBack->GetDeviceRef()->SetDirty( true );
         }
@@ -1761,6 +1807,7 @@ void    pfJournalBook::IFlipToAnchor(const ST::string& anchor)
         plDynamicTextMap* left = fBookGUIs[fCurBookGUI]->GetDTMap(pfJournalDlgProc::kTagLeftDTMap);
         if (turnBack->IsValid() && left->IsValid()) {
             memcpy(turnBack->GetImage(), left->GetImage(), left->GetLevelSize(0));
+            turnBack->MarkFullyDirty();
             if (turnBack->GetDeviceRef() != nullptr)
                 turnBack->GetDeviceRef()->SetDirty(true);
         }
@@ -1788,6 +1835,7 @@ void    pfJournalBook::IFlipToAnchor(const ST::string& anchor)
         plDynamicTextMap* right = fBookGUIs[fCurBookGUI]->GetDTMap(pfJournalDlgProc::kTagRightDTMap);
         if (turnFront->IsValid() && right->IsValid()) {
             memcpy(turnFront->GetImage(), right->GetImage(), right->GetLevelSize(0));
+            turnFront->MarkFullyDirty();
             if (turnFront->GetDeviceRef() != nullptr)
                 turnFront->GetDeviceRef()->SetDirty(true);
         }
@@ -1873,6 +1921,22 @@ void    pfJournalBook::ForceCacheCalculations()
     IRecalcPageStarts( -1 );
 }
 
+//// IHashChunk //////////////////////////////////////////////////////////////
+// Hashes everything about a compiled chunk that can move text around on a page
+
+static size_t IHashChunk(const pfEsHTMLChunk* chunk)
+{
+    size_t hash = ST::hash()(chunk->fText);
+    hash = pfJournalPageCache::ChainHash(hash, chunk->fType);
+    hash = pfJournalPageCache::ChainHash(hash, chunk->fFlags);
+    hash = pfJournalPageCache::ChainHash(hash, chunk->fFontSize);
+    hash = pfJournalPageCache::ChainHash(hash, (chunk->fAbsoluteX << 16) | chunk->fAbsoluteY);
+    hash = pfJournalPageCache::ChainHash(hash, (uint16_t)chunk->fLineSpacing);
+    if (chunk->fImageKey != nullptr)
+        hash = pfJournalPageCache::ChainHash(hash, ST::hash()(chunk->fImageKey->GetName()));
+    return hash;
+}
+
 //// ICompileSource //////////////////////////////////////////////////////////
 // Compiles the given string of esHTML source into our compiled chunk list
 
@@ -2330,8 +2394,19 @@ bool    pfJournalBook::ICompileSource(const ST::string& source, const plLocation
         fHTMLSource.emplace_back(lastParChunk);
     }
 
+    // Fingerprint what we compiled, so we can find this book's pages again
+    fChunkHashes.clear();
+    fChunkHashes.reserve(fHTMLSource.size());
+    size_t chain = 0;
+    for (size_t i = 0; i < fHTMLSource.size(); i++) {
+        fHTMLSource[i]->fSourceIdx = (uint32_t)i;
+        chain = pfJournalPageCache::ChainHash(chain, IHashChunk(fHTMLSource[i]));
+        fChunkHashes.emplace_back(chain);
+    }
+
     // Reset a few
     fPageStarts = {0};
+    fPageCacheChecked = false;
     if (fAreEditing)
         fLastPage = 0;
     else
@@ -2440,6 +2515,9 @@ bool    pfJournalBook::IGetNextOption( const char *&string, const char *end, ST:
 
 void    pfJournalBook::IFreeSource()
 {
+    IStorePageStarts();
+    fCanCachePages = false;
+
     for (pfEsHTMLChunk* chunk : fHTMLSource)
         delete chunk;
     fHTMLSource.clear();
@@ -2698,12 +2776,7 @@ void    pfJournalBook::IRenderPage( uint32_t page, uint32_t whichDTMap, bool sup
                         // this changes the chunk array beyond this point, so we need to invalidate the
                         // cache, but that's ok 'cause if we're doing this, it's probably invalid (or empty)
                         // anyway
-                        pfEsHTMLChunk *c2 = new pfEsHTMLChunk(chunk->fText.substr(lastChar));
-                        c2->fFlags = chunk->fFlags;
-                        fHTMLSource.emplace(fHTMLSource.begin() + idx + 1, c2);
-
-                        // Clip and reallocate so we don't have two copies laying around
-                        chunk->fText = chunk->fText.left(lastChar);
+                        ISplitParagraph(idx, lastChar);
 
                         // Invalidate our cache starting with the next page
                         if (fPageStarts.size() > page + 1)
@@ -3481,6 +3554,10 @@ uint8_t   pfJournalBook::IFindLastAlignment() const
 
 void    pfJournalBook::IRecalcPageStarts( uint32_t upToPage )
 {
+    // Somebody may have laid this book out before us
+    if (!fPageCacheChecked)
+        IRestorePageStarts();
+
     // Well, sadly, we can't really calc the page starts without at least a DTMap
     // we can change things on...so we just pick one and render. Note: this WILL
     // trash the font settings on the given DTMap!
@@ -3500,6 +3577,148 @@ void    pfJournalBook::IRecalcPageStarts( uint32_t upToPage )
     }
 }
 
+//// IPaginateAhead ////////////////////////////////////////////////////////
+// Lays out pages past the ones we've already seen until the time budget runs
+// out, so flipping (or jumping) ahead later doesn't have to. Returns false
+// once there's nothing left to do.
+
+bool    pfJournalBook::IPaginateAhead( double budgetSecs )
+{
+    if (fAreEditing || !fAreWeShowing || fBookGUIs[fCurBookGUI]->CurBook() != this)
+        return false;
+
+    // Same as IRecalcPageStarts, except the links we find are kept off the
+    // list rather than just emptied, since the reader is clicking on the
+    // visible pages' links while we work
+    size_t numLinks = fVisibleLinks.size();
+    double stopAt = hsTimer::GetSeconds() + budgetSecs;
+    do {
+        uint32_t page = (uint32_t)fPageStarts.size() - 1;
+        if (page > fLastPage)
+            break;
+        IRenderPage( page, pfJournalDlgProc::kTagTurnBackDTMap, false );
+    } while (hsTimer::GetSeconds() < stopAt);
+    fVisibleLinks.erase(fVisibleLinks.begin() + numLinks, fVisibleLinks.end());
+
+    if (fPageStarts.size() - 1 <= fLastPage)
+        return true;
+
+    // Done; remember the whole book
+    IStorePageStarts();
+    return false;
+}
+
+//// ISplitParagraph /////////////////////////////////////////////////////////
+// Splits a paragraph chunk in two at the given character, for when it runs
+// off the end of a page
+
+void    pfJournalBook::ISplitParagraph( uint32_t idx, uint32_t lastChar )
+{
+    pfEsHTMLChunk *chunk = fHTMLSource[ idx ];
+    pfEsHTMLChunk *c2 = new pfEsHTMLChunk(chunk->fText.substr(lastChar));
+    c2->fFlags = chunk->fFlags;
+    c2->fSourceIdx = chunk->fSourceIdx;
+    c2->fSourceOffset = chunk->fSourceOffset + lastChar;
+    fHTMLSource.emplace(fHTMLSource.begin() + idx + 1, c2);
+
+    // Clip and reallocate so we don't have two copies laying around
+    chunk->fText = chunk->fText.left(lastChar);
+}
+
+//// IGetPageCacheContext ////////////////////////////////////////////////////
+
+bool    pfJournalBook::IGetPageCacheContext( pfJournalPageCache::Context &context )
+{
+    auto it = fBookGUIs.find(fCurBookGUI);
+    if (it == fBookGUIs.end() || it->second == nullptr)
+        return false;
+
+    plDynamicTextMap *dtMap = it->second->GetDTMap( pfJournalDlgProc::kTagTurnBackDTMap );
+    if (dtMap == nullptr)
+        return false;
+
+    context.fGUIName = fCurBookGUI;
+    context.fTMargin = fPageTMargin;
+    context.fLMargin = fPageLMargin;
+    context.fBMargin = fPageBMargin;
+    context.fRMargin = fPageRMargin;
+    context.fWidth = (uint16_t)dtMap->GetWidth();
+    context.fHeight = (uint16_t)dtMap->GetHeight();
+    return true;
+}
+
+//// IRestorePageStarts //////////////////////////////////////////////////////
+// Picks up whatever page starts pfJournalPageCache still has for this book,
+// the first time we need any. This is done lazily rather than at compile time
+// since the margins and GUI are usually set after the book is created.
+
+void    pfJournalBook::IRestorePageStarts()
+{
+    fPageCacheChecked = true;
+    fCanCachePages = !fAreEditing && !fHTMLSource.empty() && IGetPageCacheContext(fPageCacheContext);
+    if (!fCanCachePages || fPageStarts.size() > 1)
+        return;
+
+    std::vector<pfJournalPageCache::Position> starts = pfJournalPageCache::Find(fPageCacheContext, fChunkHashes);
+    if (starts.size() <= 1)
+        return;
+
+    // Redo the paragraph splits that made those pages, so the starts land on
+    // the same chunks IRenderPage would have given us
+    fPageStarts.clear();
+    uint32_t splits = 0;
+    for (const pfJournalPageCache::Position& pos : starts)
+    {
+        uint32_t idx = pos.fChunk + splits;
+        if (pos.fOffset > 0)
+        {
+            pfEsHTMLChunk *chunk = idx < fHTMLSource.size() ? fHTMLSource[ idx ] : nullptr;
+            if (chunk == nullptr || chunk->fType != pfEsHTMLChunk::kParagraph || chunk->fSourceIdx != pos.fChunk ||
+                pos.fOffset <= chunk->fSourceOffset || pos.fOffset - chunk->fSourceOffset >= chunk->fText.size())
+            {
+                // Not the book we thought it was; lay out the rest ourselves
+                hsAssert(false, "Cached page start doesn't fit the book");
+                break;
+            }
+            ISplitParagraph(idx, pos.fOffset - chunk->fSourceOffset);
+            idx++;
+            splits++;
+        }
+        fPageStarts.emplace_back(idx);
+    }
+
+    if (fPageStarts.size() == starts.size() && starts.back().fChunk == fChunkHashes.size())
+        fLastPage = (uint32_t)fPageStarts.size() - 2;
+}
+
+//// IStorePageStarts ////////////////////////////////////////////////////////
+// Hands the page starts we know about to pfJournalPageCache
+
+void    pfJournalBook::IStorePageStarts()
+{
+    if (!fCanCachePages || fAreEditing || fPageStarts.size() <= 1)
+        return;
+
+    pfJournalPageCache::Store(fPageCacheContext, fChunkHashes, IGetPageStartPositions());
+}
+
+//// IGetPageStartPositions //////////////////////////////////////////////////
+// Where each page we know about starts, in terms of the source as compiled
+
+std::vector<pfJournalPageCache::Position> pfJournalBook::IGetPageStartPositions() const
+{
+    std::vector<pfJournalPageCache::Position> starts;
+    starts.reserve(fPageStarts.size());
+    for (uint32_t idx : fPageStarts)
+    {
+        if (idx < fHTMLSource.size())
+            starts.push_back({ fHTMLSource[ idx ]->fSourceIdx, fHTMLSource[ idx ]->fSourceOffset });
+        else
+            starts.push_back({ (uint32_t)fChunkHashes.size(), 0 });
+    }
+    return starts;
+}
+
 //// ISendNotify /////////////////////////////////////////////////////////////
 // Just sends out a notify to our currently set receiver key
 
@@ -192,6 +192,8 @@ You can contact Cyan Worlds, Inc. by email legal@cyan.com
 #include "pnKeyedObject/hsKeyedObject.h"
 #include "pnKeyedObject/plUoid.h"
 
+#include "pfJournalPageCache.h"
+
 
 
 class pfEsHTMLChunk;
@@ -240,9 +242,10 @@ public:
         fDefaultCover(), fCurrentlyOpen(), fStartedOpen(),
         fResetSFXFlag(), fSFXUpdateFlip(), fCurrentlyTurning(), fEditable(),
         fCurrSFXPages(kNoSides), fBaseSFXTime(), fAdjustCursorTo(-1), fPageMaterials(),
+        fPaginating(),
         fGUIName(!guiName.empty() ? guiName : ST_LITERAL("BkBook"))
     { }
-    virtual ~pfBookData() { RegisterForSFX(kNoSides); }
+    virtual ~pfBookData() { RegisterForSFX(kNoSides); RegisterForPagination(false); }
 
     void LoadGUI(); // need this seperate because the plKey isn't setup until the constructor is done
 
@@ -299,6 +302,9 @@ public:
     // Registers (or unregisters) for time messages so we can process special FX if we need to
     void RegisterForSFX(WhichSide whichSides);
 
+    // Same, for laying out the current book's later pages in the background
+    void RegisterForPagination(bool paginate);
+
     void HitEndOfControlList(int32_t cursorPos);
     void HitBeginningOfControlList(int32_t cursorPos);
 
@@ -357,12 +363,18 @@ protected:
     bool        fEditable;
     int32_t       fAdjustCursorTo;
 
+    // Is the current book still finding its page starts?
+    bool        fPaginating;
+
     // Inits our dialog template
     void IInitTemplate(pfGUIDialogMod *templateDlg);
 
     // Process SFX for this frame
     void IHandleSFX(float currTime, WhichSide whichSide = kNoSides);
 
+    // (Un)registers for time messages if SFX or pagination changed our mind
+    void IUpdateTimeRegistration(bool wasRegistered);
+
     // Yet another step in the page flip, to make SURE we're already showing the turning page before we fill in the page behind it
     void IFillUncoveringPage(bool rightSide);
 
@@ -479,7 +491,7 @@ class pfJournalBook : public hsKeyedObject
 
         void    SetEditableText(const ST::string& text);
 
-    private:
+    protected:
 
         struct loadedMovie
         {
@@ -511,6 +523,13 @@ class pfJournalBook : public hsKeyedObject
         // the book, so that going backwards can be done efficiently.
         std::vector<uint32_t> fPageStarts;
 
+        // Running hash of the compiled chunks, for finding our page starts in
+        // pfJournalPageCache if this book was laid out before
+        std::vector<size_t> fChunkHashes;
+        pfJournalPageCache::Context fPageCacheContext;
+        bool    fPageCacheChecked;
+        bool    fCanCachePages;
+
         // is the book done showing and ready for more page calculations
         bool    fAreWeShowing;
 
@@ -600,6 +619,18 @@ class pfJournalBook : public hsKeyedObject
         // Ensures that all the page starts are calced up to the given page (but not including it)
         void    IRecalcPageStarts( uint32_t upToPage );
 
+        // Calcs page starts past what we know for up to the given time. Returns true if there's more to do
+        bool    IPaginateAhead( double budgetSecs );
+
+        // Splits the given paragraph chunk at the given character
+        void    ISplitParagraph( uint32_t idx, uint32_t lastChar );
+
+        // Page start caching across books with the same source
+        bool    IGetPageCacheContext( pfJournalPageCache::Context &context );
+        void    IRestorePageStarts();
+        void    IStorePageStarts();
+        std::vector<pfJournalPageCache::Position> IGetPageStartPositions() const;
+
         // Load (or unload) all the images for the book
         void    ILoadAllImages( bool unload );
         
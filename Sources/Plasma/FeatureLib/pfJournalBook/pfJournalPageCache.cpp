@@ -0,0 +1,147 @@
+/*==LICENSE==*
+
+CyanWorlds.com Engine - MMOG client, server and tools
+Copyright (C) 2011  Cyan Worlds, Inc.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+Additional permissions under GNU GPL version 3 section 7
+
+If you modify this Program, or any covered work, by linking or
+combining it with any of RAD Game Tools Bink SDK, Autodesk 3ds Max SDK,
+NVIDIA PhysX SDK, Microsoft DirectX SDK, OpenSSL library, Independent
+JPEG Group JPEG library, Microsoft Windows Media SDK, or Apple QuickTime SDK
+(or a modified version of those libraries),
+containing parts covered by the terms of the Bink SDK EULA, 3ds Max EULA,
+PhysX SDK EULA, DirectX SDK EULA, OpenSSL and SSLeay licenses, IJG
+JPEG Library README, Windows Media SDK EULA, or QuickTime SDK EULA, the
+licensors of this Program grant you additional
+permission to convey the resulting work. Corresponding Source for a
+non-source form of such a combination shall include the source code for
+the parts of OpenSSL and IJG JPEG Library used as well as that of the covered
+work.
+
+You can contact Cyan Worlds, Inc. by email legal@cyan.com
+ or by snail mail at:
+      Cyan Worlds, Inc.
+      14617 N Newport Hwy
+      Mead, WA   99021
+
+*==LICENSE==*/
+
+#include "pfJournalPageCache.h"
+
+#include <algorithm>
+#include <list>
+
+// Books shown in one session are few; a handful covers reopening the same
+// ones over and over without hanging on to every book ever read.
+static constexpr size_t kMaxLayouts = 8;
+
+namespace
+{
+    struct CachedLayout
+    {
+        pfJournalPageCache::Context                 fContext;
+        std::vector<size_t>                         fChunkHashes;
+        std::vector<pfJournalPageCache::Position>   fPageStarts;
+    };
+}
+
+// Most recently used first
+static std::list<CachedLayout> s_layouts;
+
+// Number of leading chunks two books have in common. Since each hash covers
+// all of the chunks before it, the matching entries are always a prefix.
+static size_t ICommonChunks(const std::vector<size_t>& a, const std::vector<size_t>& b)
+{
+    size_t lo = 0, hi = std::min(a.size(), b.size());
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo + 1) / 2;
+        if (a[mid - 1] == b[mid - 1])
+            lo = mid;
+        else
+            hi = mid - 1;
+    }
+    return lo;
+}
+
+size_t pfJournalPageCache::ChainHash(size_t prev, size_t chunkHash)
+{
+    return prev ^ (chunkHash + 0x9e3779b9 + (prev << 6) + (prev >> 2));
+}
+
+void pfJournalPageCache::Store(const Context& context, std::vector<size_t> chunkHashes, std::vector<Position> pageStarts)
+{
+    if (pageStarts.size() <= 1)
+        return;
+
+    for (auto it = s_layouts.begin(); it != s_layouts.end(); ++it) {
+        if (it->fContext != context || it->fChunkHashes.size() != chunkHashes.size())
+            continue;
+        if (ICommonChunks(it->fChunkHashes, chunkHashes) != chunkHashes.size())
+            continue;
+
+        // Same book; keep whichever of us got further
+        if (it->fPageStarts.size() > pageStarts.size())
+            pageStarts = std::move(it->fPageStarts);
+        s_layouts.erase(it);
+        break;
+    }
+
+    s_layouts.push_front({ context, std::move(chunkHashes), std::move(pageStarts) });
+    if (s_layouts.size() > kMaxLayouts)
+        s_layouts.pop_back();
+}
+
+std::vector<pfJournalPageCache::Position> pfJournalPageCache::Find(const Context& context, const std::vector<size_t>& chunkHashes)
+{
+    auto best = s_layouts.end();
+    size_t bestCount = 0;
+
+    for (auto it = s_layouts.begin(); it != s_layouts.end(); ++it) {
+        if (it->fContext != context)
+            continue;
+
+        // A page start depends on every chunk up to and including the one it
+        // lands in (that's the chunk that didn't fit), so it only holds if all
+        // of those are unchanged. The end of the book needs all of them.
+        size_t common = ICommonChunks(it->fChunkHashes, chunkHashes);
+        bool wholeBook = common == chunkHashes.size() && common == it->fChunkHashes.size();
+        size_t count = 0;
+        while (count < it->fPageStarts.size() && (wholeBook || it->fPageStarts[count].fChunk < common))
+            count++;
+
+        if (count > bestCount) {
+            best = it;
+            bestCount = count;
+        }
+    }
+
+    if (best == s_layouts.end())
+        return { { 0, 0 } };
+
+    s_layouts.splice(s_layouts.begin(), s_layouts, best);
+    return std::vector<Position>(best->fPageStarts.begin(), best->fPageStarts.begin() + bestCount);
+}
+
+size_t pfJournalPageCache::GetNumLayouts()
+{
+    return s_layouts.size();
+}
+
+void pfJournalPageCache::Clear()
+{
+    s_layouts.clear();
+}
@@ -0,0 +1,113 @@
+/*==LICENSE==*
+
+CyanWorlds.com Engine - MMOG client, server and tools
+Copyright (C) 2011  Cyan Worlds, Inc.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+Additional permissions under GNU GPL version 3 section 7
+
+If you modify this Program, or any covered work, by linking or
+combining it with any of RAD Game Tools Bink SDK, Autodesk 3ds Max SDK,
+NVIDIA PhysX SDK, Microsoft DirectX SDK, OpenSSL library, Independent
+JPEG Group JPEG library, Microsoft Windows Media SDK, or Apple QuickTime SDK
+(or a modified version of those libraries),
+containing parts covered by the terms of the Bink SDK EULA, 3ds Max EULA,
+PhysX SDK EULA, DirectX SDK EULA, OpenSSL and SSLeay licenses, IJG
+JPEG Library README, Windows Media SDK EULA, or QuickTime SDK EULA, the
+licensors of this Program grant you additional
+permission to convey the resulting work. Corresponding Source for a
+non-source form of such a combination shall include the source code for
+the parts of OpenSSL and IJG JPEG Library used as well as that of the covered
+work.
+
+You can contact Cyan Worlds, Inc. by email legal@cyan.com
+ or by snail mail at:
+      Cyan Worlds, Inc.
+      14617 N Newport Hwy
+      Mead, WA   99021
+
+*==LICENSE==*/
+
+#ifndef _pfJournalPageCache_h
+#define _pfJournalPageCache_h
+
+#include "HeadSpin.h"
+
+#include <string_theory/string>
+#include <vector>
+
+//////////////////////////////////////////////////////////////////////////////
+//                                                                          //
+//  pfJournalPageCache                                                      //
+//  Remembers where the pages of a book start, so opening the same book     //
+//  again (or a book that only grew at the end, like a player's journal)    //
+//  doesn't have to lay out every page in between on the main thread.       //
+//                                                                          //
+//  Books are identified by a running hash over their compiled chunks, and  //
+//  page starts are stored as (compiled chunk, offset into its text) so     //
+//  they survive the paragraph splitting pagination does to the live book.  //
+//                                                                          //
+//////////////////////////////////////////////////////////////////////////////
+
+class pfJournalPageCache
+{
+public:
+    // Everything besides the source that changes where text wraps
+    struct Context
+    {
+        ST::string  fGUIName;
+        uint32_t    fTMargin, fLMargin, fBMargin, fRMargin;
+        uint16_t    fWidth, fHeight;
+
+        Context()
+            : fTMargin(), fLMargin(), fBMargin(), fRMargin(), fWidth(), fHeight()
+        { }
+
+        bool operator==(const Context& other) const
+        {
+            return fGUIName == other.fGUIName &&
+                   fTMargin == other.fTMargin && fLMargin == other.fLMargin &&
+                   fBMargin == other.fBMargin && fRMargin == other.fRMargin &&
+                   fWidth == other.fWidth && fHeight == other.fHeight;
+        }
+        bool operator!=(const Context& other) const { return !operator==(other); }
+    };
+
+    struct Position
+    {
+        uint32_t    fChunk;     // Index of the chunk as compiled, before any splitting
+        uint32_t    fOffset;    // Where in that chunk's text the page starts
+
+        bool operator==(const Position& other) const { return fChunk == other.fChunk && fOffset == other.fOffset; }
+    };
+
+    // Folds one compiled chunk into a running hash; the chain for chunk N
+    // therefore identifies chunks 0 through N
+    static size_t ChainHash(size_t prev, size_t chunkHash);
+
+    // Stores the page starts of a laid out book. The last position may be
+    // (numChunks, 0), which means the book was paginated to the end.
+    static void Store(const Context& context, std::vector<size_t> chunkHashes, std::vector<Position> pageStarts);
+
+    // Returns the page starts still valid for the given book, which is
+    // everything up to the first changed chunk of the closest cached book.
+    // Always returns at least the first page.
+    static std::vector<Position> Find(const Context& context, const std::vector<size_t>& chunkHashes);
+
+    static size_t GetNumLayouts();
+    static void Clear();
+};
+
+#endif //_pfJournalPageCache_h
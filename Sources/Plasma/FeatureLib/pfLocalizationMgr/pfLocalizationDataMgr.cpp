@@ -47,6 +47,9 @@ You can contact Cyan Worlds, Inc. by email legal@cyan.com
 //////////////////////////////////////////////////////////////////////
 
 #include "HeadSpin.h"
+#include "hsStream.h"
+
+#include "pnEncryption/plChecksum.h"
 
 #include "plFile/plEncryptedStream.h"
 #include "plResMgr/plLocalization.h"
@@ -782,14 +785,21 @@ std::vector<ST::string> pfLocalizationDataMgr::pf3PartMap<mapT>::getNameList(con
 pfLocalizationDataMgr   *pfLocalizationDataMgr::fInstance = nullptr;
 plStatusLog             *pfLocalizationDataMgr::fLog = nullptr; // output logfile
 
+/** Bump this whenever the cache layout or pfLocalizedString::Write() changes */
+constexpr uint32_t kLocCacheVersion = 2;
+
+/** Header of the localization cache, followed by the version, fingerprint, payload size and payload checksum */
+constexpr char kLocCacheMagic[4] = { 'P', 'L', 'O', 'C' };
+
 //// Constructor/Destructor //////////////////////////////////////////
 
-pfLocalizationDataMgr::pfLocalizationDataMgr(const plFileName & path)
+pfLocalizationDataMgr::pfLocalizationDataMgr(const plFileName & path, const plFileName & cachePath)
 {
     hsAssert(!fInstance, "Tried to create the localization data manager more than once!");
     fInstance = this;
 
     fDataPath = path;
+    fCachePath = cachePath;
 
     fDatabase = nullptr;
 }
@@ -829,7 +839,7 @@ void pfLocalizationDataMgr::IConvertElement(const pfLocalizationDataMgr::element
             fLog->AddLineF("WARNING: Argument number mismatch in element {} for {}", curPath, curTranslation.first);
     }
 
-    fLocalizedElements[curPath] = newElement;
+    fLocalizedElements[curPath] = std::move(newElement);
 }
 
 //// IConvertSet /////////////////////////////////////////////////////
@@ -908,14 +918,193 @@ void pfLocalizationDataMgr::IWriteText(const plFileName & filename, const ST::st
     }
 }
 
+//// IIndexElements //////////////////////////////////////////////////
+
+void pfLocalizationDataMgr::IIndexElements()
+{
+    fElementIndex.clear();
+    for (const auto& ageName : GetAgeList())
+    {
+        for (const auto& setName : GetSetList(ageName))
+        {
+            for (const auto& elementName : GetElementList(ageName, setName))
+            {
+                ST::string key = ST::format("{}.{}.{}", ageName, setName, elementName);
+                const auto& elements = fLocalizedElements;
+                fElementIndex[key] = &elements[key];
+            }
+        }
+    }
+}
+
+//// IFindElement ////////////////////////////////////////////////////
+
+const pfLocalizationDataMgr::localizedElement* pfLocalizationDataMgr::IFindElement(const ST::string & name) const
+{
+    auto indexIt = fElementIndex.find(name);
+    if (indexIt != fElementIndex.cend())
+        return indexIt->second;
+
+    // Not spelled the way we index it (extra dots and such), let the 3 part map sort it out
+    if (fLocalizedElements.exists(name))
+        return &fLocalizedElements[name];
+    return nullptr;
+}
+
+//// IGetFingerprint /////////////////////////////////////////////////
+
+void pfLocalizationDataMgr::IGetFingerprint(const std::vector<plFileName> & locFiles, uint8_t* digest) const
+{
+    // ListDir doesn't promise any particular order
+    std::vector<plFileName> sortedFiles = locFiles;
+    std::sort(sortedFiles.begin(), sortedFiles.end(),
+              [](const plFileName& a, const plFileName& b) { return a.AsString() < b.AsString(); });
+
+    plSHA1Checksum sum;
+    sum.Start();
+    sum.AddTo(sizeof(kLocCacheVersion), reinterpret_cast<const uint8_t*>(&kLocCacheVersion));
+    for (const auto& file : sortedFiles)
+    {
+        plFileInfo info(file);
+        uint64_t stamp[] = { (uint64_t)info.FileSize(), info.ModifyTime() };
+        ST::string name = file.GetFileName();
+        sum.AddTo(name.size() + 1, reinterpret_cast<const uint8_t*>(name.c_str()));
+        sum.AddTo(sizeof(stamp), reinterpret_cast<const uint8_t*>(stamp));
+    }
+
+    // Unsupported languages are dropped while merging, so these matter too
+    for (const auto& language : plLocalization::GetAllLanguageNames())
+        sum.AddTo(language.size() + 1, reinterpret_cast<const uint8_t*>(language.c_str()));
+    sum.Finish();
+    memcpy(digest, sum.GetValue(), sizeof(ShaDigest));
+}
+
+//// IReadCache //////////////////////////////////////////////////////
+
+bool pfLocalizationDataMgr::IReadCache(const uint8_t* fingerprint)
+{
+    std::vector<uint8_t> data;
+    {
+        hsUNIXStream s;
+        if (!s.Open(fCachePath, "rb"))
+            return false;
+        data.resize(s.GetEOF());
+        if (s.Read(data.size(), data.data()) != data.size())
+            return false;
+    }
+
+    // Pull the whole thing in at once and parse it from memory
+    hsReadOnlyStream s(data.size(), data.data());
+
+    char magic[sizeof(kLocCacheMagic)];
+    ShaDigest digest;
+    ShaDigest payloadSum;
+    uint32_t headerSize = sizeof(magic) + sizeof(uint32_t) + sizeof(digest) + sizeof(uint32_t) + sizeof(payloadSum);
+    if (data.size() < headerSize)
+        return false;
+    s.Read(sizeof(magic), magic);
+    if (memcmp(magic, kLocCacheMagic, sizeof(magic)) != 0 || s.ReadLE32() != kLocCacheVersion)
+        return false;
+    s.Read(sizeof(digest), digest);
+    if (memcmp(digest, fingerprint, sizeof(digest)) != 0)
+        return false;
+
+    // From here on the cache claims to be current, so anything wrong with it
+    // means the file is damaged and should go away rather than be tried again
+    auto discard = [this](const char* reason) {
+        fLog->AddLineF("WARNING: Discarding localization cache {}: {}", fCachePath, reason);
+        plFileSystem::Unlink(fCachePath);
+        return false;
+    };
+
+    if (s.ReadLE32() != data.size() - headerSize)
+        return discard("truncated");
+    s.Read(sizeof(payloadSum), payloadSum);
+    plSHA1Checksum sum(data.size() - headerSize, data.data() + headerSize);
+    if (memcmp(payloadSum, sum.GetValue(), sizeof(payloadSum)) != 0)
+        return discard("checksum mismatch");
+
+    // An element is at least its key and translation count, and a translation
+    // is at least its language and an empty string, so these bound the counts
+    constexpr uint32_t kMinElementSize = sizeof(uint16_t) + sizeof(uint16_t);
+    constexpr uint32_t kMinTranslationSize = sizeof(uint16_t) + sizeof(uint16_t) + 3 * sizeof(uint32_t);
+
+    if (s.GetSizeLeft() < sizeof(uint32_t))
+        return discard("bad element count");
+    uint32_t numElements = s.ReadLE32();
+    if (numElements > s.GetSizeLeft() / kMinElementSize)
+        return discard("bad element count");
+    for (uint32_t i = 0; i < numElements; i++)
+    {
+        if (s.GetSizeLeft() < kMinElementSize)
+            return discard("bad element");
+        ST::string key = s.ReadSafeString();
+        if (key.empty() || s.GetSizeLeft() < sizeof(uint16_t))
+            return discard("bad element");
+        localizedElement& element = fLocalizedElements[key];
+
+        uint16_t numTranslations = s.ReadLE16();
+        if (numTranslations > s.GetSizeLeft() / kMinTranslationSize)
+            return discard("bad translation count");
+        for (uint16_t j = 0; j < numTranslations; j++)
+        {
+            ST::string language = s.ReadSafeString();
+            if (language.empty() || !element[language].Read(&s))
+                return discard("bad translation");
+        }
+    }
+
+    if (!s.AtEnd())
+        return discard("trailing data");
+    return true;
+}
+
+//// IWriteCache /////////////////////////////////////////////////////
+
+void pfLocalizationDataMgr::IWriteCache(const uint8_t* fingerprint) const
+{
+    hsRAMStream payload;
+    payload.WriteLE32((uint32_t)fElementIndex.size());
+    for (const auto& indexed : fElementIndex)
+    {
+        payload.WriteSafeString(indexed.first);
+        payload.WriteLE16((uint16_t)indexed.second->size());
+        for (const auto& translation : *indexed.second)
+        {
+            payload.WriteSafeString(translation.first);
+            translation.second.Write(&payload);
+        }
+    }
+
+    // Write to a temporary file first so a crash never leaves a truncated cache behind.
+    plFileName tempName = plFileName::Join(fCachePath.StripFileName(),
+                                           ST::format("{}.tmp", fCachePath.GetFileName()));
+    {
+        hsUNIXStream s;
+        if (!s.Open(tempName, "wb"))
+        {
+            fLog->AddLineF("WARNING: Can't write localization cache {}", fCachePath);
+            return;
+        }
+        s.Write(sizeof(kLocCacheMagic), kLocCacheMagic);
+        s.WriteLE32(kLocCacheVersion);
+        s.Write(sizeof(ShaDigest), fingerprint);
+        s.WriteLE32(payload.GetEOF());
+        plSHA1Checksum sum(payload.GetEOF(), static_cast<const uint8_t*>(payload.GetData()));
+        s.Write(sizeof(ShaDigest), sum.GetValue());
+        s.Write(payload.GetEOF(), payload.GetData());
+    }
+    plFileSystem::Move(tempName, fCachePath);
+}
+
 //// Initialize //////////////////////////////////////////////////////
 
-void pfLocalizationDataMgr::Initialize(const plFileName & path)
+void pfLocalizationDataMgr::Initialize(const plFileName & path, const plFileName & cachePath)
 {
     if (fInstance)
         return;
 
-    fInstance = new pfLocalizationDataMgr(path);
+    fInstance = new pfLocalizationDataMgr(path, cachePath);
     fLog = plStatusLogMgr::GetInstance().CreateStatusLog(30, "LocalizationDataMgr.log",
         plStatusLog::kFilledBackground | plStatusLog::kAlignToTop | plStatusLog::kTimestamp);
     fInstance->SetupData();
@@ -942,8 +1131,24 @@ void pfLocalizationDataMgr::Shutdown()
 
 void pfLocalizationDataMgr::SetupData()
 {
-    if (fDatabase)
-        delete fDatabase;
+    delete fDatabase;
+    fDatabase = nullptr;
+
+    ShaDigest fingerprint;
+    if (fCachePath.IsValid())
+    {
+        IGetFingerprint(plFileSystem::ListDir(fDataPath, "*.loc"), fingerprint);
+        if (IReadCache(fingerprint))
+        {
+            fLog->AddLineF("Localization data read from cache {}", fCachePath);
+            IIndexElements();
+            OutputTreeToLog();
+            return;
+        }
+
+        // Whatever we got out of a bad cache file is no good
+        fLocalizedElements = pf3PartMap<localizedElement>();
+    }
 
     fDatabase = new LocalizationDatabase();
     fDatabase->Parse(fDataPath);
@@ -956,6 +1161,10 @@ void pfLocalizationDataMgr::SetupData()
     for (const auto& curAge : fDatabase->GetData())
         IConvertAge(curAge.second, curAge.first);
 
+    IIndexElements();
+    if (fCachePath.IsValid())
+        IWriteCache(fingerprint);
+
     OutputTreeToLog();
 }
 
@@ -963,30 +1172,40 @@ void pfLocalizationDataMgr::SetupData()
 
 pfLocalizedString pfLocalizationDataMgr::GetElement(const ST::string & name) const
 {
-    if (!fLocalizedElements.exists(name)) // does the requested element exist?
-        return {}; // nope, so return failure
+    const pfLocalizedString* str = FindElement(name);
+    return str ? *str : pfLocalizedString();
+}
+
+//// FindElement /////////////////////////////////////////////////////
+
+const pfLocalizedString* pfLocalizationDataMgr::FindElement(const ST::string & name) const
+{
+    const localizedElement* element = IFindElement(name);
+    if (!element) // does the requested element exist?
+        return nullptr; // nope, so return failure
 
-    auto currLangIt = fLocalizedElements[name].find(IGetCurrentLanguageName());
-    if (currLangIt != fLocalizedElements[name].cend())
-        return currLangIt->second;
+    auto currLangIt = element->find(IGetCurrentLanguageName());
+    if (currLangIt != element->cend())
+        return &currLangIt->second;
 
     // Force to English
-    auto englishIt = fLocalizedElements[name].find("English");
-    if (englishIt != fLocalizedElements[name].cend())
-        return englishIt->second;
+    auto englishIt = element->find("English");
+    if (englishIt != element->cend())
+        return &englishIt->second;
 
-    return {};
+    return nullptr;
 }
 
 //// GetSpecificElement //////////////////////////////////////////////
 
 pfLocalizedString pfLocalizationDataMgr::GetSpecificElement(const ST::string & name, const ST::string & language) const
 {
-    if (!fLocalizedElements.exists(name)) // does the requested subtitle exist?
+    const localizedElement* element = IFindElement(name);
+    if (!element) // does the requested subtitle exist?
         return {}; // nope, so return failure
 
-    auto findIt = fLocalizedElements[name].find(language);
-    if (findIt == fLocalizedElements[name].cend())
+    auto findIt = element->find(language);
+    if (findIt == element->cend())
         return {}; // language doesn't exist
 
     return findIt->second;
@@ -1078,6 +1297,7 @@ bool pfLocalizationDataMgr::AddElement(const ST::string & name)
 
     pfLocalizedString newElement;
     fLocalizedElements[name]["English"] = newElement;
+    IIndexElements();
     return true;
 }
 
@@ -1104,6 +1324,7 @@ bool pfLocalizationDataMgr::DeleteElement(const ST::string & name)
 
     // delete it!
     fLocalizedElements.erase(name);
+    IIndexElements();
     return true;
 }
 
@@ -53,6 +53,7 @@ You can contact Cyan Worlds, Inc. by email legal@cyan.com
 #include "plFileSystem.h"
 
 #include <map>
+#include <unordered_map>
 #include <vector>
 
 #include "pfLocalizedString.h"
@@ -112,7 +113,12 @@ protected:
     // Contains all localized strings, the key is the Age.Set.Name specified by XML, in localizedElement, the key is the language string
     pf3PartMap<localizedElement> fLocalizedElements;
 
+    // Flat lookup by the full "Age.Set.Name" key, so the per-call path doesn't
+    // have to split the key and walk three maps. Points into fLocalizedElements.
+    std::unordered_map<ST::string, const localizedElement*, ST::hash> fElementIndex;
+
     plFileName fDataPath;
+    plFileName fCachePath;
 
     ST::string IGetCurrentLanguageName() const; // get the name of the current language
 
@@ -122,11 +128,19 @@ protected:
 
     void IWriteText(const plFileName & filename, const ST::string & ageName, const ST::string & languageName) const; // Write localization text to the specified file
 
-    pfLocalizationDataMgr(const plFileName & path);
+    void IIndexElements();
+    const localizedElement* IFindElement(const ST::string & name) const;
+
+    // Binary cache of the converted strings, keyed on the .loc files it came from
+    void IGetFingerprint(const std::vector<plFileName> & locFiles, uint8_t* digest) const;
+    bool IReadCache(const uint8_t* fingerprint);
+    void IWriteCache(const uint8_t* fingerprint) const;
+
+    pfLocalizationDataMgr(const plFileName & path, const plFileName & cachePath);
 public:
     virtual ~pfLocalizationDataMgr();
 
-    static void Initialize(const plFileName & path);
+    static void Initialize(const plFileName & path, const plFileName & cachePath = {});
     static void Shutdown();
     static pfLocalizationDataMgr &Instance() {return *fInstance;}
     static bool InstanceValid() { return fInstance != nullptr; }
@@ -137,6 +151,10 @@ public:
     pfLocalizedString GetElement(const ST::string & name) const;
     pfLocalizedString GetSpecificElement(const ST::string & name, const ST::string & languageName) const;
 
+    // Same as GetElement(), without the copy. Returns nullptr if there's no such element,
+    // and the pointer is only good until the element is changed or deleted.
+    const pfLocalizedString* FindElement(const ST::string & name) const;
+
     std::vector<ST::string> GetAgeList() const
     {
         return fLocalizedElements.getAgeList();
@@ -73,13 +73,13 @@ pfLocalizationMgr::~pfLocalizationMgr()
 
 //// Initialize //////////////////////////////////////////////////////
 
-void pfLocalizationMgr::Initialize(const plFileName & dataPath)
+void pfLocalizationMgr::Initialize(const plFileName & dataPath, const plFileName & cachePath)
 {
     if (fInstance)
         return;
 
     fInstance = new pfLocalizationMgr();
-    pfLocalizationDataMgr::Initialize(dataPath); // set up the data manager
+    pfLocalizationDataMgr::Initialize(dataPath, cachePath); // set up the data manager
 }
 
 //// Shutdown ////////////////////////////////////////////////////////
@@ -97,11 +97,12 @@ void pfLocalizationMgr::Shutdown()
 
 ST::string pfLocalizationMgr::GetString(const ST::string & path, const std::vector<ST::string> & args) const
 {
-    return pfLocalizationDataMgr::Instance().GetElement(path) % args;
+    const pfLocalizedString* str = pfLocalizationDataMgr::Instance().FindElement(path);
+    return str ? *str % args : ST::string();
 }
 
 ST::string pfLocalizationMgr::GetString(const ST::string & path) const
 {
     std::vector<ST::string> args; // blank args so that % signs are still handled correctly
-    return pfLocalizationDataMgr::Instance().GetElement(path) % args;
+    return GetString(path, args);
 }
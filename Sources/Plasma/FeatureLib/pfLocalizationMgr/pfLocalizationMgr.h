@@ -50,8 +50,7 @@ You can contact Cyan Worlds, Inc. by email legal@cyan.com
 #define _pfLocalizationMgr_h
 
 #include "HeadSpin.h"
-
-class plFileName;
+#include "plFileSystem.h"
 
 class pfLocalizationMgr
 {
@@ -62,7 +61,9 @@ protected:
 public:
     virtual ~pfLocalizationMgr();
 
-    static void Initialize(const plFileName & dataPath);
+    // If cachePath is given, the parsed data is kept there and reused for
+    // as long as none of the .loc files change
+    static void Initialize(const plFileName & dataPath, const plFileName & cachePath = {});
     static void Shutdown();
     static pfLocalizationMgr &Instance() {return *fInstance;}
     static bool InstanceValid() { return fInstance != nullptr; }
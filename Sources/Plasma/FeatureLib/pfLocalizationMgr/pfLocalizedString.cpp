@@ -50,6 +50,7 @@ You can contact Cyan Worlds, Inc. by email legal@cyan.com
 #include "pfLocalizedString.h"
 
 #include "HeadSpin.h"
+#include "hsStream.h"
 
 #include <algorithm>
 #include <regex>
@@ -244,6 +245,78 @@ void pfLocalizedString::FromXML(const ST::string & xml)
     IConvertFromXML(xml);
 }
 
+//// Read/Write ////////////////////////////////////////////////////
+
+// Translations can easily run past what ReadSafeString allows, so these
+// just go down as a plain length and UTF-8 bytes.
+static bool IReadLongString(hsStream* s, ST::string& str)
+{
+    if (s->GetSizeLeft() < sizeof(uint32_t))
+        return false;
+    uint32_t size = s->ReadLE32();
+    if (size > s->GetSizeLeft())
+        return false;
+
+    ST::char_buffer buffer;
+    buffer.allocate(size);
+    s->Read(size, buffer.data());
+    str = ST::string::from_utf8(buffer.data(), size, ST::assume_valid);
+    return true;
+}
+
+static void IWriteLongString(hsStream* s, const ST::string& str)
+{
+    s->WriteLE32((uint32_t)str.size());
+    s->Write((uint32_t)str.size(), str.c_str());
+}
+
+bool pfLocalizedString::Read(hsStream* s)
+{
+    if (s->GetSizeLeft() < sizeof(uint16_t) + sizeof(uint32_t))
+        return false;
+    fNumArguments = s->ReadLE16();
+
+    // Every block takes at least two bytes, so a count that can't fit in
+    // what's left of the stream is garbage
+    uint32_t numBlocks = s->ReadLE32();
+    if (numBlocks > s->GetSizeLeft() / 2)
+        return false;
+
+    fText.resize(numBlocks);
+    for (textBlock& block : fText) {
+        if (s->GetSizeLeft() < 2)
+            return false;
+        block.fIsParam = s->ReadBool();
+        if (block.fIsParam) {
+            block.fParamIndex = s->ReadByte();
+            block.fText = ST::string();
+        } else {
+            block.fParamIndex = 0;
+            if (!IReadLongString(s, block.fText))
+                return false;
+        }
+    }
+
+    return IReadLongString(s, fPlainTextRep) && IReadLongString(s, fXMLRep);
+}
+
+void pfLocalizedString::Write(hsStream* s) const
+{
+    s->WriteLE16(fNumArguments);
+
+    s->WriteLE32((uint32_t)fText.size());
+    for (const textBlock& block : fText) {
+        s->WriteBool(block.fIsParam);
+        if (block.fIsParam)
+            s->WriteByte(block.fParamIndex);
+        else
+            IWriteLongString(s, block.fText);
+    }
+
+    IWriteLongString(s, fPlainTextRep);
+    IWriteLongString(s, fXMLRep);
+}
+
 //// Operators ///////////////////////////////////////////////////////
 
 bool pfLocalizedString::operator<(pfLocalizedString &obj) const
@@ -298,6 +371,12 @@ pfLocalizedString &pfLocalizedString::operator=(const ST::string & plainText)
 
 ST::string pfLocalizedString::operator%(const std::vector<ST::string> & arguments) const
 {
+    // Most strings are one plain block, no need to build anything for those
+    if (fText.empty())
+        return ST::string();
+    if (fText.size() == 1 && !fText[0].fIsParam)
+        return fText[0].fText;
+
     ST::string_stream ss;
     for (std::vector<ST::string>::size_type curIndex = 0; curIndex < fText.size(); curIndex++)
     {
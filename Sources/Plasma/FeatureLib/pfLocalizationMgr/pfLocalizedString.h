@@ -54,6 +54,8 @@ You can contact Cyan Worlds, Inc. by email legal@cyan.com
 #include <string_theory/string>
 #include <vector>
 
+class hsStream;
+
 //// pfLocalizedString Class Definition //////////////////////////////
 //  a small class to handle localized strings and which can take
 //  parameters (like %s or %1s) and also can be easily translated to
@@ -92,6 +94,12 @@ public:
 
     uint16_t GetArgumentCount() const { return fNumArguments; }
 
+    // Dumps the already parsed form (blocks and both representations), so
+    // it can be brought back without going through the XML again. Read()
+    // returns false if the stream runs out before the string does.
+    bool Read(hsStream* s);
+    void Write(hsStream* s) const;
+
     // Various operators, they all work pretty much the same as the standard string or wstring operators
     // but note that the all work on the plain text representation (not the XML representation)
     bool operator<(pfLocalizedString &obj) const;
@@ -54,6 +54,7 @@ You can contact Cyan Worlds, Inc. by email legal@cyan.com
 #include "plDrawable/plGBufferGroup.h"
 #include "plGImage/hsCodecManager.h"
 #include "plGImage/plCubicEnvironmap.h"
+#include "plGImage/plDynamicTextMap.h"
 #include "plGImage/plMipmap.h"
 #include "plPipeline/plRenderTarget.h"
 
@@ -953,6 +954,20 @@ void plMetalDevice::MakeTextureRef(plMetalDevice::TextureRef* tRef, plMipmap* im
     tRef->SetDirty(false);
 }
 
+void plMetalDevice::UpdateTextureRects(plMetalDevice::TextureRef* tRef, plDynamicTextMap* img)
+{
+    // Patches the existing texture in place rather than making a new one, so
+    // a frame still in flight may pick up some of the new text a frame early.
+    // That's the text it was about to show anyway.
+    const uint8_t* base = static_cast<const uint8_t*>(img->GetImage());
+    for (const plDynamicTextMap::DirtyRect& rect : img->GetDirtyRects()) {
+        const uint8_t* src = base + rect.fY * img->GetRowBytes() + rect.fX * sizeof(uint32_t);
+        tRef->fTexture->replaceRegion(MTL::Region::Make2D(rect.fX, rect.fY, rect.fWidth, rect.fHeight), 0, 0, src, img->GetRowBytes(), 0);
+    }
+
+    tRef->SetDirty(false);
+}
+
 void plMetalDevice::MakeCubicTextureRef(plMetalDevice::TextureRef* tRef, plCubicEnvironmap* img)
 {
     MTL::TextureDescriptor* descriptor = MTL::TextureDescriptor::textureCubeDescriptor(tRef->fFormat, img->GetFace(0)->GetWidth(), tRef->fLevels != 0);
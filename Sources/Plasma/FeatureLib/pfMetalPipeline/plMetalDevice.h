@@ -62,6 +62,7 @@ class plRenderTarget;
 class plBitmap;
 class plMipmap;
 class plCubicEnvironmap;
+class plDynamicTextMap;
 class plLayerInterface;
 class plMetalPipelineState;
 
@@ -149,6 +150,7 @@ public:
     void CheckTexture(TextureRef* tRef);
     void MakeTextureRef(TextureRef* tRef, plMipmap* img);
     void MakeCubicTextureRef(TextureRef* tRef, plCubicEnvironmap* img);
+    void UpdateTextureRects(TextureRef* tRef, plDynamicTextMap* img);
 
     ST::string GetErrorString() const { return fErrorMsg; }
 
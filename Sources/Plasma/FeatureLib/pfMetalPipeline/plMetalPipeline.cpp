@@ -57,6 +57,7 @@ You can contact Cyan Worlds, Inc. by email legal@cyan.com
 #include "plDrawable/plDrawableSpans.h"
 #include "plDrawable/plGBufferGroup.h"
 #include "plGImage/plCubicEnvironmap.h"
+#include "plGImage/plDynamicTextMap.h"
 #include "plGImage/plMipmap.h"
 #include "plGLight/plLightInfo.h"
 #include "plGLight/plShadowCaster.h"
@@ -4320,7 +4321,21 @@ void plMetalPipeline::IReloadTexture(plBitmap* bitmap, plMetalTextureRef* ref)
 {
     plMipmap* mip = plMipmap::ConvertNoRef(bitmap);
     if (mip) {
+        // Dynamic text maps know what changed since they were last uploaded,
+        // so if we still have a texture of the right size, just patch that.
+        plDynamicTextMap* dtMap = plDynamicTextMap::ConvertNoRef(mip);
+        if (dtMap && ref->fTexture && dtMap->GetImage() &&
+            dtMap->HasDirtyRects() && !dtMap->IsFullyDirty() &&
+            ref->fTexture->width() == dtMap->GetWidth() && ref->fTexture->height() == dtMap->GetHeight()) {
+            fDevice.UpdateTextureRects(ref, dtMap);
+            dtMap->ClearDirtyRects();
+            return;
+        }
+
         fDevice.MakeTextureRef(ref, mip);
+        if (dtMap && !ref->IsDirty()) {
+            dtMap->ClearDirtyRects(true);
+        }
         return;
     }
 
@@ -51,6 +51,7 @@ You can contact Cyan Worlds, Inc. by email legal@cyan.com
 #include "hsStream.h"
 #include "hsThread.h"
 #include "hsTimer.h"
+#include "plProfile.h"
 
 #include "pnEncryption/plChecksum.h"
 #include "pnNetBase/pnNbError.h"
@@ -621,6 +622,8 @@ void pfPatcherWorker::IDecompressSound(const pfPatcherQueuedFile& file) const
 
 void pfPatcherWorker::ProcessFile()
 {
+    plProfile_TraceScope("Patcher Process File");
+
     do {
         pfPatcherQueuedFile& file = fQueuedFiles.front();
         switch (file.fType) {
@@ -108,6 +108,7 @@ You can contact Cyan Worlds, Inc. by email legal@cyan.com
 #include "pyGUIPopUpMenu.h"
 #include "pyGUISkin.h"
 
+#include "plPythonPack.h"
 #include "plPythonSDLModifier.h"
 
 // For printing to the log
@@ -1272,6 +1273,9 @@ void PythonInterface::finiPython()
 
         Py_CLEAR(builtInModuleName);
 
+        // the packed code objects have to go while Python is still around to free them
+        PythonPack::ReleaseCachedCode();
+
         // let Python clean up after itself
         if (Py_FinalizeEx() != 0)
             dbgLog->AddLine("Hmm... Errors during Python shutdown.");
@@ -134,6 +134,7 @@ You can contact Cyan Worlds, Inc. by email legal@cyan.com
 
 #include "pyGameScoreMsg.h"
 
+#include "plPythonProfiler.h"
 #include "plPythonSDLModifier.h"
 
 #include "plMessage/plTimerCallbackMsg.h"
@@ -359,6 +360,7 @@ void plPythonFileMod::ICallScriptMethod(func_num methodId, Args&&... args)
     if (!callable)
         return;
 
+    plPythonProfileGuard profile(fPythonFile, fFunctionNames[methodId]);
     pyObjectRef retVal = plPython::CallObject(callable, std::forward<Args>(args)...);
     if (!retVal)
         ReportError();
@@ -42,45 +42,17 @@ You can contact Cyan Worlds, Inc. by email legal@cyan.com
 
 #include <Python.h>
 #include <marshal.h>
-#include <ctime>
+#include <algorithm>
 #include <string_theory/format>
 
 #include "HeadSpin.h"
 #include "hsStream.h"
+#include "hsTimer.h"
 
 #include "plPythonPack.h"
 
 #include "plFile/plStreamSource.h"
 
-struct plPackOffsetInfo
-{
-    uint32_t fOffset;
-    uint32_t fStreamIndex; // index of the stream object in the plPythonPack object that the file resides in
-};
-
-class plPythonPack
-{
-protected:
-    std::vector<hsStream*> fPackStreams;
-    bool fPackNotFound;     // No pack file, don't keep trying
-
-    typedef std::map<ST::string, plPackOffsetInfo> FileOffset;
-    FileOffset fFileOffsets;
-
-    plPythonPack();
-
-public:
-    ~plPythonPack();
-
-    static plPythonPack& Instance();
-
-    bool Open();
-    void Close();
-
-    PyObject* OpenPacked(const ST::string& sfileName);
-    bool IsPackedFile(const ST::string& fileName);
-};
-
 PyObject* PythonPack::OpenPythonPacked(const ST::string& fileName)
 {
     return plPythonPack::Instance().OpenPacked(fileName);
@@ -91,7 +63,17 @@ bool PythonPack::IsItPythonPacked(const ST::string& fileName)
     return plPythonPack::Instance().IsPackedFile(fileName);
 }
 
-plPythonPack::plPythonPack() : fPackNotFound(false)
+void PythonPack::ReleaseCachedCode()
+{
+    plPythonPack::Instance().ReleaseCachedCode();
+}
+
+std::vector<PythonPack::LoadTime> PythonPack::GetLoadTimes()
+{
+    return plPythonPack::Instance().GetLoadTimes();
+}
+
+plPythonPack::plPythonPack() : fIndexDirty(false), fPackNotFound(false)
 {
 }
 
@@ -120,67 +102,153 @@ bool plPythonPack::Open()
     // Get the names of all the pak files
     std::vector<plFileName> files = plStreamSource::GetInstance()->GetListOfNames("python", "pak");
 
-    std::vector<time_t> modTimes; // the modification time for each of the streams (to resolve duplicate file issues)
-
     // grab all the .pak files in the folder
-    for (int curName = 0; curName < files.size(); curName++)
+    for (const plFileName& file : files)
     {
         // obtain the stream
-        hsStream *fPackStream = plStreamSource::GetInstance()->GetFile(files[curName]);
-        if (fPackStream)
+        hsStream* packStream = plStreamSource::GetInstance()->GetFile(file);
+        if (packStream)
         {
-            fPackStream->Rewind(); // make sure we're at the beginning of the file
-            fPackNotFound = false;
-
             time_t curModTime = 0;
-            plFileInfo info(files[curName]);
+            plFileInfo info(file);
             if (info.Exists())
                 curModTime = info.ModifyTime();
-            modTimes.push_back(curModTime);
-
-            // read the index data
-            int numFiles = fPackStream->ReadLE32();
-            uint32_t streamIndex = (uint32_t)(fPackStreams.size());
-            for (int i = 0; i < numFiles; i++)
-            {
-                // and pack the index into our own data structure
-                ST::string pythonName = fPackStream->ReadSafeString();
-                uint32_t offset = fPackStream->ReadLE32();
-
-                plPackOffsetInfo offsetInfo;
-                offsetInfo.fOffset = offset;
-                offsetInfo.fStreamIndex = streamIndex;
-
-                if (fFileOffsets.find(pythonName) != fFileOffsets.end())
-                {
-                    uint32_t index = fFileOffsets[pythonName].fStreamIndex;
-                    if (modTimes[index] < curModTime) // is the existing file older then the new one?
-                        fFileOffsets[pythonName] = offsetInfo; // yup, so replace it with the new info
-                }
-                else
-                    fFileOffsets[pythonName] = offsetInfo; // no conflicts, add the info
-            }
-            fPackStreams.push_back(fPackStream);
+
+            if (AddPackStream(packStream, curModTime))
+                fPackNotFound = false;
         }
     }
 
     return !fPackNotFound;
 }
 
-void plPythonPack::Close()
+bool plPythonPack::AddPackStream(hsStream* stream, time_t modTime)
 {
-    if (fPackStreams.size() == 0)
+    stream->Rewind(); // make sure we're at the beginning of the file
+
+    uint32_t numFiles = stream->ReadLE32();
+    uint32_t streamIndex = (uint32_t)fPackStreams.size();
+
+    fIndex.reserve(fIndex.size() + numFiles);
+    for (uint32_t i = 0; i < numFiles; i++)
+    {
+        ST::string pythonName = stream->ReadSafeString();
+        uint32_t offset = stream->ReadLE32();
+
+        // The index stores "module.py", but every lookup is by module name.
+        if (pythonName.ends_with(".py"))
+            pythonName = pythonName.substr(0, pythonName.size() - 3);
+
+        Entry entry;
+        entry.fHash = ST::hash()(pythonName);
+        entry.fName = std::move(pythonName);
+        entry.fOffset = offset;
+        entry.fStreamIndex = streamIndex;
+        entry.fSize = 0;
+        entry.fLoadTicks = 0;
+        entry.fCode = nullptr;
+        fIndex.push_back(std::move(entry));
+    }
+
+    fPackStreams.push_back(stream);
+    fModTimes.push_back(modTime);
+    fIndexDirty = true;
+    return true;
+}
+
+bool plPythonPack::IEntryLess(const Entry& lhs, const Entry& rhs)
+{
+    if (lhs.fHash != rhs.fHash)
+        return lhs.fHash < rhs.fHash;
+    return lhs.fName < rhs.fName;
+}
+
+void plPythonPack::IBuildIndex()
+{
+    if (!fIndexDirty)
         return;
-    
-    int i;
-    for (i=0; i<fPackStreams.size(); i++)
+    fIndexDirty = false;
+
+    // Group duplicates together with the newest pak first. On a tie, the pak
+    // that was found first wins.
+    std::sort(fIndex.begin(), fIndex.end(), [this](const Entry& lhs, const Entry& rhs) {
+        if (IEntryLess(lhs, rhs))
+            return true;
+        if (IEntryLess(rhs, lhs))
+            return false;
+        time_t lhsTime = fModTimes[lhs.fStreamIndex];
+        time_t rhsTime = fModTimes[rhs.fStreamIndex];
+        if (lhsTime != rhsTime)
+            return lhsTime > rhsTime;
+        return lhs.fStreamIndex < rhs.fStreamIndex;
+    });
+
+    auto dest = fIndex.begin();
+    for (auto it = fIndex.begin(); it != fIndex.end(); ++it)
     {
-        // do NOT close or delete the streams, the preloader will do that for us
-        fPackStreams[i] = nullptr;
+        if (dest != fIndex.begin() && !IEntryLess(*(dest - 1), *it)) {
+            // Superseded by a newer pak
+            Py_XDECREF(it->fCode);
+            continue;
+        }
+        if (dest != it)
+            *dest = std::move(*it);
+        ++dest;
     }
+    fIndex.erase(dest, fIndex.end());
+}
 
+plPythonPack::Entry* plPythonPack::IFind(const ST::string& moduleName)
+{
+    IBuildIndex();
+
+    size_t hash = ST::hash()(moduleName);
+    auto it = std::lower_bound(fIndex.begin(), fIndex.end(), hash,
+        [&moduleName](const Entry& entry, size_t hash) {
+            if (entry.fHash != hash)
+                return entry.fHash < hash;
+            return entry.fName < moduleName;
+        });
+    if (it != fIndex.end() && it->fHash == hash && it->fName == moduleName)
+        return &(*it);
+    return nullptr;
+}
+
+bool plPythonPack::IReadEntry(Entry* entry)
+{
+    hsStream* packStream = fPackStreams[entry->fStreamIndex];
+    packStream->SetPosition(entry->fOffset);
+
+    int32_t size = packStream->ReadLE32();
+    if (size <= 0)
+        return false;
+
+    // Reuse the same buffer for every module rather than allocating one per load
+    if (fScratch.size() < (size_t)size)
+        fScratch.resize(size);
+    uint32_t readSize = packStream->Read(size, fScratch.data());
+    hsAssert(readSize <= size, ST::format("Python PackFile {}: Incorrect amount of data, read {} instead of {}",
+             entry->fName, readSize, size).c_str());
+
+    entry->fSize = size;
+    return true;
+}
+
+void plPythonPack::Close()
+{
+    if (fPackStreams.size() == 0)
+        return;
+
+    // If Python is already gone, the code objects went with it.
+    if (Py_IsInitialized())
+        ReleaseCachedCode();
+
+    // do NOT close or delete the streams, the preloader will do that for us
     fPackStreams.clear();
-    fFileOffsets.clear();
+    fModTimes.clear();
+    fIndex.clear();
+    fScratch.clear();
+    fIndexDirty = false;
 }
 
 PyObject* plPythonPack::OpenPacked(const ST::string& fileName)
@@ -188,34 +256,26 @@ PyObject* plPythonPack::OpenPacked(const ST::string& fileName)
     if (!Open())
         return nullptr;
 
-    ST::string pythonName = fileName + ".py";
+    Entry* entry = IFind(fileName);
+    if (!entry)
+        return nullptr;
 
-    FileOffset::iterator it = fFileOffsets.find(pythonName);
-    if (it != fFileOffsets.end())
+    if (!entry->fCode)
     {
-        plPackOffsetInfo offsetInfo = (*it).second;
-        hsStream* fPackStream = fPackStreams[offsetInfo.fStreamIndex];
-        
-        fPackStream->SetPosition(offsetInfo.fOffset);
-
-        int32_t size = fPackStream->ReadLE32();
-        if (size > 0)
-        {
-            char *buf = new char[size];
-            uint32_t readSize = fPackStream->Read(size, buf);
-            hsAssert(readSize <= size, ST::format("Python PackFile {}: Incorrect amount of data, read {} instead of {}",
-                     fileName, readSize, size).c_str());
-
-            // let the python marshal make it back into a code object
-            PyObject *pythonCode = PyMarshal_ReadObjectFromString(buf, size);
-
-            delete [] buf;
-
-            return pythonCode;
-        }
+        uint64_t startTicks = hsTimer::GetTicks();
+        if (!IReadEntry(entry))
+            return nullptr;
+
+        // let the python marshal make it back into a code object
+        entry->fCode = PyMarshal_ReadObjectFromString(fScratch.data(), entry->fSize);
+        entry->fLoadTicks = hsTimer::GetTicks() - startTicks;
+        if (!entry->fCode)
+            return nullptr;
     }
 
-    return nullptr;
+    // Code objects are immutable, so everyone can share the same one.
+    Py_INCREF(entry->fCode);
+    return entry->fCode;
 }
 
 bool plPythonPack::IsPackedFile(const ST::string& fileName)
@@ -223,11 +283,39 @@ bool plPythonPack::IsPackedFile(const ST::string& fileName)
     if (!Open())
         return false;
 
-    ST::string pythonName = fileName + ".py";
+    return IFind(fileName) != nullptr;
+}
 
-    FileOffset:: iterator it = fFileOffsets.find(pythonName);
-    if (it != fFileOffsets.end())
-        return true;
+bool plPythonPack::ReadPackedData(const ST::string& fileName, std::vector<char>& data)
+{
+    if (!Open())
+        return false;
+
+    Entry* entry = IFind(fileName);
+    if (!entry || !IReadEntry(entry))
+        return false;
+
+    data.assign(fScratch.begin(), fScratch.begin() + entry->fSize);
+    return true;
+}
 
-    return false;
+void plPythonPack::ReleaseCachedCode()
+{
+    for (Entry& entry : fIndex)
+        Py_CLEAR(entry.fCode);
+}
+
+std::vector<PythonPack::LoadTime> plPythonPack::GetLoadTimes() const
+{
+    std::vector<PythonPack::LoadTime> times;
+    for (const Entry& entry : fIndex)
+    {
+        if (entry.fLoadTicks == 0)
+            continue;
+        times.push_back({ entry.fName, entry.fSize, hsTimer::GetMilliSeconds<double>(entry.fLoadTicks) });
+    }
+    std::sort(times.begin(), times.end(), [](const PythonPack::LoadTime& lhs, const PythonPack::LoadTime& rhs) {
+        return lhs.fMilliseconds > rhs.fMilliseconds;
+    });
+    return times;
 }
@@ -42,14 +42,95 @@ You can contact Cyan Worlds, Inc. by email legal@cyan.com
 #ifndef plPythonPack_h_inc
 #define plPythonPack_h_inc
 
+#include "HeadSpin.h"
+
+#include <ctime>
+#include <string_theory/string>
+#include <vector>
+
+class hsStream;
 typedef struct _object PyObject;
-namespace ST { class string; }
 
 namespace PythonPack
 {
+    struct LoadTime
+    {
+        ST::string  fName;
+        uint32_t    fSize;
+        double      fMilliseconds;
+    };
+
     /** Returns new reference of marshalled python code. */
     PyObject* OpenPythonPacked(const ST::string& fileName);
     bool IsItPythonPacked(const ST::string& fileName);
+
+    /** Drops all cached code objects. Must be called before Python is finalized. */
+    void ReleaseCachedCode();
+
+    /** Returns the time spent reading and unmarshalling each loaded module, slowest first. */
+    std::vector<LoadTime> GetLoadTimes();
 }
 
+//
+// plPythonPack - Index of the compiled modules in all of the python .pak files
+//
+// A .pak file is a LE32 entry count followed by (SafeString name, LE32 offset)
+// pairs, then the (LE32 size, marshal data) blobs the offsets point to. All of
+// the pak indices are merged into a single flat array sorted by name hash, so
+// a lookup is a binary search without any string allocations. Modules are only
+// unmarshalled when first requested, and the resulting code object is kept so
+// that scripts attached to many objects are unmarshalled once.
+//
+class plPythonPack
+{
+protected:
+    struct Entry
+    {
+        size_t      fHash;
+        ST::string  fName;          // Module name, without the .py
+        uint32_t    fOffset;
+        uint32_t    fStreamIndex;   // Index of the stream in fPackStreams that the module resides in
+        uint32_t    fSize;          // Size of the marshal data, valid after the first load
+        uint64_t    fLoadTicks;     // Time spent reading and unmarshalling
+        PyObject*   fCode;          // Cached code object (strong ref)
+    };
+
+    std::vector<hsStream*> fPackStreams;
+    std::vector<time_t> fModTimes;  // the modification time for each of the streams (to resolve duplicate file issues)
+    std::vector<Entry> fIndex;
+    std::vector<char> fScratch;
+    bool fIndexDirty;
+    bool fPackNotFound;     // No pack file, don't keep trying
+
+    static bool IEntryLess(const Entry& lhs, const Entry& rhs);
+    void IBuildIndex();
+    Entry* IFind(const ST::string& moduleName);
+    bool IReadEntry(Entry* entry);
+
+public:
+    plPythonPack();
+    ~plPythonPack();
+
+    static plPythonPack& Instance();
+
+    /** Finds and indexes all of the python .pak files in the stream source. */
+    bool Open();
+    void Close();
+
+    /**
+     * Adds the index of a single .pak stream.
+     * \remarks The stream is not owned by the pack and must outlive it.
+     */
+    bool AddPackStream(hsStream* stream, time_t modTime = 0);
+
+    PyObject* OpenPacked(const ST::string& fileName);
+    bool IsPackedFile(const ST::string& fileName);
+
+    /** Reads the raw marshal data for a module without unmarshalling it. */
+    bool ReadPackedData(const ST::string& fileName, std::vector<char>& data);
+
+    void ReleaseCachedCode();
+    std::vector<PythonPack::LoadTime> GetLoadTimes() const;
+};
+
 #endif // plPythonPack_h_inc
@@ -0,0 +1,125 @@
+/*==LICENSE==*
+
+CyanWorlds.com Engine - MMOG client, server and tools
+Copyright (C) 2011  Cyan Worlds, Inc.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+Additional permissions under GNU GPL version 3 section 7
+
+If you modify this Program, or any covered work, by linking or
+combining it with any of RAD Game Tools Bink SDK, Autodesk 3ds Max SDK,
+NVIDIA PhysX SDK, Microsoft DirectX SDK, OpenSSL library, Independent
+JPEG Group JPEG library, Microsoft Windows Media SDK, or Apple QuickTime SDK
+(or a modified version of those libraries),
+containing parts covered by the terms of the Bink SDK EULA, 3ds Max EULA,
+PhysX SDK EULA, DirectX SDK EULA, OpenSSL and SSLeay licenses, IJG
+JPEG Library README, Windows Media SDK EULA, or QuickTime SDK EULA, the
+licensors of this Program grant you additional
+permission to convey the resulting work. Corresponding Source for a
+non-source form of such a combination shall include the source code for
+the parts of OpenSSL and IJG JPEG Library used as well as that of the covered
+work.
+
+You can contact Cyan Worlds, Inc. by email legal@cyan.com
+ or by snail mail at:
+      Cyan Worlds, Inc.
+      14617 N Newport Hwy
+      Mead, WA   99021
+
+*==LICENSE==*/
+
+#include "plPythonProfiler.h"
+
+#include <algorithm>
+#include <string_theory/format>
+#include <vector>
+
+#include "hsStream.h"
+#include "plFileSystem.h"
+#include "plProfile.h"
+
+plProfile_CreateTimer("Scripts", "Python", PythonScripts);
+
+bool plPythonProfiler::fEnabled = false;
+
+plPythonProfiler& plPythonProfiler::Instance()
+{
+    static plPythonProfiler theInstance;
+    return theInstance;
+}
+
+void plPythonProfiler::SetEnabled(bool on)
+{
+    fEnabled = on;
+}
+
+void plPythonProfiler::Reset()
+{
+    fStats.clear();
+}
+
+ST::string plPythonProfiler::IBegin(const ST::string& module, const char* handler)
+{
+    ST::string key = ST::format("{}.{}", module, handler);
+
+    // Only the outermost handler gets a lap, otherwise scripts that
+    // synchronously trigger other scripts would count twice in the total.
+    if (fDepth++ == 0)
+        plProfile_BeginLap(PythonScripts, key);
+    return key;
+}
+
+void plPythonProfiler::IEnd(const ST::string& module, const char* handler, const ST::string& key, uint64_t ticks)
+{
+    if (fDepth > 0 && --fDepth == 0)
+        plProfile_EndLap(PythonScripts, key);
+
+    Stats& stats = fStats[key];
+    if (stats.fCalls == 0) {
+        stats.fModule = module;
+        stats.fHandler = handler;
+    }
+    stats.fCalls++;
+    stats.fTotalTicks += ticks;
+    stats.fMaxTicks = std::max(stats.fMaxTicks, ticks);
+}
+
+bool plPythonProfiler::DumpCSV(const plFileName& fileName) const
+{
+    std::vector<const Stats*> sorted;
+    sorted.reserve(fStats.size());
+    for (const auto& it : fStats)
+        sorted.push_back(&it.second);
+    std::sort(sorted.begin(), sorted.end(), [](const Stats* a, const Stats* b) {
+        return a->fTotalTicks > b->fTotalTicks;
+    });
+
+    plFileSystem::CreateDir(fileName.StripFileName(), true);
+
+    hsUNIXStream s;
+    if (!s.Open(fileName, "wt"))
+        return false;
+
+    s.WriteString(ST_LITERAL("Module,Handler,Calls,Total ms,Avg ms,Max ms\n"));
+    for (const Stats* stats : sorted) {
+        double total = hsTimer::GetMilliSeconds<double>(stats->fTotalTicks);
+        s.WriteString(ST::format("{},{},{},{.3f},{.3f},{.3f}\n",
+                                 stats->fModule, stats->fHandler, stats->fCalls,
+                                 total, total / stats->fCalls,
+                                 hsTimer::GetMilliSeconds<double>(stats->fMaxTicks)));
+    }
+    s.Close();
+    return true;
+}
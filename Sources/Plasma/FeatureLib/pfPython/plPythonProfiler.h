@@ -0,0 +1,132 @@
+/*==LICENSE==*
+
+CyanWorlds.com Engine - MMOG client, server and tools
+Copyright (C) 2011  Cyan Worlds, Inc.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+Additional permissions under GNU GPL version 3 section 7
+
+If you modify this Program, or any covered work, by linking or
+combining it with any of RAD Game Tools Bink SDK, Autodesk 3ds Max SDK,
+NVIDIA PhysX SDK, Microsoft DirectX SDK, OpenSSL library, Independent
+JPEG Group JPEG library, Microsoft Windows Media SDK, or Apple QuickTime SDK
+(or a modified version of those libraries),
+containing parts covered by the terms of the Bink SDK EULA, 3ds Max EULA,
+PhysX SDK EULA, DirectX SDK EULA, OpenSSL and SSLeay licenses, IJG
+JPEG Library README, Windows Media SDK EULA, or QuickTime SDK EULA, the
+licensors of this Program grant you additional
+permission to convey the resulting work. Corresponding Source for a
+non-source form of such a combination shall include the source code for
+the parts of OpenSSL and IJG JPEG Library used as well as that of the covered
+work.
+
+You can contact Cyan Worlds, Inc. by email legal@cyan.com
+ or by snail mail at:
+      Cyan Worlds, Inc.
+      14617 N Newport Hwy
+      Mead, WA   99021
+
+*==LICENSE==*/
+#ifndef plPythonProfiler_h_inc
+#define plPythonProfiler_h_inc
+
+#include "HeadSpin.h"
+#include "hsTimer.h"
+
+#include <string_theory/string>
+#include <unordered_map>
+
+class plFileName;
+
+//
+// plPythonProfiler - Opt-in wall time accounting for Python script handlers.
+//
+// Every call into a script handler (plPythonFileMod::ICallScriptMethod and
+// pyAlarm callbacks) is bracketed with a plPythonProfileGuard. When the
+// profiler is disabled, the guard costs a single bool test. When enabled,
+// the inclusive time and call count are accumulated per (module, handler)
+// and the outermost call is reported as a lap of the "Python - Scripts"
+// profile timer, so it shows up in Stats.ShowLaps.
+//
+class plPythonProfiler
+{
+public:
+    struct Stats
+    {
+        ST::string  fModule;
+        ST::string  fHandler;
+        uint32_t    fCalls;
+        uint64_t    fTotalTicks;
+        uint64_t    fMaxTicks;
+
+        Stats() : fCalls(), fTotalTicks(), fMaxTicks() { }
+    };
+
+protected:
+    typedef std::unordered_map<ST::string, Stats, ST::hash> StatsMap;
+
+    static bool fEnabled;
+
+    StatsMap    fStats;
+    uint32_t    fDepth;
+
+    plPythonProfiler() : fDepth() { }
+
+    friend class plPythonProfileGuard;
+    ST::string IBegin(const ST::string& module, const char* handler);
+    void IEnd(const ST::string& module, const char* handler, const ST::string& key, uint64_t ticks);
+
+public:
+    static plPythonProfiler& Instance();
+
+    static bool IsEnabled() { return fEnabled; }
+    void SetEnabled(bool on);
+    void Reset();
+
+    const StatsMap& GetStats() const { return fStats; }
+
+    /** Writes all accumulated stats, slowest handlers first. */
+    bool DumpCSV(const plFileName& fileName) const;
+};
+
+class plPythonProfileGuard
+{
+    const ST::string&   fModule;
+    const char*         fHandler;
+    ST::string          fKey;
+    uint64_t            fStart;
+    bool                fActive;
+
+public:
+    plPythonProfileGuard(const ST::string& module, const char* handler)
+        : fModule(module), fHandler(handler), fStart(), fActive(plPythonProfiler::IsEnabled())
+    {
+        if (fActive) {
+            fKey = plPythonProfiler::Instance().IBegin(fModule, fHandler);
+            fStart = hsTimer::GetTicks();
+        }
+    }
+
+    plPythonProfileGuard(const plPythonProfileGuard&) = delete;
+    plPythonProfileGuard(plPythonProfileGuard&&) = delete;
+
+    ~plPythonProfileGuard()
+    {
+        if (fActive)
+            plPythonProfiler::Instance().IEnd(fModule, fHandler, fKey, hsTimer::GetTicks() - fStart);
+    }
+};
+
+#endif // plPythonProfiler_h_inc
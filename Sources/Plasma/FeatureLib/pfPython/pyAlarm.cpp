@@ -43,6 +43,7 @@ You can contact Cyan Worlds, Inc. by email legal@cyan.com
 #include "pyAlarm.h"
 
 #include "plPythonCallable.h"
+#include "plPythonProfiler.h"
 
 #include "hsTimer.h"
 
@@ -76,6 +77,10 @@ void pyAlarmMgr::Alarm::Fire()
     if (fCb) {
         pyObjectRef func = PyObject_GetAttrString(fCb, "onAlarm");
         if (func && PyCallable_Check(func.Get())) {
+            ST::string module;
+            if (plPythonProfiler::IsEnabled())
+                module = Py_TYPE(fCb)->tp_name;
+            plPythonProfileGuard profile(module, "onAlarm");
             pyObjectRef result = plPython::CallObject(func, fCbContext);
             if (!result)
                 PyErr_Print();
@@ -369,6 +369,7 @@ CLASS_INDEX_LIST_START
     CLASS_INDEX(plVolumeSensorConditionalObjectNoArbitration),
     CLASS_INDEX(plPXSubWorld),
     CLASS_INDEX(pfConfirmationMgr),
+    CLASS_INDEX(plShadowScheduler),
 //---------------------------------------------------------
 // Keyed objects above this line, unkeyed (such as messages) below..
 //---------------------------------------------------------
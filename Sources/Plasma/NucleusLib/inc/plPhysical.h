@@ -83,6 +83,11 @@ public:
     virtual bool GetAngularVelocitySim(hsVector3& vel) const = 0;
     virtual void SetAngularVelocitySim(const hsVector3& vel, bool wakeup=true) = 0;
 
+    // Same as sending a plImpulseMsg or plDampMsg, for callers that do it every frame.
+    // Note the damping here is how strong it is, not the plDampMsg percentage.
+    virtual void SetImpulseSim(const hsVector3& imp, bool wakeup=true) = 0;
+    virtual void SetDampingSim(float factor) = 0;
+
     /** Standard plasma transform interface, in global coordinates by convention.
     If you send in the same matrix that the physical last sent out in its correction message,
     it will be ignored as an "echo" -- UNLESS you set force to true, in which case the transform
@@ -82,6 +82,7 @@ namespace plPipeDbg
         kFlagNoPreShade,
         kFlagNVPerfHUD,
         kFlagNoFog,
+        kFlagNoLightGrid,
     };
 
 }
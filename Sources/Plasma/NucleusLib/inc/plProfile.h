@@ -46,6 +46,8 @@ You can contact Cyan Worlds, Inc. by email legal@cyan.com
 
 #include <string_theory/string>
 
+#include "plProfileTrace.h"
+
 #ifndef PLASMA_EXTERNAL_RELEASE
 #define PL_PROFILE_ENABLED
 #endif
@@ -78,6 +80,15 @@ You can contact Cyan Worlds, Inc. by email legal@cyan.com
 //     plProfile_EndLap(FoobarTime, pKeyedObj->GetKeyName());
 // }
 //
+// Timers show up in timeline traces (see plProfileTrace.h) automatically.
+// Code running outside of the main loop can mark its own spans as well:
+//
+// void SomeWorkerFunc()
+// {
+//     plProfile_TraceScope("Decode Foobar");
+//     (execute some code...)
+// }
+//
 
 #ifdef PL_PROFILE_ENABLED
 
@@ -90,6 +101,7 @@ You can contact Cyan Worlds, Inc. by email legal@cyan.com
 #define plProfile_BeginLap(varName, lapName)        gProfileVar##varName.BeginLap(lapName)
 #define plProfile_EndLap(varName, lapName)          gProfileVar##varName.EndLap(lapName)
 #define plProfile_LapGuard(varName, lapName)        plProfileVar_LapGuard hsUniqueIdentifier(ProfileLap)(gProfileVar##varName, lapName)
+#define plProfile_TraceScope(name)                  plProfileTrace_ScopeGuard hsUniqueIdentifier(ProfileTrace)(name)
 
 #define plProfile_CreateCounter(name, group, varName)   plProfileVar gProfileVar##varName(ST_LITERAL(name), ST_LITERAL(group), plProfileVar::kDisplayCount)
 #define plProfile_CreateCounterNoReset(name, group, varName)    plProfileVar gProfileVar##varName(ST_LITERAL(name), ST_LITERAL(group), plProfileVar::kDisplayCount | plProfileVar::kDisplayNoReset)
@@ -119,6 +131,7 @@ You can contact Cyan Worlds, Inc. by email legal@cyan.com
 #define plProfile_BeginLap(varName, lapName)
 #define plProfile_EndLap(varName, lapName)
 #define plProfile_LapGuard(varName, lapName)
+#define plProfile_TraceScope(name)
 
 #define plProfile_CreateCounter(name, group, varName)
 #define plProfile_CreateCounterNoReset(name, group, varName)
@@ -187,6 +200,9 @@ public:
 
     uint64_t GetValue();
 
+    // Unconverted value for this frame; timers are in hsTimer ticks
+    uint64_t GetRawValue() const { return fValue; }
+
     ST::string PrintValue(bool printType = true);
     ST::string PrintAvg(bool printType = true);
     ST::string PrintMax(bool printType = true);
@@ -226,8 +242,18 @@ public:
     ~plProfileVar();
 
     // For timing
-    void BeginTiming() { if (fActive && fRunning) IBeginTiming(); }
-    void EndTiming() { if (fActive && fRunning) IEndTiming(); }
+    void BeginTiming()
+    {
+        plProfileTrace::Begin(fName.c_str(), fGroup.c_str());
+        if (fActive && fRunning)
+            IBeginTiming();
+    }
+    void EndTiming()
+    {
+        if (fActive && fRunning)
+            IEndTiming();
+        plProfileTrace::End(fName.c_str(), fGroup.c_str());
+    }
 
     void NewMem(uint32_t memAmount) { fValue += memAmount; }
     void DelMem(uint32_t memAmount) { fValue -= memAmount; }
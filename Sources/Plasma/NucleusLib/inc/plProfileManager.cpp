@@ -41,6 +41,7 @@ You can contact Cyan Worlds, Inc. by email legal@cyan.com
 *==LICENSE==*/
 #include "plProfileManager.h"
 #include "plProfile.h"
+#include "plProfileTrace.h"
 #include "hsTimer.h"
 
 #include <string_theory/format>
@@ -125,6 +126,8 @@ void plProfileManager::EndFrame()
         if (var->GetLaps())
             var->GetLaps()->EndFrame();
     }
+
+    plProfileTrace::Instance().EndFrame();
 }
 
 uint64_t plProfileManager::GetTime()
@@ -0,0 +1,298 @@
+/*==LICENSE==*
+
+CyanWorlds.com Engine - MMOG client, server and tools
+Copyright (C) 2011  Cyan Worlds, Inc.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+Additional permissions under GNU GPL version 3 section 7
+
+If you modify this Program, or any covered work, by linking or
+combining it with any of RAD Game Tools Bink SDK, Autodesk 3ds Max SDK,
+NVIDIA PhysX SDK, Microsoft DirectX SDK, OpenSSL library, Independent
+JPEG Group JPEG library, Microsoft Windows Media SDK, or Apple QuickTime SDK
+(or a modified version of those libraries),
+containing parts covered by the terms of the Bink SDK EULA, 3ds Max EULA,
+PhysX SDK EULA, DirectX SDK EULA, OpenSSL and SSLeay licenses, IJG
+JPEG Library README, Windows Media SDK EULA, or QuickTime SDK EULA, the
+licensors of this Program grant you additional
+permission to convey the resulting work. Corresponding Source for a
+non-source form of such a combination shall include the source code for
+the parts of OpenSSL and IJG JPEG Library used as well as that of the covered
+work.
+
+You can contact Cyan Worlds, Inc. by email legal@cyan.com
+ or by snail mail at:
+      Cyan Worlds, Inc.
+      14617 N Newport Hwy
+      Mead, WA   99021
+
+*==LICENSE==*/
+
+#include "plProfileTrace.h"
+
+#include "hsLockFreeQueue.h"
+#include "hsLockGuard.h"
+#include "hsStream.h"
+#include "hsThread.h"
+#include "hsTimer.h"
+
+#include <string_theory/format>
+#include <string_theory/string_stream>
+#include <utility>
+
+struct plProfileTrace::ThreadBuffer
+{
+    hsLockFreeQueue<Event>  fQueue;
+    uint32_t                fThread;
+    ST::string              fName;
+    std::atomic<uint32_t>   fDropped;
+    std::atomic<bool>       fExited;    // Set once the thread is gone and can't push any more
+
+    ThreadBuffer(uint32_t thread, ST::string name)
+        : fQueue(kEventsPerThread), fThread(thread), fName(std::move(name)), fDropped(0), fExited(false)
+    { }
+};
+
+std::atomic<bool> plProfileTrace::sTracing(false);
+
+plProfileTrace::plProfileTrace()
+    : fNextThread(), fStartTicks(), fFramesLeft(), fFrame()
+{
+}
+
+plProfileTrace::~plProfileTrace()
+{
+    sTracing = false;
+}
+
+plProfileTrace& plProfileTrace::Instance()
+{
+    static plProfileTrace theInstance;
+    return theInstance;
+}
+
+plProfileTrace::ThreadBuffer* plProfileTrace::IGetThreadBuffer()
+{
+    // A thread keeps its buffer from one trace to the next. When the thread
+    // exits, this flags the buffer so the next collection can free it.
+    struct BufferOwner
+    {
+        ThreadBuffer* fBuffer = nullptr;
+
+        ~BufferOwner()
+        {
+            if (fBuffer)
+                fBuffer->fExited.store(true, std::memory_order_release);
+        }
+    };
+
+    static thread_local BufferOwner owner;
+    if (owner.fBuffer)
+        return owner.fBuffer;
+
+    plProfileTrace& trace = Instance();
+    hsLockGuard(trace.fBufferMutex);
+
+    uint32_t thread = trace.fNextThread++;
+    ST::string name = hsThread::GetThisThreadName();
+    if (name.empty())
+        name = thread == 0 ? ST_LITERAL("Main") : ST::format("Thread {}", thread);
+
+    trace.fBuffers.emplace_back(std::make_unique<ThreadBuffer>(thread, std::move(name)));
+    owner.fBuffer = trace.fBuffers.back().get();
+    return owner.fBuffer;
+}
+
+void plProfileTrace::IRecord(const char* name, const char* category, char phase)
+{
+    ThreadBuffer* buffer = IGetThreadBuffer();
+    if (!buffer->fQueue.push(Event{ name, category, hsTimer::GetTicks(), phase }))
+        buffer->fDropped.fetch_add(1, std::memory_order_relaxed);
+}
+
+void plProfileTrace::ICollect(bool keep)
+{
+    hsLockGuard(fBufferMutex);
+    for (auto it = fBuffers.begin(); it != fBuffers.end(); ) {
+        ThreadBuffer* buffer = it->get();
+
+        // Checked before draining, so that an exited thread's last events
+        // are all in the queue by the time we empty it
+        bool exited = buffer->fExited.load(std::memory_order_acquire);
+
+        Event event;
+        while (buffer->fQueue.pop(event)) {
+            if (keep)
+                fEvents.push_back(TimelineEvent{ event, buffer->fThread });
+        }
+
+        if (exited) {
+            // Its events may still be part of this trace, so keep what
+            // IWrite and GetDroppedEvents need to know about it
+            fExitedThreads.push_back(ExitedThread{ buffer->fThread, buffer->fName,
+                                                   buffer->fDropped.load(std::memory_order_relaxed) });
+            it = fBuffers.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+bool plProfileTrace::Start(uint32_t numFrames, const plFileName& fileName)
+{
+    if (IsTracing())
+        return false;
+
+    // Make sure the thread we were started from is the first one listed
+    IGetThreadBuffer();
+
+    // Throw away anything left over from the last trace
+    ICollect(false);
+    {
+        hsLockGuard(fBufferMutex);
+        for (const auto& buffer : fBuffers)
+            buffer->fDropped = 0;
+        fExitedThreads.clear();
+    }
+    fEvents.clear();
+
+    fFileName = fileName;
+    fFramesLeft = numFrames;
+    fFrame = 0;
+    fStartTicks = hsTimer::GetTicks();
+
+    sTracing = true;
+    return true;
+}
+
+bool plProfileTrace::Stop()
+{
+    if (!IsTracing())
+        return false;
+
+    sTracing = false;
+    ICollect(true);
+
+    bool result = IWrite();
+    fEvents.clear();
+    fEvents.shrink_to_fit();
+    return result;
+}
+
+void plProfileTrace::EndFrame()
+{
+    if (!IsTracing())
+        return;
+
+    IRecord("Frame", "Frame", 'i');
+    ICollect(true);
+    fFrame++;
+
+    if (fFramesLeft > 0 && --fFramesLeft == 0) {
+        if (Stop())
+            hsStatusMessageF("Wrote {} frame profile trace to {}", fFrame, fFileName);
+        else
+            hsStatusMessageF("Failed to write profile trace to {}", fFileName);
+    }
+}
+
+uint32_t plProfileTrace::GetDroppedEvents()
+{
+    hsLockGuard(fBufferMutex);
+    uint32_t dropped = 0;
+    for (const auto& buffer : fBuffers)
+        dropped += buffer->fDropped.load(std::memory_order_relaxed);
+    for (const ExitedThread& thread : fExitedThreads)
+        dropped += thread.fDropped;
+    return dropped;
+}
+
+static void IWriteJsonString(ST::string_stream& out, const char* str)
+{
+    out << '"';
+    for (; *str; ++str) {
+        if (*str == '"' || *str == '\\')
+            out << '\\';
+        if ((unsigned char)*str >= 0x20)
+            out << *str;
+    }
+    out << '"';
+}
+
+bool plProfileTrace::IWrite()
+{
+    // Other threads can still be registering their buffers while we write,
+    // so take our own copy of the thread names.
+    std::vector<std::pair<uint32_t, ST::string>> threads;
+    {
+        hsLockGuard(fBufferMutex);
+        threads.reserve(fExitedThreads.size() + fBuffers.size());
+        for (const ExitedThread& thread : fExitedThreads)
+            threads.emplace_back(thread.fThread, thread.fName);
+        for (const auto& buffer : fBuffers)
+            threads.emplace_back(buffer->fThread, buffer->fName);
+    }
+
+    hsUNIXStream stream;
+    if (!stream.Open(fFileName, "wt"))
+        return false;
+
+    ST::string_stream json;
+    auto flush = [&stream, &json](size_t threshold) {
+        if (json.size() >= threshold) {
+            stream.Write(json.size(), json.raw_buffer());
+            json.truncate();
+        }
+    };
+
+    json << "{\"traceEvents\":[\n";
+
+    // Name each thread's row
+    bool first = true;
+    for (const auto& thread : threads) {
+        if (!first)
+            json << ",\n";
+        first = false;
+        json << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << thread.first
+             << ",\"args\":{\"name\":";
+        IWriteJsonString(json, thread.second.c_str());
+        json << "}}";
+    }
+
+    for (const TimelineEvent& event : fEvents) {
+        double micros = event.fEvent.fTicks > fStartTicks
+                      ? hsTimer::GetSeconds<double>(event.fEvent.fTicks - fStartTicks) * 1000000.0
+                      : 0.0;
+
+        if (!first)
+            json << ",\n";
+        first = false;
+        json << "{\"name\":";
+        IWriteJsonString(json, event.fEvent.fName);
+        json << ",\"cat\":";
+        IWriteJsonString(json, event.fEvent.fCategory);
+        json << ",\"ph\":\"" << event.fEvent.fPhase << "\"";
+        if (event.fEvent.fPhase == 'i')
+            json << ",\"s\":\"g\"";
+        json << ST::format(",\"ts\":{.3f},\"pid\":1,\"tid\":{}}", micros, event.fThread);
+
+        flush(64 * 1024);
+    }
+
+    json << "\n],\"displayTimeUnit\":\"ms\"}\n";
+    flush(0);
+
+    return true;
+}
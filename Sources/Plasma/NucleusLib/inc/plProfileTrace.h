@@ -0,0 +1,168 @@
+/*==LICENSE==*
+
+CyanWorlds.com Engine - MMOG client, server and tools
+Copyright (C) 2011  Cyan Worlds, Inc.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+Additional permissions under GNU GPL version 3 section 7
+
+If you modify this Program, or any covered work, by linking or
+combining it with any of RAD Game Tools Bink SDK, Autodesk 3ds Max SDK,
+NVIDIA PhysX SDK, Microsoft DirectX SDK, OpenSSL library, Independent
+JPEG Group JPEG library, Microsoft Windows Media SDK, or Apple QuickTime SDK
+(or a modified version of those libraries),
+containing parts covered by the terms of the Bink SDK EULA, 3ds Max EULA,
+PhysX SDK EULA, DirectX SDK EULA, OpenSSL and SSLeay licenses, IJG
+JPEG Library README, Windows Media SDK EULA, or QuickTime SDK EULA, the
+licensors of this Program grant you additional
+permission to convey the resulting work. Corresponding Source for a
+non-source form of such a combination shall include the source code for
+the parts of OpenSSL and IJG JPEG Library used as well as that of the covered
+work.
+
+You can contact Cyan Worlds, Inc. by email legal@cyan.com
+ or by snail mail at:
+      Cyan Worlds, Inc.
+      14617 N Newport Hwy
+      Mead, WA   99021
+
+*==LICENSE==*/
+
+#ifndef plProfileTrace_h_inc
+#define plProfileTrace_h_inc
+
+#include "HeadSpin.h"
+#include "plFileSystem.h"
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+//
+// Timeline tracing for plProfile.
+//
+// While a trace is running, every plProfileVar timing (and every
+// plProfile_TraceScope) records a begin and an end event, along with the
+// thread it happened on, into a small lock-free buffer owned by that thread.
+// The main thread collects those buffers every frame, freeing the ones whose
+// threads have exited, and when the trace stops the whole thing is written
+// out as Chrome trace-event JSON, which can be opened in chrome://tracing
+// or https://ui.perfetto.dev.
+//
+// Names and categories are stored as raw pointers, so they must stay valid
+// for the life of the process (string literals or plProfileVar names).
+//
+
+class plProfileTrace
+{
+public:
+    enum
+    {
+        kEventsPerThread = 16384,   // Events a thread can record between collections
+    };
+
+protected:
+    struct Event
+    {
+        const char* fName;
+        const char* fCategory;
+        uint64_t    fTicks;
+        char        fPhase;
+    };
+
+    struct ThreadBuffer;
+
+    struct TimelineEvent
+    {
+        Event       fEvent;
+        uint32_t    fThread;
+    };
+
+    // A thread that went away during this trace, after its buffer was freed
+    struct ExitedThread
+    {
+        uint32_t    fThread;
+        ST::string  fName;
+        uint32_t    fDropped;
+    };
+
+    static std::atomic<bool> sTracing;
+
+    std::mutex                                  fBufferMutex;
+    std::vector<std::unique_ptr<ThreadBuffer>>  fBuffers;
+    std::vector<ExitedThread>                   fExitedThreads;
+    uint32_t                                    fNextThread;
+
+    std::vector<TimelineEvent>  fEvents;
+    plFileName                  fFileName;
+    uint64_t                    fStartTicks;
+    uint32_t                    fFramesLeft;
+    uint32_t                    fFrame;
+
+    plProfileTrace();
+
+    static ThreadBuffer* IGetThreadBuffer();
+    static void IRecord(const char* name, const char* category, char phase);
+
+    void ICollect(bool keep);
+    bool IWrite();
+
+public:
+    ~plProfileTrace();
+
+    static plProfileTrace& Instance();
+
+    static bool IsTracing() { return sTracing.load(std::memory_order_relaxed); }
+
+    static void Begin(const char* name, const char* category) { if (IsTracing()) IRecord(name, category, 'B'); }
+    static void End(const char* name, const char* category) { if (IsTracing()) IRecord(name, category, 'E'); }
+
+    // Start recording. If numFrames is zero, the trace runs until Stop().
+    bool Start(uint32_t numFrames, const plFileName& fileName);
+
+    // Stop recording and write the trace file
+    bool Stop();
+
+    // Called by plProfileManager at the end of each frame on the main thread
+    void EndFrame();
+
+    const plFileName& GetFileName() const { return fFileName; }
+
+    // Events that didn't fit in their thread's buffer during the last trace
+    uint32_t GetDroppedEvents();
+};
+
+class plProfileTrace_ScopeGuard
+{
+    const char* fName;
+
+public:
+    plProfileTrace_ScopeGuard(const char* name)
+        : fName(name)
+    {
+        plProfileTrace::Begin(fName, "Trace");
+    }
+
+    plProfileTrace_ScopeGuard(const plProfileTrace_ScopeGuard&) = delete;
+    plProfileTrace_ScopeGuard(plProfileTrace_ScopeGuard&&) = delete;
+
+    ~plProfileTrace_ScopeGuard()
+    {
+        plProfileTrace::End(fName, "Trace");
+    }
+};
+
+#endif // plProfileTrace_h_inc
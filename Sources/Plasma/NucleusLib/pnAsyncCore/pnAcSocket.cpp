@@ -54,6 +54,7 @@ You can contact Cyan Worlds, Inc. by email legal@cyan.com
 #include "hsThread.h"
 #include "hsTimer.h"
 #include "hsWindows.h"
+#include "plProfile.h"
 
 // Must include asio after hsWindows.h so asio sees our definition of _WIN32_WINNT!
 #include <asio/executor_work_guard.hpp>
@@ -241,6 +242,7 @@ static void SocketStartAsyncRead(AsyncSocket sock)
         size_t bytesNotified = sock->fBytesLeft;
         std::optional<size_t> res;
         if (sock->fCallbacks) {
+            plProfile_TraceScope("Socket Read");
             res = sock->fCallbacks->AsyncNotifySocketRead(sock, sock->fBuffer, bytesNotified);
         }
         if (!res) {
@@ -544,12 +544,8 @@ void plDispatch::MsgQueueProcess()
 
 void plDispatch::RegisterForType(uint16_t hClass, const plKey& receiver)
 {
-    int i;
-    for( i = 0; i < plFactory::GetNumClasses(); i++ )
-    {
-        if( plFactory::DerivesFrom(hClass, i) )
-            RegisterForExactType(i, receiver);
-    }
+    for (uint16_t derived : plFactory::GetDerivedClasses(hClass))
+        RegisterForExactType(derived, receiver);
 }
 
 void plDispatch::RegisterForExactType(uint16_t hClass, const plKey& receiver)
@@ -571,10 +567,10 @@ void plDispatch::RegisterForExactType(uint16_t hClass, const plKey& receiver)
 
 void plDispatch::UnRegisterForType(uint16_t hClass, const plKey& receiver)
 {
-    for (size_t i = 0; i < fRegisteredExactTypes.size(); i++)
+    for (uint16_t derived : plFactory::GetDerivedClasses(hClass))
     {
-        if (plFactory::DerivesFrom(hClass, uint16_t(i)))
-            IUnRegisterForExactType(uint16_t(i), receiver);
+        if (derived < fRegisteredExactTypes.size())
+            IUnRegisterForExactType(derived, receiver);
     }
 }
 
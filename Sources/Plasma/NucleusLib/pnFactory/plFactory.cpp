@@ -55,6 +55,7 @@ You can contact Cyan Worlds, Inc. by email legal@cyan.com
 static plFactory*   theFactory = nullptr;
 
 plFactory::plFactory()
+    : fRowWords(), fAncestryDirty(true)
 {
     fCreators.resize(plCreatableIndex::plNumClassIndices);
 }
@@ -100,9 +101,63 @@ uint16_t plFactory::IRegister(uint16_t hClass, plCreator* worker)
 {
     delete fCreators[hClass];
     fCreators[hClass] = worker;
+    fAncestryDirty.store(true, std::memory_order_release);
     return hClass;
 }
 
+// Registration all happens up front (static init, or a DLL registering its
+// externals), so this only really runs once or twice.
+void plFactory::IBuildAncestry()
+{
+    std::lock_guard<std::mutex> lock(fAncestryMutex);
+    if (!fAncestryDirty.load(std::memory_order_relaxed))
+        return;
+
+    const size_t numClasses = fCreators.size();
+    fBaseColumns.assign(numClasses, kNoColumn);
+    fSelfBase.assign(numClasses, false);
+    fDerived.assign(numClasses, {});
+
+    // Ask every class about every other class once. Almost all the answers
+    // are no, so the derived lists are all we keep from this pass.
+    uint16_t numColumns = 0;
+    for (size_t hDer = 0; hDer < numClasses; hDer++)
+    {
+        plCreator* creator = fCreators[hDer];
+        if (!creator)
+            continue;
+
+        for (size_t hBase = 0; hBase < numClasses; hBase++)
+        {
+            if (!creator->HasBaseClass(uint16_t(hBase)))
+                continue;
+
+            fDerived[hBase].emplace_back(uint16_t(hDer));
+            if (hBase == hDer)
+                fSelfBase[hDer] = true;
+            else if (fBaseColumns[hBase] == kNoColumn)
+                fBaseColumns[hBase] = numColumns++;
+        }
+    }
+
+    fRowWords = (numColumns + 63) / 64;
+    fAncestry.assign(numClasses * fRowWords, 0);
+    for (size_t hBase = 0; hBase < numClasses; hBase++)
+    {
+        uint16_t col = fBaseColumns[hBase];
+        if (col == kNoColumn)
+            continue;
+
+        for (uint16_t hDer : fDerived[hBase])
+        {
+            if (hDer != hBase)
+                fAncestry[hDer * fRowWords + (col >> 6)] |= uint64_t(1) << (col & 63);
+        }
+    }
+
+    fAncestryDirty.store(false, std::memory_order_release);
+}
+
 //
 // return true if creator exists
 //
@@ -148,6 +203,7 @@ void plFactory::UnRegister(uint16_t hClass, plCreator* worker)
 void plFactory::IUnRegister(uint16_t hClass)
 {
     fCreators[hClass] = nullptr;
+    fAncestryDirty.store(true, std::memory_order_release);
 }
 
 uint16_t plFactory::Register(uint16_t hClass, plCreator* worker)
@@ -179,10 +235,17 @@ uint16_t plFactory::GetNumClasses()
 
 bool plFactory::IDerivesFrom(uint16_t hBase, uint16_t hDer)
 {
-    if (hDer >= fCreators.size())
+    if (hDer >= fCreators.size() || hBase >= fCreators.size())
         return false;
 
-    return fCreators[hDer] ? fCreators[hDer]->HasBaseClass(hBase) : false;
+    IUpdateAncestry();
+    if (hBase == hDer)
+        return fSelfBase[hDer];
+
+    uint16_t col = fBaseColumns[hBase];
+    if (col == kNoColumn)
+        return false;
+    return (fAncestry[hDer * fRowWords + (col >> 6)] & (uint64_t(1) << (col & 63))) != 0;
 }
 
 bool plFactory::DerivesFrom(uint16_t hBase, uint16_t hDer)
@@ -193,6 +256,25 @@ bool plFactory::DerivesFrom(uint16_t hBase, uint16_t hDer)
     return theFactory->IDerivesFrom(hBase, hDer);
 }
 
+const std::vector<uint16_t>& plFactory::IGetDerivedClasses(uint16_t hBase)
+{
+    static const std::vector<uint16_t> kNone;
+    if (hBase >= fCreators.size())
+        return kNone;
+
+    IUpdateAncestry();
+    return fDerived[hBase];
+}
+
+const std::vector<uint16_t>& plFactory::GetDerivedClasses(uint16_t hBase)
+{
+    static const std::vector<uint16_t> kNone;
+    if( !theFactory && !ICreateTheFactory() )
+        return kNone;
+
+    return theFactory->IGetDerivedClasses(hBase);
+}
+
 // slow lookup for things like console
 uint16_t plFactory::FindClassIndex(const char* className)
 {
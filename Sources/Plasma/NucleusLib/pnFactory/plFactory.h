@@ -46,6 +46,8 @@ You can contact Cyan Worlds, Inc. by email legal@cyan.com
 #include "hsRefCnt.h"
 #include "HeadSpin.h"
 
+#include <atomic>
+#include <mutex>
 #include <vector>
 
 class plCreator;
@@ -58,6 +60,28 @@ class plFactory : public hsRefCnt
 private:
     std::vector<plCreator*> fCreators;
 
+    // Ancestry table, answering HasBaseClass() for every registered class
+    // without walking the class chain. Each class gets a row with a bit for
+    // every class that's a base of something else, and every base gets the
+    // list of classes derived from it. Rebuilt on first use after anybody
+    // (un)registers, which in practice means once at startup.
+    static constexpr uint16_t kNoColumn = 0xFFFF;
+
+    std::vector<uint16_t>   fBaseColumns;   // class index -> bit in the rows
+    std::vector<uint64_t>   fAncestry;
+    size_t                  fRowWords;
+    std::vector<bool>       fSelfBase;      // HasBaseClass(own index)
+    std::vector<std::vector<uint16_t>> fDerived;
+    std::atomic<bool>       fAncestryDirty;
+    std::mutex              fAncestryMutex;
+
+    void                IBuildAncestry();
+    void                IUpdateAncestry()
+    {
+        if (fAncestryDirty.load(std::memory_order_acquire))
+            IBuildAncestry();
+    }
+
     void                IForceShutdown();
     void                IUnRegister(uint16_t hClass);
     uint16_t              IRegister(uint16_t hClass, plCreator* worker);
@@ -65,6 +89,7 @@ private:
     uint16_t              IGetNumClasses();
     plCreatable*        ICreate(uint16_t hClass);
     bool                IDerivesFrom(uint16_t hBase, uint16_t hDer);
+    const std::vector<uint16_t>& IGetDerivedClasses(uint16_t hBase);
     bool                IIsValidClassIndex(uint16_t hClass);
 
     static bool         ICreateTheFactory();
@@ -86,6 +111,10 @@ public:
 
     static bool         DerivesFrom(uint16_t hBase, uint16_t hDer);
 
+    // Every registered class that DerivesFrom(hBase), including hBase itself.
+    // Only good until the next (un)registration.
+    static const std::vector<uint16_t>& GetDerivedClasses(uint16_t hBase);
+
     static uint16_t       GetNumClasses();
 
     static uint16_t       FindClassIndex(const char* className);      // slow lookup for things like console
@@ -43,6 +43,7 @@ You can contact Cyan Worlds, Inc. by email legal@cyan.com
 #include "HeadSpin.h"
 #include "plFileSystem.h"
 #include "hsStream.h"
+#include "plProfile.h"
 
 #include "plSoundBuffer.h"
 #include "plSrtFileReader.h"
@@ -111,6 +112,8 @@ void plSoundPreloader::Run()
 
                 if (buf->GetData())
                 {
+                    plProfile_TraceScope("Sound Preload");
+
                     plFileName srcFilename = buf->GetFileName();
                     reader = CreateReader(true, srcFilename, buf->GetAudioReaderType(), buf->GetReaderSelect());
                     
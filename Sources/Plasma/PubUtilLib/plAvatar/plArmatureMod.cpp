@@ -641,7 +641,7 @@ plArmatureMod::plArmatureMod()
       fPendingSynch(), fOpaque(true), fPhysHeight(), fPhysWidth(), fUpdateMsg(),
       fRootName(), fDontPanicLink(), fBodyAgeName("GlobalAvatars"_st),
       fBodyFootstepSoundPage("Audio"_st), fAnimationPrefix("Male"_st), fUserStr(),
-      fUnconsumedJump(), fLastSynch()
+      fUnconsumedJump(), fLastSynch(), fSkippedEvalTime()
 {
     fWaitFlags |= kNeedAudio | kNeedCamera | kNeedSpawn;
 }
@@ -1538,6 +1538,22 @@ void plArmatureMod::ILinkToPersonalAge()
     pMsg->Send();
 }
 
+// Avatars outside the local player's interest only run their brains this often
+#define kIgnoredEvalInterval 0.5f
+
+// We can't see or touch an avatar outside our interest, so there's no point
+// animating it every frame. Just keep its brains ticking over, and hand them
+// all the time they sat out when they do get a turn.
+void plArmatureMod::IEvalBrains(double time, float elapsed, uint32_t dirty, bool ignored)
+{
+    fSkippedEvalTime += elapsed;
+    if (!ignored || fSkippedEvalTime >= kIgnoredEvalInterval)
+    {
+        plArmatureModBase::IEval(time, fSkippedEvalTime, dirty);
+        fSkippedEvalTime = 0.f;
+    }
+}
+
 bool plArmatureMod::IEval(double time, float elapsed, uint32_t dirty)
 {
     if (IsFinal())
@@ -1545,6 +1561,7 @@ bool plArmatureMod::IEval(double time, float elapsed, uint32_t dirty)
         bool noOverlap = false;
 
         const plArmatureMod *localPlayer = plAvatarMgr::GetInstance()->GetLocalAvatar();
+        plRelevanceInterest& interest = plRelevanceMgr::Instance()->GetInterest();
         if (plRelevanceMgr::Instance()->GetEnabled() && (localPlayer != nullptr))
         {
             // (May decide to update this elsewhere instead.)
@@ -1579,6 +1596,15 @@ bool plArmatureMod::IEval(double time, float elapsed, uint32_t dirty)
                 }
             }
         }
+
+        // Remote players are who our own synchs get sent for, so keep track of
+        // where they are and what they care about.
+        if (localPlayer != nullptr && localPlayer != this &&
+            plNetClientApp::GetInstance()->IsRemotePlayerKey(GetTarget(0)->GetKey()))
+        {
+            interest.SetViewer(GetKey()->GetUoid().GetClonePlayerID(),
+                               GetTarget(0)->GetLocalToWorld().GetTranslate(), fRegionsICareAbout);
+        }
         
         if (noOverlap)
         {
@@ -1595,7 +1621,7 @@ bool plArmatureMod::IEval(double time, float elapsed, uint32_t dirty)
             SetInputFlag(A_CONTROL_TURN, false);
         
         if (!fMidLink)
-            plArmatureModBase::IEval(time, elapsed, dirty);
+            IEvalBrains(time, elapsed, dirty, noOverlap && interest.GetEnabled());
         
         fUpdateMsg->Ref();
         fUpdateMsg->Send();
@@ -1693,6 +1719,9 @@ void plArmatureMod::RemoveTarget(plSceneObject* so)
     delete fAvatarPhysicalSDLMod;
     fAvatarPhysicalSDLMod = nullptr;
 
+    if (plRelevanceMgr::Instance())
+        plRelevanceMgr::Instance()->GetInterest().RemoveViewer(GetKey()->GetUoid().GetClonePlayerID());
+
     plArmatureModBase::RemoveTarget(so);
 }
 
@@ -1921,9 +1950,19 @@ const plSceneObject *plArmatureMod::GetClothingSO(uint8_t lod) const
 
 #define kSynchInterval 1    // synch once per second
 
+float plArmatureMod::IGetSynchInterval() const
+{
+    // Nobody nearby who cares? Then we can afford to synch less often.
+    plRelevanceMgr* mgr = plRelevanceMgr::Instance();
+    if (!mgr || !GetTarget(0))
+        return kSynchInterval;
+
+    return mgr->GetInterest().GetSynchInterval(GetTarget(0)->GetLocalToWorld().GetTranslate(), fRegionsImIn);
+}
+
 void plArmatureMod::NetworkSynch(double timeNow, int force)
 {
-    if (force || ((timeNow - fLastSynch) > kSynchInterval))
+    if (force || ((timeNow - fLastSynch) > IGetSynchInterval()))
     {
         // make sure state change gets sent out over the network
         // avatar state should use relevance region filtering
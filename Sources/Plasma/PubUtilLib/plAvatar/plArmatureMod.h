@@ -380,6 +380,8 @@ protected:
     void ISetupMarkerCallbacks(plATCAnim *anim, plAnimTimeConvert *atc) override;
     
     void    NetworkSynch(double timeNow, int force = 0);
+    float   IGetSynchInterval() const;
+    void    IEvalBrains(double time, float elapsed, uint32_t dirty, bool ignored);
     bool    IHandleControlMsg(plControlEventMsg* pMsg);
     void    IFireBehaviorNotify(uint32_t type, bool behaviorStart = true);
     void    IHandleInputStateMsg(plAvatarInputStateMsg *msg);
@@ -417,6 +419,7 @@ protected:
     plAGModifier * fRootAGMod;
     plAvBoneMap * fBoneMap;                 // uses id codes to look up bones. set up by the brain as needed.
     double fLastSynch;
+    float fSkippedEvalTime;     // Brain time we've held back while outside the local player's interest
     int fBodyType;
     plClothingOutfit *fClothingOutfit;
     plClothingSDLModifier *fClothingSDLMod;
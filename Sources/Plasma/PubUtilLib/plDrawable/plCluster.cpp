@@ -89,38 +89,36 @@ void plCluster::Write(hsStream* s) const
     }
 }
 
-inline void inlTESTPOINT(const hsPoint3& destP, 
-                         float& minX, float& minY, float& minZ, 
-                         float& maxX, float& maxY, float& maxZ)
+inline void inlTESTPOINT(const hsPoint3& destP, hsPoint3& mins, hsPoint3& maxs)
 {
-    if( destP.fX < minX )
-        minX = destP.fX;
-    else if( destP.fX > maxX )
-        maxX = destP.fX;
-
-    if( destP.fY < minY )
-        minY = destP.fY;
-    else if( destP.fY > maxY )
-        maxY = destP.fY;
-
-    if( destP.fZ < minZ )
-        minZ = destP.fZ;
-    else if( destP.fZ > maxZ )
-        maxZ = destP.fZ;
+    if( destP.fX < mins.fX )
+        mins.fX = destP.fX;
+    if( destP.fX > maxs.fX )
+        maxs.fX = destP.fX;
+
+    if( destP.fY < mins.fY )
+        mins.fY = destP.fY;
+    if( destP.fY > maxs.fY )
+        maxs.fY = destP.fY;
+
+    if( destP.fZ < mins.fZ )
+        mins.fZ = destP.fZ;
+    if( destP.fZ > maxs.fZ )
+        maxs.fZ = destP.fZ;
 }
 
 void plCluster::UnPack(uint8_t* vDst, uint16_t* iDst, int idxOffset, hsBounds3Ext& wBnd) const
 {
-    float minX = 1.e33f;
-    float minY = 1.e33f;
-    float minZ = 1.e33f;
-
-    float maxX = -1.e33f;
-    float maxY = -1.e33f;
-    float maxZ = -1.e33f;
+    hsPoint3 mins(1.e33f, 1.e33f, 1.e33f);
+    hsPoint3 maxs(-1.e33f, -1.e33f, -1.e33f);
 
     hsAssert(fGroup->GetTemplate(), "Can't unpack without a template");
     const plSpanTemplate& templ = *fGroup->GetTemplate();
+    const int numVerts = templ.NumVerts();
+    const int posOff = templ.PositionOffset();
+    const int normOff = templ.NormalOffset();
+    const int colOff = templ.ColorOffset();
+    const int stride = templ.Stride();
     for (size_t i = 0; i < fInsts.size(); i++)
     {
         // First, just copy our template, offsetting by prescribed amount.
@@ -132,7 +130,7 @@ void plCluster::UnPack(uint8_t* vDst, uint16_t* iDst, int idxOffset, hsBounds3Ex
             iDst++;
             iSrc++;
         }
-        idxOffset += templ.NumVerts();
+        idxOffset += numVerts;
 
         memcpy(vDst, templ.VertData(), templ.VertSize());
 
@@ -140,70 +138,68 @@ void plCluster::UnPack(uint8_t* vDst, uint16_t* iDst, int idxOffset, hsBounds3Ex
         // a) Possibly adding a delta to the position.
         // b) Transforming the position and normal.
         // c) Possibly overwriting some (or all) of the color.
+        const bool perVert = GetInst(i).HasPosDelta() || GetInst(i).HasColor();
 
         // If we have individual position and/or color info, apply
-        // it, along with the transform.
-        if( GetInst(i).HasPosDelta() || GetInst(i).HasColor() )
+        // it before the transform.
+        if( perVert )
         {
-            const int posOff = templ.PositionOffset();
-            const int normOff = templ.NormalOffset();
-            const int colOff = templ.ColorOffset();
-            const int stride = templ.Stride();
-
-            const hsMatrix44 l2w = GetInst(i).LocalToWorld();
-            hsMatrix44 w2l;
-            GetInst(i).WorldToLocal().GetTranspose(&w2l);
-            
-            plSpanInstanceIter iter(fInsts[i], fEncoding, templ.NumVerts());
-            const int numVerts = templ.NumVerts();
+            plSpanInstanceIter iter(fInsts[i], fEncoding, numVerts);
+            uint8_t* v = vDst;
             int iVert;
             for( iVert = 0, iter.Begin(); iVert < numVerts; iVert++, iter.Advance() )
             {
-                hsPoint3* pos = (hsPoint3*)(vDst + posOff);
+                hsPoint3* pos = (hsPoint3*)(v + posOff);
                 *pos = iter.Position(*pos);
-                *pos = l2w * *pos;
-                inlTESTPOINT(*pos, minX, minY, minZ, maxX, maxY, maxZ);
-
-                hsVector3* norm = (hsVector3*)(vDst + normOff);
-                *norm = w2l * *norm;
-                hsFastMath::NormalizeAppr(*norm);
 
-                uint32_t* color = (uint32_t*)(vDst + colOff);
+                uint32_t* color = (uint32_t*)(v + colOff);
                 *color = iter.Color(*color);
 
-                vDst += stride;
+                v += stride;
             }
         }
-        else
-        {
-            // Just transform the position and normal.
-            const int posOff = templ.PositionOffset();
-            const int normOff = templ.NormalOffset();
-            const int stride = templ.Stride();
-            
-            const hsMatrix44 l2w = GetInst(i).LocalToWorld();
-            hsMatrix44 w2l;
-            GetInst(i).WorldToLocal().GetTranspose(&w2l);
-            
-            const int numVerts = templ.NumVerts();
-            int iVert;
-            for( iVert = 0; iVert < numVerts; iVert++ )
-            {
-                hsPoint3* pos = (hsPoint3*)(vDst + posOff);
-                *pos = l2w * *pos;
-                inlTESTPOINT(*pos, minX, minY, minZ, maxX, maxY, maxZ);
 
-                hsVector3* norm = (hsVector3*)(vDst + normOff);
-                *norm = w2l * *norm;
+        const hsMatrix44 l2w = GetInst(i).LocalToWorld();
+        hsMatrix44 w2l;
+        GetInst(i).WorldToLocal().GetTranspose(&w2l);
+
+        transform_verts.call(vDst, numVerts, stride, posOff, normOff, l2w, w2l, mins, maxs);
 
-                vDst += stride;
+        if( perVert )
+        {
+            uint8_t* v = vDst;
+            for (int iVert = 0; iVert < numVerts; iVert++)
+            {
+                hsFastMath::NormalizeAppr(*(hsVector3*)(v + normOff));
+                v += stride;
             }
         }
+
+        vDst += templ.VertSize();
     }
-    hsPoint3 min(minX, minY, minZ);
-    wBnd.Reset(&min);
-    hsPoint3 max(maxX, maxY, maxZ);
-    wBnd.Union(&max);
+    wBnd.Reset(&mins);
+    wBnd.Union(&maxs);
 }
 
+void plCluster::transform_verts_fpu(uint8_t* vDst, size_t count, size_t stride, size_t posOff, size_t normOff,
+                                    const hsMatrix44& l2w, const hsMatrix44& nrmXform, hsPoint3& mins, hsPoint3& maxs)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        hsPoint3* pos = (hsPoint3*)(vDst + posOff);
+        *pos = l2w * *pos;
+        inlTESTPOINT(*pos, mins, maxs);
+
+        hsVector3* norm = (hsVector3*)(vDst + normOff);
+        *norm = nrmXform * *norm;
+
+        vDst += stride;
+    }
+}
 
+// CPU-optimized functions requiring dispatch
+hsCpuFunctionDispatcher<plCluster::transform_verts_ptr> plCluster::transform_verts {
+    &plCluster::transform_verts_fpu,
+    nullptr,            // SSE1
+    &plCluster::transform_verts_sse2
+};
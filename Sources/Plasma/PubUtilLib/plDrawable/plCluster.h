@@ -46,6 +46,7 @@ You can contact Cyan Worlds, Inc. by email legal@cyan.com
 
 #include <vector>
 
+#include "hsCpuID.h"
 #include "plClusterGroup.h"
 #include "plSpanInstance.h"
 
@@ -57,6 +58,8 @@ class plLightInfo;
 class plSpanTemplate;
 class plVisRegion;
 class hsBounds3Ext;
+struct hsMatrix44;
+struct hsPoint3;
 
 class plCluster
 {
@@ -86,8 +89,22 @@ public:
     size_t NumInsts() const { return fInsts.size(); }
     const plSpanInstance& GetInst(size_t i) const { return *fInsts[i]; }
 
+    // Only touches the cluster's own instances and the buffers handed in,
+    // so different clusters can be unpacked on different threads at once.
     void UnPack(uint8_t* vDst, uint16_t* iDst, int idxOffset, hsBounds3Ext& wBnd) const;
 
+    //// CPU-optimized instance transform ////
+    // Transforms count interleaved positions by l2w and normals by nrmXform,
+    // growing [mins, maxs] around the new positions. Both versions round just
+    // like hsMatrix44's operators do, so the verts come out the same.
+    typedef void(*transform_verts_ptr)(uint8_t* vDst, size_t count, size_t stride, size_t posOff, size_t normOff,
+                                       const hsMatrix44& l2w, const hsMatrix44& nrmXform, hsPoint3& mins, hsPoint3& maxs);
+    static hsCpuFunctionDispatcher<transform_verts_ptr> transform_verts;
+    static void transform_verts_fpu(uint8_t* vDst, size_t count, size_t stride, size_t posOff, size_t normOff,
+                                    const hsMatrix44& l2w, const hsMatrix44& nrmXform, hsPoint3& mins, hsPoint3& maxs);
+    static void transform_verts_sse2(uint8_t* vDst, size_t count, size_t stride, size_t posOff, size_t normOff,
+                                     const hsMatrix44& l2w, const hsMatrix44& nrmXform, hsPoint3& mins, hsPoint3& maxs);
+
     // Getters and setters, mostly for export construction.
     const plSpanTemplate* GetTemplate() const { return fGroup->GetTemplate(); }
 
@@ -61,10 +61,15 @@ You can contact Cyan Worlds, Inc. by email legal@cyan.com
 #include "hsBitVector.h"
 #include "hsStream.h"
 #include "hsResMgr.h"
+#include "plProfile.h"
 
 //STUB
 #include "plgDispatch.h"
 
+// Running totals, since it all happens during age load
+plProfile_CreateTimerNoReset("UnPack", "Clusters", ClusterUnPack);
+plProfile_CreateCounterNoReset("Instances", "Clusters", ClusterInsts);
+
 plClusterGroup::plClusterGroup()
 :   fTemplate(),
     fMaterial(),
@@ -289,6 +294,9 @@ bool plClusterGroup::MsgReceive(plMessage* msg)
 
 void plClusterGroup::UnPack()
 {
+    plProfile_TimingGuard(ClusterUnPack);
+    plProfile_IncCount(ClusterInsts, NumInst());
+
     plDrawableSpans* drawable = new plDrawableSpans;
     fDrawable = hsgResMgr::ResMgr()->NewKey(GetKey()->GetName(), drawable, GetKey()->GetUoid().GetLocation());
     drawable->UnPackCluster(this);
@@ -0,0 +1,140 @@
+/*==LICENSE==*
+
+CyanWorlds.com Engine - MMOG client, server and tools
+Copyright (C) 2011  Cyan Worlds, Inc.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+Additional permissions under GNU GPL version 3 section 7
+
+If you modify this Program, or any covered work, by linking or
+combining it with any of RAD Game Tools Bink SDK, Autodesk 3ds Max SDK,
+NVIDIA PhysX SDK, Microsoft DirectX SDK, OpenSSL library, Independent
+JPEG Group JPEG library, Microsoft Windows Media SDK, or Apple QuickTime SDK
+(or a modified version of those libraries),
+containing parts covered by the terms of the Bink SDK EULA, 3ds Max EULA,
+PhysX SDK EULA, DirectX SDK EULA, OpenSSL and SSLeay licenses, IJG
+JPEG Library README, Windows Media SDK EULA, or QuickTime SDK EULA, the
+licensors of this Program grant you additional
+permission to convey the resulting work. Corresponding Source for a
+non-source form of such a combination shall include the source code for
+the parts of OpenSSL and IJG JPEG Library used as well as that of the covered
+work.
+
+You can contact Cyan Worlds, Inc. by email legal@cyan.com
+ or by snail mail at:
+      Cyan Worlds, Inc.
+      14617 N Newport Hwy
+      Mead, WA   99021
+
+*==LICENSE==*/
+
+#include "HeadSpin.h"
+#include "hsGeometry3.h"
+#include "hsMatrix44.h"
+#include "plCluster.h"
+
+#include <algorithm>
+
+#ifdef HAVE_SSE2
+#   include <emmintrin.h>
+#endif
+
+// Four verts per pass, with the products summed in the same order as
+// hsMatrix44::operator*(), so the results match to the bit.
+void plCluster::transform_verts_sse2(uint8_t* vDst, size_t count, size_t stride, size_t posOff, size_t normOff,
+                                     const hsMatrix44& l2w, const hsMatrix44& nrmXform, hsPoint3& mins, hsPoint3& maxs)
+{
+#ifdef HAVE_SSE2
+    // The operators leave everything alone for an identity, even -0 and
+    // infinities, which multiplying through wouldn't.
+    if ((l2w.fFlags | nrmXform.fFlags) & hsMatrix44::kIsIdent)
+    {
+        transform_verts_fpu(vDst, count, stride, posOff, normOff, l2w, nrmXform, mins, maxs);
+        return;
+    }
+
+    __m128 l[3][4], n[3][3];
+    for (int i = 0; i < 3; i++)
+    {
+        for (int j = 0; j < 4; j++)
+            l[i][j] = _mm_set1_ps(l2w.fMap[i][j]);
+        for (int j = 0; j < 3; j++)
+            n[i][j] = _mm_set1_ps(nrmXform.fMap[i][j]);
+    }
+
+    __m128 minX = _mm_set1_ps(mins.fX), minY = _mm_set1_ps(mins.fY), minZ = _mm_set1_ps(mins.fZ);
+    __m128 maxX = _mm_set1_ps(maxs.fX), maxY = _mm_set1_ps(maxs.fY), maxZ = _mm_set1_ps(maxs.fZ);
+
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4)
+    {
+        hsPoint3* p[4];
+        hsVector3* nm[4];
+        for (int j = 0; j < 4; j++)
+        {
+            p[j] = reinterpret_cast<hsPoint3*>(vDst + posOff);
+            nm[j] = reinterpret_cast<hsVector3*>(vDst + normOff);
+            vDst += stride;
+        }
+
+        __m128 x = _mm_set_ps(p[3]->fX, p[2]->fX, p[1]->fX, p[0]->fX);
+        __m128 y = _mm_set_ps(p[3]->fY, p[2]->fY, p[1]->fY, p[0]->fY);
+        __m128 z = _mm_set_ps(p[3]->fZ, p[2]->fZ, p[1]->fZ, p[0]->fZ);
+
+        alignas(16) float out[3][4];
+        for (int r = 0; r < 3; r++)
+        {
+            __m128 v = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(x, l[r][0]), _mm_mul_ps(y, l[r][1])),
+                                             _mm_mul_ps(z, l[r][2])), l[r][3]);
+            _mm_store_ps(out[r], v);
+        }
+        minX = _mm_min_ps(minX, _mm_load_ps(out[0]));
+        maxX = _mm_max_ps(maxX, _mm_load_ps(out[0]));
+        minY = _mm_min_ps(minY, _mm_load_ps(out[1]));
+        maxY = _mm_max_ps(maxY, _mm_load_ps(out[1]));
+        minZ = _mm_min_ps(minZ, _mm_load_ps(out[2]));
+        maxZ = _mm_max_ps(maxZ, _mm_load_ps(out[2]));
+        for (int j = 0; j < 4; j++)
+            p[j]->Set(out[0][j], out[1][j], out[2][j]);
+
+        x = _mm_set_ps(nm[3]->fX, nm[2]->fX, nm[1]->fX, nm[0]->fX);
+        y = _mm_set_ps(nm[3]->fY, nm[2]->fY, nm[1]->fY, nm[0]->fY);
+        z = _mm_set_ps(nm[3]->fZ, nm[2]->fZ, nm[1]->fZ, nm[0]->fZ);
+        for (int r = 0; r < 3; r++)
+        {
+            __m128 v = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, n[r][0]), _mm_mul_ps(y, n[r][1])),
+                                  _mm_mul_ps(z, n[r][2]));
+            _mm_store_ps(out[r], v);
+        }
+        for (int j = 0; j < 4; j++)
+            nm[j]->Set(out[0][j], out[1][j], out[2][j]);
+    }
+
+    alignas(16) float lo[3][4], hi[3][4];
+    _mm_store_ps(lo[0], minX);
+    _mm_store_ps(lo[1], minY);
+    _mm_store_ps(lo[2], minZ);
+    _mm_store_ps(hi[0], maxX);
+    _mm_store_ps(hi[1], maxY);
+    _mm_store_ps(hi[2], maxZ);
+    mins.Set(*std::min_element(lo[0], lo[0] + 4), *std::min_element(lo[1], lo[1] + 4), *std::min_element(lo[2], lo[2] + 4));
+    maxs.Set(*std::max_element(hi[0], hi[0] + 4), *std::max_element(hi[1], hi[1] + 4), *std::max_element(hi[2], hi[2] + 4));
+
+    // And whatever doesn't fill out a pass
+    transform_verts_fpu(vDst, count - i, stride, posOff, normOff, l2w, nrmXform, mins, maxs);
+#else
+    transform_verts_fpu(vDst, count, stride, posOff, normOff, l2w, nrmXform, mins, maxs);
+#endif // HAVE_SSE2
+}
@@ -45,9 +45,13 @@ You can contact Cyan Worlds, Inc. by email legal@cyan.com
 #include "plAccessSpan.h"
 #include "hsFastMath.h"
 #include "plAccessGeometry.h"
+#include "plSpanTriBVH.h"
 
 #include "hsStream.h"
 
+#include <algorithm>
+#include <cfloat>
+
 // Test hack
 #include "plDrawableSpans.h"
 #include "plDrawableGenerator.h"
@@ -273,10 +277,23 @@ inline void plCutter::ICutoutVtxMidW(const plCutoutVtx& inVtx, const plCutoutVtx
     dst.fUVW.fZ = 0.5f;
 }
 
+// Clipping scratch, one per thread so spans can be cut concurrently. The
+// vectors only ever grow, so once warmed up cutting doesn't allocate per tri.
+struct plCutoutScratch
+{
+    std::vector<plCutoutVtx>    fPoly;
+    std::vector<plCutoutVtx>    fAccum;
+};
+
+static plCutoutScratch& IGetCutoutScratch()
+{
+    static thread_local plCutoutScratch scratch;
+    return scratch;
+}
+
 // IPolyClip
-bool plCutter::IPolyClip(std::vector<plCutoutVtx>& poly, const hsPoint3 vPos[]) const
+bool plCutter::IPolyClip(std::vector<plCutoutVtx>& poly, std::vector<plCutoutVtx>& accum, const hsPoint3 vPos[]) const
 {
-    static std::vector<plCutoutVtx> accum;
     accum.clear();
 
     poly[0].fUVW.fX = vPos[0].InnerProduct(fDirU) - fDistU;
@@ -728,7 +745,7 @@ bool plCutter::FindHitPointsConstHeight(const std::vector<plCutoutPoly>& src, st
     return false;
 }
 
-void plCutter::ICutoutTransformedConstHeight(const plAccessSpan& src, std::vector<plCutoutPoly>& dst) const
+void plCutter::ICutoutTransformedConstHeight(const plAccessSpan& src, const uint32_t* tris, size_t numTris, std::vector<plCutoutPoly>& dst) const
 {
     const hsMatrix44& l2w = src.GetLocalToWorld();
     hsMatrix44 l2wNorm;
@@ -736,12 +753,16 @@ void plCutter::ICutoutTransformedConstHeight(const plAccessSpan& src, std::vecto
 
     bool baseHasAlpha = 0 != (src.GetMaterial()->GetLayer(0)->GetBlendFlags() & hsGMatState::kBlendAlpha);
 
+    plCutoutScratch& scratch = IGetCutoutScratch();
+    std::vector<plCutoutVtx>& poly = scratch.fPoly;
+
     plAccTriIterator tri(&src.AccessTri());
     // For each tri
-    for( tri.Begin(); tri.More(); tri.Advance() )
+    for (size_t i = 0; i < numTris; i++)
     {
+        tri.SetTri(tris ? tris[i] : i);
+
         // Do a polygon clip of tri to box
-        static std::vector<plCutoutVtx> poly;
         poly.resize(3);
 
         // Not sure about this, whether the constant water height should be world space or local.
@@ -757,7 +778,7 @@ void plCutter::ICutoutTransformedConstHeight(const plAccessSpan& src, std::vecto
         poly[2].Init(l2w * hsPoint3(tri.Position(2).fX, tri.Position(2).fY, tri.Position(2).fZ), l2wNorm * up, tri.DiffuseRGBA(2));
 
         // If we got a polygon
-        if( IPolyClip(poly, vPos) )
+        if( IPolyClip(poly, scratch.fAccum, vPos) )
         {
             // tessalate the polygon into dst
             IConstruct(dst, poly, baseHasAlpha);
@@ -768,7 +789,7 @@ void plCutter::ICutoutTransformedConstHeight(const plAccessSpan& src, std::vecto
 // We usually don't need to do any transform, because the kind of surface you
 // would leave prints on tends to be static, with the transform folded into the
 // verts. So it's worth having 2 separate versions of the function.
-void plCutter::ICutoutTransformed(const plAccessSpan& src, std::vector<plCutoutPoly>& dst) const
+void plCutter::ICutoutTransformed(const plAccessSpan& src, const uint32_t* tris, size_t numTris, std::vector<plCutoutPoly>& dst) const
 {
     const hsMatrix44& l2w = src.GetLocalToWorld();
     hsMatrix44 l2wNorm;
@@ -776,12 +797,16 @@ void plCutter::ICutoutTransformed(const plAccessSpan& src, std::vector<plCutoutP
 
     bool baseHasAlpha = 0 != (src.GetMaterial()->GetLayer(0)->GetBlendFlags() & hsGMatState::kBlendAlpha);
 
+    plCutoutScratch& scratch = IGetCutoutScratch();
+    std::vector<plCutoutVtx>& poly = scratch.fPoly;
+
     plAccTriIterator tri(&src.AccessTri());
     // For each tri
-    for( tri.Begin(); tri.More(); tri.Advance() )
+    for (size_t i = 0; i < numTris; i++)
     {
+        tri.SetTri(tris ? tris[i] : i);
+
         // Do a polygon clip of tri to box
-        static std::vector<plCutoutVtx> poly;
         poly.resize(3);
 
         hsPoint3 vPos[3];
@@ -794,7 +819,7 @@ void plCutter::ICutoutTransformed(const plAccessSpan& src, std::vector<plCutoutP
         poly[2].Init(vPos[2], l2wNorm * tri.Normal(2), tri.DiffuseRGBA(2));
 
         // If we got a polygon
-        if( IPolyClip(poly, vPos) )
+        if( IPolyClip(poly, scratch.fAccum, vPos) )
         {
             // tessalate the polygon into dst
             IConstruct(dst, poly, baseHasAlpha);
@@ -802,22 +827,26 @@ void plCutter::ICutoutTransformed(const plAccessSpan& src, std::vector<plCutoutP
     }
 }
 
-void plCutter::ICutoutConstHeight(const plAccessSpan& src, std::vector<plCutoutPoly>& dst) const
+void plCutter::ICutoutConstHeight(const plAccessSpan& src, const uint32_t* tris, size_t numTris, std::vector<plCutoutPoly>& dst) const
 {
     if( !(src.GetLocalToWorld().fFlags & hsMatrix44::kIsIdent) )
     {
-        ICutoutTransformedConstHeight(src, dst);
+        ICutoutTransformedConstHeight(src, tris, numTris, dst);
         return;
     }
 
     bool baseHasAlpha = 0 != (src.GetMaterial()->GetLayer(0)->GetBlendFlags() & hsGMatState::kBlendAlpha);
 
+    plCutoutScratch& scratch = IGetCutoutScratch();
+    std::vector<plCutoutVtx>& poly = scratch.fPoly;
+
     plAccTriIterator tri(&src.AccessTri());
     // For each tri
-    for( tri.Begin(); tri.More(); tri.Advance() )
+    for (size_t i = 0; i < numTris; i++)
     {
+        tri.SetTri(tris ? tris[i] : i);
+
         // Do a polygon clip of tri to box
-        static std::vector<plCutoutVtx> poly;
         poly.resize(3);
 
         const hsVector3 up(0.f, 0.f, 1.f);
@@ -832,7 +861,7 @@ void plCutter::ICutoutConstHeight(const plAccessSpan& src, std::vector<plCutoutP
         poly[2].Init(hsPoint3(tri.Position(2).fX, tri.Position(2).fY, tri.Position(2).fZ), up, tri.DiffuseRGBA(2));
 
         // If we got a polygon
-        if( IPolyClip(poly, vPos) )
+        if( IPolyClip(poly, scratch.fAccum, vPos) )
         {
             // tessalate the polygon into dst
             IConstruct(dst, poly, baseHasAlpha);
@@ -840,32 +869,32 @@ void plCutter::ICutoutConstHeight(const plAccessSpan& src, std::vector<plCutoutP
     }
 }
 
-// Cutout
-void plCutter::Cutout(const plAccessSpan& src, std::vector<plCutoutPoly>& dst) const
+void plCutter::ICutout(const plAccessSpan& src, const uint32_t* tris, size_t numTris, std::vector<plCutoutPoly>& dst) const
 {
-    if( !src.HasAccessTri() )
-        return;
-
     if( src.HasWaterHeight() )
     {
-        ICutoutConstHeight(src, dst);
+        ICutoutConstHeight(src, tris, numTris, dst);
         return;
     }
 
     if( !(src.GetLocalToWorld().fFlags & hsMatrix44::kIsIdent) )
     {
-        ICutoutTransformed(src, dst);
+        ICutoutTransformed(src, tris, numTris, dst);
         return;
     }
 
     bool baseHasAlpha = 0 != (src.GetMaterial()->GetLayer(0)->GetBlendFlags() & hsGMatState::kBlendAlpha);
 
+    plCutoutScratch& scratch = IGetCutoutScratch();
+    std::vector<plCutoutVtx>& poly = scratch.fPoly;
+
     plAccTriIterator tri(&src.AccessTri());
     // For each tri
-    for( tri.Begin(); tri.More(); tri.Advance() )
+    for (size_t i = 0; i < numTris; i++)
     {
+        tri.SetTri(tris ? tris[i] : i);
+
         // Do a polygon clip of tri to box
-        static std::vector<plCutoutVtx> poly;
         poly.resize(3);
 
         hsPoint3 vPos[3];
@@ -878,7 +907,7 @@ void plCutter::Cutout(const plAccessSpan& src, std::vector<plCutoutPoly>& dst) c
         poly[2].Init(vPos[2], tri.Normal(2), tri.DiffuseRGBA(2));
 
         // If we got a polygon
-        if( IPolyClip(poly, vPos) )
+        if( IPolyClip(poly, scratch.fAccum, vPos) )
         {
             // tessalate the polygon into dst
             IConstruct(dst, poly, baseHasAlpha);
@@ -886,10 +915,71 @@ void plCutter::Cutout(const plAccessSpan& src, std::vector<plCutoutPoly>& dst) c
     }
 }
 
+// Cutout
+void plCutter::Cutout(const plAccessSpan& src, std::vector<plCutoutPoly>& dst) const
+{
+    if( !src.HasAccessTri() )
+        return;
+
+    ICutout(src, nullptr, src.AccessTri().TriCount(), dst);
+}
+
+void plCutter::Cutout(const plAccessSpan& src, const std::vector<uint32_t>& tris, std::vector<plCutoutPoly>& dst) const
+{
+    if( !src.HasAccessTri() || tris.empty() )
+        return;
+
+    ICutout(src, tris.data(), tris.size(), dst);
+}
+
+bool plCutter::GatherTris(const plAccessSpan& src, const plSpanTriBVH& bvh, std::vector<uint32_t>& tris) const
+{
+    tris.clear();
+
+    // Our box in the span's local space. The tri tests are done in world space,
+    // so if the span has a transform, box up the corners of our world box.
+    hsPoint3 mins = fWorldBounds.GetMins();
+    hsPoint3 maxs = fWorldBounds.GetMaxs();
+    if( !(src.GetLocalToWorld().fFlags & hsMatrix44::kIsIdent) )
+    {
+        const hsMatrix44& w2l = src.GetWorldToLocal();
+        hsPoint3 lMin(FLT_MAX, FLT_MAX, FLT_MAX);
+        hsPoint3 lMax(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+        for (int i = 0; i < 8; i++)
+        {
+            hsPoint3 corner((i & 1) ? maxs.fX : mins.fX, (i & 2) ? maxs.fY : mins.fY, (i & 4) ? maxs.fZ : mins.fZ);
+            corner = w2l * corner;
+            lMin.Set(std::min(lMin.fX, corner.fX), std::min(lMin.fY, corner.fY), std::min(lMin.fZ, corner.fZ));
+            lMax.Set(std::max(lMax.fX, corner.fX), std::max(lMax.fY, corner.fY), std::max(lMax.fZ, corner.fZ));
+        }
+        mins = lMin;
+        maxs = lMax;
+    }
+
+    // Pad a bit, so a tri that just grazes the box and rounds differently
+    // in the clip than it does here isn't lost.
+    const float pad = 1.e-3f * std::max({ maxs.fX - mins.fX, maxs.fY - mins.fY, maxs.fZ - mins.fZ }) + 1.e-4f;
+    mins += hsVector3(-pad, -pad, -pad);
+    maxs += hsVector3(pad, pad, pad);
+
+    // With a constant water height, the clip only looks at the tri's X and Y.
+    if( src.HasWaterHeight() )
+    {
+        mins.fZ = -FLT_MAX;
+        maxs.fZ = FLT_MAX;
+    }
+
+    bvh.GatherTris(mins, maxs, tris);
+    std::sort(tris.begin(), tris.end());
+
+    return !tris.empty();
+}
+
 void plCutter::IConstruct(std::vector<plCutoutPoly>& dst, std::vector<plCutoutVtx>& poly, bool baseHasAlpha) const
 {
+    // Copy rather than swap, so the scratch poly keeps its storage for the next tri.
     plCutoutPoly& dstPoly = dst.emplace_back();
-    dstPoly.fVerts.swap(poly);
+    dstPoly.fVerts.assign(poly.begin(), poly.end());
     dstPoly.fBaseHasAlpha = baseHasAlpha;
 }
 
@@ -58,6 +58,7 @@ struct hsVector3;
 class plPrintCollect;
 class plAccTriIterator;
 class plAccessSpan;
+class plSpanTriBVH;
 
 struct plCutoutHit
 {
@@ -117,7 +118,7 @@ protected:
     plBoundsIsect   fIsect;
 
     void            IConstruct(std::vector<plCutoutPoly>& dst, std::vector<plCutoutVtx>& poly, bool baseHasAlpha) const;
-    bool            IPolyClip(std::vector<plCutoutVtx>& poly, const hsPoint3 vPos[]) const;
+    bool            IPolyClip(std::vector<plCutoutVtx>& poly, std::vector<plCutoutVtx>& accum, const hsPoint3 vPos[]) const;
     
     inline void     ICutoutVtxHiU(const plCutoutVtx& inVtx, const plCutoutVtx& outVtx, plCutoutVtx& dst) const;
     inline void     ICutoutVtxHiV(const plCutoutVtx& inVtx, const plCutoutVtx& outVtx, plCutoutVtx& dst) const;
@@ -133,9 +134,11 @@ protected:
 
     inline void     ISetPosNorm(float parm, const plCutoutVtx& inVtx, const plCutoutVtx& outVtx, plCutoutVtx& dst) const;
 
-    void            ICutoutTransformed(const plAccessSpan& src, std::vector<plCutoutPoly>& dst) const;
-    void            ICutoutConstHeight(const plAccessSpan& src, std::vector<plCutoutPoly>& dst) const;
-    void            ICutoutTransformedConstHeight(const plAccessSpan& src, std::vector<plCutoutPoly>& dst) const;
+    // tris lists the tris of src to look at, or is null for all of them.
+    void            ICutout(const plAccessSpan& src, const uint32_t* tris, size_t numTris, std::vector<plCutoutPoly>& dst) const;
+    void            ICutoutTransformed(const plAccessSpan& src, const uint32_t* tris, size_t numTris, std::vector<plCutoutPoly>& dst) const;
+    void            ICutoutConstHeight(const plAccessSpan& src, const uint32_t* tris, size_t numTris, std::vector<plCutoutPoly>& dst) const;
+    void            ICutoutTransformedConstHeight(const plAccessSpan& src, const uint32_t* tris, size_t numTris, std::vector<plCutoutPoly>& dst) const;
 
 
 public:
@@ -155,6 +158,13 @@ public:
     void        Set(const hsPoint3& pos, const hsVector3& dir, const hsVector3& out, bool flip=false);
 
     void        Cutout(const plAccessSpan& src, std::vector<plCutoutPoly>& dst) const;
+
+    // Indexed version of the above. GatherTris() finds the tris of src that might
+    // reach into our box using the span's hierarchy, sorted so that cutting them
+    // gives the same polys in the same order as cutting the whole span would.
+    // Returns false if there aren't any. Cutting may run on any thread.
+    bool        GatherTris(const plAccessSpan& src, const plSpanTriBVH& bvh, std::vector<uint32_t>& tris) const;
+    void        Cutout(const plAccessSpan& src, const std::vector<uint32_t>& tris, std::vector<plCutoutPoly>& dst) const;
     bool        CutoutGrid(int nWid, int nLen, plFlatGridMesh& dst) const;
 
     void        SetLength(const hsVector3& s) { fLengthU = s.fX; fLengthV = s.fY; fLengthW = s.fZ; }
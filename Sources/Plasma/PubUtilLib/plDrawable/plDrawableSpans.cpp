@@ -61,6 +61,7 @@ You can contact Cyan Worlds, Inc. by email legal@cyan.com
 #include "plPipeline.h"
 #include "plProfile.h"
 #include "hsMatrixMath.h"
+#include "hsParallel.h"
 #include "hsResMgr.h"
 #include "hsStream.h"
 
@@ -74,6 +75,7 @@ You can contact Cyan Worlds, Inc. by email legal@cyan.com
 #include "plSpaceTree.h"
 #include "plParticleFiller.h"
 #include "plSpaceTreeMaker.h"
+#include "plSpanTriBVH.h"
 
 #include "plClusterGroup.h"
 #include "plCluster.h"
@@ -1395,6 +1397,13 @@ void plDrawableSpans::DirtyVertexBuffer(size_t group, uint32_t idx)
     hsAssert(group < fGroups.size(), "Dirtying vtx buffer I don't have");
     GetBufferGroup(group)->DirtyVertexBuffer(idx);
 
+    // Someone's been moving verts around, the hierarchies over them are stale.
+    for (std::unique_ptr<plSpanTriBVH>& bvh : fTriBVHs)
+    {
+        if (bvh && bvh->UsesVertexBuffer(uint32_t(group), idx))
+            bvh.reset();
+    }
+
     SetNotReadyToRender();
 }
 
@@ -1406,6 +1415,31 @@ void plDrawableSpans::DirtyIndexBuffer(size_t group, uint32_t idx)
     SetNotReadyToRender();
 }
 
+const plSpanTriBVH* plDrawableSpans::GetSpanTriBVH(uint32_t spanIdx, plAccessSpan& src) const
+{
+    if (!(fSpans[spanIdx]->fTypeMask & plSpan::kIcicleSpan) || !src.HasAccessTri())
+        return nullptr;
+    const plIcicle* icicle = static_cast<const plIcicle*>(fSpans[spanIdx]);
+
+    if (src.AccessTri().TriCount() < plSpanTriBVH::kMinTris)
+        return nullptr;
+
+    if (fTriBVHs.size() < fSpans.size())
+        fTriBVHs.resize(fSpans.size());
+
+    std::unique_ptr<plSpanTriBVH>& bvh = fTriBVHs[spanIdx];
+    if (!bvh || !bvh->IsFor(*icicle))
+    {
+        bvh = std::make_unique<plSpanTriBVH>();
+        if (!bvh->Build(*icicle, src.AccessTri()))
+        {
+            bvh.reset();
+            return nullptr;
+        }
+    }
+    return bvh.get();
+}
+
 hsGMaterial* plDrawableSpans::GetSubMaterial(size_t index) const
 {
     return GetMaterial(fSpans[index]->fMaterialIdx);
@@ -2923,6 +2957,39 @@ void plDrawableSpans::IMakeSpanSortable(size_t index)
     span->fProps |= plSpan::kPropFacesSortable;
 }
 
+// One cluster's worth of unpacking, into storage already reserved for it.
+// Only buffer indices and offsets are kept, since reserving more index
+// storage can reallocate a buffer that an earlier job was going to use.
+struct plClusterUnPackJob
+{
+    const plCluster*    fCluster;
+    size_t              fGroupIdx;
+    uint32_t            fVBufferIdx;
+    uint32_t            fIBufferIdx;
+    uint32_t            fVStartByte;
+    uint32_t            fIStartIdx;
+    uint32_t            fIdxOffset;
+    size_t              fSpan;
+    uint8_t*            fVData;
+    uint16_t*           fIData;
+    hsBounds3Ext        fBounds;
+};
+
+// Below this many instances per thread, unpacking isn't worth splitting up.
+static const size_t kMinUnPackInstsPerThread = 256;
+
+static void IUnPackClusterJobs(std::vector<plClusterUnPackJob>& jobs, size_t numInsts)
+{
+    auto unpack = [](plClusterUnPackJob& job) {
+        job.fCluster->UnPack(job.fVData, job.fIData, job.fIdxOffset, job.fBounds);
+    };
+
+    // Clusters are independent, and each one only writes its own verts and indices.
+    hsParallelForEach(jobs.size(), hsParallelThreads(numInsts, kMinUnPackInstsPerThread), [&](size_t i) {
+        unpack(jobs[i]);
+    });
+}
+
 void plDrawableSpans::UnPackCluster(plClusterGroup* cluster)
 {
     const uint32_t vertsPerInst = cluster->GetTemplate()->NumVerts();
@@ -2948,6 +3015,11 @@ void plDrawableSpans::UnPackCluster(plClusterGroup* cluster)
 
     const std::vector<plLightInfo*>& lights = cluster->GetLights();
 
+    // Lay everything out up front, since the buffer groups aren't
+    // thread safe, then fill in the verts all at once.
+    std::vector<plClusterUnPackJob> jobs;
+    jobs.reserve(numClust);
+
     for (size_t iStart = 0; iStart < cluster->GetNumClusters(); )
     {
         int numVerts = 0;
@@ -2985,18 +3057,20 @@ void plDrawableSpans::UnPackCluster(plClusterGroup* cluster)
         uint32_t ibufferIdx;
         uint32_t istartIdx;
         fGroups[grpIdx]->ReserveIndexStorage(numIdx, &ibufferIdx, &istartIdx);
-        uint32_t iOffset = 0;
+        uint32_t iOffset = istartIdx;
+        uint32_t vOffset = 0;
 
-        uint8_t* vData = fGroups[grpIdx]->GetVertBufferData(vbufferIdx);
-        uint16_t* iData = fGroups[grpIdx]->GetIndexBufferData(ibufferIdx);
-        uint8_t* pvData = vData;
-        uint16_t* piData = iData;
         for (size_t i = iStart; i < iEnd; i++)
         {
-            hsBounds3Ext bnd;
-            cluster->GetCluster(i)->UnPack(pvData, piData, cellOffset, bnd);
-            fIcicles[iSpan].fLocalBounds = bnd;
-            fIcicles[iSpan].fWorldBounds = bnd;
+            plClusterUnPackJob& job = jobs.emplace_back();
+            job.fCluster = cluster->GetCluster(i);
+            job.fGroupIdx = grpIdx;
+            job.fVBufferIdx = vbufferIdx;
+            job.fIBufferIdx = ibufferIdx;
+            job.fVStartByte = vOffset;
+            job.fIStartIdx = iOffset;
+            job.fIdxOffset = cellOffset;
+            job.fSpan = iSpan;
 
             fIcicles[iSpan].fTypeMask = plSpan::kSpan | plSpan::kVertexSpan | plSpan::kIcicleSpan;
             // STUB - need to set whether strictly runtime lit or preshaded based on cluster.
@@ -3042,13 +3116,26 @@ void plDrawableSpans::UnPackCluster(plClusterGroup* cluster)
 
             iSpan++;
 
-            const uint32_t vSize = cluster->GetCluster(i)->NumInsts() * cluster->GetTemplate()->VertSize();
-            pvData += vSize;
-            piData += iLength;
+            vOffset += cluster->GetCluster(i)->NumInsts() * cluster->GetTemplate()->VertSize();
         }
 
         iStart = iEnd;
     }
+
+    // Only now that every batch has its storage are the buffers where they'll stay.
+    for (plClusterUnPackJob& job : jobs)
+    {
+        job.fVData = fGroups[job.fGroupIdx]->GetVertBufferData(job.fVBufferIdx) + job.fVStartByte;
+        job.fIData = fGroups[job.fGroupIdx]->GetIndexBufferData(job.fIBufferIdx) + job.fIStartIdx;
+    }
+
+    IUnPackClusterJobs(jobs, cluster->NumInst());
+    for (const plClusterUnPackJob& job : jobs)
+    {
+        fIcicles[job.fSpan].fLocalBounds = job.fBounds;
+        fIcicles[job.fSpan].fWorldBounds = job.fBounds;
+    }
+
     fMaterials = {nullptr};
     plGenRefMsg* refMsg = new plGenRefMsg(GetKey(), plRefMsg::kOnCreate, 0, kMsgMaterial);
     hsgResMgr::ResMgr()->SendRef(cluster->GetMaterial()->GetKey(), refMsg, plRefFlags::kActiveRef);
@@ -63,6 +63,7 @@ You can contact Cyan Worlds, Inc. by email legal@cyan.com
 #ifndef _plDrawableSpans_h
 #define _plDrawableSpans_h
 
+#include <memory>
 #include <vector>
 
 #include "hsAlignedAllocator.hpp"
@@ -87,6 +88,7 @@ class plAccessTriSpan;
 class plVisMgr;
 class plVisRegion;
 class plClusterGroup;
+class plSpanTriBVH;
 
 //// Class Definition ////////////////////////////////////////////////////////
 
@@ -144,6 +146,11 @@ class plDrawableSpans : public plDrawable
 
         mutable plSpaceTree*    fSpaceTree;
 
+        // Triangle hierarchies for plVisLOSMgr and decal cutting, built the first
+        // time a span is picked or cut against. Indexed by span, but checked against the span's buffer
+        // ranges on the way out, since spans can shuffle underneath.
+        mutable std::vector<std::unique_ptr<plSpanTriBVH>> fTriBVHs;
+
         hsBitVector             fVisSet; // the or of all our spans visset's. Doesn't have to be exact, just conservative.
         hsBitVector             fVisNot; // same, but for visregions that exclude us.
         mutable hsBitVector     fLastVisSet; // Last vis set we were evaluated against.
@@ -303,6 +310,10 @@ class plDrawableSpans : public plDrawable
         void            DirtyVertexBuffer(size_t group, uint32_t idx);
         void            DirtyIndexBuffer(size_t group, uint32_t idx);
 
+        // Returns the cached triangle hierarchy for an icicle span, building it from
+        // src (opened on that span) if needed. Null if the span is too small to bother.
+        const plSpanTriBVH* GetSpanTriBVH(uint32_t spanIdx, plAccessSpan& src) const;
+
         // Prepare all internal data structures for rendering
         virtual void    PrepForRender( plPipeline *p );
         void            SetNotReadyToRender() { fReadyToRender = false; }
@@ -56,6 +56,7 @@ You can contact Cyan Worlds, Inc. by email legal@cyan.com
 
 #include "plPrintShape.h"
 
+#include <algorithm>
 #include <string_theory/format>
 
 #include "plAvatar/plArmatureMod.h"
@@ -79,6 +80,7 @@ You can contact Cyan Worlds, Inc. by email legal@cyan.com
 
 #include "pnEncryption/plRandom.h"
 #include "hsFastMath.h"
+#include "hsParallel.h"
 
 #include "hsStream.h"
 #include "hsResMgr.h"
@@ -133,6 +135,21 @@ static const float kInitAuxSpans = 5;
 
 using namespace std;
 
+// A target span we're cutting the decal out of. Everything under the cutter is
+// opened and cut before any of it gets processed, so the cutting can be spread
+// across threads while IProcessPolys still sees the spans in their usual order.
+// Each manager keeps its own list and reuses it, so the storage sticks around
+// between decals.
+struct plDynaCutoutSpan
+{
+    plDrawableSpans*            fDrawable;
+    uint32_t                    fSpanIdx;
+    plAccessSpan                fSrc;
+    bool                        fIndexed;
+    std::vector<uint32_t>       fTris;
+    std::vector<plCutoutPoly>   fPolys;
+};
+
 bool plDynaDecalMgr::fDisableAccumulate = false;
 bool plDynaDecalMgr::fDisableUpdate = false;
 
@@ -1403,6 +1420,58 @@ bool plDynaDecalMgr::ICutoutGrid(plDrawableSpans* drawable, int iSpan, hsGMateri
     return IProcessGrid(drawable, iSpan, mat, secs, grid);
 }
 
+// Below this many tris to clip per thread, a cut isn't worth splitting up.
+static const size_t kMinCutoutTrisPerThread = 2048;
+
+static plDynaCutoutSpan& IOpenCutoutSpan(const plCutter& cutter, std::vector<plDynaCutoutSpan>& spans, size_t& numSpans,
+                                         plDrawableSpans* dr, uint32_t spanIdx)
+{
+    if (numSpans >= spans.size())
+        spans.emplace_back();
+    plDynaCutoutSpan& span = spans[numSpans++];
+
+    span.fDrawable = dr;
+    span.fSpanIdx = spanIdx;
+    span.fTris.clear();
+    span.fPolys.clear();
+
+    plAccessGeometry::Instance()->OpenRO(dr, spanIdx, span.fSrc);
+
+    // Dense spans get a cached hierarchy, so we only clip the tris under the cutter.
+    span.fIndexed = false;
+    if (const plSpanTriBVH* bvh = dr->GetSpanTriBVH(spanIdx, span.fSrc))
+    {
+        cutter.GatherTris(span.fSrc, *bvh, span.fTris);
+        span.fIndexed = true;
+    }
+    return span;
+}
+
+static void ICutoutSpans(const plCutter& cutter, std::vector<plDynaCutoutSpan>& spans, size_t numSpans)
+{
+    auto cutout = [&cutter](plDynaCutoutSpan& span) {
+        if (span.fIndexed)
+            cutter.Cutout(span.fSrc, span.fTris, span.fPolys);
+        else
+            cutter.Cutout(span.fSrc, span.fPolys);
+    };
+
+    size_t numTris = 0;
+    for (size_t i = 0; i < numSpans; i++)
+    {
+        const plDynaCutoutSpan& span = spans[i];
+        if (span.fIndexed)
+            numTris += span.fTris.size();
+        else if (span.fSrc.HasAccessTri())
+            numTris += span.fSrc.AccessTri().TriCount();
+    }
+
+    // Spans are independent, and each one only writes its own polys.
+    hsParallelForEach(numSpans, hsParallelThreads(numTris, kMinCutoutTrisPerThread), [&](size_t i) {
+        cutout(spans[i]);
+    });
+}
+
 bool plDynaDecalMgr::ICutoutObject(plSceneObject* so, double secs)
 {
     if( fDisableAccumulate )
@@ -1417,6 +1486,8 @@ bool plDynaDecalMgr::ICutoutObject(plSceneObject* so, double secs)
     if( !di )
         return retVal;
 
+    size_t numSpans = 0;
+
     plProfile_BeginTiming(Total);
     for (size_t j = 0; j < di->GetNumDrawables(); j++)
     {
@@ -1431,37 +1502,36 @@ bool plDynaDecalMgr::ICutoutObject(plSceneObject* so, double secs)
                 {
                     const plSpan* span = dr->GetSpan(diIndex[k]);
                     if( kVolumeCulled != fCutter->GetIsect().Test(span->fWorldBounds) )
-                    {
-                        plAccessSpan src;
-                        plAccessGeometry::Instance()->OpenRO(dr, diIndex[k], src);
-
-                        static std::vector<plCutoutPoly> dst;
-                        dst.clear();
-
-                        plProfile_BeginTiming(Cutter);
-                        fCutter->Cutout(src, dst);
-                        plProfile_EndTiming(Cutter);
-
-                        plProfile_BeginTiming(Process);
-                        if( IProcessPolys(dr, diIndex[k], secs, dst) )
-                        {
-                            plProfile_BeginTiming(Callback);
-                            if( src.HasWaterHeight() )
-                                ICutoutCallback(dst, true, src.GetWaterHeight());
-                            else
-                                ICutoutCallback(dst);
-                            plProfile_EndTiming(Callback);
-
-                            retVal = true;
-                        }
-                        plProfile_EndTiming(Process);
-
-                        plAccessGeometry::Instance()->Close(src);
-                    }
+                        IOpenCutoutSpan(*fCutter, fCutoutSpans, numSpans, dr, diIndex[k]);
                 }
             }
         }
     }
+
+    plProfile_BeginTiming(Cutter);
+    ICutoutSpans(*fCutter, fCutoutSpans, numSpans);
+    plProfile_EndTiming(Cutter);
+
+    for (size_t i = 0; i < numSpans; i++)
+    {
+        plDynaCutoutSpan& span = fCutoutSpans[i];
+
+        plProfile_BeginTiming(Process);
+        if( IProcessPolys(span.fDrawable, span.fSpanIdx, secs, span.fPolys) )
+        {
+            plProfile_BeginTiming(Callback);
+            if( span.fSrc.HasWaterHeight() )
+                ICutoutCallback(span.fPolys, true, span.fSrc.GetWaterHeight());
+            else
+                ICutoutCallback(span.fPolys);
+            plProfile_EndTiming(Callback);
+
+            retVal = true;
+        }
+        plProfile_EndTiming(Process);
+
+        plAccessGeometry::Instance()->Close(span.fSrc);
+    }
     plProfile_EndTiming(Total);
     return retVal;
 }
@@ -1476,35 +1546,24 @@ bool plDynaDecalMgr::ICutoutList(std::vector<plDrawVisList>& drawVis, double sec
     if (drawVis.empty())
         return retVal;
 
-    std::vector<plAccessSpan> src;
+    size_t numSpans = 0;
 
-    size_t numSpan = 0;
     for (const plDrawVisList& dv : drawVis)
-        numSpan += dv.fVisList.size();
-
-    src.resize(numSpan);
-
-    size_t iDraw = 0;
-    size_t iSpan = 0;
-    for (size_t i = 0; i < numSpan; i++)
     {
-        static std::vector<plCutoutPoly> dst;
-        dst.clear();
+        for (int16_t spanIdx : dv.fVisList)
+            IOpenCutoutSpan(*fCutter, fCutoutSpans, numSpans, (plDrawableSpans*)dv.fDrawable, spanIdx);
+    }
 
-        plAccessGeometry::Instance()->OpenRO(drawVis[iDraw].fDrawable, drawVis[iDraw].fVisList[iSpan], src[i]);
+    ICutoutSpans(*fCutter, fCutoutSpans, numSpans);
 
-        fCutter->Cutout(src[i], dst);
+    for (size_t i = 0; i < numSpans; i++)
+    {
+        plDynaCutoutSpan& span = fCutoutSpans[i];
 
-        if( IProcessPolys((plDrawableSpans*)drawVis[iDraw].fDrawable, drawVis[iDraw].fVisList[iSpan], secs, dst) )
+        if( IProcessPolys(span.fDrawable, span.fSpanIdx, secs, span.fPolys) )
             retVal = true;
 
-        plAccessGeometry::Instance()->Close(src[i]);
-
-        if (++iSpan >= drawVis[iDraw].fVisList.size())
-        {
-            iDraw++;
-            iSpan = 0;
-        }
+        plAccessGeometry::Instance()->Close(span.fSrc);
     }
     return retVal;
 }
@@ -72,6 +72,7 @@ class plMessage;
 class plCutter;
 struct plCutoutPoly;
 struct plFlatGridMesh;
+struct plDynaCutoutSpan;
 
 struct plDrawVisList;
 class plRenderLevel;
@@ -143,6 +144,8 @@ protected:
 
     std::vector<plAuxSpan*>     fAuxSpans;
 
+    std::vector<plDynaCutoutSpan> fCutoutSpans; // Scratch for ICutoutObject/ICutoutList
+
     hsGMaterial*                fMatPreShade;
     hsGMaterial*                fMatRTShade;
 
@@ -47,6 +47,11 @@ You can contact Cyan Worlds, Inc. by email legal@cyan.com
 
 #include "plMorphDelta.h"
 
+struct plMorphArrayWeights
+{
+    std::vector<float> fDeltaWeights;
+};
+
 class plMorphArray
 {
 protected:
@@ -65,6 +70,7 @@ public:
     void AddDelta(const plMorphDelta& delta);
 
     size_t GetNumDeltas() const { return fDeltas.size(); }
+    const plMorphDelta& GetDelta(size_t iDel) const { return fDeltas[iDel]; }
     float GetWeight(size_t iDel) const { return fDeltas[iDel].GetWeight(); }
     void SetWeight(size_t iDel, float w) { if (iDel < fDeltas.size()) fDeltas[iDel].SetWeight(w); }
 };
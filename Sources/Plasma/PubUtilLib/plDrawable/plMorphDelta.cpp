@@ -65,12 +65,18 @@ plMorphDelta& plMorphDelta::operator=(const plMorphDelta& src)
     return *this;
 }
 
-void plMorphDelta::Apply(std::vector<plAccessSpan>& dst, float weight /* = -1.f */) const
+float plMorphDelta::GetAppliedWeight(float weight /* = -1.f */) const
 {
     if( weight == -1.f)
         weight = fWeight; // None passed in, use our stored value
 
-    if( weight <= kMinWeight )
+    return weight > kMinWeight ? weight : 0.f;
+}
+
+void plMorphDelta::Apply(std::vector<plAccessSpan>& dst, float weight /* = -1.f */) const
+{
+    weight = GetAppliedWeight(weight);
+    if( weight == 0.f )
         return;
 
     // Easy
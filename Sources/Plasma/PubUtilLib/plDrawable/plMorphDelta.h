@@ -93,10 +93,14 @@ public:
 
     void        Apply(std::vector<plAccessSpan>& dst, float weight = -1.f) const;
 
+    // The weight Apply() would actually add in, or zero if it would skip us.
+    float       GetAppliedWeight(float weight = -1.f) const;
+
     void        ComputeDeltas(const std::vector<plAccessSpan>& base, const std::vector<plAccessSpan>& moved);
     void        ComputeDeltas(const std::vector<plGeometrySpan*>& base, const std::vector<plGeometrySpan*>& moved, const hsMatrix44& d2b, const hsMatrix44& d2bTInv);
 
     size_t      GetNumSpans() const { return fSpans.size(); }
+    const plMorphSpan& GetSpan(size_t iSpan) const { return fSpans[iSpan]; }
     void        SetNumSpans(size_t n);
     void        SetDeltas(size_t iSpan, const std::vector<plVertDelta>& deltas, size_t numUVWChans, const hsPoint3* uvws); // len uvws is deltas.size() * numUVWChans
 
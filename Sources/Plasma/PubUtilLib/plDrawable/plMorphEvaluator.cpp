@@ -0,0 +1,287 @@
+/*==LICENSE==*
+
+CyanWorlds.com Engine - MMOG client, server and tools
+Copyright (C) 2011  Cyan Worlds, Inc.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+Additional permissions under GNU GPL version 3 section 7
+
+If you modify this Program, or any covered work, by linking or
+combining it with any of RAD Game Tools Bink SDK, Autodesk 3ds Max SDK,
+NVIDIA PhysX SDK, Microsoft DirectX SDK, OpenSSL library, Independent
+JPEG Group JPEG library, Microsoft Windows Media SDK, or Apple QuickTime SDK
+(or a modified version of those libraries),
+containing parts covered by the terms of the Bink SDK EULA, 3ds Max EULA,
+PhysX SDK EULA, DirectX SDK EULA, OpenSSL and SSLeay licenses, IJG
+JPEG Library README, Windows Media SDK EULA, or QuickTime SDK EULA, the
+licensors of this Program grant you additional
+permission to convey the resulting work. Corresponding Source for a
+non-source form of such a combination shall include the source code for
+the parts of OpenSSL and IJG JPEG Library used as well as that of the covered
+work.
+
+You can contact Cyan Worlds, Inc. by email legal@cyan.com
+ or by snail mail at:
+      Cyan Worlds, Inc.
+      14617 N Newport Hwy
+      Mead, WA   99021
+
+*==LICENSE==*/
+
+#include "HeadSpin.h"
+#include "plMorphEvaluator.h"
+
+#include "hsFastMath.h"
+
+#include "plAccessSpan.h"
+#include "plAccessVtxSpan.h"
+#include "plMorphArray.h"
+
+#include <algorithm>
+
+// Every incremental step rounds a little differently than applying the
+// whole lot at once would. Nobody will see a thousand of them, and by then
+// we've usually swept through several sliders' worth, so a full rebuild is
+// cheap by comparison.
+static const uint32_t kMaxIncremental = 1024;
+
+float plMorphEvaluator::IGetWeight(const std::vector<plMorphArray>& morphs, const std::vector<plMorphArrayWeights>* weights, size_t iLay, size_t iDel) const
+{
+    return morphs[iLay].GetDelta(iDel).GetAppliedWeight(weights ? (*weights)[iLay].fDeltaWeights[iDel] : -1.f);
+}
+
+bool plMorphEvaluator::ISameLayout(const std::vector<plMorphArray>& morphs, const std::vector<plAccessSpan>* dst) const
+{
+    if (fApplied.size() != morphs.size())
+        return false;
+    for (size_t iLay = 0; iLay < morphs.size(); iLay++)
+    {
+        if (fApplied[iLay].size() != morphs[iLay].GetNumDeltas())
+            return false;
+    }
+
+    if (dst)
+    {
+        if (dst->size() != fSpans.size())
+            return false;
+        for (size_t i = 0; i < fSpans.size(); i++)
+        {
+            const plAccessVtxSpan& vtx = (*dst)[i].AccessVtx();
+            if (vtx.VertCount() != fSpans[i].fNumVerts || vtx.NumUVWs() != fSpans[i].fNumUVWs)
+                return false;
+        }
+    }
+    return true;
+}
+
+void plMorphEvaluator::IAccumDelta(const plMorphArray& morph, size_t iDel, float weight, bool track)
+{
+    const plMorphDelta& delta = morph.GetDelta(iDel);
+    const size_t numSpans = std::min(delta.GetNumSpans(), fSpans.size());
+    for (size_t iSpan = 0; iSpan < numSpans; iSpan++)
+    {
+        const plMorphSpan& mSpan = delta.GetSpan(iSpan);
+        if (mSpan.fDeltas.empty())
+            continue;
+
+        SpanCache& span = fSpans[iSpan];
+        accum_deltas.call(span.fPosNorm.data(), mSpan.fDeltas.data(), mSpan.fDeltas.size(), weight);
+
+        const uint16_t numUVWs = std::min(mSpan.fNumUVWChans, span.fNumUVWs);
+        const hsPoint3* uvwDel = mSpan.fUVWs;
+        for (const plVertDelta& vd : mSpan.fDeltas)
+        {
+            hsPoint3* uvws = span.fUVWs.data() + vd.fIdx * span.fNumUVWs;
+            for (uint16_t j = 0; j < numUVWs; j++)
+                uvws[j] += uvwDel[j] * weight;
+            uvwDel += mSpan.fNumUVWChans;
+
+            if (track && !span.fTouched[vd.fIdx])
+            {
+                span.fTouched[vd.fIdx] = 1;
+                span.fTouchedList.emplace_back(vd.fIdx);
+            }
+        }
+    }
+}
+
+void plMorphEvaluator::IWriteVert(const SpanCache& span, uint32_t iVtx, plAccessSpan& dst) const
+{
+    plAccessVtxSpan& vtx = dst.AccessVtx();
+    const float* pn = span.fPosNorm.data() + iVtx * kFloatsPerVert;
+
+    vtx.Position(iVtx).Set(pn[0], pn[1], pn[2]);
+
+    hsVector3& norm = vtx.Normal(iVtx);
+    norm.Set(pn[3], pn[4], pn[5]);
+    hsFastMath::Normalize(norm);
+
+    if (span.fNumUVWs)
+    {
+        const hsPoint3* uvws = span.fUVWs.data() + iVtx * span.fNumUVWs;
+        std::copy(uvws, uvws + span.fNumUVWs, vtx.UVWs(iVtx));
+    }
+}
+
+bool plMorphEvaluator::IsCurrent(const std::vector<plMorphArray>& morphs, const std::vector<plMorphArrayWeights>* weights) const
+{
+    if (!fValid || !ISameLayout(morphs, nullptr))
+        return false;
+
+    for (size_t iLay = 0; iLay < morphs.size(); iLay++)
+    {
+        for (size_t iDel = 0; iDel < fApplied[iLay].size(); iDel++)
+        {
+            if (IGetWeight(morphs, weights, iLay, iDel) != fApplied[iLay][iDel])
+                return false;
+        }
+    }
+    return true;
+}
+
+void plMorphEvaluator::Rebuild(const std::vector<plAccessSpan>& base, const std::vector<plMorphArray>& morphs,
+                               const std::vector<plMorphArrayWeights>* weights, std::vector<plAccessSpan>& dst)
+{
+    hsAssert(base.size() == dst.size(), "Morphing onto a different mesh than we started with");
+
+    // Copy out the whole base first, in case it's dst we're looking at.
+    fSpans.resize(std::min(base.size(), dst.size()));
+    for (size_t i = 0; i < fSpans.size(); i++)
+    {
+        const plAccessVtxSpan& src = base[i].AccessVtx();
+        SpanCache& span = fSpans[i];
+
+        span.fNumVerts = src.VertCount();
+        span.fNumUVWs = src.NumUVWs();
+        span.fPosNorm.resize(span.fNumVerts * kFloatsPerVert);
+        span.fUVWs.resize(span.fNumVerts * span.fNumUVWs);
+        span.fTouched.assign(span.fNumVerts, 0);
+        span.fTouchedList.clear();
+
+        float* pn = span.fPosNorm.data();
+        for (uint32_t j = 0; j < span.fNumVerts; j++, pn += kFloatsPerVert)
+        {
+            const hsPoint3& pos = src.Position(j);
+            const hsVector3& norm = src.Normal(j);
+            pn[0] = pos.fX;
+            pn[1] = pos.fY;
+            pn[2] = pos.fZ;
+            pn[3] = norm.fX;
+            pn[4] = norm.fY;
+            pn[5] = norm.fZ;
+            pn[6] = pn[7] = 0.f;
+
+            if (span.fNumUVWs)
+            {
+                const hsPoint3* uvws = src.UVWs(j);
+                std::copy(uvws, uvws + span.fNumUVWs, span.fUVWs.data() + j * span.fNumUVWs);
+            }
+        }
+    }
+
+    // Same order as plMorphArray::Apply(), so the sums come out the same.
+    fApplied.resize(morphs.size());
+    for (size_t iLay = 0; iLay < morphs.size(); iLay++)
+    {
+        fApplied[iLay].resize(morphs[iLay].GetNumDeltas());
+        for (size_t iDel = 0; iDel < fApplied[iLay].size(); iDel++)
+        {
+            float w = IGetWeight(morphs, weights, iLay, iDel);
+            fApplied[iLay][iDel] = w;
+            if (w != 0.f)
+                IAccumDelta(morphs[iLay], iDel, w, false);
+        }
+    }
+
+    for (size_t i = 0; i < fSpans.size(); i++)
+    {
+        for (uint32_t j = 0; j < fSpans[i].fNumVerts; j++)
+            IWriteVert(fSpans[i], j, dst[i]);
+    }
+
+    fNumIncremental = 0;
+    fValid = true;
+}
+
+bool plMorphEvaluator::Update(const std::vector<plMorphArray>& morphs, const std::vector<plMorphArrayWeights>* weights,
+                              std::vector<plAccessSpan>& dst)
+{
+    if (!fValid || !ISameLayout(morphs, &dst))
+        return false;
+
+    // Size up the job before touching anything, so we never have to back out of it halfway.
+    uint32_t numChanged = 0;
+    for (size_t iLay = 0; iLay < morphs.size(); iLay++)
+    {
+        for (size_t iDel = 0; iDel < fApplied[iLay].size(); iDel++)
+        {
+            if (IGetWeight(morphs, weights, iLay, iDel) != fApplied[iLay][iDel])
+                numChanged++;
+        }
+    }
+    if (!numChanged)
+        return true;
+    if (fNumIncremental + numChanged > kMaxIncremental)
+        return false;
+    fNumIncremental += numChanged;
+
+    for (size_t iLay = 0; iLay < morphs.size(); iLay++)
+    {
+        for (size_t iDel = 0; iDel < fApplied[iLay].size(); iDel++)
+        {
+            float w = IGetWeight(morphs, weights, iLay, iDel);
+            if (w != fApplied[iLay][iDel])
+            {
+                IAccumDelta(morphs[iLay], iDel, w - fApplied[iLay][iDel], true);
+                fApplied[iLay][iDel] = w;
+            }
+        }
+    }
+
+    for (size_t i = 0; i < fSpans.size(); i++)
+    {
+        SpanCache& span = fSpans[i];
+        for (uint32_t j : span.fTouchedList)
+        {
+            IWriteVert(span, j, dst[i]);
+            span.fTouched[j] = 0;
+        }
+        span.fTouchedList.clear();
+    }
+
+    return true;
+}
+
+void plMorphEvaluator::accum_deltas_fpu(float* accum, const plVertDelta* deltas, size_t count, float weight)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        const plVertDelta& delta = deltas[i];
+        float* pn = accum + delta.fIdx * kFloatsPerVert;
+        pn[0] += delta.fPos.fX * weight;
+        pn[1] += delta.fPos.fY * weight;
+        pn[2] += delta.fPos.fZ * weight;
+        pn[3] += delta.fNorm.fX * weight;
+        pn[4] += delta.fNorm.fY * weight;
+        pn[5] += delta.fNorm.fZ * weight;
+    }
+}
+
+// CPU-optimized functions requiring dispatch
+hsCpuFunctionDispatcher<plMorphEvaluator::accum_deltas_ptr> plMorphEvaluator::accum_deltas {
+    &plMorphEvaluator::accum_deltas_fpu,
+    nullptr,            // SSE1
+    &plMorphEvaluator::accum_deltas_sse2
+};
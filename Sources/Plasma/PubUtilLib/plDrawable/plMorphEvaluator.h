@@ -0,0 +1,121 @@
+/*==LICENSE==*
+
+CyanWorlds.com Engine - MMOG client, server and tools
+Copyright (C) 2011  Cyan Worlds, Inc.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+Additional permissions under GNU GPL version 3 section 7
+
+If you modify this Program, or any covered work, by linking or
+combining it with any of RAD Game Tools Bink SDK, Autodesk 3ds Max SDK,
+NVIDIA PhysX SDK, Microsoft DirectX SDK, OpenSSL library, Independent
+JPEG Group JPEG library, Microsoft Windows Media SDK, or Apple QuickTime SDK
+(or a modified version of those libraries),
+containing parts covered by the terms of the Bink SDK EULA, 3ds Max EULA,
+PhysX SDK EULA, DirectX SDK EULA, OpenSSL and SSLeay licenses, IJG
+JPEG Library README, Windows Media SDK EULA, or QuickTime SDK EULA, the
+licensors of this Program grant you additional
+permission to convey the resulting work. Corresponding Source for a
+non-source form of such a combination shall include the source code for
+the parts of OpenSSL and IJG JPEG Library used as well as that of the covered
+work.
+
+You can contact Cyan Worlds, Inc. by email legal@cyan.com
+ or by snail mail at:
+      Cyan Worlds, Inc.
+      14617 N Newport Hwy
+      Mead, WA   99021
+
+*==LICENSE==*/
+
+#ifndef plMorphEvaluator_inc
+#define plMorphEvaluator_inc
+
+#include <vector>
+
+#include "hsGeometry3.h"
+#include "hsCpuID.h"
+
+class plAccessSpan;
+class plMorphArray;
+struct plMorphArrayWeights;
+struct plVertDelta;
+
+// Keeps the un-normalized result of the last morph around, along with the
+// weights that went into it, so that moving one slider only costs that
+// slider's deltas. Only the verts those deltas touch get written back (and
+// renormalized). Rebuild() does exactly what applying every delta to a
+// fresh copy of the base mesh always did; Update() gets within float
+// rounding of it, and gives up (returning false) whenever the layout it
+// was built against changes, or after enough incremental steps that the
+// rounding is worth starting over for.
+class plMorphEvaluator
+{
+public:
+    // Pos xyz, norm xyz and two floats of padding, so each vert is a pair of
+    // float4s for the SIMD accumulation.
+    enum { kFloatsPerVert = 8 };
+
+protected:
+    struct SpanCache
+    {
+        uint32_t                fNumVerts;
+        uint16_t                fNumUVWs;
+        std::vector<float>      fPosNorm;
+        std::vector<hsPoint3>   fUVWs;
+        std::vector<uint8_t>    fTouched;
+        std::vector<uint32_t>   fTouchedList;
+
+        SpanCache() : fNumVerts(), fNumUVWs() { }
+    };
+    std::vector<SpanCache>              fSpans;
+    std::vector<std::vector<float>>     fApplied;       // Effective weight baked in, per layer per delta
+    uint32_t                            fNumIncremental; // Deltas Update() has (un)applied since the last Rebuild()
+    bool                                fValid;
+
+    bool        ISameLayout(const std::vector<plMorphArray>& morphs, const std::vector<plAccessSpan>* dst) const;
+    float       IGetWeight(const std::vector<plMorphArray>& morphs, const std::vector<plMorphArrayWeights>* weights, size_t iLay, size_t iDel) const;
+    void        IAccumDelta(const plMorphArray& morph, size_t iDel, float weight, bool track);
+    void        IWriteVert(const SpanCache& span, uint32_t iVtx, plAccessSpan& dst) const;
+
+public:
+    plMorphEvaluator() : fNumIncremental(), fValid() { }
+
+    bool        IsValid() const { return fValid; }
+    void        Invalidate() { fValid = false; }
+
+    // True if the last result still stands for these weights, so there's no
+    // need to even open the destination.
+    bool        IsCurrent(const std::vector<plMorphArray>& morphs, const std::vector<plMorphArrayWeights>* weights = nullptr) const;
+
+    // Start over from base, applying everything. Base and dst may be the same spans.
+    void        Rebuild(const std::vector<plAccessSpan>& base, const std::vector<plMorphArray>& morphs,
+                        const std::vector<plMorphArrayWeights>* weights, std::vector<plAccessSpan>& dst);
+
+    // Apply just the weight changes since last time. Returns false, having
+    // written nothing, if a Rebuild() is needed instead.
+    bool        Update(const std::vector<plMorphArray>& morphs, const std::vector<plMorphArrayWeights>* weights,
+                       std::vector<plAccessSpan>& dst);
+
+    //// CPU-optimized accumulation ////
+    // accum += delta * weight for each delta, on the kFloatsPerVert layout.
+    // Both versions round the same, so results match to the bit.
+    typedef void(*accum_deltas_ptr)(float* accum, const plVertDelta* deltas, size_t count, float weight);
+    static hsCpuFunctionDispatcher<accum_deltas_ptr> accum_deltas;
+    static void accum_deltas_fpu(float* accum, const plVertDelta* deltas, size_t count, float weight);
+    static void accum_deltas_sse2(float* accum, const plVertDelta* deltas, size_t count, float weight);
+};
+
+#endif // plMorphEvaluator_inc
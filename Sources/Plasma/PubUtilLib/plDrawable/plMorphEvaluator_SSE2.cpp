@@ -0,0 +1,74 @@
+/*==LICENSE==*
+
+CyanWorlds.com Engine - MMOG client, server and tools
+Copyright (C) 2011  Cyan Worlds, Inc.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+Additional permissions under GNU GPL version 3 section 7
+
+If you modify this Program, or any covered work, by linking or
+combining it with any of RAD Game Tools Bink SDK, Autodesk 3ds Max SDK,
+NVIDIA PhysX SDK, Microsoft DirectX SDK, OpenSSL library, Independent
+JPEG Group JPEG library, Microsoft Windows Media SDK, or Apple QuickTime SDK
+(or a modified version of those libraries),
+containing parts covered by the terms of the Bink SDK EULA, 3ds Max EULA,
+PhysX SDK EULA, DirectX SDK EULA, OpenSSL and SSLeay licenses, IJG
+JPEG Library README, Windows Media SDK EULA, or QuickTime SDK EULA, the
+licensors of this Program grant you additional
+permission to convey the resulting work. Corresponding Source for a
+non-source form of such a combination shall include the source code for
+the parts of OpenSSL and IJG JPEG Library used as well as that of the covered
+work.
+
+You can contact Cyan Worlds, Inc. by email legal@cyan.com
+ or by snail mail at:
+      Cyan Worlds, Inc.
+      14617 N Newport Hwy
+      Mead, WA   99021
+
+*==LICENSE==*/
+
+#include "HeadSpin.h"
+#include "plMorphEvaluator.h"
+#include "plMorphDelta.h"
+
+#ifdef HAVE_SSE2
+#   include <emmintrin.h>
+#endif
+
+// One delta per pass. The position and the front of the normal sit next to
+// each other in plVertDelta, lining up with the first float4 of the vert,
+// which leaves two floats of normal for the second.
+void plMorphEvaluator::accum_deltas_sse2(float* accum, const plVertDelta* deltas, size_t count, float weight)
+{
+#ifdef HAVE_SSE2
+    static_assert(sizeof(hsVector3) == 3 * sizeof(float), "plVertDelta vectors need to be packed floats");
+
+    const __m128 wgt = _mm_set1_ps(weight);
+    for (size_t i = 0; i < count; i++)
+    {
+        const plVertDelta& delta = deltas[i];
+        float* pn = accum + delta.fIdx * kFloatsPerVert;
+
+        __m128 lo = _mm_loadu_ps(&delta.fPos.fX);
+        __m128 hi = _mm_loadl_pi(_mm_setzero_ps(), reinterpret_cast<const __m64*>(&delta.fNorm.fY));
+
+        _mm_storeu_ps(pn, _mm_add_ps(_mm_loadu_ps(pn), _mm_mul_ps(lo, wgt)));
+        _mm_storeu_ps(pn + 4, _mm_add_ps(_mm_loadu_ps(pn + 4), _mm_mul_ps(hi, wgt)));
+    }
+#else
+    accum_deltas_fpu(accum, deltas, count, weight);
+#endif // HAVE_SSE2
+}
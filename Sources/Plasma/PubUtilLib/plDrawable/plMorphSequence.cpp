@@ -63,7 +63,6 @@ You can contact Cyan Worlds, Inc. by email legal@cyan.com
 
 #include "plTweak.h"
 #include "hsTimer.h"
-#include "hsFastMath.h"
 
 ///////////////////////////////////////////////////////////////////////////
 
@@ -331,6 +330,7 @@ void plMorphSequence::Init()
             const plDrawInterface* di = IGetDrawInterface();
 
             plAccessGeometry::Instance()->TakeSnapShot(di, kChanMask);
+            fEvaluator.Invalidate();
 
             ISetHaveSnap(true);
         }
@@ -368,25 +368,13 @@ void plMorphSequence::DeInit()
 
             if( di ) 
                 plAccessGeometry::Instance()->ReleaseSnapShot(di);
+            fEvaluator.Invalidate();
 
             ISetHaveSnap(false);
         }
     }
 }
 
-void plMorphSequence::IRenormalize(std::vector<plAccessSpan>& dst) const
-{
-    for (plAccessSpan& span : dst)
-    {
-        hsAssert(span.HasAccessVtx(), "Come on, everyone has vertices");
-        plAccessVtxSpan& accVtx = span.AccessVtx();
-        for (uint32_t j = 0; j < accVtx.VertCount(); j++)
-        {
-            hsFastMath::Normalize(accVtx.Normal(j));
-        }
-    }
-}
-
 // MorphSequence - Apply
 void plMorphSequence::Apply() const
 {
@@ -394,21 +382,25 @@ void plMorphSequence::Apply() const
     if( !di )
         return;
 
-    // Reset to initial.
-    Reset(di);
+    // Nothing's moved since last time, so the buffers are already right.
+    if (fEvaluator.IsCurrent(fMorphs))
+        return;
 
     // We'll be accumulating into the buffer, so open RW
     std::vector<plAccessSpan> dst;
     plAccessGeometry::Instance()->OpenRW(di, dst);
 
-    // For each MorphArray
-    for (const plMorphArray& morph : fMorphs)
+    // Usually it's just a slider or two that changed, so only shift those
+    // deltas. Otherwise start over from the snapshot.
+    if (!fEvaluator.Update(fMorphs, nullptr, dst))
     {
-        // Apply Delta
-        morph.Apply(dst);
-    }
+        std::vector<plAccessSpan> base;
+        plAccessGeometry::Instance()->OpenRO(di, base);
+
+        fEvaluator.Rebuild(base, fMorphs, nullptr, dst);
 
-    IRenormalize(dst);
+        plAccessGeometry::Instance()->Close(base);
+    }
 
     // Close up the access spans
     plAccessGeometry::Instance()->Close(dst);
@@ -425,6 +417,9 @@ void plMorphSequence::Reset(const plDrawInterface* di) const
     // Use access span RestoreSnapshot
     if( di )
         plAccessGeometry::Instance()->RestoreSnapShot(di, kChanMask);
+
+    // Whatever we had applied is gone now
+    fEvaluator.Invalidate();
 }
 
 const plDrawInterface* plMorphSequence::IGetDrawInterface() const
@@ -492,18 +487,16 @@ void plMorphSequence::Write(hsStream* s, hsResMgr* mgr)
 
 // Normal sequence of calls:
 // 1) on notification that meshes have changed (or activate)
-//      IFindIndices() - Sets up indices 
+//      IFindIndices() - Sets up indices, and forgets what we'd applied
 //      IApplyShared() - Find which mesh is active and
-//          IResetShared(iActive);
-//          IApplyShared(iActive);
+//          IApplyShared(iActive); - rebuilds from the shared mesh
 //      go dormant
 // 2) on weight change
 //      SetWeight() - Register for render message and set the new weight
 // 3) on render msg:
 //      if dirty
 //          IApplyShared() - Find which mesh is active and
-//              IResetShared(iActive);
-//              IApplyShared(iActive);
+//              IApplyShared(iActive); - applies just the weights that changed
 //      else
 //          Unregister for render message.
 // 4) on deinit
@@ -519,10 +512,7 @@ void plMorphSequence::IResetShared()
 void plMorphSequence::IApplyShared()
 {
     for (size_t i = 0; i < fSharedMeshes.size(); i++)
-    {
-        IResetShared(i);
         IApplyShared(i);
-    }
 }
 
 void plMorphSequence::IFindIndices()
@@ -545,29 +535,33 @@ void plMorphSequence::IApplyShared(size_t iShare)
         return;
 
     plSharedMeshInfo& mInfo = fSharedMeshes[iShare];
+    const std::vector<plMorphArray>& morphs = mInfo.fMesh->fMorphSet->fMorphs;
 
-    std::vector<plAccessSpan> dst;
-    // Now copy each shared mesh geometryspan into the drawable
-    // to get it back to it's pristine condition.
-    for (size_t i = 0; i < mInfo.fMesh->fSpans.size(); i++)
+    if (!mInfo.fEvaluator.IsCurrent(morphs, &mInfo.fArrayWeights))
     {
-        plAccessSpan dstAcc;
-        plAccessGeometry::Instance()->OpenRW(mInfo.fCurrDraw, mInfo.fCurrIdx[i], dstAcc);
+        std::vector<plAccessSpan> dst;
+        for (size_t i = 0; i < mInfo.fMesh->fSpans.size(); i++)
+        {
+            plAccessSpan dstAcc;
+            plAccessGeometry::Instance()->OpenRW(mInfo.fCurrDraw, mInfo.fCurrIdx[i], dstAcc);
 
-        dst.emplace_back(dstAcc);
-    }
+            dst.emplace_back(dstAcc);
+        }
 
-    // For each MorphArray
-    for (size_t i = 0; i < mInfo.fMesh->fMorphSet->fMorphs.size(); i++)
-    {
-        // Apply Delta
-        mInfo.fMesh->fMorphSet->fMorphs[i].Apply(dst, &mInfo.fArrayWeights[i].fDeltaWeights);
-    }
+        if (!mInfo.fEvaluator.Update(morphs, &mInfo.fArrayWeights, dst))
+        {
+            // Start over from the shared mesh geometryspans, which are
+            // still in their pristine condition.
+            std::vector<plAccessSpan> base(mInfo.fMesh->fSpans.size());
+            for (size_t i = 0; i < mInfo.fMesh->fSpans.size(); i++)
+                plAccessGeometry::Instance()->AccessSpanFromGeometrySpan(base[i], mInfo.fMesh->fSpans[i]);
 
-    IRenormalize(dst);
+            mInfo.fEvaluator.Rebuild(base, morphs, &mInfo.fArrayWeights, dst);
+        }
 
-    // Close up the access spans
-    plAccessGeometry::Instance()->Close(dst);
+        // Close up the access spans
+        plAccessGeometry::Instance()->Close(dst);
+    }
     mInfo.fFlags &= ~plSharedMeshInfo::kInfoDirtyMesh;
 }
 
@@ -577,6 +571,7 @@ bool plMorphSequence::IResetShared(size_t iShare)
         return false;
 
     plSharedMeshInfo& mInfo = fSharedMeshes[iShare];
+    mInfo.fEvaluator.Invalidate();
 
     // Now copy each shared mesh geometryspan into the drawable
     // to get it back to it's pristine condition.
@@ -609,6 +604,7 @@ bool plMorphSequence::IFindIndices(size_t iShare)
 {
     plSharedMeshInfo& mInfo = fSharedMeshes[iShare];
     mInfo.fCurrDraw = nullptr; // In case we fail.
+    mInfo.fEvaluator.Invalidate(); // The spans may have been (re)filled under us
 
     const plInstanceDrawInterface* di = plInstanceDrawInterface::ConvertNoRef(IGetDrawInterface());
     if( !di )
@@ -640,6 +636,7 @@ void plMorphSequence::IReleaseIndices(size_t iShare)
 {
     plSharedMeshInfo& mInfo = fSharedMeshes[iShare];
     mInfo.fCurrDraw = nullptr;
+    mInfo.fEvaluator.Invalidate();
 }
 
 hsSsize_t plMorphSequence::IFindSharedMeshIndex(const plKey& meshKey) const
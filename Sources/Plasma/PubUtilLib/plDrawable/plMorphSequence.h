@@ -47,17 +47,13 @@ You can contact Cyan Worlds, Inc. by email legal@cyan.com
 
 #include "pnModifier/plSingleModifier.h"
 #include "plMorphArray.h"
+#include "plMorphEvaluator.h"
 
 class plDrawable;
 class plDrawInterface;
 class plSharedMesh;
 class plMorphSequenceSDLMod;
 
-struct plMorphArrayWeights
-{
-    std::vector<float> fDeltaWeights;
-};
-
 class plSharedMeshInfo
 {
 public:
@@ -71,6 +67,7 @@ public:
     plDrawable*         fCurrDraw;
     std::vector<plMorphArrayWeights> fArrayWeights;
     uint8_t               fFlags;
+    plMorphEvaluator    fEvaluator;
 
     plSharedMeshInfo() : fMesh(), fCurrDraw(), fFlags() { }
 };
@@ -116,6 +113,7 @@ protected:
     std::vector<plMorphState>   fPendingStates;
     plMorphSequenceSDLMod*      fMorphSDLMod;
     int8_t                        fGlobalLayerRef;
+    mutable plMorphEvaluator    fEvaluator; // What Apply() last left in the draw interface
 
     const plDrawInterface*      IGetDrawInterface() const;
 
@@ -129,8 +127,6 @@ protected:
     bool        IFindIndices(size_t iShare);
     void        IReleaseIndices(size_t iShare);
 
-    void        IRenormalize(std::vector<plAccessSpan>& dst) const;
-
     void        IResetShared();
     void        IReleaseIndices(); // Puts everyone inactive
     void        IFindIndices(); // Refresh Indicies
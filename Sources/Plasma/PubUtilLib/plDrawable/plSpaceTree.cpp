@@ -46,6 +46,8 @@ You can contact Cyan Worlds, Inc. by email legal@cyan.com
 #include "hsBitVector.h"
 #include "plProfile.h"
 
+#include <limits>
+
 #include "plIntersect/plVolumeIsect.h"
 #include "plMath/hsRadixSort.h"
 
@@ -54,6 +56,64 @@ static hsBitVector scratchBitVec;
 
 plProfile_CreateCounter("Harvest Leaves", "Draw", HarvestLeaves);
 
+bool plSpaceTree::fWideHarvest = true;
+
+static plSpaceTreeCullVolume scratchCullVolume;
+
+// The kernels must come up with bit for bit the same answers as the
+// plVolumeIsect::Test they stand in for (hsBounds3::TestPlane for the slabs),
+// so keep the order of operations exactly as it is there.
+void plSpaceTree::classify_wide_fpu(const plSpaceTreeWideNode& wide, const plSpaceTreeCullVolume& vol,
+                                    uint8_t& culledMask, uint8_t& splitMask)
+{
+    culledMask = splitMask = 0;
+    for (int i = 0; i < plSpaceTreeWideNode::kNumSlots; i++)
+    {
+        bool culled = false;
+        bool split = false;
+        if (vol.fType == plSpaceTreeCullVolume::kBox)
+        {
+            for (int j = 0; j < 3; j++)
+            {
+                culled |= (wide.fMaxs[j][i] < vol.fMins[j]) || (wide.fMins[j][i] > vol.fMaxs[j]);
+                split |= (wide.fMaxs[j][i] > vol.fMaxs[j]) || (wide.fMins[j][i] < vol.fMins[j]);
+            }
+        }
+        else
+        {
+            for (const plSpaceTreeCullVolume::Slab& slab : vol.fSlabs)
+            {
+                float dmax = wide.fMins[0][i] * slab.fNorm.fX;
+                dmax += wide.fMins[1][i] * slab.fNorm.fY;
+                dmax += wide.fMins[2][i] * slab.fNorm.fZ;
+                float dmin = dmax;
+                for (int j = 0; j < 3; j++)
+                {
+                    float dd = wide.fMaxs[j][i] - wide.fMins[j][i];
+                    dd *= slab.fNorm[j];
+                    if (dd < 0)
+                        dmin += dd;
+                    else
+                        dmax += dd;
+                }
+                culled |= (dmax < slab.fMin) || (dmin > slab.fMax);
+                split |= (dmin < slab.fMin) || (dmax > slab.fMax);
+            }
+        }
+        if (culled)
+            culledMask |= (1 << i);
+        if (split)
+            splitMask |= (1 << i);
+    }
+}
+
+// CPU-optimized functions requiring dispatch
+hsCpuFunctionDispatcher<plSpaceTree::classify_wide_ptr> plSpaceTree::classify_wide {
+    &plSpaceTree::classify_wide_fpu,
+    nullptr,            // SSE1
+    &plSpaceTree::classify_wide_sse2
+};
+
 void plSpaceTreeNode::Read(hsStream* s)
 {
     fWorldBounds.Read(s);
@@ -82,7 +142,8 @@ void plSpaceTreeNode::Write(hsStream* s)
 plSpaceTree::plSpaceTree()
 :   fCullFunc(),
     fNumLeaves(),
-    fCache()
+    fCache(),
+    fWideDirty(true)
 {
 }
 
@@ -96,6 +157,8 @@ void plSpaceTree::IRefreshRecur(int16_t which)
 
     if( sub.fFlags & plSpaceTreeNode::kIsLeaf )
     {
+        if( sub.fFlags & plSpaceTreeNode::kDirty )
+            IRefitWideSlot(which);
         sub.fFlags &= ~plSpaceTreeNode::kDirty;
         return;
     }
@@ -111,6 +174,7 @@ void plSpaceTree::IRefreshRecur(int16_t which)
         if( !(fTree[sub.fChildren[1]].fFlags & plSpaceTreeNode::kDisabled) )
             sub.fWorldBounds.Union(&fTree[sub.fChildren[1]].fWorldBounds);
 
+        IRefitWideSlot(which);
         sub.fFlags &= ~plSpaceTreeNode::kDirty;
     }
 }
@@ -134,6 +198,8 @@ void plSpaceTree::SetTreeFlag(uint16_t f, bool on)
 
     for (plSpaceTreeNode& node : fTree)
         node.fFlags |= f;
+    if( f & plSpaceTreeNode::kDisabled )
+        fWideDirty = true;
 }
 
 void plSpaceTree::ClearTreeFlag(uint16_t f)
@@ -143,6 +209,8 @@ void plSpaceTree::ClearTreeFlag(uint16_t f)
 
     for (plSpaceTreeNode& node : fTree)
         node.fFlags &= ~f;
+    if( f & plSpaceTreeNode::kDisabled )
+        fWideDirty = true;
 }
 
 void plSpaceTree::SetLeafFlag(int16_t idx, uint16_t f, bool on)
@@ -159,6 +227,8 @@ void plSpaceTree::SetLeafFlag(int16_t idx, uint16_t f, bool on)
     }
 
     fTree[idx].fFlags |= f;
+    if( f & plSpaceTreeNode::kDisabled )
+        IUpdateWideDisabled(idx);
 
     idx = fTree[idx].fParent;
 
@@ -172,6 +242,8 @@ void plSpaceTree::SetLeafFlag(int16_t idx, uint16_t f, bool on)
         else
         {
             fTree[idx].fFlags |= f;
+            if( f & plSpaceTreeNode::kDisabled )
+                IUpdateWideDisabled(idx);
             idx = fTree[idx].fParent;
         }
     }
@@ -190,6 +262,8 @@ void plSpaceTree::ClearLeafFlag(int16_t idx, uint16_t f)
         else
         {
             fTree[idx].fFlags &= ~f;
+            if( f & plSpaceTreeNode::kDisabled )
+                IUpdateWideDisabled(idx);
             idx = fTree[idx].fParent;
         }
     }
@@ -288,7 +362,12 @@ void plSpaceTree::HarvestEnabledLeaves(plVolumeIsect* cull, const hsBitVector& c
 
     fCullFunc = cull;
     if (fCullFunc)
-        IHarvestAndCullEnabledLeaves(fRoot, cache, list);
+    {
+        if (IPrepWideHarvest())
+            IHarvestAndCullWideEnabledLeaves(cache, list);
+        else
+            IHarvestAndCullEnabledLeaves(fRoot, cache, list);
+    }
     else
         IHarvestEnabledLeaves(fRoot, cache, list);
 }
@@ -370,7 +449,12 @@ void plSpaceTree::HarvestLeaves(plVolumeIsect* cull, hsBitVector& list) const
     {
         fCullFunc = cull;
         if (fCullFunc)
-            IHarvestAndCullLeaves(fTree[fRoot], scratchTotVec, list);
+        {
+            if (IPrepWideHarvest())
+                IHarvestAndCullWideLeaves(list);
+            else
+                IHarvestAndCullLeaves(fTree[fRoot], scratchTotVec, list);
+        }
         else
             IHarvestLeaves(fTree[fRoot], scratchTotVec, list);
     }
@@ -524,6 +608,325 @@ void plSpaceTree::IHarvestLeaves(const plSpaceTreeNode& subRoot, std::vector<int
     }
 }
 
+///////////////////////////////////////////////////////////////////////////
+// Wide node harvesting. The wide tree is rebuilt from the binary tree the
+// first time a culled harvest comes through after its shape has changed.
+// Moved leaves only refit the bounds of the slots they touch.
+// Both levels held in a wide node get tested, so that a child which is
+// culled or clear decides for its grandchildren exactly like the recursive
+// version, and only split grandchildren go on to their own wide node.
+///////////////////////////////////////////////////////////////////////////
+
+bool plSpaceTree::IPrepWideTree() const
+{
+    // Stale bounds don't nest, let the recursive version deal with them.
+    if( !fWideHarvest || IsEmpty() || IsDirty() || IsLeaf(fRoot) )
+        return false;
+
+    if( fWideDirty )
+        IBuildWideTree();
+
+    return true;
+}
+
+bool plSpaceTree::IPrepWideHarvest() const
+{
+    if( !IPrepWideTree() )
+        return false;
+
+    plSpaceTreeCullVolume& vol = scratchCullVolume;
+    vol.fSlabs.clear();
+    if (const plSphereIsect* sphere = plSphereIsect::ConvertNoRef(fCullFunc))
+    {
+        vol.fType = plSpaceTreeCullVolume::kBox;
+        vol.fMins = sphere->GetWorldMins();
+        vol.fMaxs = sphere->GetWorldMaxs();
+    }
+    else if (const plConvexIsect* convex = plConvexIsect::ConvertNoRef(fCullFunc))
+    {
+        vol.fType = plSpaceTreeCullVolume::kSlabs;
+        for (size_t i = 0; i < convex->GetNumPlanes(); i++)
+        {
+            vol.fSlabs.push_back({ convex->GetWorldNorm(i),
+                                   -std::numeric_limits<float>::infinity(),
+                                   convex->GetWorldDist(i) });
+        }
+    }
+    else if (const plParallelIsect* par = plParallelIsect::ConvertNoRef(fCullFunc))
+    {
+        vol.fType = plSpaceTreeCullVolume::kSlabs;
+        for (size_t i = 0; i < par->GetNumPlanes(); i++)
+            vol.fSlabs.push_back({ par->GetPlaneNorm(i), par->GetPlaneMin(i), par->GetPlaneMax(i) });
+    }
+    else
+    {
+        vol.fType = plSpaceTreeCullVolume::kGeneric;
+    }
+
+    return true;
+}
+
+void plSpaceTree::IBuildWideTree() const
+{
+    fWideTree.clear();
+    fWideTree.reserve(fTree.size() / 3 + 1);
+    fWideSlots.assign(fTree.size(), -1);
+    IBuildWideRecur(fRoot);
+
+    fWideDirty = false;
+}
+
+int16_t plSpaceTree::IBuildWideRecur(int16_t binIdx) const
+{
+    auto wideIdx = (int16_t)fWideTree.size();
+    fWideTree.emplace_back();
+
+    plSpaceTreeWideNode wide;
+    wide.fScalarMask = wide.fLeafMask = wide.fDisabledMask = 0;
+    for (int i = 0; i < plSpaceTreeWideNode::kNumSlots; i++)
+        ISetWideSlot(wide, wideIdx, i, -1);
+
+    const plSpaceTreeNode& node = fTree[binIdx];
+    for (int i = 0; i < plSpaceTreeWideNode::kNumChildSlots; i++)
+    {
+        const plSpaceTreeNode& child = fTree[node.fChildren[i]];
+        ISetWideSlot(wide, wideIdx, i, node.fChildren[i]);
+        if( child.fFlags & plSpaceTreeNode::kIsLeaf )
+            continue;
+
+        for (int j = 0; j < 2; j++)
+        {
+            int slot = plSpaceTreeWideNode::GrandSlot(i, j);
+            ISetWideSlot(wide, wideIdx, slot, child.fChildren[j]);
+            if( !(fTree[child.fChildren[j]].fFlags & plSpaceTreeNode::kIsLeaf) )
+                wide.fWide[slot] = IBuildWideRecur(child.fChildren[j]);
+        }
+    }
+
+    fWideTree[wideIdx] = wide;
+    return wideIdx;
+}
+
+void plSpaceTree::ISetWideSlot(plSpaceTreeWideNode& wide, int16_t wideIdx, int slot, int16_t binIdx) const
+{
+    wide.fNode[slot] = binIdx;
+    wide.fWide[slot] = -1;
+    if( binIdx < 0 )
+    {
+        for (int j = 0; j < 3; j++)
+            wide.fMins[j][slot] = wide.fMaxs[j][slot] = 0;
+        return;
+    }
+
+    const plSpaceTreeNode& node = fTree[binIdx];
+    fWideSlots[binIdx] = (int32_t(wideIdx) << 3) | slot;
+    if( node.fFlags & plSpaceTreeNode::kIsLeaf )
+        wide.fLeafMask |= (1 << slot);
+    if( node.fFlags & plSpaceTreeNode::kDisabled )
+        wide.fDisabledMask |= (1 << slot);
+
+    ISetWideBounds(wide, slot, node.fWorldBounds);
+}
+
+void plSpaceTree::ISetWideBounds(plSpaceTreeWideNode& wide, int slot, const hsBounds3Ext& bnd) const
+{
+    if( (bnd.GetType() == kBoundsNormal) && bnd.IsAxisAligned() )
+    {
+        wide.fScalarMask &= ~(1 << slot);
+        for (int j = 0; j < 3; j++)
+        {
+            wide.fMins[j][slot] = bnd.GetMins()[j];
+            wide.fMaxs[j][slot] = bnd.GetMaxs()[j];
+            wide.fCenters[j][slot] = bnd.GetCenter()[j];
+        }
+        wide.fRadii[slot] = bnd.GetRadius();
+    }
+    else
+    {
+        wide.fScalarMask |= (1 << slot);
+        for (int j = 0; j < 3; j++)
+            wide.fMins[j][slot] = wide.fMaxs[j][slot] = wide.fCenters[j][slot] = 0;
+        wide.fRadii[slot] = 0;
+    }
+}
+
+int16_t plSpaceTree::FindWideNode(int16_t w) const
+{
+    if( !IPrepWideTree() || IsLeaf(w) )
+        return -1;
+
+    if( w == fRoot )
+        return 0;
+
+    // Only grandchild slots head wide nodes of their own.
+    int32_t slot = fWideSlots[w];
+    if( (slot < 0) || ((slot & 7) < plSpaceTreeWideNode::kFirstGrandSlot) )
+        return -1;
+    return fWideTree[slot >> 3].fWide[slot & 7];
+}
+
+// Moving things around doesn't change the shape of the tree, so the wide
+// nodes just pick up the new bounds as the binary ones are refreshed.
+void plSpaceTree::IRefitWideSlot(int16_t idx)
+{
+    if( fWideDirty || (fWideSlots[idx] < 0) )
+        return;
+
+    ISetWideBounds(fWideTree[fWideSlots[idx] >> 3], fWideSlots[idx] & 7, fTree[idx].fWorldBounds);
+}
+
+void plSpaceTree::IUpdateWideDisabled(int16_t idx)
+{
+    if( fWideDirty || (fWideSlots[idx] < 0) )
+        return;
+
+    plSpaceTreeWideNode& wide = fWideTree[fWideSlots[idx] >> 3];
+    uint8_t bit = 1 << (fWideSlots[idx] & 7);
+    if( fTree[idx].fFlags & plSpaceTreeNode::kDisabled )
+        wide.fDisabledMask |= bit;
+    else
+        wide.fDisabledMask &= ~bit;
+}
+
+void plSpaceTree::IClassifyWide(const plSpaceTreeWideNode& wide, uint8_t* res) const
+{
+    uint8_t scalar = 0xff;
+    if( scratchCullVolume.fType != plSpaceTreeCullVolume::kGeneric )
+    {
+        uint8_t culled, split;
+        classify_wide.call(wide, scratchCullVolume, culled, split);
+        for (int i = 0; i < plSpaceTreeWideNode::kNumSlots; i++)
+        {
+            if( culled & (1 << i) )
+                res[i] = kVolumeCulled;
+            else
+                res[i] = (split & (1 << i)) ? kVolumeSplit : kVolumeClear;
+        }
+        scalar = wide.fScalarMask;
+    }
+
+    for (int i = 0; scalar && i < plSpaceTreeWideNode::kNumSlots; i++, scalar >>= 1)
+    {
+        if( (scalar & 1) && (wide.fNode[i] >= 0) )
+            res[i] = fCullFunc->Test(fTree[wide.fNode[i]].fWorldBounds);
+    }
+}
+
+void plSpaceTree::IHarvestAndCullWideLeaves(hsBitVector& list) const
+{
+    const plSpaceTreeNode& subRoot = fTree[fRoot];
+    if( subRoot.fFlags & plSpaceTreeNode::kDisabled )
+        return;
+
+    plVolumeCullResult res = fCullFunc->Test(subRoot.fWorldBounds);
+    if( res == kVolumeCulled )
+        return;
+
+    if( res == kVolumeClear )
+        IHarvestLeaves(subRoot, scratchTotVec, list);
+    else
+        IHarvestWideNode(0, list);
+}
+
+void plSpaceTree::IHarvestWideNode(int16_t wideIdx, hsBitVector& list) const
+{
+    const plSpaceTreeWideNode& wide = fWideTree[wideIdx];
+
+    uint8_t res[plSpaceTreeWideNode::kNumSlots];
+    IClassifyWide(wide, res);
+
+    for (int i = 0; i < plSpaceTreeWideNode::kNumChildSlots; i++)
+    {
+        if( (res[i] == kVolumeCulled) || (wide.fDisabledMask & (1 << i)) )
+            continue;
+
+        if( wide.fLeafMask & (1 << i) )
+        {
+            plProfile_Inc(HarvestLeaves);
+            list.SetBit(wide.fNode[i]);
+            continue;
+        }
+        if( res[i] == kVolumeClear )
+        {
+            IHarvestLeaves(fTree[wide.fNode[i]], scratchTotVec, list);
+            continue;
+        }
+
+        for (int j = 0; j < 2; j++)
+        {
+            int slot = plSpaceTreeWideNode::GrandSlot(i, j);
+            if( (res[slot] == kVolumeCulled) || (wide.fDisabledMask & (1 << slot)) )
+                continue;
+
+            if( wide.fLeafMask & (1 << slot) )
+            {
+                plProfile_Inc(HarvestLeaves);
+                list.SetBit(wide.fNode[slot]);
+            }
+            else if( res[slot] == kVolumeClear )
+                IHarvestLeaves(fTree[wide.fNode[slot]], scratchTotVec, list);
+            else
+                IHarvestWideNode(wide.fWide[slot], list);
+        }
+    }
+}
+
+void plSpaceTree::IHarvestAndCullWideEnabledLeaves(const hsBitVector& cache, std::vector<int16_t>& list) const
+{
+    if( !cache.IsBitSet(fRoot) )
+        return;
+
+    plVolumeCullResult res = fCullFunc->Test(fTree[fRoot].fWorldBounds);
+    if( res == kVolumeCulled )
+        return;
+
+    if( res == kVolumeClear )
+        IHarvestEnabledLeaves(fRoot, cache, list);
+    else
+        IHarvestWideNode(0, cache, list);
+}
+
+void plSpaceTree::IHarvestWideNode(int16_t wideIdx, const hsBitVector& cache, std::vector<int16_t>& list) const
+{
+    const plSpaceTreeWideNode& wide = fWideTree[wideIdx];
+
+    uint8_t res[plSpaceTreeWideNode::kNumSlots];
+    IClassifyWide(wide, res);
+
+    for (int i = 0; i < plSpaceTreeWideNode::kNumChildSlots; i++)
+    {
+        int16_t childIdx = wide.fNode[i];
+        if( (res[i] == kVolumeCulled) || !cache.IsBitSet(childIdx) )
+            continue;
+
+        if( wide.fLeafMask & (1 << i) )
+        {
+            list.emplace_back(childIdx);
+            continue;
+        }
+        if( res[i] == kVolumeClear )
+        {
+            IHarvestEnabledLeaves(childIdx, cache, list);
+            continue;
+        }
+
+        for (int j = 0; j < 2; j++)
+        {
+            int slot = plSpaceTreeWideNode::GrandSlot(i, j);
+            int16_t grandIdx = wide.fNode[slot];
+            if( (res[slot] == kVolumeCulled) || !cache.IsBitSet(grandIdx) )
+                continue;
+
+            if( wide.fLeafMask & (1 << slot) )
+                list.emplace_back(grandIdx);
+            else if( res[slot] == kVolumeClear )
+                IHarvestEnabledLeaves(grandIdx, cache, list);
+            else
+                IHarvestWideNode(wide.fWide[slot], cache, list);
+        }
+    }
+}
+
 void plSpaceTree::Read(hsStream* s, hsResMgr* mgr)
 {
     plCreatable::Read(s, mgr);
@@ -536,6 +939,8 @@ void plSpaceTree::Read(hsStream* s, hsResMgr* mgr)
     fTree.resize(n);
     for (uint32_t i = 0; i < n; i++)
         fTree[i].Read(s);
+
+    fWideDirty = true;
 }
 
 void plSpaceTree::Write(hsStream* s, hsResMgr* mgr)
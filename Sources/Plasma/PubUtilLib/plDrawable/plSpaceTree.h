@@ -46,6 +46,7 @@ You can contact Cyan Worlds, Inc. by email legal@cyan.com
 #include <vector>
 
 #include "hsBounds.h"
+#include "hsCpuID.h"
 #include "pnFactory/plCreatable.h"
 #include "hsBitVector.h"
 
@@ -86,6 +87,59 @@ public:
     void                Write(hsStream* s);
 };
 
+// Runtime only, never written out. Each wide node stands in for an interior
+// node of the binary tree, holding the bounds of its two children and up to
+// four grandchildren as float AABBs in SoA layout, so a culling volume can
+// classify the whole node in one go instead of two levels of virtual calls.
+class plSpaceTreeWideNode
+{
+public:
+    enum {
+        kNumChildSlots      = 2,
+        kFirstGrandSlot     = 4, // 2 and 3 are padding
+        kNumSlots           = 8
+    };
+
+    alignas(16) float   fMins[3][kNumSlots];
+    alignas(16) float   fMaxs[3][kNumSlots];
+    alignas(16) float   fCenters[3][kNumSlots]; // Bounding spheres, for cullers that try those first
+    alignas(16) float   fRadii[kNumSlots];
+
+    int16_t               fNode[kNumSlots]; // Index into the binary tree, -1 if unused
+    int16_t               fWide[kNumSlots]; // Wide node of an interior grandchild, else -1
+    uint8_t               fScalarMask; // Slots whose bounds can't be tested as plain AABBs
+    uint8_t               fLeafMask;
+    uint8_t               fDisabledMask; // Mirrors kDisabled, so harvesting never touches fTree
+
+    static int          GrandSlot(int child, int grand) { return kFirstGrandSlot + child * 2 + grand; }
+};
+
+// Flattened form of the culling volume for the wide node kernels. Spheres
+// only ever look at the box of the bounds, and convex and parallel isects
+// are both sets of slabs (a convex plane is a slab with no lower bound).
+// Anything else gets tested one slot at a time through the virtual Test.
+class plSpaceTreeCullVolume
+{
+public:
+    enum Type
+    {
+        kBox,
+        kSlabs,
+        kGeneric
+    };
+    struct Slab
+    {
+        hsVector3   fNorm;
+        float       fMin;
+        float       fMax;
+    };
+
+    Type                fType;
+    hsPoint3            fMins;
+    hsPoint3            fMaxs;
+    std::vector<Slab>   fSlabs;
+};
+
 
 class plSpaceTree : public plCreatable
 {
@@ -111,6 +165,12 @@ private:
 
     hsPoint3                        fViewPos;
 
+    mutable std::vector<plSpaceTreeWideNode> fWideTree;
+    mutable std::vector<int32_t>    fWideSlots; // Per binary node, wide node << 3 | slot, -1 for the root
+    mutable bool                    fWideDirty;
+
+    static bool                     fWideHarvest;
+
     void        IRefreshRecur(int16_t which);
     
     void        IHarvestAndCullLeaves(const plSpaceTreeNode& subRoot, std::vector<int16_t>& list) const;
@@ -127,6 +187,27 @@ private:
 
     void        IEnableLeaf(int16_t idx, hsBitVector& cache) const;
 
+    bool        IPrepWideTree() const;
+    bool        IPrepWideHarvest() const;
+    void        IBuildWideTree() const;
+    int16_t     IBuildWideRecur(int16_t binIdx) const;
+    void        ISetWideSlot(plSpaceTreeWideNode& wide, int16_t wideIdx, int slot, int16_t binIdx) const;
+    void        ISetWideBounds(plSpaceTreeWideNode& wide, int slot, const hsBounds3Ext& bnd) const;
+    void        IRefitWideSlot(int16_t idx);
+    void        IUpdateWideDisabled(int16_t idx);
+    void        IClassifyWide(const plSpaceTreeWideNode& wide, uint8_t* res) const;
+
+    //  CPU-optimized functions
+    typedef void(*classify_wide_ptr)(const plSpaceTreeWideNode&, const plSpaceTreeCullVolume&, uint8_t&, uint8_t&);
+    static hsCpuFunctionDispatcher<classify_wide_ptr> classify_wide;
+    static void classify_wide_fpu(const plSpaceTreeWideNode& wide, const plSpaceTreeCullVolume& vol, uint8_t& culled, uint8_t& split);
+    static void classify_wide_sse2(const plSpaceTreeWideNode& wide, const plSpaceTreeCullVolume& vol, uint8_t& culled, uint8_t& split);
+
+    void        IHarvestAndCullWideLeaves(hsBitVector& list) const;
+    void        IHarvestWideNode(int16_t wideIdx, hsBitVector& list) const;
+    void        IHarvestAndCullWideEnabledLeaves(const hsBitVector& cache, std::vector<int16_t>& list) const;
+    void        IHarvestWideNode(int16_t wideIdx, const hsBitVector& cache, std::vector<int16_t>& list) const;
+
 public:
     plSpaceTree();
     virtual ~plSpaceTree();
@@ -184,6 +265,17 @@ public:
 
     void HarvestLevel(int level, std::vector<int16_t>& list) const;
 
+    // Culled harvests go through the wide node layout unless this is turned off.
+    // Results are identical either way, this is only here for benchmarking.
+    static void EnableWideHarvest(bool on) { fWideHarvest = on; }
+    static bool WideHarvestEnabled() { return fWideHarvest; }
+
+    // For cullers that walk the wide nodes themselves (plCullTree). Returns the
+    // wide node headed by interior node w, or -1 if w doesn't head one, wide
+    // harvests are off, or the tree is waiting on a Refresh.
+    int16_t FindWideNode(int16_t w) const;
+    const plSpaceTreeWideNode& GetWideNode(int16_t i) const { return fWideTree[i]; }
+
     friend class plSpaceTreeMaker;
 };
 
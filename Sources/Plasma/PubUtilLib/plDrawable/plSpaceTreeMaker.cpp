@@ -49,6 +49,9 @@ You can contact Cyan Worlds, Inc. by email legal@cyan.com
 #include "hsTimer.h"
 #include "plIntersect/plVolumeIsect.h"
 
+#include <algorithm>
+#include <limits>
+
 //#define MF_DO_TIMES
 
 enum mfTimeTypes
@@ -154,13 +157,69 @@ void plSpaceTreeMaker::ISortList(std::vector<plSpacePrepNode*>& nodes, const hsV
     return;
 }
 
+// Half the surface area of a box, which is all the SAH cares about.
+static inline float ISurfaceArea(const hsPoint3& mins, const hsPoint3& maxs)
+{
+    hsVector3 del(&maxs, &mins);
+    return del.fX * del.fY + del.fY * del.fZ + del.fZ * del.fX;
+}
+
+// Picks where to cut a list already sorted along the split axis, using the
+// surface area heuristic: the chance a volume reaching the parent also
+// reaches a child goes with the child's surface area, so we minimize
+// area times count summed over both sides. Ties go to the most even split.
+size_t plSpaceTreeMaker::ISAHSplitCount(const std::vector<plSpacePrepNode*>& nodes)
+{
+    const size_t n = nodes.size();
+    if( n <= 2 )
+        return n / 2;
+
+    std::vector<float> upperArea(n);
+    hsPoint3 mins = nodes[n-1]->fWorldBounds.GetMins();
+    hsPoint3 maxs = nodes[n-1]->fWorldBounds.GetMaxs();
+    for (size_t i = n; i-- > 1; )
+    {
+        const hsBounds3Ext& bnd = nodes[i]->fWorldBounds;
+        for (int j = 0; j < 3; j++)
+        {
+            mins[j] = std::min(mins[j], bnd.GetMins()[j]);
+            maxs[j] = std::max(maxs[j], bnd.GetMaxs()[j]);
+        }
+        upperArea[i] = ISurfaceArea(mins, maxs);
+    }
+
+    size_t bestCount = n / 2;
+    float bestCost = std::numeric_limits<float>::max();
+    mins = nodes[0]->fWorldBounds.GetMins();
+    maxs = nodes[0]->fWorldBounds.GetMaxs();
+    for (size_t i = 1; i < n; i++)
+    {
+        const hsBounds3Ext& bnd = nodes[i-1]->fWorldBounds;
+        for (int j = 0; j < 3; j++)
+        {
+            mins[j] = std::min(mins[j], bnd.GetMins()[j]);
+            maxs[j] = std::max(maxs[j], bnd.GetMaxs()[j]);
+        }
+        float cost = ISurfaceArea(mins, maxs) * float(i) + upperArea[i] * float(n - i);
+        size_t balance = i > n / 2 ? i - n / 2 : n / 2 - i;
+        size_t bestBalance = bestCount > n / 2 ? bestCount - n / 2 : n / 2 - bestCount;
+        if( (cost < bestCost) || ((cost == bestCost) && (balance < bestBalance)) )
+        {
+            bestCost = cost;
+            bestCount = i;
+        }
+    }
+
+    return bestCount;
+}
+
 void plSpaceTreeMaker::ISplitList(std::vector<plSpacePrepNode*>& nodes, const hsVector3& axis,
                                   std::vector<plSpacePrepNode*>& lower, std::vector<plSpacePrepNode*>& upper)
 {
 
     ISortList(nodes, axis);
 
-    size_t lowerCount = nodes.size() / 2;
+    size_t lowerCount = ISAHSplitCount(nodes);
     size_t upperCount = nodes.size() - lowerCount;
     lower.resize(lowerCount);
     upper.resize(upperCount);
@@ -77,6 +77,7 @@ protected:
     plSpacePrepNode*                INewSubRoot(const hsBounds3Ext& bnd);
     void                            IFindBigList(std::vector<plSpacePrepNode*>& nodes, float length, const hsVector3& axis, std::vector<plSpacePrepNode*>& giants, std::vector<plSpacePrepNode*>& strimp);
     void                            ISortList(std::vector<plSpacePrepNode*>& nodes, const hsVector3& axis);
+    size_t                          ISAHSplitCount(const std::vector<plSpacePrepNode*>& nodes);
     void                            ISplitList(std::vector<plSpacePrepNode*>& nodes, const hsVector3& axis, std::vector<plSpacePrepNode*>& lower, std::vector<plSpacePrepNode*>& upper);
     hsBounds3Ext                    IFindDistToCenterAxis(std::vector<plSpacePrepNode*>& nodes, float& length, hsVector3& axis);
     plSpacePrepNode*                IMakeFatTreeRecur(std::vector<plSpacePrepNode*>& nodes);
@@ -0,0 +1,107 @@
+/*==LICENSE==*
+
+CyanWorlds.com Engine - MMOG client, server and tools
+Copyright (C) 2011  Cyan Worlds, Inc.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+Additional permissions under GNU GPL version 3 section 7
+
+If you modify this Program, or any covered work, by linking or
+combining it with any of RAD Game Tools Bink SDK, Autodesk 3ds Max SDK,
+NVIDIA PhysX SDK, Microsoft DirectX SDK, OpenSSL library, Independent
+JPEG Group JPEG library, Microsoft Windows Media SDK, or Apple QuickTime SDK
+(or a modified version of those libraries),
+containing parts covered by the terms of the Bink SDK EULA, 3ds Max EULA,
+PhysX SDK EULA, DirectX SDK EULA, OpenSSL and SSLeay licenses, IJG
+JPEG Library README, Windows Media SDK EULA, or QuickTime SDK EULA, the
+licensors of this Program grant you additional
+permission to convey the resulting work. Corresponding Source for a
+non-source form of such a combination shall include the source code for
+the parts of OpenSSL and IJG JPEG Library used as well as that of the covered
+work.
+
+You can contact Cyan Worlds, Inc. by email legal@cyan.com
+ or by snail mail at:
+      Cyan Worlds, Inc.
+      14617 N Newport Hwy
+      Mead, WA   99021
+
+*==LICENSE==*/
+
+#include "HeadSpin.h"
+#include "plSpaceTree.h"
+
+#ifdef HAVE_SSE2
+#   include <emmintrin.h>
+#endif
+
+void plSpaceTree::classify_wide_sse2(const plSpaceTreeWideNode& wide, const plSpaceTreeCullVolume& vol,
+                                     uint8_t& culledMask, uint8_t& splitMask)
+{
+    culledMask = splitMask = 0;
+
+#ifdef HAVE_SSE2
+    for (int i = 0; i < plSpaceTreeWideNode::kNumSlots; i += 4)
+    {
+        __m128 mins[3];
+        __m128 maxs[3];
+        for (int j = 0; j < 3; j++)
+        {
+            mins[j] = _mm_load_ps(&wide.fMins[j][i]);
+            maxs[j] = _mm_load_ps(&wide.fMaxs[j][i]);
+        }
+
+        __m128 culled = _mm_setzero_ps();
+        __m128 split = _mm_setzero_ps();
+        if (vol.fType == plSpaceTreeCullVolume::kBox)
+        {
+            for (int j = 0; j < 3; j++)
+            {
+                __m128 volMin = _mm_set1_ps(vol.fMins[j]);
+                __m128 volMax = _mm_set1_ps(vol.fMaxs[j]);
+                culled = _mm_or_ps(culled, _mm_or_ps(_mm_cmplt_ps(maxs[j], volMin), _mm_cmpgt_ps(mins[j], volMax)));
+                split = _mm_or_ps(split, _mm_or_ps(_mm_cmpgt_ps(maxs[j], volMax), _mm_cmplt_ps(mins[j], volMin)));
+            }
+        }
+        else
+        {
+            // Adding zero instead of branching leaves dmin and dmax exactly
+            // where the branchy version in hsBounds3::TestPlane puts them.
+            const __m128 zero = _mm_setzero_ps();
+            for (const plSpaceTreeCullVolume::Slab& slab : vol.fSlabs)
+            {
+                __m128 dmax = _mm_mul_ps(mins[0], _mm_set1_ps(slab.fNorm.fX));
+                dmax = _mm_add_ps(dmax, _mm_mul_ps(mins[1], _mm_set1_ps(slab.fNorm.fY)));
+                dmax = _mm_add_ps(dmax, _mm_mul_ps(mins[2], _mm_set1_ps(slab.fNorm.fZ)));
+                __m128 dmin = dmax;
+                for (int j = 0; j < 3; j++)
+                {
+                    __m128 dd = _mm_mul_ps(_mm_sub_ps(maxs[j], mins[j]), _mm_set1_ps(slab.fNorm[j]));
+                    __m128 neg = _mm_cmplt_ps(dd, zero);
+                    dmin = _mm_add_ps(dmin, _mm_and_ps(neg, dd));
+                    dmax = _mm_add_ps(dmax, _mm_andnot_ps(neg, dd));
+                }
+                __m128 slabMin = _mm_set1_ps(slab.fMin);
+                __m128 slabMax = _mm_set1_ps(slab.fMax);
+                culled = _mm_or_ps(culled, _mm_or_ps(_mm_cmplt_ps(dmax, slabMin), _mm_cmpgt_ps(dmin, slabMax)));
+                split = _mm_or_ps(split, _mm_or_ps(_mm_cmplt_ps(dmin, slabMin), _mm_cmpgt_ps(dmax, slabMax)));
+            }
+        }
+
+        culledMask |= uint8_t(_mm_movemask_ps(culled) << i);
+        splitMask |= uint8_t(_mm_movemask_ps(split) << i);
+    }
+#endif // HAVE_SSE2
+}
@@ -0,0 +1,484 @@
+/*==LICENSE==*
+
+CyanWorlds.com Engine - MMOG client, server and tools
+Copyright (C) 2011  Cyan Worlds, Inc.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+Additional permissions under GNU GPL version 3 section 7
+
+If you modify this Program, or any covered work, by linking or
+combining it with any of RAD Game Tools Bink SDK, Autodesk 3ds Max SDK,
+NVIDIA PhysX SDK, Microsoft DirectX SDK, OpenSSL library, Independent
+JPEG Group JPEG library, Microsoft Windows Media SDK, or Apple QuickTime SDK
+(or a modified version of those libraries),
+containing parts covered by the terms of the Bink SDK EULA, 3ds Max EULA,
+PhysX SDK EULA, DirectX SDK EULA, OpenSSL and SSLeay licenses, IJG
+JPEG Library README, Windows Media SDK EULA, or QuickTime SDK EULA, the
+licensors of this Program grant you additional
+permission to convey the resulting work. Corresponding Source for a
+non-source form of such a combination shall include the source code for
+the parts of OpenSSL and IJG JPEG Library used as well as that of the covered
+work.
+
+You can contact Cyan Worlds, Inc. by email legal@cyan.com
+ or by snail mail at:
+      Cyan Worlds, Inc.
+      14617 N Newport Hwy
+      Mead, WA   99021
+
+*==LICENSE==*/
+
+#include "HeadSpin.h"
+
+#include "plSpanTriBVH.h"
+
+#include "plAccessTriSpan.h"
+#include "plSpanTypes.h"
+
+#include <algorithm>
+#include <cfloat>
+
+static inline void IGrowBox(float* mins, float* maxs, const float* pMin, const float* pMax)
+{
+    for (int i = 0; i < 3; i++)
+    {
+        mins[i] = std::min(mins[i], pMin[i]);
+        maxs[i] = std::max(maxs[i], pMax[i]);
+    }
+}
+
+static inline float IHalfArea(const float* mins, const float* maxs)
+{
+    float dx = maxs[0] - mins[0];
+    float dy = maxs[1] - mins[1];
+    float dz = maxs[2] - mins[2];
+    return dx * dy + dy * dz + dz * dx;
+}
+
+// Slab test against the part of the ray in [0, maxDist]. NaNs (ray lying in a slab
+// plane with a zero direction component) fail the comparisons and leave t0/t1 alone.
+static inline bool IHitBox(const float* mins, const float* maxs, const hsPoint3& from, const float* invDir,
+                           float maxDist, float& tNear)
+{
+    float t0 = 0.f;
+    float t1 = maxDist;
+    const float orig[3] = { from.fX, from.fY, from.fZ };
+    for (int i = 0; i < 3; i++)
+    {
+        float tA = (mins[i] - orig[i]) * invDir[i];
+        float tB = (maxs[i] - orig[i]) * invDir[i];
+        if (tA > tB)
+            std::swap(tA, tB);
+        if (tA > t0)
+            t0 = tA;
+        if (tB < t1)
+            t1 = tB;
+        if (t0 > t1)
+            return false;
+    }
+    tNear = t0;
+    return true;
+}
+
+plSpanTriBVH::plSpanTriBVH()
+    : fGroupIdx(), fVBufferIdx(), fVStartIdx(), fVLength(),
+      fIBufferIdx(), fIStartIdx(), fILength()
+{
+}
+
+bool plSpanTriBVH::IsFor(const plIcicle& span) const
+{
+    return fGroupIdx == span.fGroupIdx
+        && fVBufferIdx == span.fVBufferIdx
+        && fVStartIdx == span.fVStartIdx
+        && fVLength == span.fVLength
+        && fIBufferIdx == span.fIBufferIdx
+        && fIStartIdx == span.fIStartIdx
+        && fILength == span.fILength;
+}
+
+bool plSpanTriBVH::Build(const plIcicle& span, plAccessTriSpan& triSpan)
+{
+    fNodes.clear();
+    fVerts.clear();
+    fTriIdx.clear();
+
+    fGroupIdx = span.fGroupIdx;
+    fVBufferIdx = span.fVBufferIdx;
+    fVStartIdx = span.fVStartIdx;
+    fVLength = span.fVLength;
+    fIBufferIdx = span.fIBufferIdx;
+    fIStartIdx = span.fIStartIdx;
+    fILength = span.fILength;
+
+    if (triSpan.TriCount() < kMinTris)
+        return false;
+
+    std::vector<hsPoint3> pos;
+    pos.reserve(triSpan.TriCount() * 3);
+    std::vector<BuildTri> tris;
+    tris.reserve(triSpan.TriCount());
+
+    plAccTriIterator tri(&triSpan);
+    for (tri.Begin(); tri.More(); tri.Advance())
+    {
+        BuildTri& bt = tris.emplace_back();
+        bt.fIdx = uint32_t(tris.size() - 1);
+        for (int i = 0; i < 3; i++)
+        {
+            const hsPoint3& p = tri.Position(i);
+            pos.emplace_back(p);
+
+            const float c[3] = { p.fX, p.fY, p.fZ };
+            for (int j = 0; j < 3; j++)
+            {
+                bt.fMin[j] = i ? std::min(bt.fMin[j], c[j]) : c[j];
+                bt.fMax[j] = i ? std::max(bt.fMax[j], c[j]) : c[j];
+            }
+        }
+        for (int j = 0; j < 3; j++)
+            bt.fCenter[j] = (bt.fMin[j] + bt.fMax[j]) * 0.5f;
+    }
+
+    // Worst case is a full binary tree over single triangle leaves.
+    fNodes.reserve(2 * (tris.size() / kMaxLeafTris + 1));
+    fNodes.emplace_back();
+
+    std::vector<uint32_t> order;
+    order.reserve(tris.size());
+    IBuildNode(0, tris, 0, tris.size(), 0, order);
+
+    fVerts.reserve(order.size() * 3);
+    for (uint32_t idx : order)
+    {
+        fVerts.emplace_back(pos[idx * 3 + 0]);
+        fVerts.emplace_back(pos[idx * 3 + 1]);
+        fVerts.emplace_back(pos[idx * 3 + 2]);
+    }
+    fTriIdx.swap(order);
+
+    return true;
+}
+
+void plSpanTriBVH::IBuildNode(uint32_t nodeIdx, std::vector<BuildTri>& tris, size_t begin, size_t end, int depth, std::vector<uint32_t>& order)
+{
+    float mins[3] = { FLT_MAX, FLT_MAX, FLT_MAX };
+    float maxs[3] = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+    for (size_t i = begin; i < end; i++)
+        IGrowBox(mins, maxs, tris[i].fMin, tris[i].fMax);
+
+    // Pad a hair, so a ray grazing an edge isn't lost to the box rounding
+    // differently than the triangle test does.
+    const float pad = 1.e-4f * std::max({ maxs[0] - mins[0], maxs[1] - mins[1], maxs[2] - mins[2] }) + 1.e-5f;
+    for (int i = 0; i < 3; i++)
+    {
+        fNodes[nodeIdx].fMin[i] = mins[i] - pad;
+        fNodes[nodeIdx].fMax[i] = maxs[i] + pad;
+    }
+
+    if (end - begin <= kMaxLeafTris || depth >= kMaxDepth - 1)
+    {
+        fNodes[nodeIdx].fFirst = uint32_t(order.size());
+        fNodes[nodeIdx].fCount = uint32_t(end - begin);
+        for (size_t i = begin; i < end; i++)
+            order.emplace_back(tris[i].fIdx);
+        return;
+    }
+
+    size_t mid = IPartition(tris, begin, end);
+
+    uint32_t child = uint32_t(fNodes.size());
+    fNodes.emplace_back();
+    fNodes.emplace_back();
+    fNodes[nodeIdx].fFirst = child;
+    fNodes[nodeIdx].fCount = 0;
+
+    IBuildNode(child, tris, begin, mid, depth + 1, order);
+    IBuildNode(child + 1, tris, mid, end, depth + 1, order);
+}
+
+size_t plSpanTriBVH::IPartition(std::vector<BuildTri>& tris, size_t begin, size_t end) const
+{
+    float cMin[3] = { FLT_MAX, FLT_MAX, FLT_MAX };
+    float cMax[3] = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+    for (size_t i = begin; i < end; i++)
+        IGrowBox(cMin, cMax, tris[i].fCenter, tris[i].fCenter);
+
+    int axis = 0;
+    for (int i = 1; i < 3; i++)
+    {
+        if (cMax[i] - cMin[i] > cMax[axis] - cMin[axis])
+            axis = i;
+    }
+
+    size_t mid = (begin + end) / 2;
+    const float extent = cMax[axis] - cMin[axis];
+    if (extent > 0)
+    {
+        // Binned surface area heuristic along the widest axis of the centers.
+        enum { kNumBins = 8 };
+        struct Bin
+        {
+            float   fMin[3];
+            float   fMax[3];
+            size_t  fCount;
+        } bins[kNumBins];
+        for (Bin& bin : bins)
+        {
+            std::fill(std::begin(bin.fMin), std::end(bin.fMin), FLT_MAX);
+            std::fill(std::begin(bin.fMax), std::end(bin.fMax), -FLT_MAX);
+            bin.fCount = 0;
+        }
+
+        const float scale = kNumBins / extent;
+        auto binOf = [&](const BuildTri& t) {
+            return std::min(int((t.fCenter[axis] - cMin[axis]) * scale), int(kNumBins - 1));
+        };
+        for (size_t i = begin; i < end; i++)
+        {
+            Bin& bin = bins[binOf(tris[i])];
+            IGrowBox(bin.fMin, bin.fMax, tris[i].fMin, tris[i].fMax);
+            bin.fCount++;
+        }
+
+        float rightCost[kNumBins];
+        float rMin[3] = { FLT_MAX, FLT_MAX, FLT_MAX };
+        float rMax[3] = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+        size_t rCount = 0;
+        for (int i = kNumBins - 1; i > 0; i--)
+        {
+            IGrowBox(rMin, rMax, bins[i].fMin, bins[i].fMax);
+            rCount += bins[i].fCount;
+            rightCost[i] = rCount ? IHalfArea(rMin, rMax) * rCount : 0.f;
+        }
+
+        float lMin[3] = { FLT_MAX, FLT_MAX, FLT_MAX };
+        float lMax[3] = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+        size_t lCount = 0;
+        int bestSplit = -1;
+        float bestCost = FLT_MAX;
+        for (int i = 0; i < kNumBins - 1; i++)
+        {
+            IGrowBox(lMin, lMax, bins[i].fMin, bins[i].fMax);
+            lCount += bins[i].fCount;
+            if (!lCount || lCount == end - begin)
+                continue;
+            float cost = IHalfArea(lMin, lMax) * lCount + rightCost[i + 1];
+            if (cost < bestCost)
+            {
+                bestCost = cost;
+                bestSplit = i;
+            }
+        }
+
+        if (bestSplit >= 0)
+        {
+            auto it = std::partition(tris.begin() + begin, tris.begin() + end,
+                [&](const BuildTri& t) { return binOf(t) <= bestSplit; });
+            return size_t(it - tris.begin());
+        }
+    }
+
+    // Everything landed in one bin (or on one point), just halve it.
+    std::nth_element(tris.begin() + begin, tris.begin() + mid, tris.begin() + end,
+        [axis](const BuildTri& lhs, const BuildTri& rhs) { return lhs.fCenter[axis] < rhs.fCenter[axis]; });
+    return mid;
+}
+
+bool plSpanTriBVH::Raycast(const hsPoint3& from, const hsVector3& dir, bool twoSided, float& maxDist, hsPoint3& hitPos,
+                           uint32_t* triIdx) const
+{
+    if (fNodes.empty())
+        return false;
+
+    const float invDir[3] = { 1.f / dir.fX, 1.f / dir.fY, 1.f / dir.fZ };
+
+    float tNear;
+    if (!IHitBox(fNodes[0].fMin, fNodes[0].fMax, from, invDir, maxDist, tNear))
+        return false;
+
+    // Near child first, far child on the stack. Each level pushes at most
+    // once, so the stack can't outgrow the tree's depth.
+    uint32_t stack[kMaxDepth];
+    float stackNear[kMaxDepth];
+    int sp = 0;
+
+    bool retVal = false;
+    uint32_t nodeIdx = 0;
+    for (;;)
+    {
+        const Node& node = fNodes[nodeIdx];
+        if (node.fCount)
+        {
+            const hsPoint3* verts = &fVerts[node.fFirst * 3];
+            for (uint32_t i = 0; i < node.fCount; i++, verts += 3)
+            {
+                float dist;
+                hsPoint3 projPt;
+                if (IntersectTri(verts[0], verts[1], verts[2], from, dir, twoSided, maxDist, dist, projPt))
+                {
+                    maxDist = dist;
+                    hitPos = projPt;
+                    if (triIdx)
+                        *triIdx = fTriIdx[node.fFirst + i];
+                    retVal = true;
+                }
+            }
+        }
+        else
+        {
+            uint32_t c0 = node.fFirst;
+            uint32_t c1 = c0 + 1;
+            float t0, t1;
+            bool hit0 = IHitBox(fNodes[c0].fMin, fNodes[c0].fMax, from, invDir, maxDist, t0);
+            bool hit1 = IHitBox(fNodes[c1].fMin, fNodes[c1].fMax, from, invDir, maxDist, t1);
+            if (hit0 && hit1)
+            {
+                if (t1 < t0)
+                {
+                    std::swap(c0, c1);
+                    std::swap(t0, t1);
+                }
+                hsAssert(sp < kMaxDepth, "plSpanTriBVH deeper than built");
+                stack[sp] = c1;
+                stackNear[sp] = t1;
+                sp++;
+                nodeIdx = c0;
+                continue;
+            }
+            if (hit0 || hit1)
+            {
+                nodeIdx = hit0 ? c0 : c1;
+                continue;
+            }
+        }
+
+        // Anything pushed before we found our current hit may now be out of reach.
+        do
+        {
+            if (!sp)
+                return retVal;
+            sp--;
+        } while (stackNear[sp] > maxDist);
+        nodeIdx = stack[sp];
+    }
+}
+
+static inline bool IOverlapBox(const float* mins, const float* maxs, const hsPoint3& qMin, const hsPoint3& qMax)
+{
+    return mins[0] <= qMax.fX && maxs[0] >= qMin.fX
+        && mins[1] <= qMax.fY && maxs[1] >= qMin.fY
+        && mins[2] <= qMax.fZ && maxs[2] >= qMin.fZ;
+}
+
+void plSpanTriBVH::GatherTris(const hsPoint3& mins, const hsPoint3& maxs, std::vector<uint32_t>& tris) const
+{
+    if (fNodes.empty() || !IOverlapBox(fNodes[0].fMin, fNodes[0].fMax, mins, maxs))
+        return;
+
+    uint32_t stack[kMaxDepth];
+    int sp = 0;
+
+    uint32_t nodeIdx = 0;
+    for (;;)
+    {
+        const Node& node = fNodes[nodeIdx];
+        if (node.fCount)
+        {
+            const hsPoint3* verts = &fVerts[node.fFirst * 3];
+            for (uint32_t i = 0; i < node.fCount; i++, verts += 3)
+            {
+                const float tMin[3] = {
+                    std::min({ verts[0].fX, verts[1].fX, verts[2].fX }),
+                    std::min({ verts[0].fY, verts[1].fY, verts[2].fY }),
+                    std::min({ verts[0].fZ, verts[1].fZ, verts[2].fZ })
+                };
+                const float tMax[3] = {
+                    std::max({ verts[0].fX, verts[1].fX, verts[2].fX }),
+                    std::max({ verts[0].fY, verts[1].fY, verts[2].fY }),
+                    std::max({ verts[0].fZ, verts[1].fZ, verts[2].fZ })
+                };
+                if (IOverlapBox(tMin, tMax, mins, maxs))
+                    tris.emplace_back(fTriIdx[node.fFirst + i]);
+            }
+        }
+        else
+        {
+            uint32_t c0 = node.fFirst;
+            uint32_t c1 = c0 + 1;
+            bool hit0 = IOverlapBox(fNodes[c0].fMin, fNodes[c0].fMax, mins, maxs);
+            bool hit1 = IOverlapBox(fNodes[c1].fMin, fNodes[c1].fMax, mins, maxs);
+            if (hit0 && hit1)
+            {
+                hsAssert(sp < kMaxDepth, "plSpanTriBVH deeper than built");
+                stack[sp++] = c1;
+                nodeIdx = c0;
+                continue;
+            }
+            if (hit0 || hit1)
+            {
+                nodeIdx = hit0 ? c0 : c1;
+                continue;
+            }
+        }
+
+        if (!sp)
+            return;
+        nodeIdx = stack[--sp];
+    }
+}
+
+bool plSpanTriBVH::IntersectTri(const hsPoint3& p0, const hsPoint3& p1, const hsPoint3& p2,
+                                const hsPoint3& from, const hsVector3& dir, bool twoSided,
+                                float maxDist, float& dist, hsPoint3& projPt)
+{
+    // Project the current ray onto the tri plane
+    hsVector3 norm = hsVector3(&p1, &p0) % hsVector3(&p2, &p0);
+    float dotNorm = norm.InnerProduct(dir);
+
+    const float kMinDotNorm = 1.e-3f;
+    if( dotNorm >= -kMinDotNorm )
+    {
+        if( !twoSided )
+            return false;
+        if( dotNorm <= kMinDotNorm )
+            return false;
+    }
+    dist = hsVector3(&p0, &from).InnerProduct(norm) / dotNorm;
+
+    // Behind the ray start, or past where we're looking
+    if( dist < 0 || dist >= maxDist )
+        return false;
+
+    projPt = from;
+    projPt += dir * dist;
+
+    // Find the 3 cross products (v[i+1]-v[i]) X (proj - v[i]) dotted with current ray
+    hsVector3 cross0 = hsVector3(&p1, &p0) % hsVector3(&projPt, &p0);
+    float dot0 = cross0.InnerProduct(dir);
+
+    hsVector3 cross1 = hsVector3(&p2, &p1) % hsVector3(&projPt, &p1);
+    float dot1 = cross1.InnerProduct(dir);
+
+    hsVector3 cross2 = hsVector3(&p0, &p2) % hsVector3(&projPt, &p2);
+    float dot2 = cross2.InnerProduct(dir);
+
+    // If all 3 are negative, projPt is a hit
+    // If all 3 are positive and we're two sided, projPt is a hit
+    // We've already checked for back facing (when we checked for edge on in projection),
+    // so we'll accept either case here.
+    return ((dot0 <= 0) && (dot1 <= 0) && (dot2 <= 0))
+        || ((dot0 >= 0) && (dot1 >= 0) && (dot2 >= 0));
+}
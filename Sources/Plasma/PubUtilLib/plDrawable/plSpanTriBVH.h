@@ -0,0 +1,131 @@
+/*==LICENSE==*
+
+CyanWorlds.com Engine - MMOG client, server and tools
+Copyright (C) 2011  Cyan Worlds, Inc.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+Additional permissions under GNU GPL version 3 section 7
+
+If you modify this Program, or any covered work, by linking or
+combining it with any of RAD Game Tools Bink SDK, Autodesk 3ds Max SDK,
+NVIDIA PhysX SDK, Microsoft DirectX SDK, OpenSSL library, Independent
+JPEG Group JPEG library, Microsoft Windows Media SDK, or Apple QuickTime SDK
+(or a modified version of those libraries),
+containing parts covered by the terms of the Bink SDK EULA, 3ds Max EULA,
+PhysX SDK EULA, DirectX SDK EULA, OpenSSL and SSLeay licenses, IJG
+JPEG Library README, Windows Media SDK EULA, or QuickTime SDK EULA, the
+licensors of this Program grant you additional
+permission to convey the resulting work. Corresponding Source for a
+non-source form of such a combination shall include the source code for
+the parts of OpenSSL and IJG JPEG Library used as well as that of the covered
+work.
+
+You can contact Cyan Worlds, Inc. by email legal@cyan.com
+ or by snail mail at:
+      Cyan Worlds, Inc.
+      14617 N Newport Hwy
+      Mead, WA   99021
+
+*==LICENSE==*/
+
+#ifndef plSpanTriBVH_inc
+#define plSpanTriBVH_inc
+
+#include <vector>
+
+#include "hsGeometry3.h"
+
+class plAccessTriSpan;
+class plIcicle;
+
+// A bounding volume hierarchy over the triangles of a single icicle span,
+// in the span's local space. Built on demand for visual LOS and decal cutting,
+// so that picking or cutting against a dense mesh doesn't have to look at every
+// triangle in it.
+// The triangle positions are copied out in leaf order, so traversal never
+// goes back to the buffer group.
+class plSpanTriBVH
+{
+public:
+    enum
+    {
+        kMaxLeafTris    = 4,
+        kMaxDepth       = 48,   // Also the size of the traversal stack
+        kMinTris        = 32    // Below this, brute force is just as quick
+    };
+
+protected:
+    struct Node
+    {
+        float       fMin[3];
+        uint32_t    fFirst;     // Interior: index of first of two adjacent children. Leaf: first tri.
+        float       fMax[3];
+        uint32_t    fCount;     // Number of tris in a leaf, zero for interior nodes.
+    };
+
+    std::vector<Node>       fNodes;
+    std::vector<hsPoint3>   fVerts;     // Three per tri, in leaf order
+    std::vector<uint32_t>   fTriIdx;    // Leaf order to the tri's index in the span
+
+    // What the hierarchy was built from, to catch the span having moved under us.
+    uint32_t    fGroupIdx;
+    uint32_t    fVBufferIdx;
+    uint32_t    fVStartIdx;
+    uint32_t    fVLength;
+    uint32_t    fIBufferIdx;
+    uint32_t    fIStartIdx;
+    uint32_t    fILength;
+
+    struct BuildTri
+    {
+        float       fMin[3];
+        float       fMax[3];
+        float       fCenter[3];
+        uint32_t    fIdx;
+    };
+
+    void    IBuildNode(uint32_t nodeIdx, std::vector<BuildTri>& tris, size_t begin, size_t end, int depth, std::vector<uint32_t>& order);
+    size_t  IPartition(std::vector<BuildTri>& tris, size_t begin, size_t end) const;
+
+public:
+    plSpanTriBVH();
+
+    // Returns false if there is nothing worth building a hierarchy over.
+    bool    Build(const plIcicle& span, plAccessTriSpan& tris);
+
+    bool    IsFor(const plIcicle& span) const;
+    bool    UsesVertexBuffer(uint32_t group, uint32_t vbuf) const { return fGroupIdx == group && fVBufferIdx == vbuf; }
+
+    size_t  GetNumTris() const { return fVerts.size() / 3; }
+    size_t  GetNumNodes() const { return fNodes.size(); }
+
+    // Finds the closest tri the ray (from, normalized dir) hits before maxDist.
+    // On a hit, maxDist is shortened to the hit and hitPos set, both in local space,
+    // and triIdx (if given) is set to the span index of the tri that was hit.
+    bool    Raycast(const hsPoint3& from, const hsVector3& dir, bool twoSided, float& maxDist, hsPoint3& hitPos,
+                    uint32_t* triIdx = nullptr) const;
+
+    // Appends the span index of every tri whose box overlaps [mins, maxs], all in
+    // local space, in no particular order. Never allocates beyond growing tris.
+    void    GatherTris(const hsPoint3& mins, const hsPoint3& maxs, std::vector<uint32_t>& tris) const;
+
+    // The single triangle test plVisLOSMgr has always used, shared so both
+    // paths agree to the bit. Hits at or beyond maxDist are rejected.
+    static bool IntersectTri(const hsPoint3& p0, const hsPoint3& p1, const hsPoint3& p2,
+                             const hsPoint3& from, const hsVector3& dir, bool twoSided,
+                             float maxDist, float& dist, hsPoint3& projPt);
+};
+
+#endif // plSpanTriBVH_inc
@@ -50,6 +50,7 @@ You can contact Cyan Worlds, Inc. by email legal@cyan.com
 #include "plDrawableSpans.h"
 #include "plAccessGeometry.h"
 #include "plAccessSpan.h"
+#include "plSpanTriBVH.h"
 
 #include "plSurface/hsGMaterial.h"
 #include "plSurface/plLayerInterface.h"
@@ -251,50 +252,20 @@ bool plVisLOSMgr::ICheckSpan(plDrawableSpans* dr, uint32_t spanIdx, plVisHit& hi
 
     currDir /= maxDist;
 
-    plAccTriIterator tri(&src.AccessTri());
-    for( tri.Begin(); tri.More(); tri.Advance() )
+    // Dense spans get a cached hierarchy, so we only look at the tris near the ray.
+    if (const plSpanTriBVH* bvh = dr->GetSpanTriBVH(spanIdx, src))
     {
-        // Project the current ray onto the tri plane
-        hsVector3 norm = hsVector3(&tri.Position(1), &tri.Position(0)) % hsVector3(&tri.Position(2), &tri.Position(0));
-        float dotNorm = norm.InnerProduct(currDir);
-
-        const float kMinDotNorm = 1.e-3f;
-        if( dotNorm >= -kMinDotNorm )
-        {
-            if( !twoSided )
-                continue;
-            if( dotNorm <= kMinDotNorm )
-                continue;
-        }
-        float dist = hsVector3(&tri.Position(0), &currFrom).InnerProduct(norm);
-        if( dist > 0 )
-            continue;
-        dist /= dotNorm;
-        hsPoint3 projPt = currFrom;
-        projPt += currDir * dist;
-
-        // If the distance from source point to projected point is too long, skip
-        if( dist > maxDist )
-            continue;
-
-        // Find the 3 cross products (v[i+1]-v[i]) X (proj - v[i]) dotted with current ray
-        hsVector3 cross0 = hsVector3(&tri.Position(1), &tri.Position(0)) % hsVector3(&projPt, &tri.Position(0));
-        float dot0 = cross0.InnerProduct(currDir);
-
-        hsVector3 cross1 = hsVector3(&tri.Position(2), &tri.Position(1)) % hsVector3(&projPt, &tri.Position(1));
-        float dot1 = cross1.InnerProduct(currDir);
-
-        hsVector3 cross2 = hsVector3(&tri.Position(0), &tri.Position(2)) % hsVector3(&projPt, &tri.Position(2));
-        float dot2 = cross2.InnerProduct(currDir);
-
-        // If all 3 are negative, projPt is a hit
-        // If all 3 are positive and we're two sided, projPt is a hit
-        // We've already checked for back facing (when we checked for edge on in projection),
-        // so we'll accept either case here.
-        if( ((dot0 <= 0) && (dot1 <= 0) && (dot2 <= 0))
-            ||((dot0 >= 0) && (dot1 >= 0) && (dot2 >= 0)) )
+        retVal = bvh->Raycast(currFrom, currDir, twoSided, maxDist, hit.fPos);
+    }
+    else
+    {
+        plAccTriIterator tri(&src.AccessTri());
+        for( tri.Begin(); tri.More(); tri.Advance() )
         {
-            if( dist < maxDist )
+            float dist;
+            hsPoint3 projPt;
+            if( plSpanTriBVH::IntersectTri(tri.Position(0), tri.Position(1), tri.Position(2),
+                                           currFrom, currDir, twoSided, maxDist, dist, projPt) )
             {
                 maxDist = dist;
                 hit.fPos = projPt;
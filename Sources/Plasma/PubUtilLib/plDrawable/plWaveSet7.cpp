@@ -96,8 +96,6 @@ You can contact Cyan Worlds, Inc. by email legal@cyan.com
 
 #include "plMessage/plMatRefMsg.h"
 #include "plMessage/plAgeLoadedMsg.h"
-#include "plMessage/plDampMsg.h"
-#include "plMessage/plImpulseMsg.h"
 
 #include "plTweak.h"
 
@@ -253,6 +251,7 @@ plWaveSet7::plWaveSet7()
     fBumpReq(),
     fBumpReqMsg(),
     fEnvMap(),
+    fNextBuoy(),
     fRefObj(),
     fCosineLUT(),
     fGraphShoreTex(),
@@ -952,32 +951,37 @@ void plWaveSet7::IInitWave(int i)
     wave.fDir.Set(dir.fX, dir.fY, 0);
 }
 
-inline void plWaveSet7::IScrunch(hsPoint3& pos, hsVector3& norm) const
+void plWaveSet7::GetSurfaceParams(SurfaceParams& params) const
 {
-    pos.fX += -norm.fX * fScrunchLen;
-    pos.fY += -norm.fY * fScrunchLen;
-
-    norm.fX *= fScrunchScale;
-    norm.fY *= fScrunchScale;
-
-    hsFastMath::NormalizeAppr(norm);
+    for (int i = 0; i < kNumWaves; i++)
+        params.fWaves[i] = fWorldWaves[i];
+    params.fWaterHeight = State().fWaterHeight;
+    params.fScrunchLen = fScrunchLen;
+    params.fScrunchScale = fScrunchScale;
 }
 
-float plWaveSet7::EvalPoint(hsPoint3& pos, hsVector3& norm)
+void plWaveSet7::EvalSurfacePoint(const SurfaceParams& params, hsPoint3& pos, hsVector3& norm)
 {
     hsPoint3 accumPos;
     hsVector3 accumNorm;
-    accumPos.Set(pos.fX, pos.fY, State().fWaterHeight);
+    accumPos.Set(pos.fX, pos.fY, params.fWaterHeight);
 
     int i;
     for( i = 0; i < kNumWaves; i++ )
-        fWorldWaves[i].Accumulate(accumPos, accumNorm);
+        params.fWaves[i].Accumulate(accumPos, accumNorm);
 
     accumNorm.fZ = 1.f;
 
     hsFastMath::NormalizeAppr(accumNorm);
 
-    IScrunch(accumPos, accumNorm);
+    // Scrunch
+    accumPos.fX += -accumNorm.fX * params.fScrunchLen;
+    accumPos.fY += -accumNorm.fY * params.fScrunchLen;
+
+    accumNorm.fX *= params.fScrunchScale;
+    accumNorm.fY *= params.fScrunchScale;
+
+    hsFastMath::NormalizeAppr(accumNorm);
 
     // Project original pos along Z onto the plane tangent at accumPos with norm accumNorm
     float t = hsVector3(&accumPos, &pos).InnerProduct(accumNorm);
@@ -986,10 +990,40 @@ float plWaveSet7::EvalPoint(hsPoint3& pos, hsVector3& norm)
     pos.fZ += t;
 
     norm = accumNorm;
+}
+
+float plWaveSet7::EvalPoint(hsPoint3& pos, hsVector3& norm)
+{
+    SurfaceParams params;
+    GetSurfaceParams(params);
+    EvalSurfacePoint(params, pos, norm);
 
     return pos.fZ;
 }
 
+void plWaveSet7::EvalPoints(size_t count, hsPoint3* pos, hsVector3* norm) const
+{
+    if (!count)
+        return;
+
+    SurfaceParams params;
+    GetSurfaceParams(params);
+    eval_points.call(params, count, pos, norm);
+}
+
+void plWaveSet7::eval_points_fpu(const SurfaceParams& params, size_t count, hsPoint3* pos, hsVector3* norm)
+{
+    for (size_t i = 0; i < count; i++)
+        EvalSurfacePoint(params, pos[i], norm[i]);
+}
+
+// CPU-optimized functions requiring dispatch
+hsCpuFunctionDispatcher<plWaveSet7::eval_points_ptr> plWaveSet7::eval_points {
+    &plWaveSet7::eval_points_fpu,
+    nullptr,            // SSE1
+    &plWaveSet7::eval_points_sse2
+};
+
 void plWaveSet7::IUpdateWindDir(float dt)
 {
     fWindDir = -State().fWindDir;
@@ -1013,16 +1047,10 @@ void plWaveSet7::IUpdateRefObject()
     }
 }
 
-void plWaveSet7::IFloatBuoy(float dt, plSceneObject* so)
+void plWaveSet7::IFloatBuoy(float dt, plSceneObject* so, const hsPoint3& surfPos, const hsVector3& surfNorm)
 {
     // Compute force based on world bounds
-    hsBounds3Ext wBnd = so->GetDrawInterface()->GetWorldBounds();
-
-    hsPoint3 pos(wBnd.GetCenter());
-    hsPoint3 surfPos(pos);
-    hsVector3 surfNorm;
-
-    EvalPoint(surfPos, surfNorm);
+    const hsBounds3Ext& wBnd = so->GetDrawInterface()->GetWorldBounds();
 
     // Direction of impulse is surfNorm. Magnitude is proportional to depth
     // (in an approximation lazy hackish way).
@@ -1050,17 +1078,17 @@ void plWaveSet7::IFloatBuoy(float dt, plSceneObject* so)
     // Don't currently have anything informative from the physical to use.
     // So, let's fake something for the moment.
 
-    plKey physKey = so->GetSimulationInterface()->GetPhysical()->GetKey();
+    // Straight to the physical, rather than an impulse and a damp message per buoy per frame.
+    plPhysical* phys = so->GetSimulationInterface()->GetPhysical();
 
-    plImpulseMsg* iMsg = new plImpulseMsg(GetKey(), physKey, hsVector3(0.f, 0.f, 1.f) * forceMag * dt);
-    iMsg->Send();
+    phys->SetImpulseSim(hsVector3(0.f, 0.f, 1.f) * forceMag * dt);
 
 #if 0
     plCONST(float) kRotScale(1.f);
     hsVector3 rotAx = hsVector3(0.f, 0.f, 1.f) % surfNorm;
     rotAx *= kRotScale * dt * volume;
 
-    plAngularImpulseMsg* aMsg = new plAngularImpulseMsg(GetKey(), physKey, rotAx);
+    plAngularImpulseMsg* aMsg = new plAngularImpulseMsg(GetKey(), phys->GetKey(), rotAx);
     aMsg->Send();
 #endif
 
@@ -1073,20 +1101,53 @@ void plWaveSet7::IFloatBuoy(float dt, plSceneObject* so)
         damp *= kDampener;
         damp += kBaseDamp;
 
-        plDampMsg* dMsg = new plDampMsg(GetKey(), physKey, damp);
-        dMsg->Send();
+        // Same conversion the physical does when it gets a plDampMsg
+        phys->SetDampingSim(1.f - damp);
     }
 }
 
+plWaveSet7::BuoyTurn plWaveSet7::NextBuoyTurn(size_t numBuoys, float dt, size_t& cursor)
+{
+    if (cursor >= numBuoys)
+        cursor = 0;
+
+    // Every buoy gets kMaxBuoysPerFrame turns in numBuoys frames, so scaling
+    // by numBuoys / kMaxBuoysPerFrame comes out to dt per frame each.
+    BuoyTurn turn{ cursor, numBuoys, dt };
+    if (numBuoys > kMaxBuoysPerFrame)
+    {
+        turn.fCount = kMaxBuoysPerFrame;
+        turn.fDt = dt * float(numBuoys) / float(kMaxBuoysPerFrame);
+    }
+
+    cursor = numBuoys ? (cursor + turn.fCount) % numBuoys : 0;
+    return turn;
+}
+
 void plWaveSet7::IFloatBuoys(float dt)
 {
-    for (plSceneObject* buoy : fBuoys)
+    if (fBuoys.empty())
+        return;
+
+    BuoyTurn turn = NextBuoyTurn(fBuoys.size(), dt, fNextBuoy);
+
+    fFloating.clear();
+    fFloatPos.clear();
+    for (size_t i = 0; i < turn.fCount; i++)
     {
+        plSceneObject* buoy = fBuoys[(turn.fFirst + i) % fBuoys.size()];
         if (buoy && buoy->GetSimulationInterface() && buoy->GetSimulationInterface()->GetPhysical() && buoy->GetDrawInterface())
         {
-            IFloatBuoy(dt, buoy);
+            fFloating.push_back(buoy);
+            fFloatPos.push_back(buoy->GetDrawInterface()->GetWorldBounds().GetCenter());
         }
     }
+
+    fFloatNorm.resize(fFloatPos.size());
+    EvalPoints(fFloatPos.size(), fFloatPos.data(), fFloatNorm.data());
+
+    for (size_t i = 0; i < fFloating.size(); i++)
+        IFloatBuoy(turn.fDt, fFloating[i], fFloatPos[i], fFloatNorm[i]);
 }
 
 void plWaveSet7::IShiftCenter(plSceneObject* so) const
@@ -46,6 +46,7 @@ You can contact Cyan Worlds, Inc. by email legal@cyan.com
 #include <vector>
 
 #include "hsGeometry3.h"
+#include "hsCpuID.h"
 #include "pnEncryption/plRandom.h"
 #include "hsBounds.h"
 #include "plStatusLog/plStatusLog.h"
@@ -214,6 +215,17 @@ protected:
     std::vector<plDynaDecalMgr*>    fDecalMgrs;
 
     std::vector<plSceneObject*>     fBuoys;
+
+    // Most buoys we'll push around in one frame. Past that, they take turns,
+    // see NextBuoyTurn().
+    enum {
+        kMaxBuoysPerFrame   = 64
+    };
+    size_t                          fNextBuoy;
+    std::vector<plSceneObject*>     fFloating;  // Scratch for IFloatBuoys(), kept to save the allocations
+    std::vector<hsPoint3>           fFloatPos;
+    std::vector<hsVector3>          fFloatNorm;
+
     std::vector<plSceneObject*>     fShores;
     std::vector<plSceneObject*>     fDecals;
     plSceneObject*                  fRefObj;
@@ -332,7 +344,6 @@ protected:
     void            IInitWaveConsts();
     void            IInitState();
 
-    inline void     IScrunch(hsPoint3& pos, hsVector3& norm) const;
 
     void            ICalcWindow(float dt);
     void            ICalcScale();
@@ -348,7 +359,7 @@ protected:
 
     void            IShiftCenter(plSceneObject* so) const;
     void            IFloatBuoys(float dt);
-    void            IFloatBuoy(float dt, plSceneObject* so);
+    void            IFloatBuoy(float dt, plSceneObject* so, const hsPoint3& surfPos, const hsVector3& surfNorm);
 
     // Bookkeeping
     void    IAddTarget(const plKey& key);
@@ -507,6 +518,38 @@ public:
 
     float            EvalPoint(hsPoint3& pos, hsVector3& norm);
 
+    // Same as calling EvalPoint() on each of count points, only cheaper
+    void             EvalPoints(size_t count, hsPoint3* pos, hsVector3* norm) const;
+
+    // Everything EvalPoint() needs to know about the current waves
+    struct SurfaceParams
+    {
+        plWorldWave7    fWaves[kNumWaves];
+        float           fWaterHeight;
+        float           fScrunchLen;
+        float           fScrunchScale;
+    };
+    void             GetSurfaceParams(SurfaceParams& params) const;
+    static void      EvalSurfacePoint(const SurfaceParams& params, hsPoint3& pos, hsVector3& norm);
+
+    //// CPU-optimized surface evaluation ////
+    // The SSE2 version follows the approximations of the FPU one, but not to the bit
+    typedef void(*eval_points_ptr)(const SurfaceParams& params, size_t count, hsPoint3* pos, hsVector3* norm);
+    static hsCpuFunctionDispatcher<eval_points_ptr> eval_points;
+    static void eval_points_fpu(const SurfaceParams& params, size_t count, hsPoint3* pos, hsVector3* norm);
+    static void eval_points_sse2(const SurfaceParams& params, size_t count, hsPoint3* pos, hsVector3* norm);
+
+    // Past kMaxBuoysPerFrame, buoys take turns being floated. This picks the
+    // next run of them, starting at cursor and moving it on, along with the
+    // time step to push them for, so each buoy still averages dt per frame.
+    struct BuoyTurn
+    {
+        size_t  fFirst;
+        size_t  fCount;
+        float   fDt;
+    };
+    static BuoyTurn NextBuoyTurn(size_t numBuoys, float dt, size_t& cursor);
+
     // Getters and Setters for Python twiddling
     //
     // First a way to set new values. The secs parameter says how long to take
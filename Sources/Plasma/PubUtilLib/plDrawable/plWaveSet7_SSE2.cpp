@@ -0,0 +1,176 @@
+/*==LICENSE==*
+
+CyanWorlds.com Engine - MMOG client, server and tools
+Copyright (C) 2011  Cyan Worlds, Inc.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+Additional permissions under GNU GPL version 3 section 7
+
+If you modify this Program, or any covered work, by linking or
+combining it with any of RAD Game Tools Bink SDK, Autodesk 3ds Max SDK,
+NVIDIA PhysX SDK, Microsoft DirectX SDK, OpenSSL library, Independent
+JPEG Group JPEG library, Microsoft Windows Media SDK, or Apple QuickTime SDK
+(or a modified version of those libraries),
+containing parts covered by the terms of the Bink SDK EULA, 3ds Max EULA,
+PhysX SDK EULA, DirectX SDK EULA, OpenSSL and SSLeay licenses, IJG
+JPEG Library README, Windows Media SDK EULA, or QuickTime SDK EULA, the
+licensors of this Program grant you additional
+permission to convey the resulting work. Corresponding Source for a
+non-source form of such a combination shall include the source code for
+the parts of OpenSSL and IJG JPEG Library used as well as that of the covered
+work.
+
+You can contact Cyan Worlds, Inc. by email legal@cyan.com
+ or by snail mail at:
+      Cyan Worlds, Inc.
+      14617 N Newport Hwy
+      Mead, WA   99021
+
+*==LICENSE==*/
+
+#include "HeadSpin.h"
+#include "hsFastMath.h"
+#include "plWaveSet7.h"
+
+#ifdef HAVE_SSE2
+#   include <emmintrin.h>
+#endif
+
+#ifdef HAVE_SSE2
+// hsFastMath's cos/sin table, a column each
+static constexpr float kSqrtHalf = hsConstants::inv_sqrt2<float>;
+alignas(16) static const float kCosTable[9] = { 1.f, kSqrtHalf, 0.f, -kSqrtHalf, -1.f, -kSqrtHalf, 0.f, kSqrtHalf, 1.f };
+alignas(16) static const float kSinTable[9] = { 0.f, kSqrtHalf, 1.f, kSqrtHalf, 0.f, -kSqrtHalf, -1.f, -kSqrtHalf, 0.f };
+
+// hsFastMath::SinCosAppr() on four angles
+static inline void ISinCosAppr(__m128 rads, __m128& sinRads, __m128& cosRads)
+{
+    const __m128 one = _mm_set1_ps(1.f);
+
+    // Wrap into [0, 2pi). fmodf does this a hair more exactly, but not so you'd notice.
+    __m128 turns = _mm_mul_ps(rads, _mm_set1_ps(1.f / hsConstants::two_pi<float>));
+    __m128 whole = _mm_cvtepi32_ps(_mm_cvttps_epi32(turns));
+    whole = _mm_sub_ps(whole, _mm_and_ps(_mm_cmpgt_ps(whole, turns), one));
+    rads = _mm_sub_ps(rads, _mm_mul_ps(whole, _mm_set1_ps(hsConstants::two_pi<float>)));
+
+    __m128 t = _mm_mul_ps(rads, _mm_set1_ps(8 * 0.5f / hsConstants::pi<float>));
+    __m128i iLo = _mm_cvttps_epi32(t);
+
+    // Rounding can leave us sitting right on 2pi, which belongs to the last segment
+    const __m128i last = _mm_set1_epi32(7);
+    __m128i over = _mm_cmpgt_epi32(iLo, last);
+    iLo = _mm_or_si128(_mm_andnot_si128(over, iLo), _mm_and_si128(over, last));
+    t = _mm_sub_ps(t, _mm_cvtepi32_ps(iLo));
+
+    alignas(16) int32_t idx[4];
+    _mm_store_si128(reinterpret_cast<__m128i*>(idx), iLo);
+
+    __m128 cosLo = _mm_set_ps(kCosTable[idx[3]], kCosTable[idx[2]], kCosTable[idx[1]], kCosTable[idx[0]]);
+    __m128 sinLo = _mm_set_ps(kSinTable[idx[3]], kSinTable[idx[2]], kSinTable[idx[1]], kSinTable[idx[0]]);
+    __m128 cosHi = _mm_set_ps(kCosTable[idx[3] + 1], kCosTable[idx[2] + 1], kCosTable[idx[1] + 1], kCosTable[idx[0] + 1]);
+    __m128 sinHi = _mm_set_ps(kSinTable[idx[3] + 1], kSinTable[idx[2] + 1], kSinTable[idx[1] + 1], kSinTable[idx[0] + 1]);
+
+    cosRads = _mm_add_ps(_mm_mul_ps(_mm_sub_ps(cosHi, cosLo), t), cosLo);
+    sinRads = _mm_add_ps(_mm_mul_ps(_mm_sub_ps(sinHi, sinLo), t), sinLo);
+}
+
+// hsFastMath::NormalizeAppr(). The reciprocal square root goes through the same
+// seed table, lane by lane, as _mm_rsqrt_ps would be off from it by enough to
+// move the scrunched surface around.
+static inline void INormalizeAppr(__m128& x, __m128& y, __m128& z)
+{
+    __m128 magSq = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y)), _mm_mul_ps(z, z));
+
+    alignas(16) float lanes[4];
+    _mm_store_ps(lanes, magSq);
+    __m128 invMag = _mm_set_ps(hsFastMath::InvSqrtAppr(lanes[3]), hsFastMath::InvSqrtAppr(lanes[2]),
+                               hsFastMath::InvSqrtAppr(lanes[1]), hsFastMath::InvSqrtAppr(lanes[0]));
+    x = _mm_mul_ps(x, invMag);
+    y = _mm_mul_ps(y, invMag);
+    z = _mm_mul_ps(z, invMag);
+}
+#endif // HAVE_SSE2
+
+// Four points per pass, in the same steps as EvalSurfacePoint()
+void plWaveSet7::eval_points_sse2(const SurfaceParams& params, size_t count, hsPoint3* pos, hsVector3* norm)
+{
+#ifdef HAVE_SSE2
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 scrunchLen = _mm_set1_ps(params.fScrunchLen);
+    const __m128 scrunchScale = _mm_set1_ps(params.fScrunchScale);
+
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4)
+    {
+        hsPoint3* p = pos + i;
+        __m128 x = _mm_set_ps(p[3].fX, p[2].fX, p[1].fX, p[0].fX);
+        __m128 y = _mm_set_ps(p[3].fY, p[2].fY, p[1].fY, p[0].fY);
+        __m128 z = _mm_set_ps(p[3].fZ, p[2].fZ, p[1].fZ, p[0].fZ);
+
+        __m128 accumZ = _mm_set1_ps(params.fWaterHeight);
+        __m128 normX = zero;
+        __m128 normY = zero;
+        for (const plWorldWave7& wave : params.fWaves)
+        {
+            const __m128 dirX = _mm_set1_ps(wave.fDir.fX);
+            const __m128 dirY = _mm_set1_ps(wave.fDir.fY);
+
+            __m128 dist = _mm_add_ps(_mm_mul_ps(x, dirX), _mm_mul_ps(y, dirY));
+            dist = _mm_add_ps(_mm_mul_ps(dist, _mm_set1_ps(wave.fFreq)), _mm_set1_ps(wave.fPhase));
+
+            __m128 s, c;
+            ISinCosAppr(dist, s, c);
+
+            accumZ = _mm_add_ps(accumZ, _mm_mul_ps(s, _mm_set1_ps(wave.fAmplitude)));
+
+            c = _mm_mul_ps(c, _mm_set1_ps(-wave.fFreq * wave.fAmplitude));
+            normX = _mm_add_ps(normX, _mm_mul_ps(dirX, c));
+            normY = _mm_add_ps(normY, _mm_mul_ps(dirY, c));
+        }
+
+        __m128 normZ = _mm_set1_ps(1.f);
+        INormalizeAppr(normX, normY, normZ);
+
+        // Scrunch
+        __m128 accumX = _mm_sub_ps(x, _mm_mul_ps(normX, scrunchLen));
+        __m128 accumY = _mm_sub_ps(y, _mm_mul_ps(normY, scrunchLen));
+        normX = _mm_mul_ps(normX, scrunchScale);
+        normY = _mm_mul_ps(normY, scrunchScale);
+        INormalizeAppr(normX, normY, normZ);
+
+        // Project original pos along Z onto the plane tangent at accum with norm
+        __m128 t = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_sub_ps(accumX, x), normX),
+                                         _mm_mul_ps(_mm_sub_ps(accumY, y), normY)),
+                              _mm_mul_ps(_mm_sub_ps(accumZ, z), normZ));
+        z = _mm_add_ps(z, _mm_div_ps(t, normZ));
+
+        alignas(16) float outZ[4], outNX[4], outNY[4], outNZ[4];
+        _mm_store_ps(outZ, z);
+        _mm_store_ps(outNX, normX);
+        _mm_store_ps(outNY, normY);
+        _mm_store_ps(outNZ, normZ);
+        for (int j = 0; j < 4; j++)
+        {
+            p[j].fZ = outZ[j];
+            norm[i + j].Set(outNX[j], outNY[j], outNZ[j]);
+        }
+    }
+
+    // And whatever doesn't fill out a pass
+    eval_points_fpu(params, count - i, pos + i, norm + i);
+#else
+    eval_points_fpu(params, count, pos, norm);
+#endif // HAVE_SSE2
+}
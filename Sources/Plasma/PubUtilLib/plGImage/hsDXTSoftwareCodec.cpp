@@ -46,6 +46,7 @@ You can contact Cyan Worlds, Inc. by email legal@cyan.com
 #include "hsEndian.h"
 #include "plMipmap.h"
 #include "hsCodecManager.h"
+#include "hsParallel.h"
 
 #define SWAPVARS( x, y, t ) { t = x; x = y; y = t; }
 
@@ -518,13 +519,15 @@ void hsDXTSoftwareCodec::UncompressMipmap(plMipmap *uncompressed, plMipmap *comp
 
 void    hsDXTSoftwareCodec::UncompressMipmap( plMipmap *destBMap, plMipmap *srcBMap, uint8_t flags )
 {
+    void (hsDXTSoftwareCodec::*decode)( plMipmap *, plMipmap *, uint32_t, uint32_t ) = nullptr;
+
     if( destBMap->fUncompressedInfo.fType == plMipmap::UncompressedInfo::kRGB8888 )
     {
         /// 32-bit ARGB - Can be either DXT5 or DXT1
         if( srcBMap->fDirectXInfo.fCompressionType == plMipmap::DirectXInfo::kDXT5 )
-            IUncompressMipmapDXT5To32( destBMap, srcBMap );
+            decode = &hsDXTSoftwareCodec::IUncompressMipmapDXT5To32;
         else if( srcBMap->fDirectXInfo.fCompressionType == plMipmap::DirectXInfo::kDXT1 )
-            IUncompressMipmapDXT1To32( destBMap, srcBMap );
+            decode = &hsDXTSoftwareCodec::IUncompressMipmapDXT1To32;
     }
     else if( destBMap->fUncompressedInfo.fType == plMipmap::UncompressedInfo::kRGB1555 )
     {
@@ -533,9 +536,9 @@ void    hsDXTSoftwareCodec::UncompressMipmap( plMipmap *destBMap, plMipmap *srcB
                     "Only DXT1 bitmaps can decompress to ARGB1555 format!" );
     
         if( ( flags & hsCodecManager::kCompOrderMask ) == hsCodecManager::kWeirdCompOrder )
-            IUncompressMipmapDXT1To16Weird( destBMap, srcBMap );
+            decode = &hsDXTSoftwareCodec::IUncompressMipmapDXT1To16Weird;
         else
-            IUncompressMipmapDXT1To16( destBMap, srcBMap );
+            decode = &hsDXTSoftwareCodec::IUncompressMipmapDXT1To16;
     }
     else if( destBMap->fUncompressedInfo.fType == plMipmap::UncompressedInfo::kRGB4444 )
     {
@@ -544,26 +547,37 @@ void    hsDXTSoftwareCodec::UncompressMipmap( plMipmap *destBMap, plMipmap *srcB
                     "Only DXT5 bitmaps can decompress to ARGB4444 format!" );
 
         if( ( flags & hsCodecManager::kCompOrderMask ) == hsCodecManager::kWeirdCompOrder )
-            IUncompressMipmapDXT5To16Weird( destBMap, srcBMap );
+            decode = &hsDXTSoftwareCodec::IUncompressMipmapDXT5To16Weird;
         else
-            IUncompressMipmapDXT5To16( destBMap, srcBMap );
+            decode = &hsDXTSoftwareCodec::IUncompressMipmapDXT5To16;
     }
     else if( destBMap->fUncompressedInfo.fType == plMipmap::UncompressedInfo::kInten8 )
     {
         /// 8-bit intensity--can ONLY be DXT1
         hsAssert( srcBMap->fDirectXInfo.fCompressionType == plMipmap::DirectXInfo::kDXT1,
                     "Only DXT1 bitmaps can decompress to 8-bit Intensity format!" );
-        IUncompressMipmapDXT1ToInten( destBMap, srcBMap );
+        decode = &hsDXTSoftwareCodec::IUncompressMipmapDXT1ToInten;
     }
     else if( destBMap->fUncompressedInfo.fType == plMipmap::UncompressedInfo::kAInten88 )
     {
         /// 16-bit alpha-intensity--can ONLY be DXT5
         hsAssert( srcBMap->fDirectXInfo.fCompressionType == plMipmap::DirectXInfo::kDXT5,
                     "Only DXT5 bitmaps can decompress to 8-8 Alpha-Intensity format!" );
-        IUncompressMipmapDXT5ToAInten( destBMap, srcBMap );
+        decode = &hsDXTSoftwareCodec::IUncompressMipmapDXT5ToAInten;
     }
     else
         hsAssert( false, "Unsupported target decompression format" );
+
+    if( decode == nullptr )
+        return;
+
+    /// Each block row decodes on its own, so big levels get split across threads
+    uint32_t numRows = srcBMap->GetCurrHeight() >> 2;
+    size_t numThreads = hsParallelThreads( size_t( numRows ) * ( srcBMap->GetCurrWidth() >> 2 ),
+                                           kMinUncompressBlocksPerThread );
+    hsParallelFor( numRows, numThreads, [&]( size_t firstRow, size_t rowCount ) {
+        ( this->*decode )( destBMap, srcBMap, uint32_t( firstRow ), uint32_t( rowCount ) );
+    } );
 }
 
 
@@ -572,7 +586,8 @@ void    hsDXTSoftwareCodec::UncompressMipmap( plMipmap *destBMap, plMipmap *srcB
 //  UncompressBitmap internal call for DXT5 compression. DXT5 is 3-bit linear
 //  interpolated alpha channel compression. Output is a 16-bit RGB 4444 bitmap.
 
-void    hsDXTSoftwareCodec::IUncompressMipmapDXT5To16( plMipmap *destBMap, plMipmap *srcBMap )
+void    hsDXTSoftwareCodec::IUncompressMipmapDXT5To16( plMipmap *destBMap, plMipmap *srcBMap,
+                                                       uint32_t firstRow, uint32_t numRows )
 {
     uint16_t      *srcData;
     uint16_t      *destData, destBlock[ 16 ];
@@ -590,14 +605,15 @@ void    hsDXTSoftwareCodec::IUncompressMipmapDXT5To16( plMipmap *destBMap, plMip
     /// Setup some nifty stuff
     hsAssert( ( srcBMap->GetCurrWidth() & 3 ) == 0, "Bitmap width must be multiple of 4" );
     hsAssert( ( srcBMap->GetCurrHeight() & 3 ) == 0, "Bitmap height must be multiple of 4" );
-    numBlocks = ( srcBMap->GetCurrWidth() * srcBMap->GetCurrHeight() ) >> 4;
+    numBlocks = ( srcBMap->GetCurrWidth() >> 2 ) * numRows;
 
     blockSize = srcBMap->fDirectXInfo.fBlockSize >> 1; // In 16-bit words
-    srcData = (uint16_t *)srcBMap->GetCurrLevelPtr();
+    srcData = (uint16_t *)srcBMap->GetCurrLevelPtr() + ( srcBMap->GetCurrWidth() >> 2 ) * firstRow * blockSize;
     // Note our trick here to make sure nothing breaks if GetAddr16's 
     // formula changes
     bMapStride = (uint32_t)( destBMap->GetAddr16( 0, 1 ) - destBMap->GetAddr16( 0, 0 ) );
-    x = y = 0;
+    x = 0;
+    y = firstRow << 2;
 
 
     /// Loop through the # of blocks (width*height / 16-pixel-blocks)
@@ -729,7 +745,8 @@ void    hsDXTSoftwareCodec::IUncompressMipmapDXT5To16( plMipmap *destBMap, plMip
 //  function calls are inline. Wouldn't it be nice if we could somehow write
 //  the inline opcodes beforehand?)
 
-void    hsDXTSoftwareCodec::IUncompressMipmapDXT5To16Weird( plMipmap *destBMap, plMipmap *srcBMap )
+void    hsDXTSoftwareCodec::IUncompressMipmapDXT5To16Weird( plMipmap *destBMap, plMipmap *srcBMap,
+                                                            uint32_t firstRow, uint32_t numRows )
 {
     uint16_t      *srcData;
     uint16_t      *destData, destBlock[ 16 ];
@@ -747,14 +764,15 @@ void    hsDXTSoftwareCodec::IUncompressMipmapDXT5To16Weird( plMipmap *destBMap,
     /// Setup some nifty stuff
     hsAssert( ( srcBMap->GetCurrWidth() & 3 ) == 0, "Bitmap width must be multiple of 4" );
     hsAssert( ( srcBMap->GetCurrHeight() & 3 ) == 0, "Bitmap height must be multiple of 4" );
-    numBlocks = ( srcBMap->GetCurrWidth() * srcBMap->GetCurrHeight() ) >> 4;
+    numBlocks = ( srcBMap->GetCurrWidth() >> 2 ) * numRows;
 
     blockSize = srcBMap->fDirectXInfo.fBlockSize >> 1; // In 16-bit words
-    srcData = (uint16_t *)srcBMap->GetCurrLevelPtr();
+    srcData = (uint16_t *)srcBMap->GetCurrLevelPtr() + ( srcBMap->GetCurrWidth() >> 2 ) * firstRow * blockSize;
     // Note our trick here to make sure nothing breaks if GetAddr16's 
     // formula changes
     bMapStride = (uint32_t)( destBMap->GetAddr16( 0, 1 ) - destBMap->GetAddr16( 0, 0 ) );
-    x = y = 0;
+    x = 0;
+    y = firstRow << 2;
 
 
     /// Loop through the # of blocks (width*height / 16-pixel-blocks)
@@ -885,7 +903,8 @@ void    hsDXTSoftwareCodec::IUncompressMipmapDXT5To16Weird( plMipmap *destBMap,
 //                          the divided values and run a for loop. This gets
 //                          us only about 10% :(
 
-void    hsDXTSoftwareCodec::IUncompressMipmapDXT5To32( plMipmap *destBMap, plMipmap *srcBMap )
+void    hsDXTSoftwareCodec::IUncompressMipmapDXT5To32( plMipmap *destBMap, plMipmap *srcBMap,
+                                                       uint32_t firstRow, uint32_t numRows )
 {
     uint16_t      *srcData;
     uint32_t      *destData, destBlock[ 16 ];
@@ -903,14 +922,15 @@ void    hsDXTSoftwareCodec::IUncompressMipmapDXT5To32( plMipmap *destBMap, plMip
     /// Setup some nifty stuff
     hsAssert( ( srcBMap->GetCurrWidth() & 3 ) == 0, "Bitmap width must be multiple of 4" );
     hsAssert( ( srcBMap->GetCurrHeight() & 3 ) == 0, "Bitmap height must be multiple of 4" );
-    numBlocks = ( srcBMap->GetCurrWidth() * srcBMap->GetCurrHeight() ) >> 4;
+    numBlocks = ( srcBMap->GetCurrWidth() >> 2 ) * numRows;
 
     blockSize = srcBMap->fDirectXInfo.fBlockSize >> 1; // In 16-bit words
-    srcData = (uint16_t *)srcBMap->GetCurrLevelPtr();
+    srcData = (uint16_t *)srcBMap->GetCurrLevelPtr() + ( srcBMap->GetCurrWidth() >> 2 ) * firstRow * blockSize;
     // Note our trick here to make sure nothing breaks if GetAddr32's 
     // formula changes
     bMapStride = (uint32_t)( destBMap->GetAddr32( 0, 1 ) - destBMap->GetAddr32( 0, 0 ) );
-    x = y = 0;
+    x = 0;
+    y = firstRow << 2;
 
 
     /// Loop through the # of blocks (width*height / 16-pixel-blocks)
@@ -1046,7 +1066,8 @@ void    hsDXTSoftwareCodec::IUncompressMipmapDXT5To32( plMipmap *destBMap, plMip
 //  interpolated alpha channel compression. Output is a 16-bit Alpha-intensity
 //  map.
 
-void    hsDXTSoftwareCodec::IUncompressMipmapDXT5ToAInten( plMipmap *destBMap, plMipmap *srcBMap )
+void    hsDXTSoftwareCodec::IUncompressMipmapDXT5ToAInten( plMipmap *destBMap, plMipmap *srcBMap,
+                                                           uint32_t firstRow, uint32_t numRows )
 {
     uint16_t      *srcData;
     uint16_t      *destData, destBlock[ 16 ];
@@ -1064,14 +1085,15 @@ void    hsDXTSoftwareCodec::IUncompressMipmapDXT5ToAInten( plMipmap *destBMap, p
     /// Setup some nifty stuff
     hsAssert( ( srcBMap->GetCurrWidth() & 3 ) == 0, "Bitmap width must be multiple of 4" );
     hsAssert( ( srcBMap->GetCurrHeight() & 3 ) == 0, "Bitmap height must be multiple of 4" );
-    numBlocks = ( srcBMap->GetCurrWidth() * srcBMap->GetCurrHeight() ) >> 4;
+    numBlocks = ( srcBMap->GetCurrWidth() >> 2 ) * numRows;
 
     blockSize = srcBMap->fDirectXInfo.fBlockSize >> 1; // In 16-bit words
-    srcData = (uint16_t *)srcBMap->GetCurrLevelPtr();
+    srcData = (uint16_t *)srcBMap->GetCurrLevelPtr() + ( srcBMap->GetCurrWidth() >> 2 ) * firstRow * blockSize;
     // Note our trick here to make sure nothing breaks if GetAddr32's 
     // formula changes
     bMapStride = (uint32_t)( destBMap->GetAddr16( 0, 1 ) - destBMap->GetAddr16( 0, 0 ) );
-    x = y = 0;
+    x = 0;
+    y = firstRow << 2;
 
 
     /// Loop through the # of blocks (width*height / 16-pixel-blocks)
@@ -1194,7 +1216,8 @@ void    hsDXTSoftwareCodec::IUncompressMipmapDXT5ToAInten( plMipmap *destBMap, p
 //
 //  Note: this version decompresses to a 1-5-5-5 ARGB format.
 
-void    hsDXTSoftwareCodec::IUncompressMipmapDXT1To16( plMipmap *destBMap, plMipmap *srcBMap )
+void    hsDXTSoftwareCodec::IUncompressMipmapDXT1To16( plMipmap *destBMap, plMipmap *srcBMap,
+                                                       uint32_t firstRow, uint32_t numRows )
 {
     uint16_t      *srcData, tempW1, tempW2;
     uint16_t      *destData, destBlock[ 16 ];
@@ -1207,14 +1230,15 @@ void    hsDXTSoftwareCodec::IUncompressMipmapDXT1To16( plMipmap *destBMap, plMip
     /// Setup some nifty stuff
     hsAssert( ( srcBMap->GetCurrWidth() & 3 ) == 0, "Bitmap width must be multiple of 4" );
     hsAssert( ( srcBMap->GetCurrHeight() & 3 ) == 0, "Bitmap height must be multiple of 4" );
-    numBlocks = ( srcBMap->GetCurrWidth() * srcBMap->GetCurrHeight() ) >> 4;
+    numBlocks = ( srcBMap->GetCurrWidth() >> 2 ) * numRows;
 
     blockSize = srcBMap->fDirectXInfo.fBlockSize >> 1; // In 16-bit words
-    srcData = (uint16_t *)srcBMap->GetCurrLevelPtr();
+    srcData = (uint16_t *)srcBMap->GetCurrLevelPtr() + ( srcBMap->GetCurrWidth() >> 2 ) * firstRow * blockSize;
     // Note our trick here to make sure nothing breaks if GetAddr32's 
     // formula changes
     bMapStride = (uint32_t)( destBMap->GetAddr16( 0, 1 ) - destBMap->GetAddr16( 0, 0 ) );
-    x = y = 0;
+    x = 0;
+    y = firstRow << 2;
 
 
     /// Loop through the # of blocks (width*height / 16-pixel-blocks)
@@ -1295,8 +1319,8 @@ void    hsDXTSoftwareCodec::IUncompressMipmapDXT1To16( plMipmap *destBMap, plMip
 //
 //  Note: this version decompresses to a 5-5-5-1 RGBA format.
 
-void    hsDXTSoftwareCodec::IUncompressMipmapDXT1To16Weird( plMipmap *destBMap, 
-                                                   plMipmap *srcBMap )
+void    hsDXTSoftwareCodec::IUncompressMipmapDXT1To16Weird( plMipmap *destBMap, plMipmap *srcBMap,
+                                                            uint32_t firstRow, uint32_t numRows )
 {
     uint16_t      *srcData, tempW1, tempW2;
     uint16_t      *destData, destBlock[ 16 ];
@@ -1309,14 +1333,15 @@ void    hsDXTSoftwareCodec::IUncompressMipmapDXT1To16Weird( plMipmap *destBMap,
     /// Setup some nifty stuff
     hsAssert( ( srcBMap->GetCurrWidth() & 3 ) == 0, "Bitmap width must be multiple of 4" );
     hsAssert( ( srcBMap->GetCurrHeight() & 3 ) == 0, "Bitmap height must be multiple of 4" );
-    numBlocks = ( srcBMap->GetCurrWidth() * srcBMap->GetCurrHeight() ) >> 4;
+    numBlocks = ( srcBMap->GetCurrWidth() >> 2 ) * numRows;
 
     blockSize = srcBMap->fDirectXInfo.fBlockSize >> 1; // In 16-bit words
-    srcData = (uint16_t *)srcBMap->GetCurrLevelPtr();
+    srcData = (uint16_t *)srcBMap->GetCurrLevelPtr() + ( srcBMap->GetCurrWidth() >> 2 ) * firstRow * blockSize;
     // Note our trick here to make sure nothing breaks if GetAddr32's 
     // formula changes
     bMapStride = (uint32_t)( destBMap->GetAddr16( 0, 1 ) - destBMap->GetAddr16( 0, 0 ) );
-    x = y = 0;
+    x = 0;
+    y = firstRow << 2;
 
 
     /// Loop through the # of blocks (width*height / 16-pixel-blocks)
@@ -1397,8 +1422,8 @@ void    hsDXTSoftwareCodec::IUncompressMipmapDXT1To16Weird( plMipmap *destBMap,
 //
 //  7.31.2000 - M.Burrack - Created, based on old code (uncredited)
 
-void    hsDXTSoftwareCodec::IUncompressMipmapDXT1To32( plMipmap *destBMap, 
-                                                   plMipmap *srcBMap )
+void    hsDXTSoftwareCodec::IUncompressMipmapDXT1To32( plMipmap *destBMap, plMipmap *srcBMap,
+                                                       uint32_t firstRow, uint32_t numRows )
 {
     uint16_t      *srcData, tempW1, tempW2;
     uint32_t      *destData, destBlock[ 16 ];
@@ -1411,14 +1436,15 @@ void    hsDXTSoftwareCodec::IUncompressMipmapDXT1To32( plMipmap *destBMap,
     /// Setup some nifty stuff
     hsAssert( ( srcBMap->GetCurrWidth() & 3 ) == 0, "Bitmap width must be multiple of 4" );
     hsAssert( ( srcBMap->GetCurrHeight() & 3 ) == 0, "Bitmap height must be multiple of 4" );
-    numBlocks = ( srcBMap->GetCurrWidth() * srcBMap->GetCurrHeight() ) >> 4;
+    numBlocks = ( srcBMap->GetCurrWidth() >> 2 ) * numRows;
 
     blockSize = srcBMap->fDirectXInfo.fBlockSize >> 1; // In 16-bit words
-    srcData = (uint16_t *)srcBMap->GetCurrLevelPtr();
+    srcData = (uint16_t *)srcBMap->GetCurrLevelPtr() + ( srcBMap->GetCurrWidth() >> 2 ) * firstRow * blockSize;
     // Note our trick here to make sure nothing breaks if GetAddr32's 
     // formula changes
     bMapStride = (uint32_t)( destBMap->GetAddr32( 0, 1 ) - destBMap->GetAddr32( 0, 0 ) );
-    x = y = 0;
+    x = 0;
+    y = firstRow << 2;
 
 
     /// Loop through the # of blocks (width*height / 16-pixel-blocks)
@@ -1498,8 +1524,8 @@ void    hsDXTSoftwareCodec::IUncompressMipmapDXT1To32( plMipmap *destBMap,
 //  or all-on alpha 'compression'. Output is an 8-bit intensity bitmap, 
 //  constructed from the blue-color channel of the DXT1 output.
 
-void    hsDXTSoftwareCodec::IUncompressMipmapDXT1ToInten( plMipmap *destBMap, 
-                                                   plMipmap *srcBMap )
+void    hsDXTSoftwareCodec::IUncompressMipmapDXT1ToInten( plMipmap *destBMap, plMipmap *srcBMap,
+                                                          uint32_t firstRow, uint32_t numRows )
 {
     uint16_t      *srcData, tempW1, tempW2;
     uint8_t       *destData, destBlock[ 16 ];
@@ -1512,14 +1538,15 @@ void    hsDXTSoftwareCodec::IUncompressMipmapDXT1ToInten( plMipmap *destBMap,
     /// Setup some nifty stuff
     hsAssert( ( srcBMap->GetCurrWidth() & 3 ) == 0, "Bitmap width must be multiple of 4" );
     hsAssert( ( srcBMap->GetCurrHeight() & 3 ) == 0, "Bitmap height must be multiple of 4" );
-    numBlocks = ( srcBMap->GetCurrWidth() * srcBMap->GetCurrHeight() ) >> 4;
+    numBlocks = ( srcBMap->GetCurrWidth() >> 2 ) * numRows;
 
     blockSize = srcBMap->fDirectXInfo.fBlockSize >> 1; // In 16-bit words
-    srcData = (uint16_t *)srcBMap->GetCurrLevelPtr();
+    srcData = (uint16_t *)srcBMap->GetCurrLevelPtr() + ( srcBMap->GetCurrWidth() >> 2 ) * firstRow * blockSize;
     // Note our trick here to make sure nothing breaks if GetAddr8's 
     // formula changes
     bMapStride = (uint32_t)( destBMap->GetAddr8( 0, 1 ) - destBMap->GetAddr8( 0, 0 ) );
-    x = y = 0;
+    x = 0;
+    y = firstRow << 2;
 
     /// Loop through the # of blocks (width*height / 16-pixel-blocks)
     for( i = 0; i < numBlocks; i++ )
@@ -1926,31 +1953,54 @@ uint8_t   hsDXTSoftwareCodec::IMixEqualInten( uint8_t color1, uint8_t color2 )
 
 
 
+//// CompressMipmapLevel ////////////////////////////////////////////////////
+//  Blocks are independent of each other, so rows of them get handed out to
+//  worker threads when the level is big enough to be worth it.
+
 void hsDXTSoftwareCodec::CompressMipmapLevel( plMipmap *uncompressed, plMipmap *compressed )
+{
+    uint32_t blocksPerRow = uncompressed->GetCurrWidth() >> 2;
+    uint32_t numRows = uncompressed->GetCurrHeight() >> 2;
+
+    size_t numThreads = hsParallelThreads(size_t(numRows) * blocksPerRow, kMinCompressBlocksPerThread);
+    hsParallelFor(numRows, numThreads, [&](size_t firstRow, size_t rowCount) {
+        ICompressBlockRows(uncompressed, compressed, uint32_t(firstRow), uint32_t(rowCount));
+    });
+}
+
+void hsDXTSoftwareCodec::ICompressBlockRows( plMipmap *uncompressed, plMipmap *compressed,
+                                             uint32_t firstRow, uint32_t numRows )
 {
     uint32_t *compressedImage = (uint32_t *)compressed->GetCurrLevelPtr();
     int32_t x, y;
     int32_t xMax = uncompressed->GetCurrWidth() >> 2;
-    int32_t yMax = uncompressed->GetCurrHeight() >> 2;
-    for (x = 0; x < xMax; ++x)
+    int32_t yEnd = firstRow + numRows;
+    for (y = firstRow; y < yEnd; ++y)
     {
-        for (y = 0; y < yMax; ++y)
+        for (x = 0; x < xMax; ++x)
         {
             uint8_t maxAlpha = 0;
             uint8_t minAlpha = 255;
             uint8_t oldMaxAlpha = 0;
             uint8_t oldMinAlpha = 255;
             uint8_t alpha[8];
-            int32_t maxDistance = 0;
             hsRGBAColor32 color[4];
             bool hasTransparency = false;
 
+            // Pull the block in once, column by column (pixel index is xx * 4 + yy)
+            hsRGBAColor32 pixels[16];
             int32_t xx, yy;
+            for (xx = 0; xx < 4; ++xx)
+            {
+                for (yy = 0; yy < 4; ++yy)
+                    pixels[4 * xx + yy] = *(hsRGBAColor32*)uncompressed->GetAddr32(4 * x + xx, 4 * y + yy);
+            }
+
             for (xx = 0; xx < 4; ++xx)
             {
                 for (yy = 0; yy < 4; ++yy)
                 {
-                    hsRGBAColor32* pixel = (hsRGBAColor32*)uncompressed->GetAddr32(4 * x + xx, 4 * y + yy);
+                    const hsRGBAColor32* pixel = &pixels[4 * xx + yy];
                     uint8_t pixelAlpha = pixel->a;
                     if (pixelAlpha != 255)
                     {
@@ -1979,26 +2029,14 @@ void hsDXTSoftwareCodec::CompressMipmapLevel( plMipmap *uncompressed, plMipmap *
                             oldMinAlpha = minAlpha;
                         }
                     }
-                    
-                    int32_t xx2, yy2;
-                    for (xx2 = 0; xx2 < 4; ++xx2)
-                    {
-                        for (yy2 = 0; yy2 < 4; ++yy2)
-                        {
-                            hsRGBAColor32* pixel1 = (hsRGBAColor32*)uncompressed->GetAddr32(4 * x + xx, 4 * y + yy);
-                            hsRGBAColor32* pixel2 = (hsRGBAColor32*)uncompressed->GetAddr32(4 * x + xx2, 4 * y + yy2);
-                            
-                            int32_t distance = ColorDistanceARGBSquared(*pixel1, *pixel2);
-                            if (distance >= maxDistance)
-                            {
-                                maxDistance = distance;
-                                color[0] = *pixel1;
-                                color[1] = *pixel2;
-                            }
-                        } // for yy2
-                    } // for xx2
                 } // for yy
             } // for xx
+
+            // The two colors farthest apart become the endpoints
+            int first, second;
+            find_endpoints.call(pixels, first, second);
+            color[0] = pixels[first];
+            color[1] = pixels[second];
             
             if (oldMinAlpha == 255)
             {
@@ -2130,7 +2168,7 @@ void hsDXTSoftwareCodec::CompressMipmapLevel( plMipmap *uncompressed, plMipmap *
             {
                 for (yy = 0; yy < 4; ++yy)
                 {
-                    hsRGBAColor32* pixel = (hsRGBAColor32*)uncompressed->GetAddr32(4 * x + xx, 4 * y + yy);
+                    const hsRGBAColor32* pixel = &pixels[4 * xx + yy];
                     uint8_t pixelAlpha = pixel->a;
                     if (alphaBlock)
                     {
@@ -2212,8 +2250,8 @@ void hsDXTSoftwareCodec::CompressMipmapLevel( plMipmap *uncompressed, plMipmap *
             
             colorBlock[0] = shortColor[0];
             colorBlock[1] = shortColor[1];
-        } // for y
-    } // for x
+        } // for x
+    } // for y
 }
 
 uint16_t hsDXTSoftwareCodec::BlendColors16(uint16_t weight1, uint16_t color1, uint16_t weight2, uint16_t color2)
@@ -2265,6 +2303,39 @@ int32_t hsDXTSoftwareCodec::ColorDistanceARGBSquared(hsRGBAColor32 color1, hsRGB
     return (r1 - r2) * (r1 - r2) + (g1 - g2) * (g1 - g2) + (b1 - b2) * (b1 - b2);
 }
 
+//// find_endpoints ///////////////////////////////////////////////////////////
+//  Picks the pair of pixels farthest apart in RGB. The original search tried
+//  all 256 ordered pairs and kept the *last* maximum it saw, so ties resolve
+//  to the highest first index and then the highest second index. Distance
+//  is symmetric, so that pair always lives in the lower triangle, and walking
+//  only that in the same order gives the same answer.
+
+void hsDXTSoftwareCodec::find_endpoints_fpu(const hsRGBAColor32* pixels, int& first, int& second)
+{
+    int32_t maxDistance = 0;
+    first = second = 0;
+    for (int i = 0; i < 16; ++i)
+    {
+        for (int j = 0; j <= i; ++j)
+        {
+            int32_t distance = ColorDistanceARGBSquared(pixels[i], pixels[j]);
+            if (distance >= maxDistance)
+            {
+                maxDistance = distance;
+                first = i;
+                second = j;
+            }
+        }
+    }
+}
+
+// CPU-optimized functions requiring dispatch
+hsCpuFunctionDispatcher<hsDXTSoftwareCodec::find_endpoints_ptr> hsDXTSoftwareCodec::find_endpoints {
+    &hsDXTSoftwareCodec::find_endpoints_fpu,
+    nullptr,            // SSE1
+    &hsDXTSoftwareCodec::find_endpoints_sse2
+};
+
 uint16_t hsDXTSoftwareCodec::Color32To16(hsRGBAColor32 color)
 {
     uint8_t r = (uint8_t)(color.r & 0xf8);
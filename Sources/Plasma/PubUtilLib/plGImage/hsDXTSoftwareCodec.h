@@ -44,6 +44,7 @@ You can contact Cyan Worlds, Inc. by email legal@cyan.com
 
 #include "HeadSpin.h"
 #include "hsCodec.h"
+#include "hsCpuID.h"
 
 class plMipmap;
 typedef struct hsColor32 hsRGBAColor32;
@@ -66,17 +67,34 @@ public:
     // Colorize a compressed mipmap
     bool    ColorizeCompMipmap(plMipmap *bMap, const uint8_t *colorMask) override;
 
+    //// CPU-optimized kernels ////
+    // The SSE2 version gives the same answer as the FPU one, ties and all
+
+    // Search for the two pixels of a block farthest apart.
+    // Pixels are in column order; returns their indices.
+    typedef void(*find_endpoints_ptr)(const hsRGBAColor32* pixels, int& first, int& second);
+    static hsCpuFunctionDispatcher<find_endpoints_ptr> find_endpoints;
+    static void find_endpoints_fpu(const hsRGBAColor32* pixels, int& first, int& second);
+    static void find_endpoints_sse2(const hsRGBAColor32* pixels, int& first, int& second);
+
 private:
     enum {
         kFourColorEncoding,
         kThreeColorEncoding
     };
 
+    // Below these many blocks per thread, a level isn't worth splitting up
+    enum {
+        kMinCompressBlocksPerThread     = 256,
+        kMinUncompressBlocksPerThread   = 4096
+    };
+
     void    CompressMipmapLevel( plMipmap *uncompressed, plMipmap *compressed );
+    void    ICompressBlockRows( plMipmap *uncompressed, plMipmap *compressed, uint32_t firstRow, uint32_t numRows );
 
     uint16_t BlendColors16(uint16_t weight1, uint16_t color1, uint16_t weight2, uint16_t color2);
     hsRGBAColor32 BlendColors32(uint32_t weight1, hsRGBAColor32 color1, uint32_t weight2, hsRGBAColor32 color2);
-    int32_t ColorDistanceARGBSquared(hsRGBAColor32 color1, hsRGBAColor32 color2);
+    static int32_t ColorDistanceARGBSquared(hsRGBAColor32 color1, hsRGBAColor32 color2);
     uint16_t Color32To16(hsRGBAColor32 color);
 
     // Calculates the DXT format based on a mipmap
@@ -92,24 +110,26 @@ private:
     void inline UncompressMipmap( plMipmap *uncompressed, plMipmap *compressed, 
                                   uint8_t flags = 0 );
 
+    // Each of these decompresses numRows rows of blocks, starting at block row firstRow
+
     // Decompresses a DXT5 compressed mipmap into a RGB4444 mipmap
-    void    IUncompressMipmapDXT5To16( plMipmap *destBMap, plMipmap *srcBMap );
+    void    IUncompressMipmapDXT5To16( plMipmap *destBMap, plMipmap *srcBMap, uint32_t firstRow, uint32_t numRows );
     // Decompresses a DXT5 compressed mipmap into a RGB4444 reversed mipmap
-    void    IUncompressMipmapDXT5To16Weird( plMipmap *destBMap, plMipmap *srcBMap );
+    void    IUncompressMipmapDXT5To16Weird( plMipmap *destBMap, plMipmap *srcBMap, uint32_t firstRow, uint32_t numRows );
     // Decompresses a DXT5 compressed mipmap into a RGB8888 mipmap
-    void    IUncompressMipmapDXT5To32( plMipmap *destBMap, plMipmap *srcBMap );
+    void    IUncompressMipmapDXT5To32( plMipmap *destBMap, plMipmap *srcBMap, uint32_t firstRow, uint32_t numRows );
 
     // Decompresses a DXT1 compressed mipmap into a RGB1555 mipmap
-    void    IUncompressMipmapDXT1To16( plMipmap *destBMap, plMipmap *srcBMap );
+    void    IUncompressMipmapDXT1To16( plMipmap *destBMap, plMipmap *srcBMap, uint32_t firstRow, uint32_t numRows );
     // Decompresses a DXT1 compressed mipmap into a RGB5551 mipmap
-    void    IUncompressMipmapDXT1To16Weird( plMipmap *destBMap, plMipmap *srcBMap );
+    void    IUncompressMipmapDXT1To16Weird( plMipmap *destBMap, plMipmap *srcBMap, uint32_t firstRow, uint32_t numRows );
     // Decompresses a DXT1 compressed mipmap into a RGB8888 mipmap
-    void    IUncompressMipmapDXT1To32( plMipmap *destBMap, plMipmap *srcBMap );
+    void    IUncompressMipmapDXT1To32( plMipmap *destBMap, plMipmap *srcBMap, uint32_t firstRow, uint32_t numRows );
 
     // Decompresses a DXT1 compressed mipmap into an intensity map
-    void    IUncompressMipmapDXT1ToInten( plMipmap *destBMap, plMipmap *srcBMap );
+    void    IUncompressMipmapDXT1ToInten( plMipmap *destBMap, plMipmap *srcBMap, uint32_t firstRow, uint32_t numRows );
     // Decompresses a DXT5 compressed mipmap into an alpha-intensity map
-    void    IUncompressMipmapDXT5ToAInten( plMipmap *destBMap, plMipmap *srcBMap );
+    void    IUncompressMipmapDXT5ToAInten( plMipmap *destBMap, plMipmap *srcBMap, uint32_t firstRow, uint32_t numRows );
 
     // Mixes two RGB8888 colors equally
     uint32_t inline IMixEqualRGB32( uint32_t color1, uint32_t color2 );
@@ -0,0 +1,132 @@
+/*==LICENSE==*
+
+CyanWorlds.com Engine - MMOG client, server and tools
+Copyright (C) 2011  Cyan Worlds, Inc.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+Additional permissions under GNU GPL version 3 section 7
+
+If you modify this Program, or any covered work, by linking or
+combining it with any of RAD Game Tools Bink SDK, Autodesk 3ds Max SDK,
+NVIDIA PhysX SDK, Microsoft DirectX SDK, OpenSSL library, Independent
+JPEG Group JPEG library, Microsoft Windows Media SDK, or Apple QuickTime SDK
+(or a modified version of those libraries),
+containing parts covered by the terms of the Bink SDK EULA, 3ds Max EULA,
+PhysX SDK EULA, DirectX SDK EULA, OpenSSL and SSLeay licenses, IJG
+JPEG Library README, Windows Media SDK EULA, or QuickTime SDK EULA, the
+licensors of this Program grant you additional
+permission to convey the resulting work. Corresponding Source for a
+non-source form of such a combination shall include the source code for
+the parts of OpenSSL and IJG JPEG Library used as well as that of the covered
+work.
+
+You can contact Cyan Worlds, Inc. by email legal@cyan.com
+ or by snail mail at:
+      Cyan Worlds, Inc.
+      14617 N Newport Hwy
+      Mead, WA   99021
+
+*==LICENSE==*/
+
+#include "HeadSpin.h"
+#include "hsColorRGBA.h"
+#include "hsDXTSoftwareCodec.h"
+
+#ifdef HAVE_SSE2
+#   include <emmintrin.h>
+#endif
+
+#ifdef HAVE_SSE2
+// Pulls one 8-bit channel out of eight packed pixels into 16-bit lanes
+static inline __m128i IUnpackChannel(__m128i lo, __m128i hi, int shift)
+{
+    const __m128i mask = _mm_set1_epi32(0xff);
+    lo = _mm_and_si128(_mm_srli_epi32(lo, shift), mask);
+    hi = _mm_and_si128(_mm_srli_epi32(hi, shift), mask);
+    return _mm_packs_epi32(lo, hi);
+}
+
+static inline __m128i IMaxEpi32(__m128i a, __m128i b)
+{
+    __m128i gt = _mm_cmpgt_epi32(a, b);
+    return _mm_or_si128(_mm_and_si128(gt, a), _mm_andnot_si128(gt, b));
+}
+#endif
+
+void hsDXTSoftwareCodec::find_endpoints_sse2(const hsRGBAColor32* pixels, int& first, int& second)
+{
+#ifdef HAVE_SSE2
+    const __m128i zero = _mm_setzero_si128();
+
+    // hsColor32 is b, g, r, a in memory, so blue is the low byte of each lane
+    __m128i p0 = _mm_loadu_si128((const __m128i*)(pixels + 0));
+    __m128i p1 = _mm_loadu_si128((const __m128i*)(pixels + 4));
+    __m128i p2 = _mm_loadu_si128((const __m128i*)(pixels + 8));
+    __m128i p3 = _mm_loadu_si128((const __m128i*)(pixels + 12));
+    __m128i r[2] = { IUnpackChannel(p0, p1, 16), IUnpackChannel(p2, p3, 16) };
+    __m128i g[2] = { IUnpackChannel(p0, p1, 8), IUnpackChannel(p2, p3, 8) };
+    __m128i b[2] = { IUnpackChannel(p0, p1, 0), IUnpackChannel(p2, p3, 0) };
+
+    // Full 16x16 distance table, one row per first pixel
+    alignas(16) int32_t dist[16][16];
+    __m128i maxDist = zero;
+    for (int i = 0; i < 16; ++i)
+    {
+        __m128i ri = _mm_set1_epi16(pixels[i].r);
+        __m128i gi = _mm_set1_epi16(pixels[i].g);
+        __m128i bi = _mm_set1_epi16(pixels[i].b);
+        for (int h = 0; h < 2; ++h)
+        {
+            __m128i dr = _mm_sub_epi16(r[h], ri);
+            __m128i dg = _mm_sub_epi16(g[h], gi);
+            __m128i db = _mm_sub_epi16(b[h], bi);
+
+            __m128i rg = _mm_unpacklo_epi16(dr, dg);
+            __m128i bz = _mm_unpacklo_epi16(db, zero);
+            __m128i lo = _mm_add_epi32(_mm_madd_epi16(rg, rg), _mm_madd_epi16(bz, bz));
+            rg = _mm_unpackhi_epi16(dr, dg);
+            bz = _mm_unpackhi_epi16(db, zero);
+            __m128i hi = _mm_add_epi32(_mm_madd_epi16(rg, rg), _mm_madd_epi16(bz, bz));
+
+            _mm_store_si128((__m128i*)&dist[i][h * 8], lo);
+            _mm_store_si128((__m128i*)&dist[i][h * 8 + 4], hi);
+            maxDist = IMaxEpi32(maxDist, IMaxEpi32(lo, hi));
+        }
+    }
+    maxDist = IMaxEpi32(maxDist, _mm_shuffle_epi32(maxDist, _MM_SHUFFLE(1, 0, 3, 2)));
+    maxDist = IMaxEpi32(maxDist, _mm_shuffle_epi32(maxDist, _MM_SHUFFLE(2, 3, 0, 1)));
+
+    // Same tie-break as the scalar search: the last maximal pair wins
+    for (int i = 15; i >= 0; --i)
+    {
+        int hits = 0;
+        for (int q = 0; q < 4; ++q)
+        {
+            __m128i eq = _mm_cmpeq_epi32(_mm_load_si128((const __m128i*)&dist[i][q * 4]), maxDist);
+            hits |= _mm_movemask_ps(_mm_castsi128_ps(eq)) << (q * 4);
+        }
+        if (hits)
+        {
+            int j = 15;
+            while (!(hits & (1 << j)))
+                --j;
+            first = i;
+            second = j;
+            return;
+        }
+    }
+    first = second = 0;
+#endif
+}
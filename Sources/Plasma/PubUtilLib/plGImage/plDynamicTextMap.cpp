@@ -54,6 +54,7 @@ You can contact Cyan Worlds, Inc. by email legal@cyan.com
 #include "HeadSpin.h"
 #include "plDynamicTextMap.h"
 
+#include <algorithm>
 #include <string_theory/format>
 
 #include "hsStream.h"
@@ -71,6 +72,7 @@ You can contact Cyan Worlds, Inc. by email legal@cyan.com
 
 plProfile_CreateMemCounter("DynaTextMem", "PipeC", DynaTextMem);
 plProfile_CreateCounterNoReset("DynaTexts", "PipeC", DynaTexts);
+plProfile_CreateCounter("DynaTextUpload", "PipeC", DynaTextUpload);
 plProfile_Extern(MemMipmaps);
 
 
@@ -79,7 +81,8 @@ plProfile_Extern(MemMipmaps);
 plDynamicTextMap::plDynamicTextMap()
     : fVisWidth(0), fVisHeight(0), fHasAlpha(false), fPremultipliedAlpha(false), fJustify(kLeftJustify),
       fInitBuffer(), fFontSize(), fFontFlags(), fShadowed(), fLineSpacing(),
-      fCurrFont(), fFontAntiAliasRGB(), fFontBlockRGB(), fHasCreateBeenCalled()
+      fCurrFont(), fFontAntiAliasRGB(), fFontBlockRGB(), fHasCreateBeenCalled(),
+      fFullyDirty(true)
 {
     fFontColor.Set(0, 0, 0, 1);
 }
@@ -90,7 +93,7 @@ plDynamicTextMap::~plDynamicTextMap()
 }
 
 plDynamicTextMap::plDynamicTextMap( uint32_t width, uint32_t height, bool hasAlpha, uint32_t extraWidth, uint32_t extraHeight, bool premultipliedAlpha )
-    : fInitBuffer(nullptr)
+    : fInitBuffer(nullptr), fFullyDirty(true)
 {
     Create( width, height, hasAlpha, extraWidth, extraHeight, premultipliedAlpha );
 }
@@ -129,6 +132,7 @@ void    plDynamicTextMap::Create( uint32_t width, uint32_t height, bool hasAlpha
 
     // instead of allocating the fImage here, we'll wait for the first draw operation to be called (in IIsValid)
     fHasCreateBeenCalled = true;
+    ISetFullyDirty();
 
     fRowBytes = fWidth << 2;
     fNumLevels = 1;
@@ -166,6 +170,7 @@ void    plDynamicTextMap::Reset()
     fInitBuffer = nullptr;
 
     fFontFace = ST::string();
+    ISetFullyDirty();
 
     // Destroy the old texture ref, since we're no longer using it
     SetDeviceRef(nullptr);
@@ -198,6 +203,7 @@ bool        plDynamicTextMap::IIsValid()
         // Destroy the old texture ref, if we have one. This should force the 
         // pipeline to recreate one more suitable for our use
         SetDeviceRef(nullptr);
+        ISetFullyDirty();
         plProfile_NewMem(MemMipmaps, fTotalSize);
         plProfile_NewMem(DynaTextMem, fTotalSize);
 #ifdef MEMORY_LEAK_TRACER
@@ -221,6 +227,7 @@ void plDynamicTextMap::PurgeImage()
     // Destroy the old texture ref, if we have one. This should force the 
     // pipeline to recreate one more suitable for our use
     SetDeviceRef(nullptr);
+    ISetFullyDirty();
 }
 
 //// IAllocateOSSurface ///////////////////////////////////////////////////////
@@ -377,6 +384,8 @@ void    plDynamicTextMap::IClearFromBuffer( uint32_t *clearBuffer )
         data += fWidth;
         srcData += fVisWidth;
     }
+
+    ISetFullyDirty();
 }
 
 //// IPropagateFlags //////////////////////////////////////////////////////////
@@ -403,6 +412,8 @@ void    plDynamicTextMap::ClearToColor( hsColorRGBA &color )
     // Buffer is of size fVisWidth x fVisHeight, so we need a bit of work to do this right
     for( i = 0; i < fHeight * fWidth; i++ )
         data[ i ] = hex;
+
+    ISetFullyDirty();
 }
 
 //// SetJustify ///////////////////////////////////////////////////////////////
@@ -498,6 +509,7 @@ void    plDynamicTextMap::DrawString( uint16_t x, uint16_t y, const wchar_t *tex
     fCurrFont->SetRenderFlag( plFont::kRenderWrap | plFont::kRenderClip, false );
 	fCurrFont->SetRenderClipRect( 0, 0, fVisWidth, fVisHeight );
     fCurrFont->RenderString( this, x, y, text );
+    IAddDirtyText();
 }
 
 //// DrawClippedString ////////////////////////////////////////////////////////
@@ -516,6 +528,7 @@ void    plDynamicTextMap::DrawClippedString( int16_t x, int16_t y, const wchar_t
     IPropagateFlags();
     fCurrFont->SetRenderClipping( x, y, width, height );
     fCurrFont->RenderString( this, x, y, text );
+    IAddDirtyText();
 }
 
 //// DrawClippedString ////////////////////////////////////////////////////////
@@ -534,6 +547,7 @@ void    plDynamicTextMap::DrawClippedString( int16_t x, int16_t y, const wchar_t
     IPropagateFlags();
     fCurrFont->SetRenderClipping( clipX, clipY, width, height );
     fCurrFont->RenderString( this, x, y, text );
+    IAddDirtyText();
 }
 
 //// DrawWrappedString ////////////////////////////////////////////////////////
@@ -552,6 +566,7 @@ void    plDynamicTextMap::DrawWrappedString( uint16_t x, uint16_t y, const wchar
     IPropagateFlags();
     fCurrFont->SetRenderWrapping( x, y, width, height );
     fCurrFont->RenderString( this, x, y, text, lastX, lastY );
+    IAddDirtyText();
 }
 
 //// CalcStringWidth //////////////////////////////////////////////////////////
@@ -641,6 +656,7 @@ void    plDynamicTextMap::FillRect( uint16_t x, uint16_t y, uint16_t width, uint
 
     // Gee, how hard can it REALLY be?
     uint32_t i, hex = fPremultipliedAlpha ? color.ToARGB32Premultiplied() : color.ToARGB32();
+    IAddDirtyRect( x, y, width, height );
     height += y;
     if( height > fHeight )
         height = (uint16_t)fHeight;
@@ -668,6 +684,12 @@ void    plDynamicTextMap::FrameRect( uint16_t x, uint16_t y, uint16_t width, uin
     uint32_t i, hex = fPremultipliedAlpha ? color.ToARGB32Premultiplied() : color.ToARGB32();
     uint32_t *dest1, *dest2;
 
+    // Only the edges change, so don't make a pipeline upload the middle
+    IAddDirtyRect( x, y, width, 1 );
+    IAddDirtyRect( x, y + height - 1, width, 1 );
+    IAddDirtyRect( x, y, 1, height );
+    IAddDirtyRect( x + width - 1, y, 1, height );
+
     dest1 = GetAddr32( x, y );
     dest2 = GetAddr32( x, y + height - 1 );
     for( i = 0; i < width; i++ )
@@ -704,6 +726,7 @@ void    plDynamicTextMap::DrawImage( uint16_t x, uint16_t y, plMipmap *image, Dr
         opts.fFlags |= plMipmap::kDestPremultiplied;
 
     Composite( image, x, y, &opts );
+    IAddDirtyRect( x, y, image->GetWidth(), image->GetHeight() );
 
     /// HACK for now, since the alpha in the mipmap gets copied straight into the
     /// 32-bit color buffer, but our separate hacked alpha buffer hasn't been updated
@@ -749,6 +772,8 @@ void    plDynamicTextMap::DrawClippedImage( uint16_t x, uint16_t y, plMipmap *im
     opts.fSrcClipWidth = srcClipWidth;
     opts.fSrcClipHeight = srcClipHeight;
     Composite( image, x, y, &opts );
+    IAddDirtyRect( x, y, srcClipWidth > 0 ? srcClipWidth : image->GetWidth(),
+                   srcClipHeight > 0 ? srcClipHeight : image->GetHeight() );
 
     /// HACK for now, since the alpha in the mipmap gets copied straight into the
     /// 32-bit color buffer, but our separate hacked alpha buffer hasn't been updated
@@ -859,6 +884,97 @@ bool    plDynamicTextMap::MsgReceive( plMessage *msg )
     return plMipmap::MsgReceive( msg );
 }
 
+//// IAddDirtyRect ////////////////////////////////////////////////////////////
+//  Records a region a draw op just wrote to. Overlapping rects are merged,
+//  and once there are too many of them, or they add up to most of the
+//  surface, we give up and call the whole thing dirty: past that point,
+//  a handful of small copies costs more than one big one.
+
+static const size_t kMaxDirtyRects = 16;
+
+void    plDynamicTextMap::IAddDirtyRect( int32_t x, int32_t y, int32_t width, int32_t height )
+{
+    if( fFullyDirty )
+        return;
+
+    int32_t left = std::max( x, 0 ), top = std::max( y, 0 );
+    int32_t right = std::min( x + width, (int32_t)fWidth );
+    int32_t bottom = std::min( y + height, (int32_t)fHeight );
+    if( right <= left || bottom <= top )
+        return;
+
+    // Swallow anything this touches, repeating since each merge grows us
+    for( size_t i = 0; i < fDirtyRects.size(); )
+    {
+        const DirtyRect &r = fDirtyRects[ i ];
+        if( r.fX > right || r.fX + r.fWidth < left || r.fY > bottom || r.fY + r.fHeight < top )
+        {
+            i++;
+            continue;
+        }
+
+        left = std::min( left, (int32_t)r.fX );
+        top = std::min( top, (int32_t)r.fY );
+        right = std::max( right, (int32_t)( r.fX + r.fWidth ) );
+        bottom = std::max( bottom, (int32_t)( r.fY + r.fHeight ) );
+        fDirtyRects.erase( fDirtyRects.begin() + i );
+        i = 0;
+    }
+
+    if( fDirtyRects.size() >= kMaxDirtyRects )
+    {
+        for( const DirtyRect &r : fDirtyRects )
+        {
+            left = std::min( left, (int32_t)r.fX );
+            top = std::min( top, (int32_t)r.fY );
+            right = std::max( right, (int32_t)( r.fX + r.fWidth ) );
+            bottom = std::max( bottom, (int32_t)( r.fY + r.fHeight ) );
+        }
+        fDirtyRects.clear();
+    }
+
+    fDirtyRects.push_back( { (uint16_t)left, (uint16_t)top, (uint16_t)( right - left ), (uint16_t)( bottom - top ) } );
+
+    if( GetDirtyBytes() >= ( fHeight * fRowBytes ) * 3 / 4 )
+        ISetFullyDirty();
+}
+
+//// IAddDirtyText ////////////////////////////////////////////////////////////
+//  Dirties whatever the font says it just drew.
+
+void    plDynamicTextMap::IAddDirtyText()
+{
+    pcSmallRect drawn = fCurrFont->GetLastRenderRect();
+    IAddDirtyRect( drawn.fX, drawn.fY, drawn.fWidth, drawn.fHeight );
+}
+
+//// GetDirtyBytes ////////////////////////////////////////////////////////////
+//  What an upload honoring the dirty rects will copy. Rects never overlap,
+//  so this is just the sum.
+
+uint32_t    plDynamicTextMap::GetDirtyBytes() const
+{
+    if( fFullyDirty )
+        return fHeight * fRowBytes;
+
+    uint32_t bytes = 0;
+    for( const DirtyRect &r : fDirtyRects )
+        bytes += r.fWidth * r.fHeight * sizeof( uint32_t );
+    return bytes;
+}
+
+//// ClearDirtyRects //////////////////////////////////////////////////////////
+
+uint32_t    plDynamicTextMap::ClearDirtyRects( bool uploadedAll )
+{
+    uint32_t bytes = uploadedAll ? fHeight * fRowBytes : GetDirtyBytes();
+    plProfile_IncCount(DynaTextUpload, bytes);
+
+    fDirtyRects.clear();
+    fFullyDirty = false;
+    return bytes;
+}
+
 //// Swap /////////////////////////////////////////////////////////////////////
 //  Swapping is an evil little trick. It's also something that should probably
 //  be exposed at the mipmap level eventually, but there's no need for it yet.
@@ -885,6 +1001,8 @@ void    plDynamicTextMap::Swap( plDynamicTextMap *other )
         GetDeviceRef()->SetDirty( true );
     if (other->GetDeviceRef() != nullptr)
         other->GetDeviceRef()->SetDirty( true );
+    ISetFullyDirty();
+    other->ISetFullyDirty();
 
     // Swap DTMap info
     SWAP_ME( bool, fHasAlpha, other->fHasAlpha );
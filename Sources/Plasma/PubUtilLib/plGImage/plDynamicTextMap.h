@@ -82,6 +82,8 @@ You can contact Cyan Worlds, Inc. by email legal@cyan.com
 #include "plMipmap.h"
 #include "hsColorRGBA.h"
 
+#include <vector>
+
 struct hsMatrix44;
 
 //// Class Definition /////////////////////////////////////////////////////////
@@ -210,6 +212,33 @@ class plDynamicTextMap : public plMipmap
 
         virtual void    Swap( plDynamicTextMap *other );
 
+        //// Dirty Regions ////
+        // Every draw op records the texels it touched. FlushToHost() still
+        // just dirties the device ref, so a pipeline that knows nothing about
+        // this keeps re-uploading the whole surface, which is always right.
+        // A pipeline that wants to do better, and already has a texture of
+        // our size, copies only GetDirtyRects() (rows are fRowBytes apart in
+        // GetImage(), like everything else here) when HasDirtyRects() and not
+        // IsFullyDirty(), then calls ClearDirtyRects(). A dirty device ref with
+        // no rects at all means somebody changed the image behind our back, so
+        // that gets a full upload. Full uploads should clear with true so
+        // nothing stale lingers for the next partial one.
+        struct DirtyRect
+        {
+            uint16_t    fX, fY, fWidth, fHeight;
+        };
+
+        const std::vector<DirtyRect>& GetDirtyRects() const { return fDirtyRects; }
+        bool        IsFullyDirty() const { return fFullyDirty; }
+        bool        HasDirtyRects() const { return fFullyDirty || !fDirtyRects.empty(); }
+        uint32_t    GetDirtyBytes() const;
+
+        // Returns the number of bytes the caller has just uploaded
+        uint32_t    ClearDirtyRects( bool uploadedAll = false );
+
+        // For anyone writing straight into GetImage() instead of drawing
+        void        MarkFullyDirty() { ISetFullyDirty(); }
+
     protected:
 
         //// Protected Members ////
@@ -222,6 +251,10 @@ class plDynamicTextMap : public plMipmap
 
         void        IPropagateFlags();
 
+        void        IAddDirtyRect( int32_t x, int32_t y, int32_t width, int32_t height );
+        void        IAddDirtyText();
+        void        ISetFullyDirty() { fDirtyRects.clear(); fFullyDirty = true; }
+
         bool        fHasAlpha, fPremultipliedAlpha, fShadowed;
 
         Justify     fJustify;
@@ -238,6 +271,9 @@ class plDynamicTextMap : public plMipmap
         uint32_t      *fInitBuffer;
         
         bool        fHasCreateBeenCalled;
+
+        std::vector<DirtyRect>  fDirtyRects;
+        bool                    fFullyDirty;
 };
 
 
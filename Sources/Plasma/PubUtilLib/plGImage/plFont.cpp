@@ -63,6 +63,7 @@ You can contact Cyan Worlds, Inc. by email legal@cyan.com
 ///////////////////////////////////////////////////////////////////////////////
 
 #include "HeadSpin.h"
+#include <algorithm>
 #include <string>
 
 #include "plFont.h"
@@ -71,6 +72,21 @@ You can contact Cyan Worlds, Inc. by email legal@cyan.com
 #include "hsResMgr.h"
 
 
+bool plFont::fRenderCaching = true;
+
+// Kernel for the drop shadow IRenderChar8To32AlphaPremShadow draws
+static const uint32_t kShadowKernel[5][5] = {
+    {1,  2,  2,  2, 1},
+    {1, 13, 13, 13, 1},
+    {1, 10, 10, 10, 1},
+    {1,  7,  7,  7, 1},
+    {1,  1,  1,  1, 1}
+};
+
+// Only a few colors of any one font are ever on screen at once
+static const size_t kMaxGlyphCaches = 4;
+static const size_t kMaxCachedExtents = 256;
+
 //// plCharacter Stuff ////////////////////////////////////////////////////////
 
 plFont::plCharacter::plCharacter()
@@ -140,6 +156,11 @@ void    plFont::IClear( bool onConstruct )
     fRenderInfo.fVolatileStringPtr = nullptr;
     fRenderInfo.fFirstLineIndent = 0;
     fRenderInfo.fLineSpacing = 0;
+    fRenderInfo.fDrawnLeft = fRenderInfo.fDrawnTop = 0;
+    fRenderInfo.fDrawnRight = fRenderInfo.fDrawnBottom = 0;
+    fRenderInfo.fGlyphCache = nullptr;
+
+    IFlushRenderCaches();
 }
 
 void    plFont::Read( hsStream *s, hsResMgr *mgr )
@@ -245,6 +266,16 @@ void    plFont::RenderString( plMipmap *mip, uint16_t x, uint16_t y, const wchar
         *lastY = fRenderInfo.fLastY;
 }
 
+pcSmallRect plFont::GetLastRenderRect() const
+{
+    if (fRenderInfo.fDrawnRight <= fRenderInfo.fDrawnLeft || fRenderInfo.fDrawnBottom <= fRenderInfo.fDrawnTop)
+        return pcSmallRect();
+
+    return pcSmallRect(fRenderInfo.fDrawnLeft, fRenderInfo.fDrawnTop,
+                       fRenderInfo.fDrawnRight - fRenderInfo.fDrawnLeft,
+                       fRenderInfo.fDrawnBottom - fRenderInfo.fDrawnTop);
+}
+
 const plFont::plCharacter& plFont::IGetCharacter(wchar_t c) const
 {
     if (c - fFirstChar < fCharacters.size()) {
@@ -265,6 +296,8 @@ void    plFont::IRenderString( plMipmap *mip, uint16_t x, uint16_t y, const wcha
     fRenderInfo.fFarthestX = x;
     fRenderInfo.fMaxAscent = 0;
     fRenderInfo.fVolatileStringPtr = string;
+    fRenderInfo.fDrawnLeft = fRenderInfo.fDrawnTop = INT16_MAX;
+    fRenderInfo.fDrawnRight = fRenderInfo.fDrawnBottom = INT16_MIN;
 
     switch( fRenderInfo.fFlags & kRenderJustYMask )
     {
@@ -368,6 +401,14 @@ void    plFont::IRenderString( plMipmap *mip, uint16_t x, uint16_t y, const wcha
         return;
     }
 
+    // All the 8-bit renderers can be swapped for blits of pre-converted glyphs
+    fRenderInfo.fGlyphCache = nullptr;
+    if( fRenderCaching && !justCalc && fBPP == 8 )
+    {
+        fRenderInfo.fGlyphCache = IGetGlyphCache( fRenderInfo.fRenderFunc, fRenderInfo.fColor );
+        fRenderInfo.fRenderFunc = &plFont::IRenderCharCached;
+    }
+
     // Init our other render values
     if( !justCalc )
     {
@@ -723,6 +764,16 @@ void    plFont::IRenderLoop( const wchar_t *string, int32_t maxCount )
 
                 (this->*(fRenderInfo.fRenderFunc))( fCharacters[ c ] );
 
+                // Grow the drawn box by the whole glyph cell. The AA renderers
+                // only use half of it, and the shadowed one bleeds 2 pixels
+                // out on every side, so pad for that and don't sweat the rest.
+                int16_t cellTop = fRenderInfo.fY - (int16_t)fCharacters[ c ].fBaseline - 2;
+                int16_t cellBottom = cellTop + (int16_t)fCharacters[ c ].fHeight + 4;
+                fRenderInfo.fDrawnLeft = std::min(fRenderInfo.fDrawnLeft, int16_t(fRenderInfo.fX - 2));
+                fRenderInfo.fDrawnRight = std::max(fRenderInfo.fDrawnRight, int16_t(fRenderInfo.fX + fWidth + 2));
+                fRenderInfo.fDrawnTop = std::min(fRenderInfo.fDrawnTop, cellTop);
+                fRenderInfo.fDrawnBottom = std::max(fRenderInfo.fDrawnBottom, cellBottom);
+
                 fRenderInfo.fX += thisWidth;
                 fRenderInfo.fMaxWidth -= thisWidth;
                 fRenderInfo.fDestPtr += thisWidth * fRenderInfo.fDestBPP;
@@ -1121,14 +1172,6 @@ void    plFont::IRenderChar8To32AlphaPremShadow( const plFont::plCharacter &c )
     srcG = (uint8_t)(( fRenderInfo.fColor >> 8  ) & 0x000000ff);
     srcB = (uint8_t)(( fRenderInfo.fColor       ) & 0x000000ff);
 
-    static const uint32_t kernel[5][5] = {
-        {1,  2,  2,  2, 1},
-        {1, 13, 13, 13, 1},
-        {1, 10, 10, 10, 1},
-        {1,  7,  7,  7, 1},
-        {1,  1,  1,  1, 1}
-    };
-
     uint32_t clamp = 220 - ((2 * srcR + 4 * srcG + srcB) >> 4);
 
     y = fRenderInfo.fClipRect.fY - fRenderInfo.fY + (int16_t)c.fBaseline;
@@ -1148,7 +1191,7 @@ void    plFont::IRenderChar8To32AlphaPremShadow( const plFont::plCharacter &c )
             uint32_t sa = 0;
             for (int32_t i = -2; i <= 2; i++) {
                 for (int32_t j = -2; j <= 2; j++) {
-                    uint32_t m = kernel[j+2][i+2];
+                    uint32_t m = kShadowKernel[j+2][i+2];
                     if (m != 0)
                         sa += m * IGetCharPixel(c, x+i, y+j);
                 }
@@ -1177,6 +1220,245 @@ void    plFont::IRenderCharNull( const plCharacter &c )
 {
 }
 
+//// Glyph Caching ////////////////////////////////////////////////////////////
+
+void    plFont::IRenderCharCached( const plFont::plCharacter &c )
+{
+    plGlyphCache *cache = fRenderInfo.fGlyphCache;
+    std::vector<uint32_t> &cell = cache->fCells[ &c - fCharacters.data() ];
+    if( cell.empty() )
+    {
+        ICacheGlyph( c, cell );
+        if( cell.empty() )
+            return;
+    }
+
+    // Clip exactly like the render function we're standing in for
+    int16_t pad = cache->fPad;
+    int16_t cellWidth = (int16_t)fWidth + pad * 2;
+
+    int16_t thisWidth = (int16_t)fWidth + pad;
+    if( thisWidth >= fRenderInfo.fMaxWidth )
+        thisWidth = fRenderInfo.fMaxWidth;
+
+    int16_t xstart = fRenderInfo.fClipRect.fX - fRenderInfo.fX;
+    if( xstart < -pad )
+        xstart = -pad;
+
+    int16_t y = fRenderInfo.fClipRect.fY - fRenderInfo.fY + (int16_t)c.fBaseline;
+    if( y < -pad )
+        y = -pad;
+
+    int16_t thisHeight = fRenderInfo.fMaxHeight + (int16_t)c.fBaseline;
+    if( thisHeight > (int16_t)c.fHeight + pad )
+        thisHeight = (int16_t)c.fHeight + pad;
+
+    if( xstart >= thisWidth )
+        return;
+
+    blit_row_ptr blit;
+    if( cache->fFunc == &plFont::IRenderChar8To32AlphaPremShadow )
+        blit = blit_max_alpha.call;
+    else if( cache->fFunc == &plFont::IRenderChar8To32 )
+        blit = blit_blend.call;
+    else
+        blit = blit_masked.call;
+
+    uint8_t *destRow = fRenderInfo.fDestPtr + ( y - (int16_t)c.fBaseline ) * int32_t(fRenderInfo.fDestStride);
+    for( ; y < thisHeight; y++ )
+    {
+        // Only unpadded cells need the coverage, padded (shadow) cells never do
+        const uint32_t *cellRow = cell.data() + ( y + pad ) * cellWidth + pad + xstart;
+        const uint8_t *coverage = pad ? nullptr : fBMapData + c.fBitmapOff + y * fWidth + xstart;
+        blit( (uint32_t *)destRow + xstart, cellRow, coverage, thisWidth - xstart );
+        destRow += fRenderInfo.fDestStride;
+    }
+}
+
+//// ICacheGlyph //////////////////////////////////////////////////////////////
+//  Converts one glyph to exactly the pixels the current glyph cache's render
+//  function would write for it. Destination-dependent bits are left for the
+//  blit: blended pixels carry their inverse alpha in the top byte, and shadow
+//  pixels are only written over lower alphas.
+
+void    plFont::ICacheGlyph( const plFont::plCharacter &c, std::vector<uint32_t> &cell ) const
+{
+    const plGlyphCache *cache = fRenderInfo.fGlyphCache;
+    int32_t pad = cache->fPad;
+    int32_t cellWidth = (int32_t)fWidth + pad * 2, cellHeight = (int32_t)c.fHeight + pad * 2;
+    if( cellWidth <= 0 || cellHeight <= 0 )
+        return;
+
+    cell.resize( cellWidth * cellHeight );
+
+    uint32_t color = cache->fColor;
+    uint32_t srcA = ( color >> 24 ) & 0xff, srcR = ( color >> 16 ) & 0xff;
+    uint32_t srcG = ( color >> 8 ) & 0xff, srcB = color & 0xff;
+    uint32_t colorOnly = color & 0x00ffffff;
+    uint32_t clamp = 220 - ( ( 2 * srcR + 4 * srcG + srcB ) >> 4 );
+
+    uint32_t *dest = cell.data();
+    for( int32_t y = -pad; y < (int32_t)c.fHeight + pad; y++ )
+    {
+        for( int32_t x = -pad; x < (int32_t)fWidth + pad; x++, dest++ )
+        {
+            uint32_t val = IGetCharPixel( c, x, y );
+
+            if( cache->fFunc == &plFont::IRenderChar8To32AlphaPremShadow )
+            {
+                uint32_t sa = 0;
+                for( int32_t i = -2; i <= 2; i++ )
+                    for( int32_t j = -2; j <= 2; j++ )
+                        sa += kShadowKernel[ j + 2 ][ i + 2 ] * IGetCharPixel( c, x + i, y + j );
+                sa = ( sa * clamp ) >> 13;
+                if( sa > clamp )
+                    sa = clamp;
+                uint32_t a = val;
+                if( srcA != 0xff )
+                {
+                    a = ( srcA * a + 127 ) / 255;
+                    sa = ( srcA * sa + 127 ) / 255;
+                }
+                uint32_t ta = a + sa - ( ( a * sa + 127 ) / 255 );
+                *dest = ( ta << 24 ) | ( ( ( srcR * a + 127 ) / 255 ) << 16 ) |
+                                       ( ( ( srcG * a + 127 ) / 255 ) <<  8 ) |
+                                       ( ( ( srcB * a + 127 ) / 255 ) <<  0 );
+            }
+            else if( val == 0 )
+                *dest = 0;  // Never drawn
+            else if( cache->fFunc == &plFont::IRenderChar8To32 )
+            {
+                if( val == 255 )
+                    *dest = color;
+                else
+                {
+                    uint32_t srcAlpha = ( val * srcA ) / 255;
+                    *dest = ( ( 255 - srcAlpha ) << 24 ) | ( ( ( srcR * srcAlpha ) >> 8 ) << 16 ) |
+                            ( ( ( srcG * srcAlpha ) >> 8 ) << 8 ) | ( ( srcB * srcAlpha ) >> 8 );
+                }
+            }
+            else if( cache->fFunc == &plFont::IRenderChar8To32FullAlpha )
+                *dest = ( val << 24 ) | colorOnly;
+            else if( cache->fFunc == &plFont::IRenderChar8To32Alpha )
+            {
+                uint32_t fullAlpha = color & 0xff000000;
+                if( val == 0xff )
+                    *dest = fullAlpha | colorOnly;
+                else
+                    *dest = ( ( ( fullAlpha / 255 ) * val ) & 0xff000000 ) | colorOnly;
+            }
+            else // IRenderChar8To32AlphaPremultiplied
+            {
+                uint32_t a = val;
+                if( srcA != 0xff )
+                    a = ( srcA * a + 127 ) / 255;
+                *dest = ( a << 24 ) | ( ( ( srcR * a + 127 ) / 255 ) << 16 ) |
+                        ( ( ( srcG * a + 127 ) / 255 ) << 8 ) | ( ( srcB * a + 127 ) / 255 );
+            }
+        }
+    }
+}
+
+//// IGetGlyphCache ///////////////////////////////////////////////////////////
+
+plFont::plGlyphCache    *plFont::IGetGlyphCache( CharRenderFunc func, uint32_t color )
+{
+    for( auto it = fGlyphCaches.begin(); it != fGlyphCaches.end(); ++it )
+    {
+        if( (*it)->fFunc == func && (*it)->fColor == color )
+        {
+            std::rotate( fGlyphCaches.begin(), it, it + 1 );
+            return fGlyphCaches.front().get();
+        }
+    }
+
+    if( fGlyphCaches.size() >= kMaxGlyphCaches )
+        fGlyphCaches.pop_back();
+
+    auto cache = std::make_unique<plGlyphCache>();
+    cache->fFunc = func;
+    cache->fColor = color;
+    cache->fPad = ( func == &plFont::IRenderChar8To32AlphaPremShadow ) ? 2 : 0;
+    cache->fCells.resize( fCharacters.size() );
+    fGlyphCaches.insert( fGlyphCaches.begin(), std::move( cache ) );
+    return fGlyphCaches.front().get();
+}
+
+void    plFont::IFlushRenderCaches()
+{
+    fGlyphCaches.clear();
+    fExtentsCache.clear();
+    fRenderInfo.fGlyphCache = nullptr;
+}
+
+bool plFont::plExtentsKey::operator==(const plExtentsKey &other) const
+{
+    return fFlags == other.fFlags && fClipX == other.fClipX && fClipY == other.fClipY
+        && fClipWidth == other.fClipWidth && fClipHeight == other.fClipHeight
+        && fFirstLineIndent == other.fFirstLineIndent && fLineSpacing == other.fLineSpacing
+        && fText == other.fText;
+}
+
+size_t plFont::plExtentsKeyHash::operator()(const plExtentsKey &key) const
+{
+    size_t hash = std::hash<std::wstring>()(key.fText);
+    hash ^= key.fFlags + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+    hash ^= ((uint32_t)(uint16_t)key.fClipWidth << 16 | (uint16_t)key.fClipHeight) + (hash << 6) + (hash >> 2);
+    return hash;
+}
+
+//// Cached Glyph Blits ///////////////////////////////////////////////////////
+
+void plFont::blit_masked_fpu(uint32_t* dest, const uint32_t* cell, const uint8_t* coverage, int count)
+{
+    for (int x = 0; x < count; x++) {
+        if (coverage[x] != 0)
+            dest[x] = cell[x];
+    }
+}
+
+void plFont::blit_blend_fpu(uint32_t* dest, const uint32_t* cell, const uint8_t* coverage, int count)
+{
+    for (int x = 0; x < count; x++) {
+        if (coverage[x] == 255) {
+            dest[x] = cell[x];
+        } else if (coverage[x] != 0) {
+            uint32_t inv = cell[x] >> 24;
+            uint32_t dR = (((dest[x] >> 16) & 0xff) * inv) >> 8;
+            uint32_t dG = (((dest[x] >> 8) & 0xff) * inv) >> 8;
+            uint32_t dB = ((dest[x] & 0xff) * inv) >> 8;
+            dest[x] = (cell[x] & 0x00ffffff) + ((dR << 16) | (dG << 8) | dB) + (dest[x] & 0xff000000);
+        }
+    }
+}
+
+void plFont::blit_max_alpha_fpu(uint32_t* dest, const uint32_t* cell, const uint8_t* coverage, int count)
+{
+    for (int x = 0; x < count; x++) {
+        if ((cell[x] >> 24) > (dest[x] >> 24))
+            dest[x] = cell[x];
+    }
+}
+
+// CPU-optimized functions requiring dispatch
+hsCpuFunctionDispatcher<plFont::blit_row_ptr> plFont::blit_masked {
+    &plFont::blit_masked_fpu,
+    nullptr,            // SSE1
+    &plFont::blit_masked_sse2
+};
+
+hsCpuFunctionDispatcher<plFont::blit_row_ptr> plFont::blit_blend {
+    &plFont::blit_blend_fpu,
+    nullptr,            // SSE1
+    &plFont::blit_blend_sse2
+};
+
+hsCpuFunctionDispatcher<plFont::blit_row_ptr> plFont::blit_max_alpha {
+    &plFont::blit_max_alpha_fpu,
+    nullptr,            // SSE1
+    &plFont::blit_max_alpha_sse2
+};
+
 //// CalcString Variations ////////////////////////////////////////////////////
 
 uint16_t  plFont::CalcStringWidth( const ST::string &string )
@@ -1206,6 +1488,31 @@ void    plFont::CalcStringExtents( const ST::string &string, uint16_t &width, ui
 
 void    plFont::CalcStringExtents( const wchar_t *string, uint16_t &width, uint16_t &height, uint16_t &ascent, uint32_t &firstClippedChar, uint16_t &lastX, uint16_t &lastY )
 {
+    plExtentsKey key;
+    if( fRenderCaching )
+    {
+        key.fText = string;
+        key.fFlags = fRenderInfo.fFlags;
+        key.fClipX = fRenderInfo.fClipRect.fX;
+        key.fClipY = fRenderInfo.fClipRect.fY;
+        key.fClipWidth = fRenderInfo.fClipRect.fWidth;
+        key.fClipHeight = fRenderInfo.fClipRect.fHeight;
+        key.fFirstLineIndent = fRenderInfo.fFirstLineIndent;
+        key.fLineSpacing = fRenderInfo.fLineSpacing;
+
+        auto it = fExtentsCache.find( key );
+        if( it != fExtentsCache.end() )
+        {
+            width = it->second.fWidth;
+            height = it->second.fHeight;
+            ascent = it->second.fAscent;
+            lastX = it->second.fLastX;
+            lastY = it->second.fLastY;
+            firstClippedChar = it->second.fFirstClippedChar;
+            return;
+        }
+    }
+
     IRenderString(nullptr, 0, 0, string, true);
     width = fRenderInfo.fFarthestX;
     height = (uint16_t)(fRenderInfo.fY + fFontDescent);//fRenderInfo.fMaxDescent;
@@ -1216,6 +1523,13 @@ void    plFont::CalcStringExtents( const wchar_t *string, uint16_t &width, uint1
     // firstClippedChar is an index into the given string that points to the start of the part of the string
     // that got clipped (i.e. not rendered).
     firstClippedChar = fRenderInfo.fVolatileStringPtr - string;
+
+    if( fRenderCaching )
+    {
+        if( fExtentsCache.size() >= kMaxCachedExtents )
+            fExtentsCache.clear();
+        fExtentsCache[ std::move( key ) ] = { width, height, ascent, lastX, lastY, firstClippedChar };
+    }
 }
 
 //// IGetFreeCharData /////////////////////////////////////////////////////////
@@ -2128,6 +2442,8 @@ bool    plFont::LoadFromBDF( const plFileName &path, plBDFConvertCallback *callb
 
 bool    plFont::ReadRaw( hsStream *s )
 {
+    IFlushRenderCaches();
+
     char face_buf[257];
     s->Read(256, face_buf);
     face_buf[256] = 0;
@@ -64,8 +64,12 @@ You can contact Cyan Worlds, Inc. by email legal@cyan.com
 
 #include "HeadSpin.h"
 #include "hsColorRGBA.h"
+#include "hsCpuID.h"
 #include "pcSmallRect.h"
 
+#include <memory>
+#include <string>
+#include <unordered_map>
 #include <vector>
 
 #include "pnKeyedObject/hsKeyedObject.h"
@@ -183,6 +187,48 @@ class plFont : public hsKeyedObject
 
         typedef void (plFont::*CharRenderFunc)( const plCharacter &c );
 
+        // Glyphs pre-converted to final 32-bit pixels for one 8-bit render
+        // function and color, so drawing one is a straight row blit instead
+        // of per-pixel math. Cells are built the first time a glyph gets
+        // drawn this way, and padded by fPad on every side for the render
+        // functions that bleed past the glyph (shadows).
+        class plGlyphCache
+        {
+            public:
+                CharRenderFunc  fFunc;
+                uint32_t        fColor;
+                int16_t         fPad;
+                std::vector<std::vector<uint32_t>>  fCells;
+        };
+
+        // Most recently used first. Fonts are shared by every DTMap using
+        // the same face, so we keep a few colors around.
+        std::vector<std::unique_ptr<plGlyphCache>>  fGlyphCaches;
+
+        // What CalcStringExtents() came up with, keyed on everything that
+        // goes into it. GUI controls measure the same strings every frame.
+        struct plExtentsKey
+        {
+            std::wstring    fText;
+            uint32_t        fFlags;
+            int16_t         fClipX, fClipY, fClipWidth, fClipHeight;
+            int16_t         fFirstLineIndent, fLineSpacing;
+
+            bool operator==(const plExtentsKey &other) const;
+        };
+        struct plExtentsKeyHash
+        {
+            size_t operator()(const plExtentsKey &key) const;
+        };
+        struct plExtents
+        {
+            uint16_t    fWidth, fHeight, fAscent, fLastX, fLastY;
+            uint32_t    fFirstClippedChar;
+        };
+        std::unordered_map<plExtentsKey, plExtents, plExtentsKeyHash>  fExtentsCache;
+
+        static bool fRenderCaching;
+
         // Render info
         class plRenderInfo
         {
@@ -200,9 +246,13 @@ class plFont : public hsKeyedObject
                 pcSmallRect fClipRect;
                 float    fFloatWidth;
 
+                // Box around every glyph the last RenderString() touched
+                int16_t       fDrawnLeft, fDrawnTop, fDrawnRight, fDrawnBottom;
+
                 const wchar_t   *fVolatileStringPtr;    // Just so we know where we clipped
 
                 CharRenderFunc  fRenderFunc;
+                plGlyphCache    *fGlyphCache;   // Set when fRenderFunc is IRenderCharCached
         };
 
         plRenderInfo    fRenderInfo;
@@ -225,8 +275,25 @@ class plFont : public hsKeyedObject
         void    IRenderChar8To32AlphaPremultiplied( const plCharacter &c );
         void    IRenderChar8To32AlphaPremShadow( const plCharacter &c );
         void    IRenderCharNull( const plCharacter &c );
-
-        uint32_t IGetCharPixel( const plCharacter &c, int32_t x, int32_t y )
+        void    IRenderCharCached( const plCharacter &c );
+
+        plGlyphCache    *IGetGlyphCache( CharRenderFunc func, uint32_t color );
+        void    ICacheGlyph( const plCharacter &c, std::vector<uint32_t> &cell ) const;
+        void    IFlushRenderCaches();
+
+        //  CPU-optimized row blits for cached glyphs
+        typedef void(*blit_row_ptr)(uint32_t* dest, const uint32_t* cell, const uint8_t* coverage, int count);
+        static hsCpuFunctionDispatcher<blit_row_ptr> blit_masked;
+        static hsCpuFunctionDispatcher<blit_row_ptr> blit_blend;
+        static hsCpuFunctionDispatcher<blit_row_ptr> blit_max_alpha;
+        static void blit_masked_fpu(uint32_t* dest, const uint32_t* cell, const uint8_t* coverage, int count);
+        static void blit_masked_sse2(uint32_t* dest, const uint32_t* cell, const uint8_t* coverage, int count);
+        static void blit_blend_fpu(uint32_t* dest, const uint32_t* cell, const uint8_t* coverage, int count);
+        static void blit_blend_sse2(uint32_t* dest, const uint32_t* cell, const uint8_t* coverage, int count);
+        static void blit_max_alpha_fpu(uint32_t* dest, const uint32_t* cell, const uint8_t* coverage, int count);
+        static void blit_max_alpha_sse2(uint32_t* dest, const uint32_t* cell, const uint8_t* coverage, int count);
+
+        uint32_t IGetCharPixel( const plCharacter &c, int32_t x, int32_t y ) const
         {
             // only for 8-bit characters
             return (x < 0 || y < 0 || (uint32_t)x >= fWidth || (uint32_t)y >= c.fHeight) ? 0 : *(fBMapData + c.fBitmapOff + y*fWidth + x);
@@ -256,6 +323,11 @@ class plFont : public hsKeyedObject
         uint32_t      GetBitmapHeight() const { return fHeight; }
         uint8_t       GetBitmapBPP() const { return fBPP; }
 
+        // Glyph and extents caching, on by default. Results are identical
+        // either way, this is only here to measure what it buys us.
+        static void SetRenderCaching( bool on ) { fRenderCaching = on; }
+        static bool GetRenderCaching() { return fRenderCaching; }
+
         void    SetFace( const ST::string &face ) { fFace = face; }
         void    SetSize( uint8_t size ) { fSize = size; }
         void    SetFlags( uint32_t flags ) { fFlags = flags; }
@@ -278,6 +350,10 @@ class plFont : public hsKeyedObject
         void    RenderString(plMipmap *mip, uint16_t x, uint16_t y, const ST::string &string, uint16_t *lastX = nullptr, uint16_t *lastY = nullptr);
         void    RenderString(plMipmap *mip, uint16_t x, uint16_t y, const wchar_t *string, uint16_t *lastX = nullptr, uint16_t *lastY = nullptr);
 
+        // Conservative rect around the pixels the last RenderString() wrote,
+        // shadows included. Empty if nothing was drawn. Not clipped to the mip.
+        pcSmallRect GetLastRenderRect() const;
+
         uint16_t  CalcStringWidth( const ST::string &string );
         uint16_t  CalcStringWidth( const wchar_t *string );
         void    CalcStringExtents( const ST::string &string, uint16_t &width, uint16_t &height, uint16_t &ascent, uint16_t &lastX, uint16_t &lastY );
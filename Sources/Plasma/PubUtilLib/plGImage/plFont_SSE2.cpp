@@ -0,0 +1,135 @@
+/*==LICENSE==*
+
+CyanWorlds.com Engine - MMOG client, server and tools
+Copyright (C) 2011  Cyan Worlds, Inc.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+Additional permissions under GNU GPL version 3 section 7
+
+If you modify this Program, or any covered work, by linking or
+combining it with any of RAD Game Tools Bink SDK, Autodesk 3ds Max SDK,
+NVIDIA PhysX SDK, Microsoft DirectX SDK, OpenSSL library, Independent
+JPEG Group JPEG library, Microsoft Windows Media SDK, or Apple QuickTime SDK
+(or a modified version of those libraries),
+containing parts covered by the terms of the Bink SDK EULA, 3ds Max EULA,
+PhysX SDK EULA, DirectX SDK EULA, OpenSSL and SSLeay licenses, IJG
+JPEG Library README, Windows Media SDK EULA, or QuickTime SDK EULA, the
+licensors of this Program grant you additional
+permission to convey the resulting work. Corresponding Source for a
+non-source form of such a combination shall include the source code for
+the parts of OpenSSL and IJG JPEG Library used as well as that of the covered
+work.
+
+You can contact Cyan Worlds, Inc. by email legal@cyan.com
+ or by snail mail at:
+      Cyan Worlds, Inc.
+      14617 N Newport Hwy
+      Mead, WA   99021
+
+*==LICENSE==*/
+
+#include "HeadSpin.h"
+#include "plFont.h"
+
+#ifdef HAVE_SSE2
+#   include <emmintrin.h>
+#endif
+
+#ifdef HAVE_SSE2
+// Spreads four coverage bytes out to one per 32-bit lane
+static inline __m128i ILoadCoverage(const uint8_t* coverage)
+{
+    int32_t cov;
+    memcpy(&cov, coverage, sizeof(cov));
+    const __m128i zero = _mm_setzero_si128();
+    return _mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(cov), zero), zero);
+}
+
+static inline __m128i ISelect(__m128i mask, __m128i a, __m128i b)
+{
+    return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
+}
+#endif
+
+void plFont::blit_masked_sse2(uint32_t* dest, const uint32_t* cell, const uint8_t* coverage, int count)
+{
+#ifdef HAVE_SSE2
+    const __m128i zero = _mm_setzero_si128();
+
+    int x = 0;
+    for (; x + 4 <= count; x += 4)
+    {
+        __m128i skip = _mm_cmpeq_epi32(ILoadCoverage(coverage + x), zero);
+        __m128i d = _mm_loadu_si128((const __m128i*)(dest + x));
+        __m128i s = _mm_loadu_si128((const __m128i*)(cell + x));
+        _mm_storeu_si128((__m128i*)(dest + x), ISelect(skip, d, s));
+    }
+    blit_masked_fpu(dest + x, cell + x, coverage + x, count - x);
+#endif
+}
+
+void plFont::blit_blend_sse2(uint32_t* dest, const uint32_t* cell, const uint8_t* coverage, int count)
+{
+#ifdef HAVE_SSE2
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i full = _mm_set1_epi32(255);
+    const __m128i colorMask = _mm_set1_epi32(0x00ffffff);
+    const __m128i alphaMask = _mm_set1_epi32(0xff000000);
+
+    int x = 0;
+    for (; x + 4 <= count; x += 4)
+    {
+        __m128i cov = ILoadCoverage(coverage + x);
+        __m128i d = _mm_loadu_si128((const __m128i*)(dest + x));
+        __m128i s = _mm_loadu_si128((const __m128i*)(cell + x));
+
+        // Cells carry the inverse alpha in the top byte. Scale each dest
+        // channel by it, two pixels per register, 16 bits per channel.
+        __m128i dLo = _mm_unpacklo_epi8(d, zero);
+        __m128i dHi = _mm_unpackhi_epi8(d, zero);
+        __m128i invLo = _mm_unpacklo_epi8(s, zero);
+        __m128i invHi = _mm_unpackhi_epi8(s, zero);
+        invLo = _mm_shufflehi_epi16(_mm_shufflelo_epi16(invLo, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+        invHi = _mm_shufflehi_epi16(_mm_shufflelo_epi16(invHi, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+        dLo = _mm_srli_epi16(_mm_mullo_epi16(dLo, invLo), 8);
+        dHi = _mm_srli_epi16(_mm_mullo_epi16(dHi, invHi), 8);
+
+        // No channel can carry into the next, so a plain add does it
+        __m128i blended = _mm_add_epi32(_mm_and_si128(_mm_packus_epi16(dLo, dHi), colorMask),
+                                        _mm_and_si128(s, colorMask));
+        blended = _mm_or_si128(blended, _mm_and_si128(d, alphaMask));
+
+        __m128i out = ISelect(_mm_cmpeq_epi32(cov, full), s, blended);
+        out = ISelect(_mm_cmpeq_epi32(cov, zero), d, out);
+        _mm_storeu_si128((__m128i*)(dest + x), out);
+    }
+    blit_blend_fpu(dest + x, cell + x, coverage + x, count - x);
+#endif
+}
+
+void plFont::blit_max_alpha_sse2(uint32_t* dest, const uint32_t* cell, const uint8_t* coverage, int count)
+{
+#ifdef HAVE_SSE2
+    int x = 0;
+    for (; x + 4 <= count; x += 4)
+    {
+        __m128i d = _mm_loadu_si128((const __m128i*)(dest + x));
+        __m128i s = _mm_loadu_si128((const __m128i*)(cell + x));
+        __m128i higher = _mm_cmpgt_epi32(_mm_srli_epi32(s, 24), _mm_srli_epi32(d, 24));
+        _mm_storeu_si128((__m128i*)(dest + x), ISelect(higher, s, d));
+    }
+    blit_max_alpha_fpu(dest + x, cell + x, coverage, count - x);
+#endif
+}
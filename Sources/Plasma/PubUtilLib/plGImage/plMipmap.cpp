@@ -59,11 +59,13 @@ You can contact Cyan Worlds, Inc. by email legal@cyan.com
 #include "hsColorRGBA.h"
 #include "hsCodecManager.h"
 #include "hsGDeviceRef.h"
+#include "hsParallel.h"
 #include "plProfile.h"
 #include "plJPEG.h"
 #include "plPNG.h"
 #include <cmath>
 #include <algorithm>
+#include <vector>
 #include <string_theory/format>
 
 plProfile_CreateMemCounter("Mipmaps", "Memory", MemMipmaps);
@@ -850,7 +852,24 @@ namespace {
     // Color masks (out of 0-2)
     const uint8_t fColorMasks[ 10 ][ 3 ] = { { 2, 0, 0 }, { 0, 2, 2 }, { 2, 0, 2 }, { 0, 2, 0 },          
                 { 0, 0, 2 }, { 2, 2, 0 }, { 2, 2, 2 }, { 2, 0, 1 }, { 0, 2, 1 }, { 1, 0, 2 } };
-                                            
+
+    // Below this many output pixels per thread, a pass isn't worth splitting up
+    const uint32_t kMinPixelsPerThread = 16384;
+}
+
+//// IForEachRowBand //////////////////////////////////////////////////////////
+//  Runs func(firstRow, numRows) over bands of output rows, spread across the
+//  worker threads when there are enough pixels to make it worthwhile. Each
+//  row is written by exactly one band, so the result doesn't depend on the
+//  split.
+
+template<typename Func>
+static void IForEachRowBand(uint32_t numRows, uint32_t rowPixels, Func func)
+{
+    size_t numThreads = hsParallelThreads(size_t(numRows) * rowPixels, kMinPixelsPerThread);
+    hsParallelFor(numRows, numThreads, [&func](size_t firstRow, size_t count) {
+        func(uint32_t(firstRow), uint32_t(count));
+    });
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -883,6 +902,16 @@ class plFilterMask
         int     End() const { return fExt; }
 
         float    Mask( int i, int j ) const { return fMask[ i ][ j ]; }
+
+        // The whole mask as one row-major block, for the filter_row kernels
+        std::vector<float> GetTaps() const
+        {
+            std::vector<float> taps;
+            taps.reserve( ( ( fExt << 1 ) + 1 ) * ( ( fExt << 1 ) + 1 ) );
+            for( int i = -fExt; i <= fExt; i++ )
+                taps.insert( taps.end(), fMask[ i ] - fExt, fMask[ i ] + fExt + 1 );
+            return taps;
+        }
 };
 
 plFilterMask::plFilterMask( float sig )
@@ -1088,49 +1117,27 @@ void    plMipmap::ICreateLevelNoDetail( uint8_t iDst, const plFilterMask& mask )
     hsAssert(fPixelSize == 32, "Only 32 bit implemented");
     ASSERT_UNCOMPRESSED();
 
-    int32_t i, j, ii, jj;
-
     if( 32 == fPixelSize )
     {
         SetCurrLevel(iDst);
 
-        uint8_t *src = (uint8_t *)GetLevelPtr( iDst-1 );
+        const uint8_t *src = (uint8_t *)GetLevelPtr( iDst-1 );
         uint8_t *dst = (uint8_t *)GetLevelPtr(iDst);
 
-        int32_t srcRowBytes = fCurrLevelRowBytes << 1;
-        int32_t srcHeight = fCurrLevelHeight << 1;
-        int32_t srcWidth = fCurrLevelWidth << 1;
-
-        for( i = 0; i < fCurrLevelHeight; i++ )
-        {
-            for( j = 0; j < fCurrLevelWidth; j++ )
-            {
-                uint8_t *center = src + (i << 1) * srcRowBytes + (j << 3);
-
-                int32_t chan;
-                for( chan = 0; chan < 4; chan++ )
-                {
-                    float w = 0;
-                    float a = 0;
+        uint32_t srcRowBytes = fCurrLevelRowBytes << 1;
+        uint32_t srcHeight = fCurrLevelHeight << 1;
+        uint32_t srcWidth = fCurrLevelWidth << 1;
+        uint32_t dstRowBytes = fCurrLevelRowBytes;
+        uint32_t dstWidth = fCurrLevelWidth;
 
-                    for( ii = mask.Begin(); ii <= mask.End(); ii++ )
-                    {
-                        for( jj = mask.Begin(); jj <= mask.End(); jj++ )
-                        {
-                            if( (ii + (i << 1) >= 0)&&(ii + (i << 1) < srcHeight)
-                              &&(jj + (j << 1) >= 0)&&(jj + (j << 1) < srcWidth) )
-                            {
-                                w += mask.Mask(ii, jj);
-                                a += (float(center[ii*srcRowBytes + (jj<<2) + chan]) + 0.5f) * mask.Mask(ii, jj);
-                            }
-                        }
-                    }
-                    a /= w;
+        std::vector<float> taps = mask.GetTaps();
+        int32_t ext = mask.End();
 
-                    dst[i * fCurrLevelRowBytes + (j << 2) + chan] = (uint8_t)a;
-                }
-            }
-        }
+        IForEachRowBand( fCurrLevelHeight, dstWidth, [&]( uint32_t firstRow, uint32_t numRows ) {
+            for( uint32_t i = firstRow; i < firstRow + numRows; i++ )
+                filter_row.call( dst + i * dstRowBytes, dstWidth, src, srcRowBytes,
+                                 srcWidth, srcHeight, i << 1, 2, taps.data(), ext );
+        } );
     }
 }
 
@@ -1445,8 +1452,6 @@ void plMipmap::Filter(float sig)
     hsAssert(fPixelSize == 32, "Only 32 bit implemented");
     ASSERT_UNCOMPRESSED();
 
-    int i, j, ii, jj;
-
     if( 32 == fPixelSize )
     {
         uint8_t *dst = (uint8_t *)(fImage);
@@ -1458,41 +1463,14 @@ void plMipmap::Filter(float sig)
             sig = kDefaultSigma;
 
         plFilterMask mask(sig);
+        std::vector<float> taps = mask.GetTaps();
+        int32_t ext = mask.End();
 
-        int32_t srcRowBytes = fRowBytes;
-        int32_t srcHeight = fHeight;
-        int32_t srcWidth = fWidth;
-
-        for( i = 0; i < fHeight; i++ )
-        {
-            for( j = 0; j < fWidth; j++ )
-            {
-                uint8_t *center = &src[i * srcRowBytes + (j << 2)];
-
-                int32_t chan;
-                for( chan = 0; chan < 4; chan++ )
-                {
-                    float w = 0;
-                    float a = 0;
-
-                    for( ii = mask.Begin(); ii <= mask.End(); ii++ )
-                    {
-                        for( jj = mask.Begin(); jj <= mask.End(); jj++ )
-                        {
-                            if( (ii + i >= 0)&&(ii + i < srcHeight)
-                              &&(jj + j >= 0)&&(jj + j < srcWidth) )
-                            {
-                                w += mask.Mask(ii, jj);
-                                a += (float(center[ii*srcRowBytes + (jj<<2) + chan]) + 0.5f) * mask.Mask(ii, jj);
-                            }
-                        }
-                    }
-                    a /= w;
-
-                    dst[i * fRowBytes + (j << 2) + chan] = (uint8_t)(a);
-                }
-            }
-        }
+        IForEachRowBand( fHeight, fWidth, [&]( uint32_t firstRow, uint32_t numRows ) {
+            for( uint32_t i = firstRow; i < firstRow + numRows; i++ )
+                filter_row.call( dst + i * fRowBytes, fWidth, src.data(), fRowBytes,
+                                 fWidth, fHeight, i, 1, taps.data(), ext );
+        } );
     }
 }
 
@@ -1644,8 +1622,8 @@ void    plMipmap::Composite( plMipmap *source, uint16_t x, uint16_t y, plMipmap:
     uint8_t   level, numLevels, srcNumLevels, srcLevelOffset, levelsToSkip;
     uint16_t  pX, pY;
     uint32_t  *srcLevelPtr, *dstLevelPtr, *srcPtr, *dstPtr;
-    uint32_t  srcRowBytes, dstRowBytes, srcRowBytesToCopy, r, g, b, dR, dG, dB, srcWidth, srcHeight;
-    uint32_t  srcAlpha, oneMinusAlpha, destAlpha;
+    uint32_t  srcRowBytes, dstRowBytes, srcRowBytesToCopy, srcWidth, srcHeight;
+    uint32_t  srcAlpha;
     uint16_t  srcClipX, srcClipY;
 
 
@@ -1771,14 +1749,7 @@ void    plMipmap::Composite( plMipmap *source, uint16_t x, uint16_t y, plMipmap:
                 if( options->fFlags & kDestPremultiplied )
                 {
                     // multiply color values by alpha
-                    for( pX = 0; pX < srcWidth; pX++ )
-                    {
-                        srcAlpha = ((dstPtr[ pX ] >> 24) & 0x000000ff);
-                        dstPtr[ pX ] = ( srcAlpha << 24 )
-                            | (((((dstPtr[ pX ] >> 16) & 0xff)*srcAlpha + 127)/255) << 16)
-                            | (((((dstPtr[ pX ] >>  8) & 0xff)*srcAlpha + 127)/255) <<  8)
-                            | (((((dstPtr[ pX ]      ) & 0xff)*srcAlpha + 127)/255)      );
-                    }
+                    premultiply_row.call( dstPtr, srcWidth );
                 }
                 dstPtr += dstRowBytes >> 2;
                 srcPtr += srcRowBytes >> 2;
@@ -1848,49 +1819,7 @@ void    plMipmap::Composite( plMipmap *source, uint16_t x, uint16_t y, plMipmap:
 
             for( pY = (uint16_t)srcHeight; pY > 0; pY-- )         
             {
-                // Reverse the loop so we can count downwards--slightly faster
-                pX = (uint16_t)srcWidth;
-                do
-                {
-                    pX--;
-
-                    // Wacko trick here. Alphas are 0-255, which means scaling by alpha would
-                    // be a v' = v * alpha / 255 operation sequence. However, since we hate
-                    // dividing by 255 all the time, we actually scale the alpha just ever so
-                    // slightly so it's 0-256, which makes the divide a simple shift. Note
-                    // that this will result in some tiny bit of aliasing, but it shouldn't be
-                    // enough to notice
-                    
-                    if (!(srcPtr[pX] >> 24)) // Zero alpha. Skip this pixel
-                        continue;
-
-                    srcAlpha = options->fOpacity * ( ( srcPtr[ pX ] >> 16 ) & 0x0000ff00 ) / 255 / 256;
-                    oneMinusAlpha = 256 - srcAlpha;
-                    destAlpha = dstPtr[ pX ] & 0xff000000;
-
-                    r = (uint32_t)((( srcPtr[ pX ] >> 16 ) & 0x000000ff) * options->fRedTint);
-                    g = (uint32_t)((( srcPtr[ pX ] >> 8  ) & 0x000000ff) * options->fGreenTint);
-                    b = (uint32_t)((( srcPtr[ pX ]       ) & 0x000000ff) * options->fBlueTint);
-                    dR = ( dstPtr[ pX ] >> 16 ) & 0x000000ff;
-                    dG = ( dstPtr[ pX ] >> 8  ) & 0x000000ff;
-                    dB = ( dstPtr[ pX ]       ) & 0x000000ff;
-                    r = ( r * srcAlpha ) >> 8;
-                    g = ( g * srcAlpha ) >> 8;
-                    b = ( b * srcAlpha ) >> 8;
-                    dR = ( dR * oneMinusAlpha ) >> 8;
-                    dG = ( dG * oneMinusAlpha ) >> 8;
-                    dB = ( dB * oneMinusAlpha ) >> 8;
-
-                    // Dest alpha for now is just our original dest alpha
-                    dstPtr[ pX ] = ( ( r + dR ) << 16 ) | ( ( g + dG ) << 8 ) | ( b + dB ) | destAlpha;
-
-                    if( !( options->fFlags & kBlendWriteAlpha ) )
-                        continue;
-
-                    // Unless our blend option is set of course
-                    dstPtr[ pX ] = ( dstPtr[ pX ] & 0x00ffffff ) | ( srcAlpha << 24 );
-
-                } while( pX > 0 );
+                blend_row.call( dstPtr, srcPtr, srcWidth, *options );
 
                 dstPtr += dstRowBytes >> 2;
                 srcPtr += srcRowBytes >> 2;
@@ -2019,13 +1948,9 @@ void    plMipmap::IColorLevel( uint8_t level, const uint8_t *colorMask )
 void    plMipmap::ScaleNicely( uint32_t *destPtr, uint16_t destWidth, uint16_t destHeight,
                                 uint16_t destStride, plMipmap::ScaleFilter filter ) const
 {
-    uint16_t      destX, destY, srcX, srcY;
-    int16_t       srcStartX, srcEndX, srcStartY, srcEndY;
-    float       srcPosX, srcPosY, destToSrcXScale, destToSrcYScale, filterWidth, filterHeight, weight;
-    float       totalWeight;
-    hsColorRGBA color, accumColor;
-    float       whyWaits[ 16 ], whyWait, xWeights[ 16 ];
-    uint32_t      *srcPtr;
+    uint16_t      destX, srcX;
+    int16_t       srcStartX, srcEndX;
+    float       srcPosX, destToSrcXScale, destToSrcYScale, filterWidth, filterHeight;
 
 
     // Init
@@ -2046,81 +1971,67 @@ void    plMipmap::ScaleNicely( uint32_t *destPtr, uint16_t destWidth, uint16_t d
     if( filterHeight < 1.f )
         filterHeight = 1.f;
 
-    // Process
-    for( destY = 0; destY < destHeight; destY++ )
+    // The x spans and weights are the same for every row, so work them all out up front
+    std::vector<ScaleSpan> xSpans( destWidth );
+    size_t numXWeights = 0;
+    for( destX = 0; destX < destWidth; destX++ )
     {
-        // Calculate the span across this row
-        srcPosY = destY * destToSrcYScale;
+        // For this pixel in the destination, figure out where in the source image we virtually are
+        srcPosX = destX * destToSrcXScale;
+
+        // Range of pixels that the filter covers
+        srcStartX = (int16_t)( srcPosX - filterWidth );
+        if( srcStartX < 0 ) 
+            srcStartX = 0;
+        
+        srcEndX = (int16_t)( srcPosX + filterWidth );
+        if( srcEndX >= fWidth ) 
+            srcEndX = (int16_t)(fWidth - 1);
 
-        srcStartY = (int16_t)( srcPosY - filterHeight );
-        if( srcStartY < 0 ) 
-            srcStartY = 0;
+        xSpans[ destX ].fStart = srcStartX;
+        xSpans[ destX ].fEnd = srcEndX;
+        numXWeights += srcEndX - srcStartX + 1;
+    }
 
-        srcEndY = (int16_t)( srcPosY + filterHeight );
-        if( srcEndY >= fHeight ) 
-            srcEndY = (int16_t)(fHeight - 1);
+    std::vector<float> xWeights( numXWeights );
+    float *xWeight = xWeights.data();
+    for( destX = 0; destX < destWidth; destX++ )
+    {
+        srcPosX = destX * destToSrcXScale;
 
-        // Precalc the y weights
-        for( srcY = srcStartY; srcY <= srcEndY && ( srcY - srcStartY ) < 16; srcY++ )
-            whyWaits[ srcY - srcStartY ] = 1.f - ( fabs( (float)srcY - srcPosY ) / filterHeight );
+        xSpans[ destX ].fWeights = xWeight;
+        for( srcX = xSpans[ destX ].fStart; srcX <= xSpans[ destX ].fEnd; srcX++ )
+            *xWeight++ = 1.f - ( fabs( (float)srcX - srcPosX ) / filterWidth );
+    }
 
-        for( destX = 0; destX < destWidth; destX++ )
+    // Process, a band of rows at a time
+    const uint32_t *srcPtr = (const uint32_t *)fCurrLevelPtr;
+    uint32_t srcStride = fCurrLevelRowBytes >> 2;
+
+    IForEachRowBand( destHeight, destWidth, [&]( uint32_t firstRow, uint32_t numRows ) {
+        std::vector<float> whyWaits;
+        for( uint32_t destY = firstRow; destY < firstRow + numRows; destY++ )
         {
-            // For this pixel in the destination, figure out where in the source image we virtually are
-            srcPosX = destX * destToSrcXScale;
-
-            // Range of pixels that the filter covers
-            srcStartX = (int16_t)( srcPosX - filterWidth );
-            if( srcStartX < 0 ) 
-                srcStartX = 0;
-            
-            srcEndX = (int16_t)( srcPosX + filterWidth );
-            if( srcEndX >= fWidth ) 
-                srcEndX = (int16_t)(fWidth - 1);
-
-            // Precalc the x weights
-            for( srcX = srcStartX; srcX <= srcEndX && ( srcX - srcStartX ) < 16; srcX++ )
-                xWeights[ srcX - srcStartX ] = 1.f - ( fabs( (float)srcX - srcPosX ) / filterWidth );
-
-            // Sum up all the weighted colors in the filter area
-            accumColor.Set( 0.f, 0.f, 0.f, 0.f );
-            totalWeight = 0.f;
-            for( srcY = srcStartY; srcY <= srcEndY; srcY++ )
-            {
-                if( srcY - srcStartY < 16 )
-                    whyWait = whyWaits[ srcY - srcStartY ];
-                else
-                    whyWait = 1.f - ( fabs( (float)srcY - srcPosY ) / filterHeight );
+            // Calculate the span across this row
+            float srcPosY = destY * destToSrcYScale;
 
-                if( whyWait <= 0.f )
-                    continue;
+            int16_t srcStartY = (int16_t)( srcPosY - filterHeight );
+            if( srcStartY < 0 ) 
+                srcStartY = 0;
 
-                srcPtr = GetAddr32( srcStartX, srcY );
-                for( srcX = srcStartX; srcX <= srcEndX; srcX++, srcPtr++ )
-                {
-                    // Our weight...
-                    weight = ( srcX - srcStartX < 16 ) ? xWeights[ srcX - srcStartX ] : 
-                                ( 1.f - ( fabs( (float)srcX - srcPosX ) / filterWidth ) );
-                    weight *= whyWait;
+            int16_t srcEndY = (int16_t)( srcPosY + filterHeight );
+            if( srcEndY >= fHeight ) 
+                srcEndY = (int16_t)(fHeight - 1);
 
-                    if( weight > 0.f )
-                    {
-                        // Grab pixel values from us...
-                        color.FromARGB32( *srcPtr );
-                        color *= weight;
-                        accumColor += color;
-                        totalWeight += weight;
-                    }
-                }
-            }
-            accumColor *= 1.f / totalWeight;
+            // Precalc the y weights
+            whyWaits.resize( srcEndY - srcStartY + 1 );
+            for( uint16_t srcY = srcStartY; srcY <= srcEndY; srcY++ )
+                whyWaits[ srcY - srcStartY ] = 1.f - ( fabs( (float)srcY - srcPosY ) / filterHeight );
 
-            // Set the final value
-            *destPtr = accumColor.ToARGB32();
-            destPtr++;
+            ScaleSpan ySpan = { srcStartY, srcEndY, whyWaits.data() };
+            scale_row.call( destPtr + destY * destStride, xSpans.data(), destWidth, ySpan, srcPtr, srcStride );
         }
-        destPtr += destStride - destWidth;
-    }
+    } );
 }
 
 //// ResizeNicely /////////////////////////////////////////////////////////////
@@ -2157,6 +2068,172 @@ bool    plMipmap::ResizeNicely( uint16_t newWidth, uint16_t newHeight, plMipmap:
     return true;
 }
 
+///////////////////////////////////////////////////////////////////////////////
+//// Pixel Kernels ////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+//  The plain versions of the per-row loops behind Filter(), mip generation,
+//  ScaleNicely() and Composite(). The SSE2 versions in plMipmap_SSE2.cpp do
+//  the same float ops in the same order, so both produce the same pixels.
+
+//// filter_row ///////////////////////////////////////////////////////////////
+//  Clamping the tap range up front skips exactly the taps the old per-tap
+//  bounds test did, and the sums still run in the same order.
+
+void plMipmap::filter_row_fpu(uint8_t* dst, uint32_t dstWidth, const uint8_t* src, uint32_t srcRowBytes,
+                              uint32_t srcWidth, uint32_t srcHeight, uint32_t srcY, uint32_t step,
+                              const float* taps, int32_t ext)
+{
+    int32_t tapStride = (ext << 1) + 1;
+    int32_t iiBegin = std::max(-ext, -int32_t(srcY));
+    int32_t iiEnd = std::min(ext, int32_t(srcHeight) - 1 - int32_t(srcY));
+
+    for (uint32_t j = 0; j < dstWidth; j++)
+    {
+        int32_t srcX = int32_t(j * step);
+        int32_t jjBegin = std::max(-ext, -srcX);
+        int32_t jjEnd = std::min(ext, int32_t(srcWidth) - 1 - srcX);
+        const uint8_t* center = src + srcY * srcRowBytes + (srcX << 2);
+
+        float w = 0;
+        float a[4] = { 0, 0, 0, 0 };
+        for (int32_t ii = iiBegin; ii <= iiEnd; ii++)
+        {
+            const float* mask = taps + (ii + ext) * tapStride + ext;
+            const uint8_t* row = center + ii * int32_t(srcRowBytes);
+            for (int32_t jj = jjBegin; jj <= jjEnd; jj++)
+            {
+                w += mask[jj];
+                for (int chan = 0; chan < 4; chan++)
+                    a[chan] += (float(row[(jj << 2) + chan]) + 0.5f) * mask[jj];
+            }
+        }
+
+        for (int chan = 0; chan < 4; chan++)
+            dst[(j << 2) + chan] = (uint8_t)(a[chan] / w);
+    }
+}
+
+//// scale_row ////////////////////////////////////////////////////////////////
+
+void plMipmap::scale_row_fpu(uint32_t* dst, const ScaleSpan* xSpans, uint32_t dstWidth,
+                             const ScaleSpan& ySpan, const uint32_t* src, uint32_t srcStride)
+{
+    hsColorRGBA color, accumColor;
+
+    for (uint32_t destX = 0; destX < dstWidth; destX++)
+    {
+        const ScaleSpan& xSpan = xSpans[destX];
+
+        // Sum up all the weighted colors in the filter area
+        accumColor.Set(0.f, 0.f, 0.f, 0.f);
+        float totalWeight = 0.f;
+        for (int32_t srcY = ySpan.fStart; srcY <= ySpan.fEnd; srcY++)
+        {
+            float whyWait = ySpan.fWeights[srcY - ySpan.fStart];
+            if (whyWait <= 0.f)
+                continue;
+
+            const uint32_t* srcPtr = src + srcY * srcStride + xSpan.fStart;
+            for (int32_t srcX = xSpan.fStart; srcX <= xSpan.fEnd; srcX++, srcPtr++)
+            {
+                float weight = xSpan.fWeights[srcX - xSpan.fStart] * whyWait;
+                if (weight > 0.f)
+                {
+                    color.FromARGB32(*srcPtr);
+                    color *= weight;
+                    accumColor += color;
+                    totalWeight += weight;
+                }
+            }
+        }
+        accumColor *= 1.f / totalWeight;
+
+        // Set the final value
+        *dst++ = accumColor.ToARGB32();
+    }
+}
+
+//// blend_row ////////////////////////////////////////////////////////////////
+
+void plMipmap::blend_row_fpu(uint32_t* dst, const uint32_t* src, uint32_t count, const CompositeOptions& options)
+{
+    for (uint32_t pX = 0; pX < count; pX++)
+    {
+        // Wacko trick here. Alphas are 0-255, which means scaling by alpha would
+        // be a v' = v * alpha / 255 operation sequence. However, since we hate
+        // dividing by 255 all the time, we actually scale the alpha just ever so
+        // slightly so it's 0-256, which makes the divide a simple shift. Note
+        // that this will result in some tiny bit of aliasing, but it shouldn't be
+        // enough to notice
+
+        if (!(src[pX] >> 24)) // Zero alpha. Skip this pixel
+            continue;
+
+        uint32_t srcAlpha = options.fOpacity * ((src[pX] >> 16) & 0x0000ff00) / 255 / 256;
+        uint32_t oneMinusAlpha = 256 - srcAlpha;
+        uint32_t destAlpha = dst[pX] & 0xff000000;
+
+        uint32_t r = (uint32_t)(((src[pX] >> 16) & 0x000000ff) * options.fRedTint);
+        uint32_t g = (uint32_t)(((src[pX] >> 8 ) & 0x000000ff) * options.fGreenTint);
+        uint32_t b = (uint32_t)(((src[pX]      ) & 0x000000ff) * options.fBlueTint);
+        uint32_t dR = (dst[pX] >> 16) & 0x000000ff;
+        uint32_t dG = (dst[pX] >> 8 ) & 0x000000ff;
+        uint32_t dB = (dst[pX]      ) & 0x000000ff;
+        r = (r * srcAlpha) >> 8;
+        g = (g * srcAlpha) >> 8;
+        b = (b * srcAlpha) >> 8;
+        dR = (dR * oneMinusAlpha) >> 8;
+        dG = (dG * oneMinusAlpha) >> 8;
+        dB = (dB * oneMinusAlpha) >> 8;
+
+        // Dest alpha for now is just our original dest alpha
+        dst[pX] = ((r + dR) << 16) | ((g + dG) << 8) | (b + dB) | destAlpha;
+
+        // Unless our blend option is set of course
+        if (options.fFlags & kBlendWriteAlpha)
+            dst[pX] = (dst[pX] & 0x00ffffff) | (srcAlpha << 24);
+    }
+}
+
+//// premultiply_row //////////////////////////////////////////////////////////
+
+void plMipmap::premultiply_row_fpu(uint32_t* pixels, uint32_t count)
+{
+    for (uint32_t pX = 0; pX < count; pX++)
+    {
+        uint32_t alpha = (pixels[pX] >> 24) & 0x000000ff;
+        pixels[pX] = (alpha << 24)
+            | (((((pixels[pX] >> 16) & 0xff) * alpha + 127) / 255) << 16)
+            | (((((pixels[pX] >>  8) & 0xff) * alpha + 127) / 255) <<  8)
+            | (((((pixels[pX]      ) & 0xff) * alpha + 127) / 255)      );
+    }
+}
+
+// CPU-optimized functions requiring dispatch
+hsCpuFunctionDispatcher<plMipmap::filter_row_ptr> plMipmap::filter_row {
+    &plMipmap::filter_row_fpu,
+    nullptr,            // SSE1
+    &plMipmap::filter_row_sse2
+};
+
+hsCpuFunctionDispatcher<plMipmap::scale_row_ptr> plMipmap::scale_row {
+    &plMipmap::scale_row_fpu,
+    nullptr,            // SSE1
+    &plMipmap::scale_row_sse2
+};
+
+hsCpuFunctionDispatcher<plMipmap::blend_row_ptr> plMipmap::blend_row {
+    &plMipmap::blend_row_fpu,
+    nullptr,            // SSE1
+    &plMipmap::blend_row_sse2
+};
+
+hsCpuFunctionDispatcher<plMipmap::premultiply_row_ptr> plMipmap::premultiply_row {
+    &plMipmap::premultiply_row_fpu,
+    nullptr,            // SSE1
+    &plMipmap::premultiply_row_sse2
+};
+
 #ifdef MEMORY_LEAK_TRACER
 //// Debug Mipmap Memory Leak Tracker /////////////////////////////////////////
 
@@ -55,6 +55,7 @@ You can contact Cyan Worlds, Inc. by email legal@cyan.com
 #define _plMipmap_h
 
 #include "plBitmap.h"
+#include "hsCpuID.h"
 
 #ifdef HS_DEBUGGING
     #define ASSERT_PIXELSIZE(bitmap, pixelsize)     hsAssert((bitmap)->fPixelSize == (pixelsize), "pixelSize mismatch")
@@ -332,6 +333,50 @@ class plMipmap : public plBitmap
 
         friend class plCubicEnvironmap;
 
+    public:
+        //// CPU-optimized pixel kernels ////
+        // The SSE2 versions give the same bits as the FPU ones; see plMipmap_SSE2.cpp
+
+        // Gaussian filters one destination row. Pixel j of the row is centered on
+        // source pixel (j * step, srcY); taps is the (2 * ext + 1)^2 mask, row major.
+        typedef void(*filter_row_ptr)(uint8_t* dst, uint32_t dstWidth, const uint8_t* src, uint32_t srcRowBytes,
+                                      uint32_t srcWidth, uint32_t srcHeight, uint32_t srcY, uint32_t step,
+                                      const float* taps, int32_t ext);
+        static hsCpuFunctionDispatcher<filter_row_ptr> filter_row;
+        static void filter_row_fpu(uint8_t* dst, uint32_t dstWidth, const uint8_t* src, uint32_t srcRowBytes,
+                                   uint32_t srcWidth, uint32_t srcHeight, uint32_t srcY, uint32_t step,
+                                   const float* taps, int32_t ext);
+        static void filter_row_sse2(uint8_t* dst, uint32_t dstWidth, const uint8_t* src, uint32_t srcRowBytes,
+                                    uint32_t srcWidth, uint32_t srcHeight, uint32_t srcY, uint32_t step,
+                                    const float* taps, int32_t ext);
+
+        // Source pixels [fStart, fEnd] and their weights for one output pixel of ScaleNicely()
+        struct ScaleSpan
+        {
+            int32_t         fStart, fEnd;
+            const float*    fWeights;
+        };
+
+        typedef void(*scale_row_ptr)(uint32_t* dst, const ScaleSpan* xSpans, uint32_t dstWidth,
+                                     const ScaleSpan& ySpan, const uint32_t* src, uint32_t srcStride);
+        static hsCpuFunctionDispatcher<scale_row_ptr> scale_row;
+        static void scale_row_fpu(uint32_t* dst, const ScaleSpan* xSpans, uint32_t dstWidth,
+                                  const ScaleSpan& ySpan, const uint32_t* src, uint32_t srcStride);
+        static void scale_row_sse2(uint32_t* dst, const ScaleSpan* xSpans, uint32_t dstWidth,
+                                   const ScaleSpan& ySpan, const uint32_t* src, uint32_t srcStride);
+
+        // Composite()'s default alpha blend (and kBlendWriteAlpha) over one row
+        typedef void(*blend_row_ptr)(uint32_t* dst, const uint32_t* src, uint32_t count, const CompositeOptions& options);
+        static hsCpuFunctionDispatcher<blend_row_ptr> blend_row;
+        static void blend_row_fpu(uint32_t* dst, const uint32_t* src, uint32_t count, const CompositeOptions& options);
+        static void blend_row_sse2(uint32_t* dst, const uint32_t* src, uint32_t count, const CompositeOptions& options);
+
+        // Multiplies color by alpha in place, rounding to nearest
+        typedef void(*premultiply_row_ptr)(uint32_t* pixels, uint32_t count);
+        static hsCpuFunctionDispatcher<premultiply_row_ptr> premultiply_row;
+        static void premultiply_row_fpu(uint32_t* pixels, uint32_t count);
+        static void premultiply_row_sse2(uint32_t* pixels, uint32_t count);
+
 #ifdef MEMORY_LEAK_TRACER
 
     protected:
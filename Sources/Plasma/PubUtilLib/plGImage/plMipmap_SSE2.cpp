@@ -0,0 +1,252 @@
+/*==LICENSE==*
+
+CyanWorlds.com Engine - MMOG client, server and tools
+Copyright (C) 2011  Cyan Worlds, Inc.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+Additional permissions under GNU GPL version 3 section 7
+
+If you modify this Program, or any covered work, by linking or
+combining it with any of RAD Game Tools Bink SDK, Autodesk 3ds Max SDK,
+NVIDIA PhysX SDK, Microsoft DirectX SDK, OpenSSL library, Independent
+JPEG Group JPEG library, Microsoft Windows Media SDK, or Apple QuickTime SDK
+(or a modified version of those libraries),
+containing parts covered by the terms of the Bink SDK EULA, 3ds Max EULA,
+PhysX SDK EULA, DirectX SDK EULA, OpenSSL and SSLeay licenses, IJG
+JPEG Library README, Windows Media SDK EULA, or QuickTime SDK EULA, the
+licensors of this Program grant you additional
+permission to convey the resulting work. Corresponding Source for a
+non-source form of such a combination shall include the source code for
+the parts of OpenSSL and IJG JPEG Library used as well as that of the covered
+work.
+
+You can contact Cyan Worlds, Inc. by email legal@cyan.com
+ or by snail mail at:
+      Cyan Worlds, Inc.
+      14617 N Newport Hwy
+      Mead, WA   99021
+
+*==LICENSE==*/
+
+#include "HeadSpin.h"
+#include "plMipmap.h"
+
+#include <algorithm>
+
+#ifdef HAVE_SSE2
+#   include <emmintrin.h>
+#endif
+
+#ifdef HAVE_SSE2
+// One 32-bit pixel, a float per channel, in memory order
+static inline __m128 ILoadPixel(const void* pixel)
+{
+    int32_t value;
+    memcpy(&value, pixel, sizeof(value));
+    const __m128i zero = _mm_setzero_si128();
+    __m128i wide = _mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(value), zero), zero);
+    return _mm_cvtepi32_ps(wide);
+}
+
+// Truncates four channels back down to bytes and writes one pixel
+static inline void IStorePixel(void* pixel, __m128 channels)
+{
+    __m128i packed = _mm_cvttps_epi32(channels);
+    packed = _mm_packs_epi32(packed, packed);
+    packed = _mm_packus_epi16(packed, packed);
+    int32_t value = _mm_cvtsi128_si32(packed);
+    memcpy(pixel, &value, sizeof(value));
+}
+
+static inline __m128i ISelect(__m128i mask, __m128i a, __m128i b)
+{
+    return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
+}
+
+// x / 255 for 0 <= x <= 65535, in the low half of each 32-bit lane
+static inline __m128i IDiv255Epi32(__m128i x)
+{
+    return _mm_srli_epi32(_mm_mulhi_epu16(x, _mm_set1_epi32(0x8081)), 7);
+}
+#endif
+
+void plMipmap::filter_row_sse2(uint8_t* dst, uint32_t dstWidth, const uint8_t* src, uint32_t srcRowBytes,
+                               uint32_t srcWidth, uint32_t srcHeight, uint32_t srcY, uint32_t step,
+                               const float* taps, int32_t ext)
+{
+#ifdef HAVE_SSE2
+    const __m128 half = _mm_set1_ps(0.5f);
+
+    int32_t tapStride = (ext << 1) + 1;
+    int32_t iiBegin = std::max(-ext, -int32_t(srcY));
+    int32_t iiEnd = std::min(ext, int32_t(srcHeight) - 1 - int32_t(srcY));
+
+    for (uint32_t j = 0; j < dstWidth; j++)
+    {
+        int32_t srcX = int32_t(j * step);
+        int32_t jjBegin = std::max(-ext, -srcX);
+        int32_t jjEnd = std::min(ext, int32_t(srcWidth) - 1 - srcX);
+        const uint8_t* center = src + srcY * srcRowBytes + (srcX << 2);
+
+        // All four channels at once; the weight sum is the same for each
+        float w = 0;
+        __m128 a = _mm_setzero_ps();
+        for (int32_t ii = iiBegin; ii <= iiEnd; ii++)
+        {
+            const float* mask = taps + (ii + ext) * tapStride + ext;
+            const uint8_t* row = center + ii * int32_t(srcRowBytes);
+            for (int32_t jj = jjBegin; jj <= jjEnd; jj++)
+            {
+                w += mask[jj];
+                __m128 pixel = _mm_add_ps(ILoadPixel(row + (jj << 2)), half);
+                a = _mm_add_ps(a, _mm_mul_ps(pixel, _mm_set1_ps(mask[jj])));
+            }
+        }
+
+        IStorePixel(dst + (j << 2), _mm_div_ps(a, _mm_set1_ps(w)));
+    }
+#endif
+}
+
+void plMipmap::scale_row_sse2(uint32_t* dst, const ScaleSpan* xSpans, uint32_t dstWidth,
+                              const ScaleSpan& ySpan, const uint32_t* src, uint32_t srcStride)
+{
+#ifdef HAVE_SSE2
+    // Same constants hsColorRGBA::FromARGB32() and ToARGB32() use
+    const __m128 oo255 = _mm_set1_ps(1.f / 255.f);
+    const __m128 to255 = _mm_set1_ps(255.99f);
+
+    for (uint32_t destX = 0; destX < dstWidth; destX++)
+    {
+        const ScaleSpan& xSpan = xSpans[destX];
+
+        __m128 accumColor = _mm_setzero_ps();
+        float totalWeight = 0.f;
+        for (int32_t srcY = ySpan.fStart; srcY <= ySpan.fEnd; srcY++)
+        {
+            float whyWait = ySpan.fWeights[srcY - ySpan.fStart];
+            if (whyWait <= 0.f)
+                continue;
+
+            const uint32_t* srcPtr = src + srcY * srcStride + xSpan.fStart;
+            for (int32_t srcX = xSpan.fStart; srcX <= xSpan.fEnd; srcX++, srcPtr++)
+            {
+                float weight = xSpan.fWeights[srcX - xSpan.fStart] * whyWait;
+                if (weight > 0.f)
+                {
+                    __m128 color = _mm_mul_ps(ILoadPixel(srcPtr), oo255);
+                    accumColor = _mm_add_ps(accumColor, _mm_mul_ps(color, _mm_set1_ps(weight)));
+                    totalWeight += weight;
+                }
+            }
+        }
+        accumColor = _mm_mul_ps(accumColor, _mm_set1_ps(1.f / totalWeight));
+
+        IStorePixel(dst++, _mm_mul_ps(accumColor, to255));
+    }
+#endif
+}
+
+void plMipmap::blend_row_sse2(uint32_t* dst, const uint32_t* src, uint32_t count, const CompositeOptions& options)
+{
+#ifdef HAVE_SSE2
+    // Tints outside [0, 1] can carry into the next channel, which only the
+    // plain 32-bit math reproduces
+    if (!(options.fRedTint >= 0.f && options.fRedTint <= 1.f &&
+          options.fGreenTint >= 0.f && options.fGreenTint <= 1.f &&
+          options.fBlueTint >= 0.f && options.fBlueTint <= 1.f))
+    {
+        blend_row_fpu(dst, src, count, options);
+        return;
+    }
+
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i byteMask = _mm_set1_epi32(0xff);
+    const __m128i alphaMask = _mm_set1_epi32(0xff000000);
+    const __m128i colorMask = _mm_set1_epi32(0x00ffffff);
+    const __m128i opacity = _mm_set1_epi32(options.fOpacity);
+    const __m128i full = _mm_set1_epi32(256);
+    const __m128 redTint = _mm_set1_ps(options.fRedTint);
+    const __m128 greenTint = _mm_set1_ps(options.fGreenTint);
+    const __m128 blueTint = _mm_set1_ps(options.fBlueTint);
+    const bool writeAlpha = (options.fFlags & kBlendWriteAlpha) != 0;
+
+    // Every product below fits in 16 bits, so mullo_epi16 on the low half of
+    // each 32-bit lane is exact
+    uint32_t pX = 0;
+    for (; pX + 4 <= count; pX += 4)
+    {
+        __m128i s = _mm_loadu_si128((const __m128i*)(src + pX));
+        __m128i d = _mm_loadu_si128((const __m128i*)(dst + pX));
+
+        __m128i sa = _mm_srli_epi32(s, 24);
+        __m128i skip = _mm_cmpeq_epi32(sa, zero);
+        __m128i srcAlpha = IDiv255Epi32(_mm_mullo_epi16(sa, opacity));
+        __m128i oneMinusAlpha = _mm_sub_epi32(full, srcAlpha);
+
+        __m128i r = _mm_cvttps_epi32(_mm_mul_ps(_mm_cvtepi32_ps(_mm_and_si128(_mm_srli_epi32(s, 16), byteMask)), redTint));
+        __m128i g = _mm_cvttps_epi32(_mm_mul_ps(_mm_cvtepi32_ps(_mm_and_si128(_mm_srli_epi32(s, 8), byteMask)), greenTint));
+        __m128i b = _mm_cvttps_epi32(_mm_mul_ps(_mm_cvtepi32_ps(_mm_and_si128(s, byteMask)), blueTint));
+        r = _mm_srli_epi32(_mm_mullo_epi16(r, srcAlpha), 8);
+        g = _mm_srli_epi32(_mm_mullo_epi16(g, srcAlpha), 8);
+        b = _mm_srli_epi32(_mm_mullo_epi16(b, srcAlpha), 8);
+
+        __m128i dR = _mm_srli_epi32(_mm_mullo_epi16(_mm_and_si128(_mm_srli_epi32(d, 16), byteMask), oneMinusAlpha), 8);
+        __m128i dG = _mm_srli_epi32(_mm_mullo_epi16(_mm_and_si128(_mm_srli_epi32(d, 8), byteMask), oneMinusAlpha), 8);
+        __m128i dB = _mm_srli_epi32(_mm_mullo_epi16(_mm_and_si128(d, byteMask), oneMinusAlpha), 8);
+
+        __m128i out = _mm_or_si128(_mm_slli_epi32(_mm_add_epi32(r, dR), 16), _mm_slli_epi32(_mm_add_epi32(g, dG), 8));
+        out = _mm_or_si128(out, _mm_add_epi32(b, dB));
+        if (writeAlpha)
+            out = _mm_or_si128(out, _mm_slli_epi32(srcAlpha, 24));
+        else
+            out = _mm_or_si128(out, _mm_and_si128(d, alphaMask));
+
+        _mm_storeu_si128((__m128i*)(dst + pX), ISelect(skip, d, out));
+    }
+
+    blend_row_fpu(dst + pX, src + pX, count - pX, options);
+#endif
+}
+
+void plMipmap::premultiply_row_sse2(uint32_t* pixels, uint32_t count)
+{
+#ifdef HAVE_SSE2
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i alphaMask = _mm_set1_epi32(0xff000000);
+    const __m128i round = _mm_set1_epi16(127);
+    const __m128i div255 = _mm_set1_epi16((short)0x8081);
+
+    // Two pixels per register at 16 bits a channel; c * a + 127 tops out at
+    // 65152, and (x * 0x8081) >> 23 is exactly x / 255 up to 65535
+    uint32_t pX = 0;
+    for (; pX + 4 <= count; pX += 4)
+    {
+        __m128i p = _mm_loadu_si128((const __m128i*)(pixels + pX));
+
+        __m128i lo = _mm_unpacklo_epi8(p, zero);
+        __m128i hi = _mm_unpackhi_epi8(p, zero);
+        __m128i loAlpha = _mm_shufflehi_epi16(_mm_shufflelo_epi16(lo, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+        __m128i hiAlpha = _mm_shufflehi_epi16(_mm_shufflelo_epi16(hi, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+        lo = _mm_srli_epi16(_mm_mulhi_epu16(_mm_add_epi16(_mm_mullo_epi16(lo, loAlpha), round), div255), 7);
+        hi = _mm_srli_epi16(_mm_mulhi_epu16(_mm_add_epi16(_mm_mullo_epi16(hi, hiAlpha), round), div255), 7);
+
+        __m128i out = _mm_packus_epi16(lo, hi);
+        _mm_storeu_si128((__m128i*)(pixels + pX), ISelect(alphaMask, p, out));
+    }
+
+    premultiply_row_fpu(pixels + pX, count - pX);
+#endif
+}
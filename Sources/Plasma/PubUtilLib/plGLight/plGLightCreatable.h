@@ -67,4 +67,7 @@ REGISTER_CREATABLE(plShadowCaster);
 #include "plShadowMaster.h"
 REGISTER_NONCREATABLE(plShadowMaster);
 
+#include "plShadowScheduler.h"
+REGISTER_NONCREATABLE(plShadowScheduler);
+
 #endif // plGLightCreatable_inc
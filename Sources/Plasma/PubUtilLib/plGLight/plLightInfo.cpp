@@ -174,9 +174,41 @@ void plLightInfo::GetStrengthAndScale(const hsBounds3Ext& bnd, float& strength,
 
 bool plLightInfo::AffectsBound(const hsBounds3Ext& bnd)
 {
+    Refresh();
+
+    plVolumeIsect* isect = IGetIsect();
+    if (!isect)
+        return true;
+
+    // The cone and box tests only check the volume's own planes, which
+    // lets through boxes sitting off past a corner. Nothing outside the
+    // volume's box can be lit, and it's the same box the pipeline's light
+    // grid files us under, so the grid and a full walk agree.
+    hsBounds3Ext volBnd;
+    if (bnd.GetType() == kBoundsNormal && isect->GetWorldBounds(volBnd))
+    {
+        const hsPoint3& mins = bnd.GetMins();
+        const hsPoint3& maxs = bnd.GetMaxs();
+        for (int i = 0; i < 3; i++)
+        {
+            if (maxs[i] < volBnd.GetMins()[i] || mins[i] > volBnd.GetMaxs()[i])
+                return false;
+        }
+    }
+
+    return isect->Test(bnd) != kVolumeCulled;
+}
+
+// World space box around everything this light can reach, false for
+// lights which reach everywhere. Anything AffectsBound() passes that's
+// actually inside the light's volume overlaps this box.
+bool plLightInfo::GetInfluenceBounds(hsBounds3Ext& bnd)
+{
+    Refresh();
+
     if (plVolumeIsect* isect = IGetIsect(); isect)
-        return isect->Test(bnd) != kVolumeCulled;
-    return true;
+        return isect->GetWorldBounds(bnd);
+    return false;
 }
 
 void plLightInfo::GetAffectedForced(const plSpaceTree* space, hsBitVector& list, bool charac)
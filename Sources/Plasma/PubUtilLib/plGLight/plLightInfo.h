@@ -190,6 +190,7 @@ public:
     virtual void GetStrengthAndScale(const hsBounds3Ext& bnd, float& strength, float& scale) const;
 
     bool AffectsBound(const hsBounds3Ext& bnd);
+    bool GetInfluenceBounds(hsBounds3Ext& bnd);
     void GetAffectedForced(const plSpaceTree* space, hsBitVector& list, bool charac);
     void GetAffected(const plSpaceTree* space, hsBitVector& list, bool charac);
     const std::vector<int16_t>& GetAffected(plSpaceTree* space, const std::vector<int16_t>& visList, std::vector<int16_t>& litList, bool charac);
@@ -58,6 +58,7 @@ You can contact Cyan Worlds, Inc. by email legal@cyan.com
 #include "plgDispatch.h"
 
 #include "plShadowMaster.h"
+#include "plShadowScheduler.h"
 
 bool plShadowCaster::fShadowCastDisabled = false;
 bool plShadowCaster::fCanShadowCast = true;
@@ -194,8 +195,15 @@ bool plShadowCaster::IOnRenderMsg(plRenderMsg* msg)
 
     if( fMaxOpacity > 0 )
     {
-        plShadowCastMsg* cast = new plShadowCastMsg(GetKey(), this, msg->Pipeline());
-        cast->Send();
+        if( plShadowScheduler* sched = plShadowScheduler::Instance() )
+        {
+            sched->AddCaster(this, msg->Pipeline());
+        }
+        else
+        {
+            plShadowCastMsg* cast = new plShadowCastMsg(GetKey(), this, msg->Pipeline());
+            cast->Send();
+        }
     }
 
     return true;
@@ -46,6 +46,7 @@ You can contact Cyan Worlds, Inc. by email legal@cyan.com
 
 #include "plLightInfo.h"
 #include "plShadowCaster.h"
+#include "plShadowScheduler.h"
 
 #include "plIntersect/plVolumeIsect.h"
 #include "plMessage/plShadowCastMsg.h"
@@ -60,13 +61,19 @@ You can contact Cyan Worlds, Inc. by email legal@cyan.com
 #include "plPipeline.h"
 #include "hsFastMath.h"
 
+#include "plProfile.h"
 #include "plTweak.h"
 
+plProfile_CreateTimer("ShadowMaster", "RenderSetup", ShadowMaster);
+plProfile_CreateCounter("ShadowSetupsReused", "RenderSetup", ShadowSetupsReused);
+
 uint32_t plShadowMaster::fGlobalMaxSize = 512;
 float plShadowMaster::fGlobalMaxDist = 160.f; // PERSPTEST
 // float plShadowMaster::fGlobalMaxDist = 100000.f; // PERSPTEST
 float plShadowMaster::fGlobalVisParm = 1.f;
 float plShadowMaster::fGlobalMaxBlur = -1.f;
+uint32_t plShadowMaster::fGlobalMaxMaps = 16;
+bool plShadowMaster::fGlobalCacheSetups = true;
 
 void plShadowMaster::SetGlobalShadowQuality(float s) 
 { 
@@ -110,7 +117,8 @@ plShadowMaster::plShadowMaster()
     fMaxSize(256),
     fMinSize(256),
     fPower(1.f),
-    fLightInfo()
+    fLightInfo(),
+    fFrame()
 {
 }
 
@@ -153,12 +161,21 @@ void plShadowMaster::Write(hsStream* stream, hsResMgr* mgr)
 
 void plShadowMaster::Activate() const
 {
+    // With a scheduler running, it hands us our casters. Otherwise
+    // (tools and such) every master hears every cast, like always.
+    if( plShadowScheduler* sched = plShadowScheduler::Instance() )
+    {
+        sched->AddMaster(const_cast<plShadowMaster*>(this));
+        return;
+    }
     plgDispatch::Dispatch()->RegisterForExactType(plShadowCastMsg::Index(), GetKey());
     plgDispatch::Dispatch()->RegisterForExactType(plRenderMsg::Index(), GetKey());
 }
 
 void plShadowMaster::Deactivate() const
 {
+    if( plShadowScheduler* sched = plShadowScheduler::Instance() )
+        sched->RemoveMaster(const_cast<plShadowMaster*>(this));
     plgDispatch::Dispatch()->UnRegisterForExactType(plShadowCastMsg::Index(), GetKey());
     plgDispatch::Dispatch()->UnRegisterForExactType(plRenderMsg::Index(), GetKey());
 }
@@ -170,8 +187,6 @@ void plShadowMaster::SetMaxDist(float f)
 }
 
 
-#include "plProfile.h"
-plProfile_CreateTimer("ShadowMaster", "RenderSetup", ShadowMaster);
 bool plShadowMaster::MsgReceive(plMessage* msg)
 {
     plRenderMsg* rendMsg = plRenderMsg::ConvertNoRef(msg);
@@ -198,13 +213,23 @@ void plShadowMaster::IBeginRender()
     fSlavePool.clear();
     if( ISetLightInfo() ) 
         fLightInfo->ClearSlaveBits();
+
+    // Every so often, forget about casters we haven't seen in a while.
+    const uint32_t kStaleFrames = 64;
+    if( !(++fFrame % kStaleFrames) || !fGlobalCacheSetups )
+    {
+        for( auto iter = fSetupCache.begin(); iter != fSetupCache.end(); )
+        {
+            if( !fGlobalCacheSetups || (fFrame - iter->second.fLastFrame > kStaleFrames) )
+                iter = fSetupCache.erase(iter);
+            else
+                ++iter;
+        }
+    }
 }
 
-bool plShadowMaster::IOnCastMsg(plShadowCastMsg* castMsg)
+bool plShadowMaster::ICanCast() const
 {
-//  // HACKTEST
-//  return false;
-
     if( !fLightInfo )
         return false;
 
@@ -216,6 +241,17 @@ bool plShadowMaster::IOnCastMsg(plShadowCastMsg* castMsg)
     if( !GetKey()->GetUoid().GetLoadMask().MatchesQuality(shadowQuality) )
         return false;
 
+    return true;
+}
+
+bool plShadowMaster::IOnCastMsg(plShadowCastMsg* castMsg)
+{
+//  // HACKTEST
+//  return false;
+
+    if( !ICanCast() )
+        return false;
+
     plShadowCaster* caster = castMsg->Caster();
 
     if (caster->Spans().empty())
@@ -224,13 +260,24 @@ bool plShadowMaster::IOnCastMsg(plShadowCastMsg* castMsg)
     hsBounds3Ext casterBnd;
     IComputeCasterBounds(caster, casterBnd);
 
+    plShadowSlave* slave = ICastShadow(castMsg, casterBnd);
+    if( !slave )
+        return false;
+
+    return ISubmitSlave(castMsg, slave);
+}
+
+plShadowSlave* plShadowMaster::ICastShadow(plShadowCastMsg* castMsg, const hsBounds3Ext& casterBnd)
+{
+    const plShadowCaster* caster = castMsg->Caster();
+
     float power = IComputePower(caster, casterBnd);
 
     static float kVisShadowPower = 1.e-1f;
     static float kMinShadowPower = 2.e-1f;
     static float kKneeShadowPower = 3.e-1f;
     if( power < kMinShadowPower )
-        return false;
+        return nullptr;
     if( power < kKneeShadowPower )
     {
         power -= kMinShadowPower;
@@ -239,12 +286,6 @@ bool plShadowMaster::IOnCastMsg(plShadowCastMsg* castMsg)
         power += kVisShadowPower;
     }
 
-    // Create ShadowSlave focused on ShadowCaster
-    // ShadowSlave extent just enough to cover ShadowCaster (including nearplane)
-    plShadowSlave* slave = ICreateShadowSlave(castMsg, casterBnd, power);
-    if( !slave )
-        return false;
-
     // !!!IMPORTANT
     // ShadowMaster contains 2 values for yon.
     // First value applies to ShadowMaster. Any ShadowCaster beyond this distance
@@ -255,6 +296,13 @@ bool plShadowMaster::IOnCastMsg(plShadowCastMsg* castMsg)
     //      That's the distance used for culling ShadowReceivers
     // The ShadowSlaveYon is used directly in the 
 
+    // Create ShadowSlave focused on ShadowCaster
+    // ShadowSlave extent just enough to cover ShadowCaster (including nearplane)
+    return ICreateShadowSlave(castMsg, casterBnd, power);
+}
+
+bool plShadowMaster::ISubmitSlave(plShadowCastMsg* castMsg, plShadowSlave* slave)
+{
     slave->fIndex = uint32_t(-1);
     castMsg->Pipeline()->SubmitShadowSlave(slave);
     
@@ -284,6 +332,11 @@ plLightInfo* plShadowMaster::ISetLightInfo()
 }
 
 void plShadowMaster::IComputeCasterBounds(const plShadowCaster* caster, hsBounds3Ext& casterBnd)
+{
+    ComputeCasterBounds(caster, casterBnd);
+}
+
+void plShadowMaster::ComputeCasterBounds(const plShadowCaster* caster, hsBounds3Ext& casterBnd)
 {
     casterBnd.MakeEmpty();
     for (const plShadowCastSpan& castSpan : caster->Spans())
@@ -326,15 +379,26 @@ plShadowSlave* plShadowMaster::ICreateShadowSlave(plShadowCastMsg* castMsg, cons
 
     // Order of these matters, since values calculated in one are
     // used by later functions. Rearrange at your own risk.
-    IComputeWorldToLight(casterBnd, slave);
+    // If neither the caster nor the light has moved, the light space
+    // transforms, bounds and LUTs are the same as last time.
+    bool cached = IFetchSetup(caster, casterBnd, slave);
+    if( !cached )
+    {
+        IComputeWorldToLight(casterBnd, slave);
 
-    IComputeBounds(casterBnd, slave);
+        IComputeBounds(casterBnd, slave);
+    }
 
     IComputeWidthAndHeight(castMsg, slave);
 
     IComputeProjections(castMsg, slave);
 
-    IComputeLUT(castMsg, slave);
+    if( !cached )
+    {
+        IComputeLUT(castMsg, slave);
+
+        IStoreSetup(caster, casterBnd, slave);
+    }
 
     IComputeISect(casterBnd, slave);
 
@@ -347,10 +411,72 @@ plShadowSlave* plShadowMaster::ICreateShadowSlave(plShadowCastMsg* castMsg, cons
 
 plShadowSlave* plShadowMaster::IRecycleSlave(plShadowSlave* slave)
 {
-    fSlavePool.pop_back();
+    // Only the most recent slave can go back, the scheduler may hand
+    // back older ones, which just sit until the pool is cleared.
+    if (!fSlavePool.empty() && (fSlavePool.back().get() == slave))
+        fSlavePool.pop_back();
     return nullptr;
 }
 
+static inline bool ISameBounds(const hsBounds3Ext& a, const hsBounds3Ext& b)
+{
+    if( a.GetType() != b.GetType() )
+        return false;
+    if( a.GetType() != kBoundsNormal )
+        return true;
+    const hsPoint3& aMin = a.GetMins();
+    const hsPoint3& aMax = a.GetMaxs();
+    const hsPoint3& bMin = b.GetMins();
+    const hsPoint3& bMax = b.GetMaxs();
+    return aMin.fX == bMin.fX && aMin.fY == bMin.fY && aMin.fZ == bMin.fZ
+        && aMax.fX == bMax.fX && aMax.fY == bMax.fY && aMax.fZ == bMax.fZ;
+}
+
+bool plShadowMaster::IFetchSetup(const plShadowCaster* caster, const hsBounds3Ext& casterBnd, plShadowSlave* slave)
+{
+    if( !fGlobalCacheSetups )
+        return false;
+
+    auto iter = fSetupCache.find(caster);
+    if( iter == fSetupCache.end() )
+        return false;
+
+    SetupCache& cache = iter->second;
+    if( cache.fAttenDist != slave->fAttenDist
+        || cache.fSlaveFlags != slave->fFlags
+        || !ISameBounds(cache.fCasterBnd, casterBnd)
+        || !(cache.fLightL2W == fLightInfo->GetLightToWorld()) )
+        return false;
+
+    slave->fWorldToLight = cache.fWorldToLight;
+    slave->fLightToWorld = cache.fLightToWorld;
+    slave->fWorldBounds = cache.fWorldBounds;
+    slave->fRcvLUT = cache.fRcvLUT;
+    slave->fCastLUT = cache.fCastLUT;
+    cache.fLastFrame = fFrame;
+
+    plProfile_Inc(ShadowSetupsReused);
+    return true;
+}
+
+void plShadowMaster::IStoreSetup(const plShadowCaster* caster, const hsBounds3Ext& casterBnd, const plShadowSlave* slave)
+{
+    if( !fGlobalCacheSetups )
+        return;
+
+    SetupCache& cache = fSetupCache[caster];
+    cache.fLightL2W = fLightInfo->GetLightToWorld();
+    cache.fCasterBnd = casterBnd;
+    cache.fAttenDist = slave->fAttenDist;
+    cache.fSlaveFlags = slave->fFlags;
+    cache.fWorldToLight = slave->fWorldToLight;
+    cache.fLightToWorld = slave->fLightToWorld;
+    cache.fWorldBounds = slave->fWorldBounds;
+    cache.fRcvLUT = slave->fRcvLUT;
+    cache.fCastLUT = slave->fCastLUT;
+    cache.fLastFrame = fFrame;
+}
+
 plShadowSlave* plShadowMaster::ILastChanceToBail(plShadowCastMsg* castMsg, plShadowSlave* slave)
 {
     const hsBounds3Ext& wBnd = slave->fWorldBounds;
@@ -44,7 +44,10 @@ You can contact Cyan Worlds, Inc. by email legal@cyan.com
 #define plShadowMaster_inc
 
 #include <memory>
+#include <unordered_map>
 
+#include "hsBounds.h"
+#include "hsMatrix44.h"
 #include "hsPoolVector.h"
 
 #include "pnSceneObject/plObjInterface.h"
@@ -52,8 +55,6 @@ You can contact Cyan Worlds, Inc. by email legal@cyan.com
 class plShadowCaster;
 class plShadowSlave;
 
-struct hsMatrix44;
-class hsBounds3Ext;
 class hsStream;
 class hsResMgr;
 class plMessage;
@@ -78,6 +79,8 @@ protected:
     static float                fGlobalMaxDist;
     static float                fGlobalVisParm;
     static float                fGlobalMaxBlur;
+    static uint32_t             fGlobalMaxMaps;
+    static bool                 fGlobalCacheSetups;
 
     // Constant parameter(s) for this master.
     float                       fAttenDist;
@@ -93,6 +96,31 @@ protected:
     hsPoolVector<std::unique_ptr<plShadowSlave>> fSlavePool;
     plLightInfo*                    fLightInfo;
 
+    // The light space part of a slave's setup only depends on where the caster
+    // and the light are, so hang onto it per caster and reuse it until one of
+    // them moves. The view dependent parts (size and priority) are redone
+    // every frame.
+    struct SetupCache
+    {
+        hsMatrix44                  fLightL2W;
+        hsBounds3Ext                fCasterBnd;
+        float                       fAttenDist;
+        uint32_t                    fSlaveFlags;
+
+        hsMatrix44                  fWorldToLight;
+        hsMatrix44                  fLightToWorld;
+        hsBounds3Ext                fWorldBounds;
+        hsMatrix44                  fRcvLUT;
+        hsMatrix44                  fCastLUT;
+
+        uint32_t                    fLastFrame;
+    };
+    std::unordered_map<const plShadowCaster*, SetupCache> fSetupCache;
+    uint32_t                        fFrame;
+
+    bool IFetchSetup(const plShadowCaster* caster, const hsBounds3Ext& casterBnd, plShadowSlave* slave);
+    void IStoreSetup(const plShadowCaster* caster, const hsBounds3Ext& casterBnd, const plShadowSlave* slave);
+
     // These are specific to the projection type (perspective or orthogonal), so have to
     // be implemented by the derived class.
     virtual void IComputeWorldToLight(const hsBounds3Ext& bnd, plShadowSlave* slave) const = 0;
@@ -121,6 +149,14 @@ protected:
     virtual void IBeginRender();
     virtual bool IOnCastMsg(plShadowCastMsg* castMsg);
 
+    // IOnCastMsg in pieces, so plShadowScheduler can look at all the
+    // slaves from all the masters before any get submitted.
+    bool ICanCast() const;
+    plShadowSlave* ICastShadow(plShadowCastMsg* castMsg, const hsBounds3Ext& casterBnd);
+    bool ISubmitSlave(plShadowCastMsg* castMsg, plShadowSlave* slave);
+
+    friend class plShadowScheduler;
+
 public:
     plShadowMaster();
     virtual ~plShadowMaster();
@@ -170,6 +206,15 @@ public:
 
     static void SetGlobalMaxBlur(float s) { fGlobalMaxBlur = s; }
     static float GetGlobalMaxBlur() { return fGlobalMaxBlur; }
+
+    // Total shadow map area allowed in a frame, in maps of GetGlobalMaxSize().
+    static void SetGlobalMaxMaps(uint32_t n) { fGlobalMaxMaps = n; }
+    static uint32_t GetGlobalMaxMaps() { return fGlobalMaxMaps; }
+
+    static void SetGlobalCacheSetups(bool on) { fGlobalCacheSetups = on; }
+    static bool GetGlobalCacheSetups() { return fGlobalCacheSetups; }
+
+    static void ComputeCasterBounds(const plShadowCaster* caster, hsBounds3Ext& casterBnd);
 };
 
 
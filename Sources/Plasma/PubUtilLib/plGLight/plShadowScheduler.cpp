@@ -0,0 +1,234 @@
+/*==LICENSE==*
+
+CyanWorlds.com Engine - MMOG client, server and tools
+Copyright (C) 2011  Cyan Worlds, Inc.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+Additional permissions under GNU GPL version 3 section 7
+
+If you modify this Program, or any covered work, by linking or
+combining it with any of RAD Game Tools Bink SDK, Autodesk 3ds Max SDK,
+NVIDIA PhysX SDK, Microsoft DirectX SDK, OpenSSL library, Independent
+JPEG Group JPEG library, Microsoft Windows Media SDK, or Apple QuickTime SDK
+(or a modified version of those libraries),
+containing parts covered by the terms of the Bink SDK EULA, 3ds Max EULA,
+PhysX SDK EULA, DirectX SDK EULA, OpenSSL and SSLeay licenses, IJG
+JPEG Library README, Windows Media SDK EULA, or QuickTime SDK EULA, the
+licensors of this Program grant you additional
+permission to convey the resulting work. Corresponding Source for a
+non-source form of such a combination shall include the source code for
+the parts of OpenSSL and IJG JPEG Library used as well as that of the covered
+work.
+
+You can contact Cyan Worlds, Inc. by email legal@cyan.com
+ or by snail mail at:
+      Cyan Worlds, Inc.
+      14617 N Newport Hwy
+      Mead, WA   99021
+
+*==LICENSE==*/
+
+#include "HeadSpin.h"
+#include "plShadowScheduler.h"
+
+#include <algorithm>
+
+#include "plgDispatch.h"
+#include "plPipeline.h"
+#include "plProfile.h"
+
+#include "pnKeyedObject/plFixedKey.h"
+
+#include "plLightInfo.h"
+#include "plShadowCaster.h"
+#include "plShadowMaster.h"
+#include "plShadowSlave.h"
+
+#include "plMessage/plRenderMsg.h"
+
+plProfile_Extern(ShadowMaster);
+plProfile_CreateTimer("ShadowSchedule", "RenderSetup", ShadowSchedule);
+plProfile_CreateCounter("ShadowPairsCulled", "RenderSetup", ShadowPairsCulled);
+plProfile_CreateCounter("ShadowOverBudget", "RenderSetup", ShadowOverBudget);
+
+plShadowScheduler* plShadowScheduler::fInstance = nullptr;
+
+void plShadowScheduler::Init()
+{
+    fInstance = new plShadowScheduler;
+    fInstance->RegisterAs(kShadowScheduler_KEY);
+    plgDispatch::Dispatch()->RegisterForExactType(plRenderMsg::Index(), fInstance->GetKey());
+}
+
+void plShadowScheduler::DeInit()
+{
+    if (fInstance)
+    {
+        plgDispatch::Dispatch()->UnRegisterForExactType(plRenderMsg::Index(), fInstance->GetKey());
+        fInstance->UnRegisterAs(kShadowScheduler_KEY);     // this will destroy the instance
+        fInstance = nullptr;
+    }
+}
+
+plShadowScheduler::plShadowScheduler()
+    : fPipe(), fScheduleSent()
+{
+}
+
+void plShadowScheduler::AddMaster(plShadowMaster* master)
+{
+    if (std::find(fMasters.begin(), fMasters.end(), master) == fMasters.end())
+        fMasters.emplace_back(master);
+}
+
+void plShadowScheduler::RemoveMaster(plShadowMaster* master)
+{
+    auto iter = std::find(fMasters.begin(), fMasters.end(), master);
+    if (iter != fMasters.end())
+        fMasters.erase(iter);
+}
+
+void plShadowScheduler::AddCaster(plShadowCaster* caster, plPipeline* pipe)
+{
+    fCasters.emplace_back(caster);
+    fPipe = pipe;
+
+    // The render message is still making the rounds, and not every master has
+    // reset for the frame yet. Anything sent now gets delivered after it's
+    // done, so that's when we go to work.
+    if (!fScheduleSent)
+    {
+        plShadowCastMsg* msg = new plShadowCastMsg(GetKey(), nullptr, pipe);
+        msg->SetBCastFlag(plMessage::kBCastByType, false);
+        msg->AddReceiver(GetKey());
+        msg->Send();
+        fScheduleSent = true;
+    }
+}
+
+void plShadowScheduler::IBeginRender(plPipeline* pipe)
+{
+    fPipe = pipe;
+    for (plShadowMaster* master : fMasters)
+    {
+        plProfile_BeginLap(ShadowMaster, master->GetKey()->GetUoid().GetObjectName());
+        master->IBeginRender();
+        plProfile_EndLap(ShadowMaster, master->GetKey()->GetUoid().GetObjectName());
+    }
+}
+
+void plShadowScheduler::ISchedule()
+{
+    fScheduleSent = false;
+    if (fCasters.empty() || !fPipe)
+    {
+        fCasters.clear();
+        return;
+    }
+
+    plProfile_BeginTiming(ShadowSchedule);
+
+    fCastingMasters.clear();
+    fCastingLights.clear();
+    for (plShadowMaster* master : fMasters)
+    {
+        if (master->ICanCast())
+        {
+            fCastingMasters.emplace_back(master);
+            fCastingLights.emplace_back(master->fLightInfo);
+        }
+    }
+
+    // Match each caster up with the lights whose influence reaches it.
+    // Directional lights reach everything, so they always come back.
+    fLightGrid.Build(fCastingLights);
+
+    fCasts.clear();
+    fCastMsg.SetPipeline(fPipe);
+    for (plShadowCaster* caster : fCasters)
+    {
+        if (caster->Spans().empty())
+            continue;
+
+        hsBounds3Ext casterBnd;
+        plShadowMaster::ComputeCasterBounds(caster, casterBnd);
+
+        fLightGrid.FindLights(casterBnd, fCandidates);
+        plProfile_IncCount(ShadowPairsCulled, fCastingMasters.size() - fCandidates.size());
+
+        fCastMsg.SetCaster(caster);
+        for (uint16_t idx : fCandidates)
+        {
+            plShadowMaster* master = fCastingMasters[idx];
+            if (plShadowSlave* slave = master->ICastShadow(&fCastMsg, casterBnd))
+                fCasts.push_back({ master, slave });
+        }
+    }
+    fCasters.clear();
+    fLightGrid.Clear();
+
+    // Closest first (that's what fPriority is), then hand out the budget.
+    // Shrink the far ones before dropping anything.
+    std::stable_sort(fCasts.begin(), fCasts.end(),
+        [](const Cast& a, const Cast& b) { return a.fSlave->fPriority < b.fSlave->fPriority; });
+
+    const uint32_t kMinSize = 32;
+    const uint64_t maxSize = plShadowMaster::GetGlobalMaxSize();
+    const uint64_t budget = maxSize * maxSize * plShadowMaster::GetGlobalMaxMaps();
+    uint64_t used = 0;
+    for (const Cast& cast : fCasts)
+    {
+        plShadowSlave* slave = cast.fSlave;
+        if (budget)
+        {
+            while ((used + uint64_t(slave->fWidth) * slave->fHeight > budget)
+                && (slave->fWidth > kMinSize) && (slave->fHeight > kMinSize))
+            {
+                slave->fWidth >>= 1;
+                slave->fHeight >>= 1;
+            }
+            if (used + uint64_t(slave->fWidth) * slave->fHeight > budget)
+            {
+                plProfile_Inc(ShadowOverBudget);
+                continue;
+            }
+            used += uint64_t(slave->fWidth) * slave->fHeight;
+        }
+
+        fCastMsg.SetCaster(const_cast<plShadowCaster*>(slave->fCaster));
+        cast.fMaster->ISubmitSlave(&fCastMsg, slave);
+    }
+    fCasts.clear();
+    fCastMsg.SetCaster(nullptr);
+
+    plProfile_EndTiming(ShadowSchedule);
+}
+
+bool plShadowScheduler::MsgReceive(plMessage* msg)
+{
+    if (plRenderMsg* rendMsg = plRenderMsg::ConvertNoRef(msg))
+    {
+        IBeginRender(rendMsg->Pipeline());
+        return true;
+    }
+
+    if (plShadowCastMsg::ConvertNoRef(msg))
+    {
+        ISchedule();
+        return true;
+    }
+
+    return hsKeyedObject::MsgReceive(msg);
+}
@@ -0,0 +1,112 @@
+/*==LICENSE==*
+
+CyanWorlds.com Engine - MMOG client, server and tools
+Copyright (C) 2011  Cyan Worlds, Inc.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+Additional permissions under GNU GPL version 3 section 7
+
+If you modify this Program, or any covered work, by linking or
+combining it with any of RAD Game Tools Bink SDK, Autodesk 3ds Max SDK,
+NVIDIA PhysX SDK, Microsoft DirectX SDK, OpenSSL library, Independent
+JPEG Group JPEG library, Microsoft Windows Media SDK, or Apple QuickTime SDK
+(or a modified version of those libraries),
+containing parts covered by the terms of the Bink SDK EULA, 3ds Max EULA,
+PhysX SDK EULA, DirectX SDK EULA, OpenSSL and SSLeay licenses, IJG
+JPEG Library README, Windows Media SDK EULA, or QuickTime SDK EULA, the
+licensors of this Program grant you additional
+permission to convey the resulting work. Corresponding Source for a
+non-source form of such a combination shall include the source code for
+the parts of OpenSSL and IJG JPEG Library used as well as that of the covered
+work.
+
+You can contact Cyan Worlds, Inc. by email legal@cyan.com
+ or by snail mail at:
+      Cyan Worlds, Inc.
+      14617 N Newport Hwy
+      Mead, WA   99021
+
+*==LICENSE==*/
+
+#ifndef plShadowScheduler_inc
+#define plShadowScheduler_inc
+
+#include <vector>
+
+#include "pnKeyedObject/hsKeyedObject.h"
+#include "plMessage/plShadowCastMsg.h"
+#include "plPipeline/plLightGrid.h"
+
+class plLightInfo;
+class plMessage;
+class plPipeline;
+class plShadowCaster;
+class plShadowMaster;
+class plShadowSlave;
+
+// Sits between the shadow casters and the shadow masters, so that instead of
+// every caster's cast message going out to every master, the casters check in
+// here once a frame and get matched up with only the lights they're near.
+// All the resulting slaves are then ranked together, and the closest ones
+// submitted to the pipeline until the frame's shadow map budget
+// (plShadowMaster::GetGlobalMaxMaps() maps of GetGlobalMaxSize()) runs out.
+class plShadowScheduler : public hsKeyedObject
+{
+protected:
+    static plShadowScheduler* fInstance;
+
+    struct Cast
+    {
+        plShadowMaster*     fMaster;
+        plShadowSlave*      fSlave;
+    };
+
+    std::vector<plShadowMaster*>    fMasters;
+    std::vector<plShadowCaster*>    fCasters;
+    plPipeline*                     fPipe;
+    bool                            fScheduleSent;
+
+    // Scratch, rebuilt every frame.
+    std::vector<plShadowMaster*>    fCastingMasters;
+    std::vector<plLightInfo*>       fCastingLights;
+    plLightGrid                     fLightGrid;
+    std::vector<uint16_t>           fCandidates;
+    std::vector<Cast>               fCasts;
+    plShadowCastMsg                 fCastMsg;
+
+    void IBeginRender(plPipeline* pipe);
+    void ISchedule();
+
+public:
+    static plShadowScheduler* Instance() { return fInstance; }
+
+    static void Init();
+    static void DeInit();
+
+    plShadowScheduler();
+
+    CLASSNAME_REGISTER( plShadowScheduler );
+    GETINTERFACE_ANY( plShadowScheduler, hsKeyedObject );
+
+    bool MsgReceive(plMessage* msg) override;
+
+    void AddMaster(plShadowMaster* master);
+    void RemoveMaster(plShadowMaster* master);
+
+    // Called by the casters while handling the plRenderMsg.
+    void AddCaster(plShadowCaster* caster, plPipeline* pipe);
+};
+
+#endif // plShadowScheduler_inc
@@ -50,6 +50,19 @@ You can contact Cyan Worlds, Inc. by email legal@cyan.com
 
 static const float kDefLength = 5.f;
 
+// Grow a box a hair so round-off in the callers' own math can't
+// leave something Test() would accept sitting just outside of it.
+static void IPadWorldBounds(hsPoint3& mins, hsPoint3& maxs, hsBounds3Ext& bnd)
+{
+    for (int i = 0; i < 3; i++) {
+        float pad = (maxs[i] - mins[i]) * 1.e-3f + 1.e-3f;
+        mins[i] -= pad;
+        maxs[i] += pad;
+    }
+    bnd.Reset(&mins);
+    bnd.Union(&maxs);
+}
+
 plSphereIsect::plSphereIsect()
     : fRadius(1.f)
 {
@@ -135,6 +148,14 @@ plVolumeCullResult plSphereIsect::Test(const hsBounds3Ext& bnd) const
     return kVolumeClear;
 }
 
+bool plSphereIsect::GetWorldBounds(hsBounds3Ext& bnd) const
+{
+    // Test() above is nothing but a box test against these.
+    bnd.Reset(&fMins);
+    bnd.Union(&fMaxs);
+    return true;
+}
+
 float plSphereIsect::Test(const hsPoint3& pos) const
 {
     float dist = (pos - fWorldCenter).MagnitudeSquared();
@@ -166,7 +187,7 @@ void plSphereIsect::Write(hsStream* s, hsResMgr* mgr)
 ///////////////////////////////////////////////////////////////////////////
 
 plConeIsect::plConeIsect()
-    : fLength(kDefLength), fRadAngle(hsConstants::pi<float> * 0.25f), fCapped()
+    : fLength(kDefLength), fRadAngle(hsConstants::pi<float> * 0.25f), fCapped(), fBoundsCapped()
 {
     ISetup();
 }
@@ -305,6 +326,39 @@ void plConeIsect::SetTransform(const hsMatrix44& l2w, const hsMatrix44& w2l)
 
         IDEBUG_NORMALIZE( fNorms[4], fDists[4] );
     }
+
+    // The planes above bound a pyramid from the tip down -Z to the cap,
+    // so box up the tip and the four corners of the cap. Same sin/cos
+    // approximation as ISetup, so the corners match the planes.
+    float sinAng, cosAng;
+    hsFastMath::SinCosInRangeAppr(fRadAngle, sinAng, cosAng);
+    fBoundsCapped = fCapped && cosAng > 0.05f;
+    if( fBoundsCapped )
+    {
+        float halfWidth = fLength * sinAng / cosAng;
+        hsPoint3 mins = fWorldTip;
+        hsPoint3 maxs = fWorldTip;
+        for( i = 0; i < 4; i++ )
+        {
+            hsPoint3 corner = l2w * hsPoint3((i & 1) ? halfWidth : -halfWidth,
+                                             (i & 2) ? halfWidth : -halfWidth,
+                                             -fLength);
+            for( int j = 0; j < 3; j++ )
+            {
+                mins[j] = std::min(mins[j], corner[j]);
+                maxs[j] = std::max(maxs[j], corner[j]);
+            }
+        }
+        IPadWorldBounds(mins, maxs, fWorldBounds);
+    }
+}
+
+bool plConeIsect::GetWorldBounds(hsBounds3Ext& bnd) const
+{
+    if( !fCapped || !fBoundsCapped )
+        return false;
+    bnd = fWorldBounds;
+    return true;
 }
 
 void plConeIsect::SetLength(float d)
@@ -342,6 +396,8 @@ void plConeIsect::Read(hsStream* s, hsResMgr* mgr)
         fNorms[i].Read(s);
         fDists[i] = s->ReadLEFloat();
     }
+    // Planes came off disk, the box didn't. Wait for the next SetTransform.
+    fBoundsCapped = false;
 }
 
 void plConeIsect::Write(hsStream* s, hsResMgr* mgr)
@@ -557,6 +613,7 @@ void plParallelIsect::SetTransform(const hsMatrix44& l2w, const hsMatrix44& w2l)
             plane.fMax = t1;
         }
     }
+    ISetWorldBounds();
 }
 
 plVolumeCullResult plParallelIsect::Test(const hsBounds3Ext& bnd) const
@@ -578,6 +635,50 @@ plVolumeCullResult plParallelIsect::Test(const hsBounds3Ext& bnd) const
     return retVal;
 }
 
+void plParallelIsect::ISetWorldBounds()
+{
+    // Three pairs of planes make a parallelepiped, anything else and
+    // we don't bother.
+    fHasWorldBounds = false;
+    if (fPlanes.size() != 3)
+        return;
+
+    const hsVector3& n0 = fPlanes[0].fNorm;
+    const hsVector3& n1 = fPlanes[1].fNorm;
+    const hsVector3& n2 = fPlanes[2].fNorm;
+    hsVector3 c12 = n1 % n2;
+    hsVector3 c20 = n2 % n0;
+    hsVector3 c01 = n0 % n1;
+    float det = n0.InnerProduct(c12);
+    if (fabs(det) < 1.e-6f)
+        return;
+
+    // Each corner is where one plane from each pair meets, solved by Cramer's rule.
+    hsPoint3 mins, maxs;
+    for (int i = 0; i < 8; i++) {
+        float d0 = (i & 1) ? fPlanes[0].fMax : fPlanes[0].fMin;
+        float d1 = (i & 2) ? fPlanes[1].fMax : fPlanes[1].fMin;
+        float d2 = (i & 4) ? fPlanes[2].fMax : fPlanes[2].fMin;
+        hsVector3 corner = (c12 * d0 + c20 * d1 + c01 * d2) / det;
+        for (int j = 0; j < 3; j++) {
+            if (i == 0 || corner[j] < mins[j])
+                mins[j] = corner[j];
+            if (i == 0 || corner[j] > maxs[j])
+                maxs[j] = corner[j];
+        }
+    }
+    IPadWorldBounds(mins, maxs, fWorldBounds);
+    fHasWorldBounds = true;
+}
+
+bool plParallelIsect::GetWorldBounds(hsBounds3Ext& bnd) const
+{
+    if (!fHasWorldBounds)
+        return false;
+    bnd = fWorldBounds;
+    return true;
+}
+
 float plParallelIsect::Test(const hsPoint3& pos) const
 {
     float maxDist = 0;
@@ -618,6 +719,7 @@ void plParallelIsect::Read(hsStream* s, hsResMgr* mgr)
         plane.fPosOne.Read(s);
         plane.fPosTwo.Read(s);
     }
+    ISetWorldBounds();
 }
 
 void plParallelIsect::Write(hsStream* s, hsResMgr* mgr)
@@ -70,6 +70,12 @@ public:
     virtual plVolumeCullResult  Test(const hsBounds3Ext& bnd) const = 0;    
     virtual float            Test(const hsPoint3& pos) const = 0;
 
+    // World space box around the volume itself. Test() is free to be loose
+    // and pass boxes that merely straddle its planes, so this can be tighter
+    // than Test(), but nothing actually inside the volume falls outside it.
+    // Returns false if the volume is unbounded (or nobody bothered).
+    virtual bool GetWorldBounds(hsBounds3Ext& bnd) const { return false; }
+
     void Read(hsStream* s, hsResMgr* mgr) override = 0;
     void Write(hsStream* s, hsResMgr* mgr) override = 0;
 };
@@ -92,11 +98,14 @@ public:
     void SetRadius(float r);
 
     float GetRadius() const { return fRadius; }
+    const hsPoint3& GetWorldMins() const { return fMins; }
+    const hsPoint3& GetWorldMaxs() const { return fMaxs; }
 
     void SetTransform(const hsMatrix44& l2w, const hsMatrix44& w2l) override;
 
     plVolumeCullResult  Test(const hsBounds3Ext& bnd) const override;
     float            Test(const hsPoint3& pos) const override; // return 0 if point inside, else "distance" from pos to volume
+    bool GetWorldBounds(hsBounds3Ext& bnd) const override;
 
     void Read(hsStream* s, hsResMgr* mgr) override;
     void Write(hsStream* s, hsResMgr* mgr) override;
@@ -119,6 +128,9 @@ protected:
     hsVector3           fNorms[5];
     float            fDists[5];
 
+    hsBounds3Ext        fWorldBounds;   // Box around the capped cone as of the last SetTransform
+    bool                fBoundsCapped;
+
     void                ISetup();
 public:
 
@@ -137,6 +149,7 @@ public:
 
     plVolumeCullResult  Test(const hsBounds3Ext& bnd) const override;
     float            Test(const hsPoint3& pos) const override;
+    bool GetWorldBounds(hsBounds3Ext& bnd) const override;
 
     void Read(hsStream* s, hsResMgr* mgr) override;
     void Write(hsStream* s, hsResMgr* mgr) override;
@@ -189,14 +202,22 @@ protected:
     };
     std::vector<ParPlane> fPlanes;
 
+    hsBounds3Ext        fWorldBounds;   // Box around the planes as of the last SetTransform
+    bool                fHasWorldBounds;
+
+    void                ISetWorldBounds();
+
 public:
-    plParallelIsect() { }
+    plParallelIsect() : fHasWorldBounds() { }
 
     CLASSNAME_REGISTER( plParallelIsect );
     GETINTERFACE_ANY( plParallelIsect, plVolumeIsect );
 
     void SetNumPlanes(size_t n); // each plane is really two parallel planes
     size_t GetNumPlanes() const { return fPlanes.size(); }
+    const hsVector3& GetPlaneNorm(size_t which) const { return fPlanes[which].fNorm; }
+    float GetPlaneMin(size_t which) const { return fPlanes[which].fMin; }
+    float GetPlaneMax(size_t which) const { return fPlanes[which].fMax; }
 
     void SetPlane(size_t which, const hsPoint3& locPosOne, const hsPoint3& locPosTwo);
 
@@ -204,6 +225,7 @@ public:
 
     plVolumeCullResult  Test(const hsBounds3Ext& bnd) const override;
     float            Test(const hsPoint3& pos) const override;
+    bool GetWorldBounds(hsBounds3Ext& bnd) const override;
 
     void Read(hsStream* s, hsResMgr* mgr) override;
     void Write(hsStream* s, hsResMgr* mgr) override;
@@ -233,6 +255,8 @@ public:
     void AddPlaneUnchecked(const hsVector3& n, float dist); // no validation here
     void AddPlane(const hsVector3& n, const hsPoint3& p);
     size_t GetNumPlanes() const { return fPlanes.size(); }
+    const hsVector3& GetWorldNorm(size_t which) const { return fPlanes[which].fWorldNorm; }
+    float GetWorldDist(size_t which) const { return fPlanes[which].fWorldDist; }
 
     void SetTransform(const hsMatrix44& l2w, const hsMatrix44& w2l) override;
 
@@ -260,6 +284,7 @@ public:
 
     plVolumeCullResult  Test(const hsBounds3Ext& bnd) const override;
     float            Test(const hsPoint3& pos) const override;
+    bool GetWorldBounds(hsBounds3Ext& bnd) const override { bnd = fWorldBounds; return true; }
 
     void Read(hsStream* s, hsResMgr* mgr) override;
     void Write(hsStream* s, hsResMgr* mgr) override;
@@ -331,6 +331,7 @@ public:
 
     bool RecordMsgs(const char* recType, const char* recName);
     bool PlaybackMsgs(const char* recName);
+    bool IsPlayingBack() const { return !fMsgPlayers.empty(); }
 
     void MakeCCRInvisible(plKey avKey, int level);
     bool CCRVaultConnected() const { return GetFlagsBit(kCCRVaultConnected); }
@@ -49,6 +49,7 @@ You can contact Cyan Worlds, Inc. by email legal@cyan.com
 #include "plgDispatch.h"
 #include "hsResMgr.h"
 #include "hsTimer.h"
+#include "plProfile.h"
 
 #include "pnKeyedObject/plKey.h"
 #include "pnMessage/plTimeMsg.h"
@@ -70,6 +71,8 @@ You can contact Cyan Worlds, Inc. by email legal@cyan.com
 
 ////////////////////////////////////////////////////////////////////////
 
+plProfile_CreateTimer("SDLState", "Update", SDLState);
+
 plNetClientMsgHandler::plNetClientMsgHandler(plNetClientMgr * mgr)
 {
     SetNetApp(mgr);
@@ -181,6 +184,8 @@ MSG_HANDLER_DEFN(plNetClientMsgHandler,plNetMsgGroupOwner)
 
 MSG_HANDLER_DEFN(plNetClientMsgHandler,plNetMsgSDLState)
 {
+    plProfile_TimingGuard(SDLState);
+
     plNetClientMgr* nc = IGetNetClientMgr();
     plNetMsgSDLState* m = plNetMsgSDLState::ConvertNoRef(netMsg);
 
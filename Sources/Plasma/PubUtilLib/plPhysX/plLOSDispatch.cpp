@@ -42,6 +42,9 @@ You can contact Cyan Worlds, Inc. by email legal@cyan.com
 
 #include "plLOSDispatch.h"
 
+#include <algorithm>
+#include <functional>
+
 #include "plgDispatch.h"
 #include "plProfile.h"
 
@@ -58,9 +61,13 @@ You can contact Cyan Worlds, Inc. by email legal@cyan.com
 #include "plStatusLog/plStatusLog.h"
 
 plProfile_CreateTimer("LineOfSight", "Simulation", LineOfSight);
+plProfile_CreateCounter("LOS Requests", "Simulation", LOSRequests);
+plProfile_CreateCounter("LOS Batches", "Simulation", LOSBatches);
+
+bool plLOSDispatch::fBatchRequests = true;
 
 plLOSDispatch::plLOSDispatch()
-    : fDebugDisplay()
+    : fDebugDisplay(), fFlushQueued()
 {
     RegisterAs(kLOSObject_KEY);
     plgDispatch::Dispatch()->RegisterForExactType(plLOSRequestMsg::Index(), GetKey());
@@ -77,39 +84,15 @@ bool plLOSDispatch::MsgReceive(plMessage* msg)
 {
     plLOSRequestMsg* requestMsg = plLOSRequestMsg::ConvertNoRef(msg);
     if (requestMsg) {
-        plProfile_BeginTiming(LineOfSight);
-
-        plKey worldKey = requestMsg->fWorldKey;
-        if (!worldKey) {
-            plArmatureMod* av = plAvatarMgr::GetInstance()->GetLocalAvatar();
-            if (av && av->GetController())
-                worldKey = av->GetController()->GetSubworld();
+        // Our own request is the signal that everyone has had their say for this dispatch.
+        if (requestMsg->GetSender() == GetKey()) {
+            IFlushRequests();
+            return true;
         }
 
-        auto result = IRaycast(requestMsg->fFrom, requestMsg->fTo, worldKey, requestMsg->fRequestType,
-                               requestMsg->GetTestType() == plLOSRequestMsg::kTestClosest,
-                               requestMsg->GetCullDB());
-        if (result.fResult == LOSResult::kHit &&
-            (requestMsg->GetReportType() == plLOSRequestMsg::kReportHit ||
-             requestMsg->GetReportType() == plLOSRequestMsg::kReportHitOrMiss)) {
-            plLOSHitMsg* hitMsg = new plLOSHitMsg(GetKey(), requestMsg->GetSender(), requestMsg->fRequestID);
-            hitMsg->fObj = result.fHitObj;
-            hitMsg->fHitPoint = result.fPoint;
-            hitMsg->fNormal = result.fNormal;
-            hitMsg->fDistance = result.fDistance;
-            hitMsg->Send();
-        } else if (result.fResult != LOSResult::kHit &&
-                   (requestMsg->GetReportType() == plLOSRequestMsg::kReportMiss ||
-                    requestMsg->GetReportType() == plLOSRequestMsg::kReportHitOrMiss)) {
-            plLOSHitMsg* missMsg = new plLOSHitMsg(GetKey(), requestMsg->GetSender(), requestMsg->fRequestID);
-            missMsg->fNoHit = true;
-            // Don't leak out any internal state, just report a miss.
-            missMsg->Send();
-        }
-
-        fRequests.emplace_back(requestMsg->GetRequestName(), requestMsg->GetRequestID(), result.fResult);
-
-        plProfile_EndTiming(LineOfSight);
+        IQueueRequest(requestMsg);
+        if (!fBatchRequests)
+            IFlushRequests();
         return true;
     }
 
@@ -160,6 +143,95 @@ bool plLOSDispatch::MsgReceive(plMessage* msg)
     return hsKeyedObject::MsgReceive(msg);
 }
 
+void plLOSDispatch::IQueueRequest(plLOSRequestMsg* requestMsg)
+{
+    plProfile_BeginTiming(LineOfSight);
+
+    plKey worldKey = requestMsg->fWorldKey;
+    if (!worldKey) {
+        plArmatureMod* av = plAvatarMgr::GetInstance()->GetLocalAvatar();
+        if (av && av->GetController())
+            worldKey = av->GetController()->GetSubworld();
+    }
+
+    PendingRequest& request = fPending.emplace_back();
+    request.fSender = requestMsg->GetSender();
+    request.fName = requestMsg->GetRequestName();
+    request.fID = requestMsg->GetRequestID();
+    request.fReportType = requestMsg->GetReportType();
+    request.fValid = IPrepareRaycast(requestMsg->fFrom, requestMsg->fTo, worldKey, requestMsg->fRequestType,
+                                     requestMsg->GetTestType() == plLOSRequestMsg::kTestClosest,
+                                     requestMsg->GetCullDB(), request.fQuery);
+
+    // Dispatch hands us this after whatever else is already in the queue,
+    // which is where most of a frame's requests come from.
+    if (fBatchRequests && !fFlushQueued) {
+        fFlushQueued = true;
+        plLOSRequestMsg* flushMsg = new plLOSRequestMsg(GetKey(), {}, {}, plSimDefs::kLOSDBNone);
+        flushMsg->SetRequestName(ST_LITERAL("(flush)"));
+        flushMsg->Send();
+    }
+
+    plProfile_EndTiming(LineOfSight);
+}
+
+void plLOSDispatch::IFlushRequests()
+{
+    fFlushQueued = false;
+    if (fPending.empty())
+        return;
+
+    plProfile_BeginTiming(LineOfSight);
+    plProfile_Inc(LOSBatches);
+    plProfile_IncCount(LOSRequests, fPending.size());
+
+    // Cast grouped by subworld so consecutive rays walk the same scene's trees.
+    fCastOrder.clear();
+    for (size_t i = 0; i < fPending.size(); ++i) {
+        if (fPending[i].fValid)
+            fCastOrder.push_back(i);
+    }
+    std::stable_sort(fCastOrder.begin(), fCastOrder.end(),
+        [this](size_t lhs, size_t rhs) {
+            return std::less<physx::PxScene*>()(fPending[lhs].fQuery.fScene, fPending[rhs].fQuery.fScene);
+        }
+    );
+    ICastPending();
+
+    // Everything that touches keys or sends messages happens here, in arrival order.
+    for (PendingRequest& request : fPending) {
+        if (request.fValid)
+            IFinishRaycast(request.fQuery, request.fResult);
+        IReply(request);
+        fRequests.emplace_back(std::move(request.fName), request.fID, request.fResult.fResult);
+    }
+    fPending.clear();
+
+    plProfile_EndTiming(LineOfSight);
+}
+
+void plLOSDispatch::IReply(const PendingRequest& request) const
+{
+    const RaycastResult& result = request.fResult;
+    if (result.fResult == LOSResult::kHit &&
+        (request.fReportType == plLOSRequestMsg::kReportHit ||
+         request.fReportType == plLOSRequestMsg::kReportHitOrMiss)) {
+        plLOSHitMsg* hitMsg = new plLOSHitMsg(GetKey(), request.fSender, request.fID);
+        hitMsg->fObj = result.fHitObj;
+        hitMsg->fHitPoint = result.fPoint;
+        hitMsg->fNormal = result.fNormal;
+        hitMsg->fDistance = result.fDistance;
+        hitMsg->Send();
+    } else if (result.fResult != LOSResult::kHit &&
+               (request.fReportType == plLOSRequestMsg::kReportMiss ||
+                request.fReportType == plLOSRequestMsg::kReportHitOrMiss)) {
+        plLOSHitMsg* missMsg = new plLOSHitMsg(GetKey(), request.fSender, request.fID);
+        missMsg->fNoHit = true;
+        // Don't leak out any internal state, just report a miss.
+        missMsg->Send();
+    }
+}
+
 bool plLOSDispatch::ITestHit(const plSceneObject* so) const
 {
     for (size_t i = 0; i < so->GetNumModifiers(); ++i) {
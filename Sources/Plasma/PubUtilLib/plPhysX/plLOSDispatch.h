@@ -42,26 +42,39 @@ You can contact Cyan Worlds, Inc. by email legal@cyan.com
 #ifndef plLOSDispatch_H
 #define plLOSDispatch_H
 
+#include <cfloat>
 #include <vector>
 #include <string_theory/string>
 
 #include "hsGeometry3.h"
+#include "hsMatrix44.h"
 
 #include "pnKeyedObject/hsKeyedObject.h"
 
 #include "plPhysical/plSimDefs.h"
 
 class plLOSRequestMsg;
-struct hsMatrix44;
+class plPXActorData;
 class plSceneObject;
 class plStatusLog;
 
+namespace physx
+{
+    class PxScene;
+}
+
 /** \class plLOSDispatch
     Line-of-sight requests are sent to this guy, who then hands them
     to the appropriate solvers, which can vary depending on such
     criteria as which subworld the player is currently in.
     Eventually we will have more variants of requests, such as 
-    "search all subworlds," etc.  */
+    "search all subworlds," etc.
+
+    Requests are not cast as they arrive. They are queued until everyone
+    has had a chance to make theirs for the current dispatch, then cast
+    as one batch grouped by subworld, spread over the PhysX worker threads
+    when there are any. Replies still go out in the order the requests
+    came in.  */
 class plLOSDispatch : public hsKeyedObject
 {
 protected:
@@ -74,6 +87,7 @@ protected:
 
 private:
     friend class plPXRaycastQueryFilter;
+    friend class plPXRaycastTask;
 
     struct LOSRequest
     {
@@ -91,6 +105,8 @@ private:
     plStatusLog* fDebugDisplay;
     std::vector<LOSRequest> fRequests;
 
+    static bool fBatchRequests;
+
 public:
     plLOSDispatch();
     ~plLOSDispatch();
@@ -100,9 +116,26 @@ public:
 
     bool MsgReceive(plMessage* msg) override;
 
+    /** Batching can be turned off to cast each request as soon as it arrives. */
+    static void SetBatchRequests(bool on) { fBatchRequests = on; }
+    static bool GetBatchRequests() { return fBatchRequests; }
+
 protected:
     bool ITestHit(const plSceneObject* obj) const;
 
+    /** A raycast resolved into its subworld's space, ready to be cast on any thread. */
+    struct RaycastQuery
+    {
+        physx::PxScene* fScene;
+        hsMatrix44 fL2W;
+        hsPoint3 fOrigin;
+        hsVector3 fDirection;
+        float fMagnitude;
+        plSimDefs::plLOSDB fDB;
+        plSimDefs::plLOSDB fCullDB;
+        bool fClosest;
+    };
+
     struct RaycastResult
     {
         LOSResult fResult;
@@ -111,13 +144,53 @@ protected:
         hsVector3 fNormal;
         float fDistance;
 
+        // Set by the cast, turned into fHitObj back on the main thread
+        const plPXActorData* fHitData;
+
         RaycastResult(LOSResult result, plKey hit = {}, const hsPoint3& point = { 0.f, 0.f, 0.f },
                       const hsVector3& normal = { 0.f, 0.f, 0.f }, float dist = 0.f)
             : fResult(result), fHitObj(std::move(hit)), fPoint(point),
-              fNormal(normal), fDistance(dist)
+              fNormal(normal), fDistance(dist), fHitData()
         { }
     };
 
+    struct PendingRequest
+    {
+        plKey fSender;
+        ST::string fName;
+        uint32_t fID;
+        uint8_t fReportType;
+        bool fValid;
+        RaycastQuery fQuery;
+        RaycastResult fResult;
+
+        PendingRequest()
+            : fID(), fReportType(), fValid(), fQuery(),
+              fResult(LOSResult::kMiss, nullptr, { 0.f, 0.f, 0.f }, { 0.f, 0.f, 0.f }, FLT_MAX)
+        { }
+    };
+
+    std::vector<PendingRequest> fPending;
+    std::vector<size_t> fCastOrder;
+    bool fFlushQueued;
+
+    void IQueueRequest(plLOSRequestMsg* requestMsg);
+    void IFlushRequests();
+    void IReply(const PendingRequest& request) const;
+
+    /** Main thread: finds the scene and moves the ray into subworld space. */
+    bool IPrepareRaycast(hsPoint3 origin, hsPoint3 destination, const plKey& world, plSimDefs::plLOSDB db,
+                         bool closest, plSimDefs::plLOSDB cullDB, RaycastQuery& query) const;
+
+    /** Any thread: casts a prepared ray. Must not touch anything refcounted. */
+    void ICastRay(const RaycastQuery& query, RaycastResult& result) const;
+
+    /** Main thread: resolves the hit key and moves the hit back to world space. */
+    void IFinishRaycast(const RaycastQuery& query, RaycastResult& result) const;
+
+    /** Casts the pending requests listed in fCastOrder, in parallel if possible. */
+    void ICastPending();
+
     RaycastResult IRaycast(hsPoint3 origin, hsPoint3 destination, const plKey& world, plSimDefs::plLOSDB db,
                            bool closest, plSimDefs::plLOSDB cullDB = plSimDefs::kLOSDBNone);
 };
@@ -41,6 +41,7 @@ You can contact Cyan Worlds, Inc. by email legal@cyan.com
 *==LICENSE==*/
 
 #include "plPXCooking.h"
+#include "plPhysXAPI.h"
 #include "hsGeometry3.h"
 #include "hsStream.h"
 #include <string_theory/format>
@@ -290,6 +291,38 @@ void plPXCooking::ReadTriMesh26(hsStream* s, std::vector<uint32_t>& tris, std::v
 
 // ==========================================================================
 
+physx::PxConvexMeshDesc plPXCooking::ConvexHullDesc(const std::vector<uint32_t>& tris,
+                                                     const std::vector<hsPoint3>& verts)
+{
+    physx::PxConvexMeshDesc desc;
+    desc.indices.count = tris.size();
+    desc.indices.stride = sizeof(uint32_t);
+    desc.indices.data = tris.empty() ? nullptr : &tris[0];
+    desc.points.count = verts.size();
+    desc.points.stride = sizeof(hsPoint3);
+    desc.points.data = &verts[0];
+    desc.flags = physx::PxConvexFlag::eDISABLE_MESH_VALIDATION |
+                 physx::PxConvexFlag::eFAST_INERTIA_COMPUTATION;
+    if (tris.empty())
+        desc.flags |= physx::PxConvexFlag::eCOMPUTE_CONVEX;
+    return desc;
+}
+
+physx::PxTriangleMeshDesc plPXCooking::TriMeshDesc(const std::vector<uint32_t>& tris,
+                                                   const std::vector<hsPoint3>& verts)
+{
+    physx::PxTriangleMeshDesc desc;
+    desc.points.count = verts.size();
+    desc.points.stride = sizeof(hsPoint3);
+    desc.points.data = &verts[0];
+    desc.triangles.count = tris.size() / 3;
+    desc.triangles.stride = sizeof(uint32_t) * 3;
+    desc.triangles.data = &tris[0];
+    return desc;
+}
+
+// ==========================================================================
+
 void plPXCooking::WriteConvexHull(hsStream* s, uint32_t nverts, const hsPoint3* const verts)
 {
     s->Write(4, "HSP\x01");
@@ -49,6 +49,12 @@ You can contact Cyan Worlds, Inc. by email legal@cyan.com
 class hsStream;
 struct hsPoint3;
 
+namespace physx
+{
+    class PxConvexMeshDesc;
+    class PxTriangleMeshDesc;
+};
+
 class plPXCookingException : public std::runtime_error
 {
 public:
@@ -76,6 +82,17 @@ public:
     /** Uncooks a PhysX 2.6 triangle mesh. */
     static void ReadTriMesh26(hsStream* s, std::vector<uint32_t>& tris, std::vector<hsPoint3>& verts);
 
+    /**
+     * Describes a convex hull for the PhysX cooker.
+     * If no triangles are given, PhysX will compute the hull from the vertices.
+     */
+    static physx::PxConvexMeshDesc ConvexHullDesc(const std::vector<uint32_t>& tris,
+                                                  const std::vector<hsPoint3>& verts);
+
+    /** Describes a triangle mesh for the PhysX cooker. */
+    static physx::PxTriangleMeshDesc TriMeshDesc(const std::vector<uint32_t>& tris,
+                                                 const std::vector<hsPoint3>& verts);
+
     /** Writes an uncooked convex hull. */
     static void WriteConvexHull(hsStream* s, uint32_t nverts, const hsPoint3* const verts);
 
@@ -0,0 +1,305 @@
+/*==LICENSE==*
+
+CyanWorlds.com Engine - MMOG client, server and tools
+Copyright (C) 2011  Cyan Worlds, Inc.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+Additional permissions under GNU GPL version 3 section 7
+
+If you modify this Program, or any covered work, by linking or
+combining it with any of RAD Game Tools Bink SDK, Autodesk 3ds Max SDK,
+NVIDIA PhysX SDK, Microsoft DirectX SDK, OpenSSL library, Independent
+JPEG Group JPEG library, Microsoft Windows Media SDK, or Apple QuickTime SDK
+(or a modified version of those libraries),
+containing parts covered by the terms of the Bink SDK EULA, 3ds Max EULA,
+PhysX SDK EULA, DirectX SDK EULA, OpenSSL and SSLeay licenses, IJG
+JPEG Library README, Windows Media SDK EULA, or QuickTime SDK EULA, the
+licensors of this Program grant you additional
+permission to convey the resulting work. Corresponding Source for a
+non-source form of such a combination shall include the source code for
+the parts of OpenSSL and IJG JPEG Library used as well as that of the covered
+work.
+
+You can contact Cyan Worlds, Inc. by email legal@cyan.com
+ or by snail mail at:
+      Cyan Worlds, Inc.
+      14617 N Newport Hwy
+      Mead, WA   99021
+
+*==LICENSE==*/
+#include "plPXCookingCache.h"
+#include "plPhysXAPI.h"
+
+#include "hsGeometry3.h"
+#include "hsStream.h"
+
+#include "pnEncryption/plChecksum.h"
+
+#include "plStatusLog/plStatusLog.h"
+
+#include <algorithm>
+#include <string_theory/format>
+#include <string_theory/string_stream>
+
+// ==========================================================================
+
+/** Bump this whenever the cooking parameters or mesh descriptors change */
+constexpr uint32_t kCookingCacheVersion = 1;
+
+/** Header of a cached mesh file, followed by the PhysX serialized mesh */
+constexpr char kCookingCacheMagic[4] = { 'P', 'X', 'C', 'C' };
+
+// ==========================================================================
+
+plPXCookingCache::Key::Key(MeshType type, const std::vector<uint32_t>& tris,
+                           const std::vector<hsPoint3>& verts)
+{
+    static_assert(sizeof(fDigest) == sizeof(ShaDigest), "Key digest size mismatch");
+
+    uint32_t header[] = {
+        kCookingCacheVersion,
+        PX_PHYSICS_VERSION,
+        (uint32_t)type,
+        (uint32_t)tris.size(),
+        (uint32_t)verts.size(),
+    };
+
+    // Hash the vertices component-wise so padding in hsPoint3 never leaks into the key.
+    std::vector<float> coords;
+    coords.reserve(verts.size() * 3);
+    for (const hsPoint3& vert : verts) {
+        coords.push_back(vert.fX);
+        coords.push_back(vert.fY);
+        coords.push_back(vert.fZ);
+    }
+
+    plSHA1Checksum sum;
+    sum.Start();
+    sum.AddTo(sizeof(header), reinterpret_cast<const uint8_t*>(header));
+    sum.AddTo(tris.size() * sizeof(uint32_t), reinterpret_cast<const uint8_t*>(tris.data()));
+    sum.AddTo(coords.size() * sizeof(float), reinterpret_cast<const uint8_t*>(coords.data()));
+    sum.Finish();
+    memcpy(fDigest, sum.GetValue(), sizeof(fDigest));
+}
+
+ST::string plPXCookingCache::Key::AsString() const
+{
+    ST::string_stream ss;
+    for (uint8_t byte : fDigest)
+        ss << ST::format("{02x}", (unsigned int)byte);
+    return ss.to_string();
+}
+
+// ==========================================================================
+
+plPXCookingCache::plPXCookingCache(physx::PxPhysics* physics)
+    : fPhysics(physics), fWriteRunning(false), fCacheSize(),
+      fHits(), fMisses(), fCookMs()
+{
+}
+
+plPXCookingCache::~plPXCookingCache()
+{
+    if (fWriteThread.joinable()) {
+        fWriteRunning = false;
+        fWriteEvent.Signal();
+        fWriteThread.join();
+    }
+}
+
+bool plPXCookingCache::Init(const plFileName& path)
+{
+    if (!plFileSystem::CreateDir(path, true)) {
+        plStatusLog::AddLineSF("Simulation.log", plStatusLog::kRed,
+                               "Unable to create collision cache directory '{}'", path);
+        return false;
+    }
+
+    fPath = path;
+    plStatusLog::AddLineSF("Simulation.log", "Using collision cache in '{}'", fPath);
+
+    // The write thread starts by cleaning up after the last session
+    fWriteRunning = true;
+    fWriteThread = hsThread::StartSimpleThread([this] { IWriteProc(); });
+    return true;
+}
+
+plFileName plPXCookingCache::IGetFileName(const ST::string& name) const
+{
+    return plFileName::Join(fPath, ST::format("{}.pxc", name));
+}
+
+// ==========================================================================
+
+bool plPXCookingCache::IReadCooked(const Key& key, MeshType type, std::vector<uint8_t>& cooked) const
+{
+    hsUNIXStream s;
+    if (!s.Open(IGetFileName(key.AsString()), "rb"))
+        return false;
+
+    char magic[sizeof(kCookingCacheMagic)];
+    s.Read(sizeof(magic), magic);
+    if (memcmp(magic, kCookingCacheMagic, sizeof(magic)) != 0)
+        return false;
+    if (s.ReadLE32() != PX_PHYSICS_VERSION || s.ReadByte() != (uint8_t)type)
+        return false;
+
+    uint32_t size = s.GetEOF() - s.GetPosition();
+    if (size == 0)
+        return false;
+    cooked.resize(size);
+    return s.Read(size, cooked.data()) == size;
+}
+
+physx::PxConvexMesh* plPXCookingCache::FindConvexHull(const Key& key)
+{
+    std::vector<uint8_t> cooked;
+    if (fPath.IsValid() && IReadCooked(key, MeshType::kConvexHull, cooked)) {
+        physx::PxDefaultMemoryInputData input(cooked.data(), cooked.size());
+        if (physx::PxConvexMesh* mesh = fPhysics->createConvexMesh(input)) {
+            ++fHits;
+            return mesh;
+        }
+    }
+
+    ++fMisses;
+    return nullptr;
+}
+
+physx::PxTriangleMesh* plPXCookingCache::FindTriangleMesh(const Key& key)
+{
+    std::vector<uint8_t> cooked;
+    if (fPath.IsValid() && IReadCooked(key, MeshType::kTriangleMesh, cooked)) {
+        physx::PxDefaultMemoryInputData input(cooked.data(), cooked.size());
+        if (physx::PxTriangleMesh* mesh = fPhysics->createTriangleMesh(input)) {
+            ++fHits;
+            return mesh;
+        }
+    }
+
+    ++fMisses;
+    return nullptr;
+}
+
+// ==========================================================================
+
+void plPXCookingCache::Store(const Key& key, MeshType type, const uint8_t* cooked, size_t size,
+                             float cookMs)
+{
+    fCookMs += cookMs;
+    if (!fWriteThread.joinable())
+        return;
+
+    {
+        hsLockGuard(fWriteMutex);
+        fWriteJobs.push_back({ key.AsString(), type, std::vector<uint8_t>(cooked, cooked + size) });
+    }
+    fWriteEvent.Signal();
+}
+
+void plPXCookingCache::IWriteProc()
+{
+    ITrim();
+
+    while (fWriteRunning) {
+        fWriteEvent.Wait();
+
+        std::vector<Job> jobs;
+        {
+            hsLockGuard(fWriteMutex);
+            jobs.swap(fWriteJobs);
+        }
+
+        for (const Job& job : jobs) {
+            if (!fWriteRunning)
+                break;
+            IWrite(job);
+        }
+
+        if (fCacheSize > kMaxCacheSize)
+            ITrim();
+    }
+}
+
+void plPXCookingCache::IWrite(const Job& job)
+{
+    // Write to a temporary file first so a crash never leaves a truncated mesh behind.
+    plFileName fileName = IGetFileName(job.fName);
+    plFileName tempName = plFileName::Join(fPath, ST::format("{}.tmp", job.fName));
+    {
+        hsUNIXStream s;
+        if (!s.Open(tempName, "wb"))
+            return;
+        s.Write(sizeof(kCookingCacheMagic), kCookingCacheMagic);
+        s.WriteLE32(PX_PHYSICS_VERSION);
+        s.WriteByte((uint8_t)job.fType);
+        s.Write(job.fCooked.size(), job.fCooked.data());
+    }
+
+    if (plFileSystem::Move(tempName, fileName)) {
+        fCacheSize += sizeof(kCookingCacheMagic) + sizeof(uint32_t) + sizeof(uint8_t) + job.fCooked.size();
+    } else {
+        plStatusLog::AddLineSF("Simulation.log", plStatusLog::kRed,
+                               "Failed to store collision mesh {} in the cache", job.fName);
+        plFileSystem::Unlink(tempName);
+    }
+}
+
+void plPXCookingCache::ITrim()
+{
+    // Anything left half written by a crash
+    for (const plFileName& tempName : plFileSystem::ListDir(fPath, "*.tmp"))
+        plFileSystem::Unlink(tempName);
+
+    std::vector<plFileInfo> files;
+    fCacheSize = 0;
+    for (const plFileName& fileName : plFileSystem::ListDir(fPath, "*.pxc")) {
+        files.emplace_back(fileName);
+        fCacheSize += files.back().FileSize();
+    }
+    if (fCacheSize <= kMaxCacheSize)
+        return;
+
+    // Throw out the oldest meshes until we're back to three quarters of the
+    // limit, so a full cache doesn't trim itself after every write.
+    std::sort(files.begin(), files.end(), [](const plFileInfo& a, const plFileInfo& b) {
+        return a.ModifyTime() < b.ModifyTime();
+    });
+    size_t removed = 0;
+    for (const plFileInfo& info : files) {
+        if (fCacheSize <= kMaxCacheSize / 4 * 3)
+            break;
+        if (plFileSystem::Unlink(info.FileName())) {
+            fCacheSize -= info.FileSize();
+            removed++;
+        }
+    }
+    plStatusLog::AddLineSF("Simulation.log", "Removed {} old mesh(es) from the collision cache", removed);
+}
+
+// ==========================================================================
+
+void plPXCookingCache::ReportStats()
+{
+    if (fHits == 0 && fMisses == 0)
+        return;
+
+    plStatusLog::AddLineSF("Simulation.log",
+                           "Collision cache: {} hit(s), {} miss(es), {.1f} ms spent cooking",
+                           fHits, fMisses, fCookMs);
+    fHits = 0;
+    fMisses = 0;
+    fCookMs = 0.f;
+}
@@ -0,0 +1,153 @@
+/*==LICENSE==*
+
+CyanWorlds.com Engine - MMOG client, server and tools
+Copyright (C) 2011  Cyan Worlds, Inc.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+Additional permissions under GNU GPL version 3 section 7
+
+If you modify this Program, or any covered work, by linking or
+combining it with any of RAD Game Tools Bink SDK, Autodesk 3ds Max SDK,
+NVIDIA PhysX SDK, Microsoft DirectX SDK, OpenSSL library, Independent
+JPEG Group JPEG library, Microsoft Windows Media SDK, or Apple QuickTime SDK
+(or a modified version of those libraries),
+containing parts covered by the terms of the Bink SDK EULA, 3ds Max EULA,
+PhysX SDK EULA, DirectX SDK EULA, OpenSSL and SSLeay licenses, IJG
+JPEG Library README, Windows Media SDK EULA, or QuickTime SDK EULA, the
+licensors of this Program grant you additional
+permission to convey the resulting work. Corresponding Source for a
+non-source form of such a combination shall include the source code for
+the parts of OpenSSL and IJG JPEG Library used as well as that of the covered
+work.
+
+You can contact Cyan Worlds, Inc. by email legal@cyan.com
+ or by snail mail at:
+      Cyan Worlds, Inc.
+      14617 N Newport Hwy
+      Mead, WA   99021
+
+*==LICENSE==*/
+#ifndef plPXCookingCache_h_inc
+#define plPXCookingCache_h_inc
+
+#include "HeadSpin.h"
+#include "plFileSystem.h"
+#include "hsThread.h"
+
+#include <atomic>
+#include <mutex>
+#include <string_theory/string>
+#include <thread>
+#include <vector>
+
+struct hsPoint3;
+
+namespace physx
+{
+    class PxConvexMesh;
+    class PxPhysics;
+    class PxTriangleMesh;
+};
+
+/**
+ * On-disk cache of cooked PhysX collision meshes.
+ * Cooking the legacy PhysX 2.6 meshes stored in the PRPs is expensive, so the serialized output
+ * of the PhysX cooker is kept in the user data directory, keyed by a hash of the source geometry
+ * and the PhysX SDK version. Meshes that are not in the cache are cooked once by the caller, who
+ * creates the mesh from the cooked data and hands that same data to the cache, which writes it
+ * out on a background thread. The oldest meshes are removed once the cache grows past
+ * kMaxCacheSize.
+ */
+class plPXCookingCache
+{
+public:
+    enum class MeshType : uint8_t
+    {
+        kConvexHull,
+        kTriangleMesh,
+    };
+
+    static constexpr uint64_t kMaxCacheSize = 256 * 1024 * 1024;
+
+    /** Identifies a cooked mesh by its source geometry, mesh type, and the PhysX version. */
+    class Key
+    {
+        uint8_t fDigest[20];
+
+    public:
+        Key(MeshType type, const std::vector<uint32_t>& tris, const std::vector<hsPoint3>& verts);
+
+        [[nodiscard]]
+        ST::string AsString() const;
+    };
+
+protected:
+    struct Job
+    {
+        ST::string fName;
+        MeshType fType;
+        std::vector<uint8_t> fCooked;
+    };
+
+    physx::PxPhysics* fPhysics;
+    plFileName fPath;
+
+    std::thread fWriteThread;
+    hsEvent fWriteEvent;
+    std::mutex fWriteMutex;
+    std::vector<Job> fWriteJobs;
+    std::atomic<bool> fWriteRunning;
+    uint64_t fCacheSize;    // Only touched by the write thread
+
+    uint32_t fHits;
+    uint32_t fMisses;
+    float fCookMs;
+
+    plFileName IGetFileName(const ST::string& name) const;
+    bool IReadCooked(const Key& key, MeshType type, std::vector<uint8_t>& cooked) const;
+    void IWriteProc();
+    void IWrite(const Job& job);
+    void ITrim();
+
+public:
+    plPXCookingCache(physx::PxPhysics* physics);
+    plPXCookingCache(const plPXCookingCache&) = delete;
+    plPXCookingCache(plPXCookingCache&&) = delete;
+
+    /** Stops the write thread. Any meshes still waiting to be written are dropped. */
+    ~plPXCookingCache();
+
+    /** Sets up the cache directory. Returns false if the cache cannot be used. */
+    bool Init(const plFileName& path);
+
+    /** Loads a cooked convex hull from the cache, or nullptr if it is not cached. */
+    [[nodiscard]]
+    physx::PxConvexMesh* FindConvexHull(const Key& key);
+
+    /** Loads a cooked triangle mesh from the cache, or nullptr if it is not cached. */
+    [[nodiscard]]
+    physx::PxTriangleMesh* FindTriangleMesh(const Key& key);
+
+    /**
+     * Queues the cooked mesh data to be written out on the background thread.
+     * \param cookMs The time the caller spent cooking the mesh.
+     */
+    void Store(const Key& key, MeshType type, const uint8_t* cooked, size_t size, float cookMs);
+
+    /** Writes the hit/miss statistics since the last report to the simulation log and resets them. */
+    void ReportStats();
+};
+
+#endif
@@ -40,6 +40,10 @@ You can contact Cyan Worlds, Inc. by email legal@cyan.com
 
 *==LICENSE==*/
 #include "plLOSDispatch.h"
+
+#include <algorithm>
+#include <atomic>
+
 #include "plPhysXAPI.h"
 #include "plPXConvert.h"
 #include "plPXPhysical.h"
@@ -49,6 +53,7 @@ You can contact Cyan Worlds, Inc. by email legal@cyan.com
 #include "plSimulationMgr.h"
 
 #include "hsGeometry3.h"
+#include "hsThread.h"
 #include "hsMatrix44.h"
 
 #include "pnSceneObject/plSceneObject.h"
@@ -56,91 +61,153 @@ You can contact Cyan Worlds, Inc. by email legal@cyan.com
 
 // ==========================================================================
 
-plLOSDispatch::RaycastResult plLOSDispatch::IRaycast(hsPoint3 origin, hsPoint3 destination,
-                                                     const plKey& world, plSimDefs::plLOSDB db,
-                                                     bool closest, plSimDefs::plLOSDB cullDB)
+class plPXRaycastQueryFilter : public physx::PxQueryFilterCallback
 {
-    RaycastResult result(LOSResult::kMiss, nullptr, { 0.f, 0.f, 0.f }, { 0.f, 0.f, 0.f }, FLT_MAX);
+    const plLOSDispatch* fDispatch;
+    plSimDefs::plLOSDB fCullDB;
+
+public:
+    plPXRaycastQueryFilter(const plLOSDispatch* self, plSimDefs::plLOSDB cullDB)
+        : fDispatch(self), fCullDB(cullDB)
+    { }
+
+    physx::PxQueryHitType::Enum preFilter(const physx::PxFilterData& filterData,
+                                          const physx::PxShape* shape,
+                                          const physx::PxRigidActor* actor,
+                                          physx::PxHitFlags& queryFlags) override
+    {
+        auto data = static_cast<plPXActorData*>(actor->userData);
+        if (!data)
+            return physx::PxQueryHitType::eNONE;
+
+        // Disabled physicals aren't hit.
+        if (data->GetPhysical() && data->GetPhysical()->GetProperty(plSimulationInterface::kDisable))
+            return physx::PxQueryHitType::eNONE;
+        if (data->GetController() && !data->GetController()->IsEnabled())
+            return physx::PxQueryHitType::eNONE;
+
+        if (plSceneObject* so = plSceneObject::ConvertNoRef(data->GetKey()->ObjectIsLoaded())){
+            if (!fDispatch->ITestHit(so))
+                return physx::PxQueryHitType::eNONE;
+        }
+
+        // Ensures all hits are returned.
+        return physx::PxQueryHitType::eTOUCH;
+    }
+
+    physx::PxQueryHitType::Enum postFilter(const physx::PxFilterData& filterData,
+                                           const physx::PxQueryHit& hit) override
+    {
+        // If we are culling the LOS hits, any cull hit should prevent touches beyond that hit.
+        if (fCullDB != plSimDefs::kLOSDBNone) {
+            if (static_cast<const plPXFilterData&>(filterData).TestLOSDBs(fCullDB))
+                return physx::PxQueryHitType::eBLOCK;
+        }
+
+        return physx::PxQueryHitType::eTOUCH;
+    }
+};
+
+// ==========================================================================
+
+/**
+ * Casts a slice of the pending LOS requests on a PhysX worker thread.
+ * The last task to be released wakes up the main thread. This happens in release()
+ * rather than run() because the dispatcher still touches the task after running it.
+ */
+class plPXRaycastTask : public physx::PxLightCpuTask
+{
+    plLOSDispatch* fDispatch;
+    const size_t* fBegin;
+    const size_t* fEnd;
+    std::atomic<size_t>* fRemaining;
+    hsSemaphore* fDone;
+
+public:
+    plPXRaycastTask()
+        : fDispatch(), fBegin(), fEnd(), fRemaining(), fDone()
+    { }
+
+    void Set(plLOSDispatch* dispatch, const size_t* begin, const size_t* end,
+             std::atomic<size_t>* remaining, hsSemaphore* done)
+    {
+        fDispatch = dispatch;
+        fBegin = begin;
+        fEnd = end;
+        fRemaining = remaining;
+        fDone = done;
+    }
+
+    void Cast() const
+    {
+        for (const size_t* it = fBegin; it != fEnd; ++it) {
+            plLOSDispatch::PendingRequest& request = fDispatch->fPending[*it];
+            fDispatch->ICastRay(request.fQuery, request.fResult);
+        }
+    }
+
+    void run() override { Cast(); }
+
+    void release() override
+    {
+        physx::PxLightCpuTask::release();
+        if (--(*fRemaining) == 0)
+            fDone->Signal();
+    }
 
+    const char* getName() const override { return "plPXRaycastTask"; }
+};
+
+// ==========================================================================
+
+bool plLOSDispatch::IPrepareRaycast(hsPoint3 origin, hsPoint3 destination, const plKey& world,
+                                    plSimDefs::plLOSDB db, bool closest, plSimDefs::plLOSDB cullDB,
+                                    RaycastQuery& query) const
+{
     plPXSimulation* sim = plSimulationMgr::GetInstance()->GetPhysX();
-    physx::PxScene* scene = sim->FindScene(world);
-    if (!scene)
-        return result;
+    query.fScene = sim->FindScene(world);
+    if (!query.fScene)
+        return false;
 
     // The raycast comes in as worldspace, but if the player is in a subworld, we'll need
     // to convert it to subworld space.
-    hsMatrix44 l2w;
-    l2w.Reset();
+    query.fL2W.Reset();
     if (world) {
         if (plSceneObject* so = plSceneObject::ConvertNoRef(world->ObjectIsLoaded())) {
-            l2w = so->GetLocalToWorld();
+            query.fL2W = so->GetLocalToWorld();
             origin = so->GetWorldToLocal() * origin;
             destination = so->GetWorldToLocal() * destination;
         }
     }
 
-    hsVector3 direction = hsVector3(destination - origin);
-    float magnitude = direction.Magnitude();
-    if (magnitude <= 0.f)
-        return result;
-    direction.Normalize();
+    query.fDirection = hsVector3(destination - origin);
+    query.fMagnitude = query.fDirection.Magnitude();
+    if (query.fMagnitude <= 0.f)
+        return false;
+    query.fDirection.Normalize();
+
+    query.fOrigin = origin;
+    query.fDB = db;
+    query.fCullDB = cullDB;
+    query.fClosest = closest;
+    return true;
+}
 
+void plLOSDispatch::ICastRay(const RaycastQuery& query, RaycastResult& result) const
+{
     plPXFilterData data;
-    data.SetLOSDBs((plSimDefs::plLOSDB)((physx::PxU32)db | (physx::PxU32)cullDB));
+    data.SetLOSDBs((plSimDefs::plLOSDB)((physx::PxU32)query.fDB | (physx::PxU32)query.fCullDB));
     physx::PxQueryFilterData filter(data, physx::PxQueryFlag::eSTATIC |
                                           physx::PxQueryFlag::eDYNAMIC |
                                           physx::PxQueryFlag::ePREFILTER |
                                           physx::PxQueryFlag::ePOSTFILTER);
-    if (!closest)
+    if (!query.fClosest)
         filter.flags |= physx::PxQueryFlag::eANY_HIT;
 
-    class plPXRaycastQueryFilter : public physx::PxQueryFilterCallback
-    {
-        plLOSDispatch* fDispatch;
-        plSimDefs::plLOSDB fCullDB;
-
-    public:
-        plPXRaycastQueryFilter(plLOSDispatch* self, plSimDefs::plLOSDB cullDB)
-            : fDispatch(self), fCullDB(cullDB)
-        { }
-
-        physx::PxQueryHitType::Enum preFilter(const physx::PxFilterData& filterData,
-                                              const physx::PxShape* shape,
-                                              const physx::PxRigidActor* actor,
-                                              physx::PxHitFlags& queryFlags) override
-        {
-            auto data = static_cast<plPXActorData*>(actor->userData);
-            if (!data)
-                return physx::PxQueryHitType::eNONE;
-
-            // Disabled physicals aren't hit.
-            if (data->GetPhysical() && data->GetPhysical()->GetProperty(plSimulationInterface::kDisable))
-                return physx::PxQueryHitType::eNONE;
-            if (data->GetController() && !data->GetController()->IsEnabled())
-                return physx::PxQueryHitType::eNONE;
-
-            if (plSceneObject* so = plSceneObject::ConvertNoRef(data->GetKey()->ObjectIsLoaded())){
-                if (!fDispatch->ITestHit(so))
-                    return physx::PxQueryHitType::eNONE;
-            }
-
-            // Ensures all hits are returned.
-            return physx::PxQueryHitType::eTOUCH;
-        }
-
-        physx::PxQueryHitType::Enum postFilter(const physx::PxFilterData& filterData,
-                                               const physx::PxQueryHit& hit) override
-        {
-            // If we are culling the LOS hits, any cull hit should prevent touches beyond that hit.
-            if (fCullDB != plSimDefs::kLOSDBNone) {
-                if (static_cast<const plPXFilterData&>(filterData).TestLOSDBs(fCullDB))
-                    return physx::PxQueryHitType::eBLOCK;
-            }
-
-            return physx::PxQueryHitType::eTOUCH;
-        }
-    } filterCallback(this, cullDB);
+    plPXRaycastQueryFilter filterCallback(this, query.fCullDB);
 
+    // Only the actor data is recorded here -- copying the key would bump its
+    // refcount, which isn't safe off the main thread.
     class plPXRaycastCallback : public physx::PxRaycastCallback
     {
         RaycastResult& fResult;
@@ -159,9 +226,8 @@ plLOSDispatch::RaycastResult plLOSDispatch::IRaycast(hsPoint3 origin, hsPoint3 d
             for (physx::PxU32 i = 0; i < nbHits; ++i) {
                 const physx::PxRaycastHit& hit = hits[i];
                 if (hit.distance < fResult.fDistance && hit.distance != 0.f) {
-                    auto data = static_cast<plPXActorData*>(hit.actor->userData);
                     fResult.fResult = LOSResult::kHit;
-                    fResult.fHitObj = data->GetKey();
+                    fResult.fHitData = static_cast<const plPXActorData*>(hit.actor->userData);
                     fResult.fPoint = plPXConvert::Point(hit.position);
                     fResult.fNormal = plPXConvert::Vector(hit.normal);
                     fResult.fDistance = hit.distance;
@@ -187,26 +253,80 @@ plLOSDispatch::RaycastResult plLOSDispatch::IRaycast(hsPoint3 origin, hsPoint3 d
             }
 
             if (block.distance < fResult.fDistance && block.distance != 0.f) {
-                auto data = static_cast<plPXActorData*>(block.actor->userData);
                 fResult.fResult = LOSResult::kHit;
-                fResult.fHitObj = data->GetKey();
+                fResult.fHitData = static_cast<const plPXActorData*>(block.actor->userData);
                 fResult.fPoint = plPXConvert::Point(block.position);
                 fResult.fNormal = plPXConvert::Vector(block.normal);
                 fResult.fDistance = block.distance;
             }
         }
-    } raycast(result, cullDB);
+    } raycast(result, query.fCullDB);
 
-    bool hit = scene->raycast(plPXConvert::Point(origin),
-                              plPXConvert::Vector(direction),
-                              magnitude, raycast,
-                              (physx::PxHitFlag::ePOSITION | physx::PxHitFlag::eNORMAL),
-                              filter, &filterCallback);
+    query.fScene->raycast(plPXConvert::Point(query.fOrigin),
+                          plPXConvert::Vector(query.fDirection),
+                          query.fMagnitude, raycast,
+                          (physx::PxHitFlag::ePOSITION | physx::PxHitFlag::eNORMAL),
+                          filter, &filterCallback);
+}
+
+void plLOSDispatch::IFinishRaycast(const RaycastQuery& query, RaycastResult& result) const
+{
+    if (result.fHitData) {
+        result.fHitObj = result.fHitData->GetKey();
+        result.fHitData = nullptr;
+    }
 
     // Convert back to worldspace
-    if (hit) {
-        result.fPoint = l2w * result.fPoint;
-        result.fNormal = l2w * result.fNormal;
+    if (result.fResult == LOSResult::kHit) {
+        result.fPoint = query.fL2W * result.fPoint;
+        result.fNormal = query.fL2W * result.fNormal;
+    }
+}
+
+void plLOSDispatch::ICastPending()
+{
+    // Below this, waking the workers costs more than the rays themselves.
+    constexpr size_t kRaysPerTask = 16;
+    constexpr size_t kMaxTasks = 16;
+
+    plPXSimulation* sim = plSimulationMgr::GetInstance()->GetPhysX();
+    physx::PxDefaultCpuDispatcher* cpu = sim->GetCpuDispatcher();
+    size_t numWorkers = cpu ? cpu->getWorkerCount() : 0;
+
+    // An overlapped step already has the workers busy, so don't queue up behind it.
+    size_t numTasks = std::min({ numWorkers + 1, kMaxTasks, fCastOrder.size() / kRaysPerTask });
+    if (numTasks <= 1 || sim->IsAdvancing()) {
+        for (size_t idx : fCastOrder)
+            ICastRay(fPending[idx].fQuery, fPending[idx].fResult);
+        return;
+    }
+
+    // The last slice is cast right here while the workers chew on the rest.
+    plPXRaycastTask tasks[kMaxTasks];
+    std::atomic<size_t> remaining(numTasks - 1);
+    hsSemaphore done;
+
+    const size_t* order = fCastOrder.data();
+    size_t count = fCastOrder.size();
+    for (size_t i = 0; i < numTasks; ++i)
+        tasks[i].Set(this, order + (count * i) / numTasks, order + (count * (i + 1)) / numTasks, &remaining, &done);
+    for (size_t i = 0; i < numTasks - 1; ++i)
+        cpu->submitTask(tasks[i]);
+
+    tasks[numTasks - 1].Cast();
+    done.Wait();
+}
+
+plLOSDispatch::RaycastResult plLOSDispatch::IRaycast(hsPoint3 origin, hsPoint3 destination,
+                                                     const plKey& world, plSimDefs::plLOSDB db,
+                                                     bool closest, plSimDefs::plLOSDB cullDB)
+{
+    RaycastResult result(LOSResult::kMiss, nullptr, { 0.f, 0.f, 0.f }, { 0.f, 0.f, 0.f }, FLT_MAX);
+
+    RaycastQuery query;
+    if (IPrepareRaycast(origin, destination, world, db, closest, cullDB, query)) {
+        ICastRay(query, result);
+        IFinishRaycast(query, result);
     }
     return result;
 }
@@ -41,6 +41,8 @@ You can contact Cyan Worlds, Inc. by email legal@cyan.com
 *==LICENSE==*/
 #include "plPXSimulation.h"
 #include "plPXConvert.h"
+#include "plPXCooking.h"
+#include "plPXCookingCache.h"
 #include "plPhysXAPI.h"
 #include "plPXPhysical.h"
 #include "plPXPhysicalControllerCore.h"
@@ -48,6 +50,7 @@ You can contact Cyan Worlds, Inc. by email legal@cyan.com
 #include "plPXSubWorld.h"
 #include "plSimulationMgr.h"
 
+#include "hsTimer.h"
 #include "plProfile.h"
 
 #include "pnNetCommon/plNetApp.h"
@@ -69,6 +72,9 @@ constexpr float kToleranceScaleLength = 6.f;
 /** Typical magnitude of actor velocities in the simulation */
 constexpr float kToleranceScaleSpeed = 32.f;
 
+/** Number of PhysX worker threads, set before Init() */
+static uint32_t s_workerThreads = 0;
+
 // ==========================================================================
 
 plProfile_CreateTimer(  "Apply Controller Animations", "Simulation", ApplyController);
@@ -309,12 +315,14 @@ static physx::PxFilterFlags ISimulationFilterShader(physx::PxFilterObjectAttribu
 
 plPXSimulation::plPXSimulation()
     : fPxFoundation(), fDebugger(), fTransport(), fPxPhysics(), fPxCooking(),
-      fPxCpuDispatcher(), fAccumulator()
+      fPxCpuDispatcher(), fAccumulator(), fPendingSubSteps()
 {
 }
 
 plPXSimulation::~plPXSimulation()
 {
+    ISyncSimulation();
+
     // This should only run for the empty main world.
     for (auto [key, world] : fWorlds) {
         world.fControllers->release();
@@ -322,6 +330,9 @@ plPXSimulation::~plPXSimulation()
     }
     fWorlds.clear();
 
+    // The cache makes its meshes with fPxPhysics, so stop it (and its write
+    // thread) before any of the SDK objects are released.
+    fCookingCache.reset();
     if (fPxCooking)
         fPxCooking->release();
     if (fPxCpuDispatcher)
@@ -382,10 +393,12 @@ bool plPXSimulation::Init()
         return false;
     }
 
-    // Worker threads actually slow down our simulation - probably because Uru scenes are mostly
+    // Worker threads tend to slow down a single scene - probably because Uru scenes are mostly
     // composed of static geometry, so the thread synchronization adds more overhead than the
-    // threads help.
-    fPxCpuDispatcher = physx::PxDefaultCpuDispatcherCreate(0);
+    // threads help. Ages with many subworlds can still benefit because all of the scenes are
+    // submitted before any results are fetched, so this defaults to off but is configurable.
+    plStatusLog::AddLineSF("Simulation.log", "Using {} PhysX worker thread(s)", s_workerThreads);
+    fPxCpuDispatcher = physx::PxDefaultCpuDispatcherCreate(s_workerThreads);
     if (!fPxCpuDispatcher) {
         plStatusLog::AddLineS("Simulation.log", plStatusLog::kRed, "PhysX CPU Dispatcher failed to initialize!");
         return false;
@@ -403,6 +416,10 @@ bool plPXSimulation::Init()
         return false;
     }
 
+    // The cache is merely an optimization, so failing to set it up is not fatal.
+    fCookingCache = std::make_unique<plPXCookingCache>(fPxPhysics);
+    fCookingCache->Init(plFileName::Join(plFileSystem::GetUserDataPath(), "PhysXCache"));
+
     // Purposefully create AND LEAK the default material so it's always the first one we check.
     // In most Cyan Ages, this is the one and only material. This material will be destroyed by
     // fPxPhysics->release() in the dtor.
@@ -420,6 +437,16 @@ void plPXSimulation::SetDefaultDebuggerEndpoint(plFileName endpoint)
     s_defaultDebuggerEndpoint = std::move(endpoint);
 }
 
+void plPXSimulation::SetDefaultWorkerThreads(uint32_t numThreads)
+{
+    s_workerThreads = numThreads;
+}
+
+uint32_t plPXSimulation::GetDefaultWorkerThreads()
+{
+    return s_workerThreads;
+}
+
 bool plPXSimulation::IConnectDebugger(physx::PxPvdTransport* transport)
 {
     std::swap(transport, fTransport);
@@ -478,33 +505,51 @@ bool plPXSimulation::IsDebuggerConnected() const
 physx::PxConvexMesh* plPXSimulation::InsertConvexHull(const std::vector<uint32_t>& tris,
                                                       const std::vector<hsPoint3>& verts)
 {
-    physx::PxConvexMeshDesc desc;
-    desc.indices.count = tris.size();
-    desc.indices.stride = sizeof(uint32_t);
-    desc.indices.data = tris.empty() ? nullptr : &tris[0];
-    desc.points.count = verts.size();
-    desc.points.stride = sizeof(hsPoint3);
-    desc.points.data = &verts[0];
-    desc.flags = physx::PxConvexFlag::eDISABLE_MESH_VALIDATION |
-                 physx::PxConvexFlag::eFAST_INERTIA_COMPUTATION;
-    if (tris.empty())
-        desc.flags |= physx::PxConvexFlag::eCOMPUTE_CONVEX;
-
-    return fPxCooking->createConvexMesh(desc, fPxPhysics->getPhysicsInsertionCallback());
+    plPXCookingCache::Key key(plPXCookingCache::MeshType::kConvexHull, tris, verts);
+    if (physx::PxConvexMesh* mesh = fCookingCache->FindConvexHull(key))
+        return mesh;
+
+    // Cook once, create the mesh from the cooked data so the actor is usable
+    // right away, and let the cache write the same data out in the background.
+    uint64_t start = hsTimer::GetTicks();
+    physx::PxDefaultMemoryOutputStream cooked;
+    physx::PxConvexMesh* mesh = nullptr;
+    if (fPxCooking->cookConvexMesh(plPXCooking::ConvexHullDesc(tris, verts), cooked)) {
+        physx::PxDefaultMemoryInputData input(cooked.getData(), cooked.getSize());
+        mesh = fPxPhysics->createConvexMesh(input);
+    }
+    float cookMs = hsTimer::GetMilliSeconds<float>(hsTimer::GetTicks() - start);
+    if (mesh)
+        fCookingCache->Store(key, plPXCookingCache::MeshType::kConvexHull, cooked.getData(),
+                             cooked.getSize(), cookMs);
+    return mesh;
 }
 
 physx::PxTriangleMesh* plPXSimulation::InsertTriangleMesh(const std::vector<uint32_t>& tris,
                                                           const std::vector<hsPoint3>& verts)
 {
-    physx::PxTriangleMeshDesc desc;
-    desc.points.count = verts.size();
-    desc.points.stride = sizeof(hsPoint3);
-    desc.points.data = &verts[0];
-    desc.triangles.count = tris.size() / 3;
-    desc.triangles.stride = sizeof(uint32_t) * 3;
-    desc.triangles.data = &tris[0];
+    plPXCookingCache::Key key(plPXCookingCache::MeshType::kTriangleMesh, tris, verts);
+    if (physx::PxTriangleMesh* mesh = fCookingCache->FindTriangleMesh(key))
+        return mesh;
+
+    uint64_t start = hsTimer::GetTicks();
+    physx::PxDefaultMemoryOutputStream cooked;
+    physx::PxTriangleMesh* mesh = nullptr;
+    if (fPxCooking->cookTriangleMesh(plPXCooking::TriMeshDesc(tris, verts), cooked)) {
+        physx::PxDefaultMemoryInputData input(cooked.getData(), cooked.getSize());
+        mesh = fPxPhysics->createTriangleMesh(input);
+    }
+    float cookMs = hsTimer::GetMilliSeconds<float>(hsTimer::GetTicks() - start);
+    if (mesh)
+        fCookingCache->Store(key, plPXCookingCache::MeshType::kTriangleMesh, cooked.getData(),
+                             cooked.getSize(), cookMs);
+    return mesh;
+}
 
-    return fPxCooking->createTriangleMesh(desc, fPxPhysics->getPhysicsInsertionCallback());
+void plPXSimulation::ReportCookingStats()
+{
+    if (fCookingCache)
+        fCookingCache->ReportStats();
 }
 
 physx::PxRigidActor* plPXSimulation::CreateRigidActor(const physx::PxGeometry& geometry,
@@ -636,6 +681,8 @@ physx::PxMaterial* plPXSimulation::InitMaterial(float uStatic, float uDynamic, f
 
 void plPXSimulation::AddToWorld(physx::PxActor* actor, const plKey& world)
 {
+    ISyncSimulation();
+
     actor->setName(static_cast<plPXActorData*>(actor->userData)->c_str());
     if (physx::PxScene* scene = actor->getScene()) {
         scene->removeActor(*actor);
@@ -655,6 +702,8 @@ void plPXSimulation::AddToWorld(physx::PxActor* actor, const plKey& world)
 
 physx::PxController* plPXSimulation::CreateCharacterController(physx::PxControllerDesc& desc, const plKey& world)
 {
+    ISyncSimulation();
+
     physx::PxControllerManager* controllerMgr;
     auto it = fWorlds.find(world);
     if (it == fWorlds.end()) {
@@ -680,6 +729,8 @@ physx::PxScene* plPXSimulation::FindScene(const plKey& world)
 
 void plPXSimulation::RemoveFromWorld(physx::PxRigidActor* actor)
 {
+    ISyncSimulation();
+
     physx::PxScene* scene = actor->getScene();
     hsAssert(scene, "actor not in a scene");
 
@@ -692,6 +743,8 @@ void plPXSimulation::RemoveFromWorld(physx::PxRigidActor* actor)
 
 void plPXSimulation::RemoveFromWorld(physx::PxController* controller)
 {
+    ISyncSimulation();
+
     physx::PxScene* scene = controller->getScene();
     hsAssert(scene, "controller not in a scene");
 
@@ -701,8 +754,10 @@ void plPXSimulation::RemoveFromWorld(physx::PxController* controller)
 
 // ==========================================================================
 
-bool plPXSimulation::Advance(float delta)
+bool plPXSimulation::BeginAdvance(float delta)
 {
+    hsAssert(fPendingSubSteps == 0, "BeginAdvance called with a step still in flight");
+
     fAccumulator += delta;
     if (fAccumulator < kDefaultStepSize) {
         // Not enough time has passed to perform a physics substep, but we need to propagate
@@ -729,23 +784,59 @@ bool plPXSimulation::Advance(float delta)
     plPXPhysicalControllerCore::Apply(delta);
     plProfile_EndTiming(ApplyController);
 
+    // Kick off every subworld before waiting on any of them so the dispatcher's worker
+    // threads can chew on all of the scenes at once.
     plProfile_BeginTiming(Step);
-    for (auto [key, world] : fWorlds) {
+    for (auto& [key, world] : fWorlds) {
         world.fScene->simulate(delta);
-        world.fScene->fetchResults(true);
-
-        physx::PxSimulationStatistics stats;
-        world.fScene->getSimulationStatistics(stats);
-        plProfile_IncCount(ActiveBodies, stats.nbActiveDynamicBodies + stats.nbActiveDynamicBodies);
-        plProfile_IncCount(ActiveDynamics, stats.nbActiveDynamicBodies);
-        plProfile_IncCount(ActiveKinematics, stats.nbActiveKinematicBodies);
-        plProfile_IncCount(TotalBodies, stats.nbDynamicBodies + stats.nbKinematicBodies + stats.nbStaticBodies);
-        plProfile_IncCount(Dynamics, stats.nbDynamicBodies);
-        plProfile_IncCount(Kinematics, stats.nbKinematicBodies);
-        plProfile_IncCount(Statics, stats.nbStaticBodies);
+        world.fSimulating = true;
     }
     plProfile_EndTiming(Step);
 
+    fPendingSubSteps = numSubSteps;
+    return true;
+}
+
+void plPXSimulation::IFetchResults(World& world)
+{
+    if (!world.fSimulating)
+        return;
+
+    world.fScene->fetchResults(true);
+    world.fSimulating = false;
+
+    physx::PxSimulationStatistics stats;
+    world.fScene->getSimulationStatistics(stats);
+    plProfile_IncCount(ActiveBodies, stats.nbActiveDynamicBodies + stats.nbActiveKinematicBodies);
+    plProfile_IncCount(ActiveDynamics, stats.nbActiveDynamicBodies);
+    plProfile_IncCount(ActiveKinematics, stats.nbActiveKinematicBodies);
+    plProfile_IncCount(TotalBodies, stats.nbDynamicBodies + stats.nbKinematicBodies + stats.nbStaticBodies);
+    plProfile_IncCount(Dynamics, stats.nbDynamicBodies);
+    plProfile_IncCount(Kinematics, stats.nbKinematicBodies);
+    plProfile_IncCount(Statics, stats.nbStaticBodies);
+}
+
+void plPXSimulation::ISyncSimulation()
+{
+    if (fPendingSubSteps == 0)
+        return;
+
+    plProfile_BeginTiming(Step);
+    for (auto& [key, world] : fWorlds)
+        IFetchResults(world);
+    plProfile_EndTiming(Step);
+}
+
+bool plPXSimulation::EndAdvance()
+{
+    if (fPendingSubSteps == 0)
+        return false;
+
+    ISyncSimulation();
+
+    int numSubSteps = fPendingSubSteps;
+    fPendingSubSteps = 0;
+
     // Propagate the simulated controller movement to the SceneObjects for rendering purposes.
     plProfile_BeginTiming(CorrectController);
     plPXPhysicalControllerCore::Update(numSubSteps, fAccumulator / kDefaultStepSize);
@@ -753,3 +844,9 @@ bool plPXSimulation::Advance(float delta)
 
     return true;
 }
+
+bool plPXSimulation::Advance(float delta)
+{
+    BeginAdvance(delta);
+    return EndAdvance();
+}
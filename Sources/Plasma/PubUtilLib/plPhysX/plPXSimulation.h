@@ -46,12 +46,14 @@ You can contact Cyan Worlds, Inc. by email legal@cyan.com
 #include "pnKeyedObject/plKey.h"
 
 #include <map>
+#include <memory>
 #include <optional>
 #include <string_theory/string>
 #include <vector>
 
 class hsKeyedObject;
 struct hsPoint3;
+class plPXCookingCache;
 class plPXFilterData;
 class plPXPhysical;
 class plPXPhysicalControllerCore;
@@ -109,9 +111,13 @@ public:
     plPXActorData(plPXPhysical* physical);
     plPXActorData(plPXPhysicalControllerCore* controller);
 
-    /** Gets the key of the owner object. */
+    /**
+     * Gets the key of the owner object.
+     * Returned by reference so scene query callbacks running on PhysX worker
+     * threads don't churn the key's reference count.
+     */
     [[nodiscard]]
-    plKey GetKey() const { return fKey; }
+    const plKey& GetKey() const { return fKey; }
 
     [[nodiscard]]
     plPXPhysical* GetPhysical() const { return fPhysical; }
@@ -135,6 +141,7 @@ protected:
     {
         physx::PxScene* fScene{};
         physx::PxControllerManager* fControllers{};
+        bool fSimulating{};
     };
 
     physx::PxFoundation* fPxFoundation;
@@ -143,12 +150,20 @@ protected:
     physx::PxPhysics* fPxPhysics;
     physx::PxCooking* fPxCooking;
     physx::PxDefaultCpuDispatcher* fPxCpuDispatcher;
+    std::unique_ptr<plPXCookingCache> fCookingCache;
     std::map<plKey, World> fWorlds;
     float fAccumulator;
+    int fPendingSubSteps;
 
 protected:
     bool IConnectDebugger(physx::PxPvdTransport* transport);
 
+    /** Waits for a subworld's in-flight step, if any, and records its statistics. */
+    void IFetchResults(World& world);
+
+    /** Waits for all in-flight steps before the scenes are modified. */
+    void ISyncSimulation();
+
 public:
     plPXSimulation();
     plPXSimulation(const plPXSimulation&) = delete;
@@ -169,6 +184,16 @@ public:
      */
     static void SetDefaultDebuggerEndpoint(plFileName endpoint={});
 
+    /**
+     * Sets the number of PhysX worker threads.
+     * Zero, the default, runs the simulation entirely on the calling thread. Like the
+     * debugger endpoint, this must be set before the simulation is initialized.
+     */
+    static void SetDefaultWorkerThreads(uint32_t numThreads);
+
+    /** Gets the number of PhysX worker threads the simulation will use. */
+    static uint32_t GetDefaultWorkerThreads();
+
     /**
      * Connects to the PhysX Visual Debugger.
      * This connects to the PhysX Visual Debugger. Caution should be used if a connection to the
@@ -196,16 +221,25 @@ protected:
     physx::PxMaterial* InitMaterial(float uStatic, float uDynamic, float restitution);
 
 public:
-    /** Cooks and inserts a convex mesh into the simulation. */
+    /**
+     * Cooks and inserts a convex mesh into the simulation.
+     * The cooked mesh is loaded from the collision cache when possible.
+     */
     [[nodiscard]]
     physx::PxConvexMesh* InsertConvexHull(const std::vector<uint32_t>& tris,
                                           const std::vector<hsPoint3>& verts);
 
-    /** Cooks and inserts a triangle mesh into the simulation. */
+    /**
+     * Cooks and inserts a triangle mesh into the simulation.
+     * The cooked mesh is loaded from the collision cache when possible.
+     */
     [[nodiscard]]
     physx::PxTriangleMesh* InsertTriangleMesh(const std::vector<uint32_t>& tris,
                                               const std::vector<hsPoint3>& verts);
 
+    /** Logs how effective the collision cache has been since the last report. */
+    void ReportCookingStats();
+
     [[nodiscard]]
     physx::PxRigidActor* CreateRigidActor(const physx::PxGeometry& geometry,
                                           const physx::PxTransform& globalPose,
@@ -242,6 +276,33 @@ public:
      */
     void RemoveFromWorld(physx::PxController* controller);
 
+    /**
+     * Begins advancing the simulation.
+     * All subworlds are submitted to the CPU dispatcher before any results are fetched,
+     * so they step concurrently when worker threads are available.
+     * \returns true if a step was started and must be completed by \sa EndAdvance().
+     */
+    bool BeginAdvance(float delta);
+
+    /**
+     * Completes the step started by \sa BeginAdvance(), blocking until all subworlds
+     * have finished simulating.
+     * \returns true if the simulation actually advanced.
+     */
+    bool EndAdvance();
+
+    /** Returns whether a step has been started but not yet completed. */
+    [[nodiscard]]
+    bool IsAdvancing() const { return fPendingSubSteps != 0; }
+
+    /**
+     * Gets the CPU dispatcher that steps the simulation.
+     * Other PhysX work, such as batched scene queries, may be submitted to it while
+     * the simulation is not advancing.
+     */
+    [[nodiscard]]
+    physx::PxDefaultCpuDispatcher* GetCpuDispatcher() const { return fPxCpuDispatcher; }
+
     /** Advances the simulation. */
     bool Advance(float delta);
 };
@@ -64,6 +64,7 @@ You can contact Cyan Worlds, Inc. by email legal@cyan.com
 #include "plModifier/plDetectorLog.h"
 #include "plModifier/plExcludeRegionModifier.h"
 #include "plPhysical/plPhysicsSoundMgr.h"
+#include "plScene/plRelevanceMgr.h"
 #include "plStatusLog/plStatusLog.h"
 
 /////////////////////////////////////////////////////////////////
@@ -82,6 +83,7 @@ plProfile_CreateCounter("SetTransforms Accepted", "Simulation", SetTransforms);
 // declared at file scope so that both GetInstance and the destructor can access it.
 static plSimulationMgr* gTheInstance;
 bool plSimulationMgr::fExtraProfile = false;
+bool plSimulationMgr::fOverlapSimulation = false;
 
 void plSimulationMgr::Init()
 {
@@ -119,6 +121,7 @@ plSimulationMgr* plSimulationMgr::GetInstance()
 plSimulationMgr::plSimulationMgr()
     : fSimulation(std::make_unique<plPXSimulation>()),
       fSuspended(true),
+      fAdvancePending(false),
       fLOSDispatch(new plLOSDispatch()),
       fSoundMgr(new plPhysicsSoundMgr),
       fLog()
@@ -168,6 +171,8 @@ bool plSimulationMgr::MsgReceive(plMessage* msg)
 
     if (plAgeLoadedMsg* ageLoadedMsg = plAgeLoadedMsg::ConvertNoRef(msg)) {
         fSuspended = !ageLoadedMsg->fLoaded;
+        if (ageLoadedMsg->fLoaded)
+            fSimulation->ReportCookingStats();
         return true;
     }
 
@@ -224,12 +229,40 @@ void plSimulationMgr::ResetKickables()
 
 void plSimulationMgr::Advance(float delSecs)
 {
+    // An overlapped step that was never collected must be finished before starting another.
+    FinishAdvance();
+
     if (fSuspended)
         return;
 
+    fSimulation->BeginAdvance(delSecs);
+    fAdvancePending = true;
+    if (!fOverlapSimulation)
+        FinishAdvance();
+}
+
+void plSimulationMgr::FinishAdvance()
+{
+    if (!fAdvancePending)
+        return;
+
+    fAdvancePending = false;
+    IFinishAdvance();
+}
+
+void plSimulationMgr::SetOverlapSimulation(bool overlap)
+{
+    // Don't leave a step hanging if overlap is turned off mid-frame
+    if (!overlap && gTheInstance)
+        gTheInstance->FinishAdvance();
+    fOverlapSimulation = overlap;
+}
+
+void plSimulationMgr::IFinishAdvance()
+{
     // Only pump the sounds if the simulation actually advanced. Otherwise we get fascinating
     // (read: bad) sounds stopping/starting when the fps is greater than the simulation frequency.
-    if (fSimulation->Advance(delSecs))
+    if (fSimulation->EndAdvance())
         fSoundMgr->Update();
 
     plProfile_BeginTiming(ProcessSyncs);
@@ -306,12 +339,14 @@ void plSimulationMgr::ConsiderSynch(plPXPhysical* physical, plPXPhysical* other)
         if (syncOther)
             timeElapsed = std::max(timeElapsed, timeNow - other->GetLastSyncTime());
 
-        // Set the sync time to 1 second from the last sync
+        // Set the sync time to 1 second from the last sync, or longer if no
+        // other player close by cares about where this thing ends up
+        double interval = IGetSynchInterval(physical);
         double syncTime = 0.0;
-        if (timeElapsed > 1.0)
+        if (timeElapsed > interval)
             syncTime = hsTimer::GetSysSeconds();
         else
-            syncTime = hsTimer::GetSysSeconds() + (1.0 - timeElapsed);
+            syncTime = hsTimer::GetSysSeconds() + (interval - timeElapsed);
 
         // This line will create and insert the request if it's not there already.
         SynchRequest& physReq = fPendingSynchs[physical];
@@ -329,6 +364,21 @@ void plSimulationMgr::ConsiderSynch(plPXPhysical* physical, plPXPhysical* other)
     }
 }
 
+double plSimulationMgr::IGetSynchInterval(plPXPhysical* physical) const
+{
+    plRelevanceMgr* mgr = plRelevanceMgr::Instance();
+    if (!mgr)
+        return 1.0;
+
+    hsPoint3 pos;
+    physical->GetPositionSim(pos);
+
+    hsBitVector regionsImIn, regionsICareAbout;
+    if (mgr->GetEnabled())
+        mgr->SetRegionVectors(pos, regionsImIn, regionsICareAbout);
+    return mgr->GetInterest().GetSynchInterval(pos, regionsImIn);
+}
+
 void plSimulationMgr::IProcessSynchs()
 {
     double time = hsTimer::GetSysSeconds();
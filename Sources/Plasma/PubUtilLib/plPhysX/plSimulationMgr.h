@@ -79,11 +79,23 @@ public:
 
     static bool fExtraProfile;
 
+    // Should the PhysX step run while the frame is being rendered?
+    static bool fOverlapSimulation;
+
     bool MsgReceive(plMessage* msg) override;
 
     // Advance the simulation by the given number of seconds
     void Advance(float delSecs);
 
+    // Collect the results of a step that was left running by Advance. Only does
+    // anything when the simulation is overlapped with the rest of the frame.
+    void FinishAdvance();
+
+    // When set, Advance only kicks off the PhysX step and the results are fetched
+    // by FinishAdvance, letting the simulation run alongside render and cull.
+    static void SetOverlapSimulation(bool overlap);
+    static bool GetOverlapSimulation() { return fOverlapSimulation; }
+
     // The simulation won't run at all if it is suspended
     void Suspend() { fSuspended = true; }
     void Resume() { fSuspended = false; }
@@ -107,11 +119,15 @@ public:
     void ResetKickables();
 
 protected:
+    void IFinishAdvance();
     void ISendUpdates();
 
     // Walk through the synchronization requests and send them as appropriate.
     void IProcessSynchs();
 
+    // How long a physical can go between synchs, given who's around to see it
+    double IGetSynchInterval(plPXPhysical* physical) const;
+
     std::unique_ptr<class plPXSimulation> fSimulation;
 
     plPhysicsSoundMgr* fSoundMgr;
@@ -128,6 +144,9 @@ protected:
     // but nothing will move.
     bool fSuspended;
 
+    // Has Advance left work for FinishAdvance?
+    bool fAdvancePending;
+
     // A utility class to keep track of a request for a physical synchronization.
     // These requests must pass a certain criteria (see the code for the latest)
     // before they are actually either sent over the network or rejected.
@@ -62,6 +62,7 @@ plProfile_CreateCounter("LightChar",            "PipeC", LightChar);
 plProfile_CreateCounter("LightActive",          "PipeC", LightActive);
 plProfile_CreateCounter("Lights Found",         "PipeC", FindLightsFound);
 plProfile_CreateCounter("Perms Found",          "PipeC", FindLightsPerm);
+plProfile_CreateCounter("Grid Candidates",      "PipeC", FindLightsGrid);
 
 plProfile_CreateCounter("Polys",                "General",  DrawTriangles);
 plProfile_CreateCounter("Material Change",      "Draw",     MatChange);
@@ -53,6 +53,7 @@ You can contact Cyan Worlds, Inc. by email legal@cyan.com
 #include "hsGDeviceRef.h"
 #include "plRenderTarget.h"
 #include "plCubicRenderTarget.h"
+#include "plLightGrid.h"
 
 #include "hsGMatState.inl"
 #include "plPipeDebugFlags.h"
@@ -100,6 +101,7 @@ plProfile_Extern(LightChar);
 plProfile_Extern(LightActive);
 plProfile_Extern(FindLightsFound);
 plProfile_Extern(FindLightsPerm);
+plProfile_Extern(FindLightsGrid);
 
 static const float kPerspLayerScale  = 0.00001f;
 static const float kPerspLayerScaleW = 0.001f;
@@ -176,6 +178,8 @@ protected:
     plLightInfo*                            fActiveLights;
     std::vector<plLightInfo*>               fCharLights;
     std::vector<plLightInfo*>               fVisLights;
+    plLightGrid                             fLightGrid;     // Over fCharLights
+    std::vector<uint16_t>                   fLightCandidates;
 
     std::vector<plShadowSlave*>             fShadows;
 
@@ -1102,6 +1106,13 @@ void pl3DPipeline<DeviceType>::BeginVisMgr(plVisMgr* visMgr)
     plProfile_IncCount(LightVis, fVisLights.size());
     plProfile_IncCount(LightChar, fCharLights.size());
 
+    // fVisLights is just fCharLights minus the ones with include lists,
+    // so one grid over fCharLights serves both.
+    if (IsDebugFlagSet(plPipeDbg::kFlagNoLightGrid))
+        fLightGrid.Clear();
+    else
+        fLightGrid.Build(fCharLights);
+
     plProfile_EndTiming(FindSceneLights);
 }
 
@@ -1111,6 +1122,7 @@ void pl3DPipeline<DeviceType>::EndVisMgr(plVisMgr* visMgr)
 {
     fCharLights.clear();
     fVisLights.clear();
+    fLightGrid.Clear();
 }
 
 
@@ -1656,7 +1668,25 @@ void pl3DPipeline<DeviceType>::ICheckLighting(plDrawableSpans* drawable, std::ve
     static std::vector<plLightInfo*> lightList;
     lightList.clear();
 
-    if (drawable->GetNativeProperty(plDrawable::kPropCharacter)) {
+    const hsBounds3Ext& drawBnd = drawable->GetSpaceTree()->GetWorldBounds();
+    if (!fCharLights.empty() && fLightGrid.GetNumLights() == fCharLights.size()) {
+        // Only the lights sharing grid cells with the drawable need the full
+        // test. Candidates come back in fCharLights order, and fVisLights is
+        // fCharLights in that same order minus the lights with includes, so
+        // lightList comes out in the same order as the full walks below.
+        // AffectsBound() rejects anything outside the light's grid box, so
+        // no light the walks would keep is missing here either.
+        bool charac = drawable->GetNativeProperty(plDrawable::kPropCharacter);
+        fLightGrid.FindLights(drawBnd, fLightCandidates);
+        plProfile_IncCount(FindLightsGrid, fLightCandidates.size());
+        for (uint16_t idx : fLightCandidates) {
+            plLightInfo* light = fCharLights[idx];
+            if (!charac && light->GetProperty(plLightInfo::kLPHasIncludes))
+                continue;
+            if (light->AffectsBound(drawBnd))
+                lightList.emplace_back(light);
+        }
+    } else if (drawable->GetNativeProperty(plDrawable::kPropCharacter)) {
         for (plLightInfo* charLight : fCharLights) {
             if (charLight->AffectsBound(drawable->GetSpaceTree()->GetWorldBounds()))
                 lightList.emplace_back(charLight);
@@ -69,6 +69,57 @@ static const float kTolerance = 1.e-1f;
 
 plProfile_CreateCounter("Harvest Nodes", "Draw", HarvestNodes);
 
+// Has to come up with bit for bit the same answers as TestBounds, so the
+// order of operations matches it (and hsBounds3::TestPlane) exactly.
+void plCullNode::classify_wide_fpu(const plSpaceTreeWideNode& wide, const hsVector3& norm, float dist,
+                                   uint8_t& culledMask, uint8_t& clearMask)
+{
+    culledMask = clearMask = 0;
+    for (int i = 0; i < plSpaceTreeWideNode::kNumSlots; i++)
+    {
+        float centerDist = wide.fCenters[0][i] * norm.fX;
+        centerDist += wide.fCenters[1][i] * norm.fY;
+        centerDist += wide.fCenters[2][i] * norm.fZ;
+        centerDist += dist;
+        float rad = wide.fRadii[i];
+        if( centerDist < -rad )
+        {
+            culledMask |= (1 << i);
+            continue;
+        }
+        if( centerDist > rad )
+        {
+            clearMask |= (1 << i);
+            continue;
+        }
+
+        float dmax = wide.fMins[0][i] * norm.fX;
+        dmax += wide.fMins[1][i] * norm.fY;
+        dmax += wide.fMins[2][i] * norm.fZ;
+        float dmin = dmax;
+        for (int j = 0; j < 3; j++)
+        {
+            float dd = wide.fMaxs[j][i] - wide.fMins[j][i];
+            dd *= norm[j];
+            if( dd < 0 )
+                dmin += dd;
+            else
+                dmax += dd;
+        }
+        if( dmax + dist < kSafetyDist )
+            culledMask |= (1 << i);
+        else if( dmin + dist >= 0 )
+            clearMask |= (1 << i);
+    }
+}
+
+// CPU-optimized functions requiring dispatch
+hsCpuFunctionDispatcher<plCullNode::classify_wide_ptr> plCullNode::classify_wide {
+    &plCullNode::classify_wide_fpu,
+    nullptr,            // SSE1
+    &plCullNode::classify_wide_sse2
+};
+
 //////////////////////////////////////////////////////////////////////
 // Harvest culling section.
 // These are the functions used on a built tree
@@ -140,7 +191,6 @@ plCullNode::plCullStatus plCullNode::TestBounds(const hsBounds3Ext& bnd) const
     hsPoint2 depth;
     bnd.TestPlane(fNorm, depth);
 
-    const float kSafetyDist = -0.1f;
     if( depth.fY + fDist < kSafetyDist )
         return kCulled;
 
@@ -242,27 +292,106 @@ plCullNode::plCullStatus plCullNode::ITestNode(const plSpaceTree* space, int16_t
         }
         else
         {
-            plCullStatus child0 = ITestNode(space, space->GetNode(who).GetChild(0), clear, split, culled);
-            plCullStatus child1 = ITestNode(space, space->GetNode(who).GetChild(1), clear, split, culled);
-
-            if( child0 != child1 )
-            {
-                if( child0 == kPureSplit )
-                    split.emplace_back(space->GetNode(who).GetChild(0));
-                else if( child1 == kPureSplit )
-                    split.emplace_back(space->GetNode(who).GetChild(1));
-                retVal = kSplit;
-            }
-            else if( child0 == kPureSplit )
-            {
-                retVal = kPureSplit;
-            }
+            int16_t wideIdx = space->FindWideNode(who);
+            if( wideIdx >= 0 )
+                return ITestWideNode(space, wideIdx, clear, split, culled);
+
+            int16_t child0 = space->GetNode(who).GetChild(0);
+            int16_t child1 = space->GetNode(who).GetChild(1);
+            plCullStatus stat0 = ITestNode(space, child0, clear, split, culled);
+            plCullStatus stat1 = ITestNode(space, child1, clear, split, culled);
+            retVal = IMergeChildren(child0, child1, stat0, stat1, split);
         }
         break;
     }
     return retVal;
 }
 
+// A split parent is only interesting if its children disagree. If exactly one of
+// them is a pure split it goes on the split list by itself, and if both are,
+// the parent is passed up as a pure split in their place.
+plCullNode::plCullStatus plCullNode::IMergeChildren(int16_t child0, int16_t child1,
+                                                    plCullStatus stat0, plCullStatus stat1,
+                                                    std::vector<int16_t>& split) const
+{
+    if( stat0 != stat1 )
+    {
+        if( stat0 == kPureSplit )
+            split.emplace_back(child0);
+        else if( stat1 == kPureSplit )
+            split.emplace_back(child1);
+        return kSplit;
+    }
+    if( stat0 == kPureSplit )
+        return kPureSplit;
+    return kClear;
+}
+
+// Same as the split case of ITestNode above, for a node that heads one of the space
+// tree's wide nodes. The plane is tested against the children and grandchildren all
+// at once, then the results are used in exactly the order the recursion would have.
+plCullNode::plCullStatus plCullNode::ITestWideNode(const plSpaceTree* space, int16_t wideIdx,
+                                                   std::vector<int16_t>& clear, std::vector<int16_t>& split,
+                                                   std::vector<int16_t>& culled) const
+{
+    const plSpaceTreeWideNode& wide = space->GetWideNode(wideIdx);
+
+    uint8_t culledMask, clearMask;
+    classify_wide.call(wide, fNorm, fDist, culledMask, clearMask);
+
+    plCullStatus stat0 = ITestWideSlot(space, wide, 0, culledMask, clearMask, clear, split, culled);
+    plCullStatus stat1 = ITestWideSlot(space, wide, 1, culledMask, clearMask, clear, split, culled);
+    return IMergeChildren(wide.fNode[0], wide.fNode[1], stat0, stat1, split);
+}
+
+plCullNode::plCullStatus plCullNode::ITestWideSlot(const plSpaceTree* space, const plSpaceTreeWideNode& wide, int slot,
+                                                   uint8_t culledMask, uint8_t clearMask,
+                                                   std::vector<int16_t>& clear, std::vector<int16_t>& split,
+                                                   std::vector<int16_t>& culled) const
+{
+    int16_t who = wide.fNode[slot];
+    const plSpaceTreeNode& node = space->GetNode(who);
+    if( space->IsDisabled(who) || (node.fWorldBounds.GetType() != kBoundsNormal) )
+    {
+        culled.emplace_back(who);
+        return kCulled;
+    }
+
+    uint8_t bit = 1 << slot;
+    plCullStatus stat = kSplit;
+    if( wide.fScalarMask & bit )
+        stat = TestBounds(node.fWorldBounds);
+    else if( culledMask & bit )
+        stat = kCulled;
+    else if( clearMask & bit )
+        stat = kClear;
+
+    switch( stat )
+    {
+    case kClear:
+        clear.emplace_back(who);
+        return kClear;
+    case kCulled:
+        culled.emplace_back(who);
+        return kCulled;
+    default:
+        break;
+    }
+
+    if( node.IsLeaf() )
+        return kPureSplit;
+
+    if( slot >= plSpaceTreeWideNode::kFirstGrandSlot )
+        return ITestWideNode(space, wide.fWide[slot], clear, split, culled);
+
+    // A child's own children are in this same wide node.
+    int grand0 = plSpaceTreeWideNode::GrandSlot(slot, 0);
+    int grand1 = plSpaceTreeWideNode::GrandSlot(slot, 1);
+    plCullStatus stat0 = ITestWideSlot(space, wide, grand0, culledMask, clearMask, clear, split, culled);
+    plCullStatus stat1 = ITestWideSlot(space, wide, grand1, culledMask, clearMask, clear, split, culled);
+    return IMergeChildren(wide.fNode[grand0], wide.fNode[grand1], stat0, stat1, split);
+}
+
 // Cycle through the Cull Nodes, paring down the list of who to test (through ITestNode above).
 // We reclaim the scratch indices in clear and split when we're done (SetCount(0)), but we can't
 // reclaim the culled, because our caller may be looking at who all we culled. See below in split.
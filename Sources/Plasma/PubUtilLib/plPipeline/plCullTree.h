@@ -46,6 +46,7 @@ You can contact Cyan Worlds, Inc. by email legal@cyan.com
 #include <vector>
 
 #include "hsBounds.h"
+#include "hsCpuID.h"
 #include "hsGeometry3.h"
 #include "hsBitVector.h"
 #include "plCuller.h"
@@ -57,6 +58,8 @@ You can contact Cyan Worlds, Inc. by email legal@cyan.com
 
 class plCullTree;
 class plCullNode;
+class plSpaceTreeNode;
+class plSpaceTreeWideNode;
 
 // for vis
 struct hsPoint3;
@@ -175,6 +178,10 @@ protected:
 
     // Using the nodes
     plCullNode::plCullStatus    ITestNode(const plSpaceTree* space, int16_t who, std::vector<int16_t>& clear, std::vector<int16_t>& split, std::vector<int16_t>& culled) const;
+    plCullNode::plCullStatus    ITestWideNode(const plSpaceTree* space, int16_t wideIdx, std::vector<int16_t>& clear, std::vector<int16_t>& split, std::vector<int16_t>& culled) const;
+    plCullNode::plCullStatus    ITestWideSlot(const plSpaceTree* space, const plSpaceTreeWideNode& wide, int slot, uint8_t culledMask, uint8_t clearMask,
+                                              std::vector<int16_t>& clear, std::vector<int16_t>& split, std::vector<int16_t>& culled) const;
+    plCullNode::plCullStatus    IMergeChildren(int16_t child0, int16_t child1, plCullStatus stat0, plCullStatus stat1, std::vector<int16_t>& split) const;
     void                        ITestNode(const plSpaceTree* space, int16_t who, hsBitVector& totList, hsBitVector& outList) const;
     void                        IHarvest(const plSpaceTree* space, std::vector<int16_t>& outList) const;
 
@@ -192,6 +199,15 @@ protected:
                                     hsBitVector& onVerts,
                                     plCullPoly& srcPoly) const;
 
+    //  CPU-optimized functions
+    // Classify all the slots of a wide space tree node against one plane, with the same answers as TestBounds.
+    typedef void(*classify_wide_ptr)(const plSpaceTreeWideNode&, const hsVector3&, float, uint8_t&, uint8_t&);
+    static hsCpuFunctionDispatcher<classify_wide_ptr> classify_wide;
+    static void classify_wide_fpu(const plSpaceTreeWideNode& wide, const hsVector3& norm, float dist, uint8_t& culled, uint8_t& clear);
+    static void classify_wide_sse2(const plSpaceTreeWideNode& wide, const hsVector3& norm, float dist, uint8_t& culled, uint8_t& clear);
+
+    static constexpr float kSafetyDist = -0.1f;
+
     std::vector<plCullPoly>&        ScratchPolys() const { return fTree->ScratchPolys(); }
     std::vector<int16_t>&           ScratchClear() const { return fTree->ScratchClear(); }
     std::vector<int16_t>&           ScratchSplit() const { return fTree->ScratchSplit(); }
@@ -0,0 +1,107 @@
+/*==LICENSE==*
+
+CyanWorlds.com Engine - MMOG client, server and tools
+Copyright (C) 2011  Cyan Worlds, Inc.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+Additional permissions under GNU GPL version 3 section 7
+
+If you modify this Program, or any covered work, by linking or
+combining it with any of RAD Game Tools Bink SDK, Autodesk 3ds Max SDK,
+NVIDIA PhysX SDK, Microsoft DirectX SDK, OpenSSL library, Independent
+JPEG Group JPEG library, Microsoft Windows Media SDK, or Apple QuickTime SDK
+(or a modified version of those libraries),
+containing parts covered by the terms of the Bink SDK EULA, 3ds Max EULA,
+PhysX SDK EULA, DirectX SDK EULA, OpenSSL and SSLeay licenses, IJG
+JPEG Library README, Windows Media SDK EULA, or QuickTime SDK EULA, the
+licensors of this Program grant you additional
+permission to convey the resulting work. Corresponding Source for a
+non-source form of such a combination shall include the source code for
+the parts of OpenSSL and IJG JPEG Library used as well as that of the covered
+work.
+
+You can contact Cyan Worlds, Inc. by email legal@cyan.com
+ or by snail mail at:
+      Cyan Worlds, Inc.
+      14617 N Newport Hwy
+      Mead, WA   99021
+
+*==LICENSE==*/
+
+#include "HeadSpin.h"
+#include "plCullTree.h"
+
+#include "plDrawable/plSpaceTree.h"
+
+#ifdef HAVE_SSE2
+#   include <emmintrin.h>
+#endif
+
+void plCullNode::classify_wide_sse2(const plSpaceTreeWideNode& wide, const hsVector3& norm, float dist,
+                                    uint8_t& culledMask, uint8_t& clearMask)
+{
+    culledMask = clearMask = 0;
+
+#ifdef HAVE_SSE2
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 nx = _mm_set1_ps(norm.fX);
+    const __m128 ny = _mm_set1_ps(norm.fY);
+    const __m128 nz = _mm_set1_ps(norm.fZ);
+    const __m128 d = _mm_set1_ps(dist);
+    const __m128 safety = _mm_set1_ps(kSafetyDist);
+
+    for (int i = 0; i < plSpaceTreeWideNode::kNumSlots; i += 4)
+    {
+        __m128 centerDist = _mm_mul_ps(_mm_load_ps(&wide.fCenters[0][i]), nx);
+        centerDist = _mm_add_ps(centerDist, _mm_mul_ps(_mm_load_ps(&wide.fCenters[1][i]), ny));
+        centerDist = _mm_add_ps(centerDist, _mm_mul_ps(_mm_load_ps(&wide.fCenters[2][i]), nz));
+        centerDist = _mm_add_ps(centerDist, d);
+        __m128 rad = _mm_load_ps(&wide.fRadii[i]);
+        __m128 sphereCulled = _mm_cmplt_ps(centerDist, _mm_sub_ps(zero, rad));
+        __m128 sphereClear = _mm_cmpgt_ps(centerDist, rad);
+
+        // Adding zero instead of branching leaves dmin and dmax exactly
+        // where the branchy version in hsBounds3::TestPlane puts them.
+        __m128 mins[3];
+        __m128 maxs[3];
+        for (int j = 0; j < 3; j++)
+        {
+            mins[j] = _mm_load_ps(&wide.fMins[j][i]);
+            maxs[j] = _mm_load_ps(&wide.fMaxs[j][i]);
+        }
+        __m128 dmax = _mm_mul_ps(mins[0], nx);
+        dmax = _mm_add_ps(dmax, _mm_mul_ps(mins[1], ny));
+        dmax = _mm_add_ps(dmax, _mm_mul_ps(mins[2], nz));
+        __m128 dmin = dmax;
+        for (int j = 0; j < 3; j++)
+        {
+            __m128 dd = _mm_mul_ps(_mm_sub_ps(maxs[j], mins[j]), _mm_set1_ps(norm[j]));
+            __m128 neg = _mm_cmplt_ps(dd, zero);
+            dmin = _mm_add_ps(dmin, _mm_and_ps(neg, dd));
+            dmax = _mm_add_ps(dmax, _mm_andnot_ps(neg, dd));
+        }
+        __m128 boxCulled = _mm_cmplt_ps(_mm_add_ps(dmax, d), safety);
+        __m128 boxClear = _mm_cmpge_ps(_mm_add_ps(dmin, d), zero);
+
+        // The sphere gets the first say, the box only decides what it couldn't.
+        __m128 sphereDecided = _mm_or_ps(sphereCulled, sphereClear);
+        __m128 culled = _mm_or_ps(sphereCulled, _mm_andnot_ps(sphereDecided, boxCulled));
+        __m128 clear = _mm_or_ps(sphereClear, _mm_andnot_ps(sphereDecided, _mm_andnot_ps(boxCulled, boxClear)));
+
+        culledMask |= uint8_t(_mm_movemask_ps(culled) << i);
+        clearMask |= uint8_t(_mm_movemask_ps(clear) << i);
+    }
+#endif // HAVE_SSE2
+}
@@ -0,0 +1,225 @@
+/*==LICENSE==*
+
+CyanWorlds.com Engine - MMOG client, server and tools
+Copyright (C) 2011  Cyan Worlds, Inc.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+Additional permissions under GNU GPL version 3 section 7
+
+If you modify this Program, or any covered work, by linking or
+combining it with any of RAD Game Tools Bink SDK, Autodesk 3ds Max SDK,
+NVIDIA PhysX SDK, Microsoft DirectX SDK, OpenSSL library, Independent
+JPEG Group JPEG library, Microsoft Windows Media SDK, or Apple QuickTime SDK
+(or a modified version of those libraries),
+containing parts covered by the terms of the Bink SDK EULA, 3ds Max EULA,
+PhysX SDK EULA, DirectX SDK EULA, OpenSSL and SSLeay licenses, IJG
+JPEG Library README, Windows Media SDK EULA, or QuickTime SDK EULA, the
+licensors of this Program grant you additional
+permission to convey the resulting work. Corresponding Source for a
+non-source form of such a combination shall include the source code for
+the parts of OpenSSL and IJG JPEG Library used as well as that of the covered
+work.
+
+You can contact Cyan Worlds, Inc. by email legal@cyan.com
+ or by snail mail at:
+      Cyan Worlds, Inc.
+      14617 N Newport Hwy
+      Mead, WA   99021
+
+*==LICENSE==*/
+
+#include "HeadSpin.h"
+#include "plLightGrid.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "plGLight/plLightInfo.h"
+
+plLightGrid::plLightGrid()
+    : fNumLights(), fInvCellSize(), fDims(), fHasBounded(), fStamp()
+{
+}
+
+void plLightGrid::Clear()
+{
+    fNumLights = 0;
+    fHasBounded = false;
+    fCellStart.clear();
+    fCellLights.clear();
+    fUnbounded.clear();
+}
+
+void plLightGrid::ICellRange(const hsPoint3& mins, const hsPoint3& maxs, CellRange& range) const
+{
+    // Same clamped floor for lights and queries. Since it's monotone, two
+    // boxes which overlap always land in overlapping cell ranges.
+    for (int i = 0; i < 3; i++) {
+        int lo = int(std::floor((mins[i] - fMins[i]) * fInvCellSize[i]));
+        int hi = int(std::floor((maxs[i] - fMins[i]) * fInvCellSize[i]));
+        range.fLo[i] = std::clamp(lo, 0, fDims[i] - 1);
+        range.fHi[i] = std::clamp(hi, 0, fDims[i] - 1);
+    }
+}
+
+void plLightGrid::IAllLights(std::vector<uint16_t>& idx) const
+{
+    idx.resize(fNumLights);
+    for (size_t i = 0; i < fNumLights; i++)
+        idx[i] = uint16_t(i);
+}
+
+void plLightGrid::Build(const std::vector<plLightInfo*>& lights)
+{
+    Clear();
+
+    // Indices are stored as 16 bits. Nobody has anywhere near this many
+    // runtime lights on, but if they do, leave the grid empty and let
+    // the caller notice it doesn't match its list.
+    if (lights.empty() || lights.size() > 0xffff)
+        return;
+    fNumLights = lights.size();
+
+    fScratchRanges.clear();
+    fScratchBounded.clear();
+
+    std::vector<hsBounds3Ext>& bounds = fScratchBounds;
+    bounds.resize(fNumLights);
+    for (size_t i = 0; i < fNumLights; i++) {
+        if (lights[i]->GetInfluenceBounds(bounds[i]) && bounds[i].GetType() == kBoundsNormal) {
+            if (fScratchBounded.empty()) {
+                fMins = bounds[i].GetMins();
+                fMaxs = bounds[i].GetMaxs();
+            } else {
+                for (int j = 0; j < 3; j++) {
+                    fMins[j] = std::min(fMins[j], bounds[i].GetMins()[j]);
+                    fMaxs[j] = std::max(fMaxs[j], bounds[i].GetMaxs()[j]);
+                }
+            }
+            fScratchBounded.emplace_back(uint16_t(i));
+        } else {
+            fUnbounded.emplace_back(uint16_t(i));
+        }
+    }
+    if (fScratchBounded.empty())
+        return;
+    fHasBounded = true;
+
+    // Aim for a couple of cells per light, flat axes get a single slice.
+    int dim = int(std::ceil(std::cbrt(2.f * float(fScratchBounded.size()))));
+    dim = std::clamp(dim, 1, int(kMaxCellsPerAxis));
+    int numCells = 1;
+    for (int i = 0; i < 3; i++) {
+        float extent = fMaxs[i] - fMins[i];
+        if (extent > 1.e-3f) {
+            fDims[i] = dim;
+            fInvCellSize[i] = float(dim) / extent;
+        } else {
+            fDims[i] = 1;
+            fInvCellSize[i] = 0;
+        }
+        numCells *= fDims[i];
+    }
+
+    // Count, prefix sum, fill.
+    fCellStart.assign(numCells + 1, 0);
+    fScratchRanges.resize(fScratchBounded.size());
+    for (size_t i = 0; i < fScratchBounded.size(); i++) {
+        const hsBounds3Ext& bnd = bounds[fScratchBounded[i]];
+        CellRange& range = fScratchRanges[i];
+        ICellRange(bnd.GetMins(), bnd.GetMaxs(), range);
+        for (int z = range.fLo[2]; z <= range.fHi[2]; z++) {
+            for (int y = range.fLo[1]; y <= range.fHi[1]; y++) {
+                for (int x = range.fLo[0]; x <= range.fHi[0]; x++)
+                    fCellStart[ICellIndex(x, y, z) + 1]++;
+            }
+        }
+    }
+    for (int i = 0; i < numCells; i++)
+        fCellStart[i + 1] += fCellStart[i];
+
+    fCellLights.resize(fCellStart[numCells]);
+    std::vector<uint32_t> fill(fCellStart.begin(), fCellStart.end() - 1);
+    for (size_t i = 0; i < fScratchBounded.size(); i++) {
+        const CellRange& range = fScratchRanges[i];
+        for (int z = range.fLo[2]; z <= range.fHi[2]; z++) {
+            for (int y = range.fLo[1]; y <= range.fHi[1]; y++) {
+                for (int x = range.fLo[0]; x <= range.fHi[0]; x++)
+                    fCellLights[fill[ICellIndex(x, y, z)]++] = fScratchBounded[i];
+            }
+        }
+    }
+
+    if (fStamps.size() < fNumLights)
+        fStamps.resize(fNumLights, fStamp);
+}
+
+void plLightGrid::FindLights(const hsBounds3Ext& bnd, std::vector<uint16_t>& idx)
+{
+    idx.clear();
+    if (fNumLights == 0)
+        return;
+
+    if (bnd.GetType() != kBoundsNormal) {
+        IAllLights(idx);
+        return;
+    }
+    if (!fHasBounded) {
+        idx = fUnbounded;
+        return;
+    }
+
+    const hsPoint3& mins = bnd.GetMins();
+    const hsPoint3& maxs = bnd.GetMaxs();
+    for (int i = 0; i < 3; i++) {
+        // Off the edge of the grid, only the unbounded lights can reach.
+        if (maxs[i] < fMins[i] || mins[i] > fMaxs[i]) {
+            idx = fUnbounded;
+            return;
+        }
+    }
+
+    CellRange range;
+    ICellRange(mins, maxs, range);
+    int numCells = 1;
+    for (int i = 0; i < 3; i++)
+        numCells *= range.fHi[i] - range.fLo[i] + 1;
+    if (numCells > kMaxQueryCells) {
+        IAllLights(idx);
+        return;
+    }
+
+    if (++fStamp == 0) {
+        std::fill(fStamps.begin(), fStamps.end(), 0);
+        fStamp = 1;
+    }
+
+    for (int z = range.fLo[2]; z <= range.fHi[2]; z++) {
+        for (int y = range.fLo[1]; y <= range.fHi[1]; y++) {
+            for (int x = range.fLo[0]; x <= range.fHi[0]; x++) {
+                int cell = ICellIndex(x, y, z);
+                for (uint32_t i = fCellStart[cell]; i < fCellStart[cell + 1]; i++) {
+                    uint16_t light = fCellLights[i];
+                    if (fStamps[light] != fStamp) {
+                        fStamps[light] = fStamp;
+                        idx.emplace_back(light);
+                    }
+                }
+            }
+        }
+    }
+    idx.insert(idx.end(), fUnbounded.begin(), fUnbounded.end());
+    std::sort(idx.begin(), idx.end());
+}
@@ -0,0 +1,112 @@
+/*==LICENSE==*
+
+CyanWorlds.com Engine - MMOG client, server and tools
+Copyright (C) 2011  Cyan Worlds, Inc.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+Additional permissions under GNU GPL version 3 section 7
+
+If you modify this Program, or any covered work, by linking or
+combining it with any of RAD Game Tools Bink SDK, Autodesk 3ds Max SDK,
+NVIDIA PhysX SDK, Microsoft DirectX SDK, OpenSSL library, Independent
+JPEG Group JPEG library, Microsoft Windows Media SDK, or Apple QuickTime SDK
+(or a modified version of those libraries),
+containing parts covered by the terms of the Bink SDK EULA, 3ds Max EULA,
+PhysX SDK EULA, DirectX SDK EULA, OpenSSL and SSLeay licenses, IJG
+JPEG Library README, Windows Media SDK EULA, or QuickTime SDK EULA, the
+licensors of this Program grant you additional
+permission to convey the resulting work. Corresponding Source for a
+non-source form of such a combination shall include the source code for
+the parts of OpenSSL and IJG JPEG Library used as well as that of the covered
+work.
+
+You can contact Cyan Worlds, Inc. by email legal@cyan.com
+ or by snail mail at:
+      Cyan Worlds, Inc.
+      14617 N Newport Hwy
+      Mead, WA   99021
+
+*==LICENSE==*/
+
+#ifndef plLightGrid_inc
+#define plLightGrid_inc
+
+#include <vector>
+
+#include "hsBounds.h"
+#include "hsGeometry3.h"
+
+class plLightInfo;
+
+// A coarse world space grid over the runtime lights of one render pass,
+// built once in BeginVisMgr and then queried once per drawable in place
+// of walking every light. Each light is dropped into the cells its
+// influence box touches, lights with no box (directionals, or anything
+// whose isect doesn't know its extent) get returned for every query.
+// Queries hand back indices into the light list the grid was built from,
+// in ascending order, so callers walking them see the lights in the same
+// order they would walking the whole list. The grid is only a broad phase,
+// it's still up to the caller to run each light's own test.
+class plLightGrid
+{
+protected:
+    enum
+    {
+        kMaxCellsPerAxis    = 16,
+        kMaxQueryCells      = 64,   // Past this, just hand back everything
+    };
+
+    struct CellRange
+    {
+        int     fLo[3];
+        int     fHi[3];
+    };
+
+    size_t                      fNumLights;
+
+    hsPoint3                    fMins;
+    hsPoint3                    fMaxs;
+    float                       fInvCellSize[3];
+    int                         fDims[3];
+    bool                        fHasBounded;
+
+    std::vector<uint32_t>       fCellStart;     // Cell i owns fCellLights[fCellStart[i]..fCellStart[i+1])
+    std::vector<uint16_t>       fCellLights;
+    std::vector<uint16_t>       fUnbounded;
+
+    std::vector<uint32_t>       fStamps;
+    uint32_t                    fStamp;
+
+    std::vector<hsBounds3Ext>   fScratchBounds;
+    std::vector<CellRange>      fScratchRanges;
+    std::vector<uint16_t>       fScratchBounded;
+
+    void ICellRange(const hsPoint3& mins, const hsPoint3& maxs, CellRange& range) const;
+    int ICellIndex(int x, int y, int z) const { return (z * fDims[1] + y) * fDims[0] + x; }
+    void IAllLights(std::vector<uint16_t>& idx) const;
+
+public:
+    plLightGrid();
+
+    void Build(const std::vector<plLightInfo*>& lights);
+    void Clear();
+
+    size_t GetNumLights() const { return fNumLights; }
+
+    // Fills idx with the indices of every light that might touch bnd.
+    void FindLights(const hsBounds3Ext& bnd, std::vector<uint16_t>& idx);
+};
+
+#endif // plLightGrid_inc
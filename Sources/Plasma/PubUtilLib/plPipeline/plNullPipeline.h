@@ -78,7 +78,7 @@ public:
     void CheckIndexBufferRef(plGBufferGroup* owner, uint32_t idx) override { }
     bool OpenAccess(plAccessSpan& dst, plDrawableSpans* d, const plVertexSpan* span, bool readOnly) override { return false; }
     bool CloseAccess(plAccessSpan& acc) override { return false; }
-    void CheckTextureRef(plLayerInterface* lay) override { }
+    void CheckTextureRef(plLayerInterface* lay) override;
     void PushRenderRequest(plRenderRequest* req) override { }
     void PopRenderRequest(plRenderRequest* req) override { }
     void ClearRenderTarget(plDrawable* d) override { }
@@ -99,6 +99,12 @@ public:
     int GetMaxAntiAlias(int Width, int Height, int ColorDepth) override { return 0; }
     void ResetDisplayDevice(int Width, int Height, int ColorDepth, bool Windowed, int NumAASamples, int MaxAnisotropicSamples, bool vSync = false) override { }
     void RenderSpans(plDrawableSpans* ice, const std::vector<int16_t>& visList) override { }
+
+    // Bytes a real device would have copied to keep dynamic textures current
+    uint64_t GetTextureUploadBytes() const { return fTextureUploadBytes; }
+
+protected:
+    uint64_t fTextureUploadBytes = 0;
 };
 
 #endif //_plNullPipeline_inc_
@@ -120,7 +120,9 @@ void    plStatusLogDrawer::Draw(plStatusLog* curLog, plStatusLog* firstLog)
     y += lineHt * 2;
     for( i = 0; i < IGetMaxNumLines( curLog ); i++ )
     {
-        drawText.DrawString(x + 4, y, IGetLines(curLog)[i], IGetColors(curLog)[i]);
+        uint32_t color;
+        ST::string line = IGetLine(curLog, i, color);
+        drawText.DrawString(x + 4, y, line, color);
         y += lineHt;
     }
 
@@ -0,0 +1,263 @@
+/*==LICENSE==*
+
+CyanWorlds.com Engine - MMOG client, server and tools
+Copyright (C) 2011  Cyan Worlds, Inc.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+Additional permissions under GNU GPL version 3 section 7
+
+If you modify this Program, or any covered work, by linking or
+combining it with any of RAD Game Tools Bink SDK, Autodesk 3ds Max SDK,
+NVIDIA PhysX SDK, Microsoft DirectX SDK, OpenSSL library, Independent
+JPEG Group JPEG library, Microsoft Windows Media SDK, or Apple QuickTime SDK
+(or a modified version of those libraries),
+containing parts covered by the terms of the Bink SDK EULA, 3ds Max EULA,
+PhysX SDK EULA, DirectX SDK EULA, OpenSSL and SSLeay licenses, IJG
+JPEG Library README, Windows Media SDK EULA, or QuickTime SDK EULA, the
+licensors of this Program grant you additional
+permission to convey the resulting work. Corresponding Source for a
+non-source form of such a combination shall include the source code for
+the parts of OpenSSL and IJG JPEG Library used as well as that of the covered
+work.
+
+You can contact Cyan Worlds, Inc. by email legal@cyan.com
+ or by snail mail at:
+      Cyan Worlds, Inc.
+      14617 N Newport Hwy
+      Mead, WA   99021
+
+*==LICENSE==*/
+
+#include "plPageBlockStream.h"
+
+#include "plPageInfo.h"
+
+#include "hsExceptions.h"
+#include "hsParallel.h"
+
+#include <algorithm>
+#include <string_theory/format>
+
+#include "plCompression/plZlibCompress.h"
+
+plPageBlockStream::plPageBlockStream(std::unique_ptr<hsStream> file, const plPageInfo& info)
+    : fFile(std::move(file)),
+      fDataStart(info.GetDataStart()),
+      fDataSize(info.GetChecksum()),
+      fBlockSize(info.GetBlockSize()),
+      fBlockOffsets(info.GetBlockOffsets())
+{
+    // Without a usable block table there's nothing past the header
+    if (!info.HasBlockTable())
+        fDataSize = 0;
+    fBlocks.resize(info.GetNumBlocks());
+
+    // Anyone reading the header through us gets the plain version
+    plPageInfo plainInfo = info;
+    plainInfo.ClearBlockCompression();
+
+    hsRAMStream header;
+    plainInfo.Write(&header);
+    hsAssert(header.GetEOF() == fDataStart, "Uncompressed page header doesn't end at the data start");
+
+    fHeader.resize(fDataStart);
+    header.Rewind();
+    header.Read(std::min(header.GetEOF(), fDataStart), fHeader.data());
+}
+
+uint32_t plPageBlockStream::IGetBlockLen(size_t block) const
+{
+    uint32_t blockStart = uint32_t(block) * fBlockSize;
+    return std::min(fBlockSize, fDataSize - blockStart);
+}
+
+bool plPageBlockStream::IInflateBlock(const uint8_t* src, uint32_t srcLen, uint8_t* dst, uint32_t dstLen)
+{
+    // Blocks that didn't shrink are stored as-is
+    if (srcLen == dstLen) {
+        memcpy(dst, src, dstLen);
+        return true;
+    }
+
+    plZlibCompress zlib;
+    uint32_t outLen = dstLen;
+    return zlib.Uncompress(dst, &outLen, src, srcLen) && outLen == dstLen;
+}
+
+const uint8_t* plPageBlockStream::IGetBlock(size_t block)
+{
+    if (block >= fBlocks.size())
+        return nullptr;
+    if (fBlocks[block])
+        return fBlocks[block].get();
+
+    uint32_t srcLen = fBlockOffsets[block + 1] - fBlockOffsets[block];
+    uint32_t dstLen = IGetBlockLen(block);
+    if (fBlockOffsets[block + 1] < fBlockOffsets[block] || srcLen > dstLen)
+        return nullptr;
+
+    auto src = std::make_unique<uint8_t[]>(srcLen);
+    fFile->SetPosition(fBlockOffsets[block]);
+    if (fFile->Read(srcLen, src.get()) != srcLen)
+        return nullptr;
+
+    auto dst = std::make_unique<uint8_t[]>(dstLen);
+    if (!IInflateBlock(src.get(), srcLen, dst.get(), dstLen)) {
+        hsAssert(false, ST::format("Corrupt block {} in compressed page", block).c_str());
+        return nullptr;
+    }
+
+    fBlocks[block] = std::move(dst);
+    return fBlocks[block].get();
+}
+
+void plPageBlockStream::Prefetch()
+{
+    std::vector<size_t> missing;
+    for (size_t i = 0; i < fBlocks.size(); i++) {
+        if (!fBlocks[i])
+            missing.push_back(i);
+    }
+    if (missing.empty())
+        return;
+
+    // Pull all of the compressed data in with one read, then inflate the blocks
+    // in parallel. Each worker only ever touches the blocks it claimed.
+    uint32_t srcStart = fBlockOffsets[missing.front()];
+    uint32_t srcLen = fBlockOffsets[missing.back() + 1] - srcStart;
+    auto src = std::make_unique<uint8_t[]>(srcLen);
+    fFile->SetPosition(srcStart);
+    if (fFile->Read(srcLen, src.get()) != srcLen)
+        return;
+
+    hsParallelForEach(missing.size(), hsParallelMaxThreads(), [&](size_t i) {
+        size_t block = missing[i];
+        uint32_t dstLen = IGetBlockLen(block);
+        auto dst = std::make_unique<uint8_t[]>(dstLen);
+        if (IInflateBlock(src.get() + (fBlockOffsets[block] - srcStart),
+                          fBlockOffsets[block + 1] - fBlockOffsets[block],
+                          dst.get(), dstLen))
+            fBlocks[block] = std::move(dst);
+    });
+}
+
+bool plPageBlockStream::AtEnd()
+{
+    return fPosition >= GetEOF();
+}
+
+uint32_t plPageBlockStream::Read(uint32_t byteCount, void* buffer)
+{
+    uint8_t* out = static_cast<uint8_t*>(buffer);
+    uint32_t bytesRead = 0;
+
+    if (fPosition < fDataStart) {
+        uint32_t len = std::min(byteCount, fDataStart - fPosition);
+        memcpy(out, fHeader.data() + fPosition, len);
+        fPosition += len;
+        bytesRead += len;
+    }
+
+    while (bytesRead < byteCount && fPosition < GetEOF()) {
+        uint32_t dataPos = fPosition - fDataStart;
+        size_t block = dataPos / fBlockSize;
+        uint32_t blockPos = dataPos % fBlockSize;
+
+        const uint8_t* data = IGetBlock(block);
+        if (!data)
+            break;
+
+        uint32_t len = std::min(byteCount - bytesRead, IGetBlockLen(block) - blockPos);
+        memcpy(out + bytesRead, data + blockPos, len);
+        fPosition += len;
+        bytesRead += len;
+    }
+
+    return bytesRead;
+}
+
+uint32_t plPageBlockStream::Write(uint32_t byteCount, const void* buffer)
+{
+    hsThrow("can't write to a compressed page");
+    return 0;
+}
+
+void plPageBlockStream::Skip(uint32_t deltaByteCount)
+{
+    fPosition += deltaByteCount;
+}
+
+void plPageBlockStream::Rewind()
+{
+    fPosition = 0;
+}
+
+void plPageBlockStream::FastFwd()
+{
+    fPosition = GetEOF();
+}
+
+void plPageBlockStream::SetPosition(uint32_t position)
+{
+    fPosition = position;
+}
+
+void plPageBlockStream::Truncate()
+{
+    hsThrow("can't truncate a compressed page");
+}
+
+bool plPageBlockStream::WritePage(hsStream* src, const plPageInfo& info, hsStream* dst, uint32_t blockSize)
+{
+    uint32_t dataStart = info.GetDataStart();
+    uint32_t dataSize = info.GetChecksum();
+    size_t numBlocks = (dataSize + blockSize - 1) / blockSize;
+
+    // The header size only depends on the block count, so write it with
+    // placeholder offsets now and fill them in once the blocks are down.
+    plPageInfo blockInfo = info;
+    std::vector<uint32_t> offsets(numBlocks + 1);
+    blockInfo.SetBlockCompression(blockSize, offsets);
+
+    uint32_t headerPos = dst->GetPosition();
+    blockInfo.Write(dst);
+
+    plZlibCompress zlib;
+    std::vector<uint8_t> raw(blockSize);
+    std::vector<uint8_t> packed(blockSize + blockSize / 10 + 12);
+    for (size_t i = 0; i < numBlocks; i++) {
+        uint32_t blockLen = std::min(blockSize, dataSize - uint32_t(i) * blockSize);
+
+        src->SetPosition(dataStart + uint32_t(i) * blockSize);
+        if (src->Read(blockLen, raw.data()) != blockLen)
+            return false;
+
+        offsets[i] = dst->GetPosition();
+
+        uint32_t packedLen = uint32_t(packed.size());
+        if (zlib.Compress(packed.data(), &packedLen, raw.data(), blockLen) && packedLen < blockLen)
+            dst->Write(packedLen, packed.data());
+        else
+            dst->Write(blockLen, raw.data());
+    }
+    offsets[numBlocks] = dst->GetPosition();
+
+    blockInfo.SetBlockCompression(blockSize, std::move(offsets));
+    dst->SetPosition(headerPos);
+    blockInfo.Write(dst);
+    dst->FastFwd();
+
+    return true;
+}
@@ -0,0 +1,102 @@
+/*==LICENSE==*
+
+CyanWorlds.com Engine - MMOG client, server and tools
+Copyright (C) 2011  Cyan Worlds, Inc.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+Additional permissions under GNU GPL version 3 section 7
+
+If you modify this Program, or any covered work, by linking or
+combining it with any of RAD Game Tools Bink SDK, Autodesk 3ds Max SDK,
+NVIDIA PhysX SDK, Microsoft DirectX SDK, OpenSSL library, Independent
+JPEG Group JPEG library, Microsoft Windows Media SDK, or Apple QuickTime SDK
+(or a modified version of those libraries),
+containing parts covered by the terms of the Bink SDK EULA, 3ds Max EULA,
+PhysX SDK EULA, DirectX SDK EULA, OpenSSL and SSLeay licenses, IJG
+JPEG Library README, Windows Media SDK EULA, or QuickTime SDK EULA, the
+licensors of this Program grant you additional
+permission to convey the resulting work. Corresponding Source for a
+non-source form of such a combination shall include the source code for
+the parts of OpenSSL and IJG JPEG Library used as well as that of the covered
+work.
+
+You can contact Cyan Worlds, Inc. by email legal@cyan.com
+ or by snail mail at:
+      Cyan Worlds, Inc.
+      14617 N Newport Hwy
+      Mead, WA   99021
+
+*==LICENSE==*/
+
+#ifndef plPageBlockStream_h_inc
+#define plPageBlockStream_h_inc
+
+#include "HeadSpin.h"
+#include "hsStream.h"
+
+#include <memory>
+#include <vector>
+
+class plPageInfo;
+
+//
+// Read-only view of a block compressed page, presented with the same layout
+// as the uncompressed page so that key start positions and the index offset
+// can be used unchanged. Blocks are inflated the first time something inside
+// them is read and are kept until the stream is destroyed.
+//
+class plPageBlockStream : public hsStream
+{
+protected:
+    std::unique_ptr<hsStream> fFile;
+    std::vector<uint8_t> fHeader;   // Uncompressed page header, backs [0, fDataStart)
+
+    uint32_t fDataStart;
+    uint32_t fDataSize;
+    uint32_t fBlockSize;
+    std::vector<uint32_t> fBlockOffsets;
+    std::vector<std::unique_ptr<uint8_t[]>> fBlocks;
+
+    uint32_t IGetBlockLen(size_t block) const;
+    const uint8_t* IGetBlock(size_t block);
+
+    static bool IInflateBlock(const uint8_t* src, uint32_t srcLen, uint8_t* dst, uint32_t dstLen);
+
+public:
+    enum { kDefaultBlockSize = 64 * 1024 };
+
+    plPageBlockStream(std::unique_ptr<hsStream> file, const plPageInfo& info);
+
+    // Inflates every block that hasn't been read yet, spread over all cores.
+    // Use it before reading the whole page.
+    void Prefetch();
+
+    bool      AtEnd() override;
+    uint32_t  Read(uint32_t byteCount, void* buffer) override;
+    uint32_t  Write(uint32_t byteCount, const void* buffer) override;    // throws exception
+    void      Skip(uint32_t deltaByteCount) override;
+    void      Rewind() override;
+    void      FastFwd() override;
+    void      SetPosition(uint32_t position) override;
+    void      Truncate() override;
+    uint32_t  GetEOF() override { return fDataStart + fDataSize; }
+
+    // Writes the uncompressed page in src out to dst in block compressed form.
+    // info must describe src.
+    static bool WritePage(hsStream* src, const plPageInfo& info, hsStream* dst,
+                          uint32_t blockSize = kDefaultBlockSize);
+};
+
+#endif // plPageBlockStream_h_inc
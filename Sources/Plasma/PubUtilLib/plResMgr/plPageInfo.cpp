@@ -47,7 +47,11 @@ You can contact Cyan Worlds, Inc. by email legal@cyan.com
 
 #include "pnKeyedObject/plUoid.h"
 
+#include <algorithm>
+
 static uint32_t       sCurrPageInfoVersion = 6;
+// Only written for block compressed pages, so plain pages still load in older clients
+static uint32_t       sBlockPageInfoVersion = 7;
 
 //// Constructor/Destructor //////////////////////////////////////////////////
 plPageInfo::plPageInfo()
@@ -69,6 +73,8 @@ void plPageInfo::IInit()
     fClassVersions.clear();
     fChecksum = 0;
     fDataStart = fIndexStart = 0;
+    fFlags = 0;
+    ClearBlockCompression();
 }
 
 plPageInfo::~plPageInfo()
@@ -98,6 +104,9 @@ void    plPageInfo::ISetFrom( const plPageInfo &src )
     fChecksum = src.fChecksum;
     fDataStart = src.fDataStart;
     fIndexStart = src.fIndexStart;
+    fFlags = src.fFlags;
+    fBlockSize = src.fBlockSize;
+    fBlockOffsets = src.fBlockOffsets;
 }
 
 void    plPageInfo::SetStrings(const ST::string& age, const ST::string& page)
@@ -119,6 +128,20 @@ void plPageInfo::AddClassVersion(uint16_t classIdx, uint16_t version)
     fClassVersions.push_back(cv);
 }
 
+void plPageInfo::SetBlockCompression(uint32_t blockSize, std::vector<uint32_t> blockOffsets)
+{
+    fFlags |= kBlockCompressed;
+    fBlockSize = blockSize;
+    fBlockOffsets = std::move(blockOffsets);
+}
+
+void plPageInfo::ClearBlockCompression()
+{
+    fFlags &= ~kBlockCompressed;
+    fBlockSize = 0;
+    fBlockOffsets.clear();
+}
+
 void plPageInfo::Read( hsStream *s )
 {
     IInit();
@@ -127,7 +150,7 @@ void plPageInfo::Read( hsStream *s )
     // after Uru's online component was cancelled in Feb 2004, so I've removed support for
     // anything prior to that to clean things up a bit.
     uint32_t version = s->ReadLE32();
-    if (version > sCurrPageInfoVersion || version < 5)
+    if (version > sBlockPageInfoVersion || version < 5)
     {
         hsAssert( false, "Invalid header version in plPageInfo::Read()" );
         return;
@@ -166,11 +189,54 @@ void plPageInfo::Read( hsStream *s )
             fClassVersions.push_back(cv);
         }
     }
+
+    if (version >= 7)
+    {
+        s->ReadLE32(&fFlags);
+        if (IsBlockCompressed())
+        {
+            s->ReadLE32(&fBlockSize);
+            uint32_t numBlocks = s->ReadLE32();
+
+            // Don't size anything off the block count until we know the
+            // table actually fits in what's left of the file.
+            uint64_t tableEnd = uint64_t(s->GetPosition()) + (uint64_t(numBlocks) + 1) * sizeof(uint32_t);
+            if (tableEnd > s->GetEOF())
+                return;
+
+            fBlockOffsets.resize(size_t(numBlocks) + 1);
+            s->ReadLE32(fBlockOffsets.size(), fBlockOffsets.data());
+            if (!IValidBlockTable(uint32_t(tableEnd), s->GetEOF()))
+                fBlockOffsets.clear();
+        }
+    }
+}
+
+bool plPageInfo::IValidBlockTable(uint32_t tableEnd, uint32_t fileEnd) const
+{
+    if (fBlockSize == 0 || fIndexStart < fDataStart || fIndexStart - fDataStart > fChecksum)
+        return false;
+
+    // One block per fBlockSize of uncompressed data, laid out in order
+    // between the end of the header and the end of the file.
+    if (GetNumBlocks() != (uint64_t(fChecksum) + fBlockSize - 1) / fBlockSize)
+        return false;
+    if (fBlockOffsets.front() < tableEnd || fBlockOffsets.back() > fileEnd)
+        return false;
+
+    for (size_t i = 0; i < GetNumBlocks(); i++)
+    {
+        // Blocks are never stored bigger than they are uncompressed
+        uint32_t blockLen = std::min(fBlockSize, fChecksum - uint32_t(i) * fBlockSize);
+        if (fBlockOffsets[i + 1] < fBlockOffsets[i] || fBlockOffsets[i + 1] - fBlockOffsets[i] > blockLen)
+            return false;
+    }
+    return true;
 }
 
 void    plPageInfo::Write( hsStream *s )
 {
-    s->WriteLE32( sCurrPageInfoVersion );
+    s->WriteLE32( IsBlockCompressed() ? sBlockPageInfoVersion : sCurrPageInfoVersion );
     fLocation.Write( s );
     s->WriteSafeString( fAge );
     s->WriteSafeString( fPage );
@@ -186,6 +252,14 @@ void    plPageInfo::Write( hsStream *s )
         s->WriteLE16(cv.Class);
         s->WriteLE16(cv.Version);
     }
+
+    if (IsBlockCompressed())
+    {
+        s->WriteLE32(fFlags);
+        s->WriteLE32(fBlockSize);
+        s->WriteLE32((uint32_t)GetNumBlocks());
+        s->WriteLE32(fBlockOffsets.size(), fBlockOffsets.data());
+    }
 }
 
 //// IsValid /////////////////////////////////////////////////////////////////
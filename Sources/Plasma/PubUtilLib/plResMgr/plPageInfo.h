@@ -62,6 +62,11 @@ public:
     struct ClassVersion { uint16_t Class; uint16_t Version; };
     typedef std::vector<ClassVersion> ClassVerVec;
 
+    enum
+    {
+        kBlockCompressed = 0x1,     // Object data is stored in independently compressed blocks
+    };
+
 protected:
     plLocation  fLocation;
     ST::string  fAge;
@@ -71,8 +76,13 @@ protected:
     uint32_t    fChecksum;
     uint32_t    fDataStart, fIndexStart;
 
+    uint32_t    fFlags;
+    uint32_t    fBlockSize;         // Uncompressed size of every block but the last
+    std::vector<uint32_t> fBlockOffsets;    // File offset of each block, plus the end of the last one
+
     void        IInit();
     void        ISetFrom( const plPageInfo &src );
+    bool        IValidBlockTable(uint32_t tableEnd, uint32_t fileEnd) const;
 
 public:
 
@@ -111,5 +121,22 @@ public:
 
     uint32_t  GetIndexStart() const { return fIndexStart; }
     void    SetIndexStart( uint32_t s ) { fIndexStart = s; }
+
+    // Everything past the data start (objects and key index) is split into
+    // fixed size blocks which can be inflated on their own. Data and index
+    // offsets still refer to the uncompressed layout; the checksum is the
+    // uncompressed size of that region.
+    bool    IsBlockCompressed() const { return (fFlags & kBlockCompressed) != 0; }
+    void    SetBlockCompression(uint32_t blockSize, std::vector<uint32_t> blockOffsets);
+    void    ClearBlockCompression();
+
+    // A compressed page whose block table didn't fit the file it was read
+    // from comes back with no blocks at all, and shouldn't be loaded.
+    bool    HasBlockTable() const { return !fBlockOffsets.empty(); }
+
+    uint32_t  GetBlockSize() const { return fBlockSize; }
+    size_t    GetNumBlocks() const { return fBlockOffsets.empty() ? 0 : fBlockOffsets.size() - 1; }
+    const std::vector<uint32_t>& GetBlockOffsets() const { return fBlockOffsets; }
+    uint32_t  GetCompressedSize() const { return fBlockOffsets.empty() ? 0 : fBlockOffsets.back() - fBlockOffsets.front(); }
 };
 #endif // _plPageInfo_h
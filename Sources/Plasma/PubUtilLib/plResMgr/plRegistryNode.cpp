@@ -44,6 +44,7 @@ You can contact Cyan Worlds, Inc. by email legal@cyan.com
 #include <string_theory/format>
 
 #include "hsStream.h"
+#include "plPageBlockStream.h"
 #include "plRegistryHelpers.h"
 #include "plRegistryKeyList.h"
 #include "plVersion.h"
@@ -99,7 +100,16 @@ PageCond plRegistryPageNode::IVerify()
     hsStream* stream = OpenStream();
     if (stream)
     {
-        ourChecksum = stream->GetEOF() - fPageInfo.GetDataStart();
+        if (fPageInfo.IsBlockCompressed())
+        {
+            // The checksum is the uncompressed size, so all we can check here
+            // is that the block table agreed with it and with the file size
+            // when the header was read.
+            if (fPageInfo.HasBlockTable())
+                ourChecksum = fPageInfo.GetChecksum();
+        }
+        else
+            ourChecksum = stream->GetEOF() - fPageInfo.GetDataStart();
         CloseStream();
     }
     if (ourChecksum != fPageInfo.GetChecksum())
@@ -136,7 +146,11 @@ hsStream* plRegistryPageNode::OpenStream()
         if (!stream->Open(fPath, "rb")) {
             return nullptr;
         }
-        fStream = std::move(stream);
+        // Until the page info has been read we just hand out the raw file
+        if (fPageInfo.IsBlockCompressed())
+            fStream = std::make_unique<plPageBlockStream>(std::move(stream), fPageInfo);
+        else
+            fStream = std::move(stream);
     }
     fOpenRequests++;
     return fStream.get();
@@ -152,6 +166,12 @@ void plRegistryPageNode::CloseStream()
     }
 }
 
+void plRegistryPageNode::PrefetchStream()
+{
+    if (fStream && fPageInfo.IsBlockCompressed())
+        static_cast<plPageBlockStream*>(fStream.get())->Prefetch();
+}
+
 void plRegistryPageNode::LoadKeys()
 {
     hsAssert(IsValid(), "Trying to load keys for invalid page");
@@ -246,6 +266,7 @@ void plRegistryPageNode::Write()
     // Some prep stuff.  Assign object IDs for every key in this page, and put the
     // versions of all our creatable types in the pageinfo.
     fPageInfo.ClearClassVersions();
+    fPageInfo.ClearBlockCompression();
 
     KeyMap::const_iterator it;
     for (it = fKeyLists.begin(); it != fKeyLists.end(); it++)
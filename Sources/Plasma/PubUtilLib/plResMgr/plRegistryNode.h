@@ -139,6 +139,10 @@ public:
     hsStream*   OpenStream();
     void        CloseStream();
 
+    // If the page is block compressed, inflate all of it now. Only worth it
+    // when the whole page is about to be read.
+    void        PrefetchStream();
+
     // Export time only.  Before we write to disk, assign all the loaded keys
     // sequential object IDs that they can use to do fast lookups at load time.
     void PrepForWrite();
@@ -1177,6 +1177,7 @@ void plResManager::PageInRoom(const plLocation& page, uint16_t objClassToRef, pl
 
     // Step 0.9: Open the stream on this page, so it remains open for the entire loading process
     pageNode->OpenStream();
+    pageNode->PrefetchStream();
 
     // Step 1: We force a load on all the keys in the given page
     kResMgrLog(2, ILog(2, "...Loading page keys..."));
@@ -87,11 +87,8 @@ static void CalcCreatableVersions()
             CreatableVersions[changedType] = minorVer;
 
             // Bump any classes that derive from this one
-            for (uint16_t toCheck = 0; toCheck < plFactory::GetNumClasses(); toCheck++)
-            {
-                if (plFactory::DerivesFrom(changedType, toCheck))
-                    CreatableVersions[toCheck] = minorVer;
-            }
+            for (uint16_t derived : plFactory::GetDerivedClasses(changedType))
+                CreatableVersions[derived] = minorVer;
         }
     }
 }
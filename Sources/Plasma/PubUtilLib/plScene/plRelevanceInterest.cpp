@@ -0,0 +1,113 @@
+/*==LICENSE==*
+
+CyanWorlds.com Engine - MMOG client, server and tools
+Copyright (C) 2011  Cyan Worlds, Inc.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+Additional permissions under GNU GPL version 3 section 7
+
+If you modify this Program, or any covered work, by linking or
+combining it with any of RAD Game Tools Bink SDK, Autodesk 3ds Max SDK,
+NVIDIA PhysX SDK, Microsoft DirectX SDK, OpenSSL library, Independent
+JPEG Group JPEG library, Microsoft Windows Media SDK, or Apple QuickTime SDK
+(or a modified version of those libraries),
+containing parts covered by the terms of the Bink SDK EULA, 3ds Max EULA,
+PhysX SDK EULA, DirectX SDK EULA, OpenSSL and SSLeay licenses, IJG
+JPEG Library README, Windows Media SDK EULA, or QuickTime SDK EULA, the
+licensors of this Program grant you additional
+permission to convey the resulting work. Corresponding Source for a
+non-source form of such a combination shall include the source code for
+the parts of OpenSSL and IJG JPEG Library used as well as that of the covered
+work.
+
+You can contact Cyan Worlds, Inc. by email legal@cyan.com
+ or by snail mail at:
+      Cyan Worlds, Inc.
+      14617 N Newport Hwy
+      Mead, WA   99021
+
+*==LICENSE==*/
+
+#include "plRelevanceInterest.h"
+
+#include <algorithm>
+
+plRelevanceInterest::plRelevanceInterest()
+    : fEnabled(true), fNearDist(60.f), fFarDist(200.f)
+{
+    fSynchIntervals[kIgnored] = 8.f;
+    fSynchIntervals[kFar] = 4.f;
+    fSynchIntervals[kNear] = 2.f;
+    fSynchIntervals[kFull] = 1.f;
+}
+
+void plRelevanceInterest::SetDistances(float nearDist, float farDist)
+{
+    fNearDist = nearDist;
+    fFarDist = std::max(nearDist, farDist);
+}
+
+void plRelevanceInterest::SetViewer(uint32_t id, const hsPoint3& pos, const hsBitVector& regionsICareAbout)
+{
+    auto it = std::find_if(fViewers.begin(), fViewers.end(), [id](const Viewer& v) { return v.fID == id; });
+    if (it == fViewers.end())
+    {
+        fViewers.emplace_back();
+        it = fViewers.end() - 1;
+        it->fID = id;
+    }
+    it->fPos = pos;
+    it->fRegionsICareAbout = regionsICareAbout;
+}
+
+void plRelevanceInterest::RemoveViewer(uint32_t id)
+{
+    auto it = std::find_if(fViewers.begin(), fViewers.end(), [id](const Viewer& v) { return v.fID == id; });
+    if (it != fViewers.end())
+        fViewers.erase(it);
+}
+
+plRelevanceInterest::Level plRelevanceInterest::GetLevel(const hsPoint3& viewerPos, const hsBitVector& viewerCares,
+                                                         const hsPoint3& subjectPos, const hsBitVector& subjectRegions) const
+{
+    if (!fEnabled)
+        return kFull;
+
+    if (!viewerCares.Empty() && !subjectRegions.Empty() && !subjectRegions.Overlap(viewerCares))
+        return kIgnored;
+
+    float distSq = hsVector3(&subjectPos, &viewerPos).MagnitudeSquared();
+    if (distSq <= fNearDist * fNearDist)
+        return kFull;
+    if (distSq <= fFarDist * fFarDist)
+        return kNear;
+    return kFar;
+}
+
+plRelevanceInterest::Level plRelevanceInterest::GetBestLevel(const hsPoint3& subjectPos, const hsBitVector& subjectRegions) const
+{
+    // Until somebody tells us where they are, we can't know who doesn't care
+    if (!fEnabled || fViewers.empty())
+        return kFull;
+
+    Level best = kIgnored;
+    for (const Viewer& viewer : fViewers)
+    {
+        best = std::max(best, GetLevel(viewer.fPos, viewer.fRegionsICareAbout, subjectPos, subjectRegions));
+        if (best == kFull)
+            break;
+    }
+    return best;
+}
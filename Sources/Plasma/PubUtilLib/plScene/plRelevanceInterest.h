@@ -0,0 +1,120 @@
+/*==LICENSE==*
+
+CyanWorlds.com Engine - MMOG client, server and tools
+Copyright (C) 2011  Cyan Worlds, Inc.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+Additional permissions under GNU GPL version 3 section 7
+
+If you modify this Program, or any covered work, by linking or
+combining it with any of RAD Game Tools Bink SDK, Autodesk 3ds Max SDK,
+NVIDIA PhysX SDK, Microsoft DirectX SDK, OpenSSL library, Independent
+JPEG Group JPEG library, Microsoft Windows Media SDK, or Apple QuickTime SDK
+(or a modified version of those libraries),
+containing parts covered by the terms of the Bink SDK EULA, 3ds Max EULA,
+PhysX SDK EULA, DirectX SDK EULA, OpenSSL and SSLeay licenses, IJG
+JPEG Library README, Windows Media SDK EULA, or QuickTime SDK EULA, the
+licensors of this Program grant you additional
+permission to convey the resulting work. Corresponding Source for a
+non-source form of such a combination shall include the source code for
+the parts of OpenSSL and IJG JPEG Library used as well as that of the covered
+work.
+
+You can contact Cyan Worlds, Inc. by email legal@cyan.com
+ or by snail mail at:
+      Cyan Worlds, Inc.
+      14617 N Newport Hwy
+      Mead, WA   99021
+
+*==LICENSE==*/
+#ifndef plRelevanceInterest_inc
+#define plRelevanceInterest_inc
+
+#include "hsBitVector.h"
+#include "hsGeometry3.h"
+
+#include <vector>
+
+// Works out how much the remote players care about something we own, from the
+// relevance regions everybody is in and how far away they are. Senders use
+// it to stretch out their synchs when nobody close is watching; receivers use
+// it to decide what they don't need to animate or simulate at all.
+//
+// The viewer list is fed by whoever tracks the remote players (the avatars
+// do it themselves in plArmatureMod::IEval). Since every client builds the same
+// region vectors from the same positions, a viewer's regions as seen here
+// match what its own client reports to the server.
+class plRelevanceInterest
+{
+public:
+    enum Level
+    {
+        kIgnored,       // In a region the viewer doesn't care about
+        kFar,           // Cared about, but past the far distance
+        kNear,          // Cared about, between the near and far distances
+        kFull,          // Cared about and close by
+        kNumLevels
+    };
+
+protected:
+    struct Viewer
+    {
+        uint32_t    fID;
+        hsPoint3    fPos;
+        hsBitVector fRegionsICareAbout;
+    };
+    std::vector<Viewer> fViewers;
+
+    bool    fEnabled;
+    float   fNearDist;
+    float   fFarDist;
+    float   fSynchIntervals[kNumLevels];
+
+public:
+    plRelevanceInterest();
+
+    bool GetEnabled() const { return fEnabled; }
+    void SetEnabled(bool on) { fEnabled = on; }
+
+    void SetDistances(float nearDist, float farDist);
+    float GetNearDist() const { return fNearDist; }
+    float GetFarDist() const { return fFarDist; }
+
+    // Seconds between synchs for each level. kFull is the old fixed cadence.
+    void SetSynchInterval(Level level, float secs) { fSynchIntervals[level] = secs; }
+    float GetSynchInterval(Level level) const { return fSynchIntervals[level]; }
+
+    void SetViewer(uint32_t id, const hsPoint3& pos, const hsBitVector& regionsICareAbout);
+    void RemoveViewer(uint32_t id);
+    void ClearViewers() { fViewers.clear(); }
+    size_t GetNumViewers() const { return fViewers.size(); }
+
+    // How interested a viewer is in a subject. Empty region vectors mean
+    // relevance regions aren't in use, so only the distance counts.
+    // Always kFull while disabled.
+    Level GetLevel(const hsPoint3& viewerPos, const hsBitVector& viewerCares,
+                   const hsPoint3& subjectPos, const hsBitVector& subjectRegions) const;
+
+    // The most interested of all the viewers, kFull until any have reported in
+    Level GetBestLevel(const hsPoint3& subjectPos, const hsBitVector& subjectRegions) const;
+
+    // How long whoever owns the subject can wait between synchs
+    float GetSynchInterval(const hsPoint3& subjectPos, const hsBitVector& subjectRegions) const
+    {
+        return fSynchIntervals[GetBestLevel(subjectPos, subjectRegions)];
+    }
+};
+
+#endif // plRelevanceInterest_inc
@@ -46,6 +46,8 @@ You can contact Cyan Worlds, Inc. by email legal@cyan.com
 
 #include "pnKeyedObject/hsKeyedObject.h"
 
+#include "plRelevanceInterest.h"
+
 class hsBitVector;
 struct hsPoint3;
 class plRelevanceRegion;
@@ -64,6 +66,7 @@ public:
 protected:
     std::vector<plRelevanceRegion*> fRegions;
     bool fEnabled;
+    plRelevanceInterest fInterest;
 
     void IAddRegion(plRelevanceRegion *);
     void IRemoveRegion(plRelevanceRegion *);
@@ -79,6 +82,8 @@ public:
     bool GetEnabled() { return fEnabled; }
     void SetEnabled(bool val) { fEnabled = val; }
 
+    plRelevanceInterest& GetInterest() { return fInterest; }
+
     uint32_t GetIndex(const ST::string &regionName);
     void MarkRegion(uint32_t localIdx, uint32_t remoteIdx, bool doICare);
     void SetRegionVectors(const hsPoint3 &pos, hsBitVector &regionsImIn, hsBitVector &regionsICareAbout);
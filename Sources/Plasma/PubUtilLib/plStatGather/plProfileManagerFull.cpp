@@ -152,6 +152,17 @@ plProfileVar* plProfileManagerFull::IFindTimer(const ST::string& name)
     return nullptr;
 }
 
+plProfileVar* plProfileManagerFull::FindTimer(const ST::string& groupName, const ST::string& name)
+{
+    for (plProfileVar* var : fVars)
+    {
+        if (groupName.compare_i(var->GetGroup()) == 0 && name.compare_i(var->GetName()) == 0)
+            return var;
+    }
+
+    return nullptr;
+}
+
 void plProfileManagerFull::GetLaps(LapNames& lapNames)
 {
     for (int i = 0; i < fVars.size(); i++)
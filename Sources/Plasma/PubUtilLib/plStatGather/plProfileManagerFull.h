@@ -124,6 +124,8 @@ public:
     void LogStats(const ST::string& ageName, const ST::string& spawnName);
     plFileName GetProfilePath();
 
+    plProfileVar* FindTimer(const ST::string& groupName, const ST::string& name);
+
     // If you're going to call LogStats, make sure to call this first so all stats will be evaluated before logging
     void ActivateAllStats();
 
@@ -59,13 +59,50 @@ You can contact Cyan Worlds, Inc. by email legal@cyan.com
 #include "plEncryptLogLine.h"
 
 #include "hsFILELock.h"
+#include "hsLockFreeQueue.h"
 #include "plProduct.h"
+#include "plProfile.h"
 #include "hsThread.h"
 #include "hsTimer.h"
 #include "hsWindows.h"
 
 #include "plUnifiedTime/plUnifiedTime.h"
 
+#include <algorithm>
+#include <chrono>
+
+//// plStatusLogLine /////////////////////////////////////////////////////////
+//  A line waiting to be written to a log file. Anything time-sensitive is
+//  captured when the line is added, so the writer thread can format it
+//  whenever it gets around to it.
+
+struct plStatusLogLine
+{
+    ST::string      fLine;
+    plUnifiedTime   fTime;
+    double          fRawTime;
+    size_t          fThreadID;
+
+    plStatusLogLine() : fRawTime(), fThreadID() { }
+    plStatusLogLine(const ST::string& line, uint32_t flags)
+        : fLine(line), fRawTime(), fThreadID()
+    {
+        if (flags & (plStatusLog::kTimestamp | plStatusLog::kTimestampGMT |
+                     plStatusLog::kTimeInSeconds | plStatusLog::kTimeAsDouble))
+            fTime = plUnifiedTime::GetCurrent();
+        if (flags & plStatusLog::kRawTimeStamp)
+            fRawTime = hsTimer::GetSeconds();
+        if (flags & plStatusLog::kThreadID)
+            fThreadID = hsThread::ThisThreadHash();
+    }
+};
+
+class plStatusLogQueue : public hsLockFreeQueue<plStatusLogLine>
+{
+public:
+    using hsLockFreeQueue<plStatusLogLine>::hsLockFreeQueue;
+};
+
 //////////////////////////////////////////////////////////////////////////////
 //// plStatusLogMgr Stuff ////////////////////////////////////////////////////
 //////////////////////////////////////////////////////////////////////////////
@@ -79,12 +116,33 @@ plFileName plStatusLogMgr::IGetBasePath()
 //// Constructor & Destructor ////////////////////////////////////////////////
 
 plStatusLogMgr::plStatusLogMgr()
-    : fDisplays(), fCurrDisplay(), fDrawer(), fLastLogChangeTime()
+    : fDisplays(), fCurrDisplay(), fDrawer(), fLastLogChangeTime(),
+      fWriterRunning(false), fWriterShutdown(false)
 {
 }
 
 plStatusLogMgr::~plStatusLogMgr()
 {
+    // Stop the writer thread; anything logged from here on out is written
+    // directly by whoever logs it
+    {
+        hsLockGuard(fWriterMutex);
+        fWriterShutdown = true;
+    }
+    if (fWriterThread.joinable())
+    {
+        fWriterRunning = false;
+        fWriterEvent.Signal();
+        fWriterThread.join();
+    }
+    for (plStatusLog* log : fWriterLogs)
+    {
+        log->fQueued = false;
+        hsLockGuard(log->fFileMutex);
+        log->IWriteQueue();
+    }
+    fWriterLogs.clear();
+
     // Unlink all the displays, but don't delete them; leave that to whomever owns them
     while (fDisplays != nullptr)
     {
@@ -217,6 +275,64 @@ plStatusLog *plStatusLogMgr::FindLog( const plFileName &filename, bool createIfN
     return log;
 }
 
+//// Writer Thread /////////////////////////////////////////////////////////
+//  Logs register themselves the first time they have something for their
+//  file. The thread is started along with the first one.
+
+bool plStatusLogMgr::IRegisterWriter(plStatusLog* log)
+{
+    hsLockGuard(fWriterMutex);
+    if (fWriterShutdown)
+        return false;
+
+    fWriterLogs.push_back(log);
+    if (!fWriterThread.joinable())
+    {
+        fWriterRunning = true;
+        fWriterThread = hsThread::StartSimpleThread([this] { IWriterProc(); });
+    }
+    return true;
+}
+
+void plStatusLogMgr::IUnregisterWriter(plStatusLog* log)
+{
+    hsLockGuard(fWriterMutex);
+    auto it = std::find(fWriterLogs.begin(), fWriterLogs.end(), log);
+    if (it != fWriterLogs.end())
+        fWriterLogs.erase(it);
+    log->fQueued = false;
+}
+
+void plStatusLogMgr::IWriterProc()
+{
+    hsThread::SetThisThreadName(ST_LITERAL("StatusLogWriter"));
+
+    while (fWriterRunning)
+    {
+        fWriterEvent.Wait(std::chrono::milliseconds(kWriterIntervalMs));
+
+        plProfile_TraceScope("Status Log Write");
+        hsLockGuard(fWriterMutex);
+        for (plStatusLog* log : fWriterLogs)
+        {
+            hsLockGuard(log->fFileMutex);
+            log->IWriteQueue();
+        }
+    }
+}
+
+//// FlushLogs ///////////////////////////////////////////////////////////////
+
+void plStatusLogMgr::FlushLogs()
+{
+    hsLockGuard(fWriterMutex);
+    for (plStatusLog* log : fWriterLogs)
+    {
+        hsLockGuard(log->fFileMutex);
+        log->IWriteQueue();
+    }
+}
+
 //// BounceLogs ///////////////////////////////////////////////////////////////
 
 void plStatusLogMgr::BounceLogs()
@@ -236,6 +352,10 @@ void plStatusLogMgr::BounceLogs()
 bool plStatusLogMgr::DumpLogs( const plFileName &newFolderName )
 {
     bool retVal = true; // assume success
+
+    // Make sure what we copy is actually up to date
+    FlushLogs();
+
     plFileName newPath;
     plFileName basePath = IGetBasePath();
     if (basePath.IsValid())
@@ -261,7 +381,8 @@ uint32_t plStatusLog::fLoggingOff = false;
 
 plStatusLog::plStatusLog( uint8_t numDisplayLines, const plFileName &filename, uint32_t flags )
     : fFileHandle(), fSize(), fForceLog(), fMaxNumLines(numDisplayLines),
-      fDisplayPointer()
+      fFirstLine(), fQueued(false), fDroppedLines(0), fReportedDrops(),
+      fAppendOnReopen(), fDisplayPointer()
 {
     if (filename.IsValid())
     {
@@ -290,6 +411,7 @@ void    plStatusLog::IInit()
     fFlags = fOrigFlags;
 
     fLines = new ST::string[fMaxNumLines];
+    fFirstLine = 0;
     fColors = new uint32_t[ fMaxNumLines ];
     for( i = 0; i < fMaxNumLines; i++ )
     {
@@ -328,7 +450,7 @@ void plStatusLog::IReOpen()
             plFileSystem::Move(fileToOpen, work);
         }
         
-        if (fFlags & kAppendToLast)
+        if ((fFlags & kAppendToLast) || fAppendOnReopen)
         {
             fFileHandle = plFileSystem::Open(fileToOpen, "at");
             hsAssert(fFileHandle != nullptr, ST::format("Failed to open log file {} for appending, errno = {}", fileToOpen.GetFileName(), errno).c_str());
@@ -338,7 +460,7 @@ void plStatusLog::IReOpen()
             fFileHandle = plFileSystem::Open(fileToOpen, "wt");
             hsAssert(fFileHandle != nullptr, ST::format("Failed to open log file {} for writing, errno = {}", fileToOpen.GetFileName(), errno).c_str());
             // if we need to reopen lets just append
-            fFlags |= kAppendToLast;
+            fAppendOnReopen = true;
         }
     }
 
@@ -359,10 +481,20 @@ void    plStatusLog::IFini()
 {
     int     i;
 
-    if (fFileHandle != nullptr)
+    // Take ourselves away from the writer thread and finish the job ourselves
+    if (fQueued)
+        plStatusLogMgr::GetInstance().IUnregisterWriter(this);
+
     {
-        fclose( fFileHandle );
-        fFileHandle = nullptr;
+        hsLockGuard(fFileMutex);
+        if (fQueue)
+            IWriteQueue();
+
+        if (fFileHandle != nullptr)
+        {
+            fclose( fFileHandle );
+            fFileHandle = nullptr;
+        }
     }
 
     if( *fDisplayPointer == this )
@@ -427,29 +559,110 @@ void    plStatusLog::ILink( plStatusLog **back )
 
 void plStatusLog::IAddLine(const ST::string& line, uint32_t color)
 {
-    int     i;
-
     if(fLoggingOff && !fForceLog)
         return;
 
-    /// Scroll pointers up
-    hsFILELock fileLock(fFileHandle);
-    hsLockGuard(fileLock);
-
+    /// Overwrite the oldest line in the display ring
     if (fMaxNumLines > 0)
     {
-        for( i = 0; i < fMaxNumLines - 1; i++ )
+        hsLockGuard(fDisplayMutex);
+        fLines[fFirstLine] = line;
+        fColors[fFirstLine] = color;
+        fFirstLine = (fFirstLine + 1) % fMaxNumLines;
+    }
+
+    if (!(fFlags & kDontWriteFile))
+        IQueueLine(line);
+
+    if (fFlags & kDebugOutput)
+    {
+
+#if HS_BUILD_FOR_WIN32
+#ifndef PLASMA_EXTERNAL_RELEASE
+        ST::wchar_buffer buf = line.to_wchar();
+        OutputDebugStringW(buf.c_str());
+        OutputDebugStringW(L"\n");
+#endif
+#else
+        fwrite(line.c_str(), 1, line.size(), stderr);
+        fputc('\n', stderr);
+#endif
+    }
+
+    if (fFlags & kStdout)
+    {
+        fwrite(line.c_str(), 1, line.size(), stdout);
+        fputc('\n', stdout);
+    }
+}
+
+//// IQueueLine //////////////////////////////////////////////////////////////
+//  Hand a line off to the writer thread. If the writer can't keep up, the
+//  line is dropped (and counted) rather than stalling the caller.
+
+void plStatusLog::IQueueLine(const ST::string& line)
+{
+    std::call_once(fQueueOnce, [this] {
+        fQueue = std::make_unique<plStatusLogQueue>(plStatusLogMgr::kWriterQueueSize);
+        fQueued = plStatusLogMgr::GetInstance().IRegisterWriter(this);
+    });
+
+    bool wasEmpty = fQueue->empty();
+    if (!fQueue->push(plStatusLogLine(line, fFlags)))
+        fDroppedLines.fetch_add(1, std::memory_order_relaxed);
+
+    if (fQueued)
+    {
+        if (wasEmpty)
+            plStatusLogMgr::GetInstance().IWakeWriter();
+    }
+    else
+    {
+        // No writer thread (it's already been shut down), so write it out now
+        hsLockGuard(fFileMutex);
+        IWriteQueue();
+    }
+}
+
+//// IWriteQueue /////////////////////////////////////////////////////////////
+//  Write out everything that's been queued up. Called with fFileMutex held.
+
+void plStatusLog::IWriteQueue()
+{
+    plStatusLogLine entry;
+    if (!fQueue->pop(entry))
+        return;
+
+    if (!fFileHandle)
+        IReOpen();
+
+    {
+        hsFILELock fileLock(fFileHandle);
+        hsLockGuard(fileLock);
+
+        do
+        {
+            IPrintLineToFile(entry);
+        } while (fQueue->pop(entry));
+
+        uint32_t dropped = fDroppedLines.load(std::memory_order_relaxed);
+        if (dropped != fReportedDrops)
         {
-            fLines[ i ] = std::move(fLines[ i + 1 ]);
-            fColors[ i ] = fColors[ i + 1 ];
+            IPrintLineToFile(plStatusLogLine(ST::format("--------- {} Lines Dropped ---------", dropped - fReportedDrops), fFlags));
+            fReportedDrops = dropped;
         }
 
-        /// Add new
-        fLines[i] = line;
-        fColors[i] = color;
+        if (fFileHandle != nullptr && !(fFlags & kNonFlushedLog))
+            fflush(fFileHandle);
     }
 
-    IPrintLineToFile(line);
+    // Start a fresh file once this one gets too big. This is done outside of
+    // the file lock, since that needs the handle to unlock.
+    if (fFileHandle != nullptr && fSize >= kMaxFileSize)
+    {
+        fclose(fFileHandle);
+        fFileHandle = nullptr;
+    }
 }
 
 //// AddLine /////////////////////////////////////////////////////////////////
@@ -483,7 +696,7 @@ void    plStatusLog::Clear()
 {
     int     i;
 
-
+    hsLockGuard(fDisplayMutex);
     for( i = 0; i < fMaxNumLines; i++ )
     {
         fLines[i] = ST::string();
@@ -498,96 +711,68 @@ void    plStatusLog::Bounce( uint32_t flags)
     if (flags)
         fOrigFlags=flags;
     Clear();
-    if (fFileHandle != nullptr)
     {
-        fclose( fFileHandle );
-        fFileHandle = nullptr;
+        // Anything still queued belongs in the old file
+        hsLockGuard(fFileMutex);
+        if (fQueue)
+            IWriteQueue();
+
+        if (fFileHandle != nullptr)
+        {
+            fclose( fFileHandle );
+            fFileHandle = nullptr;
+        }
     }
     AddLine( "--------- Bounced Log ---------" );
 }
 
 //// IPrintLineToFile ////////////////////////////////////////////////////////
 
-void plStatusLog::IPrintLineToFile(const ST::string& line)
+void plStatusLog::IPrintLineToFile(const plStatusLogLine& line)
 {
-    if( fFlags & kDontWriteFile )
+    if (fFileHandle == nullptr)
         return;
 
-    if (!fFileHandle)
-        IReOpen();
+    ST::string_stream buf;
 
-    if (fFileHandle != nullptr)
-    {
-        ST::string_stream buf;
+    //build line to write to log file
 
-        //build line to write to log file
-
-        if (!line.empty())
+    if (!line.fLine.empty())
+    {
+        if ( fFlags & kTimestamp )
         {
-            if ( fFlags & kTimestamp )
-            {
-                buf << '(' << plUnifiedTime::GetCurrent(plUnifiedTime::kLocal).Format("%m/%d %H:%M:%S") << ") ";
-            }
-            if ( fFlags & kTimestampGMT )
-            {
-                buf << '(' << plUnifiedTime::GetCurrent().Format("%m/%d %H:%M:%S UTC") << ") ";
-            }
-            if ( fFlags & kTimeInSeconds )
-            {
-                buf << '(' << plUnifiedTime::GetCurrent(plUnifiedTime::kLocal).GetSecs() << ") ";
-            }
-            if ( fFlags & kTimeAsDouble )
-            {
-                buf << '(' << plUnifiedTime::GetCurrent(plUnifiedTime::kLocal).GetSecsDouble() << ") ";
-            }
-            if (fFlags & kRawTimeStamp)
-            {
-                buf << ST::format("[t={10f}] ", hsTimer::GetSeconds());
-            }
-            if (fFlags & kThreadID)
-            {
-                buf << "[t=" << hsThread::ThisThreadHash() << "] ";
-            }
-
-            buf << line << '\n';
+            plUnifiedTime localTime = line.fTime;
+            localTime.SetMode(plUnifiedTime::kLocal);
+            buf << '(' << localTime.Format("%m/%d %H:%M:%S") << ") ";
         }
-
+        if ( fFlags & kTimestampGMT )
         {
-            size_t written = fwrite(buf.raw_buffer(), 1, buf.size(), fFileHandle);
-            if (ferror(fFileHandle) == 0) {
-                fSize += written;
-                if (!(fFlags & kNonFlushedLog))
-                    fflush(fFileHandle);
-            } else {
-                hsAssert(false, ST::format("Failed to write to log file {}, errno = {}", GetFileName().GetFileName(), errno).c_str());
-            }
+            buf << '(' << line.fTime.Format("%m/%d %H:%M:%S UTC") << ") ";
         }
-
-        if ( fSize>=kMaxFileSize )
+        if ( fFlags & kTimeInSeconds )
         {
-            plStatusLogMgr::GetInstance().BounceLogs();
+            buf << '(' << line.fTime.GetSecs() << ") ";
+        }
+        if ( fFlags & kTimeAsDouble )
+        {
+            buf << '(' << line.fTime.GetSecsDouble() << ") ";
+        }
+        if (fFlags & kRawTimeStamp)
+        {
+            buf << ST::format("[t={10f}] ", line.fRawTime);
+        }
+        if (fFlags & kThreadID)
+        {
+            buf << "[t=" << line.fThreadID << "] ";
         }
 
+        buf << line.fLine << '\n';
     }
 
-    if (fFlags & kDebugOutput)
-    {
-
-#if HS_BUILD_FOR_WIN32
-#ifndef PLASMA_EXTERNAL_RELEASE
-        ST::wchar_buffer buf = line.to_wchar();
-        OutputDebugStringW(buf.c_str());
-        OutputDebugStringW(L"\n");
-#endif
-#else
-        fwrite(line.c_str(), 1, line.size(), stderr);
-        fputc('\n', stderr);
-#endif
-    }
-
-    if (fFlags & kStdout)
-    {
-        fwrite(line.c_str(), 1, line.size(), stdout);
-        fputc('\n', stdout);
+    size_t written = fwrite(buf.raw_buffer(), 1, buf.size(), fFileHandle);
+    if (ferror(fFileHandle) == 0) {
+        fSize += written;
+    } else {
+        hsAssert(false, ST::format("Failed to write to log file {}, errno = {}", GetFileName().GetFileName(), errno).c_str());
     }
 }
@@ -50,6 +50,8 @@ You can contact Cyan Worlds, Inc. by email legal@cyan.com
 //  output to the file, though; they maintain a scrolling buffer that       //
 //  can be drawn on to the screen so you can actually view what's being     //
 //  outputted to the log file (you can disable file writing if you wish).   //
+//  File writes are done on a background thread, so adding a line never     //
+//  waits on the disk.                                                      //
 //                                                                          //
 //////////////////////////////////////////////////////////////////////////////
 
@@ -60,7 +62,15 @@ You can contact Cyan Worlds, Inc. by email legal@cyan.com
 #include "plFileSystem.h"
 #include "plLoggable.h"
 
+#include <atomic>
+#include <memory>
+#include <mutex>
 #include <string_theory/format>
+#include <thread>
+#include <vector>
+
+#include "hsLockGuard.h"
+#include "hsThread.h"
 
 class plPipeline;
 
@@ -70,6 +80,8 @@ class plPipeline;
 
 class plStatusLogMgr;
 class plStatusLogDrawerStub;
+struct plStatusLogLine;
+class plStatusLogQueue;
 
 class plStatusLog : public plLog
 {
@@ -80,17 +92,29 @@ class plStatusLog : public plLog
     protected:
 
 
-        mutable uint32_t      fFlags;     // Mutable so we can change it in IPrintLineToFile() internally
+        uint32_t  fFlags;
         uint32_t  fOrigFlags;
 
         uint32_t     fMaxNumLines;
         plFileName   fFilename;
         ST::string*  fLines;
         uint32_t*    fColors;
+        uint32_t     fFirstLine;            // Oldest line in the fLines/fColors ring
+        std::mutex   fDisplayMutex;
         FILE*        fFileHandle;
         size_t       fSize;
         bool         fForceLog;
 
+        // File output is handed off to plStatusLogMgr's writer thread through
+        // this queue. Everything below fFileMutex is only touched with it held.
+        std::unique_ptr<plStatusLogQueue> fQueue;
+        std::once_flag      fQueueOnce;
+        std::atomic<bool>   fQueued;
+        std::atomic<uint32_t> fDroppedLines;
+        std::mutex          fFileMutex;
+        uint32_t            fReportedDrops;
+        bool                fAppendOnReopen;
+
         plStatusLog *fNext, **fBack;
 
         plStatusLog **fDisplayPointer;      // Inside pfConsole
@@ -99,7 +123,9 @@ class plStatusLog : public plLog
         void    ILink( plStatusLog **back );
 
         void    IAddLine(const ST::string& line, uint32_t color);
-        void    IPrintLineToFile(const ST::string& line);
+        void    IQueueLine(const ST::string& line);
+        void    IWriteQueue();
+        void    IPrintLineToFile(const plStatusLogLine& line);
         void    IParseFileName(plFileName &fileNoExt, ST::string &ext) const;
         static plStatusLog* IFindLog(const plFileName& filename);
 
@@ -227,6 +253,10 @@ class plStatusLog : public plLog
         const plFileName &GetFileName() const { return fFilename; }
 
         void SetForceLog(bool force) { fForceLog = force; }
+
+        // Number of lines that never made it to the file because the writer
+        // thread fell too far behind
+        uint32_t GetDroppedLines() const { return fDroppedLines.load(std::memory_order_relaxed); }
 };
 
 
@@ -250,13 +280,28 @@ class plStatusLogMgr
 
         double fLastLogChangeTime;
 
+        // Background file writer
+        std::thread                 fWriterThread;
+        hsEvent                     fWriterEvent;
+        std::mutex                  fWriterMutex;
+        std::vector<plStatusLog*>   fWriterLogs;
+        std::atomic<bool>           fWriterRunning;
+        bool                        fWriterShutdown;
+
         static plFileName IGetBasePath();
 
+        bool        IRegisterWriter(plStatusLog* log);
+        void        IUnregisterWriter(plStatusLog* log);
+        void        IWakeWriter() { fWriterEvent.Signal(); }
+        void        IWriterProc();
+
     public:
 
         enum
         {
-            kDefaultNumLines    = 40
+            kDefaultNumLines    = 40,
+            kWriterQueueSize    = 1024,     // Lines each log can have in flight to the writer
+            kWriterIntervalMs   = 50,       // How often the writer wakes up when idle
         };
 
         ~plStatusLogMgr();
@@ -276,6 +321,9 @@ class plStatusLogMgr
 
         void        BounceLogs();
 
+        // Block until every queued line has been written out
+        void        FlushLogs();
+
         // Create a new folder and copy all log files into it (returns false on failure)
         bool        DumpLogs( const plFileName &newFolderName );
 };
@@ -292,11 +340,18 @@ class plStatusLogDrawerStub
     protected:
 
         uint32_t      IGetMaxNumLines( plStatusLog *log ) const { return log->fMaxNumLines; }
-        const ST::string* IGetLines( plStatusLog *log ) const { return log->fLines; }
         plFileName    IGetFilename( plStatusLog *log ) const { return log->GetFileName(); }
-        uint32_t     *IGetColors( plStatusLog *log ) const { return log->fColors; }
         uint32_t      IGetFlags( plStatusLog *log ) const { return log->fFlags; }
-        
+
+        // Line 0 is the oldest one on screen
+        ST::string    IGetLine( plStatusLog *log, uint32_t line, uint32_t &color ) const
+        {
+            hsLockGuard(log->fDisplayMutex);
+            uint32_t idx = (log->fFirstLine + line) % log->fMaxNumLines;
+            color = log->fColors[idx];
+            return log->fLines[idx];
+        }
+
     public:
         virtual ~plStatusLogDrawerStub() {}
 
@@ -0,0 +1,107 @@
+/*==LICENSE==*
+
+CyanWorlds.com Engine - MMOG client, server and tools
+Copyright (C) 2011  Cyan Worlds, Inc.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+Additional permissions under GNU GPL version 3 section 7
+
+If you modify this Program, or any covered work, by linking or
+combining it with any of RAD Game Tools Bink SDK, Autodesk 3ds Max SDK,
+NVIDIA PhysX SDK, Microsoft DirectX SDK, OpenSSL library, Independent
+JPEG Group JPEG library, Microsoft Windows Media SDK, or Apple QuickTime SDK
+(or a modified version of those libraries),
+containing parts covered by the terms of the Bink SDK EULA, 3ds Max EULA,
+PhysX SDK EULA, DirectX SDK EULA, OpenSSL and SSLeay licenses, IJG
+JPEG Library README, Windows Media SDK EULA, or QuickTime SDK EULA, the
+licensors of this Program grant you additional
+permission to convey the resulting work. Corresponding Source for a
+non-source form of such a combination shall include the source code for
+the parts of OpenSSL and IJG JPEG Library used as well as that of the covered
+work.
+
+You can contact Cyan Worlds, Inc. by email legal@cyan.com
+ or by snail mail at:
+      Cyan Worlds, Inc.
+      14617 N Newport Hwy
+      Mead, WA   99021
+
+*==LICENSE==*/
+
+#include <gtest/gtest.h>
+#include <thread>
+#include <vector>
+
+#include "hsLockFreeQueue.h"
+
+TEST(hsLockFreeQueue, FillAndDrain)
+{
+    hsLockFreeQueue<int> queue(5);
+    EXPECT_EQ(8, queue.capacity());
+    EXPECT_TRUE(queue.empty());
+
+    int value = -1;
+    EXPECT_FALSE(queue.pop(value));
+    EXPECT_EQ(-1, value);
+
+    for (int lap = 0; lap < 3; ++lap) {
+        for (int i = 0; i < 8; ++i)
+            EXPECT_TRUE(queue.push(lap * 8 + i));
+        EXPECT_FALSE(queue.push(100));
+
+        for (int i = 0; i < 8; ++i) {
+            ASSERT_TRUE(queue.pop(value));
+            EXPECT_EQ(lap * 8 + i, value);
+        }
+        EXPECT_FALSE(queue.pop(value));
+        EXPECT_TRUE(queue.empty());
+    }
+}
+
+TEST(hsLockFreeQueue, MultipleProducers)
+{
+    constexpr int kProducers = 4;
+    constexpr int kPerProducer = 10000;
+
+    hsLockFreeQueue<int> queue(64);
+    std::vector<std::thread> producers;
+    for (int p = 0; p < kProducers; ++p) {
+        producers.emplace_back([&queue, p] {
+            for (int i = 0; i < kPerProducer; ++i) {
+                while (!queue.push(p * kPerProducer + i))
+                    std::this_thread::yield();
+            }
+        });
+    }
+
+    // Each producer's values must come out in the order they went in
+    std::vector<int> last(kProducers, -1);
+    int received = 0;
+    while (received < kProducers * kPerProducer) {
+        int value;
+        if (!queue.pop(value)) {
+            std::this_thread::yield();
+            continue;
+        }
+        int producer = value / kPerProducer;
+        EXPECT_LT(last[producer], value);
+        last[producer] = value;
+        ++received;
+    }
+
+    for (std::thread& thread : producers)
+        thread.join();
+    EXPECT_TRUE(queue.empty());
+}
@@ -0,0 +1,114 @@
+/*==LICENSE==*
+
+CyanWorlds.com Engine - MMOG client, server and tools
+Copyright (C) 2011  Cyan Worlds, Inc.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+Additional permissions under GNU GPL version 3 section 7
+
+If you modify this Program, or any covered work, by linking or
+combining it with any of RAD Game Tools Bink SDK, Autodesk 3ds Max SDK,
+NVIDIA PhysX SDK, Microsoft DirectX SDK, OpenSSL library, Independent
+JPEG Group JPEG library, Microsoft Windows Media SDK, or Apple QuickTime SDK
+(or a modified version of those libraries),
+containing parts covered by the terms of the Bink SDK EULA, 3ds Max EULA,
+PhysX SDK EULA, DirectX SDK EULA, OpenSSL and SSLeay licenses, IJG
+JPEG Library README, Windows Media SDK EULA, or QuickTime SDK EULA, the
+licensors of this Program grant you additional
+permission to convey the resulting work. Corresponding Source for a
+non-source form of such a combination shall include the source code for
+the parts of OpenSSL and IJG JPEG Library used as well as that of the covered
+work.
+
+You can contact Cyan Worlds, Inc. by email legal@cyan.com
+ or by snail mail at:
+      Cyan Worlds, Inc.
+      14617 N Newport Hwy
+      Mead, WA   99021
+
+*==LICENSE==*/
+
+#include <gtest/gtest.h>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "hsParallel.h"
+
+TEST(hsParallel, EachItemOnce)
+{
+    // Run a lot of small jobs back to back, so workers coming in late from
+    // one job can't end up running bands from the next.
+    for (size_t numItems : { 0, 1, 7, 1000, 4099 }) {
+        for (int pass = 0; pass < 50; ++pass) {
+            std::vector<std::atomic<int>> hits(numItems);
+            hsParallelFor(numItems, hsParallelMaxThreads(), [&](size_t first, size_t count) {
+                for (size_t i = first; i < first + count; ++i)
+                    hits[i]++;
+            });
+            for (size_t i = 0; i < numItems; ++i)
+                ASSERT_EQ(1, hits[i].load()) << "item " << i << " of " << numItems;
+        }
+    }
+}
+
+TEST(hsParallel, ForEachAndNesting)
+{
+    constexpr size_t kOuter = 64;
+    constexpr size_t kInner = 100;
+
+    // The inner loops run on whatever thread picked up the outer item
+    std::vector<std::atomic<int>> hits(kOuter * kInner);
+    hsParallelForEach(kOuter, hsParallelMaxThreads(), [&](size_t outer) {
+        hsParallelForEach(kInner, hsParallelMaxThreads(), [&](size_t inner) {
+            hits[outer * kInner + inner]++;
+        });
+    });
+    for (const std::atomic<int>& hit : hits)
+        EXPECT_EQ(1, hit.load());
+}
+
+TEST(hsParallel, ConcurrentCallers)
+{
+    constexpr int kCallers = 4;
+    constexpr size_t kItems = 10000;
+
+    std::vector<std::atomic<size_t>> sums(kCallers);
+    std::vector<std::thread> callers;
+    for (int c = 0; c < kCallers; ++c) {
+        callers.emplace_back([&sums, c] {
+            for (int pass = 0; pass < 20; ++pass) {
+                hsParallelFor(kItems, hsParallelMaxThreads(), [&](size_t first, size_t count) {
+                    size_t sum = 0;
+                    for (size_t i = first; i < first + count; ++i)
+                        sum += i;
+                    sums[c] += sum;
+                });
+            }
+        });
+    }
+    for (std::thread& thread : callers)
+        thread.join();
+
+    for (const std::atomic<size_t>& sum : sums)
+        EXPECT_EQ(20 * (kItems * (kItems - 1) / 2), sum.load());
+}
+
+TEST(hsParallel, ThreadCount)
+{
+    EXPECT_GE(hsParallelMaxThreads(), 1);
+    EXPECT_EQ(1, hsParallelThreads(10, 100));
+    EXPECT_EQ(std::min<size_t>(hsParallelMaxThreads(), 3), hsParallelThreads(300, 100));
+}
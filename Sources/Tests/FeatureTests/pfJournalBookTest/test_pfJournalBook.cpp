@@ -0,0 +1,317 @@
+/*==LICENSE==*
+
+CyanWorlds.com Engine - MMOG client, server and tools
+Copyright (C) 2011  Cyan Worlds, Inc.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+Additional permissions under GNU GPL version 3 section 7
+
+If you modify this Program, or any covered work, by linking or
+combining it with any of RAD Game Tools Bink SDK, Autodesk 3ds Max SDK,
+NVIDIA PhysX SDK, Microsoft DirectX SDK, OpenSSL library, Independent
+JPEG Group JPEG library, Microsoft Windows Media SDK, or Apple QuickTime SDK
+(or a modified version of those libraries),
+containing parts covered by the terms of the Bink SDK EULA, 3ds Max EULA,
+PhysX SDK EULA, DirectX SDK EULA, OpenSSL and SSLeay licenses, IJG
+JPEG Library README, Windows Media SDK EULA, or QuickTime SDK EULA, the
+licensors of this Program grant you additional
+permission to convey the resulting work. Corresponding Source for a
+non-source form of such a combination shall include the source code for
+the parts of OpenSSL and IJG JPEG Library used as well as that of the covered
+work.
+
+You can contact Cyan Worlds, Inc. by email legal@cyan.com
+ or by snail mail at:
+      Cyan Worlds, Inc.
+      14617 N Newport Hwy
+      Mead, WA   99021
+
+*==LICENSE==*/
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <random>
+#include <string_theory/string>
+#include <string_theory/string_stream>
+#include <vector>
+
+#include "hsResMgr.h"
+#include "hsStream.h"
+#include "plFileSystem.h"
+
+#include "pfGameGUIMgr/pfGUIDialogMod.h"
+#include "pfGameGUIMgr/pfGUIDynDisplayCtrl.h"
+#include "pfJournalBook/pfJournalBook.h"
+#include "pfJournalBook/pfJournalPageCache.h"
+#include "pnKeyedObject/plFixedKey.h"
+#include "plGImage/plDynamicTextMap.h"
+#include "plGImage/plFontCache.h"
+#include "plResMgr/plResManager.h"
+#include "plResMgr/plResMgrSettings.h"
+
+// A real book, paginated through the real IRenderPage, with just enough GUI
+// around it to hand out the turn-back page's DTMap. Laying a book out cold
+// and then picking its pages back up out of pfJournalPageCache has to put
+// every page start (and every paragraph split) in the same place.
+
+using Position = pfJournalPageCache::Position;
+
+static const ST::string kGUIName = ST_LITERAL("TestBook");
+
+// The tag pfJournalDlgProc gives the turn-back page's display control
+static constexpr uint32_t kTurnBackDTMapTag = 104;
+
+// Every printable ASCII glyph the same 9x12 block; only the metrics matter
+static void WriteSyntheticFont(const plFileName& fileName)
+{
+    constexpr uint32_t kWidth = 9, kHeight = 12, kNumChars = 95;
+
+    hsUNIXStream s;
+    ASSERT_TRUE(s.Open(fileName, "wb"));
+
+    char face[256] = "Synthetic";
+    s.Write(sizeof(face), face);
+    s.WriteByte(uint8_t(12));
+    s.WriteLE32(uint32_t(0));
+
+    s.WriteLE32(kWidth);
+    s.WriteLE32(kHeight * kNumChars);
+    s.WriteLE32(kHeight);
+    s.WriteByte(uint8_t(8));
+    for (uint32_t i = 0; i < kWidth * kHeight * kNumChars; i++)
+        s.WriteByte(uint8_t(0xff));
+
+    s.WriteLE16(uint16_t(32));
+    s.WriteLE32(kNumChars);
+    for (uint32_t i = 0; i < kNumChars; i++) {
+        s.WriteLE32(i * kWidth * kHeight);
+        s.WriteLE32(kHeight);
+        s.WriteLE32(kHeight - 3);
+        s.WriteLEFloat(0.f);
+        s.WriteLEFloat(0.f);
+    }
+}
+
+// Random words in paragraphs of all lengths, some centered, with the odd
+// page break. The same seed always starts the same way, so asking for more
+// paragraphs gives a book that only grew at the end.
+static ST::string MakeBook(uint32_t seed, int numParagraphs)
+{
+    std::mt19937 rng(seed);
+    ST::string_stream source;
+    source << "<font face=Synthetic size=12>";
+    for (int p = 0; p < numParagraphs; p++) {
+        if (p % 11 == 10)
+            source << "<pb>";
+        source << ((p % 3 == 0) ? "<p align=center>" : "<p>");
+        int words = 10 + rng() % 200;
+        for (int w = 0; w < words; w++) {
+            int len = 1 + rng() % 9;
+            for (int i = 0; i < len; i++)
+                source << char('a' + rng() % 26);
+            source << ' ';
+        }
+    }
+    return source.to_string();
+}
+
+class TestDisplayCtrl : public pfGUIDynDisplayCtrl
+{
+public:
+    TestDisplayCtrl(plDynamicTextMap* map)
+    {
+        SetTagID(kTurnBackDTMapTag);
+        fTextMaps.emplace_back(map);
+    }
+    ~TestDisplayCtrl() { fTextMaps.clear(); }
+};
+
+class TestDialog : public pfGUIDialogMod
+{
+public:
+    TestDialog(pfGUIControlMod* ctrl) { fControls.emplace_back(ctrl); }
+    ~TestDialog() { fControls.clear(); }
+};
+
+class TestBookData : public pfBookData
+{
+public:
+    TestBookData(pfGUIDialogMod* dialog) : pfBookData(kGUIName) { fDialog = dialog; }
+};
+
+class TestJournalBook : public pfJournalBook
+{
+public:
+    TestJournalBook(const ST::string& source)
+        : pfJournalBook(source, {}, {}, plLocation::kGlobalFixedLoc, kGUIName)
+    { }
+
+    // Stands in for pfJournalBook::LoadGUI, which would go to the GUI manager
+    static void SetBookData(pfBookData* data)
+    {
+        if (data)
+            fBookGUIs[kGUIName] = data;
+        else
+            fBookGUIs.erase(kGUIName);
+    }
+
+    const std::vector<uint32_t>& GetPageStarts() const { return fPageStarts; }
+    std::vector<Position> GetPagePositions() const { return IGetPageStartPositions(); }
+    size_t GetNumChunks() const { return fHTMLSource.size(); }
+    uint32_t GetLastPage() const { return fLastPage; }
+};
+
+class pfJournalBookTest : public testing::Test
+{
+protected:
+    static plFontCache* sFontCache;
+
+    plDynamicTextMap    fDTMap;
+    TestDisplayCtrl*    fDisplay;
+    TestDialog*         fDialog;
+    TestBookData*       fBookData;
+
+    static void SetUpTestSuite()
+    {
+        plFileSystem::CreateDir("fonts");
+        WriteSyntheticFont(plFileName::Join("fonts", "Synthetic.p2f"));
+
+        plResMgrSettings::Get().SetLoadPagesOnInit(false);
+        hsgResMgr::Init(new plResManager);
+
+        sFontCache = new plFontCache;
+        sFontCache->LoadCustomFonts("fonts");
+    }
+
+    static void TearDownTestSuite()
+    {
+        sFontCache->UnRegisterAs(kFontCache_KEY);
+        sFontCache = nullptr;
+        hsgResMgr::Shutdown();
+    }
+
+    void SetUp() override
+    {
+        pfJournalPageCache::Clear();
+
+        fDTMap.Create(512, 512, true);
+        fDisplay = new TestDisplayCtrl(&fDTMap);
+        fDialog = new TestDialog(fDisplay);
+        fBookData = new TestBookData(fDialog);
+        TestJournalBook::SetBookData(fBookData);
+    }
+
+    void TearDown() override
+    {
+        TestJournalBook::SetBookData(nullptr);
+        delete fBookData;
+        delete fDialog;
+        delete fDisplay;
+        pfJournalPageCache::Clear();
+    }
+
+    // Paints the DTMap so we can tell whether anybody laid out a page on it
+    std::vector<uint8_t> IPaintDTMap()
+    {
+        hsColorRGBA marker;
+        marker.Set(0.25f, 0.5f, 0.75f, 1.f);
+        fDTMap.ClearToColor(marker);
+        const uint8_t* image = static_cast<const uint8_t*>(fDTMap.GetImage());
+        return std::vector<uint8_t>(image, image + fDTMap.GetCurrLevelSize());
+    }
+
+    bool IDTMapUntouched(const std::vector<uint8_t>& painted)
+    {
+        const uint8_t* image = static_cast<const uint8_t*>(fDTMap.GetImage());
+        return std::equal(painted.begin(), painted.end(), image);
+    }
+};
+
+plFontCache* pfJournalBookTest::sFontCache = nullptr;
+
+TEST_F(pfJournalBookTest, WarmMatchesCold)
+{
+    ASSERT_NE(plFontCache::GetInstance().GetFont("Synthetic", 12, 0), nullptr);
+
+    ST::string source = MakeBook(7, 60);
+
+    std::vector<uint32_t> coldStarts;
+    std::vector<Position> coldPositions;
+    size_t coldChunks;
+    uint32_t coldLastPage;
+    {
+        TestJournalBook cold(source);
+        cold.ForceCacheCalculations();
+        coldStarts = cold.GetPageStarts();
+        coldPositions = cold.GetPagePositions();
+        coldChunks = cold.GetNumChunks();
+        coldLastPage = cold.GetLastPage();
+    }
+
+    // Make sure this was a real workout: plenty of pages, and paragraphs
+    // split across them
+    ASSERT_GT(coldLastPage, 8U);
+    ASSERT_EQ(coldStarts.size(), coldLastPage + 2);
+    EXPECT_GT(coldChunks, TestJournalBook(source).GetNumChunks());
+    EXPECT_EQ(pfJournalPageCache::GetNumLayouts(), 1U);
+
+    // Second time round, every page comes out of the cache without a single
+    // one being laid out again
+    std::vector<uint8_t> painted = IPaintDTMap();
+    TestJournalBook warm(source);
+    warm.ForceCacheCalculations();
+    EXPECT_TRUE(IDTMapUntouched(painted));
+    EXPECT_EQ(warm.GetPageStarts(), coldStarts);
+    EXPECT_EQ(warm.GetPagePositions(), coldPositions);
+    EXPECT_EQ(warm.GetNumChunks(), coldChunks);
+    EXPECT_EQ(warm.GetLastPage(), coldLastPage);
+}
+
+TEST_F(pfJournalBookTest, GrownBookMatchesCold)
+{
+    ST::string source = MakeBook(11, 40);
+    ST::string grown = MakeBook(11, 70);
+
+    // What the longer book looks like, laid out from scratch
+    std::vector<uint32_t> coldStarts;
+    std::vector<Position> coldPositions;
+    size_t coldChunks;
+    uint32_t coldLastPage;
+    {
+        TestJournalBook cold(grown);
+        cold.ForceCacheCalculations();
+        coldStarts = cold.GetPageStarts();
+        coldPositions = cold.GetPagePositions();
+        coldChunks = cold.GetNumChunks();
+        coldLastPage = cold.GetLastPage();
+    }
+    pfJournalPageCache::Clear();
+
+    // Now read the shorter one first, then the longer one picks up its
+    // pages from there and lays out the rest
+    {
+        TestJournalBook shorter(source);
+        shorter.ForceCacheCalculations();
+        ASSERT_GT(shorter.GetLastPage(), 4U);
+    }
+
+    TestJournalBook warm(grown);
+    warm.ForceCacheCalculations();
+    EXPECT_EQ(warm.GetPageStarts(), coldStarts);
+    EXPECT_EQ(warm.GetPagePositions(), coldPositions);
+    EXPECT_EQ(warm.GetNumChunks(), coldChunks);
+    EXPECT_EQ(warm.GetLastPage(), coldLastPage);
+}
@@ -0,0 +1,157 @@
+/*==LICENSE==*
+
+CyanWorlds.com Engine - MMOG client, server and tools
+Copyright (C) 2011  Cyan Worlds, Inc.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+Additional permissions under GNU GPL version 3 section 7
+
+If you modify this Program, or any covered work, by linking or
+combining it with any of RAD Game Tools Bink SDK, Autodesk 3ds Max SDK,
+NVIDIA PhysX SDK, Microsoft DirectX SDK, OpenSSL library, Independent
+JPEG Group JPEG library, Microsoft Windows Media SDK, or Apple QuickTime SDK
+(or a modified version of those libraries),
+containing parts covered by the terms of the Bink SDK EULA, 3ds Max EULA,
+PhysX SDK EULA, DirectX SDK EULA, OpenSSL and SSLeay licenses, IJG
+JPEG Library README, Windows Media SDK EULA, or QuickTime SDK EULA, the
+licensors of this Program grant you additional
+permission to convey the resulting work. Corresponding Source for a
+non-source form of such a combination shall include the source code for
+the parts of OpenSSL and IJG JPEG Library used as well as that of the covered
+work.
+
+You can contact Cyan Worlds, Inc. by email legal@cyan.com
+ or by snail mail at:
+      Cyan Worlds, Inc.
+      14617 N Newport Hwy
+      Mead, WA   99021
+
+*==LICENSE==*/
+
+#include <gtest/gtest.h>
+#include <string_theory/string>
+#include <vector>
+
+#include "pfJournalBook/pfJournalPageCache.h"
+
+using Position = pfJournalPageCache::Position;
+
+class pfJournalPageCacheTest : public testing::Test
+{
+protected:
+    pfJournalPageCache::Context fContext;
+
+    void SetUp() override
+    {
+        pfJournalPageCache::Clear();
+        fContext.fGUIName = ST_LITERAL("BkBook");
+        fContext.fTMargin = fContext.fLMargin = fContext.fBMargin = fContext.fRMargin = 16;
+        fContext.fWidth = fContext.fHeight = 512;
+    }
+
+    void TearDown() override
+    {
+        pfJournalPageCache::Clear();
+    }
+
+    // Chunk hash chain for a book whose chunks hash to the given seeds
+    static std::vector<size_t> IMakeBook(const std::vector<size_t>& seeds)
+    {
+        std::vector<size_t> hashes;
+        size_t chain = 0;
+        for (size_t seed : seeds) {
+            chain = pfJournalPageCache::ChainHash(chain, seed);
+            hashes.emplace_back(chain);
+        }
+        return hashes;
+    }
+
+    static std::vector<size_t> ISeeds(size_t count)
+    {
+        std::vector<size_t> seeds;
+        for (size_t i = 0; i < count; ++i)
+            seeds.emplace_back(i * 31 + 7);
+        return seeds;
+    }
+};
+
+TEST_F(pfJournalPageCacheTest, cold)
+{
+    std::vector<Position> starts = pfJournalPageCache::Find(fContext, IMakeBook(ISeeds(100)));
+    ASSERT_EQ(starts.size(), 1);
+    EXPECT_EQ(starts[0], (Position{ 0, 0 }));
+}
+
+TEST_F(pfJournalPageCacheTest, warm)
+{
+    std::vector<size_t> book = IMakeBook(ISeeds(100));
+    std::vector<Position> pages = { { 0, 0 }, { 10, 0 }, { 10, 250 }, { 42, 0 }, { 100, 0 } };
+    pfJournalPageCache::Store(fContext, book, pages);
+
+    EXPECT_EQ(pfJournalPageCache::Find(fContext, book), pages);
+
+    // Laid out with different margins, so none of it applies
+    pfJournalPageCache::Context other = fContext;
+    other.fLMargin = 32;
+    EXPECT_EQ(pfJournalPageCache::Find(other, book).size(), 1);
+}
+
+TEST_F(pfJournalPageCacheTest, changed_chunk)
+{
+    std::vector<size_t> seeds = ISeeds(100);
+    std::vector<Position> pages = { { 0, 0 }, { 10, 0 }, { 10, 250 }, { 42, 0 }, { 100, 0 } };
+    pfJournalPageCache::Store(fContext, IMakeBook(seeds), pages);
+
+    // Chunk 10 is where the second and third pages start, so those depend on it
+    seeds[10] = 12345;
+    std::vector<Position> starts = pfJournalPageCache::Find(fContext, IMakeBook(seeds));
+    EXPECT_EQ(starts, std::vector<Position>(pages.begin(), pages.begin() + 1));
+
+    seeds[10] = ISeeds(100)[10];
+    seeds[60] = 12345;
+    starts = pfJournalPageCache::Find(fContext, IMakeBook(seeds));
+    EXPECT_EQ(starts, std::vector<Position>(pages.begin(), pages.begin() + 4));
+}
+
+TEST_F(pfJournalPageCacheTest, appended)
+{
+    std::vector<size_t> seeds = ISeeds(100);
+    std::vector<Position> pages = { { 0, 0 }, { 10, 0 }, { 42, 0 }, { 100, 0 } };
+    pfJournalPageCache::Store(fContext, IMakeBook(seeds), pages);
+
+    // More text at the end keeps every page but the end of the book
+    seeds.emplace_back(999);
+    std::vector<size_t> longer = IMakeBook(seeds);
+    std::vector<Position> starts = pfJournalPageCache::Find(fContext, longer);
+    EXPECT_EQ(starts, std::vector<Position>(pages.begin(), pages.end() - 1));
+
+    // Storing the longer book doesn't forget the shorter one
+    starts.push_back({ 101, 0 });
+    pfJournalPageCache::Store(fContext, longer, starts);
+    EXPECT_EQ(pfJournalPageCache::GetNumLayouts(), 2);
+    EXPECT_EQ(pfJournalPageCache::Find(fContext, longer), starts);
+    EXPECT_EQ(pfJournalPageCache::Find(fContext, IMakeBook(ISeeds(100))), pages);
+}
+
+TEST_F(pfJournalPageCacheTest, keeps_furthest)
+{
+    std::vector<size_t> book = IMakeBook(ISeeds(100));
+    std::vector<Position> pages = { { 0, 0 }, { 10, 0 }, { 42, 0 }, { 100, 0 } };
+    pfJournalPageCache::Store(fContext, book, pages);
+    pfJournalPageCache::Store(fContext, book, { { 0, 0 }, { 10, 0 } });
+
+    EXPECT_EQ(pfJournalPageCache::GetNumLayouts(), 1);
+    EXPECT_EQ(pfJournalPageCache::Find(fContext, book), pages);
+}
@@ -0,0 +1,201 @@
+/*==LICENSE==*
+
+CyanWorlds.com Engine - MMOG client, server and tools
+Copyright (C) 2011  Cyan Worlds, Inc.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+Additional permissions under GNU GPL version 3 section 7
+
+If you modify this Program, or any covered work, by linking or
+combining it with any of RAD Game Tools Bink SDK, Autodesk 3ds Max SDK,
+NVIDIA PhysX SDK, Microsoft DirectX SDK, OpenSSL library, Independent
+JPEG Group JPEG library, Microsoft Windows Media SDK, or Apple QuickTime SDK
+(or a modified version of those libraries),
+containing parts covered by the terms of the Bink SDK EULA, 3ds Max EULA,
+PhysX SDK EULA, DirectX SDK EULA, OpenSSL and SSLeay licenses, IJG
+JPEG Library README, Windows Media SDK EULA, or QuickTime SDK EULA, the
+licensors of this Program grant you additional
+permission to convey the resulting work. Corresponding Source for a
+non-source form of such a combination shall include the source code for
+the parts of OpenSSL and IJG JPEG Library used as well as that of the covered
+work.
+
+You can contact Cyan Worlds, Inc. by email legal@cyan.com
+ or by snail mail at:
+      Cyan Worlds, Inc.
+      14617 N Newport Hwy
+      Mead, WA   99021
+
+*==LICENSE==*/
+
+#include <gtest/gtest.h>
+#include <filesystem>
+#include <string_theory/format>
+#include <string_theory/string>
+#include <vector>
+
+#include "hsStream.h"
+#include "plFileSystem.h"
+
+#include "pfLocalizationMgr/pfLocalizationDataMgr.h"
+
+static const plFileName s_dataDir = "locTest";
+static const plFileName s_locFile = plFileName::Join(s_dataDir, "Test.loc");
+static const plFileName s_cacheFile = plFileName::Join(s_dataDir, "Test.cache");
+
+static void IWriteLocFile(const ST::string& greeting)
+{
+    ST::string xml = ST::format(
+        "<?xml version=\"1.0\" encoding=\"utf-8\"?>\n"
+        "<localizations>\n"
+        "\t<age name=\"Test\">\n"
+        "\t\t<set name=\"Set\">\n"
+        "\t\t\t<element name=\"Greeting\">\n"
+        "\t\t\t\t<translation language=\"English\">{}</translation>\n"
+        "\t\t\t\t<translation language=\"French\">Bonjour %1s</translation>\n"
+        "\t\t\t</element>\n"
+        "\t\t\t<element name=\"Farewell\">\n"
+        "\t\t\t\t<translation language=\"English\">Goodbye</translation>\n"
+        "\t\t\t</element>\n"
+        "\t\t</set>\n"
+        "\t</age>\n"
+        "</localizations>\n", greeting);
+
+    hsUNIXStream s;
+    ASSERT_TRUE(s.Open(s_locFile, "wb"));
+    s.Write(xml.size(), xml.c_str());
+}
+
+static std::vector<uint8_t> IReadFile(const plFileName& fileName)
+{
+    std::vector<uint8_t> data;
+    hsUNIXStream s;
+    if (s.Open(fileName, "rb")) {
+        data.resize(s.GetEOF());
+        s.Read(data.size(), data.data());
+    }
+    return data;
+}
+
+static void IWriteFile(const plFileName& fileName, const std::vector<uint8_t>& data)
+{
+    hsUNIXStream s;
+    ASSERT_TRUE(s.Open(fileName, "wb"));
+    s.Write(data.size(), data.data());
+}
+
+static ST::string IGreeting()
+{
+    return ST::string(pfLocalizationDataMgr::Instance().GetElement("Test.Set.Greeting"));
+}
+
+class pfLocalizationDataMgrTest : public testing::Test
+{
+protected:
+    void SetUp() override
+    {
+        plFileSystem::CreateDir(s_dataDir);
+        plFileSystem::Unlink(s_cacheFile);
+        IWriteLocFile("Hello %1s");
+    }
+
+    void TearDown() override
+    {
+        pfLocalizationDataMgr::Shutdown();
+    }
+
+    void Reload()
+    {
+        pfLocalizationDataMgr::Shutdown();
+        pfLocalizationDataMgr::Initialize(s_dataDir, s_cacheFile);
+    }
+};
+
+TEST_F(pfLocalizationDataMgrTest, cacheRebuiltWhenSourceChanges)
+{
+    Reload();
+    EXPECT_EQ(ST_LITERAL("Hello %1s"), IGreeting());
+    std::vector<uint8_t> cache = IReadFile(s_cacheFile);
+    ASSERT_FALSE(cache.empty());
+
+    // Same size and time stamp, so the fingerprint still matches and the old
+    // text can only have come out of the cache
+    auto stamp = std::filesystem::last_write_time(s_locFile.AsString().c_str());
+    IWriteLocFile("Howdy %1s");
+    std::filesystem::last_write_time(s_locFile.AsString().c_str(), stamp);
+    Reload();
+    EXPECT_EQ(ST_LITERAL("Hello %1s"), IGreeting());
+    EXPECT_EQ(ST_LITERAL("Bonjour %1s"),
+              ST::string(pfLocalizationDataMgr::Instance().GetSpecificElement("Test.Set.Greeting", "French")));
+    EXPECT_EQ(cache, IReadFile(s_cacheFile));
+
+    // A real edit changes the fingerprint and has to rebuild the cache
+    IWriteLocFile("Greetings %1s");
+    Reload();
+    EXPECT_EQ(ST_LITERAL("Greetings %1s"), IGreeting());
+    EXPECT_NE(cache, IReadFile(s_cacheFile));
+
+    // ... and the rebuilt cache is good for the next run
+    Reload();
+    EXPECT_EQ(ST_LITERAL("Greetings %1s"), IGreeting());
+    EXPECT_EQ(ST_LITERAL("Goodbye"), ST::string(pfLocalizationDataMgr::Instance().GetElement("Test.Set.Farewell")));
+}
+
+TEST_F(pfLocalizationDataMgrTest, damagedCacheDiscarded)
+{
+    Reload();
+    std::vector<uint8_t> cache = IReadFile(s_cacheFile);
+    ASSERT_FALSE(cache.empty());
+
+    // Flip a bit in the payload; the header still matches the .loc files
+    std::vector<uint8_t> damaged = cache;
+    damaged[damaged.size() - 8] ^= 0x10;
+    IWriteFile(s_cacheFile, damaged);
+    Reload();
+    EXPECT_EQ(ST_LITERAL("Hello %1s"), IGreeting());
+    EXPECT_EQ(cache, IReadFile(s_cacheFile));
+
+    // Same for a cache that was cut short
+    damaged.assign(cache.begin(), cache.end() - 16);
+    IWriteFile(s_cacheFile, damaged);
+    Reload();
+    EXPECT_EQ(ST_LITERAL("Hello %1s"), IGreeting());
+    EXPECT_EQ(cache, IReadFile(s_cacheFile));
+}
+
+TEST_F(pfLocalizationDataMgrTest, indexedLookup)
+{
+    Reload();
+    pfLocalizationDataMgr& mgr = pfLocalizationDataMgr::Instance();
+
+    ASSERT_NE(nullptr, mgr.FindElement("Test.Set.Greeting"));
+    EXPECT_EQ(ST_LITERAL("Hello Atrus"), *mgr.FindElement("Test.Set.Greeting") % std::vector<ST::string>{ ST_LITERAL("Atrus") });
+    EXPECT_EQ(nullptr, mgr.FindElement("Test.Set.Missing"));
+    EXPECT_EQ(nullptr, mgr.FindElement("Test.Greeting"));
+    EXPECT_EQ(ST::string(), ST::string(mgr.GetElement("Nowhere.Set.Greeting")));
+
+    // Added and deleted elements have to show up in the index right away
+    EXPECT_TRUE(mgr.AddElement("Test.Set.New"));
+    EXPECT_TRUE(mgr.SetElementPlainTextData("Test.Set.New", "English", "Shorah"));
+    ASSERT_NE(nullptr, mgr.FindElement("Test.Set.New"));
+    EXPECT_EQ(ST_LITERAL("Shorah"), ST::string(*mgr.FindElement("Test.Set.New")));
+    EXPECT_TRUE(mgr.DeleteElement("Test.Set.New"));
+    EXPECT_EQ(nullptr, mgr.FindElement("Test.Set.New"));
+
+    // The index is rebuilt from the cache too
+    Reload();
+    ASSERT_NE(nullptr, pfLocalizationDataMgr::Instance().FindElement("Test.Set.Farewell"));
+    EXPECT_EQ(ST_LITERAL("Goodbye"), ST::string(*pfLocalizationDataMgr::Instance().FindElement("Test.Set.Farewell")));
+}
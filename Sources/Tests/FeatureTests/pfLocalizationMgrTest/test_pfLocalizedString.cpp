@@ -0,0 +1,120 @@
+/*==LICENSE==*
+
+CyanWorlds.com Engine - MMOG client, server and tools
+Copyright (C) 2011  Cyan Worlds, Inc.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+Additional permissions under GNU GPL version 3 section 7
+
+If you modify this Program, or any covered work, by linking or
+combining it with any of RAD Game Tools Bink SDK, Autodesk 3ds Max SDK,
+NVIDIA PhysX SDK, Microsoft DirectX SDK, OpenSSL library, Independent
+JPEG Group JPEG library, Microsoft Windows Media SDK, or Apple QuickTime SDK
+(or a modified version of those libraries),
+containing parts covered by the terms of the Bink SDK EULA, 3ds Max EULA,
+PhysX SDK EULA, DirectX SDK EULA, OpenSSL and SSLeay licenses, IJG
+JPEG Library README, Windows Media SDK EULA, or QuickTime SDK EULA, the
+licensors of this Program grant you additional
+permission to convey the resulting work. Corresponding Source for a
+non-source form of such a combination shall include the source code for
+the parts of OpenSSL and IJG JPEG Library used as well as that of the covered
+work.
+
+You can contact Cyan Worlds, Inc. by email legal@cyan.com
+ or by snail mail at:
+      Cyan Worlds, Inc.
+      14617 N Newport Hwy
+      Mead, WA   99021
+
+*==LICENSE==*/
+
+#include <gtest/gtest.h>
+#include <string_theory/string>
+#include <vector>
+
+#include "hsStream.h"
+
+#include "pfLocalizationMgr/pfLocalizedString.h"
+
+TEST(pfLocalizedString, plainText)
+{
+    pfLocalizedString str(ST_LITERAL("Welcome to D'ni"));
+    EXPECT_EQ(0, str.GetArgumentCount());
+    EXPECT_EQ(ST_LITERAL("Welcome to D'ni"), ST::string(str));
+    EXPECT_EQ(ST_LITERAL("Welcome to D'ni"), str % std::vector<ST::string>());
+    EXPECT_EQ(ST_LITERAL("Welcome to D'ni"), str % std::vector<ST::string>{ ST_LITERAL("unused") });
+
+    pfLocalizedString empty;
+    EXPECT_EQ(ST::string(), empty % std::vector<ST::string>());
+}
+
+TEST(pfLocalizedString, arguments)
+{
+    std::vector<ST::string> args{ ST_LITERAL("Atrus"), ST_LITERAL("Riven") };
+
+    pfLocalizedString ordered(ST_LITERAL("%s wrote %s"));
+    EXPECT_EQ(2, ordered.GetArgumentCount());
+    EXPECT_EQ(ST_LITERAL("Atrus wrote Riven"), ordered % args);
+
+    pfLocalizedString indexed(ST_LITERAL("%2s was written by %1s"));
+    EXPECT_EQ(2, indexed.GetArgumentCount());
+    EXPECT_EQ(ST_LITERAL("Riven was written by Atrus"), indexed % args);
+
+    // Missing arguments just drop out
+    EXPECT_EQ(ST_LITERAL(" wrote "), ordered % std::vector<ST::string>());
+
+    pfLocalizedString escaped(ST_LITERAL("100\\% %s"));
+    EXPECT_EQ(1, escaped.GetArgumentCount());
+    EXPECT_EQ(ST_LITERAL("100% Atrus"), escaped % args);
+}
+
+TEST(pfLocalizedString, xml)
+{
+    pfLocalizedString str;
+    str.FromXML(ST_LITERAL("Tom & %1s"));
+    EXPECT_EQ(1, str.GetArgumentCount());
+    EXPECT_EQ(ST_LITERAL("Tom & Jerry"), str % std::vector<ST::string>{ ST_LITERAL("Jerry") });
+    EXPECT_EQ(ST_LITERAL("Tom &amp; %1s"), str.ToXML());
+}
+
+TEST(pfLocalizedString, readWrite)
+{
+    std::vector<ST::string> args{ ST_LITERAL("Yeesha"), ST_LITERAL("Relto") };
+
+    pfLocalizedString original;
+    original.FromXML(ST_LITERAL("<p>%2s belongs to %1s, 50\\% of the time"));
+
+    hsRAMStream stream;
+    original.Write(&stream);
+    stream.Rewind();
+
+    pfLocalizedString copy;
+    copy.Read(&stream);
+    EXPECT_TRUE(stream.AtEnd());
+
+    EXPECT_EQ(original.GetArgumentCount(), copy.GetArgumentCount());
+    EXPECT_EQ(ST::string(original), ST::string(copy));
+    EXPECT_EQ(original.ToXML(), copy.ToXML());
+    EXPECT_EQ(original % args, copy % args);
+    EXPECT_EQ(ST_LITERAL("<p>Relto belongs to Yeesha, 50% of the time"), copy % args);
+
+    // Long enough that a safe string wouldn't do
+    pfLocalizedString longString(ST::string::fill(0x2000, 'x'));
+    hsRAMStream longStream;
+    longString.Write(&longStream);
+    longStream.Rewind();
+    copy.Read(&longStream);
+    EXPECT_EQ(ST::string(longString), ST::string(copy));
+}
@@ -0,0 +1,137 @@
+/*==LICENSE==*
+
+CyanWorlds.com Engine - MMOG client, server and tools
+Copyright (C) 2011  Cyan Worlds, Inc.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+Additional permissions under GNU GPL version 3 section 7
+
+If you modify this Program, or any covered work, by linking or
+combining it with any of RAD Game Tools Bink SDK, Autodesk 3ds Max SDK,
+NVIDIA PhysX SDK, Microsoft DirectX SDK, OpenSSL library, Independent
+JPEG Group JPEG library, Microsoft Windows Media SDK, or Apple QuickTime SDK
+(or a modified version of those libraries),
+containing parts covered by the terms of the Bink SDK EULA, 3ds Max EULA,
+PhysX SDK EULA, DirectX SDK EULA, OpenSSL and SSLeay licenses, IJG
+JPEG Library README, Windows Media SDK EULA, or QuickTime SDK EULA, the
+licensors of this Program grant you additional
+permission to convey the resulting work. Corresponding Source for a
+non-source form of such a combination shall include the source code for
+the parts of OpenSSL and IJG JPEG Library used as well as that of the covered
+work.
+
+You can contact Cyan Worlds, Inc. by email legal@cyan.com
+ or by snail mail at:
+      Cyan Worlds, Inc.
+      14617 N Newport Hwy
+      Mead, WA   99021
+
+*==LICENSE==*/
+
+#include <gtest/gtest.h>
+#include <string_theory/format>
+#include <string_theory/string>
+#include <utility>
+#include <vector>
+
+#include "hsStream.h"
+
+#include "pfPython/plPythonPack.h"
+
+typedef std::vector<std::pair<ST::string, std::vector<char>>> PackContents;
+
+// Writes a .pak the same way plPythonPack (the tool) does
+static void WritePack(hsStream& s, const PackContents& contents)
+{
+    s.WriteLE32((uint32_t)contents.size());
+    for (const auto& module : contents) {
+        s.WriteSafeString(module.first);
+        s.WriteLE32(0);
+    }
+
+    std::vector<uint32_t> positions;
+    for (const auto& module : contents) {
+        positions.push_back(s.GetPosition());
+        s.WriteLE32((uint32_t)module.second.size());
+        s.Write((uint32_t)module.second.size(), module.second.data());
+    }
+
+    s.SetPosition(sizeof(uint32_t));
+    for (size_t i = 0; i < contents.size(); ++i) {
+        s.WriteSafeString(contents[i].first);
+        s.WriteLE32(positions[i]);
+    }
+}
+
+static std::vector<char> MakeData(size_t size, char seed)
+{
+    std::vector<char> data(size);
+    for (size_t i = 0; i < size; ++i)
+        data[i] = char(seed + i);
+    return data;
+}
+
+TEST(plPythonPack, RoundTrip)
+{
+    PackContents contents;
+    for (int i = 0; i < 64; ++i)
+        contents.emplace_back(ST::format("module{}.py", i), MakeData(16 + i * 7, char(i)));
+    contents.emplace_back(ST_LITERAL("package.__init__.py"), MakeData(3, 'p'));
+
+    hsRAMStream s;
+    WritePack(s, contents);
+
+    plPythonPack pack;
+    ASSERT_TRUE(pack.AddPackStream(&s));
+
+    for (const auto& module : contents) {
+        ST::string name = module.first.before_last('.');
+        EXPECT_TRUE(pack.IsPackedFile(name));
+
+        std::vector<char> data;
+        ASSERT_TRUE(pack.ReadPackedData(name, data));
+        EXPECT_EQ(module.second, data);
+    }
+
+    // Lookups are by module name, never by the file name
+    EXPECT_FALSE(pack.IsPackedFile(ST_LITERAL("module0.py")));
+    EXPECT_FALSE(pack.IsPackedFile(ST_LITERAL("module64")));
+    EXPECT_FALSE(pack.IsPackedFile(ST_LITERAL("package")));
+    EXPECT_FALSE(pack.IsPackedFile(ST::string()));
+}
+
+TEST(plPythonPack, NewestPackWins)
+{
+    hsRAMStream oldStream, newStream, sameStream;
+    WritePack(oldStream, { { ST_LITERAL("xShared.py"), MakeData(8, 'o') },
+                           { ST_LITERAL("xOld.py"), MakeData(8, 'a') } });
+    WritePack(newStream, { { ST_LITERAL("xShared.py"), MakeData(12, 'n') },
+                           { ST_LITERAL("xNew.py"), MakeData(8, 'b') } });
+    WritePack(sameStream, { { ST_LITERAL("xShared.py"), MakeData(4, 's') } });
+
+    plPythonPack pack;
+    pack.AddPackStream(&oldStream, 100);
+    pack.AddPackStream(&newStream, 200);
+    pack.AddPackStream(&sameStream, 200);
+
+    std::vector<char> data;
+    ASSERT_TRUE(pack.ReadPackedData(ST_LITERAL("xShared"), data));
+    EXPECT_EQ(MakeData(12, 'n'), data);
+
+    ASSERT_TRUE(pack.ReadPackedData(ST_LITERAL("xOld"), data));
+    EXPECT_EQ(MakeData(8, 'a'), data);
+    ASSERT_TRUE(pack.ReadPackedData(ST_LITERAL("xNew"), data));
+    EXPECT_EQ(MakeData(8, 'b'), data);
+}
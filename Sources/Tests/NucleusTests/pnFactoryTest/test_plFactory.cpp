@@ -0,0 +1,109 @@
+/*==LICENSE==*
+
+CyanWorlds.com Engine - MMOG client, server and tools
+Copyright (C) 2011  Cyan Worlds, Inc.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+Additional permissions under GNU GPL version 3 section 7
+
+If you modify this Program, or any covered work, by linking or
+combining it with any of RAD Game Tools Bink SDK, Autodesk 3ds Max SDK,
+NVIDIA PhysX SDK, Microsoft DirectX SDK, OpenSSL library, Independent
+JPEG Group JPEG library, Microsoft Windows Media SDK, or Apple QuickTime SDK
+(or a modified version of those libraries),
+containing parts covered by the terms of the Bink SDK EULA, 3ds Max EULA,
+PhysX SDK EULA, DirectX SDK EULA, OpenSSL and SSLeay licenses, IJG
+JPEG Library README, Windows Media SDK EULA, or QuickTime SDK EULA, the
+licensors of this Program grant you additional
+permission to convey the resulting work. Corresponding Source for a
+non-source form of such a combination shall include the source code for
+the parts of OpenSSL and IJG JPEG Library used as well as that of the covered
+work.
+
+You can contact Cyan Worlds, Inc. by email legal@cyan.com
+ or by snail mail at:
+      Cyan Worlds, Inc.
+      14617 N Newport Hwy
+      Mead, WA   99021
+
+*==LICENSE==*/
+
+#include <algorithm>
+#include <gtest/gtest.h>
+
+#include "HeadSpin.h"
+#include "pnFactory/plCreatable.h"
+#include "pnFactory/plFactory.h"
+
+#include "pnKeyedObject/pnKeyedObjectCreatable.h"
+#include "pnMessage/pnMessageCreatable.h"
+
+// The ancestry table has to give exactly the same answers as walking the
+// GetInterface() chain of a real object of that class.
+TEST(plFactory, AncestryMatchesInterfaces)
+{
+    const uint16_t numClasses = plFactory::GetNumClasses();
+    size_t numChecked = 0;
+
+    for (uint16_t hDer = 0; hDer < numClasses; hDer++)
+    {
+        plCreatable* obj = plFactory::CanCreate(hDer) ? plFactory::Create(hDer) : nullptr;
+        if (!obj)
+            continue;
+        numChecked++;
+
+        for (uint16_t hBase = 0; hBase < numClasses; hBase++)
+        {
+            bool expected = obj->GetInterface(hBase) != nullptr;
+            EXPECT_EQ(expected, plFactory::DerivesFrom(hBase, hDer))
+                << plFactory::GetNameOfClass(hDer) << " vs " << hBase;
+        }
+
+        hsRefCnt_SafeUnRef(obj);
+    }
+
+    EXPECT_GT(numChecked, 0U);
+}
+
+TEST(plFactory, DerivedClasses)
+{
+    const uint16_t numClasses = plFactory::GetNumClasses();
+    for (uint16_t hBase = 0; hBase < numClasses; hBase++)
+    {
+        const std::vector<uint16_t>& derived = plFactory::GetDerivedClasses(hBase);
+        size_t expected = 0;
+        for (uint16_t hDer = 0; hDer < numClasses; hDer++)
+        {
+            if (!plFactory::DerivesFrom(hBase, hDer))
+                continue;
+            expected++;
+            EXPECT_NE(derived.end(), std::find(derived.begin(), derived.end(), hDer))
+                << plFactory::GetNameOfClass(hDer) << " from " << hBase;
+        }
+        EXPECT_EQ(expected, derived.size()) << hBase;
+    }
+
+    const std::vector<uint16_t>& refMsgs = plFactory::GetDerivedClasses(plRefMsg::Index());
+    EXPECT_NE(refMsgs.end(), std::find(refMsgs.begin(), refMsgs.end(), plRefMsg::Index()));
+    EXPECT_NE(refMsgs.end(), std::find(refMsgs.begin(), refMsgs.end(), plNodeRefMsg::Index()));
+    EXPECT_EQ(refMsgs.end(), std::find(refMsgs.begin(), refMsgs.end(), plTimeMsg::Index()));
+}
+
+TEST(plFactory, OutOfRange)
+{
+    EXPECT_FALSE(plFactory::DerivesFrom(plMessage::Index(), 0xFFFF));
+    EXPECT_FALSE(plFactory::DerivesFrom(0xFFFF, plRefMsg::Index()));
+    EXPECT_TRUE(plFactory::GetDerivedClasses(0xFFFF).empty());
+}
@@ -0,0 +1,341 @@
+/*==LICENSE==*
+
+CyanWorlds.com Engine - MMOG client, server and tools
+Copyright (C) 2011  Cyan Worlds, Inc.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+Additional permissions under GNU GPL version 3 section 7
+
+If you modify this Program, or any covered work, by linking or
+combining it with any of RAD Game Tools Bink SDK, Autodesk 3ds Max SDK,
+NVIDIA PhysX SDK, Microsoft DirectX SDK, OpenSSL library, Independent
+JPEG Group JPEG library, Microsoft Windows Media SDK, or Apple QuickTime SDK
+(or a modified version of those libraries),
+containing parts covered by the terms of the Bink SDK EULA, 3ds Max EULA,
+PhysX SDK EULA, DirectX SDK EULA, OpenSSL and SSLeay licenses, IJG
+JPEG Library README, Windows Media SDK EULA, or QuickTime SDK EULA, the
+licensors of this Program grant you additional
+permission to convey the resulting work. Corresponding Source for a
+non-source form of such a combination shall include the source code for
+the parts of OpenSSL and IJG JPEG Library used as well as that of the covered
+work.
+
+You can contact Cyan Worlds, Inc. by email legal@cyan.com
+ or by snail mail at:
+      Cyan Worlds, Inc.
+      14617 N Newport Hwy
+      Mead, WA   99021
+
+*==LICENSE==*/
+
+#include <gtest/gtest.h>
+
+#include <vector>
+
+#include "pnAllCreatables.h"
+#include "plAllCreatables.h"
+
+#include "pnNetCommon/plSDLTypes.h"
+#include "pnSceneObject/plCoordinateInterface.h"
+#include "pnSceneObject/plSceneObject.h"
+
+#include "plAvatar/plArmatureMod.h"
+#include "plAvatar/plAvBrain.h"
+#include "plScene/plRelevanceMgr.h"
+
+// Two clients in the same process, each with its own avatar and relevance
+// manager, talking through a stand-in for the game server. The avatars decide
+// for themselves when to synch, in plArmatureMod::NetworkSynch; all we do is
+// catch what they send. Like the real server, ours only forwards an update to
+// clients whose regions-I-care-about overlap the regions the sender is in.
+
+class TestServer;
+struct TestClient;
+
+// Stands where the avatar is, without any of the transform machinery
+class TestCoordinateInterface : public plCoordinateInterface
+{
+public:
+    hsPoint3 fPos;
+
+    const hsMatrix44& GetLocalToWorld() const override
+    {
+        hsVector3 trans(fPos.fX, fPos.fY, fPos.fZ);
+        fL2W.MakeTranslateMat(&trans);
+        return fL2W;
+    }
+
+private:
+    mutable hsMatrix44 fL2W;
+};
+
+// Hands the avatar's synchs to the server instead of the net client
+class TestSceneObject : public plSceneObject
+{
+public:
+    TestCoordinateInterface fCoord;
+    TestClient*             fClient;
+
+    TestSceneObject(TestClient* client) : fClient(client) { fCoordinateInterface = &fCoord; }
+    ~TestSceneObject() { fCoordinateInterface = nullptr; }
+
+    bool DirtySynchState(const ST::string& sdlName, uint32_t sendFlags) override;
+};
+
+class TestArmatureMod : public plArmatureMod
+{
+public:
+    TestArmatureMod(plSceneObject* so) { fTarget = so; }
+    ~TestArmatureMod()
+    {
+        fTarget = nullptr;
+        fBrains.clear();
+    }
+
+    using plArmatureMod::NetworkSynch;
+    using plArmatureMod::IEvalBrains;
+
+    // Ready to run, with no meshes to pick an LOD from
+    void SetBrain(plArmatureBrain* brain)
+    {
+        fWaitFlags = 0;
+        fDisabledDraw = kDisableReasonUnknown;
+        fBrains.push_back(brain);
+    }
+
+    void SetRegions(const hsBitVector& imIn, const hsBitVector& careAbout)
+    {
+        fRegionsImIn = imIn;
+        fRegionsICareAbout = careAbout;
+    }
+};
+
+// Just counts what it gets asked to do
+class TestBrain : public plArmatureBrain
+{
+public:
+    std::vector<float> fApplied;
+
+    bool Apply(double timeNow, float elapsed) override
+    {
+        fApplied.push_back(elapsed);
+        return true;
+    }
+};
+
+// Each client gets its own, and we swap in whichever client is running
+class TestRelevanceMgr : public plRelevanceMgr
+{
+public:
+    void MakeCurrent() { fInstance = this; }
+    static void ClearCurrent() { fInstance = nullptr; }
+};
+
+struct TestClient
+{
+    uint32_t            fID;
+    TestServer*         fServer;
+    TestRelevanceMgr    fRelevance;
+    TestSceneObject     fSceneObject;
+    TestArmatureMod     fAvatar;
+
+    int                 fSent;
+    int                 fReceived;
+
+    TestClient(uint32_t id, const hsPoint3& pos, uint32_t region)
+        : fID(id), fServer(), fSceneObject(this), fAvatar(&fSceneObject), fSent(), fReceived()
+    {
+        fSceneObject.fCoord.fPos = pos;
+        SetRegion(region);
+    }
+
+    void SetRegion(uint32_t region)
+    {
+        hsBitVector imIn, careAbout;
+        imIn.SetBit(region);
+        careAbout.SetBit(0);
+        careAbout.SetBit(region);
+        fAvatar.SetRegions(imIn, careAbout);
+    }
+};
+
+class TestServer
+{
+    std::vector<TestClient*> fClients;
+
+public:
+    ~TestServer() { TestRelevanceMgr::ClearCurrent(); }
+
+    void Join(TestClient* client)
+    {
+        client->fServer = this;
+        fClients.push_back(client);
+    }
+
+    void Send(TestClient* from, uint32_t sendFlags)
+    {
+        from->fSent++;
+        for (TestClient* to : fClients) {
+            if (to == from)
+                continue;
+            if (!(sendFlags & plSynchedObject::kUseRelevanceRegions) ||
+                from->fAvatar.GetRelRegionImIn().Overlap(to->fAvatar.GetRelRegionCareAbout()))
+                to->fReceived++;
+        }
+    }
+
+    // One frame on every client: the remote avatars report where they are
+    // (IEval does this in the game), then the local avatar gets its chance to synch.
+    void Tick(double timeNow)
+    {
+        for (TestClient* client : fClients) {
+            client->fRelevance.MakeCurrent();
+            plRelevanceInterest& interest = client->fRelevance.GetInterest();
+            for (TestClient* other : fClients) {
+                if (other != client)
+                    interest.SetViewer(other->fID, other->fSceneObject.fCoord.fPos,
+                                       other->fAvatar.GetRelRegionCareAbout());
+            }
+            client->fAvatar.NetworkSynch(timeNow);
+        }
+    }
+
+    void Run(double from, double seconds)
+    {
+        for (int frame = 1; frame <= int(seconds * 30.0); frame++)
+            Tick(from + frame / 30.0);
+    }
+};
+
+bool TestSceneObject::DirtySynchState(const ST::string& sdlName, uint32_t sendFlags)
+{
+    if (sdlName == kSDLAvatarPhysical)
+        fClient->fServer->Send(fClient, sendFlags);
+    return true;
+}
+
+TEST(plArmatureMod, SynchNearby)
+{
+    TestClient a(1, hsPoint3(0.f, 0.f, 0.f), 1);
+    TestClient b(2, hsPoint3(10.f, 0.f, 0.f), 1);
+    TestServer server;
+    server.Join(&a);
+    server.Join(&b);
+    server.Run(0.0, 10.0);
+
+    // Close together, so both keep the old once a second cadence
+    EXPECT_GE(a.fSent, 9);
+    EXPECT_GE(b.fSent, 9);
+    EXPECT_EQ(a.fReceived, b.fSent);
+    EXPECT_EQ(b.fReceived, a.fSent);
+}
+
+TEST(plArmatureMod, SynchFarApart)
+{
+    TestClient a(1, hsPoint3(0.f, 0.f, 0.f), 1);
+    TestClient b(2, hsPoint3(500.f, 0.f, 0.f), 1);
+    TestServer server;
+    server.Join(&a);
+    server.Join(&b);
+    server.Run(0.0, 10.0);
+
+    // Still delivered, just less often
+    EXPECT_GE(a.fSent, 2);
+    EXPECT_LE(a.fSent, 3);
+    EXPECT_EQ(b.fReceived, a.fSent);
+}
+
+TEST(plArmatureMod, SynchOtherRegion)
+{
+    TestClient a(1, hsPoint3(0.f, 0.f, 0.f), 1);
+    TestClient b(2, hsPoint3(5.f, 0.f, 0.f), 2);
+    TestServer server;
+    server.Join(&a);
+    server.Join(&b);
+    server.Run(0.0, 10.0);
+
+    // Neither cares about the other's region: the server would drop these
+    // anyway, so the senders barely bother
+    EXPECT_LE(a.fSent, 1);
+    EXPECT_LE(b.fSent, 1);
+    EXPECT_EQ(a.fReceived, 0);
+    EXPECT_EQ(b.fReceived, 0);
+
+    // Walk b into a's region and it should pick up straight away
+    b.SetRegion(1);
+    int before = a.fReceived;
+    server.Run(10.0, 2.0);
+    EXPECT_GE(a.fReceived - before, 1);
+}
+
+TEST(plArmatureMod, SynchThrottleOff)
+{
+    TestClient a(1, hsPoint3(0.f, 0.f, 0.f), 1);
+    TestClient b(2, hsPoint3(500.f, 0.f, 0.f), 2);
+    a.fRelevance.GetInterest().SetEnabled(false);
+    TestServer server;
+    server.Join(&a);
+    server.Join(&b);
+    server.Run(0.0, 10.0);
+
+    // Back to once a second, whoever is watching
+    EXPECT_GE(a.fSent, 9);
+}
+
+// The other side of the throttle: avatars the local player can't see only get
+// their brains run every so often, but never lose any time over it.
+TEST(plArmatureMod, EvalIgnoredAvatar)
+{
+    TestSceneObject so(nullptr);
+    TestArmatureMod avatar(&so);
+    TestBrain brain;
+    avatar.SetBrain(&brain);
+
+    // Four frames make up the half second an ignored avatar waits
+    for (int frame = 1; frame <= 40; frame++)
+        avatar.IEvalBrains(frame * 0.125, 0.125f, 0, true);
+    ASSERT_EQ(brain.fApplied.size(), 10U);
+    for (float elapsed : brain.fApplied)
+        EXPECT_FLOAT_EQ(elapsed, 0.5f);
+
+    // Anyone we care about runs every frame
+    brain.fApplied.clear();
+    for (int frame = 41; frame <= 50; frame++)
+        avatar.IEvalBrains(frame * 0.125, 0.125f, 0, false);
+    ASSERT_EQ(brain.fApplied.size(), 10U);
+    for (float elapsed : brain.fApplied)
+        EXPECT_FLOAT_EQ(elapsed, 0.125f);
+}
+
+TEST(plArmatureMod, EvalCatchesUp)
+{
+    TestSceneObject so(nullptr);
+    TestArmatureMod avatar(&so);
+    TestBrain brain;
+    avatar.SetBrain(&brain);
+
+    avatar.IEvalBrains(0.125, 0.125f, 0, true);
+    avatar.IEvalBrains(0.25, 0.125f, 0, true);
+    EXPECT_TRUE(brain.fApplied.empty());
+
+    // Walking back into view hands over everything that was held back
+    avatar.IEvalBrains(0.375, 0.125f, 0, false);
+    ASSERT_EQ(brain.fApplied.size(), 1U);
+    EXPECT_FLOAT_EQ(brain.fApplied[0], 0.375f);
+
+    avatar.IEvalBrains(0.5, 0.125f, 0, false);
+    ASSERT_EQ(brain.fApplied.size(), 2U);
+    EXPECT_FLOAT_EQ(brain.fApplied[1], 0.125f);
+}
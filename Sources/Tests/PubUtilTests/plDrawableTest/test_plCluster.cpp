@@ -0,0 +1,262 @@
+/*==LICENSE==*
+
+CyanWorlds.com Engine - MMOG client, server and tools
+Copyright (C) 2011  Cyan Worlds, Inc.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+Additional permissions under GNU GPL version 3 section 7
+
+If you modify this Program, or any covered work, by linking or
+combining it with any of RAD Game Tools Bink SDK, Autodesk 3ds Max SDK,
+NVIDIA PhysX SDK, Microsoft DirectX SDK, OpenSSL library, Independent
+JPEG Group JPEG library, Microsoft Windows Media SDK, or Apple QuickTime SDK
+(or a modified version of those libraries),
+containing parts covered by the terms of the Bink SDK EULA, 3ds Max EULA,
+PhysX SDK EULA, DirectX SDK EULA, OpenSSL and SSLeay licenses, IJG
+JPEG Library README, Windows Media SDK EULA, or QuickTime SDK EULA, the
+licensors of this Program grant you additional
+permission to convey the resulting work. Corresponding Source for a
+non-source form of such a combination shall include the source code for
+the parts of OpenSSL and IJG JPEG Library used as well as that of the covered
+work.
+
+You can contact Cyan Worlds, Inc. by email legal@cyan.com
+ or by snail mail at:
+      Cyan Worlds, Inc.
+      14617 N Newport Hwy
+      Mead, WA   99021
+
+*==LICENSE==*/
+
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <memory>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "hsFastMath.h"
+#include "hsMatrix44.h"
+#include "hsStream.h"
+
+#include "plDrawable/plCluster.h"
+#include "plDrawable/plClusterGroup.h"
+#include "plDrawable/plSpanInstance.h"
+#include "plDrawable/plSpanTemplate.h"
+
+// The template normally comes in with the rest of the group's page data.
+class plClusterTestGroup : public plClusterGroup
+{
+public:
+    void SetTemplate(plSpanTemplate* templ) { fTemplate = templ; }
+};
+
+// A patch of foliage: one template, and clusters of instances with and
+// without per-vert position and color. Unpacking has to lay down exactly
+// the verts the one-vert-at-a-time unpack always did.
+class plClusterTest : public ::testing::Test
+{
+protected:
+    static constexpr uint32_t kNumVerts = 37;   // Leaves a ragged end for the SIMD passes
+    static constexpr uint32_t kNumTris = 30;
+    static constexpr uint32_t kNumInsts = 60;
+
+    std::mt19937 fRng{ 2468u };
+    plClusterTestGroup fGroup;
+    std::vector<std::unique_ptr<plCluster>> fClusters;
+
+    void SetUp() override
+    {
+        std::uniform_real_distribution<float> unit(-1.f, 1.f);
+        std::uniform_int_distribution<uint32_t> color;
+
+        plSpanTemplate* templ = new plSpanTemplate;
+        templ->Alloc(plSpanTemplate::kPosMask | plSpanTemplate::kNormMask | plSpanTemplate::kColorMask | (1 << 4),
+                     kNumVerts, kNumTris);
+        for (uint32_t i = 0; i < kNumVerts; i++) {
+            templ->Position(i)->Set(unit(fRng) * 2.f, unit(fRng) * 2.f, unit(fRng) * 4.f + 4.f);
+            templ->Normal(i)->Set(unit(fRng), unit(fRng), 1.f);
+            templ->Normal(i)->Normalize();
+            *templ->Color(i) = color(fRng);
+            templ->UVWs(i, 0)->Set(unit(fRng), unit(fRng), 0.f);
+        }
+        uint16_t* idx = const_cast<uint16_t*>(templ->IndexData());
+        for (uint32_t i = 0; i < templ->NumIndices(); i++)
+            idx[i] = uint16_t(fRng() % kNumVerts);
+        fGroup.SetTemplate(templ);
+
+        IAddCluster(plSpanEncoding(plSpanEncoding::kPosNone | plSpanEncoding::kColNone, 0.f));
+        IAddCluster(plSpanEncoding(plSpanEncoding::kPos888 | plSpanEncoding::kColRGB888, 1.f / 64.f));
+        IAddCluster(plSpanEncoding(plSpanEncoding::kPos161616 | plSpanEncoding::kColNone, 1.f / 1024.f));
+        IAddCluster(plSpanEncoding(plSpanEncoding::kPosNone | plSpanEncoding::kColI8, 0.f));
+    }
+
+    void IAddCluster(const plSpanEncoding& enc)
+    {
+        std::uniform_real_distribution<float> unit(-1.f, 1.f);
+        std::uniform_int_distribution<uint32_t> color;
+
+        hsRAMStream s;
+        enc.Write(&s);
+        s.WriteLE32(kNumInsts);
+        for (uint32_t i = 0; i < kNumInsts; i++) {
+            hsMatrix44 l2w, rot, scale;
+            rot.MakeRotateMat(hsMatrix44::kUp, unit(fRng) * 3.f);
+            hsVector3 scl(1.f + unit(fRng) * 0.3f, 1.f + unit(fRng) * 0.3f, 1.f + unit(fRng) * 0.3f);
+            scale.MakeScaleMat(&scl);
+            l2w = rot * scale;
+            hsVector3 trans(unit(fRng) * 500.f, unit(fRng) * 500.f, unit(fRng) * 20.f);
+            l2w.SetTranslate(&trans);
+
+            std::vector<hsVector3> delPos(kNumVerts);
+            std::vector<uint32_t> colors(kNumVerts);
+            for (uint32_t j = 0; j < kNumVerts; j++) {
+                delPos[j].Set(unit(fRng), unit(fRng), unit(fRng));
+                colors[j] = color(fRng);
+            }
+
+            plSpanInstance inst;
+            inst.Encode(enc, kNumVerts, (enc.Code() & plSpanEncoding::kPosMask) ? delPos.data() : nullptr,
+                        (enc.Code() & plSpanEncoding::kColMask) ? colors.data() : nullptr);
+            inst.SetLocalToWorld(l2w);
+            inst.Write(&s, enc, kNumVerts);
+        }
+
+        s.Rewind();
+        plCluster* cluster = new plCluster;
+        cluster->Read(&s, &fGroup);
+        fClusters.emplace_back(cluster);
+    }
+
+    // The unpack as it was, one vertex at a time through the matrix operators.
+    static void IReferenceUnPack(const plCluster& cluster, uint8_t* vDst, uint16_t* iDst, int idxOffset)
+    {
+        const plSpanTemplate& templ = *cluster.GetTemplate();
+        const int stride = templ.Stride();
+        for (size_t i = 0; i < cluster.NumInsts(); i++) {
+            for (uint32_t j = 0; j < templ.NumIndices(); j++)
+                *iDst++ = templ.IndexData()[j] + idxOffset;
+            idxOffset += templ.NumVerts();
+
+            memcpy(vDst, templ.VertData(), templ.VertSize());
+
+            const plSpanInstance& inst = cluster.GetInst(i);
+            const hsMatrix44 l2w = inst.LocalToWorld();
+            hsMatrix44 w2l;
+            inst.WorldToLocal().GetTranspose(&w2l);
+
+            const bool perVert = inst.HasPosDelta() || inst.HasColor();
+            plSpanInstanceIter iter(const_cast<plSpanInstance*>(&inst), cluster.GetEncoding(), templ.NumVerts());
+            iter.Begin();
+            for (uint32_t j = 0; j < templ.NumVerts(); j++, iter.Advance()) {
+                hsPoint3* pos = (hsPoint3*)(vDst + templ.PositionOffset());
+                hsVector3* norm = (hsVector3*)(vDst + templ.NormalOffset());
+                uint32_t* color = (uint32_t*)(vDst + templ.ColorOffset());
+                if (perVert)
+                    *pos = iter.Position(*pos);
+                *pos = l2w * *pos;
+                *norm = w2l * *norm;
+                if (perVert) {
+                    hsFastMath::NormalizeAppr(*norm);
+                    *color = iter.Color(*color);
+                }
+                vDst += stride;
+            }
+        }
+    }
+
+    size_t IVertSize(const plCluster& cluster) const { return cluster.NumInsts() * cluster.GetTemplate()->VertSize(); }
+    size_t INumIndices(const plCluster& cluster) const { return cluster.NumInsts() * cluster.GetTemplate()->NumIndices(); }
+};
+
+TEST_F(plClusterTest, UnPackMatchesReference)
+{
+    for (const auto& cluster : fClusters) {
+        std::vector<uint8_t> vWant(IVertSize(*cluster)), vGot(IVertSize(*cluster));
+        std::vector<uint16_t> iWant(INumIndices(*cluster)), iGot(INumIndices(*cluster));
+
+        IReferenceUnPack(*cluster, vWant.data(), iWant.data(), 100);
+        hsBounds3Ext bnd;
+        cluster->UnPack(vGot.data(), iGot.data(), 100, bnd);
+
+        EXPECT_EQ(0, memcmp(vWant.data(), vGot.data(), vWant.size()));
+        EXPECT_EQ(iWant, iGot);
+
+        // And the bounds fit the verts exactly
+        const plSpanTemplate& templ = *cluster->GetTemplate();
+        hsPoint3 lo(1.e33f, 1.e33f, 1.e33f), hi(-1.e33f, -1.e33f, -1.e33f);
+        for (size_t i = 0; i < cluster->NumInsts() * templ.NumVerts(); i++) {
+            const hsPoint3& p = *(const hsPoint3*)(vGot.data() + i * templ.Stride() + templ.PositionOffset());
+            lo.Set(std::min(lo.fX, p.fX), std::min(lo.fY, p.fY), std::min(lo.fZ, p.fZ));
+            hi.Set(std::max(hi.fX, p.fX), std::max(hi.fY, p.fY), std::max(hi.fZ, p.fZ));
+        }
+        EXPECT_EQ(lo, bnd.GetMins());
+        EXPECT_EQ(hi, bnd.GetMaxs());
+    }
+}
+
+TEST_F(plClusterTest, TransformSSE2MatchesFPU)
+{
+    const plSpanTemplate& templ = *fGroup.GetTemplate();
+    const plSpanInstance& inst = fClusters[0]->GetInst(0);
+    const hsMatrix44 l2w = inst.LocalToWorld();
+    hsMatrix44 w2l;
+    inst.WorldToLocal().GetTranspose(&w2l);
+
+    std::vector<uint8_t> fpu(templ.VertData(), templ.VertData() + templ.VertSize());
+    std::vector<uint8_t> sse2 = fpu;
+
+    hsPoint3 fpuLo(1.e33f, 1.e33f, 1.e33f), fpuHi(-1.e33f, -1.e33f, -1.e33f);
+    hsPoint3 sse2Lo = fpuLo, sse2Hi = fpuHi;
+    plCluster::transform_verts_fpu(fpu.data(), templ.NumVerts(), templ.Stride(), templ.PositionOffset(),
+                                   templ.NormalOffset(), l2w, w2l, fpuLo, fpuHi);
+    plCluster::transform_verts_sse2(sse2.data(), templ.NumVerts(), templ.Stride(), templ.PositionOffset(),
+                                    templ.NormalOffset(), l2w, w2l, sse2Lo, sse2Hi);
+
+    EXPECT_EQ(0, memcmp(fpu.data(), sse2.data(), fpu.size()));
+    EXPECT_EQ(fpuLo, sse2Lo);
+    EXPECT_EQ(fpuHi, sse2Hi);
+}
+
+TEST_F(plClusterTest, ConcurrentUnPack)
+{
+    // What plDrawableSpans::UnPackCluster does: every cluster into its own
+    // stretch of one buffer, all at once.
+    size_t vSize = 0, iSize = 0;
+    for (const auto& cluster : fClusters) {
+        vSize += IVertSize(*cluster);
+        iSize += INumIndices(*cluster);
+    }
+
+    std::vector<uint8_t> vWant(vSize), vGot(vSize);
+    std::vector<uint16_t> iWant(iSize), iGot(iSize);
+    std::vector<std::thread> threads;
+    size_t vOff = 0, iOff = 0;
+    for (const auto& cluster : fClusters) {
+        IReferenceUnPack(*cluster, vWant.data() + vOff, iWant.data() + iOff, int(vOff / fGroup.GetTemplate()->Stride()));
+        threads.emplace_back([&cluster, v = vGot.data() + vOff, i = iGot.data() + iOff, off = int(vOff / fGroup.GetTemplate()->Stride())]() {
+            hsBounds3Ext bnd;
+            cluster->UnPack(v, i, off, bnd);
+        });
+        vOff += IVertSize(*cluster);
+        iOff += INumIndices(*cluster);
+    }
+    for (std::thread& thread : threads)
+        thread.join();
+
+    EXPECT_EQ(0, memcmp(vWant.data(), vGot.data(), vSize));
+    EXPECT_EQ(iWant, iGot);
+}
@@ -0,0 +1,286 @@
+/*==LICENSE==*
+
+CyanWorlds.com Engine - MMOG client, server and tools
+Copyright (C) 2011  Cyan Worlds, Inc.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+Additional permissions under GNU GPL version 3 section 7
+
+If you modify this Program, or any covered work, by linking or
+combining it with any of RAD Game Tools Bink SDK, Autodesk 3ds Max SDK,
+NVIDIA PhysX SDK, Microsoft DirectX SDK, OpenSSL library, Independent
+JPEG Group JPEG library, Microsoft Windows Media SDK, or Apple QuickTime SDK
+(or a modified version of those libraries),
+containing parts covered by the terms of the Bink SDK EULA, 3ds Max EULA,
+PhysX SDK EULA, DirectX SDK EULA, OpenSSL and SSLeay licenses, IJG
+JPEG Library README, Windows Media SDK EULA, or QuickTime SDK EULA, the
+licensors of this Program grant you additional
+permission to convey the resulting work. Corresponding Source for a
+non-source form of such a combination shall include the source code for
+the parts of OpenSSL and IJG JPEG Library used as well as that of the covered
+work.
+
+You can contact Cyan Worlds, Inc. by email legal@cyan.com
+ or by snail mail at:
+      Cyan Worlds, Inc.
+      14617 N Newport Hwy
+      Mead, WA   99021
+
+*==LICENSE==*/
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "hsMatrix44.h"
+
+#include "plDrawable/plAccessGeometry.h"
+#include "plDrawable/plAccessSpan.h"
+#include "plDrawable/plCutter.h"
+#include "plDrawable/plGeometrySpan.h"
+#include "plDrawable/plSpanTriBVH.h"
+#include "plDrawable/plSpanTypes.h"
+#include "plSurface/hsGMaterial.h"
+#include "plSurface/plLayer.h"
+
+// Layers normally go in by ref message, which needs a resmgr.
+class plCutterTestMaterial : public hsGMaterial
+{
+public:
+    using hsGMaterial::InsertLayer;
+};
+
+// A rolling page sized patch of ground, the sort of thing footprints and
+// puddles get cut out of. The indexed cut has to give back exactly the polys
+// a cut through every tri would, in the same order.
+class plCutterTest : public ::testing::Test
+{
+protected:
+    static constexpr int kGridSize = 64;
+    static constexpr float kCellSize = 2.f;
+
+    plCutterTestMaterial fMaterial;
+    plLayer              fLayer;
+    plGeometrySpan       fGeo;
+    plAccessSpan         fSrc;
+    plIcicle             fIcicle;
+    plSpanTriBVH         fBVH;
+
+    void SetUp() override
+    {
+        fMaterial.InsertLayer(&fLayer);
+    }
+
+    void TearDown() override
+    {
+        fMaterial.SetNumLayers(0);
+    }
+
+    void MakeGround(const hsMatrix44& l2w, bool waterHeight)
+    {
+        std::mt19937 rng{ 1234u };
+        std::uniform_real_distribution<float> jitter(-0.3f, 0.3f);
+        std::uniform_int_distribution<uint32_t> color(0, 0xffffffff);
+
+        std::vector<hsPoint3> positions;
+        std::vector<hsVector3> normals;
+        std::vector<uint32_t> colors;
+        for (int j = 0; j <= kGridSize; j++) {
+            for (int i = 0; i <= kGridSize; i++) {
+                float x = i * kCellSize + jitter(rng);
+                float y = j * kCellSize + jitter(rng);
+                float z = 3.f * sinf(x * 0.11f) * cosf(y * 0.07f) + jitter(rng);
+                positions.emplace_back(x, y, z);
+
+                hsVector3 norm(-0.33f * cosf(x * 0.11f) * cosf(y * 0.07f),
+                               0.21f * sinf(x * 0.11f) * sinf(y * 0.07f), 1.f);
+                norm.Normalize();
+                normals.emplace_back(norm);
+                colors.emplace_back(color(rng));
+            }
+        }
+
+        std::vector<uint16_t> indices;
+        for (int j = 0; j < kGridSize; j++) {
+            for (int i = 0; i < kGridSize; i++) {
+                uint16_t v00 = uint16_t(j * (kGridSize + 1) + i);
+                uint16_t v10 = uint16_t(v00 + 1);
+                uint16_t v01 = uint16_t(v00 + kGridSize + 1);
+                uint16_t v11 = uint16_t(v01 + 1);
+                indices.insert(indices.end(), { v00, v10, v11, v00, v11, v01 });
+            }
+        }
+
+        fGeo.BeginCreate(&fMaterial, l2w, plGeometrySpan::UVCountToFormat(0));
+        fGeo.AddVertexArray(uint32_t(positions.size()), positions.data(), normals.data(), colors.data());
+        fGeo.AddIndexArray(uint32_t(indices.size()), indices.data());
+        fGeo.EndCreate();
+
+        if (waterHeight) {
+            fGeo.fProps |= plGeometrySpan::kWaterHeight;
+            fGeo.fWaterHeight = 1.5f;
+        }
+
+        plAccessGeometry acc;
+        acc.AccessSpanFromGeometrySpan(fSrc, &fGeo);
+        ASSERT_TRUE(fBVH.Build(fIcicle, fSrc.AccessTri()));
+    }
+
+    // Cutters scattered over the ground in world space, at all sorts of angles.
+    static std::vector<plCutter> MakeCutters(const hsMatrix44& l2w, size_t count)
+    {
+        std::mt19937 rng{ 5678u };
+        std::uniform_real_distribution<float> pos(0.f, kGridSize * kCellSize);
+        std::uniform_real_distribution<float> unit(-1.f, 1.f);
+        std::uniform_real_distribution<float> len(0.5f, 8.f);
+
+        std::vector<plCutter> cutters(count);
+        for (plCutter& cutter : cutters) {
+            cutter.SetLength(hsVector3(len(rng), len(rng), len(rng)));
+
+            hsVector3 out(unit(rng) * 0.5f, unit(rng) * 0.5f, 1.f);
+            out.Normalize();
+            hsVector3 dir(unit(rng), unit(rng), 0.f);
+            if (dir.MagnitudeSquared() < 0.01f)
+                dir.Set(1.f, 0.f, 0.f);
+            dir.Normalize();
+
+            hsPoint3 center = l2w * hsPoint3(pos(rng), pos(rng), unit(rng) * 3.f);
+            cutter.Set(center, l2w * dir, l2w * out, unit(rng) > 0.f);
+        }
+        return cutters;
+    }
+
+    static void ExpectSamePolys(const std::vector<plCutoutPoly>& expected, const std::vector<plCutoutPoly>& actual)
+    {
+        ASSERT_EQ(expected.size(), actual.size());
+        for (size_t i = 0; i < expected.size(); i++) {
+            const plCutoutPoly& lhs = expected[i];
+            const plCutoutPoly& rhs = actual[i];
+            EXPECT_EQ(lhs.fBaseHasAlpha, rhs.fBaseHasAlpha);
+            ASSERT_EQ(lhs.fVerts.size(), rhs.fVerts.size());
+            for (size_t j = 0; j < lhs.fVerts.size(); j++) {
+                const plCutoutVtx& a = lhs.fVerts[j];
+                const plCutoutVtx& b = rhs.fVerts[j];
+                EXPECT_EQ(a.fPos, b.fPos);
+                EXPECT_EQ(a.fNorm, b.fNorm);
+                EXPECT_EQ(a.fUVW, b.fUVW);
+                EXPECT_EQ(a.fColor, b.fColor);
+            }
+        }
+    }
+
+    void CheckIndexedCuts(const hsMatrix44& l2w)
+    {
+        size_t numHits = 0;
+        for (const plCutter& cutter : MakeCutters(l2w, 200)) {
+            std::vector<plCutoutPoly> expected;
+            cutter.Cutout(fSrc, expected);
+
+            std::vector<uint32_t> tris;
+            std::vector<plCutoutPoly> actual;
+            if (cutter.GatherTris(fSrc, fBVH, tris))
+                cutter.Cutout(fSrc, tris, actual);
+            ExpectSamePolys(expected, actual);
+
+            // A decal sized box shouldn't be dragging in a big chunk of the page.
+            EXPECT_LT(tris.size(), fSrc.AccessTri().TriCount() / 8);
+            if (!expected.empty())
+                numHits++;
+        }
+        // Make sure we actually tested something
+        EXPECT_GT(numHits, 50);
+    }
+};
+
+static hsMatrix44 MakeTransform()
+{
+    hsMatrix44 rot;
+    rot.MakeRotateMat(2, 0.7f);
+    hsVector3 trans(-40.f, 25.f, 8.f);
+    hsMatrix44 l2w;
+    l2w.MakeTranslateMat(&trans);
+    return l2w * rot;
+}
+
+static hsMatrix44 MakeIdentity()
+{
+    hsMatrix44 l2w;
+    l2w.Reset();
+    return l2w;
+}
+
+TEST_F(plCutterTest, IndexedCutMatchesFullCut)
+{
+    hsMatrix44 l2w = MakeIdentity();
+    MakeGround(l2w, false);
+    CheckIndexedCuts(l2w);
+}
+
+TEST_F(plCutterTest, IndexedCutMatchesFullCutTransformed)
+{
+    hsMatrix44 l2w = MakeTransform();
+    MakeGround(l2w, false);
+    CheckIndexedCuts(l2w);
+}
+
+TEST_F(plCutterTest, IndexedCutMatchesFullCutWaterHeight)
+{
+    fLayer.SetBlendFlags(hsGMatState::kBlendAlpha);
+
+    hsMatrix44 l2w = MakeIdentity();
+    MakeGround(l2w, true);
+    CheckIndexedCuts(l2w);
+}
+
+TEST_F(plCutterTest, IndexedCutMatchesFullCutWaterHeightTransformed)
+{
+    hsMatrix44 l2w = MakeTransform();
+    MakeGround(l2w, true);
+    CheckIndexedCuts(l2w);
+}
+
+TEST_F(plCutterTest, ConcurrentCutsMatch)
+{
+    hsMatrix44 l2w = MakeIdentity();
+    MakeGround(l2w, false);
+
+    std::vector<plCutter> cutters = MakeCutters(l2w, 64);
+    std::vector<std::vector<plCutoutPoly>> expected(cutters.size());
+    for (size_t i = 0; i < cutters.size(); i++)
+        cutters[i].Cutout(fSrc, expected[i]);
+
+    // Each thread cuts its own share, with the clipping scratch to itself.
+    constexpr size_t kNumThreads = 4;
+    std::vector<std::vector<plCutoutPoly>> actual(cutters.size());
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < kNumThreads; t++) {
+        threads.emplace_back([&, t]() {
+            std::vector<uint32_t> tris;
+            for (size_t i = t; i < cutters.size(); i += kNumThreads) {
+                if (cutters[i].GatherTris(fSrc, fBVH, tris))
+                    cutters[i].Cutout(fSrc, tris, actual[i]);
+            }
+        });
+    }
+    for (std::thread& thread : threads)
+        thread.join();
+
+    for (size_t i = 0; i < cutters.size(); i++)
+        ExpectSamePolys(expected[i], actual[i]);
+}
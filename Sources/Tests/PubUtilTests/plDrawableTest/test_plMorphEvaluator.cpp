@@ -0,0 +1,318 @@
+/*==LICENSE==*
+
+CyanWorlds.com Engine - MMOG client, server and tools
+Copyright (C) 2011  Cyan Worlds, Inc.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+Additional permissions under GNU GPL version 3 section 7
+
+If you modify this Program, or any covered work, by linking or
+combining it with any of RAD Game Tools Bink SDK, Autodesk 3ds Max SDK,
+NVIDIA PhysX SDK, Microsoft DirectX SDK, OpenSSL library, Independent
+JPEG Group JPEG library, Microsoft Windows Media SDK, or Apple QuickTime SDK
+(or a modified version of those libraries),
+containing parts covered by the terms of the Bink SDK EULA, 3ds Max EULA,
+PhysX SDK EULA, DirectX SDK EULA, OpenSSL and SSLeay licenses, IJG
+JPEG Library README, Windows Media SDK EULA, or QuickTime SDK EULA, the
+licensors of this Program grant you additional
+permission to convey the resulting work. Corresponding Source for a
+non-source form of such a combination shall include the source code for
+the parts of OpenSSL and IJG JPEG Library used as well as that of the covered
+work.
+
+You can contact Cyan Worlds, Inc. by email legal@cyan.com
+ or by snail mail at:
+      Cyan Worlds, Inc.
+      14617 N Newport Hwy
+      Mead, WA   99021
+
+*==LICENSE==*/
+
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "hsFastMath.h"
+#include "hsMatrix44.h"
+
+#include "plDrawable/plAccessGeometry.h"
+#include "plDrawable/plAccessSpan.h"
+#include "plDrawable/plAccessVtxSpan.h"
+#include "plDrawable/plGeometrySpan.h"
+#include "plDrawable/plMorphArray.h"
+#include "plDrawable/plMorphEvaluator.h"
+
+// A couple of spans' worth of face, with a few layers of sliders on it.
+// The evaluator has to come out where applying every delta to a fresh copy
+// of the base does: exactly when it rebuilds, and within rounding after any
+// number of incremental nudges.
+class plMorphEvaluatorTest : public ::testing::Test
+{
+protected:
+    static constexpr uint32_t kNumVerts = 1500;
+    static constexpr uint8_t kNumUVWs = 2;
+    static constexpr size_t kNumSpans = 2;
+    static constexpr size_t kNumLayers = 3;
+    static constexpr size_t kNumDeltas = 8;
+
+    std::mt19937 fRng{ 4321u };
+
+    std::vector<std::unique_ptr<plGeometrySpan>> fBaseGeo;
+    std::vector<std::unique_ptr<plGeometrySpan>> fDstGeo;
+    std::vector<std::unique_ptr<plGeometrySpan>> fRefGeo;
+    std::vector<plAccessSpan> fBase;
+    std::vector<plAccessSpan> fDst;
+    std::vector<plMorphArray> fMorphs;
+    std::vector<plMorphArrayWeights> fWeights;
+
+    void SetUp() override
+    {
+        std::uniform_real_distribution<float> unit(-1.f, 1.f);
+
+        std::vector<hsPoint3> positions(kNumVerts);
+        std::vector<hsVector3> normals(kNumVerts);
+        std::vector<uint32_t> colors(kNumVerts, 0xffffffff);
+        std::vector<hsPoint3> uvws(kNumVerts * kNumUVWs);
+
+        for (size_t iSpan = 0; iSpan < kNumSpans; iSpan++) {
+            for (uint32_t i = 0; i < kNumVerts; i++) {
+                positions[i].Set(unit(fRng) * 10.f, unit(fRng) * 10.f, unit(fRng) * 10.f);
+                normals[i].Set(unit(fRng), unit(fRng), 1.f);
+                hsFastMath::Normalize(normals[i]);
+                for (uint8_t j = 0; j < kNumUVWs; j++)
+                    uvws[i * kNumUVWs + j].Set(unit(fRng), unit(fRng), 0.f);
+            }
+            fBaseGeo.emplace_back(IMakeGeo(positions, normals, colors, uvws));
+            fDstGeo.emplace_back(IMakeGeo(positions, normals, colors, uvws));
+            fRefGeo.emplace_back(IMakeGeo(positions, normals, colors, uvws));
+        }
+        fBase = IAccess(fBaseGeo);
+        fDst = IAccess(fDstGeo);
+
+        std::uniform_int_distribution<uint32_t> pickVert(0, kNumVerts - 1);
+        fMorphs.resize(kNumLayers);
+        fWeights.resize(kNumLayers);
+        for (size_t iLay = 0; iLay < kNumLayers; iLay++) {
+            for (size_t iDel = 0; iDel < kNumDeltas; iDel++) {
+                plMorphDelta delta;
+                delta.SetNumSpans(kNumSpans);
+                for (size_t iSpan = 0; iSpan < kNumSpans; iSpan++) {
+                    // Unique verts, sorted, like the exporter makes them
+                    std::vector<uint8_t> used(kNumVerts);
+                    for (int i = 0; i < 300; i++)
+                        used[pickVert(fRng)] = 1;
+
+                    std::vector<plVertDelta> deltas;
+                    std::vector<hsPoint3> uvwDels;
+                    for (uint32_t i = 0; i < kNumVerts; i++) {
+                        if (!used[i])
+                            continue;
+                        deltas.emplace_back(uint16_t(i), hsVector3(unit(fRng), unit(fRng), unit(fRng)),
+                                            hsVector3(unit(fRng), unit(fRng), unit(fRng)) * 0.2f);
+                        for (uint8_t j = 0; j < kNumUVWs; j++)
+                            uvwDels.emplace_back(unit(fRng) * 0.1f, unit(fRng) * 0.1f, 0.f);
+                    }
+                    delta.SetDeltas(iSpan, deltas, kNumUVWs, uvwDels.data());
+                }
+                fMorphs[iLay].AddDelta(delta);
+            }
+            fWeights[iLay].fDeltaWeights.resize(kNumDeltas);
+        }
+    }
+
+    plGeometrySpan* IMakeGeo(std::vector<hsPoint3>& positions, std::vector<hsVector3>& normals,
+                             std::vector<uint32_t>& colors, std::vector<hsPoint3>& uvws)
+    {
+        plGeometrySpan* geo = new plGeometrySpan;
+        geo->BeginCreate(nullptr, hsMatrix44::IdentityMatrix(), plGeometrySpan::UVCountToFormat(kNumUVWs));
+        geo->AddVertexArray(kNumVerts, positions.data(), normals.data(), colors.data(), uvws.data(), kNumUVWs);
+        geo->EndCreate();
+        return geo;
+    }
+
+    static std::vector<plAccessSpan> IAccess(std::vector<std::unique_ptr<plGeometrySpan>>& geos)
+    {
+        plAccessGeometry acc;
+        std::vector<plAccessSpan> spans(geos.size());
+        for (size_t i = 0; i < geos.size(); i++)
+            acc.AccessSpanFromGeometrySpan(spans[i], geos[i].get());
+        return spans;
+    }
+
+    // Copy the base and apply everything, the way plMorphSequence always has.
+    std::vector<plAccessSpan> IReference()
+    {
+        std::vector<plAccessSpan> ref = IAccess(fRefGeo);
+        for (size_t iSpan = 0; iSpan < kNumSpans; iSpan++) {
+            plAccessVtxSpan& src = fBase[iSpan].AccessVtx();
+            plAccessVtxSpan& dst = ref[iSpan].AccessVtx();
+            for (uint32_t i = 0; i < kNumVerts; i++) {
+                dst.Position(i) = src.Position(i);
+                dst.Normal(i) = src.Normal(i);
+                for (uint8_t j = 0; j < kNumUVWs; j++)
+                    dst.UVWs(i)[j] = src.UVWs(i)[j];
+            }
+        }
+
+        for (size_t iLay = 0; iLay < kNumLayers; iLay++)
+            fMorphs[iLay].Apply(ref, &fWeights[iLay].fDeltaWeights);
+
+        for (plAccessSpan& span : ref) {
+            for (uint32_t i = 0; i < kNumVerts; i++)
+                hsFastMath::Normalize(span.AccessVtx().Normal(i));
+        }
+        return ref;
+    }
+
+    void ICompare(std::vector<plAccessSpan>& ref, float tol)
+    {
+        for (size_t iSpan = 0; iSpan < kNumSpans; iSpan++) {
+            plAccessVtxSpan& want = ref[iSpan].AccessVtx();
+            plAccessVtxSpan& got = fDst[iSpan].AccessVtx();
+            for (uint32_t i = 0; i < kNumVerts; i++) {
+                ASSERT_NEAR(got.Position(i).fX, want.Position(i).fX, tol);
+                ASSERT_NEAR(got.Position(i).fY, want.Position(i).fY, tol);
+                ASSERT_NEAR(got.Position(i).fZ, want.Position(i).fZ, tol);
+                ASSERT_NEAR(got.Normal(i).fX, want.Normal(i).fX, tol);
+                ASSERT_NEAR(got.Normal(i).fY, want.Normal(i).fY, tol);
+                ASSERT_NEAR(got.Normal(i).fZ, want.Normal(i).fZ, tol);
+                for (uint8_t j = 0; j < kNumUVWs; j++) {
+                    ASSERT_NEAR(got.UVWs(i)[j].fX, want.UVWs(i)[j].fX, tol);
+                    ASSERT_NEAR(got.UVWs(i)[j].fY, want.UVWs(i)[j].fY, tol);
+                }
+            }
+        }
+    }
+
+    void IRandomWeights()
+    {
+        std::uniform_real_distribution<float> wgt(0.f, 1.f);
+        for (plMorphArrayWeights& lay : fWeights) {
+            for (float& w : lay.fDeltaWeights)
+                w = wgt(fRng);
+        }
+    }
+};
+
+TEST_F(plMorphEvaluatorTest, RebuildMatchesApply)
+{
+    IRandomWeights();
+
+    plMorphEvaluator eval;
+    eval.Rebuild(fBase, fMorphs, &fWeights, fDst);
+    EXPECT_TRUE(eval.IsCurrent(fMorphs, &fWeights));
+
+    std::vector<plAccessSpan> ref = IReference();
+    ICompare(ref, 0.f);
+}
+
+TEST_F(plMorphEvaluatorTest, UpdateMatchesApply)
+{
+    plMorphEvaluator eval;
+    eval.Rebuild(fBase, fMorphs, &fWeights, fDst);
+
+    // Sliders getting dragged and tweened about, including through the
+    // threshold below which a delta doesn't count at all.
+    std::uniform_int_distribution<size_t> pickLay(0, kNumLayers - 1);
+    std::uniform_int_distribution<size_t> pickDel(0, kNumDeltas - 1);
+    std::uniform_real_distribution<float> wgt(-0.05f, 1.f);
+    std::uniform_real_distribution<float> nudge(-0.05f, 0.05f);
+    for (int step = 0; step < 300; step++) {
+        float& w = fWeights[pickLay(fRng)].fDeltaWeights[pickDel(fRng)];
+        w = (step & 1) ? wgt(fRng) : w + nudge(fRng);
+
+        if (!eval.Update(fMorphs, &fWeights, fDst))
+            eval.Rebuild(fBase, fMorphs, &fWeights, fDst);
+        ASSERT_TRUE(eval.IsCurrent(fMorphs, &fWeights));
+
+        if (step % 25 == 0) {
+            std::vector<plAccessSpan> ref = IReference();
+            ICompare(ref, 1.e-4f);
+        }
+    }
+
+    std::vector<plAccessSpan> ref = IReference();
+    ICompare(ref, 1.e-4f);
+}
+
+TEST_F(plMorphEvaluatorTest, UpdateOnlyTouchesMovedVerts)
+{
+    plMorphEvaluator eval;
+    eval.Rebuild(fBase, fMorphs, &fWeights, fDst);
+
+    // Scribble on every vert, then move one slider. Only that delta's verts
+    // should get put right.
+    for (plAccessSpan& span : fDst) {
+        for (uint32_t i = 0; i < kNumVerts; i++)
+            span.AccessVtx().Position(i).Set(-999.f, -999.f, -999.f);
+    }
+
+    fWeights[1].fDeltaWeights[3] = 0.5f;
+    ASSERT_TRUE(eval.Update(fMorphs, &fWeights, fDst));
+
+    const plMorphDelta& delta = fMorphs[1].GetDelta(3);
+    for (size_t iSpan = 0; iSpan < kNumSpans; iSpan++) {
+        std::vector<uint8_t> moved(kNumVerts);
+        for (const plVertDelta& vd : delta.GetSpan(iSpan).fDeltas)
+            moved[vd.fIdx] = 1;
+        for (uint32_t i = 0; i < kNumVerts; i++)
+            EXPECT_EQ(moved[i] != 0, fDst[iSpan].AccessVtx().Position(i).fX != -999.f);
+    }
+}
+
+TEST_F(plMorphEvaluatorTest, UpdateRefusesNewLayout)
+{
+    plMorphEvaluator eval;
+    EXPECT_FALSE(eval.Update(fMorphs, &fWeights, fDst));
+
+    eval.Rebuild(fBase, fMorphs, &fWeights, fDst);
+    EXPECT_TRUE(eval.Update(fMorphs, &fWeights, fDst));
+
+    std::vector<plAccessSpan> fewer(fDst.begin(), fDst.end() - 1);
+    EXPECT_FALSE(eval.Update(fMorphs, &fWeights, fewer));
+
+    std::vector<plMorphArray> more = fMorphs;
+    more.emplace_back();
+    EXPECT_FALSE(eval.IsCurrent(more));
+
+    eval.Invalidate();
+    EXPECT_FALSE(eval.Update(fMorphs, &fWeights, fDst));
+}
+
+TEST(plMorphEvaluator, AccumDeltasSSE2MatchesFPU)
+{
+    std::mt19937 rng{ 99u };
+    std::uniform_real_distribution<float> unit(-1.f, 1.f);
+
+    constexpr size_t kVerts = 257;
+    std::vector<plVertDelta> deltas;
+    for (size_t i = 0; i < kVerts; i += 2)
+        deltas.emplace_back(uint16_t(i), hsVector3(unit(rng), unit(rng), unit(rng)), hsVector3(unit(rng), unit(rng), unit(rng)));
+
+    std::vector<float> fpu(kVerts * plMorphEvaluator::kFloatsPerVert);
+    for (float& f : fpu)
+        f = unit(rng);
+    for (size_t i = 0; i < kVerts; i++)
+        fpu[i * plMorphEvaluator::kFloatsPerVert + 6] = fpu[i * plMorphEvaluator::kFloatsPerVert + 7] = 0.f;
+    std::vector<float> sse2 = fpu;
+
+    plMorphEvaluator::accum_deltas_fpu(fpu.data(), deltas.data(), deltas.size(), 0.37f);
+    plMorphEvaluator::accum_deltas_sse2(sse2.data(), deltas.data(), deltas.size(), 0.37f);
+
+    for (size_t i = 0; i < fpu.size(); i++)
+        EXPECT_EQ(fpu[i], sse2[i]);
+}
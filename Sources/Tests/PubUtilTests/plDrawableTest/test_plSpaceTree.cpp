@@ -0,0 +1,114 @@
+/*==LICENSE==*
+
+CyanWorlds.com Engine - MMOG client, server and tools
+Copyright (C) 2011  Cyan Worlds, Inc.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+Additional permissions under GNU GPL version 3 section 7
+
+If you modify this Program, or any covered work, by linking or
+combining it with any of RAD Game Tools Bink SDK, Autodesk 3ds Max SDK,
+NVIDIA PhysX SDK, Microsoft DirectX SDK, OpenSSL library, Independent
+JPEG Group JPEG library, Microsoft Windows Media SDK, or Apple QuickTime SDK
+(or a modified version of those libraries),
+containing parts covered by the terms of the Bink SDK EULA, 3ds Max EULA,
+PhysX SDK EULA, DirectX SDK EULA, OpenSSL and SSLeay licenses, IJG
+JPEG Library README, Windows Media SDK EULA, or QuickTime SDK EULA, the
+licensors of this Program grant you additional
+permission to convey the resulting work. Corresponding Source for a
+non-source form of such a combination shall include the source code for
+the parts of OpenSSL and IJG JPEG Library used as well as that of the covered
+work.
+
+You can contact Cyan Worlds, Inc. by email legal@cyan.com
+ or by snail mail at:
+      Cyan Worlds, Inc.
+      14617 N Newport Hwy
+      Mead, WA   99021
+
+*==LICENSE==*/
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "hsBounds.h"
+#include "hsMatrix44.h"
+
+#include "plDrawable/plSpaceTree.h"
+#include "plDrawable/plSpaceTreeMaker.h"
+#include "plIntersect/plVolumeIsect.h"
+
+static hsBounds3Ext RandomBox(std::mt19937& rng)
+{
+    std::uniform_real_distribution<float> pos(-500.f, 500.f);
+    std::uniform_real_distribution<float> size(1.f, 20.f);
+
+    hsPoint3 mins(pos(rng), pos(rng), pos(rng));
+    hsPoint3 maxs(mins.fX + size(rng), mins.fY + size(rng), mins.fZ + size(rng));
+    hsBounds3Ext bnd;
+    bnd.Reset(&mins);
+    bnd.Union(&maxs);
+    return bnd;
+}
+
+static std::vector<int16_t> Harvest(const plSpaceTree& tree, plVolumeIsect* cull, bool wide)
+{
+    plSpaceTree::EnableWideHarvest(wide);
+    std::vector<int16_t> list;
+    tree.HarvestLeaves(cull, list);
+    plSpaceTree::EnableWideHarvest(true);
+
+    std::sort(list.begin(), list.end());
+    return list;
+}
+
+// Leaves that move every frame (avatars, clickables, physicals) go through
+// MoveLeaf and Refresh, and the wide harvest has to keep up with them.
+TEST(plSpaceTree, WideHarvestFollowsMovedLeaves)
+{
+    std::mt19937 rng(97531);
+
+    plSpaceTreeMaker maker;
+    maker.Reset();
+    const int kNumLeaves = 300;
+    for (int i = 0; i < kNumLeaves; i++)
+        maker.AddLeaf(RandomBox(rng));
+    std::unique_ptr<plSpaceTree> tree(maker.MakeTree());
+    maker.Cleanup();
+
+    plSphereIsect sphere;
+    sphere.SetCenter(hsPoint3(0.f, 0.f, 0.f));
+    sphere.SetRadius(250.f);
+    hsMatrix44 ident;
+    ident.Reset();
+    sphere.SetTransform(ident, ident);
+
+    ASSERT_EQ(Harvest(*tree, &sphere, false), Harvest(*tree, &sphere, true));
+
+    for (int frame = 0; frame < 20; frame++)
+    {
+        for (int i = 0; i < 30; i++)
+            tree->MoveLeaf(int16_t(rng() % kNumLeaves), RandomBox(rng));
+        tree->Refresh();
+
+        std::vector<int16_t> want = Harvest(*tree, &sphere, false);
+        EXPECT_FALSE(want.empty());
+        EXPECT_EQ(want, Harvest(*tree, &sphere, true)) << "frame " << frame;
+    }
+}
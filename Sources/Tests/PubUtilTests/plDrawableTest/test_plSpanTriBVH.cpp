@@ -0,0 +1,188 @@
+/*==LICENSE==*
+
+CyanWorlds.com Engine - MMOG client, server and tools
+Copyright (C) 2011  Cyan Worlds, Inc.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+Additional permissions under GNU GPL version 3 section 7
+
+If you modify this Program, or any covered work, by linking or
+combining it with any of RAD Game Tools Bink SDK, Autodesk 3ds Max SDK,
+NVIDIA PhysX SDK, Microsoft DirectX SDK, OpenSSL library, Independent
+JPEG Group JPEG library, Microsoft Windows Media SDK, or Apple QuickTime SDK
+(or a modified version of those libraries),
+containing parts covered by the terms of the Bink SDK EULA, 3ds Max EULA,
+PhysX SDK EULA, DirectX SDK EULA, OpenSSL and SSLeay licenses, IJG
+JPEG Library README, Windows Media SDK EULA, or QuickTime SDK EULA, the
+licensors of this Program grant you additional
+permission to convey the resulting work. Corresponding Source for a
+non-source form of such a combination shall include the source code for
+the parts of OpenSSL and IJG JPEG Library used as well as that of the covered
+work.
+
+You can contact Cyan Worlds, Inc. by email legal@cyan.com
+ or by snail mail at:
+      Cyan Worlds, Inc.
+      14617 N Newport Hwy
+      Mead, WA   99021
+
+*==LICENSE==*/
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include "hsGeometry3.h"
+
+#include "plDrawable/plAccessTriSpan.h"
+#include "plDrawable/plSpanTriBVH.h"
+#include "plDrawable/plSpanTypes.h"
+
+// A small bumpy sheet with a handful of loose tris floating over it at
+// random orientations, so plenty of rays come at tris from behind.
+class plSpanTriBVHTest : public ::testing::Test
+{
+protected:
+    static constexpr int kGridSize = 10;
+
+    std::vector<hsPoint3>   fVerts;
+    std::vector<uint16_t>   fIndices;
+    plAccessTriSpan         fTris;
+    plIcicle                fIcicle;
+    plSpanTriBVH            fBVH;
+
+    void SetUp() override
+    {
+        std::mt19937 rng{ 4321u };
+        std::uniform_real_distribution<float> jitter(-0.2f, 0.2f);
+
+        for (int j = 0; j <= kGridSize; j++) {
+            for (int i = 0; i <= kGridSize; i++) {
+                float x = float(i) + jitter(rng);
+                float y = float(j) + jitter(rng);
+                fVerts.emplace_back(x, y, sinf(x * 0.7f) * cosf(y * 0.5f) + jitter(rng));
+            }
+        }
+        for (int j = 0; j < kGridSize; j++) {
+            for (int i = 0; i < kGridSize; i++) {
+                uint16_t v00 = uint16_t(j * (kGridSize + 1) + i);
+                uint16_t v10 = uint16_t(v00 + 1);
+                uint16_t v01 = uint16_t(v00 + kGridSize + 1);
+                uint16_t v11 = uint16_t(v01 + 1);
+                fIndices.insert(fIndices.end(), { v00, v10, v11, v00, v11, v01 });
+            }
+        }
+
+        std::uniform_real_distribution<float> pos(0.f, float(kGridSize));
+        std::uniform_real_distribution<float> height(0.5f, 4.f);
+        std::uniform_real_distribution<float> unit(-1.f, 1.f);
+        for (int i = 0; i < 40; i++) {
+            hsPoint3 center(pos(rng), pos(rng), height(rng));
+            for (int k = 0; k < 3; k++) {
+                fIndices.emplace_back(uint16_t(fVerts.size()));
+                fVerts.emplace_back(center.fX + unit(rng), center.fY + unit(rng), center.fZ + unit(rng));
+            }
+        }
+
+        fTris.ClearVerts();
+        fTris.PositionStream(fVerts.data(), sizeof(hsPoint3), 0);
+        fTris.SetVertCount(uint16_t(fVerts.size()));
+        fTris.fTris = fIndices.data();
+        fTris.fNumTris = uint32_t(fIndices.size() / 3);
+
+        ASSERT_TRUE(fBVH.Build(fIcicle, fTris));
+    }
+
+    // What plVisLOSMgr does without a hierarchy
+    bool BruteForce(const hsPoint3& from, const hsVector3& dir, bool twoSided,
+                    float& maxDist, hsPoint3& hitPos, uint32_t& triIdx) const
+    {
+        bool retVal = false;
+        for (uint32_t i = 0; i < fTris.TriCount(); i++) {
+            float dist;
+            hsPoint3 projPt;
+            if (plSpanTriBVH::IntersectTri(Vert(i, 0), Vert(i, 1), Vert(i, 2),
+                                           from, dir, twoSided, maxDist, dist, projPt)) {
+                maxDist = dist;
+                hitPos = projPt;
+                triIdx = i;
+                retVal = true;
+            }
+        }
+        return retVal;
+    }
+
+    const hsPoint3& Vert(uint32_t tri, int i) const { return fVerts[fIndices[tri * 3 + i]]; }
+
+    void CheckRays(bool twoSided)
+    {
+        std::mt19937 rng{ 8765u };
+        std::uniform_real_distribution<float> around(-5.f, float(kGridSize) + 5.f);
+        std::uniform_real_distribution<float> over(-6.f, 8.f);
+        std::uniform_real_distribution<float> target(0.f, float(kGridSize));
+
+        size_t numHits = 0;
+        for (int i = 0; i < 5000; i++) {
+            hsPoint3 from(around(rng), around(rng), over(rng));
+            hsPoint3 to(target(rng), target(rng), target(rng) * 0.4f - 1.f);
+            hsVector3 dir(&to, &from);
+            if (dir.MagnitudeSquared() < 1.e-4f)
+                continue;
+            dir.Normalize();
+
+            float bruteDist = 100.f;
+            hsPoint3 brutePos;
+            uint32_t bruteTri = uint32_t(-1);
+            bool bruteHit = BruteForce(from, dir, twoSided, bruteDist, brutePos, bruteTri);
+
+            float bvhDist = 100.f;
+            hsPoint3 bvhPos;
+            uint32_t bvhTri = uint32_t(-1);
+            bool bvhHit = fBVH.Raycast(from, dir, twoSided, bvhDist, bvhPos, &bvhTri);
+
+            ASSERT_EQ(bruteHit, bvhHit) << "ray " << i;
+            if (!bruteHit)
+                continue;
+            numHits++;
+
+            EXPECT_EQ(bruteDist, bvhDist) << "ray " << i;
+            EXPECT_EQ(brutePos, bvhPos) << "ray " << i;
+            if (bruteTri != bvhTri) {
+                // Only acceptable for a ray through a shared edge, where
+                // both tris are hit at exactly the same distance.
+                float dist;
+                hsPoint3 projPt;
+                EXPECT_TRUE(plSpanTriBVH::IntersectTri(Vert(bvhTri, 0), Vert(bvhTri, 1), Vert(bvhTri, 2),
+                                                       from, dir, twoSided, 100.f, dist, projPt)) << "ray " << i;
+                EXPECT_EQ(bruteDist, dist) << "ray " << i;
+            }
+        }
+
+        // Make sure we actually tested something
+        EXPECT_GT(numHits, 1000u);
+    }
+};
+
+TEST_F(plSpanTriBVHTest, RaycastMatchesBruteForce)
+{
+    CheckRays(false);
+}
+
+TEST_F(plSpanTriBVHTest, RaycastMatchesBruteForceTwoSided)
+{
+    CheckRays(true);
+}
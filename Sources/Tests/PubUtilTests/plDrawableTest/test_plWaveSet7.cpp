@@ -0,0 +1,175 @@
+/*==LICENSE==*
+
+CyanWorlds.com Engine - MMOG client, server and tools
+Copyright (C) 2011  Cyan Worlds, Inc.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+Additional permissions under GNU GPL version 3 section 7
+
+If you modify this Program, or any covered work, by linking or
+combining it with any of RAD Game Tools Bink SDK, Autodesk 3ds Max SDK,
+NVIDIA PhysX SDK, Microsoft DirectX SDK, OpenSSL library, Independent
+JPEG Group JPEG library, Microsoft Windows Media SDK, or Apple QuickTime SDK
+(or a modified version of those libraries),
+containing parts covered by the terms of the Bink SDK EULA, 3ds Max EULA,
+PhysX SDK EULA, DirectX SDK EULA, OpenSSL and SSLeay licenses, IJG
+JPEG Library README, Windows Media SDK EULA, or QuickTime SDK EULA, the
+licensors of this Program grant you additional
+permission to convey the resulting work. Corresponding Source for a
+non-source form of such a combination shall include the source code for
+the parts of OpenSSL and IJG JPEG Library used as well as that of the covered
+work.
+
+You can contact Cyan Worlds, Inc. by email legal@cyan.com
+ or by snail mail at:
+      Cyan Worlds, Inc.
+      14617 N Newport Hwy
+      Mead, WA   99021
+
+*==LICENSE==*/
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include "plDrawable/plWaveSet7.h"
+
+// Batched surface evaluation goes through SIMD code that wraps its angles a
+// little differently from fmodf, so it's close to the per-point math but not
+// exactly on it.
+static constexpr float kHeightTolerance = 0.001f;
+static constexpr float kNormTolerance = 0.0001f;
+
+static plWaveSet7::SurfaceParams MakeSurface(uint32_t seed)
+{
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<float> unit(0.f, 1.f);
+
+    plWaveSet7::SurfaceParams params;
+    for (plWorldWave7& wave : params.fWaves) {
+        float angle = unit(rng) * hsConstants::two_pi<float>;
+        wave.fDir.Set(cosf(angle), sinf(angle), 0.f);
+        wave.fLength = 4.f + unit(rng) * 36.f;
+        wave.fFreq = hsConstants::two_pi<float> / wave.fLength;
+        wave.fPhase = unit(rng) * hsConstants::two_pi<float>;
+        wave.fAmplitude = wave.fLength * 0.05f;
+    }
+    params.fWaterHeight = 12.f;
+    params.fScrunchLen = 8.f;
+    params.fScrunchScale = 2.f;
+    return params;
+}
+
+static std::vector<hsPoint3> MakePoints(size_t count, uint32_t seed)
+{
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<float> xy(-800.f, 800.f);
+    std::uniform_real_distribution<float> z(0.f, 24.f);
+
+    std::vector<hsPoint3> points(count);
+    for (hsPoint3& pt : points)
+        pt.Set(xy(rng), xy(rng), z(rng));
+    return points;
+}
+
+static void ExpectBatchMatches(const plWaveSet7::SurfaceParams& params, size_t count, uint32_t seed)
+{
+    std::vector<hsPoint3> batched = MakePoints(count, seed);
+    std::vector<hsVector3> batchedNorms(count);
+    plWaveSet7::eval_points.call(params, count, batched.data(), batchedNorms.data());
+
+    std::vector<hsPoint3> single = MakePoints(count, seed);
+    for (size_t i = 0; i < count; i++) {
+        hsVector3 norm;
+        plWaveSet7::EvalSurfacePoint(params, single[i], norm);
+
+        // x and y are left alone
+        EXPECT_EQ(single[i].fX, batched[i].fX) << "point " << i;
+        EXPECT_EQ(single[i].fY, batched[i].fY) << "point " << i;
+        EXPECT_NEAR(single[i].fZ, batched[i].fZ, kHeightTolerance) << "point " << i;
+        EXPECT_NEAR(norm.fX, batchedNorms[i].fX, kNormTolerance) << "point " << i;
+        EXPECT_NEAR(norm.fY, batchedNorms[i].fY, kNormTolerance) << "point " << i;
+        EXPECT_NEAR(norm.fZ, batchedNorms[i].fZ, kNormTolerance) << "point " << i;
+    }
+}
+
+TEST(plWaveSet7, BatchMatchesPerPoint)
+{
+    for (uint32_t seed = 1; seed <= 4; seed++)
+        ExpectBatchMatches(MakeSurface(seed), 1000, seed * 31);
+}
+
+TEST(plWaveSet7, BatchTail)
+{
+    // Counts that leave some points over after the SIMD passes
+    plWaveSet7::SurfaceParams params = MakeSurface(7);
+    for (size_t count : { 1, 2, 3, 5, 6, 7, 257 })
+        ExpectBatchMatches(params, count, uint32_t(count));
+}
+
+TEST(plWaveSet7, FpuBatchIsPerPoint)
+{
+    plWaveSet7::SurfaceParams params = MakeSurface(11);
+
+    std::vector<hsPoint3> batched = MakePoints(300, 5);
+    std::vector<hsVector3> batchedNorms(batched.size());
+    plWaveSet7::eval_points_fpu(params, batched.size(), batched.data(), batchedNorms.data());
+
+    std::vector<hsPoint3> single = MakePoints(300, 5);
+    for (size_t i = 0; i < single.size(); i++) {
+        hsVector3 norm;
+        plWaveSet7::EvalSurfacePoint(params, single[i], norm);
+        EXPECT_EQ(single[i].fZ, batched[i].fZ);
+        EXPECT_EQ(norm, batchedNorms[i]);
+    }
+}
+
+TEST(plWaveSet7, CalmWater)
+{
+    // No waves, no scrunch: everything sits flat on the water height
+    plWaveSet7::SurfaceParams params = MakeSurface(3);
+    for (plWorldWave7& wave : params.fWaves)
+        wave.fAmplitude = 0.f;
+
+    std::vector<hsPoint3> points = MakePoints(64, 9);
+    std::vector<hsVector3> norms(points.size());
+    plWaveSet7::eval_points.call(params, points.size(), points.data(), norms.data());
+    for (size_t i = 0; i < points.size(); i++) {
+        EXPECT_NEAR(params.fWaterHeight, points[i].fZ, 1e-4f);
+        EXPECT_NEAR(1.f, norms[i].fZ, 0.005f); // hsFastMath::InvSqrtAppr() is only so good
+    }
+}
+
+TEST(plWaveSet7, BuoyImpulsePerFrame)
+{
+    // However many buoys there are, each one's pushes should add up to the
+    // same impulse as being pushed every frame.
+    const float dt = 1.f / 60.f;
+    for (size_t numBuoys : { 1, 10, 64, 65, 127, 200 }) {
+        std::vector<float> pushed(numBuoys);
+        size_t cursor = 0;
+        for (size_t frame = 0; frame < numBuoys; frame++) {
+            plWaveSet7::BuoyTurn turn = plWaveSet7::NextBuoyTurn(numBuoys, dt, cursor);
+            EXPECT_LE(turn.fCount, numBuoys);
+            for (size_t i = 0; i < turn.fCount; i++)
+                pushed[(turn.fFirst + i) % numBuoys] += turn.fDt;
+        }
+
+        for (size_t i = 0; i < numBuoys; i++)
+            EXPECT_NEAR(float(numBuoys) * dt, pushed[i], 0.0001f) << numBuoys << " buoys, buoy " << i;
+    }
+}
@@ -0,0 +1,232 @@
+/*==LICENSE==*
+
+CyanWorlds.com Engine - MMOG client, server and tools
+Copyright (C) 2011  Cyan Worlds, Inc.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+Additional permissions under GNU GPL version 3 section 7
+
+If you modify this Program, or any covered work, by linking or
+combining it with any of RAD Game Tools Bink SDK, Autodesk 3ds Max SDK,
+NVIDIA PhysX SDK, Microsoft DirectX SDK, OpenSSL library, Independent
+JPEG Group JPEG library, Microsoft Windows Media SDK, or Apple QuickTime SDK
+(or a modified version of those libraries),
+containing parts covered by the terms of the Bink SDK EULA, 3ds Max EULA,
+PhysX SDK EULA, DirectX SDK EULA, OpenSSL and SSLeay licenses, IJG
+JPEG Library README, Windows Media SDK EULA, or QuickTime SDK EULA, the
+licensors of this Program grant you additional
+permission to convey the resulting work. Corresponding Source for a
+non-source form of such a combination shall include the source code for
+the parts of OpenSSL and IJG JPEG Library used as well as that of the covered
+work.
+
+You can contact Cyan Worlds, Inc. by email legal@cyan.com
+ or by snail mail at:
+      Cyan Worlds, Inc.
+      14617 N Newport Hwy
+      Mead, WA   99021
+
+*==LICENSE==*/
+
+#include <gtest/gtest.h>
+
+#include <random>
+
+#include "hsColorRGBA.h"
+#include "hsCpuID.h"
+
+#include "plGImage/hsCodecManager.h"
+#include "plGImage/hsDXTSoftwareCodec.h"
+#include "plGImage/plMipmap.h"
+
+// These hashes were taken from the original scalar, single-threaded codec.
+// Whatever CPU path or thread split runs, the output has to stay the same.
+
+static uint64_t HashMipmap(plMipmap* mip)
+{
+    uint64_t hash = 1469598103934665603ULL;
+    for (uint8_t i = 0; i < mip->GetNumLevels(); i++) {
+        const uint8_t* data = static_cast<const uint8_t*>(mip->GetLevelPtr(i));
+        for (uint32_t j = 0; j < mip->GetLevelSize(i); j++) {
+            hash ^= data[j];
+            hash *= 1099511628211ULL;
+        }
+    }
+    return hash;
+}
+
+// A mix of gradient, flat, noisy and punch-through blocks on every level
+static void FillMipmap(plMipmap* mip, uint32_t seed, bool alpha)
+{
+    std::mt19937 rng(seed);
+    for (uint8_t l = 0; l < mip->GetNumLevels(); l++) {
+        mip->SetCurrLevel(l);
+        for (uint32_t y = 0; y < mip->GetCurrHeight(); y++) {
+            for (uint32_t x = 0; x < mip->GetCurrWidth(); x++) {
+                uint8_t r, g, b, a;
+                switch (((x / 4) * 7 + (y / 4) * 13 + seed) % 6) {
+                case 0: r = x * 3; g = y * 5; b = (x ^ y) * 2; a = 255; break;
+                case 1: r = g = b = rng() & 0xff; a = rng() & 0xff; break;
+                case 2: r = 200; g = 10; b = 77; a = 128; break;
+                case 3: r = rng(); g = rng(); b = rng(); a = (rng() & 1) ? 255 : 0; break;
+                case 4: r = x * 16; g = 255 - y * 16; b = 64; a = (x + y) * 8; break;
+                default: r = rng() % 32 + 100; g = rng() % 32 + 50; b = rng() % 32; a = 255 - (rng() % 3); break;
+                }
+                if (!alpha)
+                    a = 255;
+                *mip->GetAddr32(x, y) = (uint32_t(a) << 24) | (uint32_t(r) << 16) | (uint32_t(g) << 8) | b;
+            }
+        }
+    }
+    mip->SetCurrLevel(0);
+}
+
+struct DXTGolden
+{
+    uint64_t fCompressed;
+    uint64_t fTo32;
+    uint64_t fTo16;
+    uint64_t fTo16Weird;
+    uint64_t fIntensity;
+};
+
+static void CheckGolden(bool alpha, const DXTGolden& golden)
+{
+    hsDXTSoftwareCodec::Init();
+    hsDXTSoftwareCodec& codec = hsDXTSoftwareCodec::Instance();
+
+    // Big enough that the top levels get split into bands on multicore machines
+    plMipmap src(512, 512, plMipmap::kARGB32Config, 0);
+    if (alpha)
+        src.SetFlags(src.GetFlags() | plMipmap::kAlphaChannelFlag);
+    else
+        src.SetFlags(src.GetFlags() & ~plMipmap::kAlphaChannelFlag);
+    FillMipmap(&src, alpha ? 1235 : 1234, alpha);
+
+    plMipmap* comp = codec.CreateCompressedMipmap(&src);
+    ASSERT_NE(comp, nullptr);
+    EXPECT_EQ(comp->fDirectXInfo.fCompressionType,
+              alpha ? plMipmap::DirectXInfo::kDXT5 : plMipmap::DirectXInfo::kDXT1);
+    EXPECT_EQ(HashMipmap(comp), golden.fCompressed);
+
+    plMipmap* un = codec.CreateUncompressedMipmap(comp, hsCodecManager::k32BitDepth);
+    EXPECT_EQ(HashMipmap(un), golden.fTo32);
+    delete un;
+
+    un = codec.CreateUncompressedMipmap(comp, hsCodecManager::k16BitDepth);
+    EXPECT_EQ(HashMipmap(un), golden.fTo16);
+    delete un;
+
+    un = codec.CreateUncompressedMipmap(comp, hsCodecManager::k16BitDepth | hsCodecManager::kWeirdCompOrder);
+    EXPECT_EQ(HashMipmap(un), golden.fTo16Weird);
+    delete un;
+
+    comp->SetFlags(comp->GetFlags() | plMipmap::kIntensityMap);
+    un = codec.CreateUncompressedMipmap(comp, 0);
+    EXPECT_EQ(HashMipmap(un), golden.fIntensity);
+    delete un;
+
+    delete comp;
+}
+
+// Every test runs once per find_endpoints slot, whatever this CPU would have
+// picked, and every slot has to hit the same hashes.
+enum class DXTKernel
+{
+    kFPU,
+    kSSE2
+};
+
+class hsDXTKernels : public testing::TestWithParam<DXTKernel>
+{
+    hsDXTSoftwareCodec::find_endpoints_ptr fFindEndpoints;
+
+protected:
+    void SetUp() override
+    {
+        fFindEndpoints = hsDXTSoftwareCodec::find_endpoints.call;
+
+        switch (GetParam()) {
+        case DXTKernel::kFPU:
+            hsDXTSoftwareCodec::find_endpoints.call = &hsDXTSoftwareCodec::find_endpoints_fpu;
+            break;
+        case DXTKernel::kSSE2:
+#ifdef HAVE_SSE2
+            if (!hsCpuId::Instance().has_sse2)
+                GTEST_SKIP() << "No SSE2 on this CPU";
+            hsDXTSoftwareCodec::find_endpoints.call = &hsDXTSoftwareCodec::find_endpoints_sse2;
+#else
+            GTEST_SKIP() << "Built without SSE2";
+#endif
+            break;
+        }
+    }
+
+    void TearDown() override
+    {
+        hsDXTSoftwareCodec::find_endpoints.call = fFindEndpoints;
+    }
+};
+
+INSTANTIATE_TEST_SUITE_P(hsDXTSoftwareCodec, hsDXTKernels, testing::Values(DXTKernel::kFPU, DXTKernel::kSSE2),
+                         [](const testing::TestParamInfo<DXTKernel>& info) {
+                             return info.param == DXTKernel::kSSE2 ? "SSE2" : "FPU";
+                         });
+
+TEST_P(hsDXTKernels, DXT1Golden)
+{
+    CheckGolden(false, {
+        0xbaa67ba0c134f344ULL,
+        0xa1e23728275f1558ULL,
+        0xebc2cb18e3c22788ULL,
+        0xdea905d56f8acb67ULL,
+        0x765177b5248b3337ULL
+    });
+}
+
+TEST_P(hsDXTKernels, DXT5Golden)
+{
+    CheckGolden(true, {
+        0x4f198f813aca7d26ULL,
+        0xb73421f9b69f6e5dULL,
+        0xfd0547ccfb41989dULL,
+        0x8d0f831e08be0c01ULL,
+        0x5c00e2f603ad3191ULL
+    });
+}
+
+// The hashes only see the blocks in one picture. Throw a lot more at the
+// search directly, including blocks made of a handful of colors so there are
+// plenty of tied pairs to break the same way.
+TEST_P(hsDXTKernels, FindEndpoints)
+{
+    std::mt19937 rng(4321);
+    hsRGBAColor32 pixels[16];
+    for (int block = 0; block < 20000; block++) {
+        uint32_t palette[4] = { rng(), rng(), rng(), rng() };
+        int numColors = 1 + block % 5;
+        for (int i = 0; i < 16; i++) {
+            uint32_t color = numColors > 4 ? rng() : palette[rng() % numColors];
+            pixels[i].SetARGB(color >> 24, color >> 16, color >> 8, color);
+        }
+
+        int first, second;
+        hsDXTSoftwareCodec::find_endpoints.call(pixels, first, second);
+        int refFirst, refSecond;
+        hsDXTSoftwareCodec::find_endpoints_fpu(pixels, refFirst, refSecond);
+        ASSERT_EQ(first, refFirst) << "block " << block;
+        ASSERT_EQ(second, refSecond) << "block " << block;
+    }
+}
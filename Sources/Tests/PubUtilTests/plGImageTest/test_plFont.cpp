@@ -0,0 +1,195 @@
+/*==LICENSE==*
+
+CyanWorlds.com Engine - MMOG client, server and tools
+Copyright (C) 2011  Cyan Worlds, Inc.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+Additional permissions under GNU GPL version 3 section 7
+
+If you modify this Program, or any covered work, by linking or
+combining it with any of RAD Game Tools Bink SDK, Autodesk 3ds Max SDK,
+NVIDIA PhysX SDK, Microsoft DirectX SDK, OpenSSL library, Independent
+JPEG Group JPEG library, Microsoft Windows Media SDK, or Apple QuickTime SDK
+(or a modified version of those libraries),
+containing parts covered by the terms of the Bink SDK EULA, 3ds Max EULA,
+PhysX SDK EULA, DirectX SDK EULA, OpenSSL and SSLeay licenses, IJG
+JPEG Library README, Windows Media SDK EULA, or QuickTime SDK EULA, the
+licensors of this Program grant you additional
+permission to convey the resulting work. Corresponding Source for a
+non-source form of such a combination shall include the source code for
+the parts of OpenSSL and IJG JPEG Library used as well as that of the covered
+work.
+
+You can contact Cyan Worlds, Inc. by email legal@cyan.com
+ or by snail mail at:
+      Cyan Worlds, Inc.
+      14617 N Newport Hwy
+      Mead, WA   99021
+
+*==LICENSE==*/
+
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <random>
+#include <string_theory/format>
+
+#include "hsColorRGBA.h"
+#include "hsResMgr.h"
+#include "hsStream.h"
+#include "plFileSystem.h"
+
+#include "pnKeyedObject/plFixedKey.h"
+#include "plGImage/plDynamicTextMap.h"
+#include "plGImage/plFont.h"
+#include "plGImage/plFontCache.h"
+#include "plResMgr/plResManager.h"
+#include "plResMgr/plResMgrSettings.h"
+
+// An 8bpp font with every printable ASCII glyph, made of noise so that every
+// coverage value from empty to solid shows up, written out as a .p2f the same
+// way plFontConverter would.
+static constexpr uint32_t kGlyphWidth = 9;
+static constexpr uint32_t kGlyphHeight = 12;
+static constexpr uint16_t kFirstChar = 32;
+static constexpr uint32_t kNumChars = 95;
+
+static void WriteSyntheticFont(const plFileName& fileName)
+{
+    hsUNIXStream s;
+    ASSERT_TRUE(s.Open(fileName, "wb"));
+
+    char face[256] = "Synthetic";
+    s.Write(sizeof(face), face);
+    s.WriteByte(uint8_t(12));
+    s.WriteLE32(uint32_t(0));
+
+    s.WriteLE32(kGlyphWidth);
+    s.WriteLE32(kGlyphHeight * kNumChars);
+    s.WriteLE32(kGlyphHeight);
+    s.WriteByte(uint8_t(8));
+
+    std::mt19937 rng(4096);
+    for (uint32_t i = 0; i < kGlyphWidth * kGlyphHeight * kNumChars; i++) {
+        uint32_t n = rng();
+        uint8_t value = (n & 3) == 0 ? 0 : (n & 3) == 1 ? 0xff : uint8_t(n >> 8);
+        s.WriteByte(value);
+    }
+
+    s.WriteLE16(kFirstChar);
+    s.WriteLE32(kNumChars);
+    for (uint32_t i = 0; i < kNumChars; i++) {
+        s.WriteLE32(i * kGlyphWidth * kGlyphHeight);
+        s.WriteLE32(kGlyphHeight - (i % 3));
+        s.WriteLE32(kGlyphHeight - 3 - (i % 3));
+        s.WriteLEFloat(0.f);
+        s.WriteLEFloat(-float(i % 4));
+    }
+}
+
+class plFontRenderTest : public testing::Test
+{
+protected:
+    static plFontCache* sFontCache;
+
+    static void SetUpTestSuite()
+    {
+        plFileSystem::CreateDir("fonts");
+        WriteSyntheticFont(plFileName::Join("fonts", "Synthetic.p2f"));
+
+        plResMgrSettings::Get().SetLoadPagesOnInit(false);
+        hsgResMgr::Init(new plResManager);
+
+        sFontCache = new plFontCache;
+        sFontCache->LoadCustomFonts("fonts");
+    }
+
+    static void TearDownTestSuite()
+    {
+        sFontCache->UnRegisterAs(kFontCache_KEY);
+        sFontCache = nullptr;
+        hsgResMgr::Shutdown();
+    }
+
+    void TearDown() override
+    {
+        plFont::SetRenderCaching(true);
+    }
+
+    struct Mode
+    {
+        uint8_t     fFontFlags;
+        hsColorRGBA fColor;
+        bool        fBlockRGB;
+        bool        fPremultiplied;
+    };
+
+    static void Draw(plDynamicTextMap& map, const Mode& mode, bool caching)
+    {
+        plFont::SetRenderCaching(caching);
+
+        map.Create(256, 64, true, 0, 0, mode.fPremultiplied);
+        hsColorRGBA background;
+        background.Set(0.2f, 0.4f, 0.6f, 0.5f);
+        map.ClearToColor(background);
+
+        map.SetFont("Synthetic", 12, mode.fFontFlags);
+        hsColorRGBA color = mode.fColor;
+        map.SetTextColor(color, mode.fBlockRGB);
+        map.DrawString(2, 2, L"The quick brown fox jumps over the lazy dog.");
+        map.DrawWrappedString(4, 20, L"0123456789 !@#$%^&*()_+-=[]{};':\",./<>? Shorah b'shem!", 200, 40);
+    }
+};
+
+plFontCache* plFontRenderTest::sFontCache = nullptr;
+
+// Glyphs drawn out of the pre-converted cache have to land on the text map
+// exactly as the per-pixel renderers would have drawn them.
+TEST_F(plFontRenderTest, CachedMatchesUncached)
+{
+    ASSERT_NE(plFontCache::GetInstance().GetFont("Synthetic", 12, 0), nullptr);
+
+    hsColorRGBA white, orange;
+    white.Set(1.f, 1.f, 1.f, 1.f);
+    orange.Set(1.f, 0.6f, 0.1f, 0.5f);
+
+    const Mode modes[] = {
+        { 0,                                white,  false, false },
+        { 0,                                orange, false, false },
+        { plDynamicTextMap::kFontShadowed,  white,  false, false },
+        { 0,                                orange, true,  false },
+        { 0,                                orange, false, true  },
+        { plDynamicTextMap::kFontShadowed,  orange, false, true  },
+    };
+
+    for (size_t i = 0; i < std::size(modes); i++) {
+        plDynamicTextMap uncached, cached, blank;
+        Draw(uncached, modes[i], false);
+        Draw(cached, modes[i], true);
+        ASSERT_EQ(uncached.GetCurrLevelSize(), cached.GetCurrLevelSize());
+        EXPECT_EQ(0, memcmp(uncached.GetImage(), cached.GetImage(), cached.GetCurrLevelSize())) << "mode " << i;
+
+        // Once more, now that the glyphs are all in the cache.
+        Draw(cached, modes[i], true);
+        EXPECT_EQ(0, memcmp(uncached.GetImage(), cached.GetImage(), cached.GetCurrLevelSize())) << "mode " << i;
+
+        // And make sure something was actually drawn.
+        blank.Create(256, 64, true, 0, 0, modes[i].fPremultiplied);
+        hsColorRGBA background;
+        background.Set(0.2f, 0.4f, 0.6f, 0.5f);
+        blank.ClearToColor(background);
+        EXPECT_NE(0, memcmp(blank.GetImage(), cached.GetImage(), cached.GetCurrLevelSize())) << "mode " << i;
+    }
+}
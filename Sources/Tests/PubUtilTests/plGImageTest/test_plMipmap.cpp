@@ -0,0 +1,328 @@
+/*==LICENSE==*
+
+CyanWorlds.com Engine - MMOG client, server and tools
+Copyright (C) 2011  Cyan Worlds, Inc.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+Additional permissions under GNU GPL version 3 section 7
+
+If you modify this Program, or any covered work, by linking or
+combining it with any of RAD Game Tools Bink SDK, Autodesk 3ds Max SDK,
+NVIDIA PhysX SDK, Microsoft DirectX SDK, OpenSSL library, Independent
+JPEG Group JPEG library, Microsoft Windows Media SDK, or Apple QuickTime SDK
+(or a modified version of those libraries),
+containing parts covered by the terms of the Bink SDK EULA, 3ds Max EULA,
+PhysX SDK EULA, DirectX SDK EULA, OpenSSL and SSLeay licenses, IJG
+JPEG Library README, Windows Media SDK EULA, or QuickTime SDK EULA, the
+licensors of this Program grant you additional
+permission to convey the resulting work. Corresponding Source for a
+non-source form of such a combination shall include the source code for
+the parts of OpenSSL and IJG JPEG Library used as well as that of the covered
+work.
+
+You can contact Cyan Worlds, Inc. by email legal@cyan.com
+ or by snail mail at:
+      Cyan Worlds, Inc.
+      14617 N Newport Hwy
+      Mead, WA   99021
+
+*==LICENSE==*/
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "hsColorRGBA.h"
+#include "plGImage/plMipmap.h"
+
+// The filters, scaling and blending in plMipmap run through SIMD kernels and
+// may be split across threads. Each result here is compared against a plain
+// per-channel version of the original loops. On x86 the two match exactly, but
+// a compiler that fuses the float multiply-adds may round the other way, so
+// any channel is allowed to be off by one.
+static constexpr int kTolerance = 1;
+
+static void FillImage(plMipmap* mip, uint32_t seed)
+{
+    std::mt19937 rng(seed);
+    for (uint32_t y = 0; y < mip->GetCurrHeight(); y++) {
+        for (uint32_t x = 0; x < mip->GetCurrWidth(); x++) {
+            uint32_t n = rng();
+            uint8_t a = ((x / 8 + y / 8) % 3 == 0) ? 0 : uint8_t(n >> 24);
+            *mip->GetAddr32(x, y) = (uint32_t(a) << 24) | (uint32_t(uint8_t(x * 3 + (n & 7))) << 16)
+                                    | (uint32_t(uint8_t(y * 5)) << 8) | uint8_t(n >> 8);
+        }
+    }
+}
+
+static int MaxChannelDiff(const uint32_t* a, const uint32_t* b, size_t count)
+{
+    int worst = 0;
+    for (size_t i = 0; i < count; i++) {
+        for (int shift = 0; shift < 32; shift += 8) {
+            int diff = std::abs(int((a[i] >> shift) & 0xff) - int((b[i] >> shift) & 0xff));
+            worst = std::max(worst, diff);
+        }
+    }
+    return worst;
+}
+
+// Gaussian filter of one level onto another, sampling every step'th pixel
+static std::vector<uint32_t> RefFilter(const uint32_t* src, uint32_t srcWidth, uint32_t srcHeight,
+                                       float sig, uint32_t step)
+{
+    int ext = std::max(1, int(sig * 2.f));
+    float ooSigSq = 1.f / (sig * sig);
+
+    uint32_t dstWidth = srcWidth / step;
+    uint32_t dstHeight = srcHeight / step;
+    std::vector<uint32_t> dst(dstWidth * dstHeight);
+    for (int i = 0; i < int(dstHeight); i++) {
+        for (int j = 0; j < int(dstWidth); j++) {
+            int cy = i * step;
+            int cx = j * step;
+            uint32_t pixel = 0;
+            for (int chan = 0; chan < 4; chan++) {
+                float w = 0;
+                float a = 0;
+                for (int ii = -ext; ii <= ext; ii++) {
+                    for (int jj = -ext; jj <= ext; jj++) {
+                        if (cy + ii >= 0 && cy + ii < int(srcHeight) && cx + jj >= 0 && cx + jj < int(srcWidth)) {
+                            float m = expf(-(ii * ii + jj * jj) * ooSigSq);
+                            uint8_t c = src[(cy + ii) * srcWidth + cx + jj] >> (chan * 8);
+                            w += m;
+                            a += (float(c) + 0.5f) * m;
+                        }
+                    }
+                }
+                pixel |= uint32_t(uint8_t(a / w)) << (chan * 8);
+            }
+            dst[i * dstWidth + j] = pixel;
+        }
+    }
+    return dst;
+}
+
+static std::vector<uint32_t> RefScale(const uint32_t* src, uint32_t srcWidth, uint32_t srcHeight,
+                                      uint32_t dstWidth, uint32_t dstHeight)
+{
+    float xScale = float(srcWidth) / float(dstWidth);
+    float yScale = float(srcHeight) / float(dstHeight);
+    float filterWidth = std::max(1.f, xScale);
+    float filterHeight = std::max(1.f, yScale);
+
+    std::vector<uint32_t> dst(dstWidth * dstHeight);
+    for (uint32_t destY = 0; destY < dstHeight; destY++) {
+        float srcPosY = destY * yScale;
+        int startY = std::max(0, int(int16_t(srcPosY - filterHeight)));
+        int endY = std::min(int(srcHeight) - 1, int(int16_t(srcPosY + filterHeight)));
+        for (uint32_t destX = 0; destX < dstWidth; destX++) {
+            float srcPosX = destX * xScale;
+            int startX = std::max(0, int(int16_t(srcPosX - filterWidth)));
+            int endX = std::min(int(srcWidth) - 1, int(int16_t(srcPosX + filterWidth)));
+
+            hsColorRGBA accum, color;
+            accum.Set(0.f, 0.f, 0.f, 0.f);
+            float totalWeight = 0.f;
+            for (int y = startY; y <= endY; y++) {
+                float whyWait = 1.f - (fabs(float(y) - srcPosY) / filterHeight);
+                if (whyWait <= 0.f)
+                    continue;
+                for (int x = startX; x <= endX; x++) {
+                    float weight = (1.f - (fabs(float(x) - srcPosX) / filterWidth)) * whyWait;
+                    if (weight > 0.f) {
+                        color.FromARGB32(src[y * srcWidth + x]);
+                        color *= weight;
+                        accum += color;
+                        totalWeight += weight;
+                    }
+                }
+            }
+            accum *= 1.f / totalWeight;
+            dst[destY * dstWidth + destX] = accum.ToARGB32();
+        }
+    }
+    return dst;
+}
+
+static uint32_t RefBlend(uint32_t dst, uint32_t src, const plMipmap::CompositeOptions& options)
+{
+    if (!(src >> 24))
+        return dst;
+
+    uint32_t srcAlpha = options.fOpacity * (src >> 24) / 255;
+    uint32_t oneMinusAlpha = 256 - srcAlpha;
+    uint32_t r = uint32_t(((src >> 16) & 0xff) * options.fRedTint);
+    uint32_t g = uint32_t(((src >> 8) & 0xff) * options.fGreenTint);
+    uint32_t b = uint32_t((src & 0xff) * options.fBlueTint);
+    r = ((r * srcAlpha) >> 8) + ((((dst >> 16) & 0xff) * oneMinusAlpha) >> 8);
+    g = ((g * srcAlpha) >> 8) + ((((dst >> 8) & 0xff) * oneMinusAlpha) >> 8);
+    b = ((b * srcAlpha) >> 8) + (((dst & 0xff) * oneMinusAlpha) >> 8);
+
+    uint32_t alpha = (options.fFlags & plMipmap::kBlendWriteAlpha) ? (srcAlpha << 24) : (dst & 0xff000000);
+    return (r << 16) | (g << 8) | b | alpha;
+}
+
+// Every test runs twice: once through the kernels hsCpuFunctionDispatcher
+// picked for this CPU, and once through the plain C++ fallbacks.
+class plMipmapKernels : public testing::TestWithParam<bool>
+{
+    plMipmap::filter_row_ptr        fFilterRow;
+    plMipmap::scale_row_ptr         fScaleRow;
+    plMipmap::blend_row_ptr         fBlendRow;
+    plMipmap::premultiply_row_ptr   fPremultiplyRow;
+
+protected:
+    void SetUp() override
+    {
+        fFilterRow = plMipmap::filter_row.call;
+        fScaleRow = plMipmap::scale_row.call;
+        fBlendRow = plMipmap::blend_row.call;
+        fPremultiplyRow = plMipmap::premultiply_row.call;
+
+        if (GetParam()) {
+            plMipmap::filter_row.call = &plMipmap::filter_row_fpu;
+            plMipmap::scale_row.call = &plMipmap::scale_row_fpu;
+            plMipmap::blend_row.call = &plMipmap::blend_row_fpu;
+            plMipmap::premultiply_row.call = &plMipmap::premultiply_row_fpu;
+        }
+    }
+
+    void TearDown() override
+    {
+        plMipmap::filter_row.call = fFilterRow;
+        plMipmap::scale_row.call = fScaleRow;
+        plMipmap::blend_row.call = fBlendRow;
+        plMipmap::premultiply_row.call = fPremultiplyRow;
+    }
+};
+
+INSTANTIATE_TEST_SUITE_P(plMipmap, plMipmapKernels, testing::Values(false, true),
+                         [](const testing::TestParamInfo<bool>& info) {
+                             return info.param ? "Scalar" : "Dispatched";
+                         });
+
+TEST_P(plMipmapKernels, Filter)
+{
+    // Odd sizes so the SIMD loops have tails to deal with
+    plMipmap image(203, 157, plMipmap::kARGB32Config, 1);
+    FillImage(&image, 42);
+
+    for (float sig : { 1.f, 2.5f }) {
+        plMipmap filtered;
+        filtered.CopyFrom(&image);
+        filtered.Filter(sig);
+
+        std::vector<uint32_t> ref = RefFilter(static_cast<uint32_t*>(image.GetImage()),
+                                              image.GetWidth(), image.GetHeight(), sig, 1);
+        EXPECT_LE(MaxChannelDiff(static_cast<uint32_t*>(filtered.GetImage()), ref.data(), ref.size()), kTolerance)
+            << "sigma " << sig;
+    }
+}
+
+TEST_P(plMipmapKernels, CreateMipChain)
+{
+    plMipmap base(256, 256, plMipmap::kARGB32Config, 1);
+    FillImage(&base, 7);
+
+    plMipmap mips(&base, 1.f, 0, 0.f, 0.f, 0.f, 0.f);
+    ASSERT_EQ(mips.GetNumLevels(), 9);
+
+    // Each level is filtered from the one above it, so check them one at a time
+    for (uint8_t i = 1; i < mips.GetNumLevels(); i++) {
+        mips.SetCurrLevel(i - 1);
+        std::vector<uint32_t> ref = RefFilter(reinterpret_cast<uint32_t*>(mips.GetLevelPtr(i - 1)),
+                                              mips.GetCurrWidth(), mips.GetCurrHeight(), 1.f, 2);
+        EXPECT_LE(MaxChannelDiff(reinterpret_cast<uint32_t*>(mips.GetLevelPtr(i)), ref.data(), ref.size()), kTolerance)
+            << "level " << int(i);
+    }
+}
+
+TEST_P(plMipmapKernels, ScaleNicely)
+{
+    plMipmap image(181, 133, plMipmap::kARGB32Config, 1);
+    FillImage(&image, 3);
+
+    const std::pair<uint16_t, uint16_t> sizes[] = { { 60, 44 }, { 23, 17 }, { 355, 260 }, { 37, 37 } };
+    for (const auto& size : sizes) {
+        std::vector<uint32_t> scaled(size.first * size.second);
+        image.ScaleNicely(scaled.data(), size.first, size.second, size.first, plMipmap::kDefaultFilter);
+
+        std::vector<uint32_t> ref = RefScale(static_cast<uint32_t*>(image.GetImage()),
+                                             image.GetWidth(), image.GetHeight(), size.first, size.second);
+        EXPECT_LE(MaxChannelDiff(scaled.data(), ref.data(), ref.size()), kTolerance)
+            << size.first << "x" << size.second;
+    }
+}
+
+TEST_P(plMipmapKernels, CompositeBlend)
+{
+    plMipmap overlay(61, 45, plMipmap::kARGB32Config, 1);
+    FillImage(&overlay, 11);
+
+    struct { uint16_t fFlags; float fRed, fGreen, fBlue; uint8_t fOpacity; } cases[] = {
+        { 0, 1.f, 1.f, 1.f, 255 },
+        { 0, 0.5f, 0.75f, 0.2f, 200 },
+        { plMipmap::kBlendWriteAlpha, 1.f, 0.3f, 1.f, 128 },
+        { 0, 1.5f, 1.f, 1.f, 255 },
+    };
+    for (const auto& c : cases) {
+        plMipmap base(128, 128, plMipmap::kARGB32Config, 1);
+        FillImage(&base, 5);
+        std::vector<uint32_t> ref(static_cast<uint32_t*>(base.GetImage()),
+                                  static_cast<uint32_t*>(base.GetImage()) + 128 * 128);
+
+        plMipmap::CompositeOptions options(c.fFlags, 0, c.fRed, c.fGreen, c.fBlue, 0, 0, 0, 0, c.fOpacity);
+        base.Composite(&overlay, 17, 9, &options);
+
+        for (uint32_t y = 0; y < overlay.GetHeight(); y++) {
+            for (uint32_t x = 0; x < overlay.GetWidth(); x++) {
+                uint32_t& dst = ref[(y + 9) * 128 + x + 17];
+                dst = RefBlend(dst, *overlay.GetAddr32(x, y), options);
+            }
+        }
+        EXPECT_EQ(MaxChannelDiff(static_cast<uint32_t*>(base.GetImage()), ref.data(), ref.size()), 0)
+            << "flags " << c.fFlags << " opacity " << int(c.fOpacity);
+    }
+}
+
+TEST_P(plMipmapKernels, CompositePremultiplied)
+{
+    plMipmap overlay(61, 45, plMipmap::kARGB32Config, 1);
+    FillImage(&overlay, 13);
+
+    plMipmap base(128, 128, plMipmap::kARGB32Config, 1);
+    FillImage(&base, 5);
+    std::vector<uint32_t> ref(static_cast<uint32_t*>(base.GetImage()),
+                              static_cast<uint32_t*>(base.GetImage()) + 128 * 128);
+
+    plMipmap::CompositeOptions options(plMipmap::kCopySrcAlpha | plMipmap::kDestPremultiplied);
+    base.Composite(&overlay, 30, 70, &options);
+
+    for (uint32_t y = 0; y < overlay.GetHeight(); y++) {
+        for (uint32_t x = 0; x < overlay.GetWidth(); x++) {
+            uint32_t src = *overlay.GetAddr32(x, y);
+            uint32_t alpha = src >> 24;
+            ref[(y + 70) * 128 + x + 30] = (alpha << 24)
+                | (((((src >> 16) & 0xff) * alpha + 127) / 255) << 16)
+                | (((((src >> 8) & 0xff) * alpha + 127) / 255) << 8)
+                | ((((src & 0xff) * alpha + 127) / 255));
+        }
+    }
+    EXPECT_EQ(MaxChannelDiff(static_cast<uint32_t*>(base.GetImage()), ref.data(), ref.size()), 0);
+}
@@ -0,0 +1,503 @@
+/*==LICENSE==*
+
+CyanWorlds.com Engine - MMOG client, server and tools
+Copyright (C) 2011  Cyan Worlds, Inc.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+Additional permissions under GNU GPL version 3 section 7
+
+If you modify this Program, or any covered work, by linking or
+combining it with any of RAD Game Tools Bink SDK, Autodesk 3ds Max SDK,
+NVIDIA PhysX SDK, Microsoft DirectX SDK, OpenSSL library, Independent
+JPEG Group JPEG library, Microsoft Windows Media SDK, or Apple QuickTime SDK
+(or a modified version of those libraries),
+containing parts covered by the terms of the Bink SDK EULA, 3ds Max EULA,
+PhysX SDK EULA, DirectX SDK EULA, OpenSSL and SSLeay licenses, IJG
+JPEG Library README, Windows Media SDK EULA, or QuickTime SDK EULA, the
+licensors of this Program grant you additional
+permission to convey the resulting work. Corresponding Source for a
+non-source form of such a combination shall include the source code for
+the parts of OpenSSL and IJG JPEG Library used as well as that of the covered
+work.
+
+You can contact Cyan Worlds, Inc. by email legal@cyan.com
+ or by snail mail at:
+      Cyan Worlds, Inc.
+      14617 N Newport Hwy
+      Mead, WA   99021
+
+*==LICENSE==*/
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <map>
+#include <memory>
+#include <random>
+#include <string_theory/format>
+#include <utility>
+#include <vector>
+
+#include "hsBounds.h"
+#include "hsColorRGBA.h"
+#include "hsGeometry3.h"
+#include "hsMatrix44.h"
+#include "hsResMgr.h"
+#include "plViewTransform.h"
+
+#include "plDrawable/plDrawableSpans.h"
+#include "plDrawable/plSpanTypes.h"
+#include "plGLight/plLightInfo.h"
+#include "plGLight/plPointShadowMaster.h"
+#include "plGLight/plShadowCaster.h"
+#include "plGLight/plShadowScheduler.h"
+#include "plGLight/plShadowSlave.h"
+#include "plMessage/plShadowCastMsg.h"
+#include "plPipeline/hsG3DDeviceSelector.h"
+#include "plPipeline/plNullPipeline.h"
+#include "plResMgr/plResManager.h"
+#include "plResMgr/plResMgrSettings.h"
+#include "plScene/plVisMgr.h"
+
+// Masters normally find their light through the scene object they're on,
+// these just get handed one.
+class TestShadowMaster : public plPointShadowMaster
+{
+protected:
+    plLightInfo* fTestLight;
+
+public:
+    TestShadowMaster(plLightInfo* light) : fTestLight(light) { }
+
+    void IBeginRender() override
+    {
+        plPointShadowMaster::IBeginRender();
+        fLightInfo = fTestLight;
+        fLightInfo->ClearSlaveBits();
+    }
+
+    using plShadowMaster::IOnCastMsg;
+
+    size_t GetNumCachedSetups() const { return fSetupCache.size(); }
+};
+
+class TestShadowCaster : public plShadowCaster
+{
+public:
+    TestShadowCaster() { fMaxOpacity = 1.f; }
+
+    void AddSpan(plDrawableSpans* dr, uint32_t idx) { fSpans.emplace_back().Set(dr, dr->GetSpan(idx), idx); }
+};
+
+// Just enough of a drawable to hand out span bounds.
+class TestDrawable : public plDrawableSpans
+{
+public:
+    TestDrawable(size_t maxSpans) { fIcicles.reserve(maxSpans); }
+
+    uint32_t AddBox(const hsPoint3& center, float halfSize)
+    {
+        hsAssert(fIcicles.size() < fIcicles.capacity(), "Span pointers would move");
+        fIcicles.emplace_back();
+        fSpans.emplace_back(&fIcicles.back());
+
+        hsVector3 half(halfSize, halfSize, halfSize);
+        hsPoint3 lo = center - half;
+        hsPoint3 hi = center + half;
+        fIcicles.back().fWorldBounds.Reset(&lo);
+        fIcicles.back().fWorldBounds.Union(&hi);
+        return uint32_t(fSpans.size() - 1);
+    }
+
+    void MoveBox(uint32_t idx, const hsVector3& delta)
+    {
+        hsBounds3Ext& bnd = fIcicles[idx].fWorldBounds;
+        hsPoint3 lo = bnd.GetMins() + delta;
+        hsPoint3 hi = bnd.GetMaxs() + delta;
+        bnd.Reset(&lo);
+        bnd.Union(&hi);
+    }
+};
+
+class TestPipeline : public plNullPipeline
+{
+public:
+    TestPipeline(const hsG3DDeviceModeRecord* devModeRec)
+        : plNullPipeline(nullptr, nullptr, devModeRec) { }
+
+    const std::vector<plShadowSlave*>& GetShadows() const { return fShadows; }
+
+    void ClearShadows()
+    {
+        for (plShadowSlave* slave : fShadows)
+            slave->fCaster->GetKey()->UnRefObject();
+        fShadows.clear();
+    }
+};
+
+// Runs one frame's worth of scheduling without going through the dispatcher.
+class TestShadowScheduler : public plShadowScheduler
+{
+public:
+    void Run(plPipeline* pipe, const std::vector<plShadowCaster*>& casters)
+    {
+        IBeginRender(pipe);
+        fCasters = casters;
+        ISchedule();
+    }
+};
+
+// Everything about a submitted slave that came out of the master, copied
+// off before the next frame recycles it.
+struct SlaveSetup
+{
+    hsMatrix44      fWorldToLight;
+    hsMatrix44      fLightToWorld;
+    hsMatrix44      fRcvLUT;
+    hsMatrix44      fCastLUT;
+    hsBounds3Ext    fWorldBounds;
+    hsBounds3Ext    fCasterWorldBounds;
+    uint32_t        fWidth;
+    uint32_t        fHeight;
+    uint32_t        fFlags;
+    uint32_t        fIndex;
+    float           fPriority;
+    float           fPower;
+    float           fAttenDist;
+};
+
+using SlaveKey = std::pair<const plLightInfo*, const plShadowCaster*>;
+using SlaveMap = std::map<SlaveKey, SlaveSetup>;
+
+static void ExpectSameBounds(const hsBounds3Ext& want, const hsBounds3Ext& got)
+{
+    ASSERT_EQ(want.GetType(), got.GetType());
+    if (want.GetType() != kBoundsNormal)
+        return;
+    EXPECT_EQ(want.GetMins().fX, got.GetMins().fX);
+    EXPECT_EQ(want.GetMins().fY, got.GetMins().fY);
+    EXPECT_EQ(want.GetMins().fZ, got.GetMins().fZ);
+    EXPECT_EQ(want.GetMaxs().fX, got.GetMaxs().fX);
+    EXPECT_EQ(want.GetMaxs().fY, got.GetMaxs().fY);
+    EXPECT_EQ(want.GetMaxs().fZ, got.GetMaxs().fZ);
+}
+
+static void ExpectSameSlaves(const SlaveMap& want, const SlaveMap& got)
+{
+    ASSERT_EQ(want.size(), got.size());
+    for (const auto& [key, w] : want) {
+        auto iter = got.find(key);
+        ASSERT_NE(got.end(), iter) << "missing slave for a light/caster pair";
+
+        const SlaveSetup& g = iter->second;
+        EXPECT_TRUE(w.fWorldToLight == g.fWorldToLight);
+        EXPECT_TRUE(w.fLightToWorld == g.fLightToWorld);
+        EXPECT_TRUE(w.fRcvLUT == g.fRcvLUT);
+        EXPECT_TRUE(w.fCastLUT == g.fCastLUT);
+        ExpectSameBounds(w.fWorldBounds, g.fWorldBounds);
+        ExpectSameBounds(w.fCasterWorldBounds, g.fCasterWorldBounds);
+        EXPECT_EQ(w.fWidth, g.fWidth);
+        EXPECT_EQ(w.fHeight, g.fHeight);
+        EXPECT_EQ(w.fFlags, g.fFlags);
+        EXPECT_EQ(w.fPriority, g.fPriority);
+        EXPECT_EQ(w.fPower, g.fPower);
+        EXPECT_EQ(w.fAttenDist, g.fAttenDist);
+    }
+}
+
+// What the scheduler should keep out of the per light casts once the frame
+// budget is applied: closest first, shrinking the far ones before dropping.
+static SlaveMap ApplyBudget(const SlaveMap& casts, uint64_t budget)
+{
+    // Per light casting submits in the same caster by master order the
+    // scheduler builds its list in, so fIndex recovers that order.
+    std::vector<std::pair<SlaveKey, SlaveSetup>> order(casts.begin(), casts.end());
+    std::sort(order.begin(), order.end(),
+        [](const auto& a, const auto& b) { return a.second.fIndex < b.second.fIndex; });
+    std::stable_sort(order.begin(), order.end(),
+        [](const auto& a, const auto& b) { return a.second.fPriority < b.second.fPriority; });
+
+    const uint32_t kMinSize = 32;
+    SlaveMap kept;
+    uint64_t used = 0;
+    for (auto& [key, setup] : order) {
+        while ((used + uint64_t(setup.fWidth) * setup.fHeight > budget)
+            && (setup.fWidth > kMinSize) && (setup.fHeight > kMinSize)) {
+            setup.fWidth >>= 1;
+            setup.fHeight >>= 1;
+        }
+        if (used + uint64_t(setup.fWidth) * setup.fHeight > budget)
+            continue;
+        used += uint64_t(setup.fWidth) * setup.fHeight;
+        kept.emplace(key, setup);
+    }
+    return kept;
+}
+
+// A field of omni lights and small casters seen from off to one side, so
+// the casters land at all sorts of distances from the camera. Every light
+// gets two masters, one handed to a scheduler and a twin which gets every
+// cast message itself, the way it worked before the scheduler.
+class plShadowSchedulerTest : public testing::Test
+{
+protected:
+    static constexpr int kNumLights = 16;
+    static constexpr int kNumCasters = 48;
+    static constexpr float kHalfExtent = 60.f;
+
+    hsG3DDeviceRecord                               fDevRec;
+    hsG3DDeviceMode                                 fDevMode;
+    std::unique_ptr<hsG3DDeviceModeRecord>          fDevModeRec;
+    std::unique_ptr<TestPipeline>                   fPipe;
+    std::unique_ptr<TestDrawable>                   fDrawable;
+    std::unique_ptr<TestShadowScheduler>            fScheduler;
+    std::vector<std::unique_ptr<plOmniLightInfo>>   fLights;
+    std::vector<TestShadowMaster*>                  fMasters;
+    std::vector<TestShadowMaster*>                  fTwins;
+    std::vector<plShadowCaster*>                    fCasters;
+    uint32_t                                        fOldMaxSize;
+    uint32_t                                        fOldMaxMaps;
+
+    static void IPlaceLight(plLightInfo* light, const hsPoint3& pos)
+    {
+        hsVector3 trans(pos.fX, pos.fY, pos.fZ);
+        hsMatrix44 l2w, w2l;
+        l2w.MakeTranslateMat(&trans);
+        l2w.GetInverse(&w2l);
+        light->SetTransform(l2w, w2l);
+    }
+
+    static TestShadowMaster* IMakeMaster(plLightInfo* light, const ST::string& name, float attenDist)
+    {
+        TestShadowMaster* master = new TestShadowMaster(light);
+        hsgResMgr::ResMgr()->NewKey(name, master, plLocation::kGlobalFixedLoc);
+        master->GetKey()->RefObject();
+        master->SetAttenDist(attenDist);
+        master->SetMaxSize(256);
+        return master;
+    }
+
+    void SetUp() override
+    {
+        plResMgrSettings::Get().SetLoadPagesOnInit(false);
+        hsgResMgr::Init(new plResManager);
+        plGlobalVisMgr::Init();
+        fOldMaxSize = plShadowMaster::GetGlobalMaxSize();
+        fOldMaxMaps = plShadowMaster::GetGlobalMaxMaps();
+
+        fDevMode.SetWidth(800);
+        fDevMode.SetHeight(600);
+        fDevMode.SetColorDepth(32);
+        fDevModeRec = std::make_unique<hsG3DDeviceModeRecord>(fDevRec, fDevMode);
+        fPipe = std::make_unique<TestPipeline>(fDevModeRec.get());
+
+        hsMatrix44 w2c, c2w;
+        hsMatrix44::MakeCameraMatrices(hsPoint3(0.f, -90.f, 40.f), hsPoint3(0.f, 0.f, 0.f),
+                                       hsVector3(0.f, 0.f, 1.f), w2c, c2w);
+        plViewTransform view;
+        view.SetCameraTransform(w2c, c2w);
+        view.SetPerspective(true);
+        view.SetFovDeg(90.f, 75.f);
+        view.SetHither(0.3f);
+        view.SetYon(1000.f);
+        view.SetScreenSize(800, 600);
+        fPipe->SetViewTransform(view);
+
+        fScheduler = std::make_unique<TestShadowScheduler>();
+
+        std::mt19937 rng{ 2468u };
+        std::uniform_real_distribution<float> unit(0.f, 1.f);
+        auto scatter = [&](float loZ, float hiZ) {
+            return hsPoint3(kHalfExtent * (2.f * unit(rng) - 1.f),
+                            kHalfExtent * (2.f * unit(rng) - 1.f),
+                            loZ + (hiZ - loZ) * unit(rng));
+        };
+
+        // Brightness and falloff stay low enough that a light is too weak
+        // to cast well before the edge of its sphere, same as a real scene.
+        for (int i = 0; i < kNumLights; i++) {
+            plOmniLightInfo* light = fLights.emplace_back(std::make_unique<plOmniLightInfo>()).get();
+            hsColorRGBA diffuse;
+            light->SetDiffuse(diffuse.Set(0.4f + 0.6f * unit(rng), 0.4f * unit(rng), 0.4f * unit(rng), 1.f));
+            light->SetConstantAttenuation(1.f);
+            light->SetLinearAttenuation(0.05f + 0.1f * unit(rng));
+            IPlaceLight(light, scatter(8.f, 20.f));
+            light->Refresh();
+
+            const float attenDist = 5.f + float(i);
+            fMasters.emplace_back(IMakeMaster(light, ST::format("Master{}", i), attenDist));
+            fTwins.emplace_back(IMakeMaster(light, ST::format("Twin{}", i), attenDist));
+            fScheduler->AddMaster(fMasters.back());
+        }
+
+        fDrawable = std::make_unique<TestDrawable>(kNumCasters * 2);
+        for (int i = 0; i < kNumCasters; i++) {
+            TestShadowCaster* caster = new TestShadowCaster;
+            hsgResMgr::ResMgr()->NewKey(ST::format("Caster{}", i), caster, plLocation::kGlobalFixedLoc);
+            caster->GetKey()->RefObject();
+
+            hsPoint3 center = scatter(0.f, 4.f);
+            float halfSize = 0.5f + 1.5f * unit(rng);
+            for (int j = 0; j <= (i & 1); j++)
+                caster->AddSpan(fDrawable.get(), fDrawable->AddBox(center + hsVector3(1.5f * j, 0.f, 1.f * j), halfSize));
+
+            caster->SetLimitRes(!(i % 5));
+            caster->SetSelfShadow(!(i % 7));
+            caster->SetAttenScale((i % 3) ? 1.f : 0.5f);
+            fCasters.emplace_back(caster);
+        }
+    }
+
+    void TearDown() override
+    {
+        fPipe->ClearShadows();
+        fScheduler.reset();
+
+        for (TestShadowMaster* master : fMasters)
+            master->GetKey()->UnRefObject();
+        for (TestShadowMaster* twin : fTwins)
+            twin->GetKey()->UnRefObject();
+        for (plShadowCaster* caster : fCasters)
+            caster->GetKey()->UnRefObject();
+
+        fPipe.reset();
+        fDrawable.reset();
+        fLights.clear();
+
+        plShadowMaster::SetGlobalMaxSize(fOldMaxSize);
+        plShadowMaster::SetGlobalMaxMaps(fOldMaxMaps);
+        plShadowMaster::SetGlobalCacheSetups(true);
+        plGlobalVisMgr::DeInit();
+        hsgResMgr::Shutdown();
+    }
+
+    // Nudge a few casters and one light, so each frame has some setups
+    // which can come from the cache and some which can't.
+    void IMoveThings(int frame)
+    {
+        for (int i = frame; i < kNumCasters; i += 11) {
+            hsVector3 delta(0.75f, -0.5f * float(frame & 1), 0.25f);
+            for (const plShadowCastSpan& span : fCasters[i]->Spans())
+                fDrawable->MoveBox(span.fIndex, delta);
+        }
+
+        plOmniLightInfo* light = fLights[frame % kNumLights].get();
+        IPlaceLight(light, light->GetWorldPosition() + hsVector3(-2.f, 1.f, 0.5f));
+    }
+
+    SlaveMap ICollectSlaves()
+    {
+        SlaveMap slaves;
+        for (const plShadowSlave* slave : fPipe->GetShadows()) {
+            const plLightInfo* owner = nullptr;
+            for (const auto& light : fLights) {
+                if (light->GetSlaveBits().IsBitSet(slave->fIndex)) {
+                    EXPECT_EQ(nullptr, owner) << "slave claimed by two lights";
+                    owner = light.get();
+                }
+            }
+            EXPECT_NE(nullptr, owner);
+
+            SlaveSetup setup {
+                slave->fWorldToLight, slave->fLightToWorld, slave->fRcvLUT, slave->fCastLUT,
+                slave->fWorldBounds, slave->fCasterWorldBounds,
+                slave->fWidth, slave->fHeight, slave->fFlags, slave->fIndex,
+                slave->fPriority, slave->fPower, slave->fAttenDist
+            };
+            EXPECT_TRUE(slaves.emplace(SlaveKey(owner, slave->fCaster), setup).second)
+                << "two slaves for one light/caster pair";
+        }
+        fPipe->ClearShadows();
+        return slaves;
+    }
+
+    SlaveMap IRunScheduled()
+    {
+        fScheduler->Run(fPipe.get(), fCasters);
+        return ICollectSlaves();
+    }
+
+    // The old way, every master hears about every caster and works out its
+    // own setup from scratch.
+    SlaveMap IRunPerLight()
+    {
+        plShadowMaster::SetGlobalCacheSetups(false);
+        for (TestShadowMaster* twin : fTwins)
+            twin->IBeginRender();
+
+        plShadowCastMsg castMsg;
+        castMsg.SetPipeline(fPipe.get());
+        for (plShadowCaster* caster : fCasters) {
+            castMsg.SetCaster(caster);
+            for (TestShadowMaster* twin : fTwins)
+                twin->IOnCastMsg(&castMsg);
+        }
+        plShadowMaster::SetGlobalCacheSetups(true);
+
+        return ICollectSlaves();
+    }
+};
+
+// With room for everything, the scheduler should come up with exactly the
+// slaves every master would have made on its own, cached or not.
+TEST_F(plShadowSchedulerTest, matchesPerLightCasting)
+{
+    plShadowMaster::SetGlobalMaxMaps(kNumLights * kNumCasters);
+
+    for (int frame = 0; frame < 8; frame++) {
+        SCOPED_TRACE(frame);
+        if (frame)
+            IMoveThings(frame);
+
+        SlaveMap scheduled = IRunScheduled();
+        SlaveMap perLight = IRunPerLight();
+        EXPECT_FALSE(perLight.empty());
+        EXPECT_LT(perLight.size(), size_t(kNumLights * kNumCasters));
+        ExpectSameSlaves(perLight, scheduled);
+    }
+
+    size_t cached = 0;
+    for (TestShadowMaster* master : fMasters)
+        cached += master->GetNumCachedSetups();
+    EXPECT_GT(cached, 0);
+}
+
+// On a tight budget, the closest slaves get through (shrunk if they have to
+// be) and the rest get dropped, without going over.
+TEST_F(plShadowSchedulerTest, budgetKeepsClosest)
+{
+    plShadowMaster::SetGlobalMaxSize(128);
+    plShadowMaster::SetGlobalMaxMaps(2);
+    const uint64_t maxSize = plShadowMaster::GetGlobalMaxSize();
+    const uint64_t budget = maxSize * maxSize * plShadowMaster::GetGlobalMaxMaps();
+
+    for (int frame = 0; frame < 4; frame++) {
+        SCOPED_TRACE(frame);
+        if (frame)
+            IMoveThings(frame);
+
+        SlaveMap scheduled = IRunScheduled();
+        SlaveMap perLight = IRunPerLight();
+        ASSERT_FALSE(perLight.empty());
+
+        uint64_t used = 0;
+        for (const auto& [key, setup] : scheduled)
+            used += uint64_t(setup.fWidth) * setup.fHeight;
+        EXPECT_LE(used, budget);
+        EXPECT_LT(scheduled.size(), perLight.size());
+
+        ExpectSameSlaves(ApplyBudget(perLight, budget), scheduled);
+    }
+}
@@ -0,0 +1,164 @@
+/*==LICENSE==*
+
+CyanWorlds.com Engine - MMOG client, server and tools
+Copyright (C) 2011  Cyan Worlds, Inc.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+Additional permissions under GNU GPL version 3 section 7
+
+If you modify this Program, or any covered work, by linking or
+combining it with any of RAD Game Tools Bink SDK, Autodesk 3ds Max SDK,
+NVIDIA PhysX SDK, Microsoft DirectX SDK, OpenSSL library, Independent
+JPEG Group JPEG library, Microsoft Windows Media SDK, or Apple QuickTime SDK
+(or a modified version of those libraries),
+containing parts covered by the terms of the Bink SDK EULA, 3ds Max EULA,
+PhysX SDK EULA, DirectX SDK EULA, OpenSSL and SSLeay licenses, IJG
+JPEG Library README, Windows Media SDK EULA, or QuickTime SDK EULA, the
+licensors of this Program grant you additional
+permission to convey the resulting work. Corresponding Source for a
+non-source form of such a combination shall include the source code for
+the parts of OpenSSL and IJG JPEG Library used as well as that of the covered
+work.
+
+You can contact Cyan Worlds, Inc. by email legal@cyan.com
+ or by snail mail at:
+      Cyan Worlds, Inc.
+      14617 N Newport Hwy
+      Mead, WA   99021
+
+*==LICENSE==*/
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "hsBounds.h"
+#include "hsMatrix44.h"
+
+#include "plDrawable/plSpaceTree.h"
+#include "plDrawable/plSpaceTreeMaker.h"
+#include "plPipeline/plCullTree.h"
+#include "plScene/plCullPoly.h"
+
+static hsBounds3Ext RandomBox(std::mt19937& rng)
+{
+    std::uniform_real_distribution<float> pos(-400.f, 400.f);
+    std::uniform_real_distribution<float> depth(-100.f, 900.f);
+    std::uniform_real_distribution<float> size(1.f, 30.f);
+
+    hsPoint3 mins(pos(rng), pos(rng), depth(rng));
+    hsPoint3 maxs(mins.fX + size(rng), mins.fY + size(rng), mins.fZ + size(rng));
+    hsBounds3Ext bnd;
+    bnd.Reset(&mins);
+    bnd.Union(&maxs);
+
+    // Some leaves are rotated, so they can't go through the wide kernels.
+    if( rng() % 8 == 0 )
+    {
+        hsMatrix44 rot;
+        rot.MakeRotateMat(rng() % 3, 0.5f);
+        bnd.Transform(&rot);
+    }
+    return bnd;
+}
+
+// Camera at the origin looking down +Z with a 90 degree field of view.
+static void InitCuller(plCullTree& culler, const std::vector<plCullPoly>& occluders)
+{
+    const float kNear = 1.f;
+    const float kFar = 2000.f;
+
+    hsMatrix44 world2NDC;
+    world2NDC.Reset();
+    world2NDC.fMap[2][2] = kFar / (kFar - kNear);
+    world2NDC.fMap[2][3] = -kFar * kNear / (kFar - kNear);
+    world2NDC.fMap[3][2] = 1.f;
+    world2NDC.fMap[3][3] = 0.f;
+    world2NDC.NotIdentity();
+
+    culler.SetViewPos(hsPoint3(0.f, 0.f, 0.f));
+    culler.InitFrustum(world2NDC);
+    for (const plCullPoly& poly : occluders)
+        culler.AddPoly(poly);
+}
+
+static plCullPoly Occluder(float x0, float y0, float x1, float y1, float z)
+{
+    // Wound to face the camera.
+    plCullPoly poly;
+    poly.fVerts.emplace_back(x0, y0, z);
+    poly.fVerts.emplace_back(x0, y1, z);
+    poly.fVerts.emplace_back(x1, y1, z);
+    poly.fVerts.emplace_back(x1, y0, z);
+    poly.InitFromVerts(plCullPoly::kTwoSided);
+    return poly;
+}
+
+static std::vector<int16_t> Harvest(const plCullTree& culler, const plSpaceTree& tree, bool wide)
+{
+    plSpaceTree::EnableWideHarvest(wide);
+    std::vector<int16_t> list;
+    culler.Harvest(&tree, list);
+    plSpaceTree::EnableWideHarvest(true);
+
+    std::sort(list.begin(), list.end());
+    return list;
+}
+
+// The per-frame view cull walks the space tree's wide nodes, and has to
+// harvest exactly what the plane by plane binary walk does.
+TEST(plCullTree, WideHarvestMatchesBinary)
+{
+    std::mt19937 rng(24680);
+
+    plSpaceTreeMaker maker;
+    maker.Reset();
+    const int kNumLeaves = 500;
+    for (int i = 0; i < kNumLeaves; i++)
+        maker.AddLeaf(RandomBox(rng));
+    std::unique_ptr<plSpaceTree> tree(maker.MakeTree());
+    maker.Cleanup();
+
+    for (int i = 0; i < kNumLeaves; i += 37)
+        tree->SetLeafFlag(int16_t(i), plSpaceTreeNode::kDisabled);
+
+    std::vector<plCullPoly> occluders;
+    plCullTree frustum;
+    InitCuller(frustum, occluders);
+
+    occluders.push_back(Occluder(-150.f, -150.f, 50.f, 100.f, 200.f));
+    occluders.push_back(Occluder(0.f, -300.f, 300.f, 0.f, 350.f));
+    plCullTree occluded;
+    InitCuller(occluded, occluders);
+    ASSERT_GT(occluded.GetNumNodes(), frustum.GetNumNodes());
+
+    for (int frame = 0; frame < 10; frame++)
+    {
+        for (const plCullTree* culler : { &frustum, &occluded })
+        {
+            std::vector<int16_t> want = Harvest(*culler, *tree, false);
+            EXPECT_FALSE(want.empty());
+            EXPECT_LT(want.size(), size_t(kNumLeaves));
+            EXPECT_EQ(want, Harvest(*culler, *tree, true)) << "frame " << frame;
+        }
+
+        for (int i = 0; i < 40; i++)
+            tree->MoveLeaf(int16_t(rng() % kNumLeaves), RandomBox(rng));
+        tree->Refresh();
+    }
+}
@@ -0,0 +1,374 @@
+/*==LICENSE==*
+
+CyanWorlds.com Engine - MMOG client, server and tools
+Copyright (C) 2011  Cyan Worlds, Inc.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+Additional permissions under GNU GPL version 3 section 7
+
+If you modify this Program, or any covered work, by linking or
+combining it with any of RAD Game Tools Bink SDK, Autodesk 3ds Max SDK,
+NVIDIA PhysX SDK, Microsoft DirectX SDK, OpenSSL library, Independent
+JPEG Group JPEG library, Microsoft Windows Media SDK, or Apple QuickTime SDK
+(or a modified version of those libraries),
+containing parts covered by the terms of the Bink SDK EULA, 3ds Max EULA,
+PhysX SDK EULA, DirectX SDK EULA, OpenSSL and SSLeay licenses, IJG
+JPEG Library README, Windows Media SDK EULA, or QuickTime SDK EULA, the
+licensors of this Program grant you additional
+permission to convey the resulting work. Corresponding Source for a
+non-source form of such a combination shall include the source code for
+the parts of OpenSSL and IJG JPEG Library used as well as that of the covered
+work.
+
+You can contact Cyan Worlds, Inc. by email legal@cyan.com
+ or by snail mail at:
+      Cyan Worlds, Inc.
+      14617 N Newport Hwy
+      Mead, WA   99021
+
+*==LICENSE==*/
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "hsBounds.h"
+#include "hsColorRGBA.h"
+#include "hsGeometry3.h"
+#include "hsMatrix44.h"
+#include "hsResMgr.h"
+#include "plPipeDebugFlags.h"
+
+#include "plDrawable/plDrawableSpans.h"
+#include "plDrawable/plSpanTypes.h"
+#include "plGLight/plLightInfo.h"
+#include "plPipeline/hsG3DDeviceSelector.h"
+#include "plPipeline/plLightGrid.h"
+#include "plPipeline/plNullPipeline.h"
+#include "plResMgr/plResManager.h"
+#include "plResMgr/plResMgrSettings.h"
+
+class TestLightGrid : public plLightGrid
+{
+public:
+    int GetDim(int axis) const { return fDims[axis]; }
+
+    // The point where cells x-1 and x, y-1 and y, z-1 and z all meet.
+    hsPoint3 GetCellCorner(int x, int y, int z) const
+    {
+        const int cell[3] = { x, y, z };
+        hsPoint3 corner;
+        for (int i = 0; i < 3; i++)
+            corner[i] = fInvCellSize[i] > 0 ? fMins[i] + float(cell[i]) / fInvCellSize[i] : fMins[i];
+        return corner;
+    }
+};
+
+class TestPipeline : public plNullPipeline
+{
+public:
+    TestPipeline(const hsG3DDeviceModeRecord* devModeRec)
+        : plNullPipeline(nullptr, nullptr, devModeRec) { }
+
+    using pl3DPipeline<plNullPipelineDevice>::ICheckLighting;
+};
+
+// Just enough of a drawable to have its spans lit.
+class TestDrawable : public plDrawableSpans
+{
+public:
+    TestDrawable(size_t maxSpans) { fIcicles.reserve(maxSpans); }
+
+    void AddBox(const hsPoint3& mins, const hsPoint3& maxs, uint32_t props)
+    {
+        hsAssert(fIcicles.size() < fIcicles.capacity(), "Span pointers would move");
+        plIcicle& span = fIcicles.emplace_back();
+        span.fProps |= props;
+        span.fWorldBounds.Reset(&mins);
+        span.fWorldBounds.Union(&maxs);
+        fSpans.emplace_back(&span);
+    }
+};
+
+// What ICheckLighting left on one span.
+struct SpanLights
+{
+    std::vector<plLightInfo*>   fLights;
+    std::vector<float>          fStrengths;
+    std::vector<plLightInfo*>   fProjs;
+    std::vector<float>          fProjStrengths;
+};
+
+// Every shape of runtime light the grid has to file: spheres, capped cones
+// and boxes (all turned a bit so their planes aren't axis aligned), and a
+// directional with no extent at all. Some are movable, some specular, and
+// some only light what they include.
+class plLightGridTest : public testing::Test
+{
+protected:
+    static constexpr float kHalfExtent = 50.f;
+
+    hsG3DDeviceRecord                           fDevRec;
+    hsG3DDeviceMode                             fDevMode;
+    std::unique_ptr<hsG3DDeviceModeRecord>      fDevModeRec;
+    std::unique_ptr<TestPipeline>               fPipe;
+    std::vector<std::unique_ptr<plLightInfo>>   fLights;
+    std::mt19937                                fRng{ 97531u };
+
+    float IRand(float lo, float hi)
+    {
+        return std::uniform_real_distribution<float>(lo, hi)(fRng);
+    }
+
+    hsPoint3 IScatter(float loZ, float hiZ)
+    {
+        return hsPoint3(IRand(-kHalfExtent, kHalfExtent), IRand(-kHalfExtent, kHalfExtent), IRand(loZ, hiZ));
+    }
+
+    void IPlaceLight(plLightInfo* light, const hsPoint3& pos)
+    {
+        hsVector3 trans(pos.fX, pos.fY, pos.fZ);
+        hsMatrix44 l2w, rotX, rotZ, w2l;
+        l2w.MakeTranslateMat(&trans);
+        rotX.MakeRotateMat(hsMatrix44::kRight, IRand(-0.6f, 0.6f));
+        rotZ.MakeRotateMat(hsMatrix44::kView, IRand(0.f, 6.f));
+        l2w = l2w * rotZ * rotX;
+        l2w.GetInverse(&w2l);
+        light->SetTransform(l2w, w2l);
+    }
+
+    template <class LightT>
+    LightT* IAddLight()
+    {
+        LightT* light = new LightT;
+        fLights.emplace_back(light);
+
+        hsColorRGBA diffuse;
+        light->SetDiffuse(diffuse.Set(IRand(0.2f, 1.f), IRand(0.2f, 1.f), IRand(0.2f, 1.f), 1.f));
+
+        const size_t i = fLights.size();
+        light->SetProperty(plLightInfo::kLPMovable, !(i % 4));
+        if (!(i % 5)) {
+            hsColorRGBA specular;
+            light->SetSpecular(specular.Set(1.f, 1.f, 1.f, 1.f));
+        }
+        if (!(i % 6)) {
+            light->SetProperty(plLightInfo::kLPHasIncludes, true);
+            light->SetProperty(plLightInfo::kLPIncludesChars, !(i % 12));
+        }
+        return light;
+    }
+
+    void SetUp() override
+    {
+        plResMgrSettings::Get().SetLoadPagesOnInit(false);
+        hsgResMgr::Init(new plResManager);
+
+        fDevMode.SetWidth(800);
+        fDevMode.SetHeight(600);
+        fDevMode.SetColorDepth(32);
+        fDevModeRec = std::make_unique<hsG3DDeviceModeRecord>(fDevRec, fDevMode);
+        fPipe = std::make_unique<TestPipeline>(fDevModeRec.get());
+
+        for (int i = 0; i < 14; i++) {
+            plOmniLightInfo* omni = IAddLight<plOmniLightInfo>();
+            omni->SetConstantAttenuation(1.f);
+            omni->SetLinearAttenuation(IRand(1.f, 3.f));
+            IPlaceLight(omni, IScatter(-5.f, 15.f));
+        }
+        for (int i = 0; i < 10; i++) {
+            plSpotLightInfo* spot = IAddLight<plSpotLightInfo>();
+            spot->SetConstantAttenuation(1.f);
+            spot->SetLinearAttenuation(IRand(0.8f, 2.f));
+            spot->SetSpotInner(IRand(0.1f, 0.4f));
+            spot->SetSpotOuter(IRand(0.5f, 0.9f));
+            IPlaceLight(spot, IScatter(5.f, 25.f));
+        }
+        for (int i = 0; i < 6; i++) {
+            plLimitedDirLightInfo* box = IAddLight<plLimitedDirLightInfo>();
+            box->SetWidth(IRand(5.f, 20.f));
+            box->SetHeight(IRand(5.f, 20.f));
+            box->SetDepth(IRand(10.f, 30.f));
+            IPlaceLight(box, IScatter(10.f, 20.f));
+        }
+        IAddLight<plDirectionalLightInfo>();
+
+        for (const auto& light : fLights) {
+            light->Refresh();
+            fPipe->RegisterLight(light.get());
+        }
+    }
+
+    void TearDown() override
+    {
+        fPipe.reset();
+        fLights.clear();
+        hsgResMgr::Shutdown();
+    }
+
+    // The lights BeginVisMgr builds its grid over. The order doesn't
+    // change where the cells fall.
+    std::vector<plLightInfo*> ICharLights() const
+    {
+        std::vector<plLightInfo*> lights;
+        for (const auto& light : fLights) {
+            if (!light->GetProperty(plLightInfo::kLPHasIncludes) || light->GetProperty(plLightInfo::kLPIncludesChars))
+                lights.emplace_back(light.get());
+        }
+        return lights;
+    }
+
+    // Boxes scattered all over, plus some sitting right on the grid's cell
+    // boundaries: straddling a corner, and just touching it from either side.
+    std::vector<hsBounds3Ext> IQueryBoxes(const TestLightGrid& grid)
+    {
+        std::vector<hsBounds3Ext> boxes;
+        auto addBox = [&boxes](const hsPoint3& mins, const hsPoint3& maxs) {
+            hsBounds3Ext& bnd = boxes.emplace_back();
+            bnd.Reset(&mins);
+            bnd.Union(&maxs);
+        };
+
+        for (int i = 0; i < 400; i++) {
+            hsPoint3 center = IScatter(-10.f, 30.f);
+            hsVector3 half(IRand(0.1f, 6.f), IRand(0.1f, 6.f), IRand(0.1f, 6.f));
+            addBox(center - half, center + half);
+        }
+
+        for (int z = 0; z <= grid.GetDim(2); z++) {
+            for (int y = 0; y <= grid.GetDim(1); y++) {
+                for (int x = 0; x <= grid.GetDim(0); x++) {
+                    hsPoint3 corner = grid.GetCellCorner(x, y, z);
+                    hsVector3 half(0.25f, 0.25f, 0.25f);
+                    hsVector3 full(0.5f, 0.5f, 0.5f);
+                    addBox(corner - half, corner + half);
+                    addBox(corner, corner + full);
+                    addBox(corner - full, corner);
+                }
+            }
+        }
+        return boxes;
+    }
+};
+
+// The grid is only a broad phase, but it mustn't lose any light which
+// would pass the light's own test, wherever the box sits on the cells.
+TEST_F(plLightGridTest, findsEveryAffectingLight)
+{
+    std::vector<plLightInfo*> lights;
+    for (const auto& light : fLights)
+        lights.emplace_back(light.get());
+
+    TestLightGrid grid;
+    grid.Build(lights);
+    ASSERT_EQ(lights.size(), grid.GetNumLights());
+
+    std::vector<hsBounds3Ext> boxes = IQueryBoxes(grid);
+    std::vector<uint16_t> found;
+    size_t numAffecting = 0, numFound = 0;
+    for (const hsBounds3Ext& box : boxes) {
+        grid.FindLights(box, found);
+        EXPECT_TRUE(std::is_sorted(found.begin(), found.end()));
+        EXPECT_EQ(found.end(), std::adjacent_find(found.begin(), found.end()));
+
+        for (size_t i = 0; i < lights.size(); i++) {
+            if (!lights[i]->AffectsBound(box))
+                continue;
+            numAffecting++;
+            EXPECT_TRUE(std::binary_search(found.begin(), found.end(), uint16_t(i)))
+                << "light " << i << " missing for box at "
+                << box.GetCenter().fX << ", " << box.GetCenter().fY << ", " << box.GetCenter().fZ;
+        }
+        numFound += found.size();
+    }
+    EXPECT_GT(numAffecting, 0);
+
+    // And it should actually be saving some work.
+    EXPECT_LT(numFound, boxes.size() * lights.size() / 2);
+}
+
+// Every span should come out of ICheckLighting with the same lights, in the
+// same strength order, whether the pipeline goes through its grid or walks
+// every light.
+TEST_F(plLightGridTest, sameLightsAsFullWalk)
+{
+    TestLightGrid grid;
+    grid.Build(ICharLights());
+
+    // Clusters of a few spans each, some of them characters, some centered
+    // right on cell corners so their spans cross cell boundaries.
+    std::vector<hsBounds3Ext> centers = IQueryBoxes(grid);
+    std::vector<std::unique_ptr<TestDrawable>> drawables;
+    for (size_t i = 0; i < centers.size(); i += 3) {
+        const int numSpans = 1 + int(i % 4);
+        TestDrawable* draw = drawables.emplace_back(std::make_unique<TestDrawable>(numSpans)).get();
+        draw->SetNativeProperty(plDrawable::kPropCharacter, !(i % 5));
+
+        hsPoint3 center = centers[i].GetCenter();
+        for (int j = 0; j < numSpans; j++) {
+            hsVector3 offset(IRand(-2.f, 2.f), IRand(-2.f, 2.f), IRand(-2.f, 2.f));
+            hsVector3 half(IRand(0.2f, 2.f), IRand(0.2f, 2.f), IRand(0.2f, 2.f));
+            uint32_t props = (j & 1) ? plSpan::kPropMatHasSpecular : plSpan::kPropRunTimeLight;
+            draw->AddBox(center + offset - half, center + offset + half, props);
+        }
+    }
+
+    auto lightAll = [&](bool useGrid) {
+        fPipe->SetDebugFlag(plPipeDbg::kFlagNoLightGrid, !useGrid);
+        fPipe->BeginVisMgr(nullptr);
+
+        std::vector<SpanLights> result;
+        for (const auto& draw : drawables) {
+            std::vector<int16_t> visList;
+            for (size_t i = 0; i < draw->GetNumSpans(); i++)
+                visList.emplace_back(int16_t(i));
+            fPipe->ICheckLighting(draw.get(), visList, nullptr);
+
+            for (size_t i = 0; i < draw->GetNumSpans(); i++) {
+                const plSpan* span = draw->GetSpan(i);
+                SpanLights& lit = result.emplace_back();
+                for (size_t j = 0; j < span->GetNumLights(false); j++) {
+                    lit.fLights.emplace_back(span->GetLight(j, false));
+                    lit.fStrengths.emplace_back(span->GetLightStrength(j, false));
+                }
+                for (size_t j = 0; j < span->GetNumLights(true); j++) {
+                    lit.fProjs.emplace_back(span->GetLight(j, true));
+                    lit.fProjStrengths.emplace_back(span->GetLightStrength(j, true));
+                }
+            }
+        }
+
+        fPipe->EndVisMgr(nullptr);
+        return result;
+    };
+
+    std::vector<SpanLights> walked = lightAll(false);
+    std::vector<SpanLights> gridded = lightAll(true);
+    ASSERT_EQ(walked.size(), gridded.size());
+
+    size_t numLit = 0;
+    for (size_t i = 0; i < walked.size(); i++) {
+        SCOPED_TRACE(i);
+        EXPECT_EQ(walked[i].fLights, gridded[i].fLights);
+        EXPECT_EQ(walked[i].fStrengths, gridded[i].fStrengths);
+        EXPECT_EQ(walked[i].fProjs, gridded[i].fProjs);
+        EXPECT_EQ(walked[i].fProjStrengths, gridded[i].fProjStrengths);
+        numLit += walked[i].fLights.size();
+    }
+    EXPECT_GT(numLit, 0);
+}
@@ -0,0 +1,199 @@
+/*==LICENSE==*
+
+CyanWorlds.com Engine - MMOG client, server and tools
+Copyright (C) 2011  Cyan Worlds, Inc.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+Additional permissions under GNU GPL version 3 section 7
+
+If you modify this Program, or any covered work, by linking or
+combining it with any of RAD Game Tools Bink SDK, Autodesk 3ds Max SDK,
+NVIDIA PhysX SDK, Microsoft DirectX SDK, OpenSSL library, Independent
+JPEG Group JPEG library, Microsoft Windows Media SDK, or Apple QuickTime SDK
+(or a modified version of those libraries),
+containing parts covered by the terms of the Bink SDK EULA, 3ds Max EULA,
+PhysX SDK EULA, DirectX SDK EULA, OpenSSL and SSLeay licenses, IJG
+JPEG Library README, Windows Media SDK EULA, or QuickTime SDK EULA, the
+licensors of this Program grant you additional
+permission to convey the resulting work. Corresponding Source for a
+non-source form of such a combination shall include the source code for
+the parts of OpenSSL and IJG JPEG Library used as well as that of the covered
+work.
+
+You can contact Cyan Worlds, Inc. by email legal@cyan.com
+ or by snail mail at:
+      Cyan Worlds, Inc.
+      14617 N Newport Hwy
+      Mead, WA   99021
+
+*==LICENSE==*/
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+#include "hsColorRGBA.h"
+#include "hsResMgr.h"
+#include "hsStream.h"
+#include "plFileSystem.h"
+
+#include "pnKeyedObject/plFixedKey.h"
+#include "plGImage/plDynamicTextMap.h"
+#include "plGImage/plFontCache.h"
+#include "plPipeline/hsG3DDeviceSelector.h"
+#include "plPipeline/plNullPipeline.h"
+#include "plResMgr/plResManager.h"
+#include "plResMgr/plResMgrSettings.h"
+#include "plSurface/plLayer.h"
+
+// A solid 8x10 block font, so every glyph visibly changes its cell
+static void WriteBlockFont(const plFileName& fileName)
+{
+    constexpr uint32_t kWidth = 8, kHeight = 10, kNumChars = 95;
+
+    hsUNIXStream s;
+    ASSERT_TRUE(s.Open(fileName, "wb"));
+
+    char face[256] = "Block";
+    s.Write(sizeof(face), face);
+    s.WriteByte(uint8_t(10));
+    s.WriteLE32(uint32_t(0));
+    s.WriteLE32(kWidth);
+    s.WriteLE32(kHeight * kNumChars);
+    s.WriteLE32(kHeight);
+    s.WriteByte(uint8_t(8));
+    for (uint32_t i = 0; i < kWidth * kHeight * kNumChars; i++)
+        s.WriteByte(uint8_t(0xff));
+
+    s.WriteLE16(uint16_t(32));
+    s.WriteLE32(kNumChars);
+    for (uint32_t i = 0; i < kNumChars; i++) {
+        s.WriteLE32(i * kWidth * kHeight);
+        s.WriteLE32(kHeight);
+        s.WriteLE32(kHeight - 2);
+        s.WriteLEFloat(0.f);
+        s.WriteLEFloat(1.f);
+    }
+}
+
+class plNullPipelineTest : public testing::Test
+{
+protected:
+    static plFontCache* sFontCache;
+
+    static void SetUpTestSuite()
+    {
+        plFileSystem::CreateDir("fonts");
+        WriteBlockFont(plFileName::Join("fonts", "Block.p2f"));
+
+        plResMgrSettings::Get().SetLoadPagesOnInit(false);
+        hsgResMgr::Init(new plResManager);
+
+        sFontCache = new plFontCache;
+        sFontCache->LoadCustomFonts("fonts");
+    }
+
+    static void TearDownTestSuite()
+    {
+        sFontCache->UnRegisterAs(kFontCache_KEY);
+        sFontCache = nullptr;
+        hsgResMgr::Shutdown();
+    }
+};
+
+plFontCache* plNullPipelineTest::sFontCache = nullptr;
+
+// A little text on a big text map should only cost the region it covered
+TEST_F(plNullPipelineTest, DynaTextUploadsDirtyRect)
+{
+    hsG3DDeviceRecord devRec;
+    hsG3DDeviceMode devMode;
+    devMode.SetWidth(800);
+    devMode.SetHeight(600);
+    devMode.SetColorDepth(32);
+    hsG3DDeviceModeRecord devModeRec(devRec, devMode);
+    plNullPipeline pipe(nullptr, nullptr, &devModeRec);
+
+    constexpr uint32_t kSize = 512;
+    constexpr uint32_t kFullBytes = kSize * kSize * sizeof(uint32_t);
+
+    plDynamicTextMap map;
+    map.Create(kSize, kSize, true);
+    hsColorRGBA black;
+    black.Set(0.f, 0.f, 0.f, 1.f);
+    map.ClearToColor(black);
+
+    plLayer layer;
+    layer.SetTexture(&map);
+
+    // Everything starts out dirty
+    pipe.CheckTextureRef(&layer);
+    EXPECT_EQ(kFullBytes, pipe.GetTextureUploadBytes());
+
+    // Nothing changed, nothing to upload
+    pipe.CheckTextureRef(&layer);
+    EXPECT_EQ(kFullBytes, pipe.GetTextureUploadBytes());
+
+    std::vector<uint32_t> before((uint32_t*)map.GetImage(), (uint32_t*)map.GetImage() + kSize * kSize);
+
+    hsColorRGBA white;
+    white.Set(1.f, 1.f, 1.f, 1.f);
+    map.SetFont("Block", 10);
+    map.SetTextColor(white);
+    map.DrawString(100, 200, L"Relto");
+
+    // Box in everything the string actually changed
+    uint32_t left = kSize, top = kSize, right = 0, bottom = 0;
+    const uint32_t* after = (const uint32_t*)map.GetImage();
+    for (uint32_t y = 0; y < kSize; y++) {
+        for (uint32_t x = 0; x < kSize; x++) {
+            if (after[y * kSize + x] != before[y * kSize + x]) {
+                left = std::min(left, x);
+                top = std::min(top, y);
+                right = std::max(right, x + 1);
+                bottom = std::max(bottom, y + 1);
+            }
+        }
+    }
+    ASSERT_LT(left, right);
+    ASSERT_LT(top, bottom);
+
+    // Every changed pixel has to be in a dirty rect
+    ASSERT_FALSE(map.IsFullyDirty());
+    for (uint32_t y = top; y < bottom; y++) {
+        for (uint32_t x = left; x < right; x++) {
+            if (after[y * kSize + x] == before[y * kSize + x])
+                continue;
+            bool covered = false;
+            for (const plDynamicTextMap::DirtyRect& r : map.GetDirtyRects())
+                covered |= x >= r.fX && x < r.fX + r.fWidth && y >= r.fY && y < r.fY + r.fHeight;
+            EXPECT_TRUE(covered) << x << "," << y;
+        }
+    }
+
+    pipe.CheckTextureRef(&layer);
+    uint64_t uploaded = pipe.GetTextureUploadBytes() - kFullBytes;
+    uint64_t changedBytes = (right - left) * (bottom - top) * sizeof(uint32_t);
+
+    // Roughly the changed box: a glyph cell of slack on every side at most
+    EXPECT_GE(uploaded, changedBytes);
+    EXPECT_LE(uploaded, (right - left + 16) * (bottom - top + 20) * sizeof(uint32_t));
+    EXPECT_LT(uploaded, kFullBytes / 100);
+    EXPECT_FALSE(map.HasDirtyRects());
+
+    layer.SetTexture(nullptr);
+}
@@ -0,0 +1,218 @@
+/*==LICENSE==*
+
+CyanWorlds.com Engine - MMOG client, server and tools
+Copyright (C) 2011  Cyan Worlds, Inc.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+Additional permissions under GNU GPL version 3 section 7
+
+If you modify this Program, or any covered work, by linking or
+combining it with any of RAD Game Tools Bink SDK, Autodesk 3ds Max SDK,
+NVIDIA PhysX SDK, Microsoft DirectX SDK, OpenSSL library, Independent
+JPEG Group JPEG library, Microsoft Windows Media SDK, or Apple QuickTime SDK
+(or a modified version of those libraries),
+containing parts covered by the terms of the Bink SDK EULA, 3ds Max EULA,
+PhysX SDK EULA, DirectX SDK EULA, OpenSSL and SSLeay licenses, IJG
+JPEG Library README, Windows Media SDK EULA, or QuickTime SDK EULA, the
+licensors of this Program grant you additional
+permission to convey the resulting work. Corresponding Source for a
+non-source form of such a combination shall include the source code for
+the parts of OpenSSL and IJG JPEG Library used as well as that of the covered
+work.
+
+You can contact Cyan Worlds, Inc. by email legal@cyan.com
+ or by snail mail at:
+      Cyan Worlds, Inc.
+      14617 N Newport Hwy
+      Mead, WA   99021
+
+*==LICENSE==*/
+
+#include <gtest/gtest.h>
+
+#include "hsStream.h"
+
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "pnKeyedObject/plUoid.h"
+
+#include "plResMgr/plPageBlockStream.h"
+#include "plResMgr/plPageInfo.h"
+
+// Builds a fake uncompressed page: header, some compressible data, some noise
+// and a few bytes standing in for the key index.
+static std::vector<uint8_t> MakePage(plPageInfo& info)
+{
+    info = plPageInfo(plLocation::MakeNormal(42));
+    info.SetStrings("TestAge", "TestPage");
+
+    hsRAMStream page;
+    info.Write(&page);
+    info.SetDataStart(page.GetPosition());
+
+    for (uint32_t i = 0; i < 40000; i++)
+        page.WriteLE32(i / 16);
+
+    std::mt19937 rng(1234);
+    for (uint32_t i = 0; i < 20000; i++)
+        page.WriteByte(uint8_t(rng()));
+
+    info.SetIndexStart(page.GetPosition());
+    page.WriteLE32(0);
+
+    info.SetChecksum(page.GetEOF() - info.GetDataStart());
+    page.Rewind();
+    info.Write(&page);
+
+    std::vector<uint8_t> data(page.GetEOF());
+    page.CopyToMem(data.data());
+    return data;
+}
+
+static std::unique_ptr<plPageBlockStream> CompressPage(const std::vector<uint8_t>& raw,
+                                                       const plPageInfo& info, uint32_t blockSize,
+                                                       plPageInfo& packedInfo)
+{
+    hsReadOnlyStream src(int(raw.size()), raw.data());
+    auto packed = std::make_unique<hsRAMStream>();
+    EXPECT_TRUE(plPageBlockStream::WritePage(&src, info, packed.get(), blockSize));
+
+    packed->Rewind();
+    packedInfo.Read(packed.get());
+    return std::make_unique<plPageBlockStream>(std::move(packed), packedInfo);
+}
+
+TEST(plPageBlockStream, header)
+{
+    plPageInfo info;
+    std::vector<uint8_t> raw = MakePage(info);
+
+    plPageInfo packedInfo;
+    auto stream = CompressPage(raw, info, 16 * 1024, packedInfo);
+
+    EXPECT_TRUE(packedInfo.IsBlockCompressed());
+    EXPECT_EQ(16U * 1024, packedInfo.GetBlockSize());
+    EXPECT_EQ(size_t((info.GetChecksum() + 16 * 1024 - 1) / (16 * 1024)), packedInfo.GetNumBlocks());
+    EXPECT_EQ(info.GetDataStart(), packedInfo.GetDataStart());
+    EXPECT_EQ(info.GetIndexStart(), packedInfo.GetIndexStart());
+    EXPECT_EQ(info.GetChecksum(), packedInfo.GetChecksum());
+    EXPECT_LT(packedInfo.GetCompressedSize(), info.GetChecksum());
+
+    // The header we read back through the stream is the plain one
+    EXPECT_EQ(raw.size(), stream->GetEOF());
+    plPageInfo plainInfo;
+    plainInfo.Read(stream.get());
+    EXPECT_FALSE(plainInfo.IsBlockCompressed());
+    EXPECT_EQ(info.GetDataStart(), stream->GetPosition());
+    EXPECT_EQ(ST_LITERAL("TestAge"), plainInfo.GetAge());
+    EXPECT_EQ(ST_LITERAL("TestPage"), plainInfo.GetPage());
+}
+
+TEST(plPageBlockStream, random_access)
+{
+    plPageInfo info;
+    std::vector<uint8_t> raw = MakePage(info);
+
+    plPageInfo packedInfo;
+    auto stream = CompressPage(raw, info, 4 * 1024, packedInfo);
+
+    // Reads that start and end anywhere, including across block boundaries
+    std::mt19937 rng(5678);
+    std::vector<uint8_t> buf;
+    for (int i = 0; i < 200; i++) {
+        uint32_t pos = rng() % raw.size();
+        uint32_t len = std::min<uint32_t>(rng() % 10000, uint32_t(raw.size()) - pos);
+
+        buf.resize(len);
+        stream->SetPosition(pos);
+        ASSERT_EQ(len, stream->Read(len, buf.data()));
+        EXPECT_EQ(0, memcmp(buf.data(), raw.data() + pos, len)) << "pos " << pos << " len " << len;
+    }
+
+    // Reading off the end stops at the end
+    stream->SetPosition(uint32_t(raw.size()) - 4);
+    buf.resize(16);
+    EXPECT_EQ(4U, stream->Read(16, buf.data()));
+    EXPECT_TRUE(stream->AtEnd());
+}
+
+TEST(plPageBlockStream, prefetch)
+{
+    plPageInfo info;
+    std::vector<uint8_t> raw = MakePage(info);
+
+    plPageInfo packedInfo;
+    auto stream = CompressPage(raw, info, 8 * 1024, packedInfo);
+
+    stream->Prefetch();
+
+    std::vector<uint8_t> buf(raw.size());
+    stream->Rewind();
+    ASSERT_EQ(raw.size(), stream->Read(uint32_t(buf.size()), buf.data()));
+    EXPECT_EQ(raw, buf);
+}
+
+TEST(plPageBlockStream, corrupt_block_table)
+{
+    plPageInfo info;
+    std::vector<uint8_t> raw = MakePage(info);
+
+    hsReadOnlyStream src(int(raw.size()), raw.data());
+    hsRAMStream packed;
+    ASSERT_TRUE(plPageBlockStream::WritePage(&src, info, &packed, 8 * 1024));
+    std::vector<uint8_t> good(packed.GetEOF());
+    packed.CopyToMem(good.data());
+
+    plPageInfo goodInfo;
+    {
+        hsReadOnlyStream s(int(good.size()), good.data());
+        goodInfo.Read(&s);
+    }
+    ASSERT_TRUE(goodInfo.HasBlockTable());
+
+    // The block count sits just before the offsets at the end of the header
+    hsRAMStream header;
+    goodInfo.Write(&header);
+    uint32_t countPos = header.GetEOF() - uint32_t(goodInfo.GetBlockOffsets().size() + 1) * sizeof(uint32_t);
+
+    // A block count that can't possibly fit in the file
+    std::vector<uint8_t> bad = good;
+    bad[countPos + 3] = 0x7F;
+    {
+        hsReadOnlyStream s(int(bad.size()), bad.data());
+        plPageInfo badInfo;
+        badInfo.Read(&s);
+        EXPECT_TRUE(badInfo.IsBlockCompressed());
+        EXPECT_FALSE(badInfo.HasBlockTable());
+        EXPECT_EQ(0U, badInfo.GetNumBlocks());
+    }
+
+    // Blocks running past the end of a truncated file
+    bad.assign(good.begin(), good.end() - 100);
+    {
+        auto s = std::make_unique<hsReadOnlyStream>(int(bad.size()), bad.data());
+        plPageInfo badInfo;
+        badInfo.Read(s.get());
+        EXPECT_FALSE(badInfo.HasBlockTable());
+
+        // Nothing past the header comes back out of it
+        plPageBlockStream stream(std::move(s), badInfo);
+        EXPECT_EQ(info.GetDataStart(), stream.GetEOF());
+        std::vector<uint8_t> buf(raw.size());
+        EXPECT_EQ(info.GetDataStart(), stream.Read(uint32_t(buf.size()), buf.data()));
+    }
+}
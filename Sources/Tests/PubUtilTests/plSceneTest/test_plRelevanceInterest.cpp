@@ -0,0 +1,100 @@
+/*==LICENSE==*
+
+CyanWorlds.com Engine - MMOG client, server and tools
+Copyright (C) 2011  Cyan Worlds, Inc.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+Additional permissions under GNU GPL version 3 section 7
+
+If you modify this Program, or any covered work, by linking or
+combining it with any of RAD Game Tools Bink SDK, Autodesk 3ds Max SDK,
+NVIDIA PhysX SDK, Microsoft DirectX SDK, OpenSSL library, Independent
+JPEG Group JPEG library, Microsoft Windows Media SDK, or Apple QuickTime SDK
+(or a modified version of those libraries),
+containing parts covered by the terms of the Bink SDK EULA, 3ds Max EULA,
+PhysX SDK EULA, DirectX SDK EULA, OpenSSL and SSLeay licenses, IJG
+JPEG Library README, Windows Media SDK EULA, or QuickTime SDK EULA, the
+licensors of this Program grant you additional
+permission to convey the resulting work. Corresponding Source for a
+non-source form of such a combination shall include the source code for
+the parts of OpenSSL and IJG JPEG Library used as well as that of the covered
+work.
+
+You can contact Cyan Worlds, Inc. by email legal@cyan.com
+ or by snail mail at:
+      Cyan Worlds, Inc.
+      14617 N Newport Hwy
+      Mead, WA   99021
+
+*==LICENSE==*/
+
+#include <gtest/gtest.h>
+
+#include "plScene/plRelevanceInterest.h"
+
+TEST(plRelevanceInterest, Levels)
+{
+    plRelevanceInterest interest;
+    interest.SetDistances(10.f, 50.f);
+
+    hsBitVector regionA, regionB;
+    regionA.SetBit(1);
+    regionB.SetBit(2);
+    hsPoint3 origin(0.f, 0.f, 0.f);
+
+    EXPECT_EQ(interest.GetLevel(origin, regionA, hsPoint3(5.f, 0.f, 0.f), regionA), plRelevanceInterest::kFull);
+    EXPECT_EQ(interest.GetLevel(origin, regionA, hsPoint3(0.f, 30.f, 0.f), regionA), plRelevanceInterest::kNear);
+    EXPECT_EQ(interest.GetLevel(origin, regionA, hsPoint3(0.f, 0.f, 80.f), regionA), plRelevanceInterest::kFar);
+    EXPECT_EQ(interest.GetLevel(origin, regionA, hsPoint3(5.f, 0.f, 0.f), regionB), plRelevanceInterest::kIgnored);
+
+    // No regions at all means relevance regions are off; distance still counts
+    EXPECT_EQ(interest.GetLevel(origin, hsBitVector(), hsPoint3(5.f, 0.f, 0.f), hsBitVector()), plRelevanceInterest::kFull);
+    EXPECT_EQ(interest.GetLevel(origin, hsBitVector(), hsPoint3(80.f, 0.f, 0.f), hsBitVector()), plRelevanceInterest::kFar);
+
+    interest.SetEnabled(false);
+    EXPECT_EQ(interest.GetLevel(origin, regionA, hsPoint3(5.f, 0.f, 0.f), regionB), plRelevanceInterest::kFull);
+    EXPECT_EQ(interest.GetBestLevel(origin, regionA), plRelevanceInterest::kFull);
+}
+
+TEST(plRelevanceInterest, BestViewerWins)
+{
+    plRelevanceInterest interest;
+    interest.SetDistances(10.f, 50.f);
+
+    hsBitVector region;
+    region.SetBit(1);
+    hsPoint3 subject(0.f, 0.f, 0.f);
+
+    // Nobody has reported in yet, so nobody can be left out
+    EXPECT_EQ(interest.GetBestLevel(subject, region), plRelevanceInterest::kFull);
+
+    interest.SetViewer(1, hsPoint3(100.f, 0.f, 0.f), region);
+    EXPECT_EQ(interest.GetBestLevel(subject, region), plRelevanceInterest::kFar);
+
+    interest.SetViewer(2, hsPoint3(3.f, 0.f, 0.f), region);
+    EXPECT_EQ(interest.GetBestLevel(subject, region), plRelevanceInterest::kFull);
+    EXPECT_EQ(interest.GetNumViewers(), 2U);
+
+    // Moving a viewer updates it in place
+    interest.SetViewer(2, hsPoint3(20.f, 0.f, 0.f), region);
+    EXPECT_EQ(interest.GetBestLevel(subject, region), plRelevanceInterest::kNear);
+    EXPECT_EQ(interest.GetNumViewers(), 2U);
+
+    interest.RemoveViewer(2);
+    EXPECT_EQ(interest.GetBestLevel(subject, region), plRelevanceInterest::kFar);
+
+    interest.RemoveViewer(1);
+    EXPECT_EQ(interest.GetBestLevel(subject, region), plRelevanceInterest::kFull);
+}
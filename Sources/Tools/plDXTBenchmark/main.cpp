@@ -0,0 +1,173 @@
+/*==LICENSE==*
+
+CyanWorlds.com Engine - MMOG client, server and tools
+Copyright (C) 2011  Cyan Worlds, Inc.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+Additional permissions under GNU GPL version 3 section 7
+
+If you modify this Program, or any covered work, by linking or
+combining it with any of RAD Game Tools Bink SDK, Autodesk 3ds Max SDK,
+NVIDIA PhysX SDK, Microsoft DirectX SDK, OpenSSL library, Independent
+JPEG Group JPEG library, Microsoft Windows Media SDK, or Apple QuickTime SDK
+(or a modified version of those libraries),
+containing parts covered by the terms of the Bink SDK EULA, 3ds Max EULA,
+PhysX SDK EULA, DirectX SDK EULA, OpenSSL and SSLeay licenses, IJG
+JPEG Library README, Windows Media SDK EULA, or QuickTime SDK EULA, the
+licensors of this Program grant you additional
+permission to convey the resulting work. Corresponding Source for a
+non-source form of such a combination shall include the source code for
+the parts of OpenSSL and IJG JPEG Library used as well as that of the covered
+work.
+
+You can contact Cyan Worlds, Inc. by email legal@cyan.com
+ or by snail mail at:
+      Cyan Worlds, Inc.
+      14617 N Newport Hwy
+      Mead, WA   99021
+
+*==LICENSE==*/
+
+#include <chrono>
+#include <random>
+#include <string_theory/stdio>
+
+#include "plCmdParser.h"
+#include "hsMain.inl"
+
+#include "plGImage/hsCodecManager.h"
+#include "plGImage/hsDXTSoftwareCodec.h"
+#include "plGImage/plMipmap.h"
+
+enum CmdLineArgs
+{
+    kArgCount,
+    kArgSize,
+};
+
+static const plCmdArgDef s_cmdLineArgs[] = {
+    { (kCmdTypeUint | kCmdArgFlagged), "Count", kArgCount },
+    { (kCmdTypeUint | kCmdArgFlagged), "Size", kArgSize },
+};
+
+using ClockT = std::chrono::steady_clock;
+
+struct DecodeMode
+{
+    const char* fName;
+    uint8_t     fFlags;
+};
+
+static const DecodeMode s_modes[] = {
+    { "To32",       hsCodecManager::k32BitDepth },
+    { "To16",       hsCodecManager::k16BitDepth },
+    { "To16Weird",  hsCodecManager::k16BitDepth | hsCodecManager::kWeirdCompOrder },
+};
+
+// Something a bit like real texture data: gradients, flat areas and noise
+static void IFillMipmap(plMipmap* mip, bool alpha)
+{
+    std::mt19937 rng(1234);
+    for (uint8_t l = 0; l < mip->GetNumLevels(); l++) {
+        mip->SetCurrLevel(l);
+        for (uint32_t y = 0; y < mip->GetCurrHeight(); y++) {
+            for (uint32_t x = 0; x < mip->GetCurrWidth(); x++) {
+                uint32_t noise = rng();
+                uint8_t r = uint8_t(x + (noise & 0x0f));
+                uint8_t g = uint8_t(y + ((noise >> 8) & 0x0f));
+                uint8_t b = ((x / 16 + y / 16) & 1) ? 0x40 : uint8_t(noise >> 16);
+                uint8_t a = alpha ? uint8_t(x ^ y) : 0xff;
+                *mip->GetAddr32(x, y) = (uint32_t(a) << 24) | (uint32_t(r) << 16) | (uint32_t(g) << 8) | b;
+            }
+        }
+    }
+    mip->SetCurrLevel(0);
+}
+
+static void IPrintRate(const char* name, ClockT::duration elapsed, int32_t count, uint32_t pixels)
+{
+    auto us = std::chrono::duration_cast<std::chrono::microseconds>(elapsed / count);
+    double seconds = std::chrono::duration<double>(elapsed).count();
+    double mpix = seconds > 0.0 ? double(pixels) * count / seconds / 1000000.0 : 0.0;
+    ST::printf("  {<12} {>8} us  {>8.1f} Mpixel/s\n", name, us.count(), mpix);
+}
+
+static int hsMain(std::vector<ST::string> args)
+{
+    plCmdParser parser(s_cmdLineArgs, std::size(s_cmdLineArgs));
+    if (!parser.Parse(args)) {
+        ST::printf(stderr, "Usage: plDXTBenchmark [-Count N] [-Size N]\n");
+        return 1;
+    }
+
+    int32_t count = 10;
+    if (parser.IsSpecified(kArgCount))
+        count = parser.GetInt(kArgCount);
+    if (count <= 0) {
+        ST::printf(stderr, "Cannot iterate less than 1 time.\n");
+        return 1;
+    }
+
+    uint32_t size = 1024;
+    if (parser.IsSpecified(kArgSize))
+        size = parser.GetInt(kArgSize);
+    if (size < 4 || (size & (size - 1))) {
+        ST::printf(stderr, "Size must be a power of two, 4 or bigger.\n");
+        return 1;
+    }
+
+    hsDXTSoftwareCodec::Init();
+    hsDXTSoftwareCodec& codec = hsDXTSoftwareCodec::Instance();
+
+    ST::printf("{}x{} with mips, {} iterations each\n", size, size, count);
+
+    for (bool alpha : { false, true }) {
+        plMipmap src(size, size, plMipmap::kARGB32Config, 0);
+        if (alpha)
+            src.SetFlags(src.GetFlags() | plMipmap::kAlphaChannelFlag);
+        IFillMipmap(&src, alpha);
+
+        uint32_t pixels = 0;
+        for (uint8_t l = 0; l < src.GetNumLevels(); l++)
+            pixels += src.GetLevelSize(l) / 4;
+
+        ST::printf("\n{}\n", alpha ? "DXT5" : "DXT1");
+
+        plMipmap* comp = nullptr;
+        auto elapsed = ClockT::duration::zero();
+        for (int32_t i = 0; i < count; ++i) {
+            delete comp;
+            auto begin = ClockT::now();
+            comp = codec.CreateCompressedMipmap(&src);
+            elapsed += ClockT::now() - begin;
+        }
+        IPrintRate("Compress", elapsed, count, pixels);
+
+        for (const DecodeMode& mode : s_modes) {
+            elapsed = ClockT::duration::zero();
+            for (int32_t i = 0; i < count; ++i) {
+                auto begin = ClockT::now();
+                plMipmap* un = codec.CreateUncompressedMipmap(comp, mode.fFlags);
+                elapsed += ClockT::now() - begin;
+                delete un;
+            }
+            IPrintRate(mode.fName, elapsed, count, pixels);
+        }
+        delete comp;
+    }
+
+    ST::printf("\nHave a nice day!\n");
+    return 0;
+}
@@ -0,0 +1,145 @@
+/*==LICENSE==*
+
+CyanWorlds.com Engine - MMOG client, server and tools
+Copyright (C) 2011  Cyan Worlds, Inc.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+Additional permissions under GNU GPL version 3 section 7
+
+If you modify this Program, or any covered work, by linking or
+combining it with any of RAD Game Tools Bink SDK, Autodesk 3ds Max SDK,
+NVIDIA PhysX SDK, Microsoft DirectX SDK, OpenSSL library, Independent
+JPEG Group JPEG library, Microsoft Windows Media SDK, or Apple QuickTime SDK
+(or a modified version of those libraries),
+containing parts covered by the terms of the Bink SDK EULA, 3ds Max EULA,
+PhysX SDK EULA, DirectX SDK EULA, OpenSSL and SSLeay licenses, IJG
+JPEG Library README, Windows Media SDK EULA, or QuickTime SDK EULA, the
+licensors of this Program grant you additional
+permission to convey the resulting work. Corresponding Source for a
+non-source form of such a combination shall include the source code for
+the parts of OpenSSL and IJG JPEG Library used as well as that of the covered
+work.
+
+You can contact Cyan Worlds, Inc. by email legal@cyan.com
+ or by snail mail at:
+      Cyan Worlds, Inc.
+      14617 N Newport Hwy
+      Mead, WA   99021
+
+*==LICENSE==*/
+
+#include <chrono>
+#include <string_theory/stdio>
+#include <vector>
+
+#include "plCmdParser.h"
+#include "hsMain.inl"
+
+#include "pnNucleusCreatables.h"
+
+enum CmdLineArgs
+{
+    kArgCount,
+};
+
+static const plCmdArgDef s_cmdLineArgs[] = {
+    { (kCmdTypeUint | kCmdArgFlagged), "Count", kArgCount },
+};
+
+using ClockT = std::chrono::steady_clock;
+
+// Keeps the compiler from throwing away the lookups we're timing
+static volatile size_t s_sink;
+
+template<typename Func>
+static void ITime(const char* name, int32_t count, size_t ops, Func func)
+{
+    auto elapsed = ClockT::duration::zero();
+    for (int32_t i = 0; i < count; ++i) {
+        auto begin = ClockT::now();
+        func();
+        elapsed += ClockT::now() - begin;
+    }
+
+    double seconds = std::chrono::duration<double>(elapsed).count();
+    double ns = ops && count ? seconds * 1000000000.0 / (double(ops) * count) : 0.0;
+    ST::printf("  {<32} {>10.2f} ns/op\n", name, ns);
+}
+
+static int hsMain(std::vector<ST::string> args)
+{
+    plCmdParser parser(s_cmdLineArgs, std::size(s_cmdLineArgs));
+    if (!parser.Parse(args)) {
+        ST::printf(stderr, "Usage: plDispatchBenchmark [-Count N]\n");
+        return 1;
+    }
+
+    int32_t count = 100;
+    if (parser.IsSpecified(kArgCount))
+        count = parser.GetInt(kArgCount);
+    if (count <= 0) {
+        ST::printf(stderr, "Cannot iterate less than 1 time.\n");
+        return 1;
+    }
+
+    // One of every message we can make, which is a nice mix of shallow and
+    // deep class chains.
+    std::vector<plMessage*> msgs;
+    for (uint16_t i : plFactory::GetDerivedClasses(plMessage::Index())) {
+        if (plMessage* msg = plMessage::ConvertNoRef(plFactory::Create(i)))
+            msgs.emplace_back(msg);
+    }
+    const uint16_t numClasses = plFactory::GetNumClasses();
+    ST::printf("{} messages, {} class indices, {} iterations each\n\n", msgs.size(), numClasses, count);
+
+    const uint16_t targets[] = { plMessage::Index(), plRefMsg::Index(), plTimeMsg::Index(), hsKeyedObject::Index() };
+
+    ITime("ConvertNoRef", count, msgs.size() * std::size(targets), [&msgs]() {
+        size_t hits = 0;
+        for (plMessage* msg : msgs) {
+            hits += plMessage::ConvertNoRef(msg) != nullptr;
+            hits += plRefMsg::ConvertNoRef(msg) != nullptr;
+            hits += plTimeMsg::ConvertNoRef(msg) != nullptr;
+            hits += hsKeyedObject::ConvertNoRef(msg) != nullptr;
+        }
+        s_sink = hits;
+    });
+
+    ITime("DerivesFrom", count, size_t(numClasses) * std::size(targets), [numClasses, &targets]() {
+        size_t hits = 0;
+        for (uint16_t i = 0; i < numClasses; i++) {
+            for (uint16_t target : targets)
+                hits += plFactory::DerivesFrom(target, i);
+        }
+        s_sink = hits;
+    });
+
+    // Tearing a dispatcher down wants a resource manager, which we don't
+    // have, so this one is just left to the OS.
+    plDispatch* dispatch = new plDispatch();
+    for (uint16_t target : targets) {
+        ST::string name = ST::format("RegisterForType {}", plFactory::GetNameOfClass(target));
+        ITime(name.c_str(), count, 1, [dispatch, target]() {
+            dispatch->RegisterForType(target, nullptr);
+            dispatch->UnRegisterForType(target, nullptr);
+        });
+    }
+
+    for (plMessage* msg : msgs)
+        hsRefCnt_SafeUnRef(msg);
+
+    ST::printf("\nHave a nice day!\n");
+    return 0;
+}
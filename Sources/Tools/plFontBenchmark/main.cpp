@@ -0,0 +1,160 @@
+/*==LICENSE==*
+
+CyanWorlds.com Engine - MMOG client, server and tools
+Copyright (C) 2011  Cyan Worlds, Inc.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+Additional permissions under GNU GPL version 3 section 7
+
+If you modify this Program, or any covered work, by linking or
+combining it with any of RAD Game Tools Bink SDK, Autodesk 3ds Max SDK,
+NVIDIA PhysX SDK, Microsoft DirectX SDK, OpenSSL library, Independent
+JPEG Group JPEG library, Microsoft Windows Media SDK, or Apple QuickTime SDK
+(or a modified version of those libraries),
+containing parts covered by the terms of the Bink SDK EULA, 3ds Max EULA,
+PhysX SDK EULA, DirectX SDK EULA, OpenSSL and SSLeay licenses, IJG
+JPEG Library README, Windows Media SDK EULA, or QuickTime SDK EULA, the
+licensors of this Program grant you additional
+permission to convey the resulting work. Corresponding Source for a
+non-source form of such a combination shall include the source code for
+the parts of OpenSSL and IJG JPEG Library used as well as that of the covered
+work.
+
+You can contact Cyan Worlds, Inc. by email legal@cyan.com
+ or by snail mail at:
+      Cyan Worlds, Inc.
+      14617 N Newport Hwy
+      Mead, WA   99021
+
+*==LICENSE==*/
+
+#include <chrono>
+#include <cstring>
+#include <string_theory/stdio>
+
+#include "plCmdParser.h"
+#include "plFileSystem.h"
+#include "hsMain.inl"
+
+#include "plGImage/plFont.h"
+#include "plGImage/plMipmap.h"
+
+enum CmdLineArgs
+{
+    kArgCount,
+    kArgFont,
+};
+
+static const plCmdArgDef s_cmdLineArgs[] = {
+    { (kCmdTypeUint | kCmdArgFlagged), "Count", kArgCount },
+    { (kCmdTypeString | kCmdArgRequired), "Font", kArgFont },
+};
+
+using ClockT = std::chrono::steady_clock;
+
+static const char s_sampleText[] =
+    "The quick brown fox jumps over the lazy dog. Shorah b'shem! "
+    "Relto, Kadish Tolesa, Er'cana, Ahnonay, Minkata, Eder Gira, Teledahn. "
+    "0123456789 !@#$%^&*()_+-=[]{};':\",./<>?";
+
+struct BenchMode
+{
+    const char* fName;
+    uint32_t    fFlags;
+    uint32_t    fColor;
+};
+
+static const BenchMode s_modes[] = {
+    { "Plain",       0,                                                    0xffffffff },
+    { "Translucent", 0,                                                    0x80ffc040 },
+    { "Bold",        plFont::kRenderBold,                                  0xffffffff },
+    { "IntoAlpha",   plFont::kRenderIntoAlpha,                             0xffffffff },
+    { "Shadow",      plFont::kRenderAlphaPremultiplied | plFont::kRenderShadow, 0xffffffff },
+};
+
+static ClockT::duration IRender(plFont* font, plMipmap* mip, const BenchMode& mode, int32_t count)
+{
+    font->SetRenderFlag(mode.fFlags, true);
+    font->SetRenderColor(mode.fColor);
+
+    auto elapsed = ClockT::duration::zero();
+    for (int32_t i = 0; i < count; ++i) {
+        memset(mip->GetImage(), 0, mip->GetCurrLevelSize());
+        auto begin = ClockT::now();
+        font->RenderString(mip, 4, 4, ST::string(s_sampleText));
+        elapsed += ClockT::now() - begin;
+    }
+
+    font->SetRenderFlag(mode.fFlags, false);
+    return elapsed;
+}
+
+static int hsMain(std::vector<ST::string> args)
+{
+    plCmdParser parser(s_cmdLineArgs, std::size(s_cmdLineArgs));
+    if (!parser.Parse(args)) {
+        ST::printf(stderr, "Usage: plFontBenchmark [-Count N] font.p2f\n");
+        return 1;
+    }
+
+    plFileName fontFile = parser.GetString(kArgFont);
+    if (!plFileInfo(fontFile).Exists()) {
+        ST::printf(stderr, "The font '{}' does not exist.\n", fontFile);
+        return 1;
+    }
+
+    int32_t count = 1000;
+    if (parser.IsSpecified(kArgCount))
+        count = parser.GetInt(kArgCount);
+    if (count <= 0) {
+        ST::printf(stderr, "Cannot iterate less than 1 time.\n");
+        return 1;
+    }
+
+    plFont font;
+    if (!font.LoadFromP2FFile(fontFile)) {
+        ST::printf(stderr, "Unable to load '{}'.\n", fontFile);
+        return 1;
+    }
+    font.SetRenderFlag(plFont::kRenderWrap | plFont::kRenderClip, true);
+    font.SetRenderClipping(0, 0, 512, 256);
+
+    plMipmap uncached(512, 256, plMipmap::kARGB32Config, 1);
+    plMipmap cached(512, 256, plMipmap::kARGB32Config, 1);
+
+    ST::printf("Rendering with '{}' ({}pt, {}bpp), {} iterations per mode\n\n",
+               font.GetFace(), font.GetSize(), font.GetBitmapBPP(), count);
+
+    int result = 0;
+    for (const BenchMode& mode : s_modes) {
+        plFont::SetRenderCaching(false);
+        auto slow = IRender(&font, &uncached, mode, count);
+        plFont::SetRenderCaching(true);
+        auto fast = IRender(&font, &cached, mode, count);
+
+        bool match = memcmp(uncached.GetImage(), cached.GetImage(), cached.GetCurrLevelSize()) == 0;
+        if (!match)
+            result = 1;
+
+        auto slow_us = std::chrono::duration_cast<std::chrono::microseconds>(slow / count);
+        auto fast_us = std::chrono::duration_cast<std::chrono::microseconds>(fast / count);
+        double speedup = fast.count() ? double(slow.count()) / double(fast.count()) : 0.0;
+        ST::printf("{<12} uncached {>6} us, cached {>6} us, {.2f}x{}\n", mode.fName,
+                   slow_us.count(), fast_us.count(), speedup, match ? "" : "  ** OUTPUT MISMATCH **");
+    }
+
+    ST::printf("\nHave a nice day!\n");
+    return result;
+}
@@ -0,0 +1,164 @@
+/*==LICENSE==*
+
+CyanWorlds.com Engine - MMOG client, server and tools
+Copyright (C) 2011  Cyan Worlds, Inc.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+Additional permissions under GNU GPL version 3 section 7
+
+If you modify this Program, or any covered work, by linking or
+combining it with any of RAD Game Tools Bink SDK, Autodesk 3ds Max SDK,
+NVIDIA PhysX SDK, Microsoft DirectX SDK, OpenSSL library, Independent
+JPEG Group JPEG library, Microsoft Windows Media SDK, or Apple QuickTime SDK
+(or a modified version of those libraries),
+containing parts covered by the terms of the Bink SDK EULA, 3ds Max EULA,
+PhysX SDK EULA, DirectX SDK EULA, OpenSSL and SSLeay licenses, IJG
+JPEG Library README, Windows Media SDK EULA, or QuickTime SDK EULA, the
+licensors of this Program grant you additional
+permission to convey the resulting work. Corresponding Source for a
+non-source form of such a combination shall include the source code for
+the parts of OpenSSL and IJG JPEG Library used as well as that of the covered
+work.
+
+You can contact Cyan Worlds, Inc. by email legal@cyan.com
+ or by snail mail at:
+      Cyan Worlds, Inc.
+      14617 N Newport Hwy
+      Mead, WA   99021
+
+*==LICENSE==*/
+
+#include <chrono>
+#include <memory>
+#include <random>
+#include <string_theory/stdio>
+
+#include "plCmdParser.h"
+#include "hsMain.inl"
+
+#include "plGImage/plMipmap.h"
+
+enum CmdLineArgs
+{
+    kArgCount,
+    kArgSize,
+};
+
+static const plCmdArgDef s_cmdLineArgs[] = {
+    { (kCmdTypeUint | kCmdArgFlagged), "Count", kArgCount },
+    { (kCmdTypeUint | kCmdArgFlagged), "Size", kArgSize },
+};
+
+using ClockT = std::chrono::steady_clock;
+
+// Noisy gradients with some fully transparent blocks, so the blends have
+// pixels to skip
+static void IFillImage(plMipmap* mip, uint32_t seed)
+{
+    std::mt19937 rng(seed);
+    for (uint32_t y = 0; y < mip->GetCurrHeight(); y++) {
+        for (uint32_t x = 0; x < mip->GetCurrWidth(); x++) {
+            uint32_t noise = rng();
+            uint8_t r = uint8_t(x + (noise & 0x0f));
+            uint8_t g = uint8_t(y + ((noise >> 8) & 0x0f));
+            uint8_t b = uint8_t(noise >> 16);
+            uint8_t a = ((x / 8 + y / 8) % 3 == 0) ? 0 : uint8_t(noise >> 24);
+            *mip->GetAddr32(x, y) = (uint32_t(a) << 24) | (uint32_t(r) << 16) | (uint32_t(g) << 8) | b;
+        }
+    }
+}
+
+template<typename Func>
+static void ITime(const char* name, int32_t count, uint32_t pixels, Func func)
+{
+    auto elapsed = ClockT::duration::zero();
+    for (int32_t i = 0; i < count; ++i) {
+        auto begin = ClockT::now();
+        func();
+        elapsed += ClockT::now() - begin;
+    }
+
+    auto us = std::chrono::duration_cast<std::chrono::microseconds>(elapsed / count);
+    double seconds = std::chrono::duration<double>(elapsed).count();
+    double mpix = seconds > 0.0 ? double(pixels) * count / seconds / 1000000.0 : 0.0;
+    ST::printf("  {<16} {>8} us  {>8.1f} Mpixel/s\n", name, us.count(), mpix);
+}
+
+static int hsMain(std::vector<ST::string> args)
+{
+    plCmdParser parser(s_cmdLineArgs, std::size(s_cmdLineArgs));
+    if (!parser.Parse(args)) {
+        ST::printf(stderr, "Usage: plMipmapBenchmark [-Count N] [-Size N]\n");
+        return 1;
+    }
+
+    int32_t count = 10;
+    if (parser.IsSpecified(kArgCount))
+        count = parser.GetInt(kArgCount);
+    if (count <= 0) {
+        ST::printf(stderr, "Cannot iterate less than 1 time.\n");
+        return 1;
+    }
+
+    uint32_t size = 1024;
+    if (parser.IsSpecified(kArgSize))
+        size = parser.GetInt(kArgSize);
+    if (size < 4 || (size & (size - 1))) {
+        ST::printf(stderr, "Size must be a power of two, 4 or bigger.\n");
+        return 1;
+    }
+
+    ST::printf("{}x{}, {} iterations each\n\n", size, size, count);
+
+    plMipmap image(size, size, plMipmap::kARGB32Config, 1);
+    IFillImage(&image, 42);
+    uint32_t pixels = size * size;
+
+    for (float sig : { 1.f, 2.5f }) {
+        ITime(sig < 2.f ? "Filter 1.0" : "Filter 2.5", count, pixels, [&image, sig]() {
+            std::unique_ptr<plMipmap> filtered(image.Clone());
+            filtered->Filter(sig);
+        });
+    }
+
+    ITime("Mip chain", count, pixels, [&image]() {
+        plMipmap mips(&image, 1.f, 0, 0.f, 0.f, 0.f, 0.f);
+    });
+
+    for (uint32_t dest : { size / 3, size * 2 - 7 }) {
+        std::unique_ptr<uint32_t[]> scaled(new uint32_t[dest * dest]);
+        ST::string name = ST::format("Scale to {}", dest);
+        ITime(name.c_str(), count, dest * dest, [&image, &scaled, dest]() {
+            image.ScaleNicely(scaled.get(), uint16_t(dest), uint16_t(dest), uint16_t(dest), plMipmap::kDefaultFilter);
+        });
+    }
+
+    plMipmap overlay(size / 2, size / 2, plMipmap::kARGB32Config, 1);
+    IFillImage(&overlay, 7);
+    uint32_t overlayPixels = (size / 2) * (size / 2);
+
+    plMipmap::CompositeOptions blend(0, 0, 0.5f, 0.75f, 0.2f, 0, 0, 0, 0, 200);
+    ITime("Composite blend", count, overlayPixels, [&image, &overlay, &blend]() {
+        image.Composite(&overlay, 0, 0, &blend);
+    });
+
+    plMipmap::CompositeOptions premult(plMipmap::kCopySrcAlpha | plMipmap::kDestPremultiplied);
+    ITime("Composite premul", count, overlayPixels, [&image, &overlay, &premult]() {
+        image.Composite(&overlay, 0, 0, &premult);
+    });
+
+    ST::printf("\nHave a nice day!\n");
+    return 0;
+}
@@ -46,6 +46,7 @@ You can contact Cyan Worlds, Inc. by email legal@cyan.com
 
 #include <memory>
 #include <string_theory/format>
+#include <string_theory/stdio>
 
 #include "pnFactory/plFactory.h"
 #include "pnKeyedObject/plKeyImp.h"
@@ -64,6 +65,7 @@ plResManager* gResMgr = nullptr;
 
 bool DumpStats(const plFileName& patchDir);
 bool DumpSounds();
+bool DumpCompression();
 
 //// PrintVersion ///////////////////////////////////////////////////////////////
 void PrintVersion()
@@ -78,12 +80,13 @@ int PrintHelp()
     puts("");
     PrintVersion();
     puts("");
-    puts("Usage: plPageInfo [-s -i] pageFile");
+    puts("Usage: plPageInfo [-s -i -c] pageFile");
     puts("       plPageInfo -v");
     puts("Where:" );
     puts("       -v print version and exit.");
     puts("       -s dump sounds in page to the console");
     puts("       -i dump object size info to .csv files");
+    puts("       -c print the page's block compression ratio");
     puts("       pageFile is the path to the .prp file");
     puts("");
 
@@ -105,6 +108,7 @@ int main(int argc, char* argv[])
 
     bool sounds = false;
     bool stats = false;
+    bool compression = false;
 
     int arg = 1;
     for (arg = 1; arg < argc; arg++)
@@ -113,6 +117,8 @@ int main(int argc, char* argv[])
             sounds = true;
         else if (strcmp(argv[arg], "-i") == 0)
             stats = true;
+        else if (strcmp(argv[arg], "-c") == 0)
+            compression = true;
         else
             break;
     }
@@ -136,6 +142,8 @@ int main(int argc, char* argv[])
         DumpSounds();
     if (stats)
         DumpStats(pageFile.StripFileName());
+    if (compression)
+        DumpCompression();
 
     hsgResMgr::Shutdown();
 
@@ -260,3 +268,36 @@ bool DumpStats(const plFileName& patchDir)
     gResMgr->IterateAllPages(&statDump);
     return true;
 }
+
+//////////////////////////////////////////////////////////////////////////
+
+class plCompressionDumpIterator : public plRegistryPageIterator
+{
+public:
+    bool EatPage(plRegistryPageNode* page) override
+    {
+        const plPageInfo& info = page->GetPageInfo();
+        uint32_t dataSize = info.GetChecksum();
+
+        ST::printf("{}_{}: ", info.GetAge(), info.GetPage());
+        if (!info.IsBlockCompressed())
+        {
+            ST::printf("uncompressed, {} bytes of data\n", dataSize);
+            return true;
+        }
+
+        uint32_t compressedSize = info.GetCompressedSize();
+        ST::printf("{} blocks of {} KiB, {} -> {} bytes ({.1f}%)\n",
+                   info.GetNumBlocks(), info.GetBlockSize() / 1024,
+                   dataSize, compressedSize,
+                   dataSize ? compressedSize * 100.0 / dataSize : 100.0);
+        return true;
+    }
+};
+
+bool DumpCompression()
+{
+    plCompressionDumpIterator compressionDump;
+    gResMgr->IterateAllPages(&compressionDump);
+    return true;
+}
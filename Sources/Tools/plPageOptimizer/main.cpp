@@ -55,13 +55,16 @@ You can contact Cyan Worlds, Inc. by email legal@cyan.com
 
 int main(int argc, char* argv[])
 {
-    if (argc != 2)
+    bool compress = (argc == 3 && strcmp(argv[1], "-c") == 0);
+    if (argc != (compress ? 3 : 2))
     {
         puts("plPageOptimizer: wrong number of arguments");
+        puts("Usage: plPageOptimizer [-c] pageFile");
+        puts("       -c store the page in compressed blocks");
         return 1;
     }
 
-    plFileName filename = argv[1];
+    plFileName filename = argv[argc - 1];
     ST::printf("Optimizing {}...", filename);
 
     plFontCache* fontCache;
@@ -89,7 +92,7 @@ int main(int argc, char* argv[])
     try
 #endif
     {
-        plPageOptimizer optimizer(argv[1]);
+        plPageOptimizer optimizer(filename, compress);
         optimizer.Optimize();
     }
 #ifndef HS_DEBUGGING
@@ -50,13 +50,19 @@ You can contact Cyan Worlds, Inc. by email legal@cyan.com
 #include "plResMgr/plResManager.h"
 #include "plResMgr/plRegistryHelpers.h"
 #include "plResMgr/plKeyFinder.h"
+#include "plResMgr/plPageBlockStream.h"
 #include "plResMgr/plRegistryNode.h"
 
+#include <string_theory/stdio>
+
 
 plPageOptimizer* plPageOptimizer::fInstance = nullptr;
 
-plPageOptimizer::plPageOptimizer(const plFileName& pagePath) :
+plPageOptimizer::plPageOptimizer(const plFileName& pagePath, bool compress) :
     fOptimized(true),
+    fCompress(compress),
+    fOldSize(),
+    fNewSize(),
     fPageNode(),
     fPagePath(pagePath)
 {
@@ -94,6 +100,7 @@ void plPageOptimizer::Optimize()
     IFindLoc();
 
     bool loaded = true;
+    bool wasCompressed = false;
 
     // Get the key for the scene node, we'll load it to force a load on all the objects
     plKey snKey = plKeyFinder::Instance().FindSceneNodeKey(fLoc);
@@ -102,6 +109,7 @@ void plPageOptimizer::Optimize()
         // Load all the keys
         fPageNode = fResMgr->FindPage(fLoc);
         fResMgr->LoadPageKeys(fPageNode);
+        wasCompressed = fPageNode->GetPageInfo().IsBlockCompressed();
 
         // Put all the keys in a vector, so they won't get unreffed
         class plVecKeyCollector : public plRegistryKeyIterator
@@ -140,17 +148,20 @@ void plPageOptimizer::Optimize()
     {
         puts("no scene node.");
     }
-    else if (fOptimized)
+    else if (fOptimized && fCompress == wasCompressed)
     {
         plFileSystem::Unlink(fTempPagePath);
         puts("already optimized.");
     }
-    else if (oldSize == newSize)
+    else if (fOldSize == fNewSize)
     {
         plFileSystem::Unlink(fPagePath);
         plFileSystem::Move(fTempPagePath, fPagePath);
 
-        puts("complete");
+        if (oldSize != newSize)
+            ST::printf("complete ({} -> {} bytes, {.1f}%)\n", oldSize, newSize, newSize * 100.0 / oldSize);
+        else
+            puts("complete");
     }
     else
     {
@@ -206,68 +217,81 @@ void plPageOptimizer::IWriteKeyData(hsStream* oldPage, hsStream* newPage, plKey&
 
 void plPageOptimizer::IRewritePage()
 {
-    hsUNIXStream newPage;
+    // Work on the uncompressed layout, whichever way the page is stored
+    hsStream* oldPage = fPageNode->OpenStream();
+    if (!oldPage)
+        return;
 
-    if (newPage.Open(fTempPagePath, "wb"))
-    {
-        hsUNIXStream oldPage;
-        oldPage.Open(fPagePath);
+    hsRAMStream newPage;
+    const plPageInfo& pageInfo = fPageNode->GetPageInfo();
 
-        const plPageInfo& pageInfo = fPageNode->GetPageInfo();
+    uint32_t dataStart = pageInfo.GetDataStart();
 
-        uint32_t dataStart = pageInfo.GetDataStart();
+    fBuf.resize(dataStart);
 
-        fBuf.resize(dataStart);
+    oldPage->Rewind();
+    oldPage->Read(dataStart, &fBuf[0]);
+    newPage.Write(dataStart, &fBuf[0]);
 
-        oldPage.Read(dataStart, &fBuf[0]);
-        newPage.Write(dataStart, &fBuf[0]);
+    int size = (int)fKeyLoadOrder.size();
+    for (int i = 0; i < size; i++)
+        IWriteKeyData(oldPage, &newPage, fKeyLoadOrder[i]);
 
-        int size = (int)fKeyLoadOrder.size();
-        for (int i = 0; i < size; i++)
-            IWriteKeyData(&oldPage, &newPage, fKeyLoadOrder[i]);
+    // If there are any objects that we didn't write (because they didn't load for
+    // some reason), put them at the end
+    for (int i = 0; i < fAllKeys.size(); i++)
+    {
+        bool found = (fLoadedKeys.find(fAllKeys[i]) != fLoadedKeys.end());
+        if (!found)
+            IWriteKeyData(oldPage, &newPage, fAllKeys[i]);
+    }
 
-        // If there are any objects that we didn't write (because they didn't load for
-        // some reason), put them at the end
-        for (int i = 0; i < fAllKeys.size(); i++)
-        {
-            bool found = (fLoadedKeys.find(fAllKeys[i]) != fLoadedKeys.end());
-            if (!found)
-                IWriteKeyData(&oldPage, &newPage, fAllKeys[i]);
-        }
+    uint32_t oldKeyStart = pageInfo.GetIndexStart();
+    oldPage->SetPosition(oldKeyStart);
 
-        uint32_t oldKeyStart = pageInfo.GetIndexStart();
-        oldPage.SetPosition(oldKeyStart);
+    uint32_t numTypes = oldPage->ReadLE32();
+    newPage.WriteLE32(numTypes);
 
-        uint32_t numTypes = oldPage.ReadLE32();
-        newPage.WriteLE32(numTypes);
+    for (uint32_t i = 0; i < numTypes; i++)
+    {
+        uint16_t classType = oldPage->ReadLE16();
+        uint32_t len = oldPage->ReadLE32();
+        uint8_t flags = oldPage->ReadByte();
+        uint32_t numKeys = oldPage->ReadLE32();
+
+        newPage.WriteLE16(classType);
+        newPage.WriteLE32(len);
+        newPage.WriteByte(flags);
+        newPage.WriteLE32(numKeys);
 
-        for (uint32_t i = 0; i < numTypes; i++)
+        for (uint32_t j = 0; j < numKeys; j++)
         {
-            uint16_t classType = oldPage.ReadLE16();
-            uint32_t len = oldPage.ReadLE32();
-            uint8_t flags = oldPage.ReadByte();
-            uint32_t numKeys = oldPage.ReadLE32();
-
-            newPage.WriteLE16(classType);
-            newPage.WriteLE32(len);
-            newPage.WriteByte(flags);
-            newPage.WriteLE32(numKeys);
-
-            for (uint32_t j = 0; j < numKeys; j++)
-            {
-                plUoid uoid;
-                uoid.Read(&oldPage);
-                uint32_t startPos = oldPage.ReadLE32();
-                uint32_t dataLen = oldPage.ReadLE32();
-
-                // Get the new start pos
-                const plKeyImp* key = plKeyImp::GetFromKey(fResMgr->FindKey(uoid));
-                startPos = key->GetStartPos();
-
-                uoid.Write(&newPage);
-                newPage.WriteLE32(startPos);
-                newPage.WriteLE32(dataLen);
-            }
+            plUoid uoid;
+            uoid.Read(oldPage);
+            uint32_t startPos = oldPage->ReadLE32();
+            uint32_t dataLen = oldPage->ReadLE32();
+
+            // Get the new start pos
+            const plKeyImp* key = plKeyImp::GetFromKey(fResMgr->FindKey(uoid));
+            startPos = key->GetStartPos();
+
+            uoid.Write(&newPage);
+            newPage.WriteLE32(startPos);
+            newPage.WriteLE32(dataLen);
         }
     }
+
+    fOldSize = oldPage->GetEOF();
+    fNewSize = newPage.GetEOF();
+    fPageNode->CloseStream();
+
+    hsUNIXStream outPage;
+    if (outPage.Open(fTempPagePath, "wb"))
+    {
+        newPage.Rewind();
+        if (fCompress)
+            plPageBlockStream::WritePage(&newPage, pageInfo, &outPage);
+        else
+            outPage.Write(fNewSize, newPage.GetData());
+    }
 }
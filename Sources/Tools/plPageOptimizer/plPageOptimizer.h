@@ -63,6 +63,9 @@ protected:
     std::vector<uint8_t> fBuf;
 
     bool fOptimized;        // True after optimization if the page was already optimized
+    bool fCompress;         // Write the new page block compressed
+    uint32_t fOldSize;      // Uncompressed sizes of the old and new pages, for sanity checking
+    uint32_t fNewSize;
 
     plFileName fPagePath;           // Path to our page
     plFileName fTempPagePath;       // Path to the temp output page
@@ -79,7 +82,7 @@ protected:
     void IRewritePage();
 
 public:
-    plPageOptimizer(const plFileName& pagePath);
+    plPageOptimizer(const plFileName& pagePath, bool compress = false);
 
     void Optimize();
 };
@@ -0,0 +1,141 @@
+/*==LICENSE==*
+
+CyanWorlds.com Engine - MMOG client, server and tools
+Copyright (C) 2011  Cyan Worlds, Inc.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+Additional permissions under GNU GPL version 3 section 7
+
+If you modify this Program, or any covered work, by linking or
+combining it with any of RAD Game Tools Bink SDK, Autodesk 3ds Max SDK,
+NVIDIA PhysX SDK, Microsoft DirectX SDK, OpenSSL library, Independent
+JPEG Group JPEG library, Microsoft Windows Media SDK, or Apple QuickTime SDK
+(or a modified version of those libraries),
+containing parts covered by the terms of the Bink SDK EULA, 3ds Max EULA,
+PhysX SDK EULA, DirectX SDK EULA, OpenSSL and SSLeay licenses, IJG
+JPEG Library README, Windows Media SDK EULA, or QuickTime SDK EULA, the
+licensors of this Program grant you additional
+permission to convey the resulting work. Corresponding Source for a
+non-source form of such a combination shall include the source code for
+the parts of OpenSSL and IJG JPEG Library used as well as that of the covered
+work.
+
+You can contact Cyan Worlds, Inc. by email legal@cyan.com
+ or by snail mail at:
+      Cyan Worlds, Inc.
+      14617 N Newport Hwy
+      Mead, WA   99021
+
+*==LICENSE==*/
+
+#include <chrono>
+#include <random>
+#include <vector>
+#include <string_theory/stdio>
+
+#include "plCmdParser.h"
+#include "hsMain.inl"
+
+#include "plDrawable/plWaveSet7.h"
+
+enum CmdLineArgs
+{
+    kArgCount,
+};
+
+static const plCmdArgDef s_cmdLineArgs[] = {
+    { (kCmdTypeUint | kCmdArgFlagged), "Count", kArgCount },
+};
+
+using ClockT = std::chrono::steady_clock;
+
+static plWaveSet7::SurfaceParams IMakeSurface()
+{
+    std::mt19937 rng(42);
+    std::uniform_real_distribution<float> unit(0.f, 1.f);
+
+    plWaveSet7::SurfaceParams params;
+    for (plWorldWave7& wave : params.fWaves) {
+        float angle = unit(rng) * hsConstants::two_pi<float>;
+        wave.fDir.Set(cosf(angle), sinf(angle), 0.f);
+        wave.fLength = 4.f + unit(rng) * 36.f;
+        wave.fFreq = hsConstants::two_pi<float> / wave.fLength;
+        wave.fPhase = unit(rng) * hsConstants::two_pi<float>;
+        wave.fAmplitude = wave.fLength * 0.05f;
+    }
+    params.fWaterHeight = 0.f;
+    params.fScrunchLen = 8.f;
+    params.fScrunchScale = 2.f;
+    return params;
+}
+
+template<typename Func>
+static double ITime(int32_t count, Func func)
+{
+    auto begin = ClockT::now();
+    for (int32_t i = 0; i < count; ++i)
+        func();
+    auto elapsed = ClockT::now() - begin;
+    return std::chrono::duration<double, std::nano>(elapsed).count() / count;
+}
+
+static int hsMain(std::vector<ST::string> args)
+{
+    plCmdParser parser(s_cmdLineArgs, std::size(s_cmdLineArgs));
+    if (!parser.Parse(args)) {
+        ST::printf(stderr, "Usage: plWaveSetBenchmark [-Count N]\n");
+        return 1;
+    }
+
+    int32_t count = 10000;
+    if (parser.IsSpecified(kArgCount))
+        count = parser.GetInt(kArgCount);
+    if (count <= 0) {
+        ST::printf(stderr, "Cannot iterate less than 1 time.\n");
+        return 1;
+    }
+
+    const plWaveSet7::SurfaceParams params = IMakeSurface();
+
+    // One frame of buoys, evaluated one at a time the way IFloatBuoys() used
+    // to, against the batched call it makes now.
+    ST::printf("{} iterations each\n\n", count);
+    ST::printf("  {>6}  {>12}  {>12}  {>8}\n", "Buoys", "Per point", "Batched", "Speedup");
+    for (size_t numBuoys : { 4, 16, 64, 256, 512, 1024 }) {
+        std::mt19937 rng{ uint32_t(numBuoys) };
+        std::uniform_real_distribution<float> xy(-500.f, 500.f);
+        std::vector<hsPoint3> start(numBuoys);
+        for (hsPoint3& pt : start)
+            pt.Set(xy(rng), xy(rng), 0.f);
+
+        std::vector<hsPoint3> pos(numBuoys);
+        std::vector<hsVector3> norm(numBuoys);
+
+        double single = ITime(count, [&]() {
+            pos = start;
+            for (size_t i = 0; i < numBuoys; i++)
+                plWaveSet7::EvalSurfacePoint(params, pos[i], norm[i]);
+        });
+        double batched = ITime(count, [&]() {
+            pos = start;
+            plWaveSet7::eval_points.call(params, numBuoys, pos.data(), norm.data());
+        });
+
+        ST::printf("  {>6}  {>9.0f} ns  {>9.0f} ns  {>7.2f}x\n", numBuoys, single, batched, single / batched);
+    }
+
+    ST::printf("\nHave a nice day!\n");
+    return 0;
+}